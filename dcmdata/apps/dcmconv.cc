@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -104,6 +104,9 @@ int main(int argc, char *argv[])
   OFCmdUnsignedInt opt_itempad = 0;
 #ifdef WITH_ZLIB
   OFCmdUnsignedInt opt_compressionLevel = 0;
+#ifdef WITH_THREADS
+  OFCmdUnsignedInt opt_compressionThreads = 1;
+#endif
 #endif
 #ifdef WITH_LIBICONV
   const char *opt_convertToCharset = NULL;
@@ -223,6 +226,10 @@ int main(int argc, char *argv[])
     cmd.addSubGroup("deflate compression level (only with --write-xfer-deflated):");
       cmd.addOption("--compression-level",   "+cl", 1, "[l]evel: integer (default: 6)",
                                                        "0=uncompressed, 1=fastest, 9=best compression");
+#ifdef WITH_THREADS
+      cmd.addOption("--compression-threads", "+ct", 1, "[n]umber: integer (1..256, default: 1)",
+                                                       "compress blocks of 128 kB using n threads");
+#endif
 #endif
 
     /* evaluate command line */
@@ -508,6 +515,14 @@ int main(int argc, char *argv[])
         app.checkValue(cmd.getValueAndCheckMinMax(opt_compressionLevel, 0, 9));
         dcmZlibCompressionLevel.set(OFstatic_cast(int, opt_compressionLevel));
       }
+#ifdef WITH_THREADS
+      if (cmd.findOption("--compression-threads"))
+      {
+        app.checkDependence("--compression-threads", "--write-xfer-deflated", opt_oxfer == EXS_DeflatedLittleEndianExplicit);
+        app.checkValue(cmd.getValueAndCheckMinMax(opt_compressionThreads, 1, 256));
+        dcmZlibCompressionThreads.set(OFstatic_cast(Uint32, opt_compressionThreads));
+      }
+#endif
 #endif
     }
 
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2014, OFFIS e.V.
+ *  Copyright (C) 2002-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -77,6 +77,7 @@ int main(int argc, char *argv[])
   // RLE parameters
   OFBool opt_uidcreation = OFFalse;
   OFBool opt_reversebyteorder = OFFalse;
+  OFCmdUnsignedInt opt_threads = 1;
 
   OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION, "Decode RLE-compressed DICOM file", rcsid);
   OFCommandLine cmd;
@@ -104,6 +105,11 @@ int main(int argc, char *argv[])
     cmd.addSubGroup("RLE byte segment order:");
       cmd.addOption("--byte-order-default",  "+bd",    "most significant byte first (default)");
       cmd.addOption("--byte-order-reverse",  "+br",    "least significant byte first");
+#ifdef WITH_THREADS
+    cmd.addSubGroup("multi-threaded decompression:");
+      cmd.addOption("--threads",             "+mt", 1, "[n]umber: integer (1..256, default: 1)",
+                                                       "decompress up to n stripes concurrently");
+#endif
 
   cmd.addGroup("output options:");
     cmd.addSubGroup("output file format:");
@@ -166,6 +172,13 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--byte-order-reverse")) opt_reversebyteorder = OFTrue;
       cmd.endOptionBlock();
 
+#ifdef WITH_THREADS
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValueAndCheckMinMax(opt_threads, OFstatic_cast(OFCmdUnsignedInt, 1), OFstatic_cast(OFCmdUnsignedInt, 256)));
+      }
+#endif
+
       cmd.beginOptionBlock();
       if (cmd.findOption("--read-file"))
       {
@@ -232,7 +245,7 @@ int main(int argc, char *argv[])
     OFLOG_DEBUG(dcmdrleLogger, rcsid << OFendl);
 
     // register global decompression codecs
-    DcmRLEDecoderRegistration::registerCodecs(opt_uidcreation, opt_reversebyteorder);
+    DcmRLEDecoderRegistration::registerCodecs(opt_uidcreation, opt_reversebyteorder, OFstatic_cast(Uint32, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
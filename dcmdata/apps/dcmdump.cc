@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -211,6 +211,9 @@ DCMTK_MAIN_FUNCTION
         cmd.addOption("--load-short",          "-M",     "do not load very long values (e.g. pixel data)");
         cmd.addOption("--max-read-length",     "+R",  1, "[k]bytes: integer (4..4194302, default: 4)",
                                                          "set threshold for long values to k kbytes");
+      cmd.addSubGroup("file access:");
+        cmd.addOption("--read-buffered",       "-mm",    "read files using buffered file I/O (default)");
+        cmd.addOption("--read-mapped",         "+mm",    "map files into memory, refer to binary values");
       cmd.addSubGroup("parsing of file meta information:");
         cmd.addOption("--use-meta-length",     "+ml",    "use file meta information group length (default)");
         cmd.addOption("--ignore-meta-length",  "-ml",    "ignore file meta information group length");
@@ -378,6 +381,11 @@ DCMTK_MAIN_FUNCTION
       if (cmd.findOption("--load-short")) loadIntoMemory = OFFalse;
       cmd.endOptionBlock();
 
+      cmd.beginOptionBlock();
+      if (cmd.findOption("--read-buffered")) dcmUseMemoryMappedFileInput.set(OFFalse);
+      if (cmd.findOption("--read-mapped")) dcmUseMemoryMappedFileInput.set(OFTrue);
+      cmd.endOptionBlock();
+
       cmd.beginOptionBlock();
       if (cmd.findOption("--use-meta-length"))
       {
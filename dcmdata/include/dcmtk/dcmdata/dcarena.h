@@ -0,0 +1,233 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: arena allocator for objects created by the parser
+ *
+ */
+
+#ifndef DCARENA_H
+#define DCARENA_H
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/ofstd/oftypes.h"      /* for OFBool */
+#include "dcmtk/ofstd/ofthread.h"     /* for OFMutex */
+#include "dcmtk/dcmdata/dcdefine.h"   /* for DCMTK_DCMDATA_EXPORT */
+
+#define INCLUDE_CSTDDEF
+#include "dcmtk/ofstd/ofstdinc.h"
+
+/* type of the reference counter of an arena, which is updated without
+ * locking a mutex if the compiler provides atomic operations
+ */
+#if !defined(WITH_THREADS) || (defined(HAVE_SYNC_ADD_AND_FETCH) && defined(HAVE_SYNC_SUB_AND_FETCH))
+#define DCMARENA_COUNTER_TYPE size_t
+#elif defined(HAVE_INTERLOCKED_INCREMENT) && defined(HAVE_INTERLOCKED_DECREMENT)
+#define DCMARENA_COUNTER_TYPE volatile long
+#else
+#define DCMARENA_COUNTER_TYPE size_t
+#define DCMARENA_NEED_MUTEX 1
+#endif
+
+
+/** arena (or region) allocator that is used by the parser for the objects
+ *  that make up a dataset, i.e. for instances of all classes derived from
+ *  DcmObject and for the nodes of the element and item lists. Memory is
+ *  taken from large chunks by simply increasing a pointer ("bump allocator"),
+ *  and single objects are never freed individually. Instead, all chunks are
+ *  freed at once when the last object allocated from the arena has been
+ *  deleted and the arena itself has been released by its owner.
+ *  This avoids thousands of calls to malloc() and free() when parsing and
+ *  deleting large datasets.
+ *  Objects allocated from an arena can be used like all other objects, e.g.
+ *  they can be removed from the dataset and inserted into another one. This
+ *  however keeps all memory of the arena allocated until the object is deleted.
+ *  Small value fields of elements are also allocated from the arena.
+ *  An arena is activated for the current thread using class DcmArenaScope.
+ *  Objects are only allocated from an arena if they are created by this
+ *  thread while the arena is active. Since allocation from an arena is not
+ *  synchronized, an arena must not be active in more than one thread at the
+ *  same time. Objects allocated from an arena can be deleted by any thread.
+ */
+class DCMTK_DCMDATA_EXPORT DcmArena
+{
+public:
+
+  /** static method that permits creation of instances of
+   *  this class (only) on the heap, never on the stack.
+   *  A newly created instance always has a reference counter of 1,
+   *  which is the reference of the caller (owner).
+   *  @param chunkSize size of the memory chunks allocated by the arena
+   *  @param maxValueSize maximum size of a value field that is allocated
+   *    from the arena. Larger value fields are always allocated on the heap.
+   *  @return pointer to new instance
+   */
+  static DcmArena *newInstance(const size_t chunkSize = 65536,
+                               const size_t maxValueSize = 256);
+
+  /** releases the reference of the owner, i.e. the object is deleted
+   *  as soon as all objects allocated from this arena have been deleted.
+   */
+  void release();
+
+  /** allocate memory for an object. If an arena is active for the current
+   *  thread, the memory is taken from this arena, otherwise from the heap.
+   *  In both cases, the block is preceded by a small header that refers to
+   *  the arena (or is NULL for the heap), so that the memory can be freed
+   *  without looking up the owner of the block. This method is used by the class-specific operator new of DcmObject
+   *  and DcmListNode.
+   *  @param size number of bytes to allocate
+   *  @param noThrow if OFTrue, return NULL if the memory cannot be allocated,
+   *    otherwise throw std::bad_alloc
+   *  @return pointer to allocated memory
+   */
+  static void *allocateObject(const size_t size,
+                              const OFBool noThrow = OFFalse);
+
+  /** free memory that was allocated by allocateObject(). The owner of the
+   *  block is determined from its header, i.e. blocks taken from the heap
+   *  are given back to the heap, and blocks taken from an arena release
+   *  their reference to the arena.
+   *  @param ptr pointer to memory, may be NULL
+   */
+  static void deallocateObject(void *ptr);
+
+  /** allocate memory for the value field of an element from the arena that
+   *  is active for the current thread. This method is used by class DcmElement.
+   *  @param size number of bytes to allocate
+   *  @return pointer to allocated memory, NULL if no arena is active, if the
+   *    value field is too large for the arena or if the memory cannot be
+   *    allocated. The memory must be freed with deallocateValue().
+   */
+  static void *allocateValue(const size_t size);
+
+  /** free memory that was allocated by allocateValue()
+   *  @param ptr pointer to memory, may be NULL
+   */
+  static void deallocateValue(void *ptr);
+
+  /** get number of objects allocated from this arena that still exist
+   *  @return number of objects
+   */
+  size_t numberOfObjects();
+
+private:
+
+  friend class DcmArenaScope;
+
+  /** private constructor.
+   *  Instances of this class are always created through newInstance().
+   *  @param chunkSize size of the memory chunks allocated by the arena
+   *  @param maxValueSize maximum size of a value field allocated from the arena
+   */
+  DcmArena(const size_t chunkSize,
+           const size_t maxValueSize);
+
+  /** private destructor, frees all chunks. Instances of this
+   *  class are always deleted through the reference counting methods.
+   */
+  ~DcmArena();
+
+  /// private undefined copy constructor
+  DcmArena(const DcmArena &);
+
+  /// private undefined copy assignment operator
+  DcmArena &operator=(const DcmArena &);
+
+  /** allocate the given number of bytes from the current chunk,
+   *  creating a new chunk if required
+   *  @param size number of bytes to allocate (excluding the block header)
+   *  @return pointer to allocated memory (following the block header),
+   *    NULL if the memory cannot be allocated
+   */
+  void *allocate(const size_t size);
+
+  /** increase reference counter (in a thread-safe and, if possible,
+   *  lock-free fashion)
+   */
+  void increaseRefCount();
+
+  /** decrease reference counter (in a thread-safe and, if possible,
+   *  lock-free fashion) and delete this object if it becomes zero
+   */
+  void decreaseRefCount();
+
+  /// get arena that is active for the current thread, NULL if none
+  static DcmArena *current();
+
+  /** set arena that is active for the current thread
+   *  @param arena pointer to arena, NULL to deactivate
+   */
+  static void setCurrent(DcmArena *arena);
+
+  /// size of a newly allocated chunk
+  size_t chunkSize_;
+
+  /// maximum size of a value field allocated from this arena
+  size_t maxValueSize_;
+
+  /// pointer to first (i.e. most recently allocated) chunk
+  void *chunks_;
+
+  /// pointer to the free memory of the current chunk
+  char *next_;
+
+  /// number of bytes available in the current chunk
+  size_t avail_;
+
+  /** number of references to this object: one for the owner
+   *  plus one for each object allocated from this arena
+   */
+  DCMARENA_COUNTER_TYPE refCount_;
+
+#ifdef DCMARENA_NEED_MUTEX
+  /// mutex for MT-safe reference counting on platforms without atomic operations
+  OFMutex mutex_;
+#endif
+};
+
+
+/** helper class that activates an arena for the current thread during its
+ *  lifetime, i.e. all objects derived from DcmObject (and list nodes) that
+ *  are created by this thread are allocated from the arena. The previously
+ *  active arena (if any) is restored by the destructor.
+ */
+class DCMTK_DCMDATA_EXPORT DcmArenaScope
+{
+public:
+
+  /** constructor, activates the given arena for the current thread
+   *  @param arena pointer to arena, NULL to deactivate any arena
+   */
+  DcmArenaScope(DcmArena *arena);
+
+  /// destructor, restores the previously active arena
+  ~DcmArenaScope();
+
+private:
+
+  /// private undefined copy constructor
+  DcmArenaScope(const DcmArenaScope &);
+
+  /// private undefined copy assignment operator
+  DcmArenaScope &operator=(const DcmArenaScope &);
+
+  /// previously active arena
+  DcmArena *previous_;
+};
+
+
+#endif // DCARENA_H
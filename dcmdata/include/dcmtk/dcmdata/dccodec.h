@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2011, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -137,6 +137,43 @@ public:
     Uint32 bufSize,
     OFString& decompressedColorModel) const = 0;
 
+  /** decompresses a range of consecutive frames from the given pixel sequence
+   *  and stores the result in the given buffer. The default implementation calls
+   *  decodeFrame() for each frame. Codecs may override this method in order to
+   *  decompress the frames concurrently.
+   *  @param fromParam representation parameter of current compressed
+   *    representation, may be NULL.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to dataset in which pixel data element is contained
+   *  @param firstFrame number of the first frame, starting with 0 for the first frame
+   *  @param numberOfFrames number of frames to be decompressed
+   *  @param startFragment index of the compressed fragment that contains
+   *    all or the first part of the compressed bitstream for the given firstFrame.
+   *    Upon successful return this parameter is updated to contain the index
+   *    of the first compressed fragment of the frame following the given range.
+   *    When unknown, zero should be passed (see decodeFrame()).
+   *  @param buffer pointer to buffer where the frames are to be stored. Frame i
+   *    of the range is stored at offset i * frameBufSize, i.e. the buffer must be
+   *    at least numberOfFrames * frameBufSize bytes large.
+   *  @param frameBufSize size of the buffer for a single frame in bytes
+   *  @param decompressedColorModel upon successful return, the color model
+   *    of the decompressed image (which may be different from the one used
+   *    in the compressed images) is returned in this parameter.
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrames(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    void *buffer,
+    Uint32 frameBufSize,
+    OFString& decompressedColorModel) const;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -270,7 +307,9 @@ public:
     const char *codeMeaning);
 
   /** determine the index number (starting with zero) of the compressed pixel data fragment
-   *  corresponding to the given frame (also starting with zero)
+   *  corresponding to the given frame (also starting with zero). Uses the frame index of
+   *  the pixel sequence (see DcmPixelSequence::buildFrameIndex()), i.e. the fragments are
+   *  only examined once per pixel sequence.
    *  @param frameNo frame number
    *  @param numberOfFrames number of frames of this image
    *  @param fromPixSeq compressed pixel sequence
@@ -282,6 +321,26 @@ public:
     Sint32 numberOfFrames,
     DcmPixelSequence * fromPixSeq,
     Uint32& currentItem);
+
+  /** determine the index numbers (starting with zero) of the compressed pixel data fragments
+   *  at which the frames of the given range start, using the frame index of the pixel
+   *  sequence (see DcmPixelSequence::buildFrameIndex()).
+   *  @param firstFrame number of the first frame of the range (starting with zero)
+   *  @param count number of frames in the range
+   *  @param numberOfFrames number of frames of this image
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param startFragments array of count + 1 entries. Upon success, entry i contains the
+   *    index of the first fragment of frame firstFrame + i. The last entry contains the index
+   *    of the first fragment following the range, i.e. the number of fragments if the range
+   *    ends with the last frame of the image.
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  static OFCondition determineFrameFragments(
+    Uint32 firstFrame,
+    Uint32 count,
+    Sint32 numberOfFrames,
+    DcmPixelSequence * fromPixSeq,
+    Uint32 *startFragments);
 };
 
 
@@ -391,6 +450,41 @@ public:
     Uint32 bufSize,
     OFString& decompressedColorModel);
 
+  /** looks for a codec that is able to decode from the given transfer syntax
+   *  and calls the decodeFrames() method of the codec.  A read lock on the list of
+   *  codecs is acquired until this method returns.
+   *  @param fromType transfer syntax to decode from
+   *  @param fromParam representation parameter of current compressed
+   *    representation, may be NULL.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param dataset pointer to dataset in which pixel data element is contained
+   *  @param firstFrame number of the first frame, starting with 0 for the first frame
+   *  @param numberOfFrames number of frames to be decompressed
+   *  @param startFragment index of the compressed fragment that contains
+   *    all or the first part of the compressed bitstream for the given firstFrame.
+   *    Upon successful return this parameter is updated to contain the index
+   *    of the first compressed fragment of the frame following the given range.
+   *    When unknown, zero should be passed.
+   *  @param buffer pointer to buffer where the frames are to be stored, frame i
+   *    of the range at offset i * frameBufSize
+   *  @param frameBufSize size of the buffer for a single frame in bytes
+   *  @param decompressedColorModel upon successful return, the color model
+   *    of the decompressed image (which may be different from the one used
+   *    in the compressed images) is returned in this parameter.
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition decodeFrames(
+    const DcmXfer & fromType,
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    void *buffer,
+    Uint32 frameBufSize,
+    OFString& decompressedColorModel);
+
   /** looks for a codec that is able to encode from the given transfer syntax
    *  and calls the encode() method of the codec.  A read lock on the list of
    *  codecs is acquired until this method returns.
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -32,6 +32,7 @@
 class DcmInputStream;
 class DcmOutputStream;
 class DcmRepresentationParameter;
+class DcmArena;
 
 
 /** a class handling the DICOM dataset format (files without meta header)
@@ -183,6 +184,35 @@ class DCMTK_DCMDATA_EXPORT DcmDataset
                              const E_GrpLenEncoding glenc = EGL_noChange,
                              const Uint32 maxReadLength = DCM_MaxReadLength);
 
+    /** This function reads the information of all attributes which are
+     *  captured in the input stream up to the attribute tag stopParsingAtElement
+     *  and captures this information in this->elementList. Optionally, only
+     *  the attributes contained in the given tag filter are kept. Apart from
+     *  this, the behavior is the same as for read().
+     *  @param inStream      The stream which contains the information.
+     *  @param xfer          The transfer syntax which was used to encode
+     *                       the information in inStream.
+     *  @param glenc         Encoding type for group length; specifies what
+     *                       will be done with group length tags.
+     *  @param maxReadLength Maximum read length for reading an attribute value.
+     *  @param stopParsingAtElement parsing of the input stream is stopped before
+     *                       the first attribute with a tag that is equal to or
+     *                       greater than this tag (e.g. DCM_PixelData).
+     *                       DCM_UndefinedTagKey means that the complete stream is read.
+     *  @param tagFilter     list of attribute tags to be read (optional). If not
+     *                       NULL, all other attributes on dataset level are skipped.
+     *                       Please note that the tags of private creator elements
+     *                       and of the Specific Character Set should also be listed
+     *                       if private or character string attributes are requested.
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition readUntilTag(DcmInputStream &inStream,
+                                     const E_TransferSyntax xfer = EXS_Unknown,
+                                     const E_GrpLenEncoding glenc = EGL_noChange,
+                                     const Uint32 maxReadLength = DCM_MaxReadLength,
+                                     const DcmTagKey &stopParsingAtElement = DCM_UndefinedTagKey,
+                                     const OFList<DcmTagKey> *tagFilter = NULL);
+
     /** write dataset to a stream
      *  @param outStream DICOM output stream
      *  @param oxfer output transfer syntax (EXS_Unknown means use original)
@@ -273,6 +303,33 @@ class DCMTK_DCMDATA_EXPORT DcmDataset
                                  const E_GrpLenEncoding groupLength = EGL_noChange,
                                  const Uint32 maxReadLength = DCM_MaxReadLength);
 
+    /** load object from a DICOM file, stopping before the given attribute tag.
+     *  This method only supports DICOM objects stored as a dataset, i.e. without meta header.
+     *  Use DcmFileFormat::loadFileUntilTag() to load files with meta header.
+     *  The file is only read up to the attribute tag stopParsingAtElement, e.g. the
+     *  values of the remaining attributes such as the pixel data are never read.
+     *  @param fileName name of the file to load (may contain wide chars if support enabled).
+     *    Since there are various constructors for the OFFilename class, a "char *", "OFString"
+     *    or "wchar_t *" can also be passed directly to this parameter.
+     *  @param readXfer transfer syntax used to read the data (auto detection if EXS_Unknown)
+     *  @param groupLength flag, specifying how to handle the group length tags
+     *  @param maxReadLength maximum number of bytes to be read for an element value.
+     *    Element values with a larger size are not loaded until their value is retrieved
+     *    (with getXXX()) or loadAllDataIntoMemory() is called.
+     *  @param stopParsingAtElement parsing of the file is stopped before the first attribute
+     *    with a tag that is equal to or greater than this tag (on dataset level).
+     *    DCM_UndefinedTagKey means that the complete file is read.
+     *  @param tagFilter list of attribute tags to be read (optional). If not NULL, all
+     *    other attributes on dataset level are skipped without loading their value.
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition loadFileUntilTag(const OFFilename &fileName,
+                                         const E_TransferSyntax readXfer = EXS_Unknown,
+                                         const E_GrpLenEncoding groupLength = EGL_noChange,
+                                         const Uint32 maxReadLength = DCM_MaxReadLength,
+                                         const DcmTagKey &stopParsingAtElement = DCM_UndefinedTagKey,
+                                         const OFList<DcmTagKey> *tagFilter = NULL);
+
     /** save object to a DICOM file.
      *  This method only supports DICOM objects stored as a dataset, i.e. without meta header.
      *  Use DcmFileFormat::saveFile() to save files with meta header.
@@ -339,6 +396,11 @@ class DCMTK_DCMDATA_EXPORT DcmDataset
     E_TransferSyntax OriginalXfer;
     /// current transfer syntax of the dataset
     E_TransferSyntax CurrentXfer;
+    /** arena from which the objects created by read() are allocated (NULL if
+     *  none, see dcmUseArenaAllocation). The arena is only released by this
+     *  dataset; it is deleted when all objects allocated from it are deleted.
+     */
+    DcmArena *Arena;
 };
 
 
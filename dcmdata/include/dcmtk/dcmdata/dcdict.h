@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -26,6 +26,7 @@
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 
 #include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/ofstd/oflist.h"
 #include "dcmtk/dcmdata/dchashdi.h"
 
 /// maximum length of a line in the loadable DICOM dictionary
@@ -49,6 +50,9 @@
 #define ENVIRONMENT_PATH_SEPARATOR '\n' /* at least define something unlikely */
 #endif
 
+// forward declarations
+class DcmDataDictionaryIndex;
+
 
 /** this class implements a loadable DICOM Data Dictionary
  */
@@ -212,6 +216,9 @@ private:
  *  A read/write lock is used to protect threads from each other.
  *  This allows parallel read-only access by multiple threads, which is
  *  the most common case.
+ *  In addition, an immutable index of all dictionary entries is maintained,
+ *  which allows for looking up tag keys without acquiring any lock (see
+ *  findEntry()). The index is rebuilt whenever a write lock is released.
  */
 class DCMTK_DCMDATA_EXPORT GlobalDcmDataDictionary
 {
@@ -237,9 +244,25 @@ public:
   DcmDataDictionary& wrlock();
 
   /** unlocks the read or write lock which must have been acquired previously.
+   *  If a write lock is released, the index used by findEntry() is rebuilt.
    */
   void unlock();
 
+  /** dictionary lookup for the given tag key and private creator name.
+   *  In contrast to rdlock().findEntry(), this method does not acquire a lock
+   *  (if supported by the compiler) and is, therefore, much faster when used
+   *  by many threads in parallel. The lookup is performed on an immutable
+   *  index of the dictionary, i.e. changes of the dictionary are only visible
+   *  after the write lock has been released. This method must not be called
+   *  with a write lock on the dictionary being held by the calling thread.
+   *  @param key tag key
+   *  @param privCreator private creator name, may be NULL
+   *  @return pointer to dictionary entry if found, NULL otherwise. The entry
+   *    remains valid (but unchanged) until this object is destroyed, since an
+   *    index that has been replaced by a newer one is never deleted before.
+   */
+  const DcmDictEntry *findEntry(const DcmTagKey &key, const char *privCreator);
+
   /** checks if a data dictionary has been loaded. This method acquires and
    *  releases a read lock. It must not be called with another lock on the
    *  dictionary being held by the calling thread.
@@ -268,10 +291,37 @@ private:
    */
   void createDataDict();
 
+  /** create a new index of the data dictionary and make it available to
+   *  findEntry(). The replaced index is kept until this object is destroyed
+   *  since it (or the entries returned from it) might still be used by other
+   *  threads. Since the dictionary is rarely modified after it has been
+   *  loaded, the additional memory is usually negligible.
+   *  The caller must have dataDictLock locked for writing.
+   */
+  void updateDataDictIndex();
+
+  /** get the current index of the data dictionary
+   *  @return pointer to the current index, NULL if none
+   */
+  DcmDataDictionaryIndex *getDataDictIndex();
+
   /** the data dictionary managed by this class
    */
   DcmDataDictionary *dataDict;
 
+  /** the current immutable index of the data dictionary used by findEntry()
+   */
+  DcmDataDictionaryIndex * volatile dataDictIndex;
+
+  /** the indexes that have been replaced by updates of the dictionary,
+   *  deleted when this object is destroyed
+   */
+  OFList<DcmDataDictionaryIndex *> retiredDataDictIndexes;
+
+  /** true if the dictionary is currently locked for writing
+   */
+  OFBool dataDictWriteLocked;
+
 #ifdef WITH_THREADS
   /** the read/write lock used to protect access from multiple threads
    */
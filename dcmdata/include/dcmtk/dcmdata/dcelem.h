@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -30,6 +30,7 @@
 
 // forward declarations
 class DcmInputStreamFactory;
+class DcmFileMapping;
 class DcmFileCache;
 class DcmItem;
 
@@ -430,7 +431,10 @@ class DCMTK_DCMDATA_EXPORT DcmElement
      *  element.
      *  @param copy if true, copy value field before detaching; if false, do not
      *    retain a copy.
-     *  @return EC_Normal upon success, an error code otherwise
+     *  @return EC_Normal upon success, an error code otherwise. The value of an
+     *    element that refers to a memory-mapped file (see dcmUseMemoryMappedFileInput)
+     *    or that has been allocated from an arena (see dcmUseArenaAllocation) cannot
+     *    be detached, EC_IllegalCall is returned in this case.
      */
     OFCondition detachValueField(OFBool copy = OFFalse);
 
@@ -756,6 +760,13 @@ class DCMTK_DCMDATA_EXPORT DcmElement
      */
     void *getValue(const E_ByteOrder newByteOrder = gLocalByteOrder);
 
+    /** check whether the element value stays in memory, unchanged, once this
+     *  element has been written, so that write() may pass it to the output
+     *  stream by reference (see DcmOutputStream::writeReference()).
+     *  @return OFTrue if the value may be referenced, OFFalse if it must be copied
+     */
+    virtual OFBool valueRemainsAfterWrite() const;
+
     /** insert into the element value a copy of the given raw value. If the
      *  attribute is multi-valued, all other values remain untouched.
      *  Only works for fixed-size VRs, not for strings.
@@ -807,6 +818,16 @@ class DCMTK_DCMDATA_EXPORT DcmElement
      */
     virtual Uint8 *newValueField();
 
+    /** allocate memory for a new value field. Small value fields are taken from
+     *  the arena that is active for the current thread (if any), all others are
+     *  allocated on the heap. This method is used by newValueField() and must only
+     *  be called if there is currently no value field, since the returned memory
+     *  is expected to be assigned to this element's value field.
+     *  @param size number of bytes to allocate
+     *  @return pointer to allocated memory, NULL if out of memory
+     */
+    Uint8 *allocateValueField(const Uint32 size);
+
     /** swaps the content of the value field (if loaded) from big-endian to
      *  little-endian or back
      *  @param valueWidth width (in bytes) of each element value
@@ -855,6 +876,11 @@ class DCMTK_DCMDATA_EXPORT DcmElement
 
   private:
 
+    /** delete the value field of this element (if any), i.e.\ free the memory
+     *  or release the file mapping the value refers to. Afterwards, fValue is NULL.
+     */
+    void deleteValueField();
+
     /// current byte order of attribute value in memory
     E_ByteOrder fByteOrder;
 
@@ -863,6 +889,14 @@ class DCMTK_DCMDATA_EXPORT DcmElement
 
     /// value of the element
     Uint8 *fValue;
+
+    /** file mapping that fValue refers to, NULL if fValue was allocated on the heap.
+     *  The value is not deleted but the reference to the mapping is released.
+     */
+    DcmFileMapping *fMapping;
+
+    /// flag indicating whether fValue has been allocated from an arena (see DcmArena)
+    OFBool fValueInArena;
 };
 
 
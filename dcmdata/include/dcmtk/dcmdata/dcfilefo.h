@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -183,6 +183,29 @@ class DCMTK_DCMDATA_EXPORT DcmFileFormat
                              const E_GrpLenEncoding glenc = EGL_noChange,
                              const Uint32 maxReadLength = DCM_MaxReadLength);
 
+    /** read object from a stream, up to the attribute tag stopParsingAtElement.
+     *  The meta header is always read completely, the stop tag and the tag filter
+     *  only apply to the dataset.
+     *  @param inStream DICOM input stream
+     *  @param xfer transfer syntax to use when parsing
+     *  @param glenc handling of group length parameters
+     *  @param maxReadLength attribute values larger than this value are skipped
+     *    while parsing and read later upon first access if the stream type supports
+     *    this.
+     *  @param stopParsingAtElement parsing of the dataset is stopped before the first
+     *    attribute with a tag that is equal to or greater than this tag (e.g. DCM_PixelData).
+     *    DCM_UndefinedTagKey means that the complete stream is read.
+     *  @param tagFilter list of attribute tags to be read from the dataset (optional).
+     *    If not NULL, all other attributes on dataset level are skipped.
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition readUntilTag(DcmInputStream &inStream,
+                                     const E_TransferSyntax xfer = EXS_Unknown,
+                                     const E_GrpLenEncoding glenc = EGL_noChange,
+                                     const Uint32 maxReadLength = DCM_MaxReadLength,
+                                     const DcmTagKey &stopParsingAtElement = DCM_UndefinedTagKey,
+                                     const OFList<DcmTagKey> *tagFilter = NULL);
+
     /** write fileformat to a stream
      *  @param outStream DICOM output stream
      *  @param oxfer output transfer syntax
@@ -254,6 +277,38 @@ class DCMTK_DCMDATA_EXPORT DcmFileFormat
                                  const Uint32 maxReadLength = DCM_MaxReadLength,
                                  const E_FileReadMode readMode = ERM_autoDetect);
 
+    /** load object from a DICOM file, stopping before the given attribute tag.
+     *  This method supports DICOM objects stored as a file (with meta header) or as a
+     *  dataset (without meta header).  By default, the presence of a meta header is
+     *  detected automatically.  The file is only read up to the attribute tag
+     *  stopParsingAtElement, i.e. the values of the remaining attributes (such as
+     *  the pixel data) are never read from the file.
+     *  @param fileName name of the file to load (may contain wide chars if support enabled).
+     *    Since there are various constructors for the OFFilename class, a "char *", "OFString"
+     *    or "wchar_t *" can also be passed directly to this parameter.
+     *  @param readXfer transfer syntax used to read the data (auto detection if EXS_Unknown)
+     *  @param groupLength flag, specifying how to handle the group length tags
+     *  @param maxReadLength maximum number of bytes to be read for an element value.
+     *    Element values with a larger size are not loaded until their value is retrieved
+     *    (with getXXX()) or loadAllDataIntoMemory() is called.
+     *  @param readMode read file with or without meta header, i.e. as a fileformat or a
+     *    dataset.  Use ERM_fileOnly in order to force the presence of a meta header.
+     *  @param stopParsingAtElement parsing of the dataset is stopped before the first
+     *    attribute with a tag that is equal to or greater than this tag (e.g. DCM_PixelData).
+     *    DCM_UndefinedTagKey means that the complete file is read.
+     *  @param tagFilter list of attribute tags to be read from the dataset (optional).
+     *    If not NULL, all other attributes on dataset level are skipped without loading
+     *    their value (if the value length is known).  The meta header is not filtered.
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition loadFileUntilTag(const OFFilename &fileName,
+                                         const E_TransferSyntax readXfer = EXS_Unknown,
+                                         const E_GrpLenEncoding groupLength = EGL_noChange,
+                                         const Uint32 maxReadLength = DCM_MaxReadLength,
+                                         const E_FileReadMode readMode = ERM_autoDetect,
+                                         const DcmTagKey &stopParsingAtElement = DCM_UndefinedTagKey,
+                                         const OFList<DcmTagKey> *tagFilter = NULL);
+
     /** save object to a DICOM file.
      *  @param fileName name of the file to save (may contain wide chars if support enabled).
      *    Since there are various constructors for the OFFilename class, a "char *", "OFString"
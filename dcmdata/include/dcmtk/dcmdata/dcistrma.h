@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -29,6 +29,7 @@
 #include "dcmtk/dcmdata/dcxfer.h"   /* for E_StreamCompression */
 
 class DcmInputStream;
+class DcmFileMapping;
 
 /** pure virtual abstract base class for producers, i.e. the initial node 
  *  of a filter chain in an input stream.
@@ -87,6 +88,28 @@ public:
    */
   virtual void putback(offile_off_t num) = 0;
 
+  /** provides direct access to the given number of bytes at the current
+   *  stream position without copying them, and skips over these bytes.
+   *  This is only supported by producers that keep the complete data in
+   *  a memory-mapped file (see class DcmMappedFileProducer). The default
+   *  implementation does not support this operation.
+   *  @param len number of bytes to be accessed
+   *  @param alignment required alignment of the returned pointer in bytes.
+   *    If the data is not aligned accordingly, the operation fails.
+   *  @param mapping upon success, pointer to the file mapping that contains
+   *    the data. Its reference counter has been increased, i.e. the caller
+   *    must call DcmFileMapping::decreaseRefCount() when the data is no
+   *    longer needed.
+   *  @return pointer to the data if successful, NULL otherwise (in which
+   *    case the stream position remains unchanged).
+   */
+  virtual Uint8 *readMapped(offile_off_t /* len */,
+                            size_t /* alignment */,
+                            DcmFileMapping *& /* mapping */)
+  {
+    return NULL;
+  }
+
 };
 
 
@@ -183,6 +206,24 @@ public:
    */
   virtual offile_off_t skip(offile_off_t skiplen);
 
+  /** provides direct access to the given number of bytes at the current
+   *  stream position without copying them, and skips over these bytes.
+   *  This is only possible if the producer supports this operation (i.e. the
+   *  data is read from a memory-mapped file) and no compression filter is
+   *  installed.
+   *  @param len number of bytes to be accessed
+   *  @param alignment required alignment of the returned pointer in bytes
+   *  @param mapping upon success, pointer to the file mapping that contains
+   *    the data. Its reference counter has been increased, i.e. the caller
+   *    must call DcmFileMapping::decreaseRefCount() when the data is no
+   *    longer needed.
+   *  @return pointer to the data if successful, NULL otherwise (in which
+   *    case the stream position remains unchanged).
+   */
+  virtual Uint8 *readMapped(offile_off_t len,
+                            size_t alignment,
+                            DcmFileMapping *&mapping);
+
   /** returns the total number of bytes read from the stream so far
    *  @return total number of bytes read from the stream
    */
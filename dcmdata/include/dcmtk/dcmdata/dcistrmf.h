@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -191,8 +191,284 @@ private:
 
   /// filename
   OFFilename filename_;
+
+  /// byte offset of the start of this stream in the file
+  offile_off_t offset_;
+};
+
+/** class that maps a complete file into memory (read-only for the file, i.e.
+ *  modifications of the mapped data are never written back to the file but
+ *  lead to private copies of the affected pages, "copy-on-write").
+ *  The mapping maintains a thread-safe reference counter, and when this
+ *  counter is decreased to zero, the file is unmapped and the object deletes
+ *  itself. Memory-mapped files are currently only supported on systems that
+ *  provide mmap().
+ */
+class DCMTK_DCMDATA_EXPORT DcmFileMapping
+{
+public:
+
+  /** static method that permits creation of instances of
+   *  this class (only) on the heap, never on the stack.
+   *  A newly created instance always has a reference counter of 1.
+   *  @param filename name of the file to be mapped (wide char filenames
+   *    are not supported)
+   *  @param status upon return, contains the status of the operation
+   *  @return pointer to new instance if successful, NULL otherwise
+   */
+  static DcmFileMapping *newInstance(const OFFilename &filename,
+                                     OFCondition &status);
+
+  /** get pointer to the mapped file content
+   *  @return pointer to the mapped file content, might be NULL for empty files
+   */
+  Uint8 *data() const { return data_; }
+
+  /** get size of the mapped file content
+   *  @return number of bytes in file
+   */
+  offile_off_t size() const { return size_; }
+
+  /// increase reference counter for this object
+  void increaseRefCount();
+
+  /** decreases reference counter for this object and unmaps the file
+   *  and deletes this object if the reference counter becomes zero.
+   */
+  void decreaseRefCount();
+
+private:
+
+  /** private constructor.
+   *  Instances of this class are always created through newInstance().
+   *  @param data pointer to the mapped file content
+   *  @param size number of bytes mapped
+   */
+  DcmFileMapping(Uint8 *data, offile_off_t size);
+
+  /** private destructor. Instances of this class
+   *  are always deleted through the reference counting methods
+   */
+  virtual ~DcmFileMapping();
+
+  /// private undefined copy constructor
+  DcmFileMapping(const DcmFileMapping& arg);
+
+  /// private undefined copy assignment operator
+  DcmFileMapping& operator=(const DcmFileMapping& arg);
+
+  /** number of references to the mapping.
+   *  Default initialized to 1 upon construction of this object
+   */
+  size_t refCount_;
+
+#ifdef WITH_THREADS
+  /// mutex for MT-safe reference counting
+  OFMutex mutex_;
+#endif
+
+  /// pointer to the mapped file content
+  Uint8 *data_;
+
+  /// number of bytes mapped
+  offile_off_t size_;
 };
 
+
+/** producer class that reads data from a memory-mapped file.
+ *  In addition to the normal read operations, this producer permits
+ *  direct access to the file content through readMapped().
+ */
+class DCMTK_DCMDATA_EXPORT DcmMappedFileProducer: public DcmProducer
+{
+public:
+  /** constructor
+   *  @param filename name of file to be mapped
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmMappedFileProducer(const OFFilename &filename, offile_off_t offset = 0);
+
+  /** constructor, shares an existing file mapping
+   *  @param mapping file mapping, reference counter is increased by this operation
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmMappedFileProducer(DcmFileMapping *mapping, offile_off_t offset = 0);
+
+  /// destructor, decreases reference counter of the file mapping
+  virtual ~DcmMappedFileProducer();
+
+  /** returns the status of the producer. Unless the status is good,
+   *  the producer will not permit any operation.
+   *  @return status, true if good
+   */
+  virtual OFBool good() const;
+
+  /** returns the status of the producer as an OFCondition object.
+   *  Unless the status is good, the producer will not permit any operation.
+   *  @return status, EC_Normal if good
+   */
+  virtual OFCondition status() const;
+
+  /** returns true if the producer is at the end of stream.
+   *  @return true if end of stream, false otherwise
+   */
+  virtual OFBool eos();
+
+  /** returns the minimum number of bytes that can be read with the
+   *  next call to read().
+   *  @return minimum of data available in producer
+   */
+  virtual offile_off_t avail();
+
+  /** reads as many bytes as possible into the given block.
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually read.
+   */
+  virtual offile_off_t read(void *buf, offile_off_t buflen);
+
+  /** skips over the given number of bytes (or less)
+   *  @param skiplen number of bytes to skip
+   *  @return number of bytes actually skipped.
+   */
+  virtual offile_off_t skip(offile_off_t skiplen);
+
+  /** resets the stream to the position by the given number of bytes.
+   *  @param num number of bytes to putback. If the putback operation
+   *    fails, the producer status becomes bad.
+   */
+  virtual void putback(offile_off_t num);
+
+  /** provides direct access to the given number of bytes at the current
+   *  position of the mapped file, and skips over these bytes.
+   *  @param len number of bytes to be accessed
+   *  @param alignment required alignment of the returned pointer in bytes
+   *  @param mapping upon success, pointer to the file mapping (with increased
+   *    reference counter)
+   *  @return pointer to the data if successful, NULL otherwise
+   */
+  virtual Uint8 *readMapped(offile_off_t len,
+                            size_t alignment,
+                            DcmFileMapping *&mapping);
+
+  /** returns the file mapping used by this producer
+   *  @return pointer to file mapping, NULL if the file could not be mapped
+   */
+  DcmFileMapping *mapping() const { return mapping_; }
+
+private:
+
+  /// private unimplemented copy constructor
+  DcmMappedFileProducer(const DcmMappedFileProducer&);
+
+  /// private unimplemented copy assignment operator
+  DcmMappedFileProducer& operator=(const DcmMappedFileProducer&);
+
+  /// the file mapping we're actually reading from
+  DcmFileMapping *mapping_;
+
+  /// status
+  OFCondition status_;
+
+  /// current read position in the mapped file
+  offile_off_t pos_;
+};
+
+
+/** input stream factory for memory-mapped files.
+ *  The factory keeps the file mapping alive, so that values which are
+ *  loaded later do not require the file to be mapped again.
+ */
+class DCMTK_DCMDATA_EXPORT DcmInputMappedFileStreamFactory: public DcmInputStreamFactory
+{
+public:
+
+  /** constructor
+   *  @param mapping file mapping, reference counter is increased by this operation
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmInputMappedFileStreamFactory(DcmFileMapping *mapping, offile_off_t offset);
+
+  /// copy constructor
+  DcmInputMappedFileStreamFactory(const DcmInputMappedFileStreamFactory &arg);
+
+  /// destructor, decreases reference counter of the file mapping
+  virtual ~DcmInputMappedFileStreamFactory();
+
+  /** create a new input stream object
+   *  @return pointer to new input stream object
+   */
+  virtual DcmInputStream *create() const;
+
+  /** returns a pointer to a copy of this object
+   */
+  virtual DcmInputStreamFactory *clone() const
+  {
+    return new DcmInputMappedFileStreamFactory(*this);
+  }
+
+private:
+
+  /// private unimplemented copy assignment operator
+  DcmInputMappedFileStreamFactory& operator=(const DcmInputMappedFileStreamFactory&);
+
+  /// file mapping
+  DcmFileMapping *mapping_;
+
+  /// offset in file
+  offile_off_t offset_;
+};
+
+
+/** input stream that reads from a memory-mapped file.
+ *  Element values read from this stream can refer directly to the mapped
+ *  file content instead of being copied (see dcmUseMemoryMappedFileInput).
+ */
+class DCMTK_DCMDATA_EXPORT DcmInputMappedFileStream: public DcmInputStream
+{
+public:
+  /** constructor
+   *  @param filename name of file to be mapped
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmInputMappedFileStream(const OFFilename &filename, offile_off_t offset = 0);
+
+  /** constructor, shares an existing file mapping
+   *  @param mapping file mapping, reference counter is increased by this operation
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmInputMappedFileStream(DcmFileMapping *mapping, offile_off_t offset = 0);
+
+  /// destructor
+  virtual ~DcmInputMappedFileStream();
+
+  /** creates a new factory object for the current stream
+   *  and stream position.  When activated, the factory will be
+   *  able to create new DcmInputStream delivering the same
+   *  data as the current stream.  Used to defer loading of
+   *  value fields until accessed.
+   *  If no factory object can be created (e.g. because a
+   *  compression filter is installed), returns NULL.
+   *  @return pointer to new factory object if successful, NULL otherwise.
+   */
+  virtual DcmInputStreamFactory *newFactory() const;
+
+private:
+
+  /// private unimplemented copy constructor
+  DcmInputMappedFileStream(const DcmInputMappedFileStream&);
+
+  /// private unimplemented copy assignment operator
+  DcmInputMappedFileStream& operator=(const DcmInputMappedFileStream&);
+
+  /// the final producer of the filter chain
+  DcmMappedFileProducer producer_;
+
+  /// byte offset of the start of this stream in the file
+  offile_off_t offset_;
+};
+
+
 /** class that manages the life cycle of a temporary file.
  *  It maintains a thread-safe reference counter, and when this counter
  *  is decreased to zero, unlinks (deletes) the file and then the handler
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2015, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -26,6 +26,7 @@
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 
 #include "dcmtk/ofstd/offile.h"       /* for offile_off_t */
+#include "dcmtk/ofstd/oflist.h"       /* for class OFList */
 #include "dcmtk/dcmdata/dctypes.h"
 #include "dcmtk/dcmdata/dcobject.h"
 #include "dcmtk/dcmdata/dclist.h"
@@ -234,6 +235,38 @@ class DCMTK_DCMDATA_EXPORT DcmItem
                              const E_GrpLenEncoding glenc = EGL_noChange,
                              const Uint32 maxReadLength = DCM_MaxReadLength);
 
+    /** This function reads the information of all attributes which
+     *  are captured in the input stream and captures this information
+     *  in elementList, up to the attribute tag stopParsingAtElement.
+     *  Each attribute is represented as an element in this list.
+     *  If not all information for an attribute could be read from the
+     *  stream, the function returns EC_StreamNotifyClient.
+     *  The stop tag and the tag filter are only evaluated on dataset level,
+     *  i.e. they are ignored for the items of a sequence.
+     *  @param inStream      The stream which contains the information.
+     *  @param ixfer         The transfer syntax which was used to encode
+     *                       the information in inStream.
+     *  @param glenc         Encoding type for group length; specifies
+     *                       what will be done with group length tags.
+     *  @param maxReadLength Maximum read length for reading an attribute value.
+     *  @param stopParsingAtElement parsing of the input stream is stopped
+     *                       before the first attribute with a tag that is equal
+     *                       to or greater than this tag. The stream is positioned
+     *                       at the start of this attribute. DCM_UndefinedTagKey
+     *                       means that the complete stream is read.
+     *  @param tagFilter     list of attribute tags to be read (optional). If not NULL,
+     *                       all other attributes on dataset level are skipped; their
+     *                       values are not loaded into memory if the length is known
+     *                       in advance and the stream permits to skip them.
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition readUntilTag(DcmInputStream &inStream,
+                                     const E_TransferSyntax ixfer,
+                                     const E_GrpLenEncoding glenc = EGL_noChange,
+                                     const Uint32 maxReadLength = DCM_MaxReadLength,
+                                     const DcmTagKey &stopParsingAtElement = DCM_UndefinedTagKey,
+                                     const OFList<DcmTagKey> *tagFilter = NULL);
+
     /** write object to a stream
      *  @param outStream DICOM output stream
      *  @param oxfer output transfer syntax
@@ -1303,6 +1336,18 @@ class DCMTK_DCMDATA_EXPORT DcmItem
                                   DcmStack &resultStack,         // inout
                                   OFBool searchIntoSub );        // in
 
+    /** helper function that performs a binary search for the given tag on the
+     *  element list, which is always kept in ascending tag order. Afterwards,
+     *  the current element of the list is the element found, or the element
+     *  that would follow an element with the given tag (if any).
+     *  @param tag tag key to be searched
+     *  @param position returns the index of the first element in the list whose
+     *    tag is not less than the given tag (card() if there is no such element)
+     *  @return pointer to the element with the given tag, NULL if not found
+     */
+    DcmObject *findInElementList(const DcmTagKey &tag,           // in
+                                 unsigned long &position);       // out
+
     /** helper function that interprets the given pointer as a pointer to an
      *  array of two characters and checks whether these two characters form
      *  a valid standard DICOM VR.
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -26,9 +26,11 @@
 
 #include "dcmtk/ofstd/ofcast.h"
 #include "dcmtk/ofstd/oftypes.h"
+#include "dcmtk/ofstd/ofvector.h"
 
 #define INCLUDE_CSTDDEF
 #define INCLUDE_CSTDLIB
+#define INCLUDE_NEW
 #include "dcmtk/ofstd/ofstdinc.h"
 #include "dcmtk/dcmdata/dcobject.h"
 
@@ -49,6 +51,49 @@ public:
     /// destructor
     ~DcmListNode();
 
+    /** class-specific allocation function. The memory is taken from the arena
+     *  that is active for the current thread (if any), see class DcmArena.
+     *  @param size number of bytes to allocate
+     *  @return pointer to allocated memory
+     */
+    static void *operator new(size_t size);
+
+    /** class-specific deallocation function
+     *  @param ptr pointer to memory allocated by operator new, may be NULL
+     */
+    static void operator delete(void *ptr);
+
+#ifdef HAVE_STD__NOTHROW
+    /** class-specific non-throwing allocation function, see above
+     *  @param size number of bytes to allocate
+     *  @return pointer to allocated memory, NULL if the memory cannot be allocated
+     */
+    static void *operator new(size_t size, const std::nothrow_t &) throw();
+
+    /** class-specific deallocation function matching the non-throwing
+     *  allocation function
+     *  @param ptr pointer to memory allocated by operator new, may be NULL
+     */
+    static void operator delete(void *ptr, const std::nothrow_t &) throw();
+#endif
+
+    /** placement allocation function, constructs the object at the given address
+     *  @param size number of bytes (unused)
+     *  @param place address of the memory to be used
+     *  @return the given address
+     */
+    static void *operator new(size_t /* size */, void *place) throw()
+    {
+        return place;
+    }
+
+    /** placement deallocation function matching the placement allocation function.
+     *  Does nothing.
+     */
+    static void operator delete(void * /* ptr */, void * /* place */) throw()
+    {
+    }
+
     /// return pointer to object maintained by this list node
     inline DcmObject *value() { return objNodeValue; } 
 
@@ -93,7 +138,11 @@ typedef enum
 
 /** double-linked list class that maintains pointers to DcmObject instances.
  *  The remove operation does not delete the object pointed to, however,
- *  the destructor will delete all elements pointed to
+ *  the destructor will delete all elements pointed to.
+ *  In addition to the linked nodes, the list maintains an index of all nodes
+ *  in list order, so that seek_to() and position() operate in constant time.
+ *  This allows for binary search on lists that are kept in sorted order
+ *  (e.g. the element list of a DcmItem).
  */
 class DCMTK_DCMDATA_EXPORT DcmList 
 {
@@ -149,6 +198,12 @@ public:
      */
     DcmObject *seek_to(unsigned long absolute_position);
 
+    /** get index of the current element in the list
+     *  @return position index < card() of the current element, or
+     *    DCM_EndOfListIndex if there is no current element
+     */
+    inline unsigned long position() const { return currentPosition; }
+
     /** Remove and delete all elements from list. Thus, the 
      *  elements' memory is also freed by this operation. The list
      *  is empty after calling this function.
@@ -176,6 +231,12 @@ private:
 
     /// number of elements in list
     unsigned long cardinality;
+
+    /// index of the current node in list, DCM_EndOfListIndex if there is none
+    unsigned long currentPosition;
+
+    /// pointers to all nodes in list order, used for random access
+    OFVector<DcmListNode *> nodeIndex;
  
     /// private undefined copy constructor 
     DcmList &operator=(const DcmList &);
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -33,6 +33,9 @@
 #include "dcmtk/dcmdata/dctag.h"
 #include "dcmtk/dcmdata/dcstack.h"
 
+#define INCLUDE_NEW
+#include "dcmtk/ofstd/ofstdinc.h"
+
 
 // forward declarations
 class DcmItem;
@@ -193,6 +196,44 @@ extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmIgnoreFileMetaInformationGroupLe
  */
 extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmReplaceWrongDelimitationItem; /* default OFFalse */
 
+/** This flag enables the use of memory-mapped files in DcmFileFormat::loadFile()
+ *  and DcmDataset::loadFile() (if supported by the operating system). Values of
+ *  binary elements (e.g. OB, OW and UN) are then not copied into separately
+ *  allocated memory but refer directly to the mapped file content. The file itself
+ *  is never modified: pages that are changed in memory (e.g. by byte swapping) are
+ *  copied by the operating system. Since the file remains mapped as long as any of
+ *  these values exist, the file should not be modified by other processes while
+ *  the dataset is in use. Default is OFFalse, i.e. files are read conventionally.
+ */
+extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmUseMemoryMappedFileInput; /* default OFFalse */
+
+/** This flag enables the use of an arena allocator (see class DcmArena) when
+ *  reading a dataset, e.g. in DcmDataset::read(), DcmFileFormat::loadFile()
+ *  or DcmDataset::loadFile(). All elements, items and sequences created by the
+ *  parser as well as the nodes of the element lists and small value fields are
+ *  then allocated from a single arena that is owned by the dataset. This is
+ *  much faster than allocating and freeing thousands of small objects separately,
+ *  but the memory is only given back when all these objects have been deleted.
+ *  Default is OFFalse, i.e. all objects are allocated separately on the heap.
+ */
+extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmUseArenaAllocation; /* default OFFalse */
+
+/** This flag enables lazy parsing of sequences when reading a dataset from a
+ *  file, e.g. in DcmFileFormat::loadFile() or DcmDataset::loadFile(). The items
+ *  of a sequence are then not parsed immediately. Instead, only the position of
+ *  the sequence in the file is remembered and the items are read when they are
+ *  accessed first (see DcmSequenceOfItems::itemsLoaded()). This speeds up reading
+ *  of large datasets considerably, e.g. multi-frame images with thousands of items
+ *  in the functional group sequences, if only a few attributes are needed. Like
+ *  for large attribute values that are not loaded into memory (see parameter
+ *  'maxReadLength'), the file must not be modified or deleted as long as the
+ *  dataset is in use. Sequences are always parsed immediately if the stream has
+ *  no random access (e.g. network or compressed streams) or if their end cannot
+ *  be determined without parsing. Default is OFFalse, i.e. all sequences are
+ *  parsed immediately.
+ */
+extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmLazySequenceParsing; /* default OFFalse */
+
 
 /** Abstract base class for most classes in module dcmdata. As a rule of thumb,
  *  everything that is either a dataset or that can be identified with a DICOM
@@ -217,6 +258,49 @@ class DCMTK_DCMDATA_EXPORT DcmObject
     /// destructor
     virtual ~DcmObject();
 
+    /** class-specific allocation function. The memory is taken from the arena
+     *  that is active for the current thread (if any), see class DcmArena.
+     *  @param size number of bytes to allocate
+     *  @return pointer to allocated memory
+     */
+    static void *operator new(size_t size);
+
+    /** class-specific deallocation function
+     *  @param ptr pointer to memory allocated by operator new, may be NULL
+     */
+    static void operator delete(void *ptr);
+
+#ifdef HAVE_STD__NOTHROW
+    /** class-specific non-throwing allocation function, see above
+     *  @param size number of bytes to allocate
+     *  @return pointer to allocated memory, NULL if the memory cannot be allocated
+     */
+    static void *operator new(size_t size, const std::nothrow_t &) throw();
+
+    /** class-specific deallocation function matching the non-throwing
+     *  allocation function
+     *  @param ptr pointer to memory allocated by operator new, may be NULL
+     */
+    static void operator delete(void *ptr, const std::nothrow_t &) throw();
+#endif
+
+    /** placement allocation function, constructs the object at the given address
+     *  @param size number of bytes (unused)
+     *  @param place address of the memory to be used
+     *  @return the given address
+     */
+    static void *operator new(size_t /* size */, void *place) throw()
+    {
+        return place;
+    }
+
+    /** placement deallocation function matching the placement allocation function.
+     *  Does nothing.
+     */
+    static void operator delete(void * /* ptr */, void * /* place */) throw()
+    {
+    }
+
     /** clone method
      *  @return deep copy of this object
      */
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -75,6 +75,21 @@ public:
    */
   virtual offile_off_t write(const void *buf, offile_off_t buflen) = 0;
 
+  /** processes as many bytes as possible from the given input block,
+   *  which the caller guarantees to remain valid and unchanged until the
+   *  data has been passed on by the consumer (e.g. until the buffer of a
+   *  buffer consumer has been flushed). This permits consumers to keep
+   *  a reference to the block instead of copying it. The default
+   *  implementation just calls write().
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually processed.
+   */
+  virtual offile_off_t writeReference(const void *buf, offile_off_t buflen)
+  {
+    return write(buf, buflen);
+  }
+
   /** instructs the consumer to flush its internal content until
    *  either the consumer becomes "flushed" or I/O suspension occurs.
    *  After a call to flush(), a call to write() will produce undefined
@@ -151,6 +166,15 @@ public:
    */
   virtual offile_off_t write(const void *buf, offile_off_t buflen);
 
+  /** processes as many bytes as possible from the given input block,
+   *  which the caller guarantees to remain valid and unchanged until the
+   *  stream has been flushed. See DcmConsumer::writeReference().
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually processed.
+   */
+  virtual offile_off_t writeReference(const void *buf, offile_off_t buflen);
+
   /** instructs the stream to flush its internal content until
    *  either the stream becomes "flushed" or I/O suspension occurs.
    *  After a call to flush(), a call to write() will produce undefined
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -38,6 +38,18 @@ END_EXTERN_C
  */
 extern DCMTK_DCMDATA_EXPORT OFGlobal<int> dcmZlibCompressionLevel;
 
+/** global flag defining the number of threads used for zlib (deflate)
+ *  compression.  If the value is larger than 1 (and DCMTK has been compiled
+ *  with thread support), the data is split into blocks of 128 kBytes that
+ *  are compressed concurrently, each using the last 32 kBytes of the
+ *  preceding block as dictionary.  The result is still a single valid
+ *  deflate bitstream, but it is slightly larger than the one created by
+ *  a single thread.  Default is 1, i.e. no additional threads.
+ */
+extern DCMTK_DCMDATA_EXPORT OFGlobal<Uint32> dcmZlibCompressionThreads;
+
+class DcmZLibParallelCompressor;
+
 /** zlib compression filter for output streams
  */
 class DCMTK_DCMDATA_EXPORT DcmZLibOutputFilter: public DcmOutputFilter
@@ -146,6 +158,11 @@ private:
   /// pointer to consumer to which compressed output is written
   DcmConsumer *current_;
 
+  /** pointer to the multi-threaded compressor, NULL if all data is
+   *  compressed on the calling thread using zstream_
+   */
+  DcmZLibParallelCompressor *parallel_;
+
   /// pointer to struct z_stream object containing the zlib status
   z_streamp zstream_;
 
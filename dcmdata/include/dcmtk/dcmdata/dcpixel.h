@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -563,12 +563,14 @@ public:
      *    all or the first part of the compressed bitstream for the given frameNo.
      *    Upon successful return this parameter is updated to contain the index
      *    of the first compressed fragment of the next frame.
-     *    When unknown, zero should be passed. In this case the decompression
-     *    algorithm will try to determine the index by itself, which will always
-     *    work if frames are decompressed in increasing order from first to last,
-     *    but may fail if frames are decompressed in random order, multiple fragments
-     *    per frame and multiple frames are present in the dataset, and the offset
-     *    table is empty.
+     *    When unknown, zero should be passed. In this case the index is looked up
+     *    in the frame index of the pixel sequence, which is built by the first such
+     *    call (see DcmPixelSequence::buildFrameIndex()). If there are multiple
+     *    fragments per frame and the offset table is empty or does not match, the
+     *    frames are located by looking for JPEG, JPEG-LS or JPEG 2000 codestream
+     *    markers at the start of the fragments. This is a heuristic: it fails if a
+     *    frame does not start with such a marker, and a fragment of JPEG 2000 data
+     *    that happens to start with the same bytes may be taken for a new frame.
      *  @param buffer pointer to buffer allocated by the caller. The buffer
      *    must be large enough for one frame of this image.
      *  @param bufSize size of buffer, in bytes. This number must be even so
@@ -590,6 +592,41 @@ public:
         OFString& decompressedColorModel,
         DcmFileCache *cache=NULL);
 
+    /** access a range of consecutive frames without decompressing or loading a
+     *  complete multi-frame object. This is the batch version of getUncompressedFrame(),
+     *  which allows codecs to decompress the frames concurrently (e.g. for a viewer
+     *  that displays multiple frames at once). Each frame is stored in a slot of the
+     *  buffer that has the size of a frame, rounded up to an even number of bytes.
+     *  @param dataset pointer to DICOM dataset in which this pixel data object is
+     *    located. Used to access rows, columns, samples per pixel etc.
+     *  @param firstFrame number of the first frame, starting with 0 for the first frame
+     *  @param numberOfFrames number of frames to be accessed
+     *  @param startFragment index of the compressed fragment that contains
+     *    all or the first part of the compressed bitstream for the given firstFrame.
+     *    Upon successful return this parameter is updated to contain the index
+     *    of the first compressed fragment of the frame following the given range.
+     *    When unknown, zero should be passed (see getUncompressedFrame()).
+     *  @param buffer pointer to buffer allocated by the caller. The buffer
+     *    must be large enough for the given number of frame slots.
+     *  @param bufSize size of buffer, in bytes
+     *  @param decompressedColorModel upon successful return, the color model
+     *    of the decompressed image (which may be different from the one used
+     *    in the compressed images) is returned in this parameter.
+     *  @param cache file cache object that may be passed to multiple subsequent calls
+     *    to this method for the same file; the file cache will then keep a file
+     *    handle open, thus improving performance. Optional, may be NULL
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition getUncompressedFrames(
+        DcmItem *dataset,
+        Uint32 firstFrame,
+        Uint32 numberOfFrames,
+        Uint32& startFragment,
+        void *buffer,
+        Uint32 bufSize,
+        OFString& decompressedColorModel,
+        DcmFileCache *cache=NULL);
+
     /** determine color model of the decompressed image
      *  @param dataset pointer to DICOM dataset in which this pixel data object
      *    is located. Used to access photometric interpretation.
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -27,8 +27,10 @@
 
 #include "dcmtk/dcmdata/dcsequen.h"
 #include "dcmtk/dcmdata/dcofsetl.h"   /* for class DcmOffsetList */
+#include "dcmtk/ofstd/ofvector.h"     /* for class OFVector */
 
 class DcmPixelItem;
+class DcmFileCache;
 
 /** this class implements a sequence of pixel items, i.e. the data structure DICOM is using
  *  to store compressed pixel data. The object behaves very much like a sequence, but uses
@@ -227,6 +229,50 @@ public:
                                              Uint32 compressedLen,
                                              Uint32 fragmentSize);
 
+    /** determines the first fragment (pixel item) of each frame and caches the result
+     *  in a frame index, so that subsequent calls of getFrameFragments() do not have to
+     *  walk through the fragments again. The index is derived from the number of fragments
+     *  if there is exactly one fragment per frame, otherwise from the Basic Offset Table.
+     *  If the Basic Offset Table is empty or does not match the fragments, the first bytes
+     *  of each fragment are checked for the start of a JPEG, JPEG-LS or JPEG 2000 codestream
+     *  (see indexFramesFromCodestreams()).
+     *  The index is discarded when pixel items are inserted or removed. This method returns
+     *  immediately if the index has already been built for the given number of frames.
+     *  @param numberOfFrames number of frames of the image
+     *  @param cache file cache used for reading the first bytes of fragments that have not
+     *    been loaded into memory, may be NULL
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition buildFrameIndex(const Uint32 numberOfFrames,
+                                        DcmFileCache *cache = NULL);
+
+    /** determines the range of fragments (pixel items) that contain the given frame.
+     *  The frame index is built by the first call (see buildFrameIndex()), afterwards
+     *  the lookup takes constant time.
+     *  @param frameNo number of the frame, starting with zero
+     *  @param numberOfFrames number of frames of the image
+     *  @param startFragment upon success, the index of the first fragment of the frame
+     *  @param endFragment upon success, the index of the fragment following the frame,
+     *    i.e. the number of fragments for the last frame
+     *  @param cache file cache used for building the frame index, may be NULL
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition getFrameFragments(const Uint32 frameNo,
+                                          const Uint32 numberOfFrames,
+                                          Uint32 &startFragment,
+                                          Uint32 &endFragment,
+                                          DcmFileCache *cache = NULL);
+
+    /** stores the offsets of all frames in the Basic Offset Table (first pixel item),
+     *  so that the frame index can be built without inspecting the fragments after the
+     *  pixel data has been written and read again. An existing offset table is replaced.
+     *  @param numberOfFrames number of frames of the image
+     *  @param cache file cache used for building the frame index, may be NULL
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition storeFrameIndex(const Uint32 numberOfFrames,
+                                        DcmFileCache *cache = NULL);
+
 protected:
 
     /** helper function for read(). Create sub-object (pixel item) of the
@@ -247,6 +293,35 @@ private:
      */
     E_TransferSyntax Xfer;
 
+    /** index of the first fragment of each frame, followed by the number of fragments.
+     *  Empty if the index has not been built yet.
+     */
+    OFVector<Uint32> FrameIndex;
+
+    /// number of fragments at the time the frame index was built
+    unsigned long FrameIndexFragments;
+
+    /** determines the first fragment of each frame from the Basic Offset Table
+     *  @param numberOfFrames number of frames of the image
+     *  @param index upon success, the index of the first fragment of each frame
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    OFCondition indexFramesFromOffsetTable(const Uint32 numberOfFrames,
+                                           OFVector<Uint32> &index);
+
+    /** determines the first fragment of each frame by checking the first bytes of each
+     *  fragment for the start of a JPEG, JPEG-LS or JPEG 2000 codestream. This is only a
+     *  heuristic for an empty or mismatched Basic Offset Table: false positives are
+     *  possible for JPEG 2000, since its packet data may contain the bytes FF 4F FF 51.
+     *  @param numberOfFrames number of frames of the image
+     *  @param cache file cache used for reading the fragments, may be NULL
+     *  @param index upon success, the index of the first fragment of each frame
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    OFCondition indexFramesFromCodestreams(const Uint32 numberOfFrames,
+                                           DcmFileCache *cache,
+                                           OFVector<Uint32> &index);
+
     /// method inherited from base class that is useless in this class
     virtual OFCondition insert(DcmItem* /*item*/,
                                unsigned long /*where*/ = DCM_EndOfListIndex,
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2011, OFFIS e.V.
+ *  Copyright (C) 2002-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,6 +25,8 @@
 #include "dcmtk/config/osconfig.h"
 #include "dcmtk/dcmdata/dccodec.h"  /* for class DcmCodec */
 
+class DcmRLECodecParameter;
+
 /** decoder class for RLE.
  *  This class only supports decompression, it neither implements
  *  encoding nor transcoding.
@@ -92,6 +94,42 @@ public:
     Uint32 bufSize,
     OFString& decompressedColorModel) const;
 
+  /** decompresses a range of consecutive frames from the given pixel sequence
+   *  and stores the result in the given buffer. If more than one thread is
+   *  configured and the frame boundaries are known (one fragment per frame or
+   *  a basic offset table), the stripes of all frames are decompressed
+   *  concurrently. Otherwise, decodeFrame() is called for each frame.
+   *  @param fromParam representation parameter of current compressed
+   *    representation, may be NULL.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to dataset in which pixel data element is contained
+   *  @param firstFrame number of the first frame, starting with 0 for the first frame
+   *  @param numberOfFrames number of frames to be decompressed
+   *  @param startFragment index of the compressed fragment that contains
+   *    all or the first part of the compressed bitstream for the given firstFrame.
+   *    Upon successful return this parameter is updated to contain the index
+   *    of the first compressed fragment of the frame following the given range.
+   *  @param buffer pointer to buffer where the frames are to be stored, frame i
+   *    of the range at offset i * frameBufSize
+   *  @param frameBufSize size of the buffer for a single frame in bytes
+   *  @param decompressedColorModel upon successful return, the color model
+   *    of the decompressed image (which may be different from the one used
+   *    in the compressed images) is returned in this parameter.
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrames(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    void *buffer,
+    Uint32 frameBufSize,
+    OFString& decompressedColorModel) const;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -170,6 +208,38 @@ public:
 
 private:
 
+  /** decompresses the given frames with DcmRLEStripeCodec, using multiple
+   *  threads for the stripes of the frames if configured.  The fragments are
+   *  accessed by the calling thread only.
+   *  @param pixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param startFragments array of numberOfFrames + 1 entries. Entry i contains
+   *    the index of the first fragment of frame i, the last entry the index of
+   *    the first fragment following the last frame.
+   *  @param numberOfFrames number of frames to be decompressed
+   *  @param buffer pointer to buffer where the frames are to be stored
+   *    (in little endian byte order), frame i at offset i * frameBufSize
+   *  @param frameBufSize size of the buffer for a single frame in bytes
+   *  @param columns columns of a frame
+   *  @param rows rows of a frame
+   *  @param samplesPerPixel samples per pixel of a frame
+   *  @param bytesAllocated bytes allocated per sample
+   *  @param planarConfiguration planar configuration of the frames
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition decompressFrames(
+    DcmPixelSequence *pixSeq,
+    const DcmRLECodecParameter *cp,
+    const Uint32 *startFragments,
+    Uint32 numberOfFrames,
+    Uint8 *buffer,
+    size_t frameBufSize,
+    Uint16 columns,
+    Uint16 rows,
+    Uint16 samplesPerPixel,
+    Uint16 bytesAllocated,
+    Uint16 planarConfiguration);
+
   /// private undefined copy constructor
   DcmRLECodecDecoder(const DcmRLECodecDecoder&);
 
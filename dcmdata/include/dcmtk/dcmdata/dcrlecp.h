@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2014, OFFIS e.V.
+ *  Copyright (C) 2002-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -44,13 +44,16 @@ public:
    *  @param pReverseDecompressionByteOrder flag indicating whether the byte order should
    *    be reversed upon decompression. Needed to correctly decode some incorrectly encoded
    *    images with more than one byte per sample.
+   *  @param pNumberOfThreads maximum number of threads used for processing the stripes
+   *    and frames of an image. The stripes are processed one after the other if 1 (default).
    */
   DcmRLECodecParameter(
     OFBool pCreateSOPInstanceUID = OFFalse,
     Uint32 pFragmentSize = 0,
     OFBool pCreateOffsetTable = OFTrue,
     OFBool pConvertToSC = OFFalse,
-    OFBool pReverseDecompressionByteOrder = OFFalse);
+    OFBool pReverseDecompressionByteOrder = OFFalse,
+    Uint32 pNumberOfThreads = 1);
 
   /// copy constructor
   DcmRLECodecParameter(const DcmRLECodecParameter& arg);
@@ -109,6 +112,15 @@ public:
     return reverseDecompressionByteOrder;
   }
 
+  /** returns maximum number of threads used for processing the stripes and
+   *  frames of an image, 1 (default) if they are processed sequentially
+   *  @return maximum number of threads
+   */
+  Uint32 getNumberOfThreads() const
+  {
+    return numberOfThreads;
+  }
+
 
 private:
 
@@ -131,6 +143,9 @@ private:
    *  decompress certain incorrectly encoded RLE images
    */
   OFBool reverseDecompressionByteOrder;
+
+  /// maximum number of threads used for processing the stripes and frames of an image
+  Uint32 numberOfThreads;
 };
 
 
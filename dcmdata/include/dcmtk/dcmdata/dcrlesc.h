@@ -0,0 +1,146 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: RLE compressor and decompressor for complete stripes
+ *
+ */
+
+#ifndef DCRLESC_H
+#define DCRLESC_H
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/ofstd/oftypes.h"    /* for Uint8 */
+#include "dcmtk/dcmdata/dcdefine.h"
+
+#define INCLUDE_CSTDDEF
+#include "dcmtk/ofstd/ofstdinc.h"
+
+
+/** this class implements an RLE compressor and decompressor conforming to
+ *  the DICOM standard that processes one complete stripe (i.e. one RLE segment
+ *  containing one byte of each pixel of a frame) at a time.  Unlike
+ *  DcmRLEEncoder and DcmRLEDecoder, which process the data byte by byte, this
+ *  class searches for runs of identical bytes in blocks of 16 bytes using vector
+ *  instructions (where available), writes into a single buffer that is allocated
+ *  by the caller, and expands runs with memset() and memcpy().  The compressed
+ *  stream is identical to the one created by DcmRLEEncoder.  All methods are
+ *  static and do not use any shared data, i.e. different stripes may be processed
+ *  by different threads concurrently.
+ */
+class DCMTK_DCMDATA_EXPORT DcmRLEStripeCodec
+{
+public:
+
+  /** returns the maximum number of bytes that the RLE compressed form of
+   *  a stripe can have, including the pad byte.
+   *  @param columns number of columns of the frame
+   *  @param rows number of rows of the frame
+   *  @return maximum size of the compressed stripe, in bytes
+   */
+  static size_t getMaxEncodedSize(const Uint16 columns,
+                                  const Uint16 rows);
+
+  /** compresses one stripe.  Each row is encoded separately as required
+   *  by DICOM part 5 section G.3.1, and the result is padded to an even
+   *  number of bytes.
+   *  @param pixelData pointer to the byte of the first pixel that belongs
+   *    to the stripe
+   *  @param pixelStride offset between the bytes of two consecutive pixels
+   *    that belong to the stripe, e.g. 1 for 8-bit monochrome images
+   *  @param columns number of columns of the frame
+   *  @param rows number of rows of the frame
+   *  @param target pointer to the buffer for the compressed stripe, which must
+   *    have at least getMaxEncodedSize() bytes
+   *  @param rowBuffer pointer to a buffer of at least 'columns' bytes, which is
+   *    used for collecting the bytes of a row if pixelStride is larger than 1.
+   *    May be NULL if pixelStride is 1.
+   *  @return number of bytes written to the target buffer (always even)
+   */
+  static size_t encodeStripe(const Uint8 *pixelData,
+                             const size_t pixelStride,
+                             const Uint16 columns,
+                             const Uint16 rows,
+                             Uint8 *target,
+                             Uint8 *rowBuffer);
+
+  /** decompresses one stripe.  Decompression stops when the compressed data
+   *  is exhausted or when the requested number of bytes has been produced,
+   *  i.e. a trailing pad byte or garbage following the stripe is ignored.
+   *  @param rleData pointer to the compressed stripe
+   *  @param rleSize size of the compressed stripe, in bytes
+   *  @param target pointer to the byte of the first pixel that belongs
+   *    to the stripe
+   *  @param pixelStride offset between the bytes of two consecutive pixels
+   *    that belong to the stripe
+   *  @param numberOfBytes number of bytes of the uncompressed stripe
+   *    (i.e. number of pixels of the frame)
+   *  @param stripeBuffer pointer to a buffer of at least numberOfBytes bytes,
+   *    which is used for the decompressed stripe if pixelStride is larger than 1.
+   *    May be NULL if pixelStride is 1.
+   *  @return number of bytes that have been decompressed, which is less than
+   *    numberOfBytes if the compressed data is incomplete
+   */
+  static size_t decodeStripe(const Uint8 *rleData,
+                             const size_t rleSize,
+                             Uint8 *target,
+                             const size_t pixelStride,
+                             const size_t numberOfBytes,
+                             Uint8 *stripeBuffer);
+
+private:
+
+  /** compresses one row that is stored in consecutive bytes.
+   *  @param row pointer to the bytes of the row
+   *  @param length number of bytes of the row
+   *  @param target pointer to the buffer for the compressed row
+   *  @return pointer to the byte following the compressed row
+   */
+  static Uint8 *encodeRow(const Uint8 *row,
+                          const size_t length,
+                          Uint8 *target);
+
+  /** searches for the first run of three or more identical bytes
+   *  @param data pointer to the bytes to be searched
+   *  @param start index of the first byte to be considered
+   *  @param length total number of bytes
+   *  @return index of the first byte of the run, length if there is none
+   */
+  static size_t findRun(const Uint8 *data,
+                        size_t start,
+                        const size_t length);
+
+  /** determines the length of the run of identical bytes starting at the given index
+   *  @param data pointer to the bytes to be searched
+   *  @param start index of the first byte of the run
+   *  @param length total number of bytes
+   *  @return number of identical bytes, at least 1
+   */
+  static size_t getRunLength(const Uint8 *data,
+                             const size_t start,
+                             const size_t length);
+
+  /// private undefined default constructor
+  DcmRLEStripeCodec();
+
+  /// private undefined copy constructor
+  DcmRLEStripeCodec(const DcmRLEStripeCodec&);
+
+  /// private undefined copy assignment operator
+  DcmRLEStripeCodec& operator=(const DcmRLEStripeCodec&);
+};
+
+#endif
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2015, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -36,6 +36,8 @@
  *  that sequences have no value field as such, they maintain a list of items. However,
  *  all APIs in class DcmItem and class DcmDataset accept DcmElements.
  *  This is ugly and causes some DcmElement API methods to be useless with DcmSequence.
+ *  If lazy sequence parsing is enabled (see dcmLazySequenceParsing), the items of a
+ *  sequence that is read from a file are only parsed when they are accessed first.
  */
 class DCMTK_DCMDATA_EXPORT DcmSequenceOfItems : public DcmElement
 {
@@ -335,6 +337,15 @@ public:
      */
     virtual unsigned long card() const;
 
+    /** check whether the items of this sequence have already been parsed.
+     *  If lazy sequence parsing is enabled (see dcmLazySequenceParsing), the
+     *  items are only read from file when they are accessed first, e.g. by
+     *  card(), getItem() or search().
+     *  @return OFTrue if all items are present in memory, OFFalse if they
+     *    still reside in file
+     */
+    OFBool itemsLoaded() const { return fLoadItems == NULL; }
+
     /** insert the given item at the start of the item list maintained by this sequence.
      *  Ownership of the item, which must be allocated on the heap, is transferred to the sequence.
      *  @param item pointer to DcmItem instance allocated on the heap, must not be NULL.
@@ -564,6 +575,13 @@ protected:
                                           DcmStack &resultStack,              // inout
                                           const OFBool searchIntoSub);        // in
 
+    /** read the items of this sequence from file if they have not been parsed
+     *  yet (see dcmLazySequenceParsing). This method does nothing if the items
+     *  are already present in memory.
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    OFCondition loadItems();
+
     /// the list of items maintained by this sequence object
     DcmList *itemList;
 
@@ -583,6 +601,39 @@ private:
                                      DcmEVR vr,
                                      const E_TransferSyntax oxfer);
 
+    /** helper function for read() and loadItems(). Reads the items of this
+     *  sequence from the given stream. The transfer state must be ERW_inWork.
+     *  @param inStream      The stream which contains the information.
+     *  @param xfer          The transfer syntax which was used to encode
+     *                       the information in inStream.
+     *  @param glenc         Encoding type for group length; specifies
+     *                       what will be done with group length tags.
+     *  @param maxReadLength Maximum read length for reading an attribute value.
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    OFCondition readItems(DcmInputStream &inStream,
+                          const E_TransferSyntax xfer,
+                          const E_GrpLenEncoding glenc,
+                          const Uint32 maxReadLength);
+
+    /** helper function for read(). Skips the items of this sequence in the given
+     *  stream and remembers their position, so they can be read later by loadItems().
+     *  This is only possible if the stream has random access and if the end of the
+     *  sequence can be determined unambiguously without parsing the items.
+     *  Otherwise, the stream is not modified.
+     *  @param inStream      The stream which contains the information.
+     *  @param xfer          The transfer syntax which was used to encode
+     *                       the information in inStream.
+     *  @param glenc         Encoding type for group length; specifies
+     *                       what will be done with group length tags.
+     *  @param maxReadLength Maximum read length for reading an attribute value.
+     *  @return OFTrue if the items have been skipped, OFFalse otherwise
+     */
+    OFBool skipItems(DcmInputStream &inStream,
+                     const E_TransferSyntax xfer,
+                     const E_GrpLenEncoding glenc,
+                     const Uint32 maxReadLength);
+
     /** flag used during suspended I/O. Indicates whether the last item
      *  was completely or only partially read/written during the last call
      *  to read/write.
@@ -600,6 +651,21 @@ private:
      */
     OFBool readAsUN_;
 
+    /** used during lazy parsing. Creates a stream that allows for reading the
+     *  items of this sequence, which have not been parsed yet. NULL if the
+     *  items are present in memory.
+     */
+    DcmInputStreamFactory *fLoadItems;
+
+    /// transfer syntax used for reading the items later (see fLoadItems)
+    E_TransferSyntax fLoadItemsXfer;
+
+    /// group length encoding used for reading the items later (see fLoadItems)
+    E_GrpLenEncoding fLoadItemsGlenc;
+
+    /// maximum read length used for reading the items later (see fLoadItems)
+    Uint32 fLoadItemsMaxReadLength;
+
 };
 
 
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -41,7 +41,9 @@ DCMTK_DCMDATA_EXPORT OFCondition swapIfNecessary(
   const Uint32 byteLength,
   const size_t valWidth);
 
-/** swap block of data from big-endian to little-endian or back
+/** swap block of data from big-endian to little-endian or back.
+ *  Blocks of 2, 4 or 8 byte values are swapped using vector instructions
+ *  (SSE2 or NEON) if available on the target platform.
  *  @param value pointer to block of data
  *  @param byteLength size of data block in bytes
  *  @param valWidth size of each value in the data block, in bytes
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -313,6 +313,13 @@ class DCMTK_DCMDATA_EXPORT DcmOtherByteOtherWord
      */
     virtual void postLoadValue();
 
+    /** check whether the element value stays in memory after this element has
+     *  been written. This is not the case if the value was loaded from file
+     *  for the write operation only and is removed again afterwards.
+     *  @return OFTrue if the value may be referenced, OFFalse if it must be copied
+     */
+    virtual OFBool valueRemainsAfterWrite() const;
+
     /** align the element value to an even length (padding)
      *  @return status, EC_Normal if successful, an error code otherwise
      */
@@ -0,0 +1,319 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: arena allocator for objects created by the parser
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/dcmdata/dcarena.h"
+#include "dcmtk/ofstd/oftypes.h"
+
+#define INCLUDE_NEW
+#include "dcmtk/ofstd/ofstdinc.h"
+
+#if defined(WITH_THREADS) && !defined(HAVE_SYNC_ADD_AND_FETCH) && defined(HAVE_INTERLOCKED_INCREMENT) && defined(HAVE_WINDOWS_H)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+
+/* header that precedes each block returned by allocateObject() and
+ * allocateValue(). It stores the arena the block has been allocated from,
+ * or NULL if the block has been allocated from the heap. The union makes
+ * sure that the memory following the header is suitably aligned for all
+ * types used by DcmObject.
+ */
+union DcmArenaBlockHeader
+{
+  DcmArena *arena;
+  double alignDouble;
+  Uint64 alignUint64;
+  void *alignPointer;
+};
+
+/* header of each chunk of memory managed by an arena */
+union DcmArenaChunkHeader
+{
+  void *next;
+  double alignDouble;
+  Uint64 alignUint64;
+};
+
+/* size of the headers, rounded to the required alignment */
+#define DCMARENA_BLOCK_HEADER sizeof(DcmArenaBlockHeader)
+#define DCMARENA_CHUNK_HEADER sizeof(DcmArenaChunkHeader)
+
+/* round the given size up to a multiple of the block header size */
+#define DCMARENA_ALIGN(size) (((size) + DCMARENA_BLOCK_HEADER - 1) / DCMARENA_BLOCK_HEADER * DCMARENA_BLOCK_HEADER)
+
+/* flag indicating whether an arena has ever been activated. As long as this
+ * is not the case, allocateObject() does not need to check the thread
+ * specific data at all.
+ */
+static volatile OFBool arenaActivated = OFFalse;
+
+#ifdef WITH_THREADS
+/* arena that is active for the current thread */
+static OFThreadSpecificData currentArena;
+#else
+/* arena that is active (in a single-threaded environment) */
+static DcmArena *currentArena = NULL;
+#endif
+
+
+DcmArena *DcmArena::newInstance(const size_t chunkSize,
+                                const size_t maxValueSize)
+{
+  return new DcmArena(chunkSize, maxValueSize);
+}
+
+
+DcmArena::DcmArena(const size_t chunkSize,
+                   const size_t maxValueSize)
+: chunkSize_(DCMARENA_ALIGN(chunkSize))
+, maxValueSize_(maxValueSize)
+, chunks_(NULL)
+, next_(NULL)
+, avail_(0)
+, refCount_(1)
+#ifdef DCMARENA_NEED_MUTEX
+, mutex_()
+#endif
+{
+}
+
+
+DcmArena::~DcmArena()
+{
+  // free all chunks at once
+  while (chunks_)
+  {
+    void *next = OFstatic_cast(DcmArenaChunkHeader *, chunks_)->next;
+    delete[] OFstatic_cast(char *, chunks_);
+    chunks_ = next;
+  }
+}
+
+
+void DcmArena::release()
+{
+  decreaseRefCount();
+}
+
+
+size_t DcmArena::numberOfObjects()
+{
+  // one reference is held by the owner (unless already released)
+#if !defined(WITH_THREADS)
+  return refCount_ - 1;
+#elif defined(HAVE_SYNC_ADD_AND_FETCH)
+  return __sync_add_and_fetch(&refCount_, 0) - 1;
+#elif defined(HAVE_INTERLOCKED_INCREMENT)
+  return OFstatic_cast(size_t, InterlockedExchangeAdd(&refCount_, 0) - 1);
+#else
+  mutex_.lock();
+  const size_t result = refCount_ - 1;
+  mutex_.unlock();
+  return result;
+#endif
+}
+
+
+void *DcmArena::allocate(const size_t size)
+{
+  const size_t blockSize = DCMARENA_BLOCK_HEADER + DCMARENA_ALIGN(size);
+  char *block = NULL;
+  // no need to lock anything since an arena is only active in a single thread
+  if (blockSize > avail_)
+  {
+    // very large blocks get a chunk of their own
+    const size_t newChunkSize = (blockSize > chunkSize_) ? blockSize : chunkSize_;
+    char *chunk;
+#ifdef HAVE_STD__NOTHROW
+    chunk = new (std::nothrow) char[DCMARENA_CHUNK_HEADER + newChunkSize];
+#else
+    try
+    {
+      chunk = new char[DCMARENA_CHUNK_HEADER + newChunkSize];
+    }
+    catch (STD_NAMESPACE bad_alloc const &)
+    {
+      chunk = NULL;
+    }
+#endif
+    if (chunk)
+    {
+      OFreinterpret_cast(DcmArenaChunkHeader *, chunk)->next = chunks_;
+      chunks_ = chunk;
+      next_ = chunk + DCMARENA_CHUNK_HEADER;
+      avail_ = newChunkSize;
+    }
+  }
+  if (blockSize <= avail_)
+  {
+    block = next_;
+    next_ += blockSize;
+    avail_ -= blockSize;
+    // each block holds a reference to the arena
+    increaseRefCount();
+  }
+  if (block == NULL) return NULL;
+  OFreinterpret_cast(DcmArenaBlockHeader *, block)->arena = this;
+  return block + DCMARENA_BLOCK_HEADER;
+}
+
+
+void DcmArena::increaseRefCount()
+{
+#if !defined(WITH_THREADS)
+  ++refCount_;
+#elif defined(HAVE_SYNC_ADD_AND_FETCH)
+  __sync_add_and_fetch(&refCount_, 1);
+#elif defined(HAVE_INTERLOCKED_INCREMENT)
+  InterlockedIncrement(&refCount_);
+#else
+  mutex_.lock();
+  ++refCount_;
+  mutex_.unlock();
+#endif
+}
+
+
+void DcmArena::decreaseRefCount()
+{
+#if !defined(WITH_THREADS)
+  const OFBool last = (--refCount_ == 0);
+#elif defined(HAVE_SYNC_SUB_AND_FETCH)
+  const OFBool last = (__sync_sub_and_fetch(&refCount_, 1) == 0);
+#elif defined(HAVE_INTERLOCKED_DECREMENT)
+  const OFBool last = (InterlockedDecrement(&refCount_) == 0);
+#else
+  mutex_.lock();
+  const OFBool last = (--refCount_ == 0);
+  mutex_.unlock();
+#endif
+  if (last) delete this;
+}
+
+
+DcmArena *DcmArena::current()
+{
+  if (!arenaActivated) return NULL;
+#ifdef WITH_THREADS
+  void *result = NULL;
+  currentArena.get(result);
+  return OFstatic_cast(DcmArena *, result);
+#else
+  return currentArena;
+#endif
+}
+
+
+void DcmArena::setCurrent(DcmArena *arena)
+{
+  if (arena) arenaActivated = OFTrue;
+  // nothing to do if no arena has ever been activated
+  else if (!arenaActivated) return;
+#ifdef WITH_THREADS
+  currentArena.set(arena);
+#else
+  currentArena = arena;
+#endif
+}
+
+
+void *DcmArena::allocateObject(const size_t size,
+                               const OFBool noThrow)
+{
+  DcmArena *arena = current();
+  if (arena)
+  {
+    void *result = arena->allocate(size);
+    if ((result == NULL) && !noThrow) throw STD_NAMESPACE bad_alloc();
+    return result;
+  }
+  // allocate from the heap, the header marks the block as such
+  char *block = NULL;
+  if (noThrow)
+  {
+#ifdef HAVE_STD__NOTHROW
+    block = OFstatic_cast(char *, ::operator new(DCMARENA_BLOCK_HEADER + size, std::nothrow));
+#else
+    try
+    {
+      block = OFstatic_cast(char *, ::operator new(DCMARENA_BLOCK_HEADER + size));
+    }
+    catch (STD_NAMESPACE bad_alloc const &)
+    {
+      block = NULL;
+    }
+#endif
+    if (block == NULL) return NULL;
+  }
+  else
+    block = OFstatic_cast(char *, ::operator new(DCMARENA_BLOCK_HEADER + size));
+  OFreinterpret_cast(DcmArenaBlockHeader *, block)->arena = NULL;
+  return block + DCMARENA_BLOCK_HEADER;
+}
+
+
+void *DcmArena::allocateValue(const size_t size)
+{
+  DcmArena *arena = current();
+  if (arena && (size <= arena->maxValueSize_))
+    return arena->allocate(size);
+  return NULL;
+}
+
+
+void DcmArena::deallocateObject(void *ptr)
+{
+  if (ptr)
+  {
+    char *block = OFstatic_cast(char *, ptr) - DCMARENA_BLOCK_HEADER;
+    DcmArena *arena = OFreinterpret_cast(DcmArenaBlockHeader *, block)->arena;
+    if (arena)
+      arena->decreaseRefCount();
+    else
+      ::operator delete(block);
+  }
+}
+
+
+void DcmArena::deallocateValue(void *ptr)
+{
+  if (ptr)
+  {
+    char *block = OFstatic_cast(char *, ptr) - DCMARENA_BLOCK_HEADER;
+    // memory allocated from an arena is freed when the arena is deleted
+    OFreinterpret_cast(DcmArenaBlockHeader *, block)->arena->decreaseRefCount();
+  }
+}
+
+
+DcmArenaScope::DcmArenaScope(DcmArena *arena)
+: previous_(DcmArena::current())
+{
+  DcmArena::setCurrent(arena);
+}
+
+
+DcmArenaScope::~DcmArenaScope()
+{
+  DcmArena::setCurrent(previous_);
+}
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2010, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -41,6 +41,33 @@ OFReadWriteLock DcmCodecList::codecLock;
 
 /* --------------------------------------------------------------- */
 
+OFCondition DcmCodec::decodeFrames(
+  const DcmRepresentationParameter * fromParam,
+  DcmPixelSequence * fromPixSeq,
+  const DcmCodecParameter * cp,
+  DcmItem *dataset,
+  Uint32 firstFrame,
+  Uint32 numberOfFrames,
+  Uint32& startFragment,
+  void *buffer,
+  Uint32 frameBufSize,
+  OFString& decompressedColorModel) const
+{
+  if ((buffer == NULL) || (numberOfFrames == 0)) return EC_IllegalCall;
+  OFCondition result = EC_Normal;
+  Uint8 *frameBuffer = OFstatic_cast(Uint8 *, buffer);
+
+  // decompress one frame after the other. decodeFrame() updates startFragment
+  for (Uint32 i = 0; (i < numberOfFrames) && result.good(); i++)
+  {
+    result = decodeFrame(fromParam, fromPixSeq, cp, dataset, firstFrame + i, startFragment,
+      frameBuffer, frameBufSize, decompressedColorModel);
+    frameBuffer += frameBufSize;
+  }
+  return result;
+}
+
+
 // DcmCodec static helper methods
 
 OFCondition DcmCodec::insertStringIfMissing(DcmItem *dataset, const DcmTagKey& tag, const char *val)
@@ -230,6 +257,7 @@ OFCondition DcmCodec::determineStartFragment(
   DcmPixelSequence * fromPixSeq,
   Uint32& currentItem)
 {
+  if (fromPixSeq == NULL) return EC_IllegalCall;
   Uint32 numberOfFragments = OFstatic_cast(Uint32, fromPixSeq->card());
   if (numberOfFrames < 1 || numberOfFragments <= OFstatic_cast(Uint32, numberOfFrames) || frameNo >= OFstatic_cast(Uint32, numberOfFrames)) return EC_IllegalCall;
 
@@ -240,65 +268,29 @@ OFCondition DcmCodec::determineStartFragment(
     return EC_Normal;
   }
 
-  if (numberOfFragments == OFstatic_cast(Uint32, numberOfFrames) + 1)
-  {
-    // standard case: there is one fragment per frame.
-    currentItem = frameNo + 1;
-    return EC_Normal;
-  }
-
-  // non-standard case: multiple fragments per frame.
-  // We now try to consult the offset table.
-  DcmPixelItem *pixItem = NULL;
-  Uint8 * rawOffsetTable = NULL;
-
-  // get first pixel item, i.e. the fragment containing the offset table
-  OFCondition result = fromPixSeq->getItem(pixItem, 0);
-  if (result.good())
-  {
-    Uint32 tableLength = pixItem->getLength();
-    result = pixItem->getUint8Array(rawOffsetTable);
-    if (result.good())
-    {
-      // check if the offset table has the right size: 4 bytes for each frame (not fragment!)
-      if (tableLength != 4* OFstatic_cast(Uint32, numberOfFrames)) return EC_IllegalCall;
-
-      // byte swap offset table into local byte order. In file, the offset table is always in little endian
-      swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, rawOffsetTable, tableLength, sizeof(Uint32));
-
-      // cast offset table to Uint32.
-      Uint32 *offsetTable = OFreinterpret_cast(Uint32 *, rawOffsetTable);
-
-      // now access offset of the frame we're looking for
-      Uint32 offset = offsetTable[frameNo];
-
-      // OK, now let's look if we can find a fragment that actually corresponds to that offset.
-      // In counter we compute the offset for each frame by adding all fragment lenghts
-      Uint32 counter = 0;
-      // now iterate over all fragments except the index table. The start of the first fragment
-      // is defined as zero.
-      for (Uint32 idx = 1; idx < numberOfFragments; ++idx)
-      {
-        if (counter == offset)
-        {
-          // hooray, we are lucky. We have found the fragment we're looking for
-          currentItem = idx;
-          return EC_Normal;
-        }
+  // all other cases are handled by the frame index of the pixel sequence,
+  // which is built only once
+  Uint32 endFragment = 0;
+  return fromPixSeq->getFrameFragments(frameNo, OFstatic_cast(Uint32, numberOfFrames), currentItem, endFragment);
+}
 
-        // access pixel item in order to determine its length
-        result = fromPixSeq->getItem(pixItem, idx);
-        if (result.bad()) return result;
 
-        // add pixel item length plus 8 bytes overhead for the item tag and length field
-        counter += pixItem->getLength() + 8;
-      }
+OFCondition DcmCodec::determineFrameFragments(
+  Uint32 firstFrame,
+  Uint32 count,
+  Sint32 numberOfFrames,
+  DcmPixelSequence * fromPixSeq,
+  Uint32 *startFragments)
+{
+  if ((fromPixSeq == NULL) || (startFragments == NULL) || (numberOfFrames < 1) || (count == 0)) return EC_IllegalCall;
+  const Uint32 frames = OFstatic_cast(Uint32, numberOfFrames);
+  if ((firstFrame >= frames) || (count > frames - firstFrame)) return EC_IllegalCall;
 
-      // bad luck. We have not found a fragment corresponding to the offset in the offset table.
-      // Either we cannot correctly add numbers, or they cannot :-)
-      return EC_TagNotFound;
-    }
-  }
+  Uint32 endFragment = 0;
+  OFCondition result = EC_Normal;
+  for (Uint32 i = 0; (i < count) && result.good(); ++i)
+    result = fromPixSeq->getFrameFragments(firstFrame + i, frames, startFragments[i], endFragment);
+  if (result.good()) startFragments[count] = endFragment;
   return result;
 }
 
@@ -496,6 +488,48 @@ OFCondition DcmCodecList::decodeFrame(
 }
 
 
+OFCondition DcmCodecList::decodeFrames(
+  const DcmXfer & fromType,
+  const DcmRepresentationParameter * fromParam,
+  DcmPixelSequence * fromPixSeq,
+  DcmItem *dataset,
+  Uint32 firstFrame,
+  Uint32 numberOfFrames,
+  Uint32& startFragment,
+  void *buffer,
+  Uint32 frameBufSize,
+  OFString& decompressedColorModel)
+{
+#ifdef WITH_THREADS
+  if (! codecLock.initialized()) return EC_IllegalCall; // should never happen
+#endif
+  OFCondition result = EC_CannotChangeRepresentation;
+
+  // acquire write lock on codec list.  Will block if some write lock is currently active.
+#ifdef WITH_THREADS
+  OFReadWriteLocker locker(codecLock);
+  if (0 == locker.rdlock())
+  {
+#endif
+    E_TransferSyntax fromXfer = fromType.getXfer();
+    OFListIterator(DcmCodecList *) first = registeredCodecs.begin();
+    OFListIterator(DcmCodecList *) last = registeredCodecs.end();
+    while (first != last)
+    {
+      if ((*first)->codec->canChangeCoding(fromXfer, EXS_LittleEndianExplicit))
+      {
+        result = (*first)->codec->decodeFrames(fromParam, fromPixSeq, (*first)->codecParameter,
+                 dataset, firstFrame, numberOfFrames, startFragment, buffer, frameBufSize, decompressedColorModel);
+        first = last;
+      } else ++first;
+    }
+#ifdef WITH_THREADS
+  } else result = EC_IllegalCall;
+#endif
+  return result;
+}
+
+
 OFCondition DcmCodecList::encode(
   const E_TransferSyntax fromRepType,
   const DcmRepresentationParameter * fromParam,
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2015, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -41,6 +41,7 @@
 #include "dcmtk/dcmdata/dcistrma.h"    /* for class DcmInputStream */
 #include "dcmtk/dcmdata/dcistrmf.h"    /* for class DcmInputFileStream */
 #include "dcmtk/dcmdata/dcwcache.h"    /* for class DcmWriteCache */
+#include "dcmtk/dcmdata/dcarena.h"     /* for class DcmArena */
 
 
 // ********************************
@@ -50,7 +51,8 @@ DcmDataset::DcmDataset()
   : DcmItem(ItemTag, DCM_UndefinedLength),
     OriginalXfer(EXS_Unknown),
     // the default transfer syntax is explicit VR with local endianness
-    CurrentXfer((gLocalByteOrder == EBO_BigEndian) ? EXS_BigEndianExplicit : EXS_LittleEndianExplicit)
+    CurrentXfer((gLocalByteOrder == EBO_BigEndian) ? EXS_BigEndianExplicit : EXS_LittleEndianExplicit),
+    Arena(NULL)
 {
 }
 
@@ -72,7 +74,8 @@ DcmDataset& DcmDataset::operator=(const DcmDataset& obj)
 DcmDataset::DcmDataset(const DcmDataset &old)
   : DcmItem(old),
     OriginalXfer(old.OriginalXfer),
-    CurrentXfer(old.CurrentXfer)
+    CurrentXfer(old.CurrentXfer),
+    Arena(NULL)
 {
 }
 
@@ -90,6 +93,9 @@ OFCondition DcmDataset::copyFrom(const DcmObject& rhs)
 
 DcmDataset::~DcmDataset()
 {
+    // the arena is deleted as soon as all elements allocated from it are deleted
+    if (Arena)
+        Arena->release();
 }
 
 
@@ -99,6 +105,12 @@ DcmDataset::~DcmDataset()
 OFCondition DcmDataset::clear()
 {
     OFCondition result = DcmItem::clear();
+    // start with a new arena when reading the next dataset
+    if (Arena)
+    {
+        Arena->release();
+        Arena = NULL;
+    }
     // TODO: should we also reset OriginalXfer and CurrentXfer?
     setLengthField(DCM_UndefinedLength);
     return result;
@@ -340,6 +352,17 @@ OFCondition DcmDataset::read(DcmInputStream &inStream,
                              const E_TransferSyntax xfer,
                              const E_GrpLenEncoding glenc,
                              const Uint32 maxReadLength)
+{
+    return DcmDataset::readUntilTag(inStream, xfer, glenc, maxReadLength, DCM_UndefinedTagKey);
+}
+
+
+OFCondition DcmDataset::readUntilTag(DcmInputStream &inStream,
+                                     const E_TransferSyntax xfer,
+                                     const E_GrpLenEncoding glenc,
+                                     const Uint32 maxReadLength,
+                                     const DcmTagKey &stopParsingAtElement,
+                                     const OFList<DcmTagKey> *tagFilter)
 {
     /* check if the stream variable reported an error */
     errorFlag = inStream.status();
@@ -414,7 +437,14 @@ OFCondition DcmDataset::read(DcmInputStream &inStream,
         }
         /* pass processing the task to class DcmItem */
         if (errorFlag.good())
-            errorFlag = DcmItem::read(inStream, OriginalXfer, glenc, maxReadLength);
+        {
+            /* allocate all objects created by the parser from the arena (if enabled) */
+            if (!Arena && dcmUseArenaAllocation.get())
+                Arena = DcmArena::newInstance();
+            DcmArenaScope arenaScope(Arena);
+            errorFlag = DcmItem::readUntilTag(inStream, OriginalXfer, glenc, maxReadLength,
+                stopParsingAtElement, tagFilter);
+        }
     }
 
     /* if the error flag shows ok or that the end of the stream was encountered, */
@@ -434,7 +464,7 @@ OFCondition DcmDataset::read(DcmInputStream &inStream,
     }
 
     /* dump information if required */
-    DCMDATA_TRACE("DcmDataset::read() returns error = " << errorFlag.text());
+    DCMDATA_TRACE("DcmDataset::readUntilTag() returns error = " << errorFlag.text());
 
     /* return result flag */
     return errorFlag;
@@ -603,16 +633,31 @@ OFCondition DcmDataset::loadFile(const OFFilename &fileName,
                                  const E_TransferSyntax readXfer,
                                  const E_GrpLenEncoding groupLength,
                                  const Uint32 maxReadLength)
+{
+    return loadFileUntilTag(fileName, readXfer, groupLength, maxReadLength, DCM_UndefinedTagKey);
+}
+
+
+OFCondition DcmDataset::loadFileUntilTag(const OFFilename &fileName,
+                                         const E_TransferSyntax readXfer,
+                                         const E_GrpLenEncoding groupLength,
+                                         const Uint32 maxReadLength,
+                                         const DcmTagKey &stopParsingAtElement,
+                                         const OFList<DcmTagKey> *tagFilter)
 {
     OFCondition l_error = EC_InvalidFilename;
     /* check parameters first */
     if (!fileName.isEmpty())
     {
-        /* open file for input */
-        DcmInputFileStream fileStream(fileName);
+        /* open file for input (map file into memory if desired) */
+        DcmInputStream *fileStream;
+        if (dcmUseMemoryMappedFileInput.get())
+            fileStream = new DcmInputMappedFileStream(fileName);
+        else
+            fileStream = new DcmInputFileStream(fileName);
 
         /* check stream status */
-        l_error = fileStream.status();
+        l_error = fileStream->status();
 
         if (l_error.good())
         {
@@ -622,10 +667,12 @@ OFCondition DcmDataset::loadFile(const OFFilename &fileName,
             {
                 /* read data from file */
                 transferInit();
-                l_error = read(fileStream, readXfer, groupLength, maxReadLength);
+                l_error = readUntilTag(*fileStream, readXfer, groupLength, maxReadLength,
+                    stopParsingAtElement, tagFilter);
                 transferEnd();
             }
         }
+        delete fileStream;
     }
     return l_error;
 }
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -27,6 +27,7 @@
 #include "dcmtk/ofstd/ofdefine.h"
 #include "dcmtk/dcmdata/dcdicent.h"
 #include "dcmtk/dcmdata/dctypes.h"
+#include "dcmtk/ofstd/ofvector.h"
 
 #define INCLUDE_CSTDLIB
 #define INCLUDE_CSTDIO
@@ -34,6 +35,31 @@
 #define INCLUDE_CCTYPE
 #include "dcmtk/ofstd/ofstdinc.h"
 
+#if defined(WITH_THREADS) && !defined(HAVE_SYNC_ADD_AND_FETCH) && defined(HAVE_INTERLOCKED_INCREMENT) && defined(HAVE_WINDOWS_H)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+/*
+** Atomic load (with acquire semantics) and store (with release semantics)
+** of the pointer to the current dictionary index, which is required for
+** publishing a new index to other threads without a lock. If no such
+** operations are available, the pointer is accessed with the read/write
+** lock being held.
+*/
+#ifdef WITH_THREADS
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define DCMDICT_LOAD_ACQUIRE(ptr) __atomic_load_n(&(ptr), __ATOMIC_ACQUIRE)
+#define DCMDICT_STORE_RELEASE(ptr, value) __atomic_store_n(&(ptr), (value), __ATOMIC_RELEASE)
+#elif defined(HAVE_SYNC_ADD_AND_FETCH)
+#define DCMDICT_LOAD_ACQUIRE(ptr) __sync_fetch_and_add(&(ptr), 0)
+#define DCMDICT_STORE_RELEASE(ptr, value) do { __sync_synchronize(); (ptr) = (value); } while (0)
+#elif defined(HAVE_INTERLOCKED_INCREMENT) && defined(HAVE_WINDOWS_H)
+#define DCMDICT_LOAD_ACQUIRE(ptr) OFstatic_cast(DcmDataDictionaryIndex *, InterlockedCompareExchangePointer(OFreinterpret_cast(PVOID volatile *, &(ptr)), NULL, NULL))
+#define DCMDICT_STORE_RELEASE(ptr, value) InterlockedExchangePointer(OFreinterpret_cast(PVOID volatile *, &(ptr)), (value))
+#endif
+#endif
+
 /*
 ** The separator character between fields in the data dictionary file(s)
 */
@@ -785,8 +811,160 @@ DcmDataDictionary::findEntry(const char *name) const
 /* ================================================================== */
 
 
+/** immutable index of all entries of a data dictionary. The index contains
+ *  copies of the dictionary entries, so it can be used without any lock while
+ *  the dictionary itself is modified. The normal (non-repeating) entries are
+ *  stored in an open addressing hash table, which is never modified after
+ *  construction.
+ */
+class DcmDataDictionaryIndex
+{
+public:
+
+    /** constructor, creates an index of all entries of the given dictionary
+     *  @param dict dictionary to be indexed
+     */
+    DcmDataDictionaryIndex(DcmDataDictionary &dict);
+
+    /// destructor
+    ~DcmDataDictionaryIndex();
+
+    /** dictionary lookup for the given tag key and private creator name,
+     *  see DcmDataDictionary::findEntry()
+     *  @param key tag key
+     *  @param privCreator private creator name, may be NULL
+     *  @return pointer to dictionary entry if found, NULL otherwise
+     */
+    const DcmDictEntry *findEntry(const DcmTagKey &key, const char *privCreator) const;
+
+private:
+
+    /// private undefined copy constructor
+    DcmDataDictionaryIndex(const DcmDataDictionaryIndex &);
+
+    /// private undefined assignment operator
+    DcmDataDictionaryIndex &operator=(const DcmDataDictionaryIndex &);
+
+    /** compute the position of the given tag key in the hash table
+     *  @param key tag key
+     *  @return index of the first slot to be checked
+     */
+    size_t slot(const DcmTagKey &key) const
+    {
+        return OFstatic_cast(size_t, (key.hash() * 2654435761UL) & 0xffffffffUL) >> shift_ & mask_;
+    }
+
+    /** look up the given tag key and private creator in the hash table
+     *  @param key tag key
+     *  @param privCreator private creator name, may be NULL
+     *  @return pointer to dictionary entry if found, NULL otherwise
+     */
+    const DcmDictEntry *findNormalEntry(const DcmTagKey &key, const char *privCreator) const;
+
+    /// copies of the normal (non-repeating) dictionary entries
+    OFVector<DcmDictEntry *> normalEntries_;
+
+    /// copies of the repeating dictionary entries, in search order
+    OFVector<DcmDictEntry *> repeatingEntries_;
+
+    /// hash table with open addressing (linear probing), NULL for empty slots
+    OFVector<const DcmDictEntry *> table_;
+
+    /// bit mask for the positions in the hash table (size of table minus 1)
+    size_t mask_;
+
+    /// number of bits the hash code is shifted to the right
+    int shift_;
+};
+
+
+DcmDataDictionaryIndex::DcmDataDictionaryIndex(DcmDataDictionary &dict)
+  : normalEntries_(),
+    repeatingEntries_(),
+    table_(),
+    mask_(0),
+    shift_(32)
+{
+    DcmHashDictIterator iter;
+    for (iter = dict.normalBegin(); iter != dict.normalEnd(); ++iter)
+        normalEntries_.push_back(new DcmDictEntry(**iter));
+    DcmDictEntryListIterator iter2;
+    for (iter2 = dict.repeatingBegin(); iter2 != dict.repeatingEnd(); ++iter2)
+        repeatingEntries_.push_back(new DcmDictEntry(**iter2));
+    /* the hash table is at most half full, so collisions are rare */
+    size_t size = 1;
+    while ((size < 16) || (size < 2 * normalEntries_.size()))
+    {
+        size <<= 1;
+        --shift_;
+    }
+    mask_ = size - 1;
+    table_.resize(size, NULL);
+    for (size_t i = 0; i < normalEntries_.size(); ++i)
+    {
+        size_t pos = slot(normalEntries_[i]->getKey());
+        while (table_[pos] != NULL)
+            pos = (pos + 1) & mask_;
+        table_[pos] = normalEntries_[i];
+    }
+}
+
+
+DcmDataDictionaryIndex::~DcmDataDictionaryIndex()
+{
+    size_t i;
+    for (i = 0; i < normalEntries_.size(); ++i)
+        delete normalEntries_[i];
+    for (i = 0; i < repeatingEntries_.size(); ++i)
+        delete repeatingEntries_[i];
+}
+
+
+const DcmDictEntry *DcmDataDictionaryIndex::findNormalEntry(const DcmTagKey &key, const char *privCreator) const
+{
+    /* there might be several entries with the same tag key but different private creators */
+    size_t pos = slot(key);
+    const DcmDictEntry *e;
+    while ((e = table_[pos]) != NULL)
+    {
+        if ((e->getKey() == key) && e->privateCreatorMatch(privCreator))
+            return e;
+        pos = (pos + 1) & mask_;
+    }
+    return NULL;
+}
+
+
+const DcmDictEntry *DcmDataDictionaryIndex::findEntry(const DcmTagKey &key, const char *privCreator) const
+{
+    /* same search order as in DcmDataDictionary::findEntry() and DcmHashDict::get() */
+    const DcmDictEntry *e = findNormalEntry(key, privCreator);
+    if ((e == NULL) && privCreator)
+    {
+        /* as a second guess, we look for a private tag with flexible element number */
+        e = findNormalEntry(DcmTagKey(key.getGroup(), OFstatic_cast(Uint16, key.getElement() & 0xff)), privCreator);
+    }
+    if (e == NULL)
+    {
+        /* search in the repeating tags */
+        for (size_t i = 0; i < repeatingEntries_.size(); ++i)
+        {
+            if (repeatingEntries_[i]->contains(key, privCreator))
+                return repeatingEntries_[i];
+        }
+    }
+    return e;
+}
+
+
+/* ================================================================== */
+
+
 GlobalDcmDataDictionary::GlobalDcmDataDictionary()
   : dataDict(NULL)
+  , dataDictIndex(NULL)
+  , retiredDataDictIndexes()
+  , dataDictWriteLocked(OFFalse)
 #ifdef WITH_THREADS
   , dataDictLock()
 #endif
@@ -797,6 +975,12 @@ GlobalDcmDataDictionary::~GlobalDcmDataDictionary()
 {
   /* No threads may be active any more, so no locking needed */
   delete dataDict;
+  delete dataDictIndex;
+  while (!retiredDataDictIndexes.empty())
+  {
+    delete retiredDataDictIndexes.front();
+    retiredDataDictIndexes.pop_front();
+  }
 }
 
 void GlobalDcmDataDictionary::createDataDict()
@@ -813,12 +997,58 @@ void GlobalDcmDataDictionary::createDataDict()
   /* Make sure no other thread managed to create the dictionary
    * before we got our write lock. */
   if (!dataDict)
+  {
     dataDict = new DcmDataDictionary(OFTrue /*loadBuiltin*/, loadExternal);
+    updateDataDictIndex();
+  }
 #ifdef WITH_THREADS
   dataDictLock.unlock();
 #endif
 }
 
+void GlobalDcmDataDictionary::updateDataDictIndex()
+{
+  DcmDataDictionaryIndex *newIndex = new DcmDataDictionaryIndex(*dataDict);
+  DcmDataDictionaryIndex *oldIndex = dataDictIndex;
+#ifdef DCMDICT_STORE_RELEASE
+  /* make sure that the index is complete before other threads can see it */
+  DCMDICT_STORE_RELEASE(dataDictIndex, newIndex);
+#else
+  dataDictIndex = newIndex;
+#endif
+  /* Other threads might still perform a lookup in the replaced index or
+   * use the entries returned from it, and there is no way to find out when
+   * they are done. So the index is only deleted with this object.
+   */
+  if (oldIndex)
+    retiredDataDictIndexes.push_back(oldIndex);
+}
+
+DcmDataDictionaryIndex *GlobalDcmDataDictionary::getDataDictIndex()
+{
+#if defined(WITH_THREADS) && !defined(DCMDICT_LOAD_ACQUIRE)
+  dataDictLock.rdlock();
+  DcmDataDictionaryIndex *index = dataDictIndex;
+  dataDictLock.unlock();
+  return index;
+#elif defined(DCMDICT_LOAD_ACQUIRE)
+  return DCMDICT_LOAD_ACQUIRE(dataDictIndex);
+#else
+  return dataDictIndex;
+#endif
+}
+
+const DcmDictEntry *GlobalDcmDataDictionary::findEntry(const DcmTagKey &key, const char *privCreator)
+{
+  DcmDataDictionaryIndex *index = getDataDictIndex();
+  if (!index)
+  {
+    createDataDict();
+    index = getDataDictIndex();
+  }
+  return (index) ? index->findEntry(key, privCreator) : NULL;
+}
+
 const DcmDataDictionary& GlobalDcmDataDictionary::rdlock()
 {
 #ifdef WITH_THREADS
@@ -854,11 +1084,18 @@ DcmDataDictionary& GlobalDcmDataDictionary::wrlock()
     dataDictLock.wrlock();
 #endif
   }
+  dataDictWriteLocked = OFTrue;
   return *dataDict;
 }
 
 void GlobalDcmDataDictionary::unlock()
 {
+  /* the dictionary might have been modified, so create a new index */
+  if (dataDictWriteLocked)
+  {
+    dataDictWriteLocked = OFFalse;
+    updateDataDictIndex();
+  }
 #ifdef WITH_THREADS
   dataDictLock.unlock();
 #endif
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -35,6 +35,8 @@
 #include "dcmtk/dcmdata/dcobject.h"
 #include "dcmtk/dcmdata/dcswap.h"
 #include "dcmtk/dcmdata/dcistrma.h"    /* for class DcmInputStream */
+#include "dcmtk/dcmdata/dcistrmf.h"    /* for class DcmFileMapping */
+#include "dcmtk/dcmdata/dcarena.h"     /* for class DcmArena */
 #include "dcmtk/dcmdata/dcostrma.h"    /* for class DcmOutputStream */
 #include "dcmtk/dcmdata/dcfcache.h"    /* for class DcmFileCache */
 #include "dcmtk/dcmdata/dcwcache.h"    /* for class DcmWriteCache */
@@ -54,7 +56,9 @@ DcmElement::DcmElement(const DcmTag &tag,
   : DcmObject(tag, len),
     fByteOrder(gLocalByteOrder),
     fLoadValue(NULL),
-    fValue(NULL)
+    fValue(NULL),
+    fMapping(NULL),
+    fValueInArena(OFFalse)
 {
 }
 
@@ -63,7 +67,9 @@ DcmElement::DcmElement(const DcmElement &elem)
   : DcmObject(elem),
     fByteOrder(elem.fByteOrder),
     fLoadValue(NULL),
-    fValue(NULL)
+    fValue(NULL),
+    fMapping(NULL),
+    fValueInArena(OFFalse)
 {
     if (elem.fValue)
     {
@@ -135,16 +141,9 @@ DcmElement &DcmElement::operator=(const DcmElement &obj)
 {
   if (this != &obj)
   {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-    // if created with the nothrow version it must also be deleted with
-    // the nothrow version else memory error.
-    operator delete[] (fValue, std::nothrow);
-#else
-    delete[] fValue;
-#endif
+    deleteValueField();
     delete fLoadValue;
     fLoadValue = NULL;
-    fValue = NULL;
 
     DcmObject::operator=(obj);
     fByteOrder = obj.fByteOrder;
@@ -258,13 +257,7 @@ OFCondition DcmElement::copyFrom(const DcmObject& rhs)
 
 DcmElement::~DcmElement()
 {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-    // if created with the nothrow version it must also be deleted with
-    // the nothrow version else memory error.
-    operator delete[] (fValue, std::nothrow);
-#else
-    delete[] fValue;
-#endif
+    deleteValueField();
     delete fLoadValue;
 }
 
@@ -275,14 +268,7 @@ DcmElement::~DcmElement()
 OFCondition DcmElement::clear()
 {
     errorFlag = EC_Normal;
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-    // if created with the nothrow version it must also be deleted with
-    // the nothrow version else memory error.
-    operator delete[] (fValue, std::nothrow);
-#else
-    delete[] fValue;
-#endif
-    fValue = NULL;
+    deleteValueField();
     delete fLoadValue;
     fLoadValue = NULL;
     setLengthField(0);
@@ -344,7 +330,10 @@ OFBool DcmElement::canWriteXfer(const E_TransferSyntax newXfer,
 OFCondition DcmElement::detachValueField(OFBool copy)
 {
     OFCondition l_error = EC_Normal;
-    if (getLengthField() != 0)
+    /* a value that refers to a file mapping or an arena cannot be deleted by the caller */
+    if (fMapping || fValueInArena)
+        l_error = EC_IllegalCall;
+    else if (getLengthField() != 0)
     {
         if (copy)
         {
@@ -643,6 +632,16 @@ OFCondition DcmElement::loadValue(DcmInputStream *inStream)
             /* if we did not encounter the end of the stream and no error occurred so far, go ahead */
             else if (errorFlag.good())
             {
+                /* if the stream permits direct access to the data (i.e. a memory-mapped file), refer */
+                /* to the data instead of copying it. This is only done for binary values that */
+                /* have an even length and have not been read partially, since all other values */
+                /* require additional bytes (e.g. a terminating null byte for strings). */
+                if (!fValue && (getTransferredBytes() == 0) && !(getLengthField() & 1) && !getTag().getVR().isaString())
+                {
+                    fValue = readStream->readMapped(getLengthField(), getTag().getVR().getValueWidth(), fMapping);
+                    if (fValue)
+                        setTransferredBytes(getLengthField());
+                }
                 /* if the object which holds this element's value does not yet exist, create it */
                 if (!fValue)
                     fValue = newValueField(); /* also set errorFlag in case of error */
@@ -691,6 +690,35 @@ OFCondition DcmElement::loadValue(DcmInputStream *inStream)
 // ********************************
 
 
+void DcmElement::deleteValueField()
+{
+    if (fMapping)
+    {
+        /* the value refers to a memory-mapped file, so only release the mapping */
+        fMapping->decreaseRefCount();
+        fMapping = NULL;
+    }
+    else if (fValueInArena)
+    {
+        /* the value has been allocated from an arena */
+        DcmArena::deallocateValue(fValue);
+        fValueInArena = OFFalse;
+    } else {
+#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
+        // if created with the nothrow version it must also be deleted with
+        // the nothrow version else memory error.
+        operator delete[] (fValue, std::nothrow);
+#else
+        delete[] fValue;
+#endif
+    }
+    fValue = NULL;
+}
+
+
+// ********************************
+
+
 Uint8 *DcmElement::newValueField()
 {
     Uint8 * value;
@@ -710,22 +738,7 @@ Uint8 *DcmElement::newValueField()
               return NULL;
         }
         /* create an array of Length+1 bytes */
-#ifdef HAVE_STD__NOTHROW
-        // we want to use a non-throwing new here if available.
-        // If the allocation fails, we report an EC_MemoryExhausted error
-        // back to the caller.
-        value = new (std::nothrow) Uint8[lengthField + 1];    // protocol error: odd value length
-#else
-        /* make sure that the pointer is set to NULL in case of error */
-        try
-        {
-            value = new Uint8[lengthField + 1];    // protocol error: odd value length
-        }
-        catch (STD_NAMESPACE bad_alloc const &)
-        {
-            value = NULL;
-        }
-#endif
+        value = allocateValueField(lengthField + 1);    // protocol error: odd value length
         /* if creation was successful, set last byte to 0 (in order to initialize this byte) */
         /* (no value will be assigned to this byte later, since Length was odd) */
         if (value)
@@ -739,26 +752,39 @@ Uint8 *DcmElement::newValueField()
     }
     /* if this element's length is even, create a corresponding array of Length bytes */
     else
+        value = allocateValueField(lengthField);
+    /* if creation was not successful set member error flag correspondingly */
+    if (!value)
+        errorFlag = EC_MemoryExhausted;
+    /* return byte array */
+    return value;
+}
+
+
+Uint8 *DcmElement::allocateValueField(const Uint32 size)
+{
+    /* small value fields are allocated from the current arena (if any) */
+    Uint8 *value = OFstatic_cast(Uint8 *, DcmArena::allocateValue(size));
+    fValueInArena = (value != NULL);
+    if (!fValueInArena)
+    {
 #ifdef HAVE_STD__NOTHROW
         // we want to use a non-throwing new here if available.
         // If the allocation fails, we report an EC_MemoryExhausted error
         // back to the caller.
-        value = new (std::nothrow) Uint8[lengthField];
+        value = new (std::nothrow) Uint8[size];
 #else
         /* make sure that the pointer is set to NULL in case of error */
         try
         {
-            value = new Uint8[lengthField];
+            value = new Uint8[size];
         }
         catch (STD_NAMESPACE bad_alloc const &)
         {
             value = NULL;
         }
 #endif
-    /* if creation was not successful set member error flag correspondingly */
-    if (!value)
-        errorFlag = EC_MemoryExhausted;
-    /* return byte array */
+    }
     return value;
 }
 
@@ -831,13 +857,7 @@ OFCondition DcmElement::changeValue(const void *value,
                     memcpy(newValue, fValue, size_t(getLengthField()));
                     // copy value passed as a parameter to the end
                     memcpy(&newValue[getLengthField()], OFstatic_cast(const Uint8 *, value), size_t(num));
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-                    // if created with the nothrow version it must also be deleted with
-                    // the nothrow version else memory error.
-                    operator delete[] (fValue, std::nothrow);
-#else
-                    delete[] fValue;
-#endif
+                    deleteValueField();
                     fValue = newValue;
                     setLengthField(getLengthField() + num);
                 } else
@@ -998,17 +1018,7 @@ OFCondition DcmElement::putValue(const void * newValue,
 {
     errorFlag = EC_Normal;
 
-    if (fValue)
-    {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-        // if created with the nothrow version it must also be deleted with
-        // the nothrow version else memory error.
-        operator delete[] (fValue, std::nothrow);
-#else
-        delete[] fValue;
-#endif
-    }
-    fValue = NULL;
+    deleteValueField();
 
     if (fLoadValue)
         delete fLoadValue;
@@ -1061,17 +1071,7 @@ OFCondition DcmElement::createUint16Array(const Uint32 /*numWords*/,
 OFCondition DcmElement::createEmptyValue(const Uint32 length)
 {
     errorFlag = EC_Normal;
-    if (fValue)
-    {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-        // if created with the nothrow version it must also be deleted with
-        // the nothrow version else memory error.
-        operator delete[] (fValue, std::nothrow);
-#else
-        delete[] fValue;
-#endif
-    }
-    fValue = NULL;
+    deleteValueField();
     if (fLoadValue)
         delete fLoadValue;
     fLoadValue = NULL;
@@ -1177,13 +1177,7 @@ OFCondition DcmElement::read(DcmInputStream &inStream,
                     }
                 }
                 /* if there is already a value for this element, delete this value */
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-                // if created with the nothrow version it must also be deleted with
-                // the nothrow version else memory error.
-                operator delete[] (fValue, std::nothrow);
-#else
-                delete[] fValue;
-#endif
+                deleteValueField();
                 /* set the transfer state to ERW_inWork */
                 setTransferState(ERW_inWork);
             }
@@ -1335,7 +1329,11 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
                     /* write as many bytes as possible to the stream starting at value[getTransferredBytes()] */
                     /* (note that the bytes value[0] to value[getTransferredBytes()-1] have already been */
                     /* written to the stream) */
-                    len = OFstatic_cast(Uint32, outStream.write(&value[getTransferredBytes()], getLengthField() - getTransferredBytes()));
+                    /* (if the value stays in memory, the stream may keep a reference instead of a copy) */
+                    if (valueRemainsAfterWrite())
+                        len = OFstatic_cast(Uint32, outStream.writeReference(&value[getTransferredBytes()], getLengthField() - getTransferredBytes()));
+                    else
+                        len = OFstatic_cast(Uint32, outStream.write(&value[getTransferredBytes()], getLengthField() - getTransferredBytes()));
 
                     /* increase the amount of bytes which have been transfered correspondingly */
                     incTransferredBytes(len);
@@ -1788,14 +1786,25 @@ OFCondition DcmElement::getPartialValue(void *targetBuffer,
 }
 
 
+// ********************************
+
+
+OFBool DcmElement::valueRemainsAfterWrite() const
+{
+    return OFTrue;
+}
+
+
+// ********************************
+
+
 void DcmElement::compact()
 {
   if (fLoadValue && fValue)
   {
     DCMDATA_DEBUG("DcmElement::compact() removed element value of " << getTag()
         << " with " << getTransferredBytes() << " bytes");
-    delete[] fValue;
-    fValue = NULL;
+    deleteValueField();
     setTransferredBytes(0);
   }
 }
@@ -1807,14 +1816,7 @@ OFCondition DcmElement::createValueFromTempFile(DcmInputStreamFactory *factory,
 {
     if (factory && !(length & 1))
     {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-        // if created with the nothrow version it must also be deleted with
-        // the nothrow version else memory error.
-        operator delete[] (fValue, std::nothrow);
-#else
-        delete[] fValue;
-#endif
-        fValue = 0;
+        deleteValueField();
         delete fLoadValue;
         fLoadValue = factory;
         fByteOrder = byteOrder;
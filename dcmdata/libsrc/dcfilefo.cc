@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2013, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -638,7 +638,17 @@ OFCondition DcmFileFormat::read(DcmInputStream &inStream,
                                 const E_TransferSyntax xfer,
                                 const E_GrpLenEncoding glenc,
                                 const Uint32 maxReadLength)
+{
+    return DcmFileFormat::readUntilTag(inStream, xfer, glenc, maxReadLength, DCM_UndefinedTagKey);
+}
+
 
+OFCondition DcmFileFormat::readUntilTag(DcmInputStream &inStream,
+                                        const E_TransferSyntax xfer,
+                                        const E_GrpLenEncoding glenc,
+                                        const Uint32 maxReadLength,
+                                        const DcmTagKey &stopParsingAtElement,
+                                        const OFList<DcmTagKey> *tagFilter)
 {
     if (getTransferState() == ERW_notInitialized)
         errorFlag = EC_IllegalCall;
@@ -694,7 +704,8 @@ OFCondition DcmFileFormat::read(DcmInputStream &inStream,
                 {
                     if (dataset && dataset->transferState() != ERW_ready)
                     {
-                        errorFlag = dataset->read(inStream, newxfer, glenc, maxReadLength);
+                        errorFlag = dataset->readUntilTag(inStream, newxfer, glenc, maxReadLength,
+                            stopParsingAtElement, tagFilter);
                     }
                 }
             }
@@ -706,7 +717,7 @@ OFCondition DcmFileFormat::read(DcmInputStream &inStream,
             setTransferState(ERW_ready);
     }
     return errorFlag;
-}  // DcmFileFormat::read()
+}  // DcmFileFormat::readUntilTag()
 
 
 // ********************************
@@ -824,18 +835,37 @@ OFCondition DcmFileFormat::loadFile(const OFFilename &fileName,
                                     const E_GrpLenEncoding groupLength,
                                     const Uint32 maxReadLength,
                                     const E_FileReadMode readMode)
+{
+    return loadFileUntilTag(fileName, readXfer, groupLength, maxReadLength, readMode, DCM_UndefinedTagKey);
+}
+
+
+OFCondition DcmFileFormat::loadFileUntilTag(const OFFilename &fileName,
+                                            const E_TransferSyntax readXfer,
+                                            const E_GrpLenEncoding groupLength,
+                                            const Uint32 maxReadLength,
+                                            const E_FileReadMode readMode,
+                                            const DcmTagKey &stopParsingAtElement,
+                                            const OFList<DcmTagKey> *tagFilter)
 {
     if (readMode == ERM_dataset)
-        return getDataset()->loadFile(fileName, readXfer, groupLength, maxReadLength);
+    {
+        return getDataset()->loadFileUntilTag(fileName, readXfer, groupLength, maxReadLength,
+            stopParsingAtElement, tagFilter);
+    }
 
     OFCondition l_error = EC_InvalidFilename;
     /* check parameters first */
     if (!fileName.isEmpty())
     {
-        /* open file for input */
-        DcmInputFileStream fileStream(fileName);
+        /* open file for input (map file into memory if desired) */
+        DcmInputStream *fileStream;
+        if (dcmUseMemoryMappedFileInput.get())
+            fileStream = new DcmInputMappedFileStream(fileName);
+        else
+            fileStream = new DcmInputFileStream(fileName);
         /* check stream status */
-        l_error = fileStream.status();
+        l_error = fileStream->status();
         if (l_error.good())
         {
             /* clear this object */
@@ -847,12 +877,14 @@ OFCondition DcmFileFormat::loadFile(const OFFilename &fileName,
                 FileReadMode = readMode;
                 /* read data from file */
                 transferInit();
-                l_error = read(fileStream, readXfer, groupLength, maxReadLength);
+                l_error = readUntilTag(*fileStream, readXfer, groupLength, maxReadLength,
+                    stopParsingAtElement, tagFilter);
                 transferEnd();
                 /* restore old value */
                 FileReadMode = oldMode;
             }
         }
+        delete fileStream;
     }
     return l_error;
 }
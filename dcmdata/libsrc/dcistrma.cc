@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -73,6 +73,15 @@ offile_off_t DcmInputStream::skip(offile_off_t skiplen)
   return result;
 }
 
+Uint8 *DcmInputStream::readMapped(offile_off_t len, size_t alignment, DcmFileMapping *&mapping)
+{
+  // if a compression filter is installed, it is the current node of the
+  // filter chain and does not support direct access to the data
+  Uint8 *result = current_->readMapped(len, alignment, mapping);
+  if (result) tell_ += len;
+  return result;
+}
+
 offile_off_t DcmInputStream::tell() const
 {
   return tell_;
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2012, OFFIS e.V.
+ *  Copyright (C) 2002-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -26,8 +26,15 @@
 
 #define INCLUDE_CSTDIO
 #define INCLUDE_CERRNO
+#define INCLUDE_CSTRING
 #include "dcmtk/ofstd/ofstdinc.h"
 
+#ifdef HAVE_SYS_MMAN_H
+BEGIN_EXTERN_C
+#include <sys/mman.h>
+END_EXTERN_C
+#endif
+
 
 DcmFileProducer::DcmFileProducer(const OFFilename &filename, offile_off_t offset)
 : DcmProducer()
@@ -160,6 +167,7 @@ DcmInputFileStream::DcmInputFileStream(const OFFilename &filename, offile_off_t
 : DcmInputStream(&producer_) // safe because DcmInputStream only stores pointer
 , producer_(filename, offset)
 , filename_(filename)
+, offset_(offset)
 {
 }
 
@@ -173,7 +181,262 @@ DcmInputStreamFactory *DcmInputFileStream::newFactory() const
   if (currentProducer() == &producer_)
   {
     // no filter installed, can create factory object
-    result = new DcmInputFileStreamFactory(filename_, tell());
+    result = new DcmInputFileStreamFactory(filename_, offset_ + tell());
+  }
+  return result;
+}
+
+/* ======================================================================= */
+
+DcmFileMapping::DcmFileMapping(Uint8 *data, offile_off_t size)
+#ifdef WITH_THREADS
+: refCount_(1), mutex_(), data_(data), size_(size)
+#else
+: refCount_(1), data_(data), size_(size)
+#endif
+{
+}
+
+DcmFileMapping::~DcmFileMapping()
+{
+#ifdef HAVE_SYS_MMAN_H
+  if (data_) munmap(OFreinterpret_cast(char *, data_), OFstatic_cast(size_t, size_));
+#endif
+}
+
+DcmFileMapping *DcmFileMapping::newInstance(const OFFilename &filename, OFCondition &status)
+{
+  DcmFileMapping *result = NULL;
+#ifdef HAVE_SYS_MMAN_H
+  OFFile file;
+  if (file.fopen(filename, "rb"))
+  {
+    // determine number of bytes in file
+    file.fseek(0L, SEEK_END);
+    const offile_off_t size = file.ftell();
+    if ((size < 0) || (OFstatic_cast(Uint64, size) > OFstatic_cast(Uint64, OFstatic_cast(size_t, -1))))
+      status = makeOFCondition(OFM_dcmdata, 18, OF_error, "file too large to be mapped into memory");
+    else if (size == 0)
+    {
+      // mmap() does not permit mapping of empty files
+      result = new DcmFileMapping(NULL, 0);
+      status = EC_Normal;
+    }
+    else
+    {
+      // use a private mapping, so that values can be modified in memory
+      // (e.g. byte swapped) without ever changing the file itself
+      void *data = mmap(NULL, OFstatic_cast(size_t, size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file.fileNo(), 0);
+      if (data == MAP_FAILED)
+      {
+        char buf[256];
+        status = makeOFCondition(OFM_dcmdata, 18, OF_error, OFStandard::strerror(errno, buf, sizeof(buf)));
+      } else {
+        result = new DcmFileMapping(OFstatic_cast(Uint8 *, data), size);
+        status = EC_Normal;
+      }
+    }
+    // the mapping remains valid after the file has been closed
+    file.fclose();
+  }
+  else
+  {
+    OFString s("(unknown error code)");
+    file.getLastErrorString(s);
+    status = makeOFCondition(OFM_dcmdata, 18, OF_error, s.c_str());
+  }
+#else
+  (void) filename;
+  status = makeOFCondition(OFM_dcmdata, 18, OF_error, "memory-mapped files not supported on this system");
+#endif
+  return result;
+}
+
+void DcmFileMapping::increaseRefCount()
+{
+#ifdef WITH_THREADS
+  mutex_.lock();
+#endif
+  ++refCount_;
+#ifdef WITH_THREADS
+  mutex_.unlock();
+#endif
+}
+
+void DcmFileMapping::decreaseRefCount()
+{
+#ifdef WITH_THREADS
+  mutex_.lock();
+#endif
+  size_t result = --refCount_;
+#ifdef WITH_THREADS
+  mutex_.unlock();
+#endif
+  if (result == 0) delete this;
+}
+
+/* ======================================================================= */
+
+DcmMappedFileProducer::DcmMappedFileProducer(const OFFilename &filename, offile_off_t offset)
+: DcmProducer()
+, mapping_(NULL)
+, status_(EC_Normal)
+, pos_(0)
+{
+  mapping_ = DcmFileMapping::newInstance(filename, status_);
+  if (mapping_)
+  {
+    if (offset <= mapping_->size()) pos_ = offset;
+    else status_ = EC_InvalidStream;
+  }
+}
+
+DcmMappedFileProducer::DcmMappedFileProducer(DcmFileMapping *mapping, offile_off_t offset)
+: DcmProducer()
+, mapping_(mapping)
+, status_(EC_Normal)
+, pos_(0)
+{
+  if (mapping_)
+  {
+    mapping_->increaseRefCount();
+    if (offset <= mapping_->size()) pos_ = offset;
+    else status_ = EC_InvalidStream;
+  }
+  else status_ = EC_IllegalCall;
+}
+
+DcmMappedFileProducer::~DcmMappedFileProducer()
+{
+  if (mapping_) mapping_->decreaseRefCount();
+}
+
+OFBool DcmMappedFileProducer::good() const
+{
+  return status_.good();
+}
+
+OFCondition DcmMappedFileProducer::status() const
+{
+  return status_;
+}
+
+OFBool DcmMappedFileProducer::eos()
+{
+  if (mapping_) return (pos_ == mapping_->size()); else return OFTrue;
+}
+
+offile_off_t DcmMappedFileProducer::avail()
+{
+  if (mapping_) return mapping_->size() - pos_; else return 0;
+}
+
+offile_off_t DcmMappedFileProducer::read(void *buf, offile_off_t buflen)
+{
+  offile_off_t result = 0;
+  if (status_.good() && mapping_ && buf && buflen)
+  {
+    result = (mapping_->size() - pos_ < buflen) ? (mapping_->size() - pos_) : buflen;
+    memcpy(buf, mapping_->data() + pos_, OFstatic_cast(size_t, result));
+    pos_ += result;
+  }
+  return result;
+}
+
+offile_off_t DcmMappedFileProducer::skip(offile_off_t skiplen)
+{
+  offile_off_t result = 0;
+  if (status_.good() && mapping_ && skiplen)
+  {
+    result = (mapping_->size() - pos_ < skiplen) ? (mapping_->size() - pos_) : skiplen;
+    pos_ += result;
+  }
+  return result;
+}
+
+void DcmMappedFileProducer::putback(offile_off_t num)
+{
+  if (status_.good() && mapping_ && num)
+  {
+    if (num <= pos_) pos_ -= num;
+    else status_ = EC_PutbackFailed; // tried to putback before start of file
+  }
+}
+
+Uint8 *DcmMappedFileProducer::readMapped(offile_off_t len, size_t alignment, DcmFileMapping *&mapping)
+{
+  Uint8 *result = NULL;
+  if (status_.good() && mapping_ && (len > 0) && (mapping_->size() - pos_ >= len))
+  {
+    result = mapping_->data() + pos_;
+    // the caller might access the data as an array of 16, 32 or 64 bit values
+    if ((alignment > 1) && (OFreinterpret_cast(size_t, result) % alignment != 0))
+      result = NULL;
+    else
+    {
+      mapping_->increaseRefCount();
+      mapping = mapping_;
+      pos_ += len;
+    }
+  }
+  return result;
+}
+
+/* ======================================================================= */
+
+DcmInputMappedFileStreamFactory::DcmInputMappedFileStreamFactory(DcmFileMapping *mapping, offile_off_t offset)
+: DcmInputStreamFactory()
+, mapping_(mapping)
+, offset_(offset)
+{
+  mapping_->increaseRefCount();
+}
+
+DcmInputMappedFileStreamFactory::DcmInputMappedFileStreamFactory(const DcmInputMappedFileStreamFactory& arg)
+: DcmInputStreamFactory(arg)
+, mapping_(arg.mapping_)
+, offset_(arg.offset_)
+{
+  mapping_->increaseRefCount();
+}
+
+DcmInputMappedFileStreamFactory::~DcmInputMappedFileStreamFactory()
+{
+  mapping_->decreaseRefCount();
+}
+
+DcmInputStream *DcmInputMappedFileStreamFactory::create() const
+{
+  return new DcmInputMappedFileStream(mapping_, offset_);
+}
+
+/* ======================================================================= */
+
+DcmInputMappedFileStream::DcmInputMappedFileStream(const OFFilename &filename, offile_off_t offset)
+: DcmInputStream(&producer_) // safe because DcmInputStream only stores pointer
+, producer_(filename, offset)
+, offset_(offset)
+{
+}
+
+DcmInputMappedFileStream::DcmInputMappedFileStream(DcmFileMapping *mapping, offile_off_t offset)
+: DcmInputStream(&producer_) // safe because DcmInputStream only stores pointer
+, producer_(mapping, offset)
+, offset_(offset)
+{
+}
+
+DcmInputMappedFileStream::~DcmInputMappedFileStream()
+{
+}
+
+DcmInputStreamFactory *DcmInputMappedFileStream::newFactory() const
+{
+  DcmInputStreamFactory *result = NULL;
+  if ((currentProducer() == &producer_) && producer_.mapping())
+  {
+    // no filter installed, can create factory object
+    result = new DcmInputMappedFileStreamFactory(producer_.mapping(), offset_ + tell());
   }
   return result;
 }
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2015, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -1236,6 +1236,36 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
                           const E_TransferSyntax xfer,
                           const E_GrpLenEncoding glenc,
                           const Uint32 maxReadLength)
+{
+    return DcmItem::readUntilTag(inStream, xfer, glenc, maxReadLength, DCM_UndefinedTagKey);
+}
+
+
+// ********************************
+
+
+/* check whether the given tag is contained in the tag filter (if any) */
+static OFBool isTagInFilter(const OFList<DcmTagKey> *tagFilter,
+                            const DcmTagKey &tag)
+{
+    if (tagFilter == NULL)
+        return OFTrue;
+    OFListConstIterator(DcmTagKey) last = tagFilter->end();
+    for (OFListConstIterator(DcmTagKey) it = tagFilter->begin(); it != last; ++it)
+    {
+        if (*it == tag)
+            return OFTrue;
+    }
+    return OFFalse;
+}
+
+
+OFCondition DcmItem::readUntilTag(DcmInputStream & inStream,
+                                  const E_TransferSyntax xfer,
+                                  const E_GrpLenEncoding glenc,
+                                  const Uint32 maxReadLength,
+                                  const DcmTagKey &stopParsingAtElement,
+                                  const OFList<DcmTagKey> *tagFilter)
 {
     /* check if this is an illegal call; if so set the error flag and do nothing, else go ahead */
     if (getTransferState() == ERW_notInitialized)
@@ -1260,12 +1290,15 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
             setTransferState(ERW_inWork);
         }
         DcmTag newTag; OFBool readStopElem = OFFalse;
+        /* the stop tag and the tag filter are only evaluated on dataset level */
+        const OFBool isDataset = (ident() == EVR_dataset);
         /* start a loop in order to read all elements (attributes) which are contained in the inStream */
         while (inStream.good() && (getTransferredBytes() < getLengthField() || !lastElementComplete) && !readStopElem)
         {
             /* initialize variables */
             Uint32 newValueLength = 0;
             Uint32 bytes_tagAndLen = 0;
+            OFBool skippedElem = OFFalse;
             /* if the reading of the last element was complete, go ahead and read the next element */
             if (lastElementComplete)
             {
@@ -1306,19 +1339,40 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
                     /* while loop will be terminated.) */
                     if (errorFlag.bad())
                         break;
-                    /* If we get to this point, we just started reading the first part */
-                    /* of an element; hence, lastElementComplete is not longer true */
-                    lastElementComplete = OFFalse;
-                    /* in case of implicit VR, check whether the "default VR" is really appropriate */
-                    if (DcmXfer(xfer).isImplicitVR())
-                        checkAndUpdateVR(*this, newTag);
-                    /* read the actual data value which belongs to this element */
-                    /* (attribute) and insert this information into the elementList */
-                    errorFlag = readSubElement(inStream, newTag, newValueLength, xfer, glenc, maxReadLength);
-                    /* if reading was successful, we read the entire data value information */
-                    /* for this element; hence lastElementComplete is true again */
-                    if (errorFlag.good())
-                        lastElementComplete = OFTrue;
+                    /* if desired, stop parsing before the given element (tag and length are put back) */
+                    if (isDataset && (stopParsingAtElement != DCM_UndefinedTagKey) &&
+                        (newTag.getXTag() >= stopParsingAtElement))
+                    {
+                        DCMDATA_DEBUG("DcmItem::readUntilTag() element " << newTag
+                            << " encountered, skipping rest of dataset");
+                        inStream.putback();
+                        readStopElem = OFTrue;
+                        break;
+                    }
+                    /* skip the value of elements that are not contained in the tag filter */
+                    /* (only possible if the value length is known and the value is available) */
+                    if (isDataset && !isTagInFilter(tagFilter, newTag) &&
+                        (newValueLength != DCM_UndefinedLength) && (inStream.avail() >= OFstatic_cast(offile_off_t, newValueLength)))
+                    {
+                        DCMDATA_TRACE("DcmItem::readUntilTag() skipping element " << newTag
+                            << " with length " << newValueLength << " (not in tag filter)");
+                        inStream.skip(newValueLength);
+                        skippedElem = OFTrue;
+                    } else {
+                        /* If we get to this point, we just started reading the first part */
+                        /* of an element; hence, lastElementComplete is not longer true */
+                        lastElementComplete = OFFalse;
+                        /* in case of implicit VR, check whether the "default VR" is really appropriate */
+                        if (DcmXfer(xfer).isImplicitVR())
+                            checkAndUpdateVR(*this, newTag);
+                        /* read the actual data value which belongs to this element */
+                        /* (attribute) and insert this information into the elementList */
+                        errorFlag = readSubElement(inStream, newTag, newValueLength, xfer, glenc, maxReadLength);
+                        /* if reading was successful, we read the entire data value information */
+                        /* for this element; hence lastElementComplete is true again */
+                        if (errorFlag.good())
+                            lastElementComplete = OFTrue;
+                    }
                 }
             } else
             {
@@ -1337,7 +1391,7 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
             if (errorFlag.good())
             {
                 // If we completed one element, update the private tag cache.
-                if (lastElementComplete)
+                if (lastElementComplete && !skippedElem)
                 {
                     privateCreatorCache.updateCache(elementList->get());
                     // evaluate option for skipping rest of dataset
@@ -1349,6 +1403,13 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
                             << " encountered, skipping rest of dataset");
                         readStopElem = OFTrue;
                     }
+                    // remove elements that are not contained in the tag filter but could not be skipped
+                    if (isDataset && !isTagInFilter(tagFilter, elementList->get()->getTag()))
+                    {
+                        DCMDATA_TRACE("DcmItem::readUntilTag() removing element " << elementList->get()->getTag()
+                            << " (not in tag filter)");
+                        delete elementList->remove();
+                    }
                 }
             } else
                 break; // if some error was encountered terminate the while-loop
@@ -1388,7 +1449,7 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
         setTransferState(ERW_ready);
 
     /* dump information if required */
-    DCMDATA_TRACE("DcmItem::read() returns error = " << errorFlag.text());
+    DCMDATA_TRACE("DcmItem::readUntilTag() returns error = " << errorFlag.text());
 
     /* return result value */
     return errorFlag;
@@ -1640,58 +1701,71 @@ OFCondition DcmItem::insert(DcmElement *elem,
     /* do something only if the pointer which was passed does not equal NULL */
     if (elem != NULL)
     {
-        DcmElement *dE;
-        E_ListPos seekmode = ELP_last;
-        /* iterate through elementList (from the last element to the first) */
-        do {
-            /* get current element from elementList */
-            dE = OFstatic_cast(DcmElement *, elementList->seek(seekmode));
-            /* if there is no element, i.e. elementList is empty */
-            if (dE == NULL)
+        /* determine the position of the new element in the (sorted) elementList */
+        unsigned long pos = 0;
+        DcmObject *dE = findInElementList(elem->getTag(), pos);
+        /* if there is no element with the same tag, insert the new element */
+        if (dE == NULL)
+        {
+            /* either before the element with the next greater tag or at the end of the list */
+            if (pos < elementList->card())
             {
-                /* insert new element at the beginning of elementList */
-                elementList->insert(elem, ELP_first);
+                elementList->seek_to(pos);
+                elementList->insert(elem, ELP_prev);
                 if (checkInsertOrder)
                 {
-                    // check if we have inserted at the end of the list
-                    if (elem != OFstatic_cast(DcmElement *, elementList->seek(ELP_last)))
-                    {
-                        // produce diagnostics
-                        DCMDATA_WARN("DcmItem: Dataset not in ascending tag order, at element " << elem->getTag());
-                    }
+                    // we have not inserted at the end of the list, produce diagnostics
+                    DCMDATA_WARN("DcmItem: Dataset not in ascending tag order, at element " << elem->getTag());
                 }
-                /* dump some information if required */
+            } else
+                elementList->append(elem);
+            /* dump some information if required */
+            if (pos == 0)
+            {
                 DCMDATA_TRACE("DcmItem::insert() Element " << elem->getTag()
                     << " VR=\"" << DcmVR(elem->getVR()).getVRName() << "\" inserted at beginning");
-                /* check whether the new element already has a parent */
-                if (elem->getParent() != NULL)
-                {
-                    DCMDATA_DEBUG("DcmItem::insert() Element " << elem->getTag() << " already has a parent: "
-                      << elem->getParent()->getTag() << " VR=" << DcmVR(elem->getParent()->getVR()).getVRName());
-                }
-                /* remember the parent (i.e. the surrounding item/dataset) */
-                elem->setParent(this);
-                /* terminate do-while-loop */
-                break;
+            } else {
+                DCMDATA_TRACE("DcmItem::insert() Element " << elem->getTag()
+                    << " VR=\"" << DcmVR(elem->getVR()).getVRName() << "\" inserted");
             }
-            /* else if the new element's tag is greater than the current element's tag */
-            /* (i.e. we have found the position where the new element shall be inserted) */
-            else if (elem->getTag() > dE->getTag())
+            /* check whether the new element already has a parent */
+            if (elem->getParent() != NULL)
             {
-                /* insert the new element after the current element */
-                elementList->insert(elem, ELP_next);
-                if (checkInsertOrder)
+                DCMDATA_DEBUG("DcmItem::insert() Element " << elem->getTag() << " already has a parent: "
+                    << elem->getParent()->getTag() << " VR=" << DcmVR(elem->getParent()->getVR()).getVRName());
+            }
+            /* remember the parent (i.e. the surrounding item/dataset) */
+            elem->setParent(this);
+        }
+        /* else if new and current element (showing the same tag) are not identical */
+        else if (elem != dE)
+        {
+            /* if the current (old) element shall be replaced */
+            if (replaceOld)
+            {
+                /* remove current element from list */
+                DcmObject *remObj = elementList->remove();
+
+                /* now the following holds: remObj == dE and elementList */
+                /* points to the element after the former current element. */
+
+                /* if the pointer to the removed object does not */
+                /* equal NULL (the usual case), delete this object */
+                /* and dump some information if required */
+                if (remObj != NULL)
                 {
-                    // check if we have inserted at the end of the list
-                    if (elem != OFstatic_cast(DcmElement *, elementList->seek(ELP_last)))
-                    {
-                        // produce diagnostics
-                        DCMDATA_WARN("DcmItem: Dataset not in ascending tag order, at element " << elem->getTag());
-                    }
+                    /* dump some information if required */
+                    DCMDATA_TRACE("DcmItem::insert() Element " << remObj->getTag()
+                        << " VR=\"" << DcmVR(remObj->getVR()).getVRName()
+                        << "\" p=" << OFstatic_cast(void *, remObj) << " removed and deleted");
+                    delete remObj;
                 }
+                /* insert the new element before the current element */
+                elementList->insert(elem, ELP_prev);
                 /* dump some information if required */
                 DCMDATA_TRACE("DcmItem::insert() Element " << elem->getTag()
-                    << " VR=\"" << DcmVR(elem->getVR()).getVRName() << "\" inserted");
+                    << " VR=\"" << DcmVR(elem->getVR()).getVRName()
+                    << "\" p=" << OFstatic_cast(void *, elem) << " replaced older one");
                 /* check whether the new element already has a parent */
                 if (elem->getParent() != NULL)
                 {
@@ -1700,68 +1774,19 @@ OFCondition DcmItem::insert(DcmElement *elem,
                 }
                 /* remember the parent (i.e. the surrounding item/dataset) */
                 elem->setParent(this);
-                /* terminate do-while-loop */
-                break;
-            }
-            /* else if the current element and the new element show the same tag */
-            else if (elem->getTag() == dE->getTag())
-            {
-                /* if new and current element are not identical */
-                if (elem != dE)
-                {
-                    /* if the current (old) element shall be replaced */
-                    if (replaceOld)
-                    {
-                        /* remove current element from list */
-                        DcmObject *remObj = elementList->remove();
-
-                        /* now the following holds: remObj == dE and elementList */
-                        /* points to the element after the former current element. */
-
-                        /* if the pointer to the removed object does not */
-                        /* equal NULL (the usual case), delete this object */
-                        /* and dump some information if required */
-                        if (remObj != NULL)
-                        {
-                            /* dump some information if required */
-                            DCMDATA_TRACE("DcmItem::insert() Element " << remObj->getTag()
-                                << " VR=\"" << DcmVR(remObj->getVR()).getVRName()
-                                << "\" p=" << OFstatic_cast(void *, remObj) << " removed and deleted");
-                            delete remObj;
-                        }
-                        /* insert the new element before the current element */
-                        elementList->insert(elem, ELP_prev);
-                        /* dump some information if required */
-                        DCMDATA_TRACE("DcmItem::insert() Element " << elem->getTag()
-                            << " VR=\"" << DcmVR(elem->getVR()).getVRName()
-                            << "\" p=" << OFstatic_cast(void *, elem) << " replaced older one");
-                        /* check whether the new element already has a parent */
-                        if (elem->getParent() != NULL)
-                        {
-                            DCMDATA_DEBUG("DcmItem::insert() Element " << elem->getTag() << " already has a parent: "
-                                << elem->getParent()->getTag() << " VR=" << DcmVR(elem->getParent()->getVR()).getVRName());
-                        }
-                        /* remember the parent (i.e. the surrounding item/dataset) */
-                        elem->setParent(this);
-                    }   // if (replaceOld)
-                    /* or else, i.e. the current element shall not be replaced by the new element */
-                    else {
-                        /* set the error flag correspondingly; we do not */
-                        /* allow two elements with the same tag in elementList */
-                        errorFlag = EC_DoubledTag;
-                    }   // if (!replaceOld)
-                }   // if (elem != dE)
-                /* if the new and the current element are identical, the caller tries to insert */
-                /* one element twice. Most probably an application error. */
-                else {
-                    errorFlag = EC_DoubledTag;
-                }
-                /* terminate do-while-loop */
-                break;
-            }
-            /* set the seek mode to "get the previous element" */
-            seekmode = ELP_prev;
-        } while (dE);
+            }   // if (replaceOld)
+            /* or else, i.e. the current element shall not be replaced by the new element */
+            else {
+                /* set the error flag correspondingly; we do not */
+                /* allow two elements with the same tag in elementList */
+                errorFlag = EC_DoubledTag;
+            }   // if (!replaceOld)
+        }   // if (elem != dE)
+        /* if the new and the current element are identical, the caller tries to insert */
+        /* one element twice. Most probably an application error. */
+        else {
+            errorFlag = EC_DoubledTag;
+        }
     }
     /* if the pointer which was passed equals NULL, this is an illegal call */
     else
@@ -1774,6 +1799,45 @@ OFCondition DcmItem::insert(DcmElement *elem,
 // ********************************
 
 
+DcmObject *DcmItem::findInElementList(const DcmTagKey &tag,
+                                      unsigned long &position)
+{
+    DcmObject *dO = NULL;
+    unsigned long first = 0;
+    unsigned long last = elementList->card();
+    /* check the last element first, since elements are usually appended in */
+    /* ascending order (e.g. while parsing a dataset) */
+    if (last > 0)
+    {
+        dO = elementList->seek(ELP_last);
+        if (dO->getTag() < tag)
+            first = last;
+        else if (dO->getTag() == tag)
+            first = last - 1;
+    }
+    /* binary search for the first element whose tag is not less than the given one; */
+    /* this works because the elementList is always kept in ascending tag order */
+    while (first < last)
+    {
+        const unsigned long middle = first + (last - first) / 2;
+        dO = elementList->seek_to(middle);
+        if (dO->getTag() < tag)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    position = first;
+    /* make the element found the current one (if any) */
+    dO = elementList->seek_to(first);
+    if ((dO != NULL) && (dO->getTag() == tag))
+        return dO;
+    return NULL;
+}
+
+
+// ********************************
+
+
 DcmElement *DcmItem::getElement(const unsigned long num)
 {
     errorFlag = EC_Normal;
@@ -1797,11 +1861,16 @@ DcmObject *DcmItem::nextInContainer(const DcmObject *obj)
     {
         if (elementList->get() != obj)
         {
-            for(DcmObject * search_obj = elementList->seek(ELP_first);
-                search_obj && search_obj != obj;
-                search_obj = elementList->seek(ELP_next)
-               ) {
-                /* do nothing, just keep iterating */
+            unsigned long pos = 0;
+            /* elements are sorted, so we can search for the tag of the given object */
+            if (findInElementList(obj->getTag(), pos) != obj)
+            {
+                for(DcmObject * search_obj = elementList->seek(ELP_first);
+                    search_obj && search_obj != obj;
+                    search_obj = elementList->seek(ELP_next)
+                   ) {
+                    /* do nothing, just keep iterating */
+                }
             }
         }
         return elementList->seek(ELP_next);
@@ -1877,18 +1946,13 @@ DcmElement *DcmItem::remove(DcmObject *elem)
     errorFlag = EC_IllegalCall;
     if (!elementList->empty() && elem != NULL)
     {
-        DcmObject *dO;
-        elementList->seek(ELP_first);
-        do {
-            dO = elementList->get();
-            if (dO == elem)
-            {
-                elementList->remove();     // removes element from list but does not delete it
-                elem->setParent(NULL);     // forget about the parent
-                errorFlag = EC_Normal;
-                break;
-            }
-        } while (elementList->seek(ELP_next));
+        unsigned long pos = 0;
+        if (findInElementList(elem->getTag(), pos) == elem)
+        {
+            elementList->remove();     // removes element from list but does not delete it
+            elem->setParent(NULL);     // forget about the parent
+            errorFlag = EC_Normal;
+        }
     }
     if (errorFlag == EC_IllegalCall)
         return NULL;
@@ -1906,17 +1970,14 @@ DcmElement *DcmItem::remove(const DcmTagKey &tag)
     DcmObject *dO = NULL;
     if (!elementList->empty())
     {
-        elementList->seek(ELP_first);
-        do {
-            dO = elementList->get();
-            if (dO->getTag() == tag)
-            {
-                elementList->remove();     // removes element from list but does not delete it
-                dO->setParent(NULL);       // forget about the parent
-                errorFlag = EC_Normal;
-                break;
-            }
-        } while (elementList->seek(ELP_next));
+        unsigned long pos = 0;
+        dO = findInElementList(tag, pos);
+        if (dO != NULL)
+        {
+            elementList->remove();     // removes element from list but does not delete it
+            dO->setParent(NULL);       // forget about the parent
+            errorFlag = EC_Normal;
+        }
     }
 
     if (errorFlag == EC_TagNotFound)
@@ -1986,11 +2047,11 @@ OFCondition DcmItem::searchSubFromHere(const DcmTagKey &tag,
     OFCondition l_error = EC_TagNotFound;
     if (!elementList->empty())
     {
-        elementList->seek(ELP_first);
-        do {
-            dO = elementList->get();
-            if (searchIntoSub)
-            {
+        if (searchIntoSub)
+        {
+            elementList->seek(ELP_first);
+            do {
+                dO = elementList->get();
                 resultStack.push(dO);
                 if (dO->getTag() == tag)
                     l_error = EC_Normal;
@@ -1998,14 +2059,17 @@ OFCondition DcmItem::searchSubFromHere(const DcmTagKey &tag,
                     l_error = dO->search(tag, resultStack, ESM_fromStackTop, OFTrue);
                 if (l_error.bad())
                     resultStack.pop();
-            } else {
-                if (dO->getTag() == tag)
-                {
-                    resultStack.push(dO);
-                    l_error = EC_Normal;
-                }
+            } while (l_error.bad() && elementList->seek(ELP_next));
+        } else {
+            /* no deep search, so use binary search on the sorted element list */
+            unsigned long pos = 0;
+            dO = findInElementList(tag, pos);
+            if (dO != NULL)
+            {
+                resultStack.push(dO);
+                l_error = EC_Normal;
             }
-        } while (l_error.bad() && elementList->seek(ELP_next));
+        }
         if (l_error==EC_Normal && dO->getTag()==tag)
         {
             DCMDATA_TRACE("DcmItem::searchSubFromHere() Element " << tag << " found");
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -23,6 +23,7 @@
 
 #include "dcmtk/ofstd/ofstream.h"
 #include "dcmtk/dcmdata/dclist.h"
+#include "dcmtk/dcmdata/dcarena.h"
 
 
 // *****************************************
@@ -46,6 +47,32 @@ DcmListNode::~DcmListNode()
 }
 
 
+void *DcmListNode::operator new(size_t size)
+{
+    return DcmArena::allocateObject(size);
+}
+
+
+void DcmListNode::operator delete(void *ptr)
+{
+    DcmArena::deallocateObject(ptr);
+}
+
+
+#ifdef HAVE_STD__NOTHROW
+void *DcmListNode::operator new(size_t size, const std::nothrow_t &) throw()
+{
+    return DcmArena::allocateObject(size, OFTrue /* noThrow */);
+}
+
+
+void DcmListNode::operator delete(void *ptr, const std::nothrow_t &) throw()
+{
+    DcmArena::deallocateObject(ptr);
+}
+#endif
+
+
 // *****************************************
 // *** DcmList *****************************
 // *****************************************
@@ -55,7 +82,9 @@ DcmList::DcmList()
   : firstNode(NULL),
     lastNode(NULL),
     currentNode(NULL),
-    cardinality(0)
+    cardinality(0),
+    currentPosition(DCM_EndOfListIndex),
+    nodeIndex()
 {
 }
 
@@ -82,6 +111,17 @@ DcmList::~DcmList()
 // ********************************
 
 
+// helper function returning the position index for the given (new) current node
+
+static inline unsigned long positionAfterMove(const DcmListNode *node, const unsigned long pos)
+{
+    return (node != NULL) ? pos : DCM_EndOfListIndex;
+}
+
+
+// ********************************
+
+
 DcmObject *DcmList::append( DcmObject *obj )
 {
     if ( obj != NULL )
@@ -95,7 +135,8 @@ DcmObject *DcmList::append( DcmObject *obj )
             node->prevNode = lastNode;
             currentNode = lastNode = node;
         }
-        cardinality++;
+        nodeIndex.push_back(currentNode);
+        currentPosition = cardinality++;
     } // obj == NULL
     return obj;
 }
@@ -117,6 +158,8 @@ DcmObject *DcmList::prepend( DcmObject *obj )
             firstNode->prevNode = node;
             currentNode = firstNode = node;
         }
+        nodeIndex.insert(nodeIndex.begin(), currentNode);
+        currentPosition = 0;
         cardinality++;
     } // obj == NULL
     return obj;
@@ -133,6 +176,8 @@ DcmObject *DcmList::insert( DcmObject *obj, E_ListPos pos )
         if ( DcmList::empty() )                 // list is empty !
         {
             currentNode = firstNode = lastNode = new DcmListNode(obj);
+            nodeIndex.push_back(currentNode);
+            currentPosition = 0;
             cardinality++;
         }
         else {
@@ -155,6 +200,8 @@ DcmObject *DcmList::insert( DcmObject *obj, E_ListPos pos )
                 node->nextNode = currentNode;
                 currentNode->prevNode = node;
                 currentNode = node;
+                // new node takes over the position of the former current node
+                nodeIndex.insert(nodeIndex.begin() + currentPosition, node);
                 cardinality++;
             }
             else //( pos==ELP_next || pos==ELP_atpos )
@@ -169,6 +216,7 @@ DcmObject *DcmList::insert( DcmObject *obj, E_ListPos pos )
                 node->prevNode = currentNode;
                 currentNode->nextNode = node;
                 currentNode = node;
+                nodeIndex.insert(nodeIndex.begin() + (++currentPosition), node);
                 cardinality++;
             }
         }
@@ -204,6 +252,9 @@ DcmObject *DcmList::remove()
             currentNode->nextNode->prevNode = currentNode->prevNode;
 
         currentNode = currentNode->nextNode;
+        // successor (if any) moves up to the position of the removed node
+        nodeIndex.erase(nodeIndex.begin() + currentPosition);
+        currentPosition = positionAfterMove(currentNode, currentPosition);
         tempobj = tempnode->value();
         delete tempnode;
         cardinality--;
@@ -230,17 +281,25 @@ DcmObject *DcmList::seek( E_ListPos pos )
     {
         case ELP_first :
             currentNode = firstNode;
+            currentPosition = positionAfterMove(currentNode, 0);
             break;
         case ELP_last :
             currentNode = lastNode;
+            currentPosition = positionAfterMove(currentNode, cardinality - 1);
             break;
         case ELP_prev :
             if ( DcmList::valid() )
+            {
                 currentNode = currentNode->prevNode;
+                currentPosition = positionAfterMove(currentNode, currentPosition - 1);
+            }
             break;
         case ELP_next :
             if ( DcmList::valid() )
+            {
                 currentNode = currentNode->nextNode;
+                currentPosition = positionAfterMove(currentNode, currentPosition + 1);
+            }
             break;
         default:
             break;
@@ -254,10 +313,15 @@ DcmObject *DcmList::seek( E_ListPos pos )
 
 DcmObject *DcmList::seek_to(unsigned long absolute_position)
 {
-    const unsigned long tmppos = absolute_position < cardinality ? absolute_position : cardinality;
-    seek( ELP_first );
-    for (unsigned long i = 0; i < tmppos; i++)
-        seek( ELP_next );
+    // use the node index for constant time access
+    if ( absolute_position < cardinality )
+    {
+        currentNode = nodeIndex[absolute_position];
+        currentPosition = absolute_position;
+    } else {
+        currentNode = NULL;
+        currentPosition = DCM_EndOfListIndex;
+    }
     return get( ELP_atpos );
 }
 
@@ -292,4 +356,6 @@ void DcmList::deleteAllElements()
     lastNode = NULL;
     currentNode = NULL;
     cardinality = 0;
+    currentPosition = DCM_EndOfListIndex;
+    nodeIndex.clear();
 }
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -33,6 +33,7 @@
 #include "dcmtk/dcmdata/dcswap.h"
 #include "dcmtk/dcmdata/dcistrma.h"    /* for class DcmInputStream */
 #include "dcmtk/dcmdata/dcostrma.h"    /* for class DcmOutputStream */
+#include "dcmtk/dcmdata/dcarena.h"     /* for class DcmArena */
 
 #define INCLUDE_CSTDIO
 #define INCLUDE_IOMANIP
@@ -55,6 +56,9 @@ OFGlobal<DcmTagKey> dcmStopParsingAfterElement(DCM_UndefinedTagKey); // (0xffff,
 OFGlobal<OFBool>    dcmWriteOversizedSeqsAndItemsUndefined(OFTrue);
 OFGlobal<OFBool>    dcmIgnoreFileMetaInformationGroupLength(OFFalse);
 OFGlobal<OFBool>    dcmReplaceWrongDelimitationItem(OFFalse);
+OFGlobal<OFBool>    dcmUseMemoryMappedFileInput(OFFalse);
+OFGlobal<OFBool>    dcmUseArenaAllocation(OFFalse);
+OFGlobal<OFBool>    dcmLazySequenceParsing(OFFalse);
 
 
 // ****** public methods **********************************
@@ -88,6 +92,32 @@ DcmObject::~DcmObject()
 }
 
 
+void *DcmObject::operator new(size_t size)
+{
+    return DcmArena::allocateObject(size);
+}
+
+
+void DcmObject::operator delete(void *ptr)
+{
+    DcmArena::deallocateObject(ptr);
+}
+
+
+#ifdef HAVE_STD__NOTHROW
+void *DcmObject::operator new(size_t size, const std::nothrow_t &) throw()
+{
+    return DcmArena::allocateObject(size, OFTrue /* noThrow */);
+}
+
+
+void DcmObject::operator delete(void *ptr, const std::nothrow_t &) throw()
+{
+    DcmArena::deallocateObject(ptr);
+}
+#endif
+
+
 DcmObject &DcmObject::operator=(const DcmObject &obj)
 {
     if (this != &obj)
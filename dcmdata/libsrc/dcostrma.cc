@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -92,6 +92,13 @@ offile_off_t DcmOutputStream::write(const void *buf, offile_off_t buflen)
   return result;
 }
 
+offile_off_t DcmOutputStream::writeReference(const void *buf, offile_off_t buflen)
+{
+  offile_off_t result = current_->writeReference(buf, buflen);
+  tell_ += result;
+  return result;
+}
+
 void DcmOutputStream::flush()
 {
   current_->flush();
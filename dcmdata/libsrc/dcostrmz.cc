@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2010, OFFIS e.V.
+ *  Copyright (C) 2002-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -26,8 +26,22 @@
 #include "dcmtk/dcmdata/dcostrmz.h"
 #include "dcmtk/dcmdata/dcerror.h"
 
+#ifdef WITH_THREADS
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofvector.h"
+#endif
+
 #define DCMZLIBOUTPUTFILTER_BUFSIZE 4096
 
+/* size of the blocks that are compressed concurrently */
+#define DCMZLIBOUTPUTFILTER_BLOCKSIZE 131072
+
+/* size of the dictionary taken from the end of the preceding input,
+ * i.e. the size of the deflate window
+ */
+#define DCMZLIBOUTPUTFILTER_DICTSIZE 32768
+
 /* taken from zutil.h */
 #if MAX_MEM_LEVEL >= 8
 #define DEF_MEM_LEVEL 8
@@ -36,6 +50,7 @@
 #endif
 
 OFGlobal<int> dcmZlibCompressionLevel(Z_DEFAULT_COMPRESSION);
+OFGlobal<Uint32> dcmZlibCompressionThreads(1);
 
 // helper method to fix old-style casts warnings
 BEGIN_EXTERN_C
@@ -55,9 +70,531 @@ static int OFdeflateInit(z_stream* const stream, int level)
 }
 END_EXTERN_C
 
+
+#ifdef WITH_THREADS
+
+/** a block of uncompressed data and its compressed form, which is
+ *  compressed independently of all other blocks by one of the threads
+ *  of DcmZLibParallelCompressor
+ */
+class DcmZLibCompressionBlock
+{
+public:
+
+  /** constructor
+   *  @param outputSize size of the output buffer, in bytes
+   */
+  DcmZLibCompressionBlock(size_t outputSize)
+  : input_(new unsigned char[DCMZLIBOUTPUTFILTER_BLOCKSIZE])
+  , inputCount_(0)
+  , dictionary_(new unsigned char[DCMZLIBOUTPUTFILTER_DICTSIZE])
+  , dictionaryCount_(0)
+  , output_(new unsigned char[outputSize])
+  , outputSize_(outputSize)
+  , outputStart_(0)
+  , outputCount_(0)
+  , last_(OFFalse)
+  , queued_(OFFalse)
+  , finished_(OFFalse)
+  , status_(EC_Normal)
+  , done_(0)
+  {
+  }
+
+  /// destructor
+  ~DcmZLibCompressionBlock()
+  {
+    delete[] input_;
+    delete[] dictionary_;
+    delete[] output_;
+  }
+
+  /// uncompressed data
+  unsigned char *input_;
+
+  /// number of bytes in the input buffer
+  size_t inputCount_;
+
+  /// copy of the last bytes of the input preceding this block
+  unsigned char *dictionary_;
+
+  /// number of bytes in the dictionary, 0 for the first block
+  size_t dictionaryCount_;
+
+  /// compressed data
+  unsigned char *output_;
+
+  /// size of the output buffer
+  size_t outputSize_;
+
+  /// offset of the first compressed byte not yet written to the consumer
+  size_t outputStart_;
+
+  /// number of compressed bytes in the output buffer
+  size_t outputCount_;
+
+  /// true if this block is the end of the input stream
+  OFBool last_;
+
+  /// true if this block has been handed over to the threads and not yet written
+  OFBool queued_;
+
+  /// true if the calling thread knows that the block has been compressed
+  OFBool finished_;
+
+  /// result of the compression
+  OFCondition status_;
+
+  /// posted by the compressing thread when the block is complete
+  OFSemaphore done_;
+
+private:
+
+  /// private undefined copy constructor
+  DcmZLibCompressionBlock(const DcmZLibCompressionBlock&);
+
+  /// private undefined copy assignment operator
+  DcmZLibCompressionBlock& operator=(const DcmZLibCompressionBlock&);
+};
+
+
+class DcmZLibParallelCompressor;
+
+/** thread compressing blocks that are fetched from a DcmZLibParallelCompressor
+ */
+class DcmZLibCompressionThread: public OFThread
+{
+public:
+
+  /** constructor
+   *  @param compressor compressor from which the blocks are fetched
+   *  @param level zlib compression level
+   */
+  DcmZLibCompressionThread(DcmZLibParallelCompressor& compressor, int level);
+
+  /// destructor
+  virtual ~DcmZLibCompressionThread();
+
+  /** returns the status of the zlib object after initialization
+   *  @return status, EC_Normal if good
+   */
+  OFCondition status() const { return status_; }
+
+  /** returns the maximum size of a compressed block
+   *  @return maximum number of bytes
+   */
+  size_t maxCompressedSize();
+
+  /** compresses the given block
+   *  @param block block to be compressed
+   */
+  void compress(DcmZLibCompressionBlock& block);
+
+protected:
+
+  /// compresses blocks until the compressor is shut down
+  virtual void run();
+
+private:
+
+  /// private undefined copy constructor
+  DcmZLibCompressionThread(const DcmZLibCompressionThread&);
+
+  /// private undefined copy assignment operator
+  DcmZLibCompressionThread& operator=(const DcmZLibCompressionThread&);
+
+  /// compressor from which the blocks are fetched
+  DcmZLibParallelCompressor& compressor_;
+
+  /// zlib status of this thread
+  z_stream zstream_;
+
+  /// status of the zlib initialization
+  OFCondition status_;
+};
+
+
+/** multi-threaded (block-split) deflate compressor.  The data is split into
+ *  blocks that are compressed concurrently.  All blocks but the last one are
+ *  terminated with a sync flush, which aligns the compressed data to a byte
+ *  boundary, so that the concatenation of all blocks forms a single deflate
+ *  bitstream.  The compressed blocks are written to the consumer in their
+ *  original order.
+ */
+class DcmZLibParallelCompressor
+{
+public:
+
+  /** constructor.  Starts the compressing threads.
+   *  @param numberOfThreads number of threads, should be larger than 1
+   *  @param level zlib compression level
+   */
+  DcmZLibParallelCompressor(Uint32 numberOfThreads, int level);
+
+  /// destructor.  Stops the compressing threads.
+  ~DcmZLibParallelCompressor();
+
+  /** returns the status of the compressor
+   *  @return status, EC_Normal if good
+   */
+  OFCondition status() const { return status_; }
+
+  /** returns true if the end of the stream has been compressed and written
+   *  @return true if flushed, false otherwise
+   */
+  OFBool isFlushed() const { return finalSubmitted_ && (queuedCount_ == 0); }
+
+  /** returns the number of bytes that can be written with the next call to write()
+   *  @return number of bytes, 0 in case of I/O suspension
+   */
+  offile_off_t avail() const;
+
+  /** processes as many bytes as possible from the given input block
+   *  @param consumer consumer to which the compressed data is written
+   *  @param buf pointer to memory block
+   *  @param buflen length of memory block
+   *  @return number of bytes actually processed
+   */
+  offile_off_t write(DcmConsumer& consumer, const void *buf, offile_off_t buflen);
+
+  /** compresses the remaining data and writes all compressed blocks
+   *  until complete or until I/O suspension occurs
+   *  @param consumer consumer to which the compressed data is written
+   */
+  void flush(DcmConsumer& consumer);
+
+  /** waits for the next block to be compressed.  Called by the compressing threads.
+   *  @return pointer to the next block, NULL if the thread should terminate
+   */
+  DcmZLibCompressionBlock *fetchBlock();
+
+private:
+
+  /// private undefined copy constructor
+  DcmZLibParallelCompressor(const DcmZLibParallelCompressor&);
+
+  /// private undefined copy assignment operator
+  DcmZLibParallelCompressor& operator=(const DcmZLibParallelCompressor&);
+
+  /** hands the block that is currently filled over to the compressing threads
+   *  @param last true if the block constitutes the end of the input stream
+   */
+  void submitBlock(OFBool last);
+
+  /** writes the oldest queued block to the consumer
+   *  @param consumer consumer to which the compressed data is written
+   *  @param wait if true, wait until the block has been compressed
+   *  @return true if the block has been written completely, false otherwise
+   */
+  OFBool flushBlock(DcmConsumer& consumer, OFBool wait);
+
+  /** writes queued blocks until the block to be filled next is available
+   *  @param consumer consumer to which the compressed data is written
+   */
+  void makeRoom(DcmConsumer& consumer);
+
+  /// compressing threads
+  OFVector<DcmZLibCompressionThread *> threads_;
+
+  /// ring of blocks
+  OFVector<DcmZLibCompressionBlock *> blocks_;
+
+  /// index of the block that is currently filled
+  size_t fillIndex_;
+
+  /// index of the oldest queued block
+  size_t flushIndex_;
+
+  /// number of queued blocks
+  size_t queuedCount_;
+
+  /// copy of the last bytes of the input submitted so far, i.e.\ the
+  /// preset dictionary for the next block
+  unsigned char *history_;
+
+  /// number of bytes in history_, 0 before the first block is submitted
+  size_t historyCount_;
+
+  /// true if the last block has been submitted
+  OFBool finalSubmitted_;
+
+  /// status
+  OFCondition status_;
+
+  /// blocks to be compressed by the threads, NULL entries terminate a thread
+  OFList<DcmZLibCompressionBlock *> queue_;
+
+  /// mutex protecting queue_
+  OFMutex queueMutex_;
+
+  /// counts the entries in queue_
+  OFSemaphore queueSemaphore_;
+};
+
+
+DcmZLibCompressionThread::DcmZLibCompressionThread(DcmZLibParallelCompressor& compressor, int level)
+: OFThread()
+, compressor_(compressor)
+, zstream_()
+, status_(EC_Normal)
+{
+  zstream_.zalloc = Z_NULL;
+  zstream_.zfree = Z_NULL;
+  zstream_.opaque = Z_NULL;
+  if (Z_OK != OFdeflateInit(&zstream_, level))
+  {
+    OFString etext = "ZLib Error: ";
+    if (zstream_.msg) etext += zstream_.msg;
+    status_ = makeOFCondition(OFM_dcmdata, 16, OF_error, etext.c_str());
+  }
+}
+
+DcmZLibCompressionThread::~DcmZLibCompressionThread()
+{
+  if (status_.good()) deflateEnd(&zstream_);
+}
+
+size_t DcmZLibCompressionThread::maxCompressedSize()
+{
+  // a sync flush adds an empty stored block of 4 bytes plus up to 3 bytes of
+  // pending bits, which deflateBound() does not account for
+  return OFstatic_cast(size_t, deflateBound(&zstream_, DCMZLIBOUTPUTFILTER_BLOCKSIZE)) + 16;
+}
+
+void DcmZLibCompressionThread::compress(DcmZLibCompressionBlock& block)
+{
+  int zstatus = deflateReset(&zstream_);
+  if ((zstatus == Z_OK) && block.dictionaryCount_)
+    zstatus = deflateSetDictionary(&zstream_, block.dictionary_, OFstatic_cast(uInt, block.dictionaryCount_));
+  if (zstatus == Z_OK)
+  {
+    zstream_.next_in = block.input_;
+    zstream_.avail_in = OFstatic_cast(uInt, block.inputCount_);
+    zstream_.next_out = block.output_;
+    zstream_.avail_out = OFstatic_cast(uInt, block.outputSize_);
+    zstatus = deflate(&zstream_, block.last_ ? Z_FINISH : Z_SYNC_FLUSH);
+    // the output buffer is large enough to take the complete block
+    if (block.last_ ? (zstatus == Z_STREAM_END) : ((zstatus == Z_OK) && (zstream_.avail_in == 0) && (zstream_.avail_out > 0)))
+      zstatus = Z_OK;
+    else if (zstatus == Z_OK)
+      zstatus = Z_BUF_ERROR;
+  }
+  if (zstatus == Z_OK)
+  {
+    block.outputCount_ = block.outputSize_ - zstream_.avail_out;
+    block.status_ = EC_Normal;
+  }
+  else
+  {
+    OFString etext = "ZLib Error: ";
+    if (zstream_.msg) etext += zstream_.msg; else etext += "block compression failed";
+    block.status_ = makeOFCondition(OFM_dcmdata, 16, OF_error, etext.c_str());
+  }
+}
+
+void DcmZLibCompressionThread::run()
+{
+  DcmZLibCompressionBlock *block;
+  while ((block = compressor_.fetchBlock()) != NULL)
+  {
+    compress(*block);
+    block->done_.post();
+  }
+}
+
+
+DcmZLibParallelCompressor::DcmZLibParallelCompressor(Uint32 numberOfThreads, int level)
+: threads_()
+, blocks_()
+, fillIndex_(0)
+, flushIndex_(0)
+, queuedCount_(0)
+, history_(new unsigned char[DCMZLIBOUTPUTFILTER_DICTSIZE])
+, historyCount_(0)
+, finalSubmitted_(OFFalse)
+, status_(EC_Normal)
+, queue_()
+, queueMutex_()
+, queueSemaphore_(0)
+{
+  for (Uint32 i = 0; (i < numberOfThreads) && status_.good(); ++i)
+  {
+    DcmZLibCompressionThread *thread = new DcmZLibCompressionThread(*this, level);
+    status_ = thread->status();
+    if (status_.good() && (thread->start() != 0))
+      status_ = makeOFCondition(OFM_dcmdata, 16, OF_error, "ZLib Error: unable to create compression thread");
+    if (status_.good())
+      threads_.push_back(thread);
+    else
+      delete thread;
+  }
+  if (status_.good())
+  {
+    // two blocks per thread, so that the threads are kept busy while
+    // the calling thread writes the compressed data
+    const size_t outputSize = threads_[0]->maxCompressedSize();
+    for (size_t i = 0; i < 2 * threads_.size(); ++i)
+      blocks_.push_back(new DcmZLibCompressionBlock(outputSize));
+  }
+}
+
+DcmZLibParallelCompressor::~DcmZLibParallelCompressor()
+{
+  // the threads compress all queued blocks before they terminate
+  size_t i;
+  queueMutex_.lock();
+  for (i = 0; i < threads_.size(); ++i)
+    queue_.push_back(NULL);
+  queueMutex_.unlock();
+  for (i = 0; i < threads_.size(); ++i)
+    queueSemaphore_.post();
+  for (i = 0; i < threads_.size(); ++i)
+  {
+    threads_[i]->join();
+    delete threads_[i];
+  }
+  for (i = 0; i < blocks_.size(); ++i)
+    delete blocks_[i];
+  delete[] history_;
+}
+
+DcmZLibCompressionBlock *DcmZLibParallelCompressor::fetchBlock()
+{
+  queueSemaphore_.wait();
+  queueMutex_.lock();
+  DcmZLibCompressionBlock *block = queue_.front();
+  queue_.pop_front();
+  queueMutex_.unlock();
+  return block;
+}
+
+offile_off_t DcmZLibParallelCompressor::avail() const
+{
+  if (status_.bad() || finalSubmitted_ || blocks_[fillIndex_]->queued_) return 0;
+  return DCMZLIBOUTPUTFILTER_BLOCKSIZE - OFstatic_cast(offile_off_t, blocks_[fillIndex_]->inputCount_);
+}
+
+void DcmZLibParallelCompressor::submitBlock(OFBool last)
+{
+  DcmZLibCompressionBlock *block = blocks_[fillIndex_];
+  // the preceding block may already have been written (and its input
+  // discarded), so the dictionary is taken from our own copy of the input
+  memcpy(block->dictionary_, history_, historyCount_);
+  block->dictionaryCount_ = historyCount_;
+
+  // keep the last bytes of the input, including those of earlier blocks
+  // if this block is shorter than the dictionary
+  if (block->inputCount_ >= DCMZLIBOUTPUTFILTER_DICTSIZE)
+  {
+    memcpy(history_, block->input_ + block->inputCount_ - DCMZLIBOUTPUTFILTER_DICTSIZE, DCMZLIBOUTPUTFILTER_DICTSIZE);
+    historyCount_ = DCMZLIBOUTPUTFILTER_DICTSIZE;
+  }
+  else if (block->inputCount_ > 0)
+  {
+    size_t keep = DCMZLIBOUTPUTFILTER_DICTSIZE - block->inputCount_;
+    if (keep > historyCount_) keep = historyCount_;
+    memmove(history_, history_ + historyCount_ - keep, keep);
+    memcpy(history_ + keep, block->input_, block->inputCount_);
+    historyCount_ = keep + block->inputCount_;
+  }
+
+  block->last_ = last;
+  block->queued_ = OFTrue;
+  block->finished_ = OFFalse;
+  finalSubmitted_ = last;
+  ++queuedCount_;
+  fillIndex_ = (fillIndex_ + 1) % blocks_.size();
+
+  queueMutex_.lock();
+  queue_.push_back(block);
+  queueMutex_.unlock();
+  queueSemaphore_.post();
+}
+
+OFBool DcmZLibParallelCompressor::flushBlock(DcmConsumer& consumer, OFBool wait)
+{
+  DcmZLibCompressionBlock *block = blocks_[flushIndex_];
+  if (! block->finished_)
+  {
+    if (wait)
+      block->done_.wait();
+    else if (block->done_.trywait() != 0)
+      return OFFalse;
+    block->finished_ = OFTrue;
+    if (block->status_.bad())
+    {
+      status_ = block->status_;
+      return OFFalse;
+    }
+  }
+  while (block->outputStart_ < block->outputCount_)
+  {
+    offile_off_t written = consumer.write(block->output_ + block->outputStart_,
+      OFstatic_cast(offile_off_t, block->outputCount_ - block->outputStart_));
+    if (written <= 0) return OFFalse; // I/O suspension
+    block->outputStart_ += OFstatic_cast(size_t, written);
+  }
+  block->inputCount_ = 0;
+  block->outputStart_ = 0;
+  block->outputCount_ = 0;
+  block->queued_ = OFFalse;
+  flushIndex_ = (flushIndex_ + 1) % blocks_.size();
+  --queuedCount_;
+  return OFTrue;
+}
+
+void DcmZLibParallelCompressor::makeRoom(DcmConsumer& consumer)
+{
+  // write all blocks that are already complete, then wait for the
+  // oldest block if the next block to be filled is still in use
+  while (status_.good() && queuedCount_ && flushBlock(consumer, OFFalse)) /* nothing */;
+  while (status_.good() && blocks_[fillIndex_]->queued_ && flushBlock(consumer, OFTrue)) /* nothing */;
+}
+
+offile_off_t DcmZLibParallelCompressor::write(DcmConsumer& consumer, const void *buf, offile_off_t buflen)
+{
+  if (status_.bad() || finalSubmitted_) return 0;
+  makeRoom(consumer);
+
+  const unsigned char *data = OFstatic_cast(const unsigned char *, buf);
+  offile_off_t result = 0;
+  while (status_.good() && (result < buflen) && ! blocks_[fillIndex_]->queued_)
+  {
+    DcmZLibCompressionBlock *block = blocks_[fillIndex_];
+    size_t count = DCMZLIBOUTPUTFILTER_BLOCKSIZE - block->inputCount_;
+    if (OFstatic_cast(offile_off_t, count) > buflen - result) count = OFstatic_cast(size_t, buflen - result);
+    memcpy(block->input_ + block->inputCount_, data + result, count);
+    block->inputCount_ += count;
+    result += OFstatic_cast(offile_off_t, count);
+    if (block->inputCount_ == DCMZLIBOUTPUTFILTER_BLOCKSIZE)
+    {
+      submitBlock(OFFalse);
+      makeRoom(consumer);
+    }
+  }
+  return result;
+}
+
+void DcmZLibParallelCompressor::flush(DcmConsumer& consumer)
+{
+  if (status_.bad()) return;
+  if (! finalSubmitted_)
+  {
+    makeRoom(consumer);
+    if (status_.bad() || blocks_[fillIndex_]->queued_) return;
+    // the last block might be empty, it still terminates the deflate bitstream
+    submitBlock(OFTrue);
+  }
+  while (status_.good() && queuedCount_ && flushBlock(consumer, OFTrue)) /* nothing */;
+}
+
+#endif /* WITH_THREADS */
+
+
 DcmZLibOutputFilter::DcmZLibOutputFilter()
 : DcmOutputFilter()
 , current_(NULL)
+, parallel_(NULL)
 , zstream_(new z_stream)
 , status_(EC_MemoryExhausted)
 , flushed_(OFFalse)
@@ -82,10 +619,21 @@ DcmZLibOutputFilter::DcmZLibOutputFilter()
       status_ = makeOFCondition(OFM_dcmdata, 16, OF_error, etext.c_str());
     }
   }
+#if defined(WITH_THREADS) && !defined(ZLIB_ENCODE_RFC1950_HEADER)
+  // the block-split compression cannot create the zlib header and checksum
+  if (status_.good() && (dcmZlibCompressionThreads.get() > 1))
+  {
+    parallel_ = new DcmZLibParallelCompressor(dcmZlibCompressionThreads.get(), dcmZlibCompressionLevel.get());
+    status_ = parallel_->status();
+  }
+#endif
 }
 
 DcmZLibOutputFilter::~DcmZLibOutputFilter()
 {
+#ifdef WITH_THREADS
+  delete parallel_;
+#endif
   if (zstream_)
   {
     deflateEnd(zstream_); // discards any unprocessed input and does not flush any pending output
@@ -109,12 +657,18 @@ OFCondition DcmZLibOutputFilter::status() const
 OFBool DcmZLibOutputFilter::isFlushed() const
 {
   if (status_.bad() || (current_ == NULL)) return OFTrue;
+#ifdef WITH_THREADS
+  if (parallel_) return parallel_->isFlushed() && current_->isFlushed();
+#endif
   return (inputBufCount_ == 0) && (outputBufCount_ == 0) && flushed_ && current_->isFlushed();
 }
 
 
 offile_off_t DcmZLibOutputFilter::avail() const
 {
+#ifdef WITH_THREADS
+  if (parallel_) return parallel_->avail();
+#endif
   // compute number of bytes available in input buffer
   if (status_.good() ) return DCMZLIBOUTPUTFILTER_BUFSIZE - inputBufCount_;
     else return 0;
@@ -283,6 +837,15 @@ offile_off_t DcmZLibOutputFilter::write(const void *buf, offile_off_t buflen)
 {
   if (status_.bad() || (current_ == NULL)) return 0;
 
+#ifdef WITH_THREADS
+  if (parallel_)
+  {
+    offile_off_t result = parallel_->write(*current_, buf, buflen);
+    status_ = parallel_->status();
+    return result;
+  }
+#endif
+
   // flush output buffer if necessary
   if (outputBufCount_ == DCMZLIBOUTPUTFILTER_BUFSIZE) flushOutputBuffer();
 
@@ -316,6 +879,15 @@ offile_off_t DcmZLibOutputFilter::write(const void *buf, offile_off_t buflen)
 
 void DcmZLibOutputFilter::flush()
 {
+#ifdef WITH_THREADS
+  if (parallel_ && status_.good() && current_)
+  {
+    parallel_->flush(*current_);
+    status_ = parallel_->status();
+    return;
+  }
+#endif
+
   if (status_.good() && current_)
   {
     // flush output buffer first
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2010, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -1091,7 +1091,14 @@ OFCondition DcmPixelData::getUncompressedFrame(
     }
     else
     {
-      // we only have a compressed version of the pixel data.
+      // we only have a compressed version of the pixel data. If the caller does not
+      // know the first fragment of the frame, make sure that the frame index of the pixel
+      // sequence exists, so that the codec can look it up without reading all fragments.
+      // The file cache avoids opening the file for each fragment not loaded into memory.
+      // Errors are reported by the codec.
+      if ((startFragment == 0) && (frameNo > 0))
+        (*original)->pixSeq->buildFrameIndex(OFstatic_cast(Uint32, numberOfFrames), cache);
+
       // Identify a codec for decompressing the frame.
       result = DcmCodecList::decodeFrame(
         (*original)->repType, (*original)->repParam, (*original)->pixSeq,
@@ -1101,6 +1108,63 @@ OFCondition DcmPixelData::getUncompressedFrame(
 }
 
 
+OFCondition DcmPixelData::getUncompressedFrames(
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    void *buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel,
+    DcmFileCache *cache)
+{
+    if ((dataset == NULL) || (buffer == NULL) || (numberOfFrames == 0)) return EC_IllegalCall;
+
+    Sint32 imageFrames = 1;
+    dataset->findAndGetSint32(DCM_NumberOfFrames, imageFrames); // don't fail if absent
+    if (imageFrames < 1) imageFrames = 1;
+
+    Uint32 frameSize;
+    OFCondition result = getUncompressedFrameSize(dataset, frameSize);
+    if (result.bad()) return result;
+
+    // each frame is stored in a slot of even size (see getUncompressedFrame())
+    Uint32 slotSize = frameSize;
+    if (slotSize & 1) ++slotSize;
+
+    // check frame range and buffer size
+    if ((firstFrame >= OFstatic_cast(Uint32, imageFrames)) ||
+        (numberOfFrames > OFstatic_cast(Uint32, imageFrames) - firstFrame)) return EC_IllegalCall;
+    if ((slotSize == 0) || (bufSize / slotSize < numberOfFrames)) return EC_IllegalCall;
+
+    if (existUnencapsulated)
+    {
+      // we already have an uncompressed version of the pixel data
+      // either in memory or in file, so copy one frame after the other.
+      Uint8 *frameBuffer = OFstatic_cast(Uint8 *, buffer);
+      for (Uint32 i = 0; (i < numberOfFrames) && result.good(); i++)
+      {
+        result = getPartialValue(frameBuffer, (firstFrame + i) * frameSize, frameSize, cache);
+        frameBuffer += slotSize;
+      }
+      if (result.good()) result = dataset->findAndGetOFString(DCM_PhotometricInterpretation, decompressedColorModel);
+    }
+    else
+    {
+      // we only have a compressed version of the pixel data. Build the frame index
+      // of the pixel sequence if necessary (see getUncompressedFrame()).
+      if ((startFragment == 0) && (firstFrame + numberOfFrames > 1))
+        (*original)->pixSeq->buildFrameIndex(OFstatic_cast(Uint32, imageFrames), cache);
+
+      // Identify a codec for decompressing the frames.
+      result = DcmCodecList::decodeFrames(
+        (*original)->repType, (*original)->repParam, (*original)->pixSeq,
+        dataset, firstFrame, numberOfFrames, startFragment, buffer, slotSize, decompressedColorModel);
+    }
+    return result;
+}
+
+
 OFCondition DcmPixelData::getDecompressedColorModel(
     DcmItem *dataset,
     OFString &decompressedColorModel)
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2013, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -43,7 +43,9 @@
 DcmPixelSequence::DcmPixelSequence(const DcmTag &tag,
                                    const Uint32 len)
   : DcmSequenceOfItems(tag, len),
-    Xfer(EXS_Unknown)
+    Xfer(EXS_Unknown),
+    FrameIndex(),
+    FrameIndexFragments(0)
 {
     setTagVR(EVR_OB);
     setLengthField(DCM_UndefinedLength); // pixel sequences always use undefined length
@@ -52,7 +54,9 @@ DcmPixelSequence::DcmPixelSequence(const DcmTag &tag,
 
 DcmPixelSequence::DcmPixelSequence(const DcmPixelSequence &old)
   : DcmSequenceOfItems(old),
-    Xfer(old.Xfer)
+    Xfer(old.Xfer),
+    FrameIndex(old.FrameIndex),
+    FrameIndexFragments(old.FrameIndexFragments)
 {
     /* everything gets handled in DcmSequenceOfItems constructor */
 }
@@ -69,6 +73,8 @@ DcmPixelSequence &DcmPixelSequence::operator=(const DcmPixelSequence &obj)
   {
     DcmSequenceOfItems::operator=(obj);
     Xfer = obj.Xfer;
+    FrameIndex = obj.FrameIndex;
+    FrameIndexFragments = obj.FrameIndexFragments;
   }
   return *this;
 }
@@ -231,6 +237,7 @@ OFCondition DcmPixelSequence::insert(DcmPixelItem *item,
     errorFlag = EC_Normal;
     if (item != NULL)
     {
+        FrameIndex.clear();
         itemList->seek_to(where);
         itemList->insert(item);
         if (where < itemList->card())
@@ -275,6 +282,7 @@ OFCondition DcmPixelSequence::remove(DcmPixelItem *&item,
     item = OFstatic_cast(DcmPixelItem*, itemList->seek_to(num));  // read item from list
     if (item != NULL)
     {
+        FrameIndex.clear();
         itemList->remove();
         item->setParent(NULL);          // forget about the parent
     } else
@@ -297,6 +305,7 @@ OFCondition DcmPixelSequence::remove(DcmPixelItem *item)
             dO = itemList->get();
             if (dO == item)
             {
+                FrameIndex.clear();
                 itemList->remove();         // remove element from list, but do no delete it
                 item->setParent(NULL);      // forget about the parent
                 errorFlag = EC_Normal;
@@ -343,6 +352,7 @@ OFCondition DcmPixelSequence::read(DcmInputStream &inStream,
                                    const Uint32 maxReadLength)
 {
     OFCondition l_error = changeXfer(ixfer);
+    FrameIndex.clear();
     if (l_error.good())
         return DcmSequenceOfItems::read(inStream, ixfer, glenc, maxReadLength);
 
@@ -429,3 +439,198 @@ OFCondition DcmPixelSequence::storeCompressedFrame(DcmOffsetList &offsetList,
     offsetList.push_back(currentSize);
     return result;
 }
+
+
+// ********************************
+
+
+OFCondition DcmPixelSequence::indexFramesFromOffsetTable(const Uint32 numberOfFrames,
+                                                         OFVector<Uint32> &index)
+{
+    DcmPixelItem *pixItem = NULL;
+    Uint8 *offsetTable = NULL;
+    OFCondition result = getItem(pixItem, 0);
+    if (result.good())
+        result = pixItem->getUint8Array(offsetTable);
+    if (result.bad())
+        return result;
+    // the offset table must have 4 bytes for each frame (not fragment!)
+    if ((offsetTable == NULL) || (pixItem->getLength() != 4 * numberOfFrames))
+        return EC_InvalidBasicOffsetTable;
+
+    const Uint32 numberOfFragments = OFstatic_cast(Uint32, card());
+    Uint32 frameNo = 0;
+    Uint32 counter = 0;
+    for (Uint32 idx = 1; (idx < numberOfFragments) && (frameNo < numberOfFrames); ++idx)
+    {
+        // the offset table is always stored in little endian byte order. It is not
+        // swapped in place since the frames might be decoded by other threads later on.
+        const Uint8 *entry = offsetTable + 4 * frameNo;
+        const Uint32 offset = OFstatic_cast(Uint32, entry[0]) | (OFstatic_cast(Uint32, entry[1]) << 8) |
+            (OFstatic_cast(Uint32, entry[2]) << 16) | (OFstatic_cast(Uint32, entry[3]) << 24);
+        if (counter == offset)
+            index[frameNo++] = idx;
+        else if (counter > offset)
+            return EC_InvalidBasicOffsetTable; // no fragment corresponds to this offset
+
+        // add pixel item length (padded to even) plus 8 bytes for the item tag and length field
+        result = getItem(pixItem, idx);
+        if (result.bad())
+            return result;
+        const Uint32 length = pixItem->getLength();
+        counter += length + (length & 1) + 8;
+    }
+    if (frameNo < numberOfFrames)
+        return EC_InvalidBasicOffsetTable;
+    return EC_Normal;
+}
+
+
+// ********************************
+
+
+OFCondition DcmPixelSequence::indexFramesFromCodestreams(const Uint32 numberOfFrames,
+                                                         DcmFileCache *cache,
+                                                         OFVector<Uint32> &index)
+{
+    const Uint32 numberOfFragments = OFstatic_cast(Uint32, card());
+    DcmPixelItem *pixItem = NULL;
+    Uint8 header[4];
+    Uint32 frameNo = 0;
+    for (Uint32 idx = 1; idx < numberOfFragments; ++idx)
+    {
+        OFCondition result = getItem(pixItem, idx);
+        if (result.bad())
+            return result;
+        OFBool isStart = OFFalse;
+        if (pixItem->getLength() >= sizeof(header))
+        {
+            // only read the first bytes, the fragment might not be loaded into memory yet
+            result = pixItem->getPartialValue(header, 0, sizeof(header), cache);
+            if (result.bad())
+                return result;
+            // a JPEG or JPEG-LS codestream starts with the SOI marker followed by another
+            // marker, a JPEG 2000 codestream starts with the SOC marker followed by SIZ.
+            // This is only a heuristic: JPEG entropy coded data never contains these
+            // markers, but JPEG 2000 packet data only excludes 0xFF90..0xFFFF, so a
+            // fragment boundary within a codestream may look like the start of a new one.
+            isStart = (header[0] == 0xFF) && (header[2] == 0xFF) &&
+                ((header[1] == 0xD8) || ((header[1] == 0x4F) && (header[3] == 0x51)));
+        }
+        if (isStart)
+        {
+            // there must not be more frames than expected
+            if (frameNo == numberOfFrames)
+                return EC_InvalidBasicOffsetTable;
+            index[frameNo++] = idx;
+        }
+        else if (idx == 1)
+        {
+            // the first fragment always starts a frame
+            return EC_InvalidBasicOffsetTable;
+        }
+    }
+    if (frameNo < numberOfFrames)
+        return EC_InvalidBasicOffsetTable;
+    return EC_Normal;
+}
+
+
+// ********************************
+
+
+OFCondition DcmPixelSequence::buildFrameIndex(const Uint32 numberOfFrames,
+                                              DcmFileCache *cache)
+{
+    const unsigned long numberOfFragments = card();
+    if ((numberOfFrames == 0) || (numberOfFragments <= numberOfFrames))
+        return EC_IllegalCall;
+    // the index is still valid if the fragments have not changed
+    if ((FrameIndex.size() == numberOfFrames + 1) && (FrameIndexFragments == numberOfFragments))
+        return EC_Normal;
+
+    OFVector<Uint32> index(numberOfFrames + 1);
+    index[numberOfFrames] = OFstatic_cast(Uint32, numberOfFragments);
+    OFCondition result = EC_Normal;
+    if (numberOfFragments == numberOfFrames + 1)
+    {
+        // standard case: there is one fragment per frame
+        for (Uint32 i = 0; i < numberOfFrames; ++i)
+            index[i] = i + 1;
+    } else {
+        // non-standard case: multiple fragments per frame. Consult the offset table
+        // first and look for the start of each codestream if that fails.
+        result = indexFramesFromOffsetTable(numberOfFrames, index);
+        if (result.bad())
+        {
+            DCMDATA_DEBUG("DcmPixelSequence: cannot use basic offset table (" << result.text()
+                << "), checking " << (numberOfFragments - 1) << " fragments for the start of each frame");
+            result = indexFramesFromCodestreams(numberOfFrames, cache, index);
+        }
+    }
+    if (result.good())
+    {
+        DCMDATA_TRACE("DcmPixelSequence: built frame index for " << numberOfFrames << " frames in "
+            << (numberOfFragments - 1) << " fragments");
+        FrameIndex.swap(index);
+        FrameIndexFragments = numberOfFragments;
+    }
+    return result;
+}
+
+
+// ********************************
+
+
+OFCondition DcmPixelSequence::getFrameFragments(const Uint32 frameNo,
+                                                const Uint32 numberOfFrames,
+                                                Uint32 &startFragment,
+                                                Uint32 &endFragment,
+                                                DcmFileCache *cache)
+{
+    if (frameNo >= numberOfFrames)
+        return EC_IllegalCall;
+    OFCondition result = buildFrameIndex(numberOfFrames, cache);
+    if (result.good())
+    {
+        startFragment = FrameIndex[frameNo];
+        endFragment = FrameIndex[frameNo + 1];
+    }
+    return result;
+}
+
+
+// ********************************
+
+
+OFCondition DcmPixelSequence::storeFrameIndex(const Uint32 numberOfFrames,
+                                              DcmFileCache *cache)
+{
+    OFCondition result = buildFrameIndex(numberOfFrames, cache);
+    if (result.bad())
+        return result;
+
+    // the offset table contains the offset of the first fragment of each frame,
+    // but createOffsetTable() expects the size of each frame
+    DcmOffsetList frameSizes;
+    DcmPixelItem *pixItem = NULL;
+    for (Uint32 frameNo = 0; (frameNo < numberOfFrames) && result.good(); ++frameNo)
+    {
+        Uint32 frameSize = 0;
+        for (Uint32 idx = FrameIndex[frameNo]; (idx < FrameIndex[frameNo + 1]) && result.good(); ++idx)
+        {
+            result = getItem(pixItem, idx);
+            if (result.good())
+            {
+                const Uint32 length = pixItem->getLength();
+                frameSize += length + (length & 1) + 8;
+            }
+        }
+        frameSizes.push_back(frameSize);
+    }
+    if (result.good())
+        result = getItem(pixItem, 0);
+    if (result.good())
+        result = pixItem->createOffsetTable(frameSizes);
+    return result;
+}
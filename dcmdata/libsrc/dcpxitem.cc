@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -366,7 +366,8 @@ OFCondition DcmPixelItem::writeSignatureFormat(
                       /* write as many bytes as possible to the stream starting at value[getTransferredBytes()] */
                       /* (note that the bytes value[0] to value[getTransferredBytes()-1] have already been */
                       /* written to the stream) */
-                      len = OFstatic_cast(Uint32, outStream.write(&value[getTransferredBytes()], getLengthField() - getTransferredBytes()));
+                      /* (the value stays in memory, so the stream may keep a reference instead of a copy) */
+                      len = OFstatic_cast(Uint32, outStream.writeReference(&value[getTransferredBytes()], getLengthField() - getTransferredBytes()));
 
                       /* increase the amount of bytes which have been transfered correspondingly */
                       incTransferredBytes(len);
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2010, OFFIS e.V.
+ *  Copyright (C) 2002-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,6 +25,7 @@
 // dcmdata includes
 #include "dcmtk/dcmdata/dcrlecp.h"   /* for class DcmRLECodecParameter */
 #include "dcmtk/dcmdata/dcrledec.h"  /* for class DcmRLEDecoder */
+#include "dcmtk/dcmdata/dcrlesc.h"   /* for class DcmRLEStripeCodec */
 #include "dcmtk/dcmdata/dcdatset.h"  /* for class DcmDataset */
 #include "dcmtk/dcmdata/dcdeftag.h"  /* for tag constants */
 #include "dcmtk/dcmdata/dcpixseq.h"  /* for class DcmPixelSequence */
@@ -33,6 +34,283 @@
 #include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary() */
 #include "dcmtk/dcmdata/dcuid.h"     /* for dcmGenerateUniqueIdentifer()*/
 
+// ofstd includes
+#include "dcmtk/ofstd/oflist.h"      /* for class OFList */
+#include "dcmtk/ofstd/ofthread.h"    /* for class OFThread */
+
+
+/** helper class for the decompression of the stripes of a number of frames.
+ *  Each stripe is decompressed directly into the output buffer.  If multiple
+ *  threads are used, each thread fetches the next stripe that has not yet been
+ *  taken and decompresses it.
+ */
+class DcmRLEStripeDecoderJob
+{
+public:
+
+  /** constructor
+   *  @param numFrames number of frames to be decompressed
+   *  @param buffer buffer for the first frame
+   *  @param frameBufSize offset between two frames in the buffer
+   *  @param columns columns of a frame
+   *  @param rows rows of a frame
+   *  @param samplesPerPixel samples per pixel of a frame
+   *  @param bytesAllocated bytes allocated per sample
+   *  @param planarConfiguration planar configuration of the frames
+   *  @param reverseByteOrder assume LSB to MSB order of the stripes
+   */
+  DcmRLEStripeDecoderJob(Uint32 numFrames, Uint8 *buffer, size_t frameBufSize,
+    Uint16 columns, Uint16 rows, Uint16 samplesPerPixel, Uint16 bytesAllocated,
+    Uint16 planarConfiguration, OFBool reverseByteOrder)
+  : numFrames_(numFrames)
+  , buffer_(buffer)
+  , frameBufSize_(frameBufSize)
+  , bytesPerStripe_(OFstatic_cast(size_t, columns) * rows)
+  , bytesAllocated_(bytesAllocated)
+  , planarConfiguration_(planarConfiguration)
+  , reverseByteOrder_(reverseByteOrder)
+  , stripesPerFrame_(OFstatic_cast(Uint32, bytesAllocated) * samplesPerPixel)
+  , stripeData_(new const Uint8 *[numFrames * stripesPerFrame_])
+  , stripeSizes_(new size_t[numFrames * stripesPerFrame_])
+  , decodedBytes_(new size_t[numFrames * stripesPerFrame_])
+  , nextStripe_(0)
+  , mutex_()
+  {
+    for (Uint32 i = 0; i < numStripes(); i++)
+    {
+      stripeData_[i] = NULL;
+      stripeSizes_[i] = 0;
+      decodedBytes_[i] = 0;
+    }
+  }
+
+  /// destructor
+  ~DcmRLEStripeDecoderJob()
+  {
+    delete[] stripeData_;
+    delete[] stripeSizes_;
+    delete[] decodedBytes_;
+  }
+
+  /// returns the total number of stripes of this job
+  Uint32 numStripes() const { return numFrames_ * stripesPerFrame_; }
+
+  /** checks the RLE header of the given compressed frame and determines
+   *  the location of its stripes.  The compressed frame must not be deleted
+   *  before the stripes have been decompressed.
+   *  @param frame index of the frame within this job
+   *  @param rleData compressed frame
+   *  @param rleSize size of the compressed frame, in bytes
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition setFrame(Uint32 frame, const Uint8 *rleData, size_t rleSize)
+  {
+    // we require that the RLE header is present
+    if (rleSize < 64) return EC_CannotChangeRepresentation;
+
+    // copy RLE header to buffer and adjust byte order
+    Uint32 rleHeader[16];
+    memcpy(rleHeader, rleData, 64);
+    swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, rleHeader, 16*OFstatic_cast(Uint32, sizeof(Uint32)), sizeof(Uint32));
+
+    // check that number of stripes in RLE header matches our expectation.
+    // The header has room for the offsets of at most 15 stripes.
+    if ((stripesPerFrame_ < 1) || (stripesPerFrame_ > 15) || (rleHeader[0] != stripesPerFrame_))
+      return EC_CannotChangeRepresentation;
+
+    for (Uint32 i = 0; i < stripesPerFrame_; i++)
+    {
+      // the last stripe ends with the compressed frame, any trailing
+      // pad byte or garbage is ignored by the decoder
+      const size_t start = rleHeader[i + 1];
+      const size_t end = (i + 1 < stripesPerFrame_) ? rleHeader[i + 2] : rleSize;
+      if ((start > end) || (end > rleSize)) return EC_CannotChangeRepresentation;
+      stripeData_[frame * stripesPerFrame_ + i] = rleData + start;
+      stripeSizes_[frame * stripesPerFrame_ + i] = end - start;
+    }
+    return EC_Normal;
+  }
+
+  /** decompresses stripes until all stripes are processed.
+   *  May be called by multiple threads concurrently.
+   */
+  void decodeStripes()
+  {
+    // only needed if the bytes of a stripe are not stored consecutively
+    Uint8 *stripeBuffer = NULL;
+    if (pixelStride() != 1) stripeBuffer = new Uint8[bytesPerStripe_];
+    Uint32 i;
+    while ((i = fetchStripe()) < numStripes())
+    {
+      decodedBytes_[i] = DcmRLEStripeCodec::decodeStripe(stripeData_[i], stripeSizes_[i],
+        pixelPointer(i), pixelStride(), bytesPerStripe_, stripeBuffer);
+    }
+    delete[] stripeBuffer;
+  }
+
+  /** checks whether all stripes of the given frame have been decompressed completely.
+   *  An incomplete last stripe is filled with copies of the last decoded byte.
+   *  @param frame index of the frame within this job
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition checkFrame(Uint32 frame)
+  {
+    for (Uint32 i = frame * stripesPerFrame_; i < (frame + 1) * stripesPerFrame_; i++)
+    {
+      const size_t decodedBytes = decodedBytes_[i];
+      if (decodedBytes < bytesPerStripe_)
+      {
+        if ((i + 1 < (frame + 1) * stripesPerFrame_) || (decodedBytes == 0))
+        {
+          DCMDATA_ERROR("RLE decoder is finished but has produced insufficient data for this stripe");
+          return EC_CannotChangeRepresentation;
+        }
+        // stream ended prematurely, fill the remaining pixels of the last stripe
+        DCMDATA_WARN("RLE decoder is finished but has produced insufficient data for this stripe, filling remaining pixels");
+        const size_t stride = pixelStride();
+        Uint8 *pixel = pixelPointer(i) + decodedBytes * stride;
+        const Uint8 lastPixelValue = *(pixel - stride);
+        for (size_t p = decodedBytes; p < bytesPerStripe_; ++p)
+        {
+          *pixel = lastPixelValue;
+          pixel += stride;
+        }
+      }
+    }
+    return EC_Normal;
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DcmRLEStripeDecoderJob(const DcmRLEStripeDecoderJob&);
+
+  /// private undefined copy assignment operator
+  DcmRLEStripeDecoderJob& operator=(const DcmRLEStripeDecoderJob&);
+
+  /** returns the index of the next stripe to be decompressed (and marks it as taken)
+   *  @return index of the next stripe, numStripes() if all stripes have been taken
+   */
+  Uint32 fetchStripe()
+  {
+    mutex_.lock();
+    const Uint32 i = (nextStripe_ < numStripes()) ? nextStripe_++ : numStripes();
+    mutex_.unlock();
+    return i;
+  }
+
+  /// returns the byte offset between two pixels of a stripe
+  size_t pixelStride() const
+  {
+    return (planarConfiguration_ == 0) ? stripesPerFrame_ : bytesAllocated_;
+  }
+
+  /** returns the location of the first byte of the given stripe in the output buffer
+   *  @param i index of the stripe within this job
+   *  @return pointer to the first byte of the stripe
+   */
+  Uint8 *pixelPointer(Uint32 i) const
+  {
+    const Uint32 frame = i / stripesPerFrame_;
+    const Uint32 stripe = i % stripesPerFrame_;
+    // which sample and byte are we currently decompressing?
+    const Uint32 sample = stripe / bytesAllocated_;
+    const Uint32 byte = stripe % bytesAllocated_;
+    const size_t sampleOffset = (planarConfiguration_ == 0) ? sample * bytesAllocated_ : sample * bytesAllocated_ * bytesPerStripe_;
+    Uint8 *pixelPointer = buffer_ + frame * frameBufSize_ + sampleOffset;
+    if (reverseByteOrder_)
+    {
+      // assume incorrect LSB to MSB order of RLE segments as produced by some tools
+      return pixelPointer + byte;
+    }
+    return pixelPointer + bytesAllocated_ - byte - 1;
+  }
+
+  /// number of frames
+  Uint32 numFrames_;
+
+  /// buffer for the uncompressed frames
+  Uint8 *buffer_;
+
+  /// offset between two frames in the buffer
+  size_t frameBufSize_;
+
+  /// number of bytes of a stripe (i.e. pixels of a frame)
+  size_t bytesPerStripe_;
+
+  /// bytes allocated per sample
+  Uint16 bytesAllocated_;
+
+  /// planar configuration of the frames
+  Uint16 planarConfiguration_;
+
+  /// flag indicating LSB to MSB order of the stripes
+  OFBool reverseByteOrder_;
+
+  /// number of stripes per frame
+  Uint32 stripesPerFrame_;
+
+  /// start of the compressed stripes
+  const Uint8 **stripeData_;
+
+  /// size of the compressed stripes
+  size_t *stripeSizes_;
+
+  /// number of bytes decompressed for each stripe
+  size_t *decodedBytes_;
+
+  /// index of the next stripe to be decompressed
+  Uint32 nextStripe_;
+
+  /// mutex protecting nextStripe_
+  OFMutex mutex_;
+};
+
+
+#ifdef WITH_THREADS
+
+/** worker thread decompressing stripes of a DcmRLEStripeDecoderJob
+ */
+class DcmRLEStripeDecoderThread : public OFThread
+{
+public:
+
+  /** constructor
+   *  @param job job from which the stripes are fetched
+   */
+  DcmRLEStripeDecoderThread(DcmRLEStripeDecoderJob &job)
+  : OFThread()
+  , job_(job)
+  {
+  }
+
+  /// destructor
+  virtual ~DcmRLEStripeDecoderThread()
+  {
+  }
+
+protected:
+
+  /// decompresses stripes until all stripes of the job are processed
+  virtual void run()
+  {
+    job_.decodeStripes();
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DcmRLEStripeDecoderThread(const DcmRLEStripeDecoderThread&);
+
+  /// private undefined copy assignment operator
+  DcmRLEStripeDecoderThread& operator=(const DcmRLEStripeDecoderThread&);
+
+  /// job from which the stripes are fetched
+  DcmRLEStripeDecoderJob &job_;
+};
+
+#endif
+
 
 DcmRLECodecDecoder::DcmRLECodecDecoder()
 : DcmCodec()
@@ -139,6 +417,19 @@ OFCondition DcmRLECodecDecoder::decode(
         {
           Uint8 *imageData8 = OFreinterpret_cast(Uint8 *, imageData16);
 
+          // standard case: one fragment per frame. The frame boundaries are known,
+          // so all frames can be decompressed at once (concurrently, if configured).
+          if (pixSeq->card() == OFstatic_cast(unsigned long, imageFrames) + 1)
+          {
+            Uint32 *startFragments = new Uint32[imageFrames + 1];
+            for (i = 0; i <= OFstatic_cast(Uint32, imageFrames); i++) startFragments[i] = i + 1;
+            result = decompressFrames(pixSeq, djcp, startFragments, OFstatic_cast(Uint32, imageFrames), imageData8,
+              frameSize, imageColumns, imageRows, imageSamplesPerPixel, imageBytesAllocated, imagePlanarConfiguration);
+            delete[] startFragments;
+            currentFrame = imageFrames;
+          }
+
+          // otherwise, decompress the frames one after the other, following the fragments
           while ((currentFrame < imageFrames) && result.good())
           {
             DCMDATA_DEBUG("RLE decoder processes frame " << currentFrame);
@@ -413,8 +704,6 @@ OFCondition DcmRLECodecDecoder::decodeFrame(
     // assume we can cast the codec parameter to what we need
     const DcmRLECodecParameter *djcp = OFstatic_cast(const DcmRLECodecParameter *, cp);
 
-    OFBool enableReverseByteOrder = djcp->getReverseDecompressionByteOrder();
-
     if ((!dataset)||((dataset->ident()!= EVR_dataset) && (dataset->ident()!= EVR_item))) return EC_InvalidTag;
 
     Uint16 imageSamplesPerPixel = 0;
@@ -424,7 +713,6 @@ OFCondition DcmRLECodecDecoder::decodeFrame(
     Uint16 imageBitsAllocated = 0;
     Uint16 imageBytesAllocated = 0;
     Uint16 imagePlanarConfiguration = 0;
-    Uint32 rleHeader[16];
     OFString photometricInterpretation;
     DcmItem *ditem = OFstatic_cast(DcmItem *, dataset);
 
@@ -450,18 +738,12 @@ OFCondition DcmRLECodecDecoder::decodeFrame(
     if (result.bad())
        return result;
 
-    DcmPixelItem *pixItem = NULL;
-    Uint8 * rleData = NULL;
-    const size_t bytesPerStripe = imageColumns * imageRows;
-    Uint32 numberOfStripes = 0;
-    Uint32 fragmentLength = 0;
-    Uint32 i;
     Uint32 frameSize = imageBytesAllocated * imageRows * imageColumns * imageSamplesPerPixel;
 
     if (frameSize > bufSize) return EC_IllegalCall;
 
-    DcmRLEDecoder rledecoder(bytesPerStripe);
-    if (rledecoder.fail()) return EC_MemoryExhausted;  // RLE decoder failed to initialize
+    // an RLE stripe set can have at most 15 stripes
+    if (OFstatic_cast(Uint32, imageBytesAllocated) * imageSamplesPerPixel > 15) return EC_CannotChangeRepresentation;
 
     DCMDATA_DEBUG("RLE decoder processes frame " << frameNo);
 
@@ -478,172 +760,242 @@ OFCondition DcmRLECodecDecoder::decodeFrame(
     }
 
     DCMDATA_DEBUG("RLE decoder processes pixel item " << currentItem);
-    // now access and decompress the frame starting at the item we have identified
-    result = fromPixSeq->getItem(pixItem, currentItem);
-    if (result.bad())
-       return result;
+    // now access and decompress the frame starting at the item we have identified.
+    // The frame must be contained in this item completely.
+    Uint32 startFragments[2] = { currentItem, currentItem + 1 };
+    result = decompressFrames(fromPixSeq, djcp, startFragments, 1, OFstatic_cast(Uint8 *, buffer), frameSize,
+        imageColumns, imageRows, imageSamplesPerPixel, imageBytesAllocated, imagePlanarConfiguration);
 
-    fragmentLength = pixItem->getLength();
-    result = pixItem->getUint8Array(rleData);
-    if (result.bad())
-       return result;
+    /* remove used fragment from memory */
+    DcmPixelItem *pixItem = NULL;
+    if (fromPixSeq->getItem(pixItem, currentItem).good())
+        pixItem->compact(); // there should only be one...
 
-    // copy RLE header to buffer and adjust byte order
-    memcpy(rleHeader, rleData, 64);
-    swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, rleHeader, OFstatic_cast(Uint32, 16*sizeof(Uint32)), sizeof(Uint32));
+    if (result.good())
+    {
+      // compression was successful. Now update output parameters
+      startFragment = currentItem + 1;
+      decompressedColorModel = photometricInterpretation;
+    }
+
+    // adjust byte order for uncompressed image to little endian
+    swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, buffer, frameSize, sizeof(Uint16));
 
-    // determine number of stripes.
-    numberOfStripes = rleHeader[0];
+    return result;
+}
+
+
+OFCondition DcmRLECodecDecoder::decodeFrames(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    void *buffer,
+    Uint32 frameBufSize,
+    OFString& decompressedColorModel) const
+{
+    if ((buffer == NULL) || (numberOfFrames == 0)) return EC_IllegalCall;
+    if ((!dataset)||((dataset->ident()!= EVR_dataset) && (dataset->ident()!= EVR_item))) return EC_InvalidTag;
 
-    // check that number of stripes in RLE header matches our expectation
-    if ((numberOfStripes < 1) || (numberOfStripes > 15) || (numberOfStripes != OFstatic_cast(Uint32, imageBytesAllocated) * imageSamplesPerPixel))
-        return EC_CannotChangeRepresentation;
+    // assume we can cast the codec parameter to what we need
+    const DcmRLECodecParameter *djcp = OFstatic_cast(const DcmRLECodecParameter *, cp);
 
-    // this variable keeps the current position within the current fragment
-    Uint32 byteOffset = 0;
+    // decompress the frames one after the other unless multiple threads are configured
+    if ((numberOfFrames == 1) || (djcp->getNumberOfThreads() <= 1))
+    {
+        return DcmCodec::decodeFrames(fromParam, fromPixSeq, cp, dataset, firstFrame, numberOfFrames,
+            startFragment, buffer, frameBufSize, decompressedColorModel);
+    }
 
-    OFBool lastStripe = OFFalse;
-    Uint32 inputBytes = 0;
+    Uint16 imageSamplesPerPixel = 0;
+    Uint16 imageRows = 0;
+    Uint16 imageColumns = 0;
+    Sint32 imageFrames = 1;
+    Uint16 imageBitsAllocated = 0;
+    Uint16 imagePlanarConfiguration = 0;
+    OFString photometricInterpretation;
 
-    // pointers for buffer copy operations
-    Uint8 *outputBuffer = NULL;
-    Uint8 *pixelPointer = NULL;
-    Uint16 *imageData16 = OFreinterpret_cast(Uint16 *, buffer);
-    Uint8 *imageData8 = OFreinterpret_cast(Uint8 *, buffer);
+    OFCondition result = dataset->findAndGetUint16(DCM_SamplesPerPixel, imageSamplesPerPixel);
+    if (result.good()) result = dataset->findAndGetUint16(DCM_Rows, imageRows);
+    if (result.good()) result = dataset->findAndGetUint16(DCM_Columns, imageColumns);
+    if (result.good()) result = dataset->findAndGetUint16(DCM_BitsAllocated, imageBitsAllocated);
+    if (result.good()) result = dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometricInterpretation);
+    if (result.good() && (imageSamplesPerPixel > 1))
+    {
+        result = dataset->findAndGetUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
+    }
+    if (result.bad())
+       return result;
 
-    // byte offset for first sample in frame
-    Uint32 sampleOffset = 0;
+    const Uint16 imageBytesAllocated = OFstatic_cast(Uint16, imageBitsAllocated / 8);
+    if ((imageBitsAllocated < 8)||(imageBitsAllocated % 8 != 0)) return EC_CannotChangeRepresentation;
+    if (OFstatic_cast(Uint32, imageBytesAllocated) * imageSamplesPerPixel > 15) return EC_CannotChangeRepresentation;
 
-    // byte offset between samples
-    Uint32 offsetBetweenSamples = 0;
+    const Uint32 frameSize = imageBytesAllocated * imageRows * imageColumns * imageSamplesPerPixel;
+    if (frameSize > frameBufSize) return EC_IllegalCall;
 
-    // temporary variables
-    Uint32 sample = 0;
-    Uint32 byte = 0;
-    register Uint32 pixel = 0;
-    size_t bytesToDecode;
+    // number of frames is an optional attribute - we don't mind if it isn't present.
+    (void) dataset->findAndGetSint32(DCM_NumberOfFrames, imageFrames);
+    if (imageFrames >= OFstatic_cast(Sint32, fromPixSeq->card()))
+      imageFrames = OFstatic_cast(Sint32, fromPixSeq->card()) - 1; // limit number of frames to number of pixel items - 1
+    if (imageFrames < 1)
+      imageFrames = 1; // default in case the number of frames attribute is absent or contains garbage
 
-    // for each stripe in stripe set
-    for (i = 0; i < numberOfStripes; ++i)
+    // the frame boundaries must be known in order to access the fragments of all frames at once
+    Uint32 *startFragments = new Uint32[numberOfFrames + 1];
+    if (determineFrameFragments(firstFrame, numberOfFrames, imageFrames, fromPixSeq, startFragments).bad())
     {
-        // reset RLE codec
-        rledecoder.clear();
+        delete[] startFragments;
+        DCMDATA_DEBUG("RLE decoder: frame boundaries unknown, decompressing frames sequentially");
+        return DcmCodec::decodeFrames(fromParam, fromPixSeq, cp, dataset, firstFrame, numberOfFrames,
+            startFragment, buffer, frameBufSize, decompressedColorModel);
+    }
 
-        // adjust start point for RLE stripe
-        byteOffset = rleHeader[i+1];
+    DCMDATA_DEBUG("RLE decoder processes frames " << firstFrame << " to " << (firstFrame + numberOfFrames - 1));
+    Uint8 *frameBuffer = OFstatic_cast(Uint8 *, buffer);
+    result = decompressFrames(fromPixSeq, djcp, startFragments, numberOfFrames, frameBuffer, frameBufSize,
+        imageColumns, imageRows, imageSamplesPerPixel, imageBytesAllocated, imagePlanarConfiguration);
+
+    /* remove used fragments from memory */
+    DcmPixelItem *pixItem = NULL;
+    for (Uint32 i = startFragments[0]; i < startFragments[numberOfFrames]; i++)
+    {
+        if (fromPixSeq->getItem(pixItem, i).good())
+            pixItem->compact();
+    }
 
-        // byteOffset now points to the first byte of the new RLE stripe
-        // check if the current stripe is the last one for this frame
-        if (i+1 == numberOfStripes) lastStripe = OFTrue; else lastStripe = OFFalse;
+    if (result.good())
+    {
+      // compression was successful. Now update output parameters
+      startFragment = startFragments[numberOfFrames];
+      decompressedColorModel = photometricInterpretation;
+    }
+    delete[] startFragments;
 
-        if (lastStripe)
-        {
-            // the last stripe needs special handling because we cannot use the
-            // offset table to determine the number of bytes to feed to the codec
-            // if the RLE data is split in multiple fragments. We need to feed
-            // data fragment by fragment until the RLE codec has produced
-            // sufficient output.
-            bytesToDecode = OFstatic_cast(size_t, fragmentLength - byteOffset);
-        }
-        else
-        {
-            // not the last stripe. We can use the offset table to determine
-            // the number of bytes to feed to the RLE codec.
-            inputBytes = rleHeader[i+2];
-            if (inputBytes < rleHeader[i+1]) return EC_CannotChangeRepresentation;
+    // adjust byte order for uncompressed image to little endian
+    for (Uint32 i = 0; i < numberOfFrames; i++)
+        swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, frameBuffer + i * frameBufSize, frameSize, sizeof(Uint16));
 
-            inputBytes -= rleHeader[i+1]; // number of bytes to feed to codec
+    return result;
+}
 
-            bytesToDecode = OFstatic_cast(size_t, inputBytes);
-        }
 
-        // last fragment for this RLE stripe
-        result = rledecoder.decompress(rleData + byteOffset, bytesToDecode);
+OFCondition DcmRLECodecDecoder::decompressFrames(
+    DcmPixelSequence *pixSeq,
+    const DcmRLECodecParameter *cp,
+    const Uint32 *startFragments,
+    Uint32 numberOfFrames,
+    Uint8 *buffer,
+    size_t frameBufSize,
+    Uint16 columns,
+    Uint16 rows,
+    Uint16 samplesPerPixel,
+    Uint16 bytesAllocated,
+    Uint16 planarConfiguration)
+{
+    // an RLE frame consists of at most 15 stripes, one for each byte of each sample
+    const Uint32 stripesPerFrame = OFstatic_cast(Uint32, bytesAllocated) * samplesPerPixel;
+    if ((stripesPerFrame < 1) || (stripesPerFrame > 15)) return EC_CannotChangeRepresentation;
 
-        // special handling for zero pad byte at the end of the RLE stream
-        // which results in an EC_StreamNotifyClient return code
-        // or trailing garbage data which results in EC_CorruptedData
-        if (rledecoder.size() == bytesPerStripe) result = EC_Normal;
+    OFCondition result = EC_Normal;
+    DcmRLEStripeDecoderJob job(numberOfFrames, buffer, frameBufSize, columns, rows, samplesPerPixel,
+        bytesAllocated, planarConfiguration, cp->getReverseDecompressionByteOrder());
 
-        byteOffset += inputBytes;
+    // frames stored in more than one fragment are copied into a buffer of their own
+    OFList<Uint8 *> frameCopies;
 
-        // copy the decoded stuff over to the buffer here...
-        // make sure the RLE decoder has produced the right amount of data
-        if (lastStripe && (rledecoder.size() < bytesPerStripe))
+    // access the compressed frames, since the pixel sequence must not be accessed by multiple threads
+    for (Uint32 i = 0; (i < numberOfFrames) && result.good(); i++)
+    {
+        DcmPixelItem *pixItem = NULL;
+        Uint8 *rleData = NULL;
+        size_t rleSize = 0;
+        if (startFragments[i + 1] <= startFragments[i]) result = EC_CannotChangeRepresentation;
+        else if (startFragments[i + 1] == startFragments[i] + 1)
         {
-            // stream ended premature? report a warning and continue
-            if (result == EC_StreamNotifyClient)
+            // standard case: the frame is stored in a single fragment
+            result = pixSeq->getItem(pixItem, startFragments[i]);
+            if (result.good()) result = pixItem->getUint8Array(rleData);
+            if (result.good()) rleSize = pixItem->getLength();
+        } else {
+            Uint32 item;
+            for (item = startFragments[i]; (item < startFragments[i + 1]) && result.good(); item++)
+            {
+                result = pixSeq->getItem(pixItem, item);
+                if (result.good()) rleSize += pixItem->getLength();
+            }
+            if (result.good())
             {
-                DCMDATA_WARN("RLE decoder is finished but has produced insufficient data for this stripe, filling remaining pixels");
-                result = EC_Normal;
+                rleData = new Uint8[rleSize];
+                frameCopies.push_back(rleData);
+                Uint8 *fragmentData = NULL;
+                size_t offset = 0;
+                for (item = startFragments[i]; (item < startFragments[i + 1]) && result.good(); item++)
+                {
+                    result = pixSeq->getItem(pixItem, item);
+                    if (result.good()) result = pixItem->getUint8Array(fragmentData);
+                    if (result.good() && fragmentData)
+                    {
+                        memcpy(rleData + offset, fragmentData, pixItem->getLength());
+                        offset += pixItem->getLength();
+                    }
+                }
             }
         }
-        else if (rledecoder.size() != bytesPerStripe)
+        if (result.good())
         {
-            DCMDATA_ERROR("RLE decoder is finished but has produced insufficient data for this stripe");
-            return EC_CannotChangeRepresentation;
+            if (rleData == NULL) result = EC_CannotChangeRepresentation;
+            else result = job.setFrame(i, rleData, rleSize);
         }
+    }
 
-        // distribute decompressed bytes into output image array
-        // which sample and byte are we currently decompressing?
-        sample = i / imageBytesAllocated;
-        byte = i % imageBytesAllocated;
-
-        // raw buffer containing bytesPerStripe bytes of uncompressed data
-        outputBuffer = OFstatic_cast(Uint8 *, rledecoder.getOutputBuffer());
-
-        // compute byte offsets
-        if (imagePlanarConfiguration == 0)
-        {
-            sampleOffset = sample * imageBytesAllocated;
-            offsetBetweenSamples = imageSamplesPerPixel * imageBytesAllocated;
-        }
-        else
+    if (result.good())
+    {
+        const Uint32 numberOfThreads = cp->getNumberOfThreads();
+        if (numberOfThreads > 1)
         {
-            sampleOffset = sample * imageBytesAllocated * imageColumns * imageRows;
-            offsetBetweenSamples = imageBytesAllocated;
+            DCMDATA_DEBUG("RLE decoder: decompressing " << job.numStripes() << " stripes using up to "
+                << numberOfThreads << " threads");
         }
 
-        // initialize pointer to output data
-        if (enableReverseByteOrder)
+        // decompress the stripes, using additional threads if possible
+#ifdef WITH_THREADS
+        OFList<DcmRLEStripeDecoderThread *> threads;
+        for (Uint32 t = 1; (t < numberOfThreads) && (t < job.numStripes()); t++)
         {
-            // assume incorrect LSB to MSB order of RLE segments as produced by some tools
-            pixelPointer = imageData8 + sampleOffset + byte;
+            DcmRLEStripeDecoderThread *thread = new DcmRLEStripeDecoderThread(job);
+            if (thread->start() != 0)
+            {
+                // the remaining stripes are decompressed by the other threads
+                delete thread;
+                break;
+            }
+            threads.push_back(thread);
         }
-        else
+#endif
+        job.decodeStripes();
+#ifdef WITH_THREADS
+        while (!threads.empty())
         {
-            pixelPointer = imageData8 + sampleOffset + imageBytesAllocated - byte - 1;
+            threads.front()->join();
+            delete threads.front();
+            threads.pop_front();
         }
+#endif
 
-        // copy the pixel data that was decoded
-        const size_t decoderSize = rledecoder.size();
-        for (pixel = 0; pixel < decoderSize; ++pixel)
-        {
-            *pixelPointer = *outputBuffer++;
-            pixelPointer += offsetBetweenSamples;
-        }
-        // and fill the remainder of the image with copies of the last decoded pixel
-        const Uint8 lastPixelValue = *(outputBuffer - 1);
-        for (pixel = OFstatic_cast(Uint32, decoderSize); pixel < bytesPerStripe; ++pixel)
-        {
-            *pixelPointer = lastPixelValue;
-            pixelPointer += offsetBetweenSamples;
-        }
+        // make sure the RLE decoder has produced the right amount of data
+        for (Uint32 i = 0; (i < numberOfFrames) && result.good(); i++)
+            result = job.checkFrame(i);
     }
 
-    /* remove used fragment from memory */
-    pixItem->compact(); // there should only be one...
-
-    if (result.good())
+    while (!frameCopies.empty())
     {
-      // compression was successful. Now update output parameters
-      startFragment = currentItem + 1;
-      decompressedColorModel = photometricInterpretation;
+        delete[] frameCopies.front();
+        frameCopies.pop_front();
     }
-
-    // adjust byte order for uncompressed image to little endian
-    swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, imageData16, frameSize, sizeof(Uint16));
-
     return result;
 }
 
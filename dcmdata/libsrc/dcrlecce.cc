@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2014, OFFIS e.V.
+ *  Copyright (C) 2002-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -22,7 +22,7 @@
 #include "dcmtk/config/osconfig.h"
 #include "dcmtk/dcmdata/dcrlecce.h"
 
-#include "dcmtk/dcmdata/dcrleenc.h"  /* for class DcmRLEEncoder */
+#include "dcmtk/dcmdata/dcrlesc.h"   /* for class DcmRLEStripeCodec */
 #include "dcmtk/dcmdata/dcrlecp.h"   /* for class DcmRLECodecParameter */
 #include "dcmtk/dcmdata/dcdeftag.h"  /* for tag constants */
 #include "dcmtk/dcmdata/dcpixseq.h"  /* for class DcmPixelSequence */
@@ -30,13 +30,234 @@
 #include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary */
 #include "dcmtk/dcmdata/dcitem.h"
 #include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/oflist.h"      /* for class OFList */
+#include "dcmtk/ofstd/ofthread.h"    /* for class OFThread */
 
 #define INCLUDE_CSTDIO
+#define INCLUDE_CSTRING
 #include "dcmtk/ofstd/ofstdinc.h"
 
 
-typedef OFList<DcmRLEEncoder *> DcmRLEEncoderList;
-typedef OFListIterator(DcmRLEEncoder *) DcmRLEEncoderListIterator;
+/** helper class for the compression of the stripes of a run of frames.
+ *  Each stripe is compressed into the part of the frame buffer that is
+ *  reserved for it.  If multiple threads are used, each thread fetches
+ *  the next stripe that has not yet been taken and compresses it.
+ */
+class DcmRLEStripeEncoderJob
+{
+public:
+
+  /** constructor
+   *  @param pixelData pointer to the first frame of the run (little endian)
+   *  @param numFrames number of frames to be compressed
+   *  @param frameSize size of an uncompressed frame in bytes
+   *  @param columns columns of a frame
+   *  @param rows rows of a frame
+   *  @param samplesPerPixel samples per pixel of a frame
+   *  @param bytesAllocated bytes allocated per sample
+   *  @param planarConfiguration planar configuration of the frames
+   */
+  DcmRLEStripeEncoderJob(const Uint8 *pixelData, Uint32 numFrames, size_t frameSize,
+    Uint16 columns, Uint16 rows, Uint16 samplesPerPixel, Uint16 bytesAllocated, Uint16 planarConfiguration)
+  : pixelData_(pixelData)
+  , numFrames_(numFrames)
+  , frameSize_(frameSize)
+  , columns_(columns)
+  , rows_(rows)
+  , samplesPerPixel_(samplesPerPixel)
+  , bytesAllocated_(bytesAllocated)
+  , planarConfiguration_(planarConfiguration)
+  , stripesPerFrame_(OFstatic_cast(Uint32, bytesAllocated) * samplesPerPixel)
+  , maxStripeSize_(DcmRLEStripeCodec::getMaxEncodedSize(columns, rows))
+  , frameBuffers_(new Uint8 *[numFrames])
+  , stripeSizes_(new size_t[numFrames * stripesPerFrame_])
+  , nextStripe_(0)
+  , mutex_()
+  {
+    for (Uint32 i = 0; i < numFrames_; i++)
+      frameBuffers_[i] = new Uint8[64 + stripesPerFrame_ * maxStripeSize_];
+  }
+
+  /// destructor, also deletes the compressed frames
+  ~DcmRLEStripeEncoderJob()
+  {
+    for (Uint32 i = 0; i < numFrames_; i++)
+      delete[] frameBuffers_[i];
+    delete[] frameBuffers_;
+    delete[] stripeSizes_;
+  }
+
+  /// returns the total number of stripes of this job
+  Uint32 numStripes() const { return numFrames_ * stripesPerFrame_; }
+
+  /** compresses stripes until all stripes are processed.
+   *  May be called by multiple threads concurrently.
+   */
+  void encodeStripes()
+  {
+    // only needed if the bytes of a stripe are not stored consecutively
+    Uint8 *rowBuffer = new Uint8[columns_];
+    const size_t bytesPerStripe = OFstatic_cast(size_t, columns_) * rows_;
+    // compute byte offset between samples
+    const size_t offsetBetweenSamples = (planarConfiguration_ == 0) ? stripesPerFrame_ : bytesAllocated_;
+    Uint32 i;
+    while ((i = fetchStripe()) < numStripes())
+    {
+      const Uint32 frame = i / stripesPerFrame_;
+      const Uint32 stripe = i % stripesPerFrame_;
+      // which sample and byte are we currently compressing?
+      // The most significant byte of each sample comes first.
+      const Uint32 sample = stripe / bytesAllocated_;
+      const Uint32 byte = stripe % bytesAllocated_;
+      const size_t sampleOffset = (planarConfiguration_ == 0) ? sample * bytesAllocated_ : sample * bytesAllocated_ * bytesPerStripe;
+      const Uint8 *pixelPointer = pixelData_ + frame * frameSize_ + sampleOffset + bytesAllocated_ - byte - 1;
+      stripeSizes_[i] = DcmRLEStripeCodec::encodeStripe(pixelPointer, offsetBetweenSamples, columns_, rows_,
+        frameBuffers_[frame] + 64 + stripe * maxStripeSize_, rowBuffer);
+    }
+    delete[] rowBuffer;
+  }
+
+  /** creates the RLE header of the given frame and moves the compressed
+   *  stripes directly behind each other.  Must be called after all stripes
+   *  of the job have been compressed.
+   *  @param frame index of the frame within this job
+   *  @return size of the compressed frame including the RLE header, in bytes
+   */
+  Uint32 finishFrame(Uint32 frame)
+  {
+    Uint8 *frameBuffer = frameBuffers_[frame];
+    const size_t *stripeSizes = stripeSizes_ + frame * stripesPerFrame_;
+    Uint32 rleHeader[16];
+    Uint32 i;
+    for (i = 0; i < 16; i++) rleHeader[i] = 0;
+    rleHeader[0] = stripesPerFrame_;
+    Uint32 rleSize = 64;
+    for (i = 0; i < stripesPerFrame_; i++)
+    {
+      rleHeader[i + 1] = rleSize;
+      // the first stripe is already at the right position
+      if (rleSize != 64 + i * maxStripeSize_)
+        memmove(frameBuffer + rleSize, frameBuffer + 64 + i * maxStripeSize_, stripeSizes[i]);
+      rleSize += OFstatic_cast(Uint32, stripeSizes[i]);
+    }
+    // copy RLE header to compressed frame buffer
+    swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, rleHeader, OFstatic_cast(Uint32, 16*sizeof(Uint32)), sizeof(Uint32));
+    memcpy(frameBuffer, rleHeader, 64);
+    return rleSize;
+  }
+
+  /** returns the buffer of the given frame
+   *  @param frame index of the frame within this job
+   *  @return pointer to the compressed frame
+   */
+  Uint8 *frameBuffer(Uint32 frame) { return frameBuffers_[frame]; }
+
+private:
+
+  /// private undefined copy constructor
+  DcmRLEStripeEncoderJob(const DcmRLEStripeEncoderJob&);
+
+  /// private undefined copy assignment operator
+  DcmRLEStripeEncoderJob& operator=(const DcmRLEStripeEncoderJob&);
+
+  /** returns the index of the next stripe to be compressed (and marks it as taken)
+   *  @return index of the next stripe, numStripes() if all stripes have been taken
+   */
+  Uint32 fetchStripe()
+  {
+    mutex_.lock();
+    const Uint32 i = (nextStripe_ < numStripes()) ? nextStripe_++ : numStripes();
+    mutex_.unlock();
+    return i;
+  }
+
+  /// pointer to the first uncompressed frame
+  const Uint8 *pixelData_;
+
+  /// number of frames
+  Uint32 numFrames_;
+
+  /// size of an uncompressed frame
+  size_t frameSize_;
+
+  /// columns of a frame
+  Uint16 columns_;
+
+  /// rows of a frame
+  Uint16 rows_;
+
+  /// samples per pixel of a frame
+  Uint16 samplesPerPixel_;
+
+  /// bytes allocated per sample
+  Uint16 bytesAllocated_;
+
+  /// planar configuration of the frames
+  Uint16 planarConfiguration_;
+
+  /// number of stripes per frame
+  Uint32 stripesPerFrame_;
+
+  /// space reserved for a compressed stripe in the frame buffers
+  size_t maxStripeSize_;
+
+  /// buffers for the compressed frames
+  Uint8 **frameBuffers_;
+
+  /// sizes of the compressed stripes
+  size_t *stripeSizes_;
+
+  /// index of the next stripe to be compressed
+  Uint32 nextStripe_;
+
+  /// mutex protecting nextStripe_
+  OFMutex mutex_;
+};
+
+
+#ifdef WITH_THREADS
+
+/** worker thread compressing stripes of a DcmRLEStripeEncoderJob
+ */
+class DcmRLEStripeEncoderThread : public OFThread
+{
+public:
+
+  /** constructor
+   *  @param job job from which the stripes are fetched
+   */
+  DcmRLEStripeEncoderThread(DcmRLEStripeEncoderJob &job)
+  : OFThread()
+  , job_(job)
+  {
+  }
+
+  /// destructor
+  virtual ~DcmRLEStripeEncoderThread()
+  {
+  }
+
+protected:
+
+  /// compresses stripes until all stripes of the job are processed
+  virtual void run()
+  {
+    job_.encodeStripes();
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DcmRLEStripeEncoderThread(const DcmRLEStripeEncoderThread&);
+
+  /// private undefined copy assignment operator
+  DcmRLEStripeEncoderThread& operator=(const DcmRLEStripeEncoderThread&);
+
+  /// job from which the stripes are fetched
+  DcmRLEStripeEncoderJob &job_;
+};
+
+#endif
 
 
 // =======================================================================
@@ -124,13 +345,7 @@ OFCondition DcmRLECodecEncoder::encode(
   (void)localStack.pop();             // pop pixel data element from stack
   DcmObject *dataset = localStack.pop(); // this is the item in which the pixel data is located
   Uint8 *pixelData8 = OFreinterpret_cast(Uint8 *, OFconst_cast(Uint16 *, pixelData));
-  Uint8 *pixelPointer = NULL;
   DcmOffsetList offsetList;
-  DcmRLEEncoderList rleEncoderList;
-  DcmRLEEncoderListIterator first = rleEncoderList.begin();
-  DcmRLEEncoderListIterator last = rleEncoderList.end();
-  Uint32 rleHeader[16];
-  Uint32 i;
   OFBool byteSwapped = OFFalse;  // true if we have byte-swapped the original pixel data
 
   if ((!dataset)||((dataset->ident()!= EVR_dataset) && (dataset->ident()!= EVR_item))) result = EC_InvalidTag;
@@ -205,137 +420,63 @@ OFCondition DcmRLECodecEncoder::encode(
     // create RLE stripe sets
     if (result.good())
     {
-      const Uint32 bytesPerStripe = columns * rows;
-      const Uint32 frameSize = columns * rows * samplesPerPixel * bytesAllocated;
-      Uint32 frameOffset = 0;
-      Uint32 sampleOffset = 0;
-      Uint32 offsetBetweenSamples = 0;
-      Uint32 sample = 0;
-      Uint32 byte = 0;
-      register Uint32 pixel = 0;
-      register Uint32 columnCounter = 0;
-
-      DcmRLEEncoder *rleEncoder = NULL;
-      Uint32 rleSize = 0;
-      Uint8 *rleData = NULL;
-      Uint8 *rleData2 = NULL;
+      const size_t frameSize = OFstatic_cast(size_t, columns) * rows * samplesPerPixel * bytesAllocated;
+      const Uint32 numberOfThreads = (djcp->getNumberOfThreads() > 0) ? djcp->getNumberOfThreads() : 1;
 
       // warn about (possibly) non-standard fragmentation
       if (djcp->getFragmentSize() > 0)
          DCMDATA_WARN("DcmRLECodecEncoder: limiting the fragment size may result in non-standard conformant encoding");
 
-      // compute byte offset between samples
-      if (planarConfiguration == 0)
-         offsetBetweenSamples = samplesPerPixel * bytesAllocated;
-         else offsetBetweenSamples = bytesAllocated;
+      // compress as many frames at a time as needed to keep all threads busy
+      Uint32 framesPerRun = (numberOfThreads + numberOfStripes - 1) / numberOfStripes;
+      if (framesPerRun < 1) framesPerRun = 1;
+      if (numberOfThreads > 1)
+        DCMDATA_DEBUG("RLE encoder: compressing " << numberOfStripes << " stripes per frame using up to "
+          << numberOfThreads << " threads");
 
       // loop through all frames of the image
-      for (Uint32 currentFrame = 0; ((currentFrame < OFstatic_cast(Uint32, numberOfFrames)) && result.good()); currentFrame++)
+      Uint32 currentFrame = 0;
+      while ((currentFrame < OFstatic_cast(Uint32, numberOfFrames)) && result.good())
       {
-        // offset to start of frame, in bytes
-        frameOffset = frameSize * currentFrame;
-
-        // loop through all samples of one frame
-        for (sample = 0; sample < samplesPerPixel; sample++)
+        Uint32 framesInRun = OFstatic_cast(Uint32, numberOfFrames) - currentFrame;
+        if (framesInRun > framesPerRun) framesInRun = framesPerRun;
+        DcmRLEStripeEncoderJob job(pixelData8 + frameSize * currentFrame, framesInRun, frameSize,
+          columns, rows, samplesPerPixel, bytesAllocated, planarConfiguration);
+
+        // compress the stripes, using additional threads if possible
+#ifdef WITH_THREADS
+        OFList<DcmRLEStripeEncoderThread *> threads;
+        for (Uint32 t = 1; (t < numberOfThreads) && (t < job.numStripes()); t++)
         {
-          // compute byte offset for first sample in frame
-          if (planarConfiguration == 0)
-             sampleOffset = sample * bytesAllocated;
-             else sampleOffset = sample * bytesAllocated * columns * rows;
-
-          // loop through the bytes of one sample
-          for (byte = 0; byte < bytesAllocated; byte++)
+          DcmRLEStripeEncoderThread *thread = new DcmRLEStripeEncoderThread(job);
+          if (thread->start() != 0)
           {
-            pixelPointer = pixelData8 + frameOffset + sampleOffset + bytesAllocated - byte - 1;
-
-            // initialize new RLE codec for this stripe
-            rleEncoder = new DcmRLEEncoder(1 /* DICOM padding required */);
-            if (rleEncoder)
-            {
-              rleEncoderList.push_back(rleEncoder);
-              columnCounter = columns;
-
-              // loop through all pixels of the frame
-              for (pixel = 0; pixel < bytesPerStripe; ++pixel)
-              {
-                rleEncoder->add(*pixelPointer);
-
-                // enforce DICOM rule that "Each row of the image shall be encoded
-                // separately and not cross a row boundary."
-                // (see DICOM part 5 section G.3.1)
-                if (--columnCounter == 0)
-                {
-                  rleEncoder->flush();
-                  columnCounter = columns;
-                }
-                pixelPointer += offsetBetweenSamples;
-              }
-
-              rleEncoder->flush();
-              if (rleEncoder->fail()) result = EC_MemoryExhausted;
-            } else result = EC_MemoryExhausted;
+            // the remaining stripes are compressed by the other threads
+            delete thread;
+            break;
           }
+          threads.push_back(thread);
         }
-
-        // store frame and erase RLE codec list
-        if (result.good() && (rleEncoderList.size() > 0) && (rleEncoderList.size() < 16))
+#endif
+        job.encodeStripes();
+#ifdef WITH_THREADS
+        while (!threads.empty())
         {
-          // compute size of compressed frame including RLE header
-          // and populate RLE header
-          for (i=0; i<16; i++) rleHeader[i] = 0;
-          rleHeader[0] = OFstatic_cast(Uint32, rleEncoderList.size());
-          rleSize = 64;
-          i = 1;
-          first = rleEncoderList.begin();
-          while (first != last)
-          {
-            rleHeader[i++] = rleSize;
-            rleSize += OFstatic_cast(Uint32, (*first)->size());
-            ++first;
-          }
-
-          // allocate buffer for compressed frame
-          rleData = new Uint8[rleSize];
-
-          if (rleData)
-          {
-            // copy RLE header to compressed frame buffer
-            swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, rleHeader, OFstatic_cast(Uint32, 16*sizeof(Uint32)), sizeof(Uint32));
-            memcpy(rleData, rleHeader, 64);
-
-            // store RLE stripe sets in compressed frame buffer
-            rleData2 = rleData + 64;
-            first = rleEncoderList.begin();
-            while (first != last)
-            {
-              (*first)->write(rleData2);
-              rleData2 += (*first)->size();
-              delete *first;
-              first = rleEncoderList.erase(first);
-            }
-
-            // store compressed frame, breaking into segments if necessary
-            result = pixelSequence->storeCompressedFrame(offsetList, rleData, rleSize, djcp->getFragmentSize());
-            compressedSize += rleSize;
-
-            // erase buffer for compressed frame
-            delete[] rleData;
-          } else result = EC_MemoryExhausted;
+          threads.front()->join();
+          delete threads.front();
+          threads.pop_front();
         }
-        else
+#endif
+
+        // store compressed frames in their original order, breaking into segments if necessary
+        for (Uint32 f = 0; (f < framesInRun) && result.good(); f++)
         {
-          // erase RLE codec list
-          first = rleEncoderList.begin();
-          while (first != last)
-          {
-            delete *first;
-            first = rleEncoderList.erase(first);
-          }
-          if (result.good()) result = EC_CannotChangeRepresentation;
+          const Uint32 rleSize = job.finishFrame(f);
+          result = pixelSequence->storeCompressedFrame(offsetList, job.frameBuffer(f), rleSize, djcp->getFragmentSize());
+          compressedSize += rleSize;
         }
-
+        currentFrame += framesInRun;
       }
-
     }
 
     // store pixel sequence if everything went well.
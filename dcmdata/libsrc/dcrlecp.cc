@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -27,13 +27,15 @@ DcmRLECodecParameter::DcmRLECodecParameter(
     Uint32 pFragmentSize,
     OFBool pCreateOffsetTable,
     OFBool pConvertToSC,
-    OFBool pReverseDecompressionByteOrder)
+    OFBool pReverseDecompressionByteOrder,
+    Uint32 pNumberOfThreads)
 : DcmCodecParameter()
 , fragmentSize(pFragmentSize)
 , createOffsetTable(pCreateOffsetTable)
 , convertToSC(pConvertToSC)
 , createInstanceUID(pCreateSOPInstanceUID)
 , reverseDecompressionByteOrder(pReverseDecompressionByteOrder)
+, numberOfThreads(pNumberOfThreads)
 {
 }
 
@@ -45,6 +47,7 @@ DcmRLECodecParameter::DcmRLECodecParameter(const DcmRLECodecParameter& arg)
 , convertToSC(arg.convertToSC)
 , createInstanceUID(arg.createInstanceUID)
 , reverseDecompressionByteOrder(arg.reverseDecompressionByteOrder)
+, numberOfThreads(arg.numberOfThreads)
 {
 }
 
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -33,14 +33,16 @@ DcmRLECodecDecoder *DcmRLEDecoderRegistration::codec          = NULL;
 
 void DcmRLEDecoderRegistration::registerCodecs(
     OFBool pCreateSOPInstanceUID,
-    OFBool pReverseDecompressionByteOrder)
+    OFBool pReverseDecompressionByteOrder,
+    Uint32 pNumberOfThreads)
 {
   if (! registered)
   {
     cp = new DcmRLECodecParameter(
       pCreateSOPInstanceUID,
       0, OFTrue, OFFalse,
-      pReverseDecompressionByteOrder);
+      pReverseDecompressionByteOrder,
+      pNumberOfThreads);
       
     if (cp)
     {
@@ -0,0 +1,276 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: RLE compressor and decompressor for complete stripes
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/dcmdata/dcrlesc.h"
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
+/* use vector instructions for searching runs of identical bytes if they are
+ * available on the target platform (SSE2 is part of the x86-64 instruction set).
+ * On ARM, the horizontal minimum and maximum instructions are only available
+ * in the ARMv8 (AArch64) instruction set.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DCMTK_RLE_WITH_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define DCMTK_RLE_WITH_NEON
+#include <arm_neon.h>
+#endif
+
+/* size of a vector register in bytes */
+#define DCMTK_RLE_BLOCK_SIZE 16
+
+/* maximum number of bytes in a literal or replicate run */
+#define DCMTK_RLE_MAX_RUN 128
+
+
+size_t DcmRLEStripeCodec::getMaxEncodedSize(const Uint16 columns,
+                                            const Uint16 rows)
+{
+    // in the worst case, each row consists of literal runs of 128 bytes,
+    // each of which requires one additional control byte.  Add one pad byte.
+    const size_t bytesPerRow = columns + (columns + DCMTK_RLE_MAX_RUN - 1) / DCMTK_RLE_MAX_RUN;
+    return bytesPerRow * rows + 1;
+}
+
+
+size_t DcmRLEStripeCodec::encodeStripe(const Uint8 *pixelData,
+                                       const size_t pixelStride,
+                                       const Uint16 columns,
+                                       const Uint16 rows,
+                                       Uint8 *target,
+                                       Uint8 *rowBuffer)
+{
+    Uint8 *current = target;
+    const Uint8 *pixel = pixelData;
+    for (Uint16 row = 0; row < rows; ++row)
+    {
+        // enforce DICOM rule that "Each row of the image shall be encoded
+        // separately and not cross a row boundary."
+        // (see DICOM part 5 section G.3.1)
+        if (pixelStride == 1)
+        {
+            current = encodeRow(pixel, columns, current);
+            pixel += columns;
+        } else {
+            // collect the bytes of this row first
+            for (Uint16 column = 0; column < columns; ++column)
+            {
+                rowBuffer[column] = *pixel;
+                pixel += pixelStride;
+            }
+            current = encodeRow(rowBuffer, columns, current);
+        }
+    }
+    size_t size = current - target;
+    // pad to even number of bytes if necessary
+    if (size & 1)
+        target[size++] = 0;
+    return size;
+}
+
+
+size_t DcmRLEStripeCodec::decodeStripe(const Uint8 *rleData,
+                                       const size_t rleSize,
+                                       Uint8 *target,
+                                       const size_t pixelStride,
+                                       const size_t numberOfBytes,
+                                       Uint8 *stripeBuffer)
+{
+    Uint8 *output = (pixelStride == 1) ? target : stripeBuffer;
+    const Uint8 *input = rleData;
+    const Uint8 *inputEnd = rleData + rleSize;
+    size_t offset = 0;
+    size_t count;
+    while ((input < inputEnd) && (offset < numberOfBytes))
+    {
+        const Uint8 control = *input++;
+        if (control & 0x80)
+        {
+            // replicate run. The value is missing if the stream ends here.
+            if (input == inputEnd)
+                break;
+            // DICOM packbit scheme uses 257 - nbytes to represent replicate runs
+            count = 257 - control;
+            if (count > numberOfBytes - offset)
+                count = numberOfBytes - offset;
+            memset(output + offset, *input++, count);
+        } else {
+            // literal run, which might be incomplete if the stream ends early
+            count = OFstatic_cast(size_t, control) + 1;
+            if (count > OFstatic_cast(size_t, inputEnd - input))
+                count = inputEnd - input;
+            if (count > numberOfBytes - offset)
+                count = numberOfBytes - offset;
+            memcpy(output + offset, input, count);
+            input += count;
+        }
+        offset += count;
+    }
+    if (pixelStride != 1)
+    {
+        // distribute decompressed bytes into the output image
+        const Uint8 *stripe = stripeBuffer;
+        const Uint8 *stripeEnd = stripeBuffer + offset;
+        while (stripe < stripeEnd)
+        {
+            *target = *stripe++;
+            target += pixelStride;
+        }
+    }
+    return offset;
+}
+
+
+Uint8 *DcmRLEStripeCodec::encodeRow(const Uint8 *row,
+                                    const size_t length,
+                                    Uint8 *target)
+{
+    size_t pos = 0;
+    size_t count;
+    while (pos < length)
+    {
+        // all bytes up to the next run of three or more identical bytes
+        // are stored as literal runs
+        const size_t runStart = findRun(row, pos, length);
+        size_t literalEnd = runStart;
+        // like DcmRLEEncoder, store a pair of identical bytes at the end of
+        // the row as a replicate run, so that the output does not differ
+        if ((runStart == length) && (length - pos >= 2) && (row[length - 1] == row[length - 2]))
+            literalEnd = length - 2;
+        while (pos < literalEnd)
+        {
+            count = literalEnd - pos;
+            if (count > DCMTK_RLE_MAX_RUN)
+                count = DCMTK_RLE_MAX_RUN;
+            *target++ = OFstatic_cast(Uint8, count - 1);
+            memcpy(target, row + pos, count);
+            target += count;
+            pos += count;
+        }
+        if (pos < length)
+        {
+            size_t runLength = (runStart < length) ? getRunLength(row, pos, length) : length - pos;
+            const Uint8 value = row[pos];
+            pos += runLength;
+            // write as many replicate runs as necessary.  DICOM uses 257 - n
+            // for a run of n bytes, i.e. a single remaining byte results in
+            // a literal run with control byte 0.
+            while (runLength > 0)
+            {
+                count = (runLength > DCMTK_RLE_MAX_RUN) ? DCMTK_RLE_MAX_RUN : runLength;
+                *target++ = OFstatic_cast(Uint8, 257 - count);
+                *target++ = value;
+                runLength -= count;
+            }
+        }
+    }
+    return target;
+}
+
+
+size_t DcmRLEStripeCodec::findRun(const Uint8 *data,
+                                  size_t start,
+                                  const size_t length)
+{
+#ifdef DCMTK_RLE_WITH_SSE2
+    // check DCMTK_RLE_BLOCK_SIZE start positions at a time
+    while (start + DCMTK_RLE_BLOCK_SIZE + 2 <= length)
+    {
+        const __m128i v0 = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, data + start));
+        const __m128i v1 = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, data + start + 1));
+        const __m128i v2 = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, data + start + 2));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v0, v1), _mm_cmpeq_epi8(v1, v2)));
+        if (mask != 0)
+        {
+            // the lowest bit set marks the first run
+            while ((mask & 1) == 0)
+            {
+                mask >>= 1;
+                ++start;
+            }
+            return start;
+        }
+        start += DCMTK_RLE_BLOCK_SIZE;
+    }
+#elif defined(DCMTK_RLE_WITH_NEON)
+    // skip blocks of DCMTK_RLE_BLOCK_SIZE start positions without a run,
+    // the exact position within a block is determined below
+    while (start + DCMTK_RLE_BLOCK_SIZE + 2 <= length)
+    {
+        const uint8x16_t v0 = vld1q_u8(data + start);
+        const uint8x16_t v1 = vld1q_u8(data + start + 1);
+        const uint8x16_t v2 = vld1q_u8(data + start + 2);
+        if (vmaxvq_u8(vandq_u8(vceqq_u8(v0, v1), vceqq_u8(v1, v2))) != 0)
+            break;
+        start += DCMTK_RLE_BLOCK_SIZE;
+    }
+#endif
+    while (start + 2 < length)
+    {
+        if ((data[start] == data[start + 1]) && (data[start + 1] == data[start + 2]))
+            return start;
+        ++start;
+    }
+    return length;
+}
+
+
+size_t DcmRLEStripeCodec::getRunLength(const Uint8 *data,
+                                       const size_t start,
+                                       const size_t length)
+{
+    const Uint8 value = data[start];
+    size_t pos = start + 1;
+#ifdef DCMTK_RLE_WITH_SSE2
+    const __m128i v = _mm_set1_epi8(OFstatic_cast(char, value));
+    while (pos + DCMTK_RLE_BLOCK_SIZE <= length)
+    {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(OFreinterpret_cast(const __m128i *, data + pos)), v));
+        if (mask != 0xffff)
+        {
+            // the lowest bit not set marks the end of the run
+            while (mask & 1)
+            {
+                mask >>= 1;
+                ++pos;
+            }
+            return pos - start;
+        }
+        pos += DCMTK_RLE_BLOCK_SIZE;
+    }
+#elif defined(DCMTK_RLE_WITH_NEON)
+    // skip blocks of identical bytes, the end of the run is determined below
+    const uint8x16_t v = vdupq_n_u8(value);
+    while (pos + DCMTK_RLE_BLOCK_SIZE <= length)
+    {
+        if (vminvq_u8(vceqq_u8(vld1q_u8(data + pos), v)) == 0)
+            break;
+        pos += DCMTK_RLE_BLOCK_SIZE;
+    }
+#endif
+    while ((pos < length) && (data[pos] == value))
+        ++pos;
+    return pos - start;
+}
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -53,7 +53,11 @@ DcmSequenceOfItems::DcmSequenceOfItems(
   itemList(new DcmList),
   lastItemComplete(OFTrue),
   fStartPosition(0),
-  readAsUN_(readAsUN)
+  readAsUN_(readAsUN),
+  fLoadItems(NULL),
+  fLoadItemsXfer(EXS_Unknown),
+  fLoadItemsGlenc(EGL_noChange),
+  fLoadItemsMaxReadLength(DCM_MaxReadLength)
 {
 }
 
@@ -66,8 +70,14 @@ DcmSequenceOfItems::DcmSequenceOfItems(const DcmSequenceOfItems &old)
     itemList(new DcmList),
     lastItemComplete(old.lastItemComplete),
     fStartPosition(old.fStartPosition),
-    readAsUN_(old.readAsUN_)
+    readAsUN_(old.readAsUN_),
+    fLoadItems(NULL),
+    fLoadItemsXfer(EXS_Unknown),
+    fLoadItemsGlenc(EGL_noChange),
+    fLoadItemsMaxReadLength(DCM_MaxReadLength)
 {
+    // the items of the original sequence are needed for the copy
+    OFconst_cast(DcmSequenceOfItems *, &old)->loadItems();
     if (!old.itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -90,6 +100,7 @@ DcmSequenceOfItems::~DcmSequenceOfItems()
 {
     itemList->deleteAllElements();
     delete itemList;
+    delete fLoadItems;
 }
 
 
@@ -104,6 +115,10 @@ DcmSequenceOfItems &DcmSequenceOfItems::operator=(const DcmSequenceOfItems &obj)
     lastItemComplete = obj.lastItemComplete;
     fStartPosition = obj.fStartPosition;
     readAsUN_ = obj.readAsUN_;
+    // the items of the original sequence are needed for the copy
+    OFconst_cast(DcmSequenceOfItems &, obj).loadItems();
+    delete fLoadItems;
+    fLoadItems = NULL;
 
     // DcmList has no copy constructor. Need to copy ourselves.
     DcmList *newList = new DcmList;
@@ -252,6 +267,7 @@ void DcmSequenceOfItems::print(STD_NAMESPACE ostream&out,
                                const char *pixelFileName,
                                size_t *pixelCounter)
 {
+    loadItems();
     /* print sequence start line */
     if (flags & DCMTypes::PF_showTreeStructure)
     {
@@ -305,6 +321,7 @@ void DcmSequenceOfItems::print(STD_NAMESPACE ostream&out,
 OFCondition DcmSequenceOfItems::writeXML(STD_NAMESPACE ostream&out,
                                          const size_t flags)
 {
+    loadItems();
     if (flags & DCMTypes::XF_useNativeModel)
     {
         /* use common method from DcmElement to write start tag */
@@ -374,6 +391,7 @@ OFCondition DcmSequenceOfItems::writeXML(STD_NAMESPACE ostream&out,
 OFBool DcmSequenceOfItems::canWriteXfer(const E_TransferSyntax newXfer,
                                         const E_TransferSyntax oldXfer)
 {
+    loadItems();
     OFBool canWrite = OFTrue;
 
     if (newXfer == EXS_Unknown)
@@ -420,6 +438,7 @@ Uint32 DcmSequenceOfItems::calcElementLength(const E_TransferSyntax xfer,
 Uint32 DcmSequenceOfItems::getLength(const E_TransferSyntax xfer,
                                      const E_EncodingType enctype)
 {
+    loadItems();
     Uint32 seqlen = 0;
     Uint32 sublen = 0;
     if (!itemList->empty())
@@ -467,6 +486,7 @@ OFCondition DcmSequenceOfItems::computeGroupLengthAndPadding(const E_GrpLenEncod
                                                              const Uint32 subPadlen,
                                                              Uint32 instanceLength)
 {
+    loadItems();
     OFCondition l_error = EC_Normal;
 
     if (!itemList->empty())
@@ -656,63 +676,23 @@ OFCondition DcmSequenceOfItems::read(DcmInputStream &inStream,
             errorFlag = EC_EndOfStream;
         else if (errorFlag.good() && (getTransferState() != ERW_ready))
         {
-            if (getTransferState() == ERW_init)
-            {
-                fStartPosition = inStream.tell();   // Position Sequence-Value
-                setTransferState(ERW_inWork);
-            }
-
             E_TransferSyntax readxfer = readAsUN_ ? EXS_LittleEndianImplicit : xfer;
 
-            itemList->seek(ELP_last); // append data at end
-            while (inStream.good() && ((getTransferredBytes() < getLengthField()) || !lastItemComplete))
+            if (getTransferState() == ERW_init)
             {
-                DcmTag newTag;
-                Uint32 newValueLength = 0;
-
-                if (lastItemComplete)
-                {
-                    if (inStream.eos())
-                    {
-                        DCMDATA_WARN("DcmSequenceOfItems: Reached end of stream before the end of sequence "
-                                << getTagName() << " " << getTag());
-                        if (dcmIgnoreParsingErrors.get())
-                        {
-                            /* "Invent" a SequenceDelimitationItem.
-                             * This will be turned into EC_Normal below. */
-                            errorFlag = EC_SequEnd;
-                        }
-                        else
-                            errorFlag = EC_SequDelimitationItemMissing;
-                        break;
-                    }
-
-                    errorFlag = readTagAndLength(inStream, readxfer, newTag, newValueLength);
-
-                    if (errorFlag.bad())
-                        break;                  // finish while loop
-                    else
-                        incTransferredBytes(8);
-
-                    lastItemComplete = OFFalse;
-                    errorFlag = readSubItem(inStream, newTag, newValueLength, readxfer, glenc, maxReadLength);
-                    if (errorFlag.good())
-                        lastItemComplete = OFTrue;
-                }
-                else
+                /* in lazy parsing mode, try to skip the items and read them later */
+                if (dcmLazySequenceParsing.get() && (ident() == EVR_SQ) &&
+                    skipItems(inStream, readxfer, glenc, maxReadLength))
                 {
-                    errorFlag = itemList->get()->read(inStream, readxfer, glenc, maxReadLength);
-                    if (errorFlag.good())
-                        lastItemComplete = OFTrue;
+                    DCMDATA_TRACE("DcmSequenceOfItems::read() items of sequence " << getTag() << " will be read later");
+                    setTransferState(ERW_ready);
+                } else {
+                    fStartPosition = inStream.tell();   // Position Sequence-Value
+                    setTransferState(ERW_inWork);
                 }
-                setTransferredBytes(OFstatic_cast(Uint32, inStream.tell() - fStartPosition));
-
-                if (errorFlag.bad())
-                    break;
-
-            } //while
-            if (((getTransferredBytes() < getLengthField()) || !lastItemComplete) && errorFlag.good())
-                errorFlag = EC_StreamNotifyClient;
+            }
+            if (getTransferState() == ERW_inWork)
+                errorFlag = readItems(inStream, readxfer, glenc, maxReadLength);
         } // else errorFlag
 
         if (errorFlag == EC_SequEnd)
@@ -726,6 +706,242 @@ OFCondition DcmSequenceOfItems::read(DcmInputStream &inStream,
 }
 
 
+OFCondition DcmSequenceOfItems::readItems(DcmInputStream &inStream,
+                                          const E_TransferSyntax xfer,
+                                          const E_GrpLenEncoding glenc,
+                                          const Uint32 maxReadLength)
+{
+    itemList->seek(ELP_last); // append data at end
+    while (inStream.good() && ((getTransferredBytes() < getLengthField()) || !lastItemComplete))
+    {
+        DcmTag newTag;
+        Uint32 newValueLength = 0;
+
+        if (lastItemComplete)
+        {
+            if (inStream.eos())
+            {
+                DCMDATA_WARN("DcmSequenceOfItems: Reached end of stream before the end of sequence "
+                        << getTagName() << " " << getTag());
+                if (dcmIgnoreParsingErrors.get())
+                {
+                    /* "Invent" a SequenceDelimitationItem.
+                     * This will be turned into EC_Normal below. */
+                    errorFlag = EC_SequEnd;
+                }
+                else
+                    errorFlag = EC_SequDelimitationItemMissing;
+                break;
+            }
+
+            errorFlag = readTagAndLength(inStream, xfer, newTag, newValueLength);
+
+            if (errorFlag.bad())
+                break;                  // finish while loop
+            else
+                incTransferredBytes(8);
+
+            lastItemComplete = OFFalse;
+            errorFlag = readSubItem(inStream, newTag, newValueLength, xfer, glenc, maxReadLength);
+            if (errorFlag.good())
+                lastItemComplete = OFTrue;
+        }
+        else
+        {
+            errorFlag = itemList->get()->read(inStream, xfer, glenc, maxReadLength);
+            if (errorFlag.good())
+                lastItemComplete = OFTrue;
+        }
+        setTransferredBytes(OFstatic_cast(Uint32, inStream.tell() - fStartPosition));
+
+        if (errorFlag.bad())
+            break;
+
+    } //while
+    if (((getTransferredBytes() < getLengthField()) || !lastItemComplete) && errorFlag.good())
+        errorFlag = EC_StreamNotifyClient;
+    return errorFlag;
+}
+
+
+// ********************************
+
+
+/* helper function for skipItems(). Reads the tag and length of the next data
+ * element or item from the given stream without any interpretation of the value.
+ * Returns OFFalse if the tag and length cannot be determined unambiguously.
+ */
+static OFBool scanTagAndLength(DcmInputStream &inStream,
+                               const DcmXfer &xferSyn,
+                               DcmTagKey &tag,
+                               DcmEVR &evr,
+                               Uint32 &length)
+{
+    const E_ByteOrder byteOrder = xferSyn.getByteOrder();
+    Uint16 groupTag = 0xffff;
+    Uint16 elementTag = 0xffff;
+    if (inStream.eos() || (inStream.read(&groupTag, 2) != 2) || (inStream.read(&elementTag, 2) != 2))
+        return OFFalse;
+    swapIfNecessary(gLocalByteOrder, byteOrder, &groupTag, 2, 2);
+    swapIfNecessary(gLocalByteOrder, byteOrder, &elementTag, 2, 2);
+    tag.set(groupTag, elementTag);
+    evr = EVR_UNKNOWN;
+    /* items and delimitation items never have a VR and a 4 byte length field */
+    if (xferSyn.isExplicitVR() && (groupTag != 0xfffe))
+    {
+        char vrstr[3];
+        vrstr[2] = '\0';
+        if (inStream.read(vrstr, 2) != 2)
+            return OFFalse;
+        DcmVR vr(vrstr);
+        /* non-standard VRs are handled in different ways by the parser */
+        if (!vr.isStandard())
+            return OFFalse;
+        evr = vr.getEVR();
+        if (!vr.usesExtendedLengthEncoding())
+        {
+            Uint16 valueLength = 0;
+            if (inStream.read(&valueLength, 2) != 2)
+                return OFFalse;
+            swapIfNecessary(gLocalByteOrder, byteOrder, &valueLength, 2, 2);
+            length = valueLength;
+            return OFTrue;
+        }
+        /* skip the reserved field */
+        if (inStream.skip(2) != 2)
+            return OFFalse;
+    }
+    Uint32 valueLength = 0;
+    if (inStream.read(&valueLength, 4) != 4)
+        return OFFalse;
+    swapIfNecessary(gLocalByteOrder, byteOrder, &valueLength, 4, 4);
+    length = valueLength;
+    return OFTrue;
+}
+
+
+/* helper function for skipItems(). Skips all data elements and items in the
+ * given stream up to and including the next delimitation item that ends a
+ * sequence, item or encapsulated value with undefined length.
+ * Returns OFFalse if the end cannot be determined unambiguously.
+ */
+static OFBool scanUndefinedLengthValue(DcmInputStream &inStream,
+                                       const E_TransferSyntax xfer)
+{
+    DcmXfer xferSyn(xfer);
+    DcmTagKey tag;
+    DcmEVR evr = EVR_UNKNOWN;
+    Uint32 length = 0;
+    while (scanTagAndLength(inStream, xferSyn, tag, evr, length))
+    {
+        if ((tag == DCM_SequenceDelimitationItem) || (tag == DCM_ItemDelimitationItem))
+            return OFTrue;
+        if (length == DCM_UndefinedLength)
+        {
+            /* the value of an UN element with undefined length is encoded in
+             * Implicit VR Little Endian (see CP-246) */
+            const E_TransferSyntax subXfer = ((evr == EVR_UN) && dcmEnableCP246Support.get()) ? EXS_LittleEndianImplicit : xfer;
+            if (!scanUndefinedLengthValue(inStream, subXfer))
+                return OFFalse;
+        }
+        else if (OFstatic_cast(Uint32, inStream.skip(length)) != length)
+            return OFFalse;
+    }
+    return OFFalse;
+}
+
+
+OFBool DcmSequenceOfItems::skipItems(DcmInputStream &inStream,
+                                     const E_TransferSyntax xfer,
+                                     const E_GrpLenEncoding glenc,
+                                     const Uint32 maxReadLength)
+{
+    /* nothing to be gained for empty sequences */
+    if (getLengthField() == 0)
+        return OFFalse;
+    /* these flags change the way the length of an element is determined */
+    if (dcmPreferVRFromDataDictionary.get() || dcmPreferLengthFieldSizeFromDataDictionary.get())
+        return OFFalse;
+    /* a stream factory is needed for reading the items later */
+    DcmInputStreamFactory *factory = inStream.newFactory();
+    if (factory == NULL)
+        return OFFalse;
+    /* determine the end of the sequence on a separate stream first, so that */
+    /* the items can still be parsed conventionally if this is not possible */
+    OFBool result = OFFalse;
+    offile_off_t valueLength = 0;
+    DcmInputStream *scanStream = factory->create();
+    if (scanStream && scanStream->good())
+    {
+        const offile_off_t scanStart = scanStream->tell();
+        if (getLengthField() == DCM_UndefinedLength)
+            result = scanUndefinedLengthValue(*scanStream, xfer);
+        else
+            result = (scanStream->skip(getLengthField()) == OFstatic_cast(offile_off_t, getLengthField()));
+        valueLength = scanStream->tell() - scanStart;
+    }
+    delete scanStream;
+    if (result && (inStream.skip(valueLength) == valueLength))
+    {
+        itemList->deleteAllElements();
+        delete fLoadItems;
+        fLoadItems = factory;
+        fLoadItemsXfer = xfer;
+        fLoadItemsGlenc = glenc;
+        fLoadItemsMaxReadLength = maxReadLength;
+        setTransferredBytes(OFstatic_cast(Uint32, valueLength));
+    } else {
+        DCMDATA_DEBUG("DcmSequenceOfItems::skipItems() cannot determine end of sequence "
+            << getTagName() << " " << getTag() << ", parsing items immediately");
+        delete factory;
+        result = OFFalse;
+    }
+    return result;
+}
+
+
+OFCondition DcmSequenceOfItems::loadItems()
+{
+    OFCondition l_error = EC_Normal;
+    if (fLoadItems != NULL)
+    {
+        DcmInputStream *readStream = fLoadItems->create();
+        /* the items are read only once, even if an error occurs */
+        delete fLoadItems;
+        fLoadItems = NULL;
+        if (readStream == NULL)
+            l_error = EC_InvalidStream;
+        else
+            l_error = readStream->status();
+        if (l_error.good())
+        {
+            DCMDATA_TRACE("DcmSequenceOfItems::loadItems() reading items of sequence " << getTag());
+            const E_TransferState oldState = getTransferState();
+            fStartPosition = readStream->tell();
+            lastItemComplete = OFTrue;
+            setTransferredBytes(0);
+            setTransferState(ERW_inWork);
+            l_error = readItems(*readStream, fLoadItemsXfer, fLoadItemsGlenc, fLoadItemsMaxReadLength);
+            if (l_error == EC_SequEnd)
+                l_error = EC_Normal;
+            /* restore the transfer state, e.g. if this sequence is about to be written */
+            if (oldState == ERW_init)
+                transferInit();
+            else
+                setTransferState(oldState);
+        }
+        delete readStream;
+        if (l_error.bad())
+        {
+            DCMDATA_ERROR("DcmSequenceOfItems: Cannot read items of sequence " << getTagName()
+                << " " << getTag() << " from file: " << l_error.text());
+        }
+        errorFlag = l_error;
+    }
+    return l_error;
+}
+
+
 // ********************************
 
 OFCondition DcmSequenceOfItems::write(DcmOutputStream &outStream,
@@ -733,6 +949,7 @@ OFCondition DcmSequenceOfItems::write(DcmOutputStream &outStream,
                                       const E_EncodingType enctype,
                                       DcmWriteCache *wcache)
 {
+    loadItems();
   if (getTransferState() == ERW_notInitialized)
         errorFlag = EC_IllegalCall;
     else
@@ -857,6 +1074,7 @@ OFCondition DcmSequenceOfItems::writeSignatureFormat(DcmOutputStream &outStream,
                                                      const E_EncodingType enctype,
                                                      DcmWriteCache *wcache)
 {
+    loadItems();
     if (getTransferState() == ERW_notInitialized)
         errorFlag = EC_IllegalCall;
     else
@@ -963,6 +1181,7 @@ void DcmSequenceOfItems::transferEnd()
 
 unsigned long DcmSequenceOfItems::card() const
 {
+    OFconst_cast(DcmSequenceOfItems *, this)->loadItems();
     return itemList->card();
 }
 
@@ -972,6 +1191,7 @@ unsigned long DcmSequenceOfItems::card() const
 
 OFCondition DcmSequenceOfItems::prepend(DcmItem *item)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -992,6 +1212,7 @@ OFCondition DcmSequenceOfItems::insert(DcmItem *item,
                                        unsigned long where,
                                        OFBool before)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -1027,6 +1248,7 @@ OFCondition DcmSequenceOfItems::insert(DcmItem *item,
 OFCondition DcmSequenceOfItems::insertAtCurrentPos(DcmItem *item,
                                                    OFBool before)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -1052,6 +1274,7 @@ OFCondition DcmSequenceOfItems::insertAtCurrentPos(DcmItem *item,
 
 OFCondition DcmSequenceOfItems::append(DcmItem *item)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -1075,6 +1298,7 @@ OFCondition DcmSequenceOfItems::append(DcmItem *item)
 
 DcmItem* DcmSequenceOfItems::getItem(const unsigned long num)
 {
+    loadItems();
     errorFlag = EC_Normal;
     DcmItem *item;
     item = OFstatic_cast(DcmItem *, itemList->seek_to(num));  // read item from list
@@ -1089,6 +1313,7 @@ DcmItem* DcmSequenceOfItems::getItem(const unsigned long num)
 
 DcmObject *DcmSequenceOfItems::nextInContainer(const DcmObject *obj)
 {
+    loadItems();
     if (!obj)
         return itemList->get(ELP_first);
     else
@@ -1152,6 +1377,7 @@ OFCondition DcmSequenceOfItems::nextObject(DcmStack &stack,
 
 DcmItem *DcmSequenceOfItems::remove(const unsigned long num)
 {
+    loadItems();
     errorFlag = EC_Normal;
     DcmItem *item;
     item = OFstatic_cast(DcmItem *, itemList->seek_to(num));  // read item from list
@@ -1170,6 +1396,7 @@ DcmItem *DcmSequenceOfItems::remove(const unsigned long num)
 
 DcmItem *DcmSequenceOfItems::remove(DcmItem *item)
 {
+    loadItems();
     DcmItem *retItem = NULL;
     errorFlag = EC_IllegalCall;
     if (!itemList->empty() && (item != NULL))
@@ -1201,6 +1428,9 @@ DcmItem *DcmSequenceOfItems::remove(DcmItem *item)
 OFCondition DcmSequenceOfItems::clear()
 {
     errorFlag = EC_Normal;
+    // items that have not been read yet are simply discarded
+    delete fLoadItems;
+    fLoadItems = NULL;
     // remove all items from sequence and delete them from memory
     itemList->deleteAllElements();
     setLengthField(0);
@@ -1210,6 +1440,7 @@ OFCondition DcmSequenceOfItems::clear()
 
 OFBool DcmSequenceOfItems::isEmpty(const OFBool /*normalize*/)
 {
+    loadItems();
     return itemList->empty();
 }
 
@@ -1219,6 +1450,7 @@ OFBool DcmSequenceOfItems::isEmpty(const OFBool /*normalize*/)
 
 OFCondition DcmSequenceOfItems::verify(const OFBool autocorrect)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (!itemList->empty())
     {
@@ -1286,6 +1518,7 @@ OFCondition DcmSequenceOfItems::search(const DcmTagKey &tag,
                                        E_SearchMode mode,
                                        OFBool searchIntoSub)
 {
+    loadItems();
     DcmObject *dO = NULL;
     OFCondition l_error = EC_TagNotFound;
     if ((mode == ESM_afterStackTop) && (resultStack.top() == this))
@@ -1378,7 +1611,7 @@ OFCondition DcmSequenceOfItems::search(const DcmTagKey &tag,
 
 OFCondition DcmSequenceOfItems::loadAllDataIntoMemory()
 {
-    OFCondition l_error = EC_Normal;
+    OFCondition l_error = loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -1406,6 +1639,7 @@ OFBool DcmSequenceOfItems::isSignable() const
 
 OFBool DcmSequenceOfItems::containsUnknownVR() const
 {
+    OFconst_cast(DcmSequenceOfItems *, this)->loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -1420,6 +1654,7 @@ OFBool DcmSequenceOfItems::containsUnknownVR() const
 
 OFBool DcmSequenceOfItems::containsExtendedCharacters(const OFBool checkAllStrings)
 {
+    loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -1434,6 +1669,7 @@ OFBool DcmSequenceOfItems::containsExtendedCharacters(const OFBool checkAllStrin
 
 OFBool DcmSequenceOfItems::isAffectedBySpecificCharacterSet() const
 {
+    OFconst_cast(DcmSequenceOfItems *, this)->loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -1448,6 +1684,7 @@ OFBool DcmSequenceOfItems::isAffectedBySpecificCharacterSet() const
 
 OFCondition DcmSequenceOfItems::convertCharacterSet(DcmSpecificCharacterSet &converter)
 {
+    loadItems();
     OFCondition status = EC_Normal;
     if (!itemList->empty())
     {
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -22,6 +22,99 @@
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 #include "dcmtk/dcmdata/dcswap.h"
 
+/* use vector instructions for swapping larger blocks of 2, 4 or 8 byte values
+ * if they are available on the target platform (SSE2 is part of the x86-64
+ * instruction set, NEON of the ARMv8 instruction set)
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DCMTK_SWAP_WITH_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DCMTK_SWAP_WITH_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(DCMTK_SWAP_WITH_SSE2) || defined(DCMTK_SWAP_WITH_NEON)
+
+/* size of a vector register in bytes */
+#define DCMTK_SWAP_BLOCK_SIZE 16
+
+static Uint32 swapBlocks(Uint8 *value, const Uint32 byteLength,
+                         const size_t valWidth)
+    /*
+     * This function swaps all complete blocks of DCMTK_SWAP_BLOCK_SIZE bytes in value
+     * using vector instructions. The remaining bytes (if any) are not touched.
+     *
+     * Parameters:
+     *   value        - [in] Array that contains the bytes to be swapped (no alignment required).
+     *   byteLength   - [in] Length of the above array.
+     *   valWidth     - [in] Number of bytes treated together as one element (2, 4 or 8).
+     *
+     * Return value:
+     *   Number of bytes that have been swapped (multiple of DCMTK_SWAP_BLOCK_SIZE).
+     */
+{
+    const Uint32 swapLength = byteLength - (byteLength % DCMTK_SWAP_BLOCK_SIZE);
+    Uint8 *end = value + swapLength;
+#ifdef DCMTK_SWAP_WITH_SSE2
+    __m128i v;
+    if (valWidth == 2)
+    {
+        for (; value < end; value += DCMTK_SWAP_BLOCK_SIZE)
+        {
+            v = _mm_loadu_si128(OFreinterpret_cast(__m128i *, value));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            _mm_storeu_si128(OFreinterpret_cast(__m128i *, value), v);
+        }
+    }
+    else if (valWidth == 4)
+    {
+        for (; value < end; value += DCMTK_SWAP_BLOCK_SIZE)
+        {
+            /* first swap the two 16-bit words of each value, then the bytes of each word */
+            v = _mm_loadu_si128(OFreinterpret_cast(__m128i *, value));
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            _mm_storeu_si128(OFreinterpret_cast(__m128i *, value), v);
+        }
+    }
+    else if (valWidth == 8)
+    {
+        for (; value < end; value += DCMTK_SWAP_BLOCK_SIZE)
+        {
+            /* first reverse the order of the four 16-bit words of each value, then swap the bytes of each word */
+            v = _mm_loadu_si128(OFreinterpret_cast(__m128i *, value));
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            _mm_storeu_si128(OFreinterpret_cast(__m128i *, value), v);
+        }
+    }
+    else
+        return 0;
+#else /* DCMTK_SWAP_WITH_NEON */
+    if (valWidth == 2)
+    {
+        for (; value < end; value += DCMTK_SWAP_BLOCK_SIZE)
+            vst1q_u8(value, vrev16q_u8(vld1q_u8(value)));
+    }
+    else if (valWidth == 4)
+    {
+        for (; value < end; value += DCMTK_SWAP_BLOCK_SIZE)
+            vst1q_u8(value, vrev32q_u8(vld1q_u8(value)));
+    }
+    else if (valWidth == 8)
+    {
+        for (; value < end; value += DCMTK_SWAP_BLOCK_SIZE)
+            vst1q_u8(value, vrev64q_u8(vld1q_u8(value)));
+    }
+    else
+        return 0;
+#endif
+    return swapLength;
+}
+
+#endif
+
 OFCondition swapIfNecessary(const E_ByteOrder newByteOrder,
                             const E_ByteOrder oldByteOrder,
                             void * value, const Uint32 byteLength,
@@ -81,13 +174,22 @@ void swapBytes(void * value, const Uint32 byteLength,
 {
     /* use register (if available) to increase speed */
     register Uint8 save;
+    Uint8 *data = OFstatic_cast(Uint8 *, value);
+    Uint32 length = byteLength;
+
+#if defined(DCMTK_SWAP_WITH_SSE2) || defined(DCMTK_SWAP_WITH_NEON)
+    /* swap as many bytes as possible using vector instructions, the rest is swapped below */
+    const Uint32 swapped = swapBlocks(data, length, valWidth);
+    data += swapped;
+    length -= swapped;
+#endif
 
     /* in case valWidth equals 2, swap correspondingly */
     if (valWidth == 2)
     {
-        register Uint8 *first = &OFstatic_cast(Uint8*, value)[0];
-        register Uint8 *second = &OFstatic_cast(Uint8*, value)[1];
-        register Uint32 times = byteLength / 2;
+        register Uint8 *first = &data[0];
+        register Uint8 *second = &data[1];
+        register Uint32 times = length / 2;
         while(times--)
         {
             save = *first;
@@ -106,8 +208,8 @@ void swapBytes(void * value, const Uint32 byteLength,
         register Uint8 *start;
         register Uint8 *end;
 
-        Uint32 times = OFstatic_cast(Uint32, byteLength / valWidth);
-        Uint8  *base = OFstatic_cast(Uint8 *, value);
+        Uint32 times = OFstatic_cast(Uint32, length / valWidth);
+        Uint8  *base = data;
 
         while (times--)
         {
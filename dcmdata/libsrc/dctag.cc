@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -122,14 +122,13 @@ DcmTag& DcmTag::operator=(const DcmTag& tag)
 
 void DcmTag::lookupVRinDictionary()
 {
-    const DcmDataDictionary& globalDataDict = dcmDataDict.rdlock();
-    const DcmDictEntry *dictRef = globalDataDict.findEntry(*this, privateCreator);
+    /* lock-free lookup in the current index of the global data dictionary */
+    const DcmDictEntry *dictRef = dcmDataDict.findEntry(*this, privateCreator);
     if (dictRef)
     {
         vr = dictRef->getVR();
         errorFlag = EC_Normal;
     }
-    dcmDataDict.unlock();
 }
 
 // ********************************
@@ -155,14 +154,12 @@ const char *DcmTag::getTagName()
         return tagName;
 
     const char *newTagName = NULL;
-    const DcmDataDictionary& globalDataDict = dcmDataDict.rdlock();
-    const DcmDictEntry *dictRef = globalDataDict.findEntry(*this, privateCreator);
+    const DcmDictEntry *dictRef = dcmDataDict.findEntry(*this, privateCreator);
     if (dictRef)
         newTagName=dictRef->getTagName();
     if (newTagName == NULL)
         newTagName = DcmTag_ERROR_TagName;
     updateTagName(newTagName);
-    dcmDataDict.unlock();
 
     if (tagName)
         return tagName;
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -320,6 +320,16 @@ void DcmOtherByteOtherWord::postLoadValue()
 // ********************************
 
 
+OFBool DcmOtherByteOtherWord::valueRemainsAfterWrite() const
+{
+    /* the value is removed from memory by compact() once it has been written */
+    return !compactAfterTransfer;
+}
+
+
+// ********************************
+
+
 OFCondition DcmOtherByteOtherWord::putUint8Array(const Uint8 *byteValue,
                                                  const unsigned long numBytes)
 {
@@ -0,0 +1,144 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the arena allocator
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcarena.h"
+
+#define NUM_ITEMS 100
+
+
+OFTEST(dcmdata_arenaAllocator)
+{
+    DcmArena *arena = DcmArena::newInstance(1024, 64);
+    DcmItem *item = NULL;
+    DcmElement *elem = NULL;
+    OFString str;
+    {
+        // all objects created in this scope are allocated from the arena
+        DcmArenaScope scope(arena);
+        item = new DcmItem();
+        OFCHECK(item->putAndInsertString(DCM_PatientName, "Doe^John").good());
+        OFCHECK(item->putAndInsertString(DCM_PatientID, "12345").good());
+        {
+            // objects created in this scope are allocated from the heap
+            DcmArenaScope noArena(NULL);
+            elem = new DcmLongString(DCM_StudyDescription);
+        }
+    }
+    // item, two elements, two list nodes and two values
+    OFCHECK_EQUAL(arena->numberOfObjects(), 7);
+    OFCHECK(elem->putString("some description").good());
+    OFCHECK(item->insert(elem).good());
+    OFCHECK_EQUAL(arena->numberOfObjects(), 7);
+    // values allocated from the arena cannot be detached
+    OFCHECK(item->findAndGetElement(DCM_PatientID, elem).good());
+    OFCHECK(elem->detachValueField(OFTrue) == EC_IllegalCall);
+    // but they can be replaced (by values on the heap)
+    OFCHECK(elem->putString("67890").good());
+    OFCHECK_EQUAL(arena->numberOfObjects(), 6);
+    OFCHECK(item->findAndGetOFString(DCM_PatientID, str).good());
+    OFCHECK_EQUAL(str, "67890");
+    // the arena is only deleted after the last object
+    arena->release();
+    OFCHECK(item->findAndGetOFString(DCM_PatientName, str).good());
+    OFCHECK_EQUAL(str, "Doe^John");
+    delete item;
+
+    // read a dataset with the arena allocator enabled
+    DcmFileFormat dfile;
+    DcmDataset *dset = dfile.getDataset();
+    OFCHECK(dset->putAndInsertString(DCM_PatientName, "Doe^Jane").good());
+    for (Uint16 i = 0; i < NUM_ITEMS; i++)
+    {
+        DcmItem *newItem = NULL;
+        OFCHECK(dset->findOrCreateSequenceItem(DCM_ReferencedImageSequence, newItem, -2).good());
+        if (newItem != NULL)
+        {
+            OFCHECK(newItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_SecondaryCaptureImageStorage).good());
+            OFCHECK(newItem->putAndInsertUint16(DCM_ReferencedSegmentNumber, i).good());
+        }
+    }
+    OFCHECK(dfile.saveFile("test_arena.dcm", EXS_LittleEndianExplicit).good());
+    dcmUseArenaAllocation.set(OFTrue);
+    OFCHECK(dfile.loadFile("test_arena.dcm").good());
+    dcmUseArenaAllocation.set(OFFalse);
+    OFCHECK(dset->findAndGetOFString(DCM_PatientName, str).good());
+    OFCHECK_EQUAL(str, "Doe^Jane");
+    DcmItem *lastItem = NULL;
+    OFCHECK(dset->findAndGetSequenceItem(DCM_ReferencedImageSequence, lastItem, -1).good());
+    if (lastItem != NULL)
+    {
+        OFCHECK(lastItem->findAndGetOFString(DCM_ReferencedSOPClassUID, str).good());
+        OFCHECK_EQUAL(str, UID_SecondaryCaptureImageStorage);
+        // remove an item from the dataset and delete it after the dataset
+        DcmSequenceOfItems *sequence = NULL;
+        OFCHECK(dset->findAndGetSequence(DCM_ReferencedImageSequence, sequence).good());
+        if (sequence != NULL)
+        {
+            OFCHECK_EQUAL(sequence->card(), NUM_ITEMS);
+            OFCHECK_EQUAL(sequence->remove(lastItem), lastItem);
+        }
+    }
+    OFCHECK(dfile.clear().good());
+    if (lastItem != NULL)
+    {
+        OFCHECK(lastItem->findAndGetOFString(DCM_ReferencedSOPClassUID, str).good());
+        OFCHECK_EQUAL(str, UID_SecondaryCaptureImageStorage);
+        delete lastItem;
+    }
+    OFStandard::deleteFile("test_arena.dcm");
+}
+
+
+OFTEST(dcmdata_arenaAllocatorPlacementAndNothrow)
+{
+#ifdef HAVE_STD__NOTHROW
+    // non-throwing allocation from the heap
+    DcmDataset *dset = new (std::nothrow) DcmDataset();
+    OFCHECK(dset != NULL);
+    if (dset != NULL)
+    {
+        OFCHECK(dset->putAndInsertString(DCM_PatientName, "Doe^John").good());
+        delete dset;
+    }
+    // non-throwing allocation from an arena
+    DcmArena *arena = DcmArena::newInstance();
+    {
+        DcmArenaScope scope(arena);
+        dset = new (std::nothrow) DcmDataset();
+    }
+    OFCHECK(dset != NULL);
+    OFCHECK_EQUAL(arena->numberOfObjects(), 1);
+    arena->release();
+    delete dset;
+#endif
+    // placement new does not use the arena
+    void *buffer = ::operator new(sizeof(DcmLongString));
+    DcmLongString *elem = new (buffer) DcmLongString(DCM_StudyDescription);
+    OFCHECK(elem->putString("some description").good());
+    OFCHECK_EQUAL(elem->getLength(), 16);
+    elem->~DcmLongString();
+    ::operator delete(buffer);
+}
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2011, OFFIS e.V.
+ *  Copyright (C) 2011-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -106,3 +106,70 @@ OFTEST(dcmdata_usingDataDictionary)
 
 #undef checkDictionary
 }
+
+OFTEST(dcmdata_globalDataDictionaryIndex)
+{
+    // The lock-free lookup must give the same results as the locked one
+    const DcmTagKey keys[] = {
+        DcmTagKey(0x0010, 0x0010), DcmTagKey(0x7fe0, 0x0010), DcmTagKey(0x6002, 0x3000),
+        DcmTagKey(0x0029, 0x1010), DcmTagKey(0x0009, 0x0010), DcmTagKey(0xfffe, 0xe000)
+    };
+    const char *creators[] = { NULL, "SIEMENS CSA HEADER", "TDICT UNKNOWN CREATOR" };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i)
+    {
+        for (size_t j = 0; j < sizeof(creators) / sizeof(creators[0]); ++j)
+        {
+            const DcmDictEntry *indexed = dcmDataDict.findEntry(keys[i], creators[j]);
+            const DcmDictEntry *locked = dcmDataDict.rdlock().findEntry(keys[i], creators[j]);
+            OFCHECK((indexed == NULL) == (locked == NULL));
+            if (indexed && locked)
+            {
+                OFCHECK(indexed->getKey() == locked->getKey());
+                OFCHECK_EQUAL(indexed->getEVR(), locked->getEVR());
+                OFCHECK_EQUAL(OFString(indexed->getTagName()), OFString(locked->getTagName()));
+            }
+            dcmDataDict.unlock();
+        }
+    }
+
+    // Changes of the dictionary are visible after the write lock was released
+    const DcmTagKey key(0x0009, 0x1042);
+    const char *creator = "TDICT TEST CREATOR";
+    OFCHECK(dcmDataDict.findEntry(key, creator) == NULL);
+    DcmDictEntry *entry = new DcmDictEntry(0x0009, 0x0042, DcmVR(EVR_LO), "TDictTestEntry",
+        1, 1, "private", OFTrue, creator);
+    dcmDataDict.wrlock().addEntry(entry);
+    dcmDataDict.unlock();
+    const DcmDictEntry *found = dcmDataDict.findEntry(key, creator);
+    OFCHECK(found != NULL);
+    if (found)
+    {
+        OFCHECK_EQUAL(found->getEVR(), EVR_LO);
+        OFCHECK_EQUAL(OFString(found->getTagName()), "TDictTestEntry");
+    }
+    OFCHECK(dcmDataDict.findEntry(key, NULL) == NULL);
+    // Replacing the entry also replaces it in the index
+    entry = new DcmDictEntry(0x0009, 0x0042, DcmVR(EVR_UT), "TDictTestEntry",
+        1, 1, "private", OFTrue, creator);
+    dcmDataDict.wrlock().addEntry(entry);
+    dcmDataDict.unlock();
+    found = dcmDataDict.findEntry(key, creator);
+    OFCHECK(found != NULL);
+    if (found)
+        OFCHECK_EQUAL(found->getEVR(), EVR_UT);
+    // An entry of the index that has just been replaced remains valid until the next update
+    dcmDataDict.wrlock();
+    dcmDataDict.unlock();
+    if (found)
+        OFCHECK_EQUAL(OFString(found->getTagName()), "TDictTestEntry");
+    // Repeated updates do not affect the lookup (older indexes are deleted)
+    for (int i = 0; i < 10; ++i)
+    {
+        dcmDataDict.wrlock();
+        dcmDataDict.unlock();
+    }
+    found = dcmDataDict.findEntry(key, creator);
+    OFCHECK(found != NULL);
+    if (found)
+        OFCHECK_EQUAL(found->getEVR(), EVR_UT);
+}
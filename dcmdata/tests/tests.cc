@@ -96,9 +96,26 @@ OFTEST_REGISTER(dcmdata_parser_wrongExplicitVRinDataset_preferDataDict);
 OFTEST_REGISTER(dcmdata_parser_undefinedLengthUNSequence);
 OFTEST_REGISTER(dcmdata_readingDataDictionary);
 OFTEST_REGISTER(dcmdata_usingDataDictionary);
+OFTEST_REGISTER(dcmdata_globalDataDictionaryIndex);
 OFTEST_REGISTER(dcmdata_specificCharacterSet_1);
 OFTEST_REGISTER(dcmdata_specificCharacterSet_2);
 OFTEST_REGISTER(dcmdata_specificCharacterSet_3);
 OFTEST_REGISTER(dcmdata_specificCharacterSet_4);
 OFTEST_REGISTER(dcmdata_attribute_filter);
+OFTEST_REGISTER(dcmdata_itemInsertAndSearch);
+OFTEST_REGISTER(dcmdata_memoryMappedFileInput);
+OFTEST_REGISTER(dcmdata_arenaAllocator);
+OFTEST_REGISTER(dcmdata_arenaAllocatorPlacementAndNothrow);
+OFTEST_REGISTER(dcmdata_swapBytes);
+OFTEST_REGISTER(dcmdata_lazySequenceParsing);
+OFTEST_REGISTER(dcmdata_readUntilTag);
+OFTEST_REGISTER(dcmdata_getUncompressedFrames);
+OFTEST_REGISTER(dcmdata_frameIndex);
+OFTEST_REGISTER(dcmdata_rleStripeCodec);
+OFTEST_REGISTER(dcmdata_rleCodecMultipleThreads);
+OFTEST_REGISTER(dcmdata_rleCodecInvalidStripes);
+#if defined(WITH_ZLIB) && defined(WITH_THREADS)
+OFTEST_REGISTER(dcmdata_deflateMultipleThreads);
+OFTEST_REGISTER(dcmdata_deflateMultipleThreadsDeterministic);
+#endif
 OFTEST_MAIN("dcmdata")
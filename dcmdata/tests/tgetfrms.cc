@@ -0,0 +1,222 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for accessing a range of uncompressed frames
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcpxitem.h"
+#include "dcmtk/dcmdata/dcrleerg.h"
+#include "dcmtk/dcmdata/dcrledrg.h"
+
+#define COLUMNS 5
+#define ROWS 3
+#define FRAMES 4
+#define FRAME_SIZE (COLUMNS * ROWS)
+#define SLOT_SIZE (FRAME_SIZE + 1)
+
+
+// check the given frames against the pixel values created by createDataset()
+static OFBool checkFrames(const Uint8 *buffer, Uint32 firstFrame, Uint32 numberOfFrames)
+{
+    OFBool result = OFTrue;
+    for (Uint32 i = 0; i < numberOfFrames; i++)
+    {
+        for (Uint32 j = 0; j < FRAME_SIZE; j++)
+            result &= (buffer[i * SLOT_SIZE + j] == OFstatic_cast(Uint8, (firstFrame + i) * 16 + j));
+    }
+    return result;
+}
+
+
+static void createDataset(DcmDataset &dset)
+{
+    Uint8 pixelData[FRAMES * FRAME_SIZE];
+    for (Uint32 i = 0; i < FRAMES; i++)
+    {
+        for (Uint32 j = 0; j < FRAME_SIZE; j++)
+            pixelData[i * FRAME_SIZE + j] = OFstatic_cast(Uint8, i * 16 + j);
+    }
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_MultiframeGrayscaleByteSecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4.5").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, 1).good());
+    OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2").good());
+    OFCHECK(dset.putAndInsertString(DCM_NumberOfFrames, "4").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, ROWS).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, COLUMNS).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 8).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, 8).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_HighBit, 7).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+    OFCHECK(dset.putAndInsertUint8Array(DCM_PixelData, pixelData, FRAMES * FRAME_SIZE).good());
+}
+
+
+static void checkGetUncompressedFrames(DcmDataset &dset)
+{
+    DcmElement *elem = NULL;
+    OFCHECK(dset.findAndGetElement(DCM_PixelData, elem).good());
+    DcmPixelData *pixelData = OFstatic_cast(DcmPixelData *, elem);
+    if (pixelData == NULL) return;
+
+    Uint8 buffer[FRAMES * SLOT_SIZE];
+    OFString colorModel;
+    Uint32 startFragment = 0;
+    // all frames, each one in a slot of even size
+    OFCHECK(pixelData->getUncompressedFrames(&dset, 0, FRAMES, startFragment, buffer, sizeof(buffer), colorModel).good());
+    OFCHECK(checkFrames(buffer, 0, FRAMES));
+    OFCHECK_EQUAL(colorModel, "MONOCHROME2");
+    // a range in the middle of the image, without knowing the start fragment
+    startFragment = 0;
+    memset(buffer, 0, sizeof(buffer));
+    OFCHECK(pixelData->getUncompressedFrames(&dset, 1, 2, startFragment, buffer, 2 * SLOT_SIZE, colorModel).good());
+    OFCHECK(checkFrames(buffer, 1, 2));
+    // the last frame, continuing with the start fragment returned by the previous call
+    OFCHECK(pixelData->getUncompressedFrames(&dset, 3, 1, startFragment, buffer, SLOT_SIZE, colorModel).good());
+    OFCHECK(checkFrames(buffer, 3, 1));
+    // invalid ranges and buffers
+    startFragment = 0;
+    OFCHECK(pixelData->getUncompressedFrames(&dset, 3, 2, startFragment, buffer, sizeof(buffer), colorModel).bad());
+    OFCHECK(pixelData->getUncompressedFrames(&dset, 4, 1, startFragment, buffer, sizeof(buffer), colorModel).bad());
+    OFCHECK(pixelData->getUncompressedFrames(&dset, 0, 0, startFragment, buffer, sizeof(buffer), colorModel).bad());
+    OFCHECK(pixelData->getUncompressedFrames(&dset, 0, 2, startFragment, buffer, 2 * SLOT_SIZE - 1, colorModel).bad());
+}
+
+
+OFTEST(dcmdata_getUncompressedFrames)
+{
+    // uncompressed pixel data
+    DcmDataset dset;
+    createDataset(dset);
+    checkGetUncompressedFrames(dset);
+
+    // RLE compressed pixel data, decompressed by the default implementation of DcmCodec::decodeFrames()
+    DcmRLEEncoderRegistration::registerCodecs();
+    DcmRLEDecoderRegistration::registerCodecs();
+    OFCHECK(dset.chooseRepresentation(EXS_RLELossless, NULL).good());
+    dset.removeAllButCurrentRepresentations();
+    OFCHECK(dset.hasRepresentation(EXS_RLELossless, NULL));
+    OFCHECK(!dset.hasRepresentation(EXS_LittleEndianExplicit, NULL));
+    checkGetUncompressedFrames(dset);
+    DcmRLEDecoderRegistration::cleanup();
+    DcmRLEEncoderRegistration::cleanup();
+}
+
+
+// append a fragment of the given length that optionally starts with a JPEG SOI marker
+static void appendFragment(DcmPixelSequence &pixSeq, Uint32 length, OFBool frameStart)
+{
+    Uint8 data[16];
+    memset(data, 0x55, sizeof(data));
+    if (frameStart)
+    {
+        data[0] = 0xFF;
+        data[1] = 0xD8;
+        data[2] = 0xFF;
+        data[3] = 0xE0;
+    }
+    DcmPixelItem *item = new DcmPixelItem(DcmTag(DCM_Item, EVR_OB));
+    OFCHECK(item->putUint8Array(data, length).good());
+    OFCHECK(pixSeq.insert(item).good());
+}
+
+
+// check the frame index against the fragments created by createPixelSequence()
+static void checkFrameIndex(DcmPixelSequence &pixSeq)
+{
+    static const Uint32 expected[] = { 1, 3, 6, 8 };
+    Uint32 startFragment = 0;
+    Uint32 endFragment = 0;
+    for (Uint32 frameNo = 0; frameNo < 3; ++frameNo)
+    {
+        OFCHECK(pixSeq.getFrameFragments(frameNo, 3, startFragment, endFragment).good());
+        OFCHECK_EQUAL(startFragment, expected[frameNo]);
+        OFCHECK_EQUAL(endFragment, expected[frameNo + 1]);
+    }
+    OFCHECK(pixSeq.getFrameFragments(3, 3, startFragment, endFragment).bad());
+}
+
+
+// three frames with two, three and two fragments, the last one of odd length
+static void createPixelSequence(DcmPixelSequence &pixSeq, OFBool withMarkers)
+{
+    pixSeq.insert(new DcmPixelItem(DcmTag(DCM_Item, EVR_OB)));
+    appendFragment(pixSeq, 16, withMarkers);
+    appendFragment(pixSeq, 8, OFFalse);
+    appendFragment(pixSeq, 10, withMarkers);
+    appendFragment(pixSeq, 4, OFFalse);
+    appendFragment(pixSeq, 16, OFFalse);
+    appendFragment(pixSeq, 12, withMarkers);
+    appendFragment(pixSeq, 7, OFFalse);
+}
+
+
+OFTEST(dcmdata_frameIndex)
+{
+    // empty offset table, frames are found by their JPEG start markers
+    DcmPixelSequence pixSeq(DcmTag(DCM_PixelData, EVR_OB));
+    createPixelSequence(pixSeq, OFTrue);
+    checkFrameIndex(pixSeq);
+    // the index does not cover a different number of frames
+    Uint32 startFragment = 0;
+    Uint32 endFragment = 0;
+    OFCHECK(pixSeq.getFrameFragments(0, 2, startFragment, endFragment).bad());
+    OFCHECK(pixSeq.getFrameFragments(0, 5, startFragment, endFragment).bad());
+
+    // store the index in the offset table
+    OFCHECK(pixSeq.storeFrameIndex(3).good());
+    DcmPixelItem *offsetTable = NULL;
+    Uint8 *offsets = NULL;
+    OFCHECK(pixSeq.getItem(offsetTable, 0).good());
+    OFCHECK(offsetTable->getUint8Array(offsets).good());
+    OFCHECK_EQUAL(offsetTable->getLength(), 12);
+    if ((offsets != NULL) && (offsetTable->getLength() == 12))
+    {
+        // offsets are stored in little endian byte order
+        OFCHECK((offsets[0] == 0) && (offsets[1] == 0) && (offsets[2] == 0) && (offsets[3] == 0));
+        OFCHECK((offsets[4] == 40) && (offsets[5] == 0) && (offsets[6] == 0) && (offsets[7] == 0));
+        OFCHECK((offsets[8] == 94) && (offsets[9] == 0) && (offsets[10] == 0) && (offsets[11] == 0));
+    }
+
+    // without start markers, the offset table is required
+    DcmPixelSequence pixSeq2(DcmTag(DCM_PixelData, EVR_OB));
+    createPixelSequence(pixSeq2, OFFalse);
+    OFCHECK(pixSeq2.buildFrameIndex(3).bad());
+    DcmPixelItem *offsetTable2 = NULL;
+    OFCHECK(pixSeq2.getItem(offsetTable2, 0).good());
+    OFCHECK(offsetTable2->putUint8Array(offsets, 12).good());
+    checkFrameIndex(pixSeq2);
+
+    // the index is discarded when the fragments change
+    appendFragment(pixSeq2, 8, OFFalse);
+    OFCHECK(pixSeq2.getFrameFragments(2, 3, startFragment, endFragment).good());
+    OFCHECK_EQUAL(endFragment, 9);
+
+    // one fragment per frame
+    DcmPixelSequence pixSeq3(DcmTag(DCM_PixelData, EVR_OB));
+    pixSeq3.insert(new DcmPixelItem(DcmTag(DCM_Item, EVR_OB)));
+    for (int i = 0; i < 3; ++i)
+        appendFragment(pixSeq3, 6, OFFalse);
+    OFCHECK(pixSeq3.getFrameFragments(2, 3, startFragment, endFragment).good());
+    OFCHECK_EQUAL(startFragment, 3);
+    OFCHECK_EQUAL(endFragment, 4);
+}
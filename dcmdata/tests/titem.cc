@@ -0,0 +1,103 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for element list handling in class DcmItem
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+
+
+// check that the elements of the given item are in strictly ascending tag order
+static void checkAscendingOrder(DcmItem &item)
+{
+    for (unsigned long i = 1; i < item.card(); i++)
+        OFCHECK(item.getElement(i - 1)->getTag() < item.getElement(i)->getTag());
+}
+
+// insert a new element with VR US into the given item (most of the tags used
+// below are not defined in the data dictionary, so the VR has to be specified)
+static OFCondition insertUint16(DcmItem &item, const Uint16 elem, const Uint16 value, const OFBool replaceOld = OFTrue)
+{
+    DcmElement *element = new DcmUnsignedShort(DcmTag(0x0028, elem, EVR_US));
+    OFCondition status = element->putUint16(value);
+    if (status.good())
+        status = item.insert(element, replaceOld);
+    if (status.bad())
+        delete element;
+    return status;
+}
+
+OFTEST(dcmdata_itemInsertAndSearch)
+{
+    DcmItem item;
+    Uint16 value = 0;
+    // insert elements in descending and alternating order
+    for (Uint16 elem = 200; elem > 0; elem -= 2)
+        OFCHECK(insertUint16(item, elem, elem).good());
+    for (Uint16 elem = 1; elem < 200; elem += 2)
+        OFCHECK(insertUint16(item, elem, elem).good());
+    OFCHECK_EQUAL(item.card(), 200);
+    checkAscendingOrder(item);
+    // search all elements (not recursively)
+    for (Uint16 elem = 1; elem <= 200; elem++)
+    {
+        OFCHECK(item.findAndGetUint16(DcmTagKey(0x0028, elem), value).good());
+        OFCHECK_EQUAL(value, elem);
+    }
+    // search non-existing elements before, in between and after existing ones
+    OFCHECK(item.findAndGetUint16(DcmTagKey(0x0028, 0x0000), value) == EC_TagNotFound);
+    OFCHECK(item.findAndGetUint16(DcmTagKey(0x0028, 0x0201), value) == EC_TagNotFound);
+    OFCHECK(item.findAndGetUint16(DcmTagKey(0x0008, 0x0001), value) == EC_TagNotFound);
+    OFCHECK(item.findAndGetUint16(DcmTagKey(0x7fe0, 0x0010), value) == EC_TagNotFound);
+    // replace an existing element
+    OFCHECK(insertUint16(item, 100, 1000).good());
+    OFCHECK_EQUAL(item.card(), 200);
+    OFCHECK(item.findAndGetUint16(DcmTagKey(0x0028, 100), value).good());
+    OFCHECK_EQUAL(value, 1000);
+    // do not replace an existing element
+    OFCHECK(insertUint16(item, 100, 2000, OFFalse) == EC_DoubledTag);
+    OFCHECK(item.findAndGetUint16(DcmTagKey(0x0028, 100), value).good());
+    OFCHECK_EQUAL(value, 1000);
+    // remove first, last and some element in between
+    OFCHECK(item.findAndDeleteElement(DcmTagKey(0x0028, 1)).good());
+    OFCHECK(item.findAndDeleteElement(DcmTagKey(0x0028, 200)).good());
+    OFCHECK(item.findAndDeleteElement(DcmTagKey(0x0028, 50)).good());
+    OFCHECK(item.findAndDeleteElement(DcmTagKey(0x0028, 50)) == EC_TagNotFound);
+    OFCHECK_EQUAL(item.card(), 197);
+    checkAscendingOrder(item);
+    OFCHECK(item.findAndGetUint16(DcmTagKey(0x0028, 51), value).good());
+    OFCHECK_EQUAL(value, 51);
+    // remove element by pointer
+    DcmElement *elem = item.getElement(10);
+    OFCHECK(elem != NULL);
+    OFCHECK_EQUAL(item.remove(elem), elem);
+    OFCHECK(item.remove(elem) == NULL);
+    delete elem;
+    OFCHECK_EQUAL(item.card(), 196);
+    checkAscendingOrder(item);
+    // iterate over all elements
+    unsigned long count = 0;
+    DcmObject *obj = NULL;
+    while ((obj = item.nextInContainer(obj)) != NULL)
+        count++;
+    OFCHECK_EQUAL(count, item.card());
+}
@@ -0,0 +1,147 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for lazy parsing of sequences
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+
+#define NUM_ITEMS 50
+
+
+static void checkLazySequence(const char *filename,
+                              const E_TransferSyntax xfer,
+                              const E_EncodingType enctype,
+                              DcmDataset &original)
+{
+    DcmFileFormat dfile;
+    dfile.getDataset()->copyFrom(original);
+    OFCHECK(dfile.saveFile(filename, xfer, enctype).good());
+
+    dcmLazySequenceParsing.set(OFTrue);
+    OFCHECK(dfile.loadFile(filename).good());
+    DcmDataset *dset = dfile.getDataset();
+    // elements after the sequence have been read
+    OFString str;
+    OFCHECK(dset->findAndGetOFString(DCM_PatientName, str).good());
+    OFCHECK_EQUAL(str, "Doe^John");
+    DcmSequenceOfItems *sequence = NULL;
+    OFCHECK(dset->findAndGetSequence(DCM_ReferencedImageSequence, sequence).good());
+    if (sequence != NULL)
+    {
+        // the items are only read when accessed first
+        OFCHECK(!sequence->itemsLoaded());
+        OFCHECK_EQUAL(sequence->card(), NUM_ITEMS);
+        OFCHECK(sequence->itemsLoaded());
+        DcmItem *item = sequence->getItem(NUM_ITEMS - 1);
+        OFCHECK(item != NULL);
+        if (item != NULL)
+        {
+            // nested sequences are also read lazily
+            DcmSequenceOfItems *nested = NULL;
+            OFCHECK(item->findAndGetSequence(DCM_PurposeOfReferenceCodeSequence, nested).good());
+            if (nested != NULL)
+                OFCHECK(!nested->itemsLoaded());
+            OFCHECK(item->findAndGetOFString(DCM_CodeValue, str, 0, OFTrue /*searchIntoSub*/).good());
+            OFCHECK_EQUAL(str, "49");
+        }
+    }
+    dcmLazySequenceParsing.set(OFFalse);
+    // all other sequences are read when the dataset is compared
+    OFCHECK_EQUAL(dset->compare(original), 0);
+
+    // write the lazily parsed dataset to another file and read it again
+    dcmLazySequenceParsing.set(OFTrue);
+    OFCHECK(dfile.loadFile(filename).good());
+    dcmLazySequenceParsing.set(OFFalse);
+    OFCHECK(dfile.saveFile("test_lazyseq_copy.dcm", xfer, enctype).good());
+    DcmFileFormat copy;
+    OFCHECK(copy.loadFile("test_lazyseq_copy.dcm").good());
+    OFCHECK_EQUAL(copy.getDataset()->compare(original), 0);
+    OFStandard::deleteFile("test_lazyseq_copy.dcm");
+    OFStandard::deleteFile(filename);
+}
+
+
+OFTEST(dcmdata_lazySequenceParsing)
+{
+    // create a dataset with large and nested sequences
+    DcmDataset dset;
+    for (Uint16 i = 0; i < NUM_ITEMS; i++)
+    {
+        DcmItem *item = NULL;
+        OFCHECK(dset.findOrCreateSequenceItem(DCM_ReferencedImageSequence, item, -2).good());
+        if (item != NULL)
+        {
+            char uid[64];
+            OFCHECK(item->putAndInsertString(DCM_ReferencedSOPClassUID, UID_SecondaryCaptureImageStorage).good());
+            OFCHECK(item->putAndInsertString(DCM_ReferencedSOPInstanceUID, dcmGenerateUniqueIdentifier(uid)).good());
+            OFCHECK(item->putAndInsertUint16(DCM_ReferencedSegmentNumber, i).good());
+            DcmItem *nested = NULL;
+            OFCHECK(item->findOrCreateSequenceItem(DCM_PurposeOfReferenceCodeSequence, nested, -2).good());
+            if (nested != NULL)
+            {
+                OFOStringStream oss;
+                oss << i << OFStringStream_ends;
+                OFSTRINGSTREAM_GETOFSTRING(oss, value)
+                OFCHECK(nested->putAndInsertOFStringArray(DCM_CodeValue, value).good());
+                OFCHECK(nested->putAndInsertString(DCM_CodingSchemeDesignator, "99TEST").good());
+            }
+        }
+    }
+    DcmItem *item = NULL;
+    OFCHECK(dset.findOrCreateSequenceItem(DCM_ReferencedSeriesSequence, item).good());
+    if (item != NULL)
+        OFCHECK(item->putAndInsertString(DCM_SeriesInstanceUID, "1.2.3.4").good());
+    OFCHECK(dset.putAndInsertString(DCM_PatientName, "Doe^John").good());
+
+    checkLazySequence("test_lazyseq_le.dcm", EXS_LittleEndianExplicit, EET_UndefinedLength, dset);
+    checkLazySequence("test_lazyseq_lel.dcm", EXS_LittleEndianExplicit, EET_ExplicitLength, dset);
+    checkLazySequence("test_lazyseq_be.dcm", EXS_BigEndianExplicit, EET_UndefinedLength, dset);
+    checkLazySequence("test_lazyseq_li.dcm", EXS_LittleEndianImplicit, EET_UndefinedLength, dset);
+    // lazy parsing also works with memory-mapped files
+    dcmUseMemoryMappedFileInput.set(OFTrue);
+    checkLazySequence("test_lazyseq_mm.dcm", EXS_LittleEndianExplicit, EET_UndefinedLength, dset);
+    dcmUseMemoryMappedFileInput.set(OFFalse);
+
+    // sequences are parsed immediately if lazy parsing is disabled
+    DcmFileFormat dfile;
+    dfile.getDataset()->copyFrom(dset);
+    OFCHECK(dfile.saveFile("test_lazyseq.dcm", EXS_LittleEndianExplicit).good());
+    OFCHECK(dfile.loadFile("test_lazyseq.dcm").good());
+    DcmSequenceOfItems *sequence = NULL;
+    OFCHECK(dfile.getDataset()->findAndGetSequence(DCM_ReferencedImageSequence, sequence).good());
+    if (sequence != NULL)
+        OFCHECK(sequence->itemsLoaded());
+    // clearing a sequence discards the items that have not been read
+    dcmLazySequenceParsing.set(OFTrue);
+    OFCHECK(dfile.loadFile("test_lazyseq.dcm").good());
+    dcmLazySequenceParsing.set(OFFalse);
+    OFCHECK(dfile.getDataset()->findAndGetSequence(DCM_ReferencedImageSequence, sequence).good());
+    if (sequence != NULL)
+    {
+        OFCHECK(sequence->clear().good());
+        OFCHECK(sequence->itemsLoaded());
+        OFCHECK_EQUAL(sequence->card(), 0);
+    }
+    OFStandard::deleteFile("test_lazyseq.dcm");
+}
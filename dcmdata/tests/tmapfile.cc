@@ -0,0 +1,115 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for reading from memory-mapped files
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+
+#define NUM_WORDS 4096
+
+
+static void checkMappedFile(const char *filename, const E_TransferSyntax xfer, const Uint32 maxReadLength)
+{
+    DcmFileFormat dfile;
+    Uint16 *words = NULL;
+    Uint8 *bytes = NULL;
+    const char *cstr = NULL;
+    OFString str;
+    OFCHECK(dfile.loadFile(filename, EXS_Unknown, EGL_noChange, maxReadLength).good());
+    DcmDataset *dset = dfile.getDataset();
+    OFCHECK_EQUAL(dset->getOriginalXfer(), xfer);
+    // check values of all elements
+    OFCHECK(dset->findAndGetString(DCM_PatientName, cstr).good());
+    OFCHECK(cstr != NULL);
+    OFCHECK(dset->findAndGetOFString(DCM_PatientName, str).good());
+    OFCHECK_EQUAL(str, "Doe^John");
+    unsigned long count = 0;
+    OFCHECK(dset->findAndGetUint16Array(DCM_RWavePointer, OFconst_cast(const Uint16 *&, words), &count).good());
+    OFCHECK_EQUAL(count, NUM_WORDS);
+    if (words != NULL)
+    {
+        OFBool valuesOk = OFTrue;
+        for (Uint16 i = 0; i < NUM_WORDS; i++)
+            valuesOk &= (words[i] == i);
+        OFCHECK(valuesOk);
+        // modify value in memory (must not have any impact on the file)
+        words[0] = 0xffff;
+    }
+    DcmElement *elem = NULL;
+    OFCHECK(dset->findAndGetElement(DCM_EncapsulatedDocument, elem).good());
+    if (elem != NULL)
+    {
+        OFCHECK(elem->getUint8Array(bytes).good());
+        OFCHECK(bytes != NULL && bytes[0] == 0 && bytes[NUM_WORDS - 1] == OFstatic_cast(Uint8, NUM_WORDS - 1));
+        // a value that refers to the file mapping cannot be detached
+        OFCHECK(elem->detachValueField() == EC_IllegalCall);
+        // but it can be modified
+        OFCHECK(elem->putUint8Array(bytes, 2).good());
+        OFCHECK_EQUAL(elem->getLength(), 2);
+        // and a value on the heap can be detached (the caller has to delete it)
+        OFCHECK(elem->getUint8Array(bytes).good());
+        OFCHECK(elem->detachValueField(OFTrue).good());
+        delete[] bytes;
+    }
+}
+
+OFTEST(dcmdata_memoryMappedFileInput)
+{
+#ifdef HAVE_SYS_MMAN_H
+    Uint16 words[NUM_WORDS];
+    Uint8 bytes[NUM_WORDS];
+    for (Uint16 i = 0; i < NUM_WORDS; i++)
+    {
+        words[i] = i;
+        bytes[i] = OFstatic_cast(Uint8, i);
+    }
+    // create test files in little and big endian
+    DcmFileFormat dfile;
+    DcmDataset *dset = dfile.getDataset();
+    OFCHECK(dset->putAndInsertString(DCM_PatientName, "Doe^John").good());
+    OFCHECK(dset->putAndInsertUint16Array(DCM_RWavePointer, words, NUM_WORDS).good());
+    OFCHECK(dset->putAndInsertUint8Array(DCM_EncapsulatedDocument, bytes, NUM_WORDS).good());
+    OFCHECK(dfile.saveFile("test_mmap_le.dcm", EXS_LittleEndianExplicit).good());
+    OFCHECK(dfile.saveFile("test_mmap_be.dcm", EXS_BigEndianExplicit).good());
+
+    dcmUseMemoryMappedFileInput.set(OFTrue);
+    // read values while parsing the file (and check twice to make sure that
+    // modifications in memory did not change the file)
+    checkMappedFile("test_mmap_le.dcm", EXS_LittleEndianExplicit, DCM_MaxReadLength);
+    checkMappedFile("test_mmap_le.dcm", EXS_LittleEndianExplicit, DCM_MaxReadLength);
+    checkMappedFile("test_mmap_be.dcm", EXS_BigEndianExplicit, DCM_MaxReadLength);
+    checkMappedFile("test_mmap_be.dcm", EXS_BigEndianExplicit, DCM_MaxReadLength);
+    // load values later, i.e. after the file has been parsed
+    checkMappedFile("test_mmap_le.dcm", EXS_LittleEndianExplicit, 256);
+    checkMappedFile("test_mmap_be.dcm", EXS_BigEndianExplicit, 256);
+    dcmUseMemoryMappedFileInput.set(OFFalse);
+
+    // a missing file is reported as an error
+    dcmUseMemoryMappedFileInput.set(OFTrue);
+    OFCHECK(dfile.loadFile("test_mmap_missing.dcm").bad());
+    dcmUseMemoryMappedFileInput.set(OFFalse);
+
+    OFStandard::deleteFile("test_mmap_le.dcm");
+    OFStandard::deleteFile("test_mmap_be.dcm");
+#endif
+}
@@ -0,0 +1,324 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the RLE stripe codec and the RLE codecs
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcpxitem.h"
+#include "dcmtk/dcmdata/dcrleenc.h"
+#include "dcmtk/dcmdata/dcrlesc.h"
+#include "dcmtk/dcmdata/dcrleerg.h"
+#include "dcmtk/dcmdata/dcrledrg.h"
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
+#define RLE_COLUMNS 300
+#define RLE_ROWS 7
+#define RLE_PIXELS (RLE_COLUMNS * RLE_ROWS)
+
+
+/* fill the given buffer with a mix of runs (some of them longer than 128 bytes),
+ * pairs of identical bytes and pseudo random literal bytes
+ */
+static void createStripe(Uint8 *data, size_t count, Uint32 seed)
+{
+    size_t i = 0;
+    while (i < count)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % 200 + 1;
+        const int kind = OFstatic_cast(int, (seed >> 8) % 3);
+        const Uint8 value = OFstatic_cast(Uint8, seed >> 24);
+        for (size_t j = 0; (j < length) && (i < count); j++, i++)
+        {
+            if (kind == 0)
+                data[i] = value;
+            else if (kind == 1)
+                data[i] = OFstatic_cast(Uint8, value + j / 2);
+            else
+            {
+                seed = seed * 1103515245 + 12345;
+                data[i] = OFstatic_cast(Uint8, seed >> 20);
+            }
+        }
+    }
+}
+
+
+OFTEST(dcmdata_rleStripeCodec)
+{
+    Uint8 stripe[RLE_PIXELS];
+    Uint8 decoded[RLE_PIXELS];
+    Uint8 rowBuffer[RLE_COLUMNS];
+    const size_t maxSize = DcmRLEStripeCodec::getMaxEncodedSize(RLE_COLUMNS, RLE_ROWS);
+    Uint8 *encoded = new Uint8[maxSize];
+
+    for (Uint32 seed = 1; seed <= 20; seed++)
+    {
+        createStripe(stripe, RLE_PIXELS, seed);
+        // the most simple cases: all bytes identical and no identical bytes at all
+        if (seed == 1)
+            memset(stripe, 42, RLE_PIXELS);
+        else if (seed == 2)
+        {
+            for (size_t i = 0; i < RLE_PIXELS; i++)
+                stripe[i] = OFstatic_cast(Uint8, i);
+        }
+
+        // compress the stripe byte by byte, one row after the other
+        DcmRLEEncoder reference(1 /* DICOM padding required */);
+        for (size_t row = 0; row < RLE_ROWS; row++)
+        {
+            reference.add(stripe + row * RLE_COLUMNS, RLE_COLUMNS);
+            reference.flush();
+        }
+        Uint8 *expected = new Uint8[reference.size()];
+        reference.write(expected);
+
+        // the stripe codec must create exactly the same compressed stream
+        const size_t size = DcmRLEStripeCodec::encodeStripe(stripe, 1, RLE_COLUMNS, RLE_ROWS, encoded, NULL);
+        OFCHECK(size <= maxSize);
+        OFCHECK_EQUAL(size, reference.size());
+        OFCHECK((size == reference.size()) && (memcmp(encoded, expected, size) == 0));
+        delete[] expected;
+
+        memset(decoded, 0, sizeof(decoded));
+        OFCHECK_EQUAL(DcmRLEStripeCodec::decodeStripe(encoded, size, decoded, 1, RLE_PIXELS, NULL), RLE_PIXELS);
+        OFCHECK(memcmp(decoded, stripe, RLE_PIXELS) == 0);
+
+        // incomplete compressed data
+        OFCHECK(DcmRLEStripeCodec::decodeStripe(encoded, size / 2, decoded, 1, RLE_PIXELS, NULL) < RLE_PIXELS);
+    }
+
+    // the second byte of 3 byte pixels
+    Uint8 *pixels = new Uint8[3 * RLE_PIXELS];
+    memset(pixels, 0, 3 * RLE_PIXELS);
+    createStripe(stripe, RLE_PIXELS, 4711);
+    for (size_t i = 0; i < RLE_PIXELS; i++)
+        pixels[3 * i + 1] = stripe[i];
+    const size_t size = DcmRLEStripeCodec::encodeStripe(pixels + 1, 3, RLE_COLUMNS, RLE_ROWS, encoded, rowBuffer);
+    OFCHECK_EQUAL(size, DcmRLEStripeCodec::encodeStripe(stripe, 1, RLE_COLUMNS, RLE_ROWS, encoded + size, NULL));
+    OFCHECK(memcmp(encoded, encoded + size, size) == 0);
+    memset(pixels, 0, 3 * RLE_PIXELS);
+    OFCHECK_EQUAL(DcmRLEStripeCodec::decodeStripe(encoded, size, pixels + 1, 3, RLE_PIXELS, decoded), RLE_PIXELS);
+    OFBool equal = OFTrue;
+    for (size_t i = 0; i < RLE_PIXELS; i++)
+        equal &= (pixels[3 * i] == 0) && (pixels[3 * i + 1] == stripe[i]) && (pixels[3 * i + 2] == 0);
+    OFCHECK(equal);
+
+    delete[] pixels;
+    delete[] encoded;
+}
+
+
+#define RLE_FRAMES 5
+#define RLE_FRAME_COLUMNS 70
+#define RLE_FRAME_ROWS 20
+#define RLE_FRAME_VALUES (RLE_FRAME_COLUMNS * RLE_FRAME_ROWS * 3)
+
+
+/* create a multi-frame RGB image with 16 bits per sample, i.e. six stripes per frame */
+static void createDataset(DcmDataset &dset, Uint16 *pixelData)
+{
+    createStripe(OFreinterpret_cast(Uint8 *, pixelData), RLE_FRAMES * RLE_FRAME_VALUES * sizeof(Uint16), 815);
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_MultiframeTrueColorSecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4.5").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, 3).good());
+    OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, "RGB").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PlanarConfiguration, 0).good());
+    OFCHECK(dset.putAndInsertString(DCM_NumberOfFrames, "5").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, RLE_FRAME_ROWS).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, RLE_FRAME_COLUMNS).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 16).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, 16).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_HighBit, 15).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+    OFCHECK(dset.putAndInsertUint16Array(DCM_PixelData, pixelData, RLE_FRAMES * RLE_FRAME_VALUES).good());
+}
+
+
+static DcmPixelSequence *getPixelSequence(DcmDataset &dset)
+{
+    DcmElement *elem = NULL;
+    DcmPixelSequence *pixSeq = NULL;
+    if (dset.findAndGetElement(DCM_PixelData, elem).good())
+        OFstatic_cast(DcmPixelData *, elem)->getEncapsulatedRepresentation(EXS_RLELossless, NULL, pixSeq);
+    return pixSeq;
+}
+
+
+OFTEST(dcmdata_rleCodecMultipleThreads)
+{
+    Uint16 *pixelData = new Uint16[RLE_FRAMES * RLE_FRAME_VALUES];
+    DcmDataset dset1;
+    DcmDataset dset2;
+    createDataset(dset1, pixelData);
+    createDataset(dset2, pixelData);
+
+    // compress one stripe after the other
+    DcmRLEEncoderRegistration::registerCodecs();
+    OFCHECK(dset1.chooseRepresentation(EXS_RLELossless, NULL).good());
+    DcmRLEEncoderRegistration::cleanup();
+
+    // compress the stripes of multiple frames concurrently
+    DcmRLEEncoderRegistration::registerCodecs(OFFalse, 0, OFTrue, OFFalse, 4);
+    OFCHECK(dset2.chooseRepresentation(EXS_RLELossless, NULL).good());
+    DcmRLEEncoderRegistration::cleanup();
+    dset1.removeAllButCurrentRepresentations();
+    dset2.removeAllButCurrentRepresentations();
+
+    // the compressed frames must be identical, including the offset table
+    DcmPixelSequence *pixSeq1 = getPixelSequence(dset1);
+    DcmPixelSequence *pixSeq2 = getPixelSequence(dset2);
+    OFCHECK(pixSeq1 != NULL);
+    OFCHECK(pixSeq2 != NULL);
+    if (pixSeq1 && pixSeq2)
+    {
+        OFCHECK_EQUAL(pixSeq1->card(), RLE_FRAMES + 1);
+        OFCHECK_EQUAL(pixSeq1->card(), pixSeq2->card());
+        for (unsigned long i = 0; (i < pixSeq1->card()) && (i < pixSeq2->card()); i++)
+        {
+            DcmPixelItem *item1 = NULL;
+            DcmPixelItem *item2 = NULL;
+            Uint8 *data1 = NULL;
+            Uint8 *data2 = NULL;
+            OFCHECK(pixSeq1->getItem(item1, i).good() && item1->getUint8Array(data1).good());
+            OFCHECK(pixSeq2->getItem(item2, i).good() && item2->getUint8Array(data2).good());
+            OFCHECK_EQUAL(item1->getLength(), item2->getLength());
+            OFCHECK((item1->getLength() == item2->getLength()) && (memcmp(data1, data2, item1->getLength()) == 0));
+        }
+    }
+
+    // decompress a range of frames and all frames concurrently
+    DcmRLEDecoderRegistration::registerCodecs(OFFalse, OFFalse, 4);
+    DcmElement *elem = NULL;
+    OFCHECK(dset1.findAndGetElement(DCM_PixelData, elem).good());
+    if (elem != NULL)
+    {
+        const Uint32 frameSize = RLE_FRAME_VALUES * sizeof(Uint16);
+        Uint16 *buffer = new Uint16[3 * RLE_FRAME_VALUES];
+        Uint32 startFragment = 0;
+        OFString colorModel;
+        OFCHECK(OFstatic_cast(DcmPixelData *, elem)->getUncompressedFrames(&dset1, 1, 3, startFragment, buffer, 3 * frameSize, colorModel).good());
+        OFCHECK_EQUAL(startFragment, 5);
+        OFCHECK_EQUAL(colorModel, "RGB");
+        OFCHECK(memcmp(buffer, pixelData + RLE_FRAME_VALUES, 3 * frameSize) == 0);
+        delete[] buffer;
+    }
+    OFCHECK(dset2.chooseRepresentation(EXS_LittleEndianExplicit, NULL).good());
+    const Uint16 *decompressed = NULL;
+    unsigned long count = 0;
+    OFCHECK(dset2.findAndGetUint16Array(DCM_PixelData, decompressed, &count).good());
+    OFCHECK_EQUAL(count, RLE_FRAMES * RLE_FRAME_VALUES);
+    OFCHECK((decompressed != NULL) && (memcmp(decompressed, pixelData, RLE_FRAMES * RLE_FRAME_VALUES * sizeof(Uint16)) == 0));
+    DcmRLEDecoderRegistration::cleanup();
+
+    delete[] pixelData;
+}
+
+
+/* create a dataset with two RLE compressed frames of 2x2 pixels with 8 bits
+ * per sample, each sample being compressed into a stripe of its own
+ */
+static void createStripesDataset(DcmDataset &dset, Uint16 numStripes)
+{
+    OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, numStripes).good());
+    OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, "RGB").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PlanarConfiguration, 0).good());
+    OFCHECK(dset.putAndInsertString(DCM_NumberOfFrames, "2").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, 2).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, 2).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 8).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, 8).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_HighBit, 7).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+
+    // each stripe is a literal run of four bytes. The header has room for
+    // the offsets of 15 stripes, any further stripe cannot be located.
+    Uint8 fragment[64 + 16 * 5];
+    Uint32 rleHeader[16];
+    memset(rleHeader, 0, sizeof(rleHeader));
+    rleHeader[0] = numStripes;
+    for (Uint32 i = 1; (i <= numStripes) && (i < 16); i++)
+        rleHeader[i] = 64 + (i - 1) * 5;
+    swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, rleHeader, 16 * OFstatic_cast(Uint32, sizeof(Uint32)), sizeof(Uint32));
+    memcpy(fragment, rleHeader, 64);
+    for (Uint32 j = 0; j < numStripes; j++)
+    {
+        Uint8 *stripe = fragment + 64 + j * 5;
+        stripe[0] = 3;
+        stripe[1] = stripe[2] = stripe[3] = stripe[4] = OFstatic_cast(Uint8, j);
+    }
+
+    DcmPixelSequence *pixSeq = new DcmPixelSequence(DcmTag(DCM_PixelData, EVR_OB));
+    pixSeq->insert(new DcmPixelItem(DcmTag(DCM_Item, EVR_OB)));
+    for (int k = 0; k < 2; k++)
+    {
+        DcmPixelItem *item = new DcmPixelItem(DcmTag(DCM_Item, EVR_OB));
+        OFCHECK(item->putUint8Array(fragment, 64 + numStripes * 5).good());
+        pixSeq->insert(item);
+    }
+    DcmPixelData *pixelData = new DcmPixelData(DCM_PixelData);
+    pixelData->putOriginalRepresentation(EXS_RLELossless, NULL, pixSeq);
+    OFCHECK(dset.insert(pixelData).good());
+}
+
+
+OFTEST(dcmdata_rleCodecInvalidStripes)
+{
+    DcmRLEDecoderRegistration::registerCodecs(OFFalse, OFFalse, 4);
+
+    // 15 stripes per frame are the maximum supported by the RLE header
+    DcmDataset dset;
+    createStripesDataset(dset, 15);
+    OFCHECK(dset.chooseRepresentation(EXS_LittleEndianExplicit, NULL).good());
+    const Uint8 *decompressed = NULL;
+    unsigned long count = 0;
+    OFCHECK(dset.findAndGetUint8Array(DCM_PixelData, decompressed, &count).good());
+    OFCHECK_EQUAL(count, 2 * 2 * 2 * 15);
+    for (unsigned long i = 0; (decompressed != NULL) && (i < count); i++)
+        OFCHECK_EQUAL(decompressed[i], i % 15);
+
+    // a header claiming 16 stripes must be rejected when decompressing
+    // all frames at once, a range of frames and single frames
+    DcmDataset dset1;
+    createStripesDataset(dset1, 16);
+    OFCHECK(dset1.chooseRepresentation(EXS_LittleEndianExplicit, NULL).bad());
+    DcmDataset dset2;
+    createStripesDataset(dset2, 16);
+    DcmElement *elem = NULL;
+    OFCHECK(dset2.findAndGetElement(DCM_PixelData, elem).good());
+    if (elem != NULL)
+    {
+        Uint8 buffer[2 * 2 * 2 * 16];
+        Uint32 startFragment = 0;
+        OFString colorModel;
+        DcmPixelData *pixelData = OFstatic_cast(DcmPixelData *, elem);
+        OFCHECK(pixelData->getUncompressedFrame(&dset2, 1, startFragment, buffer, sizeof(buffer) / 2, colorModel).bad());
+        startFragment = 0;
+        OFCHECK(pixelData->getUncompressedFrames(&dset2, 0, 2, startFragment, buffer, sizeof(buffer), colorModel).bad());
+    }
+
+    DcmRLEDecoderRegistration::cleanup();
+}
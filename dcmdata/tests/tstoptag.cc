@@ -0,0 +1,130 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for reading a dataset up to a given tag
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+
+#define PIXEL_DATA_SIZE 4096
+
+
+static void checkReadUntilTag(const char *filename,
+                              const E_TransferSyntax xfer,
+                              DcmDataset &original)
+{
+    DcmFileFormat dfile;
+    dfile.getDataset()->copyFrom(original);
+    OFCHECK(dfile.saveFile(filename, xfer, EET_UndefinedLength).good());
+
+    // stop before the pixel data
+    OFString str;
+    Uint16 rows = 0;
+    OFCHECK(dfile.loadFileUntilTag(filename, EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+        ERM_autoDetect, DCM_PixelData).good());
+    DcmDataset *dset = dfile.getDataset();
+    OFCHECK(dfile.getMetaInfo()->tagExists(DCM_TransferSyntaxUID));
+    OFCHECK(dset->findAndGetOFString(DCM_PatientName, str).good());
+    OFCHECK_EQUAL(str, "Doe^John");
+    OFCHECK(dset->findAndGetUint16(DCM_Rows, rows).good());
+    OFCHECK_EQUAL(rows, 64);
+    OFCHECK(dset->tagExists(DCM_ReferencedImageSequence));
+    OFCHECK(!dset->tagExists(DCM_PixelData));
+    OFCHECK(!dset->tagExists(DCM_DataSetTrailingPadding));
+    OFCHECK_EQUAL(dset->getOriginalXfer(), xfer);
+
+    // the stop tag does not need to be present in the dataset
+    OFCHECK(dfile.loadFileUntilTag(filename, EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+        ERM_autoDetect, DCM_SeriesInstanceUID).good());
+    OFCHECK(dset->tagExists(DCM_StudyInstanceUID));
+    OFCHECK(!dset->tagExists(DCM_SeriesNumber));
+
+    // only read the attributes contained in the tag filter
+    OFList<DcmTagKey> tagFilter;
+    tagFilter.push_back(DCM_PatientID);
+    tagFilter.push_back(DCM_SeriesNumber);
+    tagFilter.push_back(DCM_PixelData);
+    OFCHECK(dfile.loadFileUntilTag(filename, EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+        ERM_autoDetect, DCM_UndefinedTagKey, &tagFilter).good());
+    OFCHECK_EQUAL(dset->card(), 3);
+    OFCHECK(dset->findAndGetOFString(DCM_PatientID, str).good());
+    OFCHECK_EQUAL(str, "12345");
+    OFCHECK(dset->findAndGetOFString(DCM_SeriesNumber, str).good());
+    OFCHECK_EQUAL(str, "7");
+    OFCHECK(dset->tagExists(DCM_PixelData));
+    // the sequence with undefined length is read but not kept
+    OFCHECK(!dset->tagExists(DCM_ReferencedImageSequence));
+    OFCHECK(!dset->tagExists(DCM_PatientName));
+
+    // tag filter and stop tag can be combined
+    OFCHECK(dfile.loadFileUntilTag(filename, EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+        ERM_autoDetect, DCM_PixelData, &tagFilter).good());
+    OFCHECK_EQUAL(dset->card(), 2);
+    OFCHECK(!dset->tagExists(DCM_PixelData));
+
+    // reading the complete file still works
+    OFCHECK(dfile.loadFile(filename).good());
+    OFCHECK_EQUAL(dset->compare(original), 0);
+    OFStandard::deleteFile(filename);
+}
+
+
+OFTEST(dcmdata_readUntilTag)
+{
+    // create a dataset with a sequence, pixel data and some trailing elements
+    DcmDataset dset;
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4.5").good());
+    DcmItem *item = NULL;
+    OFCHECK(dset.findOrCreateSequenceItem(DCM_ReferencedImageSequence, item).good());
+    if (item != NULL)
+        OFCHECK(item->putAndInsertString(DCM_ReferencedSOPInstanceUID, "1.2.3.4.6").good());
+    OFCHECK(dset.putAndInsertString(DCM_PatientName, "Doe^John").good());
+    OFCHECK(dset.putAndInsertString(DCM_PatientID, "12345").good());
+    OFCHECK(dset.putAndInsertString(DCM_StudyInstanceUID, "1.2.3.4").good());
+    OFCHECK(dset.putAndInsertString(DCM_SeriesNumber, "7").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, 64).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, 64).good());
+    Uint8 pixelData[PIXEL_DATA_SIZE];
+    for (size_t i = 0; i < PIXEL_DATA_SIZE; i++)
+        pixelData[i] = OFstatic_cast(Uint8, i);
+    OFCHECK(dset.putAndInsertUint8Array(DCM_PixelData, pixelData, PIXEL_DATA_SIZE).good());
+    OFCHECK(dset.putAndInsertUint8Array(DCM_DataSetTrailingPadding, pixelData, 16).good());
+
+    checkReadUntilTag("test_stoptag_le.dcm", EXS_LittleEndianExplicit, dset);
+    checkReadUntilTag("test_stoptag_li.dcm", EXS_LittleEndianImplicit, dset);
+    checkReadUntilTag("test_stoptag_be.dcm", EXS_BigEndianExplicit, dset);
+
+    // datasets stored without meta header
+    OFCHECK(dset.saveFile("test_stoptag.dcm", EXS_LittleEndianExplicit).good());
+    DcmDataset dataset;
+    OFCHECK(dataset.loadFileUntilTag("test_stoptag.dcm", EXS_Unknown, EGL_noChange,
+        DCM_MaxReadLength, DCM_PatientID).good());
+    OFCHECK(dataset.tagExists(DCM_PatientName));
+    OFCHECK(!dataset.tagExists(DCM_PatientID));
+    DcmFileFormat dfile;
+    OFCHECK(dfile.loadFileUntilTag("test_stoptag.dcm", EXS_Unknown, EGL_noChange,
+        DCM_MaxReadLength, ERM_dataset, DCM_Rows).good());
+    OFCHECK(dfile.getDataset()->tagExists(DCM_SeriesNumber));
+    OFCHECK(!dfile.getDataset()->tagExists(DCM_Rows));
+    OFStandard::deleteFile("test_stoptag.dcm");
+}
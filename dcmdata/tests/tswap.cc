@@ -0,0 +1,76 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the byte order functions
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dcswap.h"
+
+#define BUFFER_SIZE 256
+
+
+// check swapBytes() for the given value width, all lengths and different alignments
+static void checkSwapBytes(const size_t valWidth)
+{
+    Uint8 buffer[BUFFER_SIZE + 8];
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (Uint32 length = 0; length <= BUFFER_SIZE; length++)
+        {
+            Uint8 *value = buffer + offset;
+            for (Uint32 i = 0; i < length; i++)
+                value[i] = OFstatic_cast(Uint8, i);
+            swapBytes(value, length, valWidth);
+            // complete values are reversed, remaining bytes are not changed
+            const Uint32 swapLength = OFstatic_cast(Uint32, length - length % valWidth);
+            OFBool valuesOk = OFTrue;
+            for (Uint32 i = 0; i < length; i++)
+            {
+                const Uint32 expected = (i < swapLength) ? (i - i % valWidth) + (valWidth - 1 - i % valWidth) : i;
+                valuesOk &= (value[i] == OFstatic_cast(Uint8, expected));
+            }
+            OFCHECK(valuesOk);
+        }
+    }
+}
+
+
+OFTEST(dcmdata_swapBytes)
+{
+    checkSwapBytes(2);
+    checkSwapBytes(4);
+    checkSwapBytes(8);
+    checkSwapBytes(6);
+    // single values
+    Uint8 value[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    OFCHECK(swapIfNecessary(EBO_BigEndian, EBO_LittleEndian, value, 2, 2).good());
+    OFCHECK(value[0] == 2 && value[1] == 1);
+    OFCHECK(swapIfNecessary(EBO_BigEndian, EBO_LittleEndian, value, 4, 4).good());
+    OFCHECK(value[0] == 4 && value[1] == 3 && value[2] == 1 && value[3] == 2);
+    OFCHECK(swapIfNecessary(EBO_BigEndian, EBO_LittleEndian, value, 8, 8).good());
+    OFCHECK(value[0] == 8 && value[7] == 4);
+    // nothing to do for identical byte orders
+    OFCHECK(swapIfNecessary(EBO_BigEndian, EBO_BigEndian, value, 8, 2).good());
+    OFCHECK(value[0] == 8 && value[1] == 7);
+    OFCHECK(swapIfNecessary(EBO_unknown, EBO_BigEndian, value, 8, 2) == EC_IllegalCall);
+    OFCHECK_EQUAL(swapShort(0x1234), 0x3412);
+}
@@ -0,0 +1,160 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the multi-threaded zlib compression filter
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#if defined(WITH_ZLIB) && defined(WITH_THREADS)
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcostrmz.h"    /* for dcmZlibCompressionThreads */
+#include "dcmtk/dcmdata/dcostrmb.h"    /* for DcmOutputBufferStream */
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
+
+/* create a dataset with an OB element of the given size, which contains
+ * data that is compressible but not trivial
+ */
+static void createDataset(DcmDataset &dset, Uint8 *data, Uint32 size)
+{
+    Uint32 seed = 42;
+    for (Uint32 i = 0; i < size; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = OFstatic_cast(Uint8, (i / 64) % 7 + ((seed >> 16) % 4));
+    }
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4.5.6").good());
+    OFCHECK(dset.putAndInsertString(DCM_PatientName, "Doe^John").good());
+    OFCHECK(dset.putAndInsertUint8Array(DCM_EncapsulatedDocument, data, size).good());
+}
+
+
+/* save the dataset using the given number of compression threads, load the
+ * resulting file again and check that the content has not changed
+ */
+static void checkSaveAndLoad(Uint32 size, Uint32 threads, const char *filename, offile_off_t *fileSize)
+{
+    Uint8 *data = new Uint8[size];
+    DcmFileFormat dfile;
+    createDataset(*dfile.getDataset(), data, size);
+    dcmZlibCompressionThreads.set(threads);
+    OFCondition cond = dfile.saveFile(filename, EXS_DeflatedLittleEndianExplicit);
+    dcmZlibCompressionThreads.set(1);
+    if (cond.bad()) OFCHECK_FAIL(cond.text());
+
+    DcmFileFormat dfile2;
+    cond = dfile2.loadFile(filename);
+    if (cond.bad()) OFCHECK_FAIL(cond.text());
+    OFString patientName;
+    OFCHECK(dfile2.getDataset()->findAndGetOFString(DCM_PatientName, patientName).good());
+    OFCHECK_EQUAL(patientName, "Doe^John");
+    const Uint8 *loaded = NULL;
+    unsigned long count = 0;
+    OFCHECK(dfile2.getDataset()->findAndGetUint8Array(DCM_EncapsulatedDocument, loaded, &count).good());
+    OFCHECK_EQUAL(count, size);
+    OFCHECK((loaded != NULL) && (count == size) && (memcmp(loaded, data, size) == 0));
+    delete[] data;
+
+    *fileSize = OFStandard::getFileSize(filename);
+    OFStandard::deleteFile(filename);
+}
+
+
+OFTEST(dcmdata_deflateMultipleThreads)
+{
+    offile_off_t sizeSingle = 0;
+    offile_off_t sizeMulti = 0;
+    // a dataset that is split into many blocks
+    const Uint32 size = 1000000;
+    checkSaveAndLoad(size, 1, "test_zlib_1.dcm", &sizeSingle);
+    checkSaveAndLoad(size, 4, "test_zlib_4.dcm", &sizeMulti);
+    OFCHECK(sizeMulti < OFstatic_cast(offile_off_t, size / 2));
+    // the blocks are compressed independently, which costs a little space
+    OFCHECK(sizeMulti >= sizeSingle);
+    OFCHECK(sizeMulti < sizeSingle + sizeSingle / 10);
+
+    // a dataset that fits into a single block, and one that is slightly
+    // larger than two blocks
+    checkSaveAndLoad(100, 3, "test_zlib_3.dcm", &sizeMulti);
+    checkSaveAndLoad(2 * 131072, 2, "test_zlib_2.dcm", &sizeMulti);
+}
+
+
+/* compress the given data with four threads, writing it to the stream in
+ * pieces of the given size and optionally pausing after each piece, so that
+ * the compressing threads can finish (and write) all blocks submitted so far
+ */
+static void compressData(const Uint8 *data, Uint32 size, Uint32 pieceSize, OFBool pause, OFString &result)
+{
+    Uint8 *buffer = new Uint8[size];
+    dcmZlibCompressionThreads.set(4);
+    DcmOutputBufferStream stream(buffer, size);
+    OFCHECK(stream.installCompressionFilter(ESC_zlib).good());
+    dcmZlibCompressionThreads.set(1);
+    Uint32 offset = 0;
+    while (stream.good() && (offset < size))
+    {
+        Uint32 count = size - offset;
+        if (count > pieceSize) count = pieceSize;
+        const offile_off_t written = stream.write(data + offset, count);
+        OFCHECK_EQUAL(written, OFstatic_cast(offile_off_t, count));
+        if (written <= 0) break;
+        offset += OFstatic_cast(Uint32, written);
+        if (pause) OFStandard::milliSleep(200);
+    }
+    stream.flush();
+    void *compressed = NULL;
+    offile_off_t length = 0;
+    stream.flushBuffer(compressed, length);
+    result.assign(OFstatic_cast(const char *, compressed), OFstatic_cast(size_t, length));
+    delete[] buffer;
+}
+
+
+OFTEST(dcmdata_deflateMultipleThreadsDeterministic)
+{
+    // each block uses the end of the preceding input as preset dictionary,
+    // no matter whether the preceding block has already been written. So
+    // the compressed stream must not depend on the timing of the threads.
+    const Uint32 size = 5 * 131072 + 1000;
+    Uint8 *data = new Uint8[size];
+    DcmDataset dset;
+    createDataset(dset, data, size);
+    OFString content;
+    OFString contentPaused;
+    OFString contentSmallPieces;
+    compressData(data, size, size, OFFalse, content);
+    compressData(data, size, 131072, OFTrue, contentPaused);
+    compressData(data, size, 50000, OFTrue, contentSmallPieces);
+    OFCHECK(content.length() < size / 2);
+    OFCHECK_EQUAL(contentPaused.length(), content.length());
+    OFCHECK(contentPaused == content);
+    OFCHECK_EQUAL(contentSmallPieces.length(), content.length());
+    OFCHECK(contentSmallPieces == content);
+    delete[] data;
+}
+
+#endif
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1996-2014, OFFIS e.V.
+ *  Copyright (C) 1996-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -38,6 +38,7 @@
 #include "dcmtk/dcmimgle/dcmimage.h"     /* for DicomImage */
 #include "dcmtk/dcmimgle/digsdfn.h"      /* for DiGSDFunction */
 #include "dcmtk/dcmimgle/diciefn.h"      /* for DiCIELABFunction */
+#include "dcmtk/dcmimgle/dithread.h"     /* for dcmImageProcessingThreads */
 
 #include "dcmtk/ofstd/ofconapp.h"        /* for OFConsoleApplication */
 #include "dcmtk/ofstd/ofcmdln.h"         /* for OFCommandLine */
@@ -202,6 +203,9 @@ int main(int argc, char *argv[])
     E_FileType          opt_fileType = EFT_RawPNM;        /* default: 8-bit PGM/PPM */
                                                           /* (binary for file output and ASCII for stdout) */
     OFCmdUnsignedInt    opt_fileBits = 0;                 /* default: 0 */
+#ifdef WITH_THREADS
+    OFCmdUnsignedInt    opt_threads = 1;                  /* default: no additional threads */
+#endif
     const char *        opt_ifname = NULL;
     const char *        opt_ofname = NULL;
 
@@ -380,6 +384,10 @@ int main(int argc, char *argv[])
       cmd.addOption("--change-polarity",    "+P",      "change polarity (invert pixel output)");
       cmd.addOption("--clip-region",        "+C",   4, "[l]eft [t]op [w]idth [h]eight: integer",
                                                        "clip image region (l, t, w, h)");
+#ifdef WITH_THREADS
+      cmd.addOption("--processing-threads", "+pt",  1, "[n]umber: integer (1..256, default: 1)",
+                                                       "process bands of image rows using n threads");
+#endif
 
     cmd.addGroup("output options:");
      cmd.addSubGroup("general:");
@@ -537,6 +545,13 @@ int main(int argc, char *argv[])
             app.checkValue(cmd.getValue(opt_height));
             opt_useClip = 1;
         }
+#ifdef WITH_THREADS
+        if (cmd.findOption("--processing-threads"))
+        {
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_threads, 1, 256));
+            dcmImageProcessingThreads.set(OFstatic_cast(Uint32, opt_threads));
+        }
+#endif
 
         /* image processing options: rotation */
 
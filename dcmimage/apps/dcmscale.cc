@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2014, OFFIS e.V.
+ *  Copyright (C) 2002-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -40,6 +40,7 @@
 #include "dcmtk/oflog/oflog.h"           /* for OFLogger */
 
 #include "dcmtk/dcmimgle/dcmimage.h"     /* for DicomImage */
+#include "dcmtk/dcmimgle/dithread.h"     /* for dcmImageProcessingThreads */
 #include "dcmtk/dcmimage/diregist.h"     /* include to support color images */
 #include "dcmtk/dcmdata/dcrledrg.h"      /* for DcmRLEDecoderRegistration */
 
@@ -106,6 +107,9 @@ int main(int argc, char *argv[])
     OFBool           opt_useClip = OFFalse;            /* default: don't clip */
     OFCmdSignedInt   opt_left = 0, opt_top = 0;        /* clip region (origin) */
     OFCmdUnsignedInt opt_width = 0, opt_height = 0;    /* clip region (extension) */
+#ifdef WITH_THREADS
+    OFCmdUnsignedInt opt_threads = 1;                  /* default: no additional threads */
+#endif
 
     const char *opt_ifname = NULL;
     const char *opt_ofname = NULL;
@@ -161,6 +165,10 @@ int main(int argc, char *argv[])
      cmd.addSubGroup("other transformations:");
       cmd.addOption("--clip-region",         "+C",   4, "[l]eft [t]op [w]idth [h]eight: integer",
                                                         "clip rectangular image region (l, t, w, h)");
+#ifdef WITH_THREADS
+      cmd.addOption("--processing-threads",  "+pt",  1, "[n]umber: integer (1..256, default: 1)",
+                                                        "process bands of image rows using n threads");
+#endif
      cmd.addSubGroup("SOP Instance UID:");
       cmd.addOption("--uid-always",          "+ua",     "always assign new SOP Instance UID (default)");
       cmd.addOption("--uid-never",           "+un",     "never assign new SOP Instance UID");
@@ -323,6 +331,13 @@ int main(int argc, char *argv[])
           app.checkValue(cmd.getValue(opt_height));
           opt_useClip = OFTrue;
       }
+#ifdef WITH_THREADS
+      if (cmd.findOption("--processing-threads"))
+      {
+          app.checkValue(cmd.getValueAndCheckMinMax(opt_threads, 1, 256));
+          dcmImageProcessingThreads.set(OFstatic_cast(Uint32, opt_threads));
+      }
+#endif
 
       /* image processing options: SOP Instance UID options */
 
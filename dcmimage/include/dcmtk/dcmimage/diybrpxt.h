@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1998-2014, OFFIS e.V.
+ *  Copyright (C) 1998-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -27,6 +27,7 @@
 
 #include "dcmtk/dcmimage/dicopxt.h"
 #include "dcmtk/dcmimgle/diinpx.h"  /* gcc 3.4 needs this */
+#include "dcmtk/dcmimgle/dithread.h"
 
 
 /*---------------------*
@@ -92,17 +93,16 @@ class DiYBRPixelTemplate
             const unsigned long count = (this->InputCount < this->Count) ? this->InputCount : this->Count;
             if (rgb)    /* convert to RGB model */
             {
-                register T2 *r = this->Data[0];
-                register T2 *g = this->Data[1];
-                register T2 *b = this->Data[2];
                 const T2 maxvalue = OFstatic_cast(T2, DicomImageClass::maxval(bits));
                 DiPixelRepresentationTemplate<T1> rep;
+                Sint16 tables[4 * 256];
+                const Sint16 *tab = NULL;
                 if (bits == 8 && !rep.isSigned())          // only for unsigned 8 bit
                 {
-                    Sint16 rcr_tab[256];
-                    Sint16 gcb_tab[256];
-                    Sint16 gcr_tab[256];
-                    Sint16 bcb_tab[256];
+                    Sint16 *rcr_tab = tables;
+                    Sint16 *gcb_tab = tables + 256;
+                    Sint16 *gcr_tab = tables + 2 * 256;
+                    Sint16 *bcb_tab = tables + 3 * 256;
                     const double r_const = 0.7010 * OFstatic_cast(double, maxvalue);
                     const double g_const = 0.5291 * OFstatic_cast(double, maxvalue);
                     const double b_const = 0.8859 * OFstatic_cast(double, maxvalue);
@@ -114,115 +114,11 @@ class DiYBRPixelTemplate
                         gcr_tab[l] = OFstatic_cast(Sint16, 0.7141 * OFstatic_cast(double, l) - g_const);
                         bcb_tab[l] = OFstatic_cast(Sint16, 1.7720 * OFstatic_cast(double, l) - b_const);
                     }
-                    register Sint32 sr;
-                    register Sint32 sg;
-                    register Sint32 sb;
-                    if (this->PlanarConfiguration)
-                    {
-/*
-                        register const T1 *y = pixel;
-                        register const T1 *cb = y + this->InputCount;
-                        register const T1 *cr = cb + this->InputCount;
-                        for (i = count; i != 0; --i, ++y, ++cb, ++cr)
-                        {
-                            sr = OFstatic_cast(Sint32, *y) + OFstatic_cast(Sint32, rcr_tab[*cr]);
-                            sg = OFstatic_cast(Sint32, *y) - OFstatic_cast(Sint32, gcb_tab[*cb]) - OFstatic_cast(Sint32, gcr_tab[*cr]);
-                            sb = OFstatic_cast(Sint32, *y) + OFstatic_cast(Sint32, bcb_tab[*cb]);
-                            *(r++) = (sr < 0) ? 0 : (sr > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sr);
-                            *(g++) = (sg < 0) ? 0 : (sg > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sg);
-                            *(b++) = (sb < 0) ? 0 : (sb > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sb);
-                        }
-*/
-                        register const T1 *y = pixel;
-                        register const T1 *cb = y + planeSize;
-                        register const T1 *cr = cb + planeSize;
-                        register unsigned long i = count;
-                        while (i != 0)
-                        {
-                            /* convert a single frame */
-                            for (l = planeSize; (l != 0) && (i != 0); --l, --i, ++y, ++cb, ++cr)
-                            {
-                                sr = OFstatic_cast(Sint32, *y) + OFstatic_cast(Sint32, rcr_tab[OFstatic_cast(Uint32, *cr)]);
-                                sg = OFstatic_cast(Sint32, *y) - OFstatic_cast(Sint32, gcb_tab[OFstatic_cast(Uint32, *cb)]) - OFstatic_cast(Sint32, gcr_tab[OFstatic_cast(Uint32, *cr)]);
-                                sb = OFstatic_cast(Sint32, *y) + OFstatic_cast(Sint32, bcb_tab[OFstatic_cast(Uint32, *cb)]);
-                                *(r++) = (sr < 0) ? 0 : (sr > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sr);
-                                *(g++) = (sg < 0) ? 0 : (sg > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sg);
-                                *(b++) = (sb < 0) ? 0 : (sb > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sb);
-                            }
-                            /* jump to next frame start (skip 2 planes) */
-                            y += 2 * planeSize;
-                            cb += 2 * planeSize;
-                            cr += 2 * planeSize;
-                        }
-                    }
-                    else
-                    {
-                        register const T1 *p = pixel;
-                        register T1 y;
-                        register T1 cb;
-                        register T1 cr;
-                        register unsigned long i;
-                        for (i = count; i != 0; --i)
-                        {
-                            y  = *(p++);
-                            cb = *(p++);
-                            cr = *(p++);
-                            sr = OFstatic_cast(Sint32, y) + OFstatic_cast(Sint32, rcr_tab[OFstatic_cast(Uint32, cr)]);
-                            sg = OFstatic_cast(Sint32, y) - OFstatic_cast(Sint32, gcb_tab[OFstatic_cast(Uint32, cb)]) - OFstatic_cast(Sint32, gcr_tab[OFstatic_cast(Uint32, cr)]);
-                            sb = OFstatic_cast(Sint32, y) + OFstatic_cast(Sint32, bcb_tab[OFstatic_cast(Uint32, cb)]);
-                            *(r++) = (sr < 0) ? 0 : (sr > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sr);
-                            *(g++) = (sg < 0) ? 0 : (sg > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sg);
-                            *(b++) = (sb < 0) ? 0 : (sb > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sb);
-                        }
-                    }
-                }
-                else
-                {
-                    if (this->PlanarConfiguration)
-                    {
-/*
-                        register const T1 *y = pixel;
-                        register const T1 *cb = y + this->InputCount;
-                        register const T1 *cr = cb + this->InputCount;
-                        for (i = count; i != 0; --i)
-                            convertValue(*(r++), *(g++), *(b++), removeSign(*(y++), offset), removeSign(*(cb++), offset),
-                                removeSign(*(cr++), offset), maxvalue);
-*/
-                        register unsigned long l;
-                        register unsigned long i = count;
-                        register const T1 *y = pixel;
-                        register const T1 *cb = y + planeSize;
-                        register const T1 *cr = cb + planeSize;
-                        while (i != 0)
-                        {
-                            /* convert a single frame */
-                            for (l = planeSize; (l != 0) && (i != 0); --l, --i)
-                            {
-                                convertValue(*(r++), *(g++), *(b++), removeSign(*(y++), offset), removeSign(*(cb++), offset),
-                                    removeSign(*(cr++), offset), maxvalue);
-                            }
-                            /* jump to next frame start (skip 2 planes) */
-                            y += 2 * planeSize;
-                            cb += 2 * planeSize;
-                            cr += 2 * planeSize;
-                        }
-                    }
-                    else
-                    {
-                        register const T1 *p = pixel;
-                        register T2 y;
-                        register T2 cb;
-                        register T2 cr;
-                        register unsigned long i;
-                        for (i = count; i != 0; --i)
-                        {
-                            y = removeSign(*(p++), offset);
-                            cb = removeSign(*(p++), offset);
-                            cr = removeSign(*(p++), offset);
-                            convertValue(*(r++), *(g++), *(b++), y, cb, cr, maxvalue);
-                        }
-                    }
+                    tab = tables;
                 }
+                // the pixels are converted independently of each other, i.e. in parallel
+                ConvertTask task(*this, pixel, planeSize, offset, maxvalue, tab);
+                task.run(count);
             } else {    /* retain YCbCr model */
                 register const T1 *p = pixel;
                 if (this->PlanarConfiguration)
@@ -267,6 +163,194 @@ class DiYBRPixelTemplate
         }
     }
 
+    /** Helper class converting bands of pixels from YCbCr to RGB in parallel
+     */
+    class ConvertTask
+      : public DiThreadedTask
+    {
+
+     public:
+
+        /** constructor
+         *
+         ** @param  image      pixel object to be converted
+         *  @param  pixel      pointer to input pixel data
+         *  @param  planeSize  number of pixels in a plane
+         *  @param  offset     offset to be removed from signed input values
+         *  @param  maxvalue   maximum output value
+         *  @param  tables     lookup tables for unsigned 8 bit data (maybe NULL)
+         */
+        ConvertTask(DiYBRPixelTemplate<T1, T2> &image,
+                    const T1 *pixel,
+                    const unsigned long planeSize,
+                    const T1 offset,
+                    const T2 maxvalue,
+                    const Sint16 *tables)
+          : Image(image),
+            Pixel(pixel),
+            PlaneSize(planeSize),
+            Offset(offset),
+            MaxValue(maxvalue),
+            Tables(tables)
+        {
+        }
+
+     protected:
+
+        /** convert the given range of pixels
+         *
+         ** @param  first  index of the first pixel
+         *  @param  last   index of the pixel following the last one
+         */
+        virtual void process(const unsigned long first,
+                             const unsigned long last)
+        {
+            Image.convertToRGB(Pixel, PlaneSize, Offset, MaxValue, Tables, first, last);
+        }
+
+     private:
+
+        /// pixel object to be converted
+        DiYBRPixelTemplate<T1, T2> &Image;
+        /// pointer to input pixel data
+        const T1 *Pixel;
+        /// number of pixels in a plane
+        const unsigned long PlaneSize;
+        /// offset to be removed from signed input values
+        const T1 Offset;
+        /// maximum output value
+        const T2 MaxValue;
+        /// lookup tables for unsigned 8 bit data
+        const Sint16 *Tables;
+
+     // --- declarations to avoid compiler warnings
+
+        ConvertTask(const ConvertTask &);
+        ConvertTask &operator=(const ConvertTask &);
+    };
+
+    /** convert the given range of input pixels from YCbCr to RGB
+     *
+     ** @param  pixel      pointer to input pixel data
+     *  @param  planeSize  number of pixels in a plane
+     *  @param  offset     offset to be removed from signed input values
+     *  @param  maxvalue   maximum output value
+     *  @param  tables     lookup tables for unsigned 8 bit data (four tables with
+     *                     256 entries each), NULL for all other data
+     *  @param  first      index of the first pixel to be converted
+     *  @param  last       index of the pixel following the last one
+     */
+    void convertToRGB(const T1 *pixel,
+                      const unsigned long planeSize,
+                      const T1 offset,
+                      const T2 maxvalue,
+                      const Sint16 *tables,
+                      const unsigned long first,
+                      const unsigned long last)
+    {
+        register T2 *r = this->Data[0] + first;
+        register T2 *g = this->Data[1] + first;
+        register T2 *b = this->Data[2] + first;
+        if (tables != NULL)                         // only for unsigned 8 bit
+        {
+            const Sint16 *rcr_tab = tables;
+            const Sint16 *gcb_tab = tables + 256;
+            const Sint16 *gcr_tab = tables + 2 * 256;
+            const Sint16 *bcb_tab = tables + 3 * 256;
+            register Sint32 sr;
+            register Sint32 sg;
+            register Sint32 sb;
+            if (this->PlanarConfiguration)
+            {
+                /* start within the frame that contains the first pixel */
+                register const T1 *y = pixel + (first / planeSize) * 3 * planeSize + first % planeSize;
+                register const T1 *cb = y + planeSize;
+                register const T1 *cr = cb + planeSize;
+                register unsigned long l = planeSize - first % planeSize;
+                register unsigned long i = last - first;
+                while (i != 0)
+                {
+                    /* convert a single frame */
+                    for (; (l != 0) && (i != 0); --l, --i, ++y, ++cb, ++cr)
+                    {
+                        sr = OFstatic_cast(Sint32, *y) + OFstatic_cast(Sint32, rcr_tab[OFstatic_cast(Uint32, *cr)]);
+                        sg = OFstatic_cast(Sint32, *y) - OFstatic_cast(Sint32, gcb_tab[OFstatic_cast(Uint32, *cb)]) - OFstatic_cast(Sint32, gcr_tab[OFstatic_cast(Uint32, *cr)]);
+                        sb = OFstatic_cast(Sint32, *y) + OFstatic_cast(Sint32, bcb_tab[OFstatic_cast(Uint32, *cb)]);
+                        *(r++) = (sr < 0) ? 0 : (sr > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sr);
+                        *(g++) = (sg < 0) ? 0 : (sg > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sg);
+                        *(b++) = (sb < 0) ? 0 : (sb > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sb);
+                    }
+                    /* jump to next frame start (skip 2 planes) */
+                    y += 2 * planeSize;
+                    cb += 2 * planeSize;
+                    cr += 2 * planeSize;
+                    l = planeSize;
+                }
+            }
+            else
+            {
+                register const T1 *p = pixel + 3 * first;
+                register T1 y;
+                register T1 cb;
+                register T1 cr;
+                register unsigned long i;
+                for (i = last - first; i != 0; --i)
+                {
+                    y  = *(p++);
+                    cb = *(p++);
+                    cr = *(p++);
+                    sr = OFstatic_cast(Sint32, y) + OFstatic_cast(Sint32, rcr_tab[OFstatic_cast(Uint32, cr)]);
+                    sg = OFstatic_cast(Sint32, y) - OFstatic_cast(Sint32, gcb_tab[OFstatic_cast(Uint32, cb)]) - OFstatic_cast(Sint32, gcr_tab[OFstatic_cast(Uint32, cr)]);
+                    sb = OFstatic_cast(Sint32, y) + OFstatic_cast(Sint32, bcb_tab[OFstatic_cast(Uint32, cb)]);
+                    *(r++) = (sr < 0) ? 0 : (sr > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sr);
+                    *(g++) = (sg < 0) ? 0 : (sg > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sg);
+                    *(b++) = (sb < 0) ? 0 : (sb > OFstatic_cast(Sint32, maxvalue)) ? maxvalue : OFstatic_cast(T2, sb);
+                }
+            }
+        }
+        else
+        {
+            if (this->PlanarConfiguration)
+            {
+                /* start within the frame that contains the first pixel */
+                register const T1 *y = pixel + (first / planeSize) * 3 * planeSize + first % planeSize;
+                register const T1 *cb = y + planeSize;
+                register const T1 *cr = cb + planeSize;
+                register unsigned long l = planeSize - first % planeSize;
+                register unsigned long i = last - first;
+                while (i != 0)
+                {
+                    /* convert a single frame */
+                    for (; (l != 0) && (i != 0); --l, --i)
+                    {
+                        convertValue(*(r++), *(g++), *(b++), removeSign(*(y++), offset), removeSign(*(cb++), offset),
+                            removeSign(*(cr++), offset), maxvalue);
+                    }
+                    /* jump to next frame start (skip 2 planes) */
+                    y += 2 * planeSize;
+                    cb += 2 * planeSize;
+                    cr += 2 * planeSize;
+                    l = planeSize;
+                }
+            }
+            else
+            {
+                register const T1 *p = pixel + 3 * first;
+                register T2 y;
+                register T2 cb;
+                register T2 cr;
+                register unsigned long i;
+                for (i = last - first; i != 0; --i)
+                {
+                    y = removeSign(*(p++), offset);
+                    cb = removeSign(*(p++), offset);
+                    cr = removeSign(*(p++), offset);
+                    convertValue(*(r++), *(g++), *(b++), y, cb, cr, maxvalue);
+                }
+            }
+        }
+    }
+
     /** convert a single YCbCr value to RGB
      */
     inline void convertValue(T2 &red, T2 &green, T2 &blue, const T2 y, const T2 cb, const T2 cr, const T2 maxvalue)
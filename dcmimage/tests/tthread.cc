@@ -0,0 +1,143 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimage
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for multi-threaded conversion, scaling and
+ *           rendering of color images
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmimgle/dcmimage.h"
+#include "dcmtk/dcmimgle/dithread.h"
+#include "dcmtk/dcmimage/diregist.h"  /* include to support color images */
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
+/* image size, large enough for four threads processing at least 64k pixels each */
+#define THREAD_COLUMNS 512
+#define THREAD_ROWS 512
+#define THREAD_FRAMES 3
+
+
+/* create a multi-frame color image with three planes of 8 bits */
+static void createDataset(DcmDataset &dataset, const char *photometricInterpretation, const Uint16 planarConfiguration)
+{
+    const unsigned long frameSize = OFstatic_cast(unsigned long, THREAD_COLUMNS) * THREAD_ROWS;
+    const unsigned long count = frameSize * THREAD_FRAMES * 3;
+    Uint8 *pixels = new Uint8[count];
+    Uint32 seed = 4711;
+    for (unsigned long i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        // each sample of each pixel gets a different value
+        const unsigned long pixel = (planarConfiguration == 0) ? i / 3 : (i / (frameSize * 3)) * frameSize + i % frameSize;
+        const unsigned long sample = (planarConfiguration == 0) ? i % 3 : (i / frameSize) % 3;
+        const unsigned long x = pixel % THREAD_COLUMNS;
+        const unsigned long y = (pixel / THREAD_COLUMNS) % THREAD_ROWS;
+        pixels[i] = OFstatic_cast(Uint8, x * (sample + 1) + y * (3 - sample) + pixel / frameSize * 50 + (seed >> 29));
+    }
+    OFCHECK(dataset.putAndInsertString(DCM_PhotometricInterpretation, photometricInterpretation).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_SamplesPerPixel, 3).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_PlanarConfiguration, planarConfiguration).good());
+    OFCHECK(dataset.putAndInsertString(DCM_NumberOfFrames, "3").good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_Rows, THREAD_ROWS).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_Columns, THREAD_COLUMNS).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_BitsAllocated, 8).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_BitsStored, 8).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_HighBit, 7).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+    OFCHECK(dataset.putAndInsertUint8Array(DCM_PixelData, pixels, count).good());
+    delete[] pixels;
+}
+
+
+/* scale (if width > 0) and render all frames of the image with the given number
+ * of threads.  The output data of all frames is returned in a single buffer.
+ */
+static Uint8 *renderFrames(DcmDataset &dataset, const Uint32 threads, const int planar, const unsigned long width,
+                           const unsigned long height, const int interpolate, unsigned long &size)
+{
+    dcmImageProcessingThreads.set(threads);
+    Uint8 *buffer = NULL;
+    size = 0;
+    DicomImage image(&dataset, EXS_LittleEndianExplicit);
+    OFCHECK_EQUAL(image.getStatus(), EIS_Normal);
+    OFCHECK_EQUAL(image.getFrameCount(), THREAD_FRAMES);
+    OFCHECK(!image.isMonochrome());
+    DicomImage *scaled = (width > 0) ? image.createScaledImage(width, height, interpolate) : &image;
+    OFCHECK(scaled != NULL);
+    if (scaled != NULL)
+    {
+        const unsigned long frameSize = scaled->getOutputDataSize(8);
+        size = frameSize * scaled->getFrameCount();
+        buffer = new Uint8[size];
+        memset(buffer, 0, size);
+        for (unsigned long frame = 0; frame < scaled->getFrameCount(); ++frame)
+            OFCHECK(scaled->getOutputData(buffer + frame * frameSize, frameSize, 8, frame, planar));
+        if (scaled != &image)
+            delete scaled;
+    }
+    return buffer;
+}
+
+
+/* compare the output of a single thread with the output of four threads */
+static void checkThreads(DcmDataset &dataset, const int planar, const unsigned long width = 0,
+                         const unsigned long height = 0, const int interpolate = 0)
+{
+    unsigned long expectedSize = 0;
+    unsigned long resultSize = 0;
+    Uint8 *expected = renderFrames(dataset, 1, planar, width, height, interpolate, expectedSize);
+    Uint8 *result = renderFrames(dataset, 4, planar, width, height, interpolate, resultSize);
+    OFCHECK(expectedSize > 0);
+    OFCHECK_EQUAL(resultSize, expectedSize);
+    OFCHECK((expected != NULL) && (result != NULL) && (resultSize == expectedSize) &&
+        (memcmp(result, expected, expectedSize) == 0));
+    delete[] result;
+    delete[] expected;
+}
+
+
+OFTEST(dcmimage_multiThreadedProcessing)
+{
+    const Uint32 threads = dcmImageProcessingThreads.get();
+    // RGB is copied, YBR_FULL is converted to RGB in parallel
+    const char *photometricInterpretations[2] = { "RGB", "YBR_FULL" };
+    for (int i = 0; i < 2; ++i)
+    {
+        for (Uint16 planarConfiguration = 0; planarConfiguration < 2; ++planarConfiguration)
+        {
+            DcmDataset dataset;
+            createDataset(dataset, photometricInterpretations[i], planarConfiguration);
+            // rendering color-by-pixel and color-by-plane
+            checkThreads(dataset, 0);
+            checkThreads(dataset, 1);
+            // scaling with pbmplus interpolation
+            checkThreads(dataset, 0, 700, 300, 1);
+            // magnification and reduction with c't interpolation
+            checkThreads(dataset, 0, 768, 640, 2);
+            checkThreads(dataset, 1, 400, 448, 2);
+        }
+    }
+    dcmImageProcessingThreads.set(threads);
+}
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1996-2011, OFFIS e.V.
+ *  Copyright (C) 1996-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -133,6 +133,155 @@ class DCMTK_DCMIMGLE_EXPORT DiMonoOutputPixel
      */
     virtual void determineUsedValues() = 0;
 
+    /** apply an optimization LUT to the given pixel values, i.e. replace each pixel
+     *  value by the corresponding LUT entry.  The specialized versions for 8-bit output
+     *  load eight LUT entries at a time using vector gather instructions if available,
+     *  i.e. if the library has been compiled for a target that supports AVX2 or (with
+     *  gcc and clang) if the CPU supports AVX2 at runtime.
+     *
+     ** @param  src    pointer to the pixel values (intermediate representation)
+     *  @param  dst    pointer to the output buffer
+     *  @param  lut0   pointer to the LUT entry for the pixel value 0.  The LUT must
+     *                 contain (at least) three additional entries after the last one.
+     *  @param  count  number of pixels to be processed
+     */
+    static void applyOptimizationLUT(const Uint8 *src,
+                                     Uint8 *dst,
+                                     const Uint8 *lut0,
+                                     const unsigned long count);
+
+    /** apply an optimization LUT (see above)
+     */
+    static void applyOptimizationLUT(const Sint8 *src,
+                                     Uint8 *dst,
+                                     const Uint8 *lut0,
+                                     const unsigned long count);
+
+    /** apply an optimization LUT (see above)
+     */
+    static void applyOptimizationLUT(const Uint16 *src,
+                                     Uint8 *dst,
+                                     const Uint8 *lut0,
+                                     const unsigned long count);
+
+    /** apply an optimization LUT (see above)
+     */
+    static void applyOptimizationLUT(const Sint16 *src,
+                                     Uint8 *dst,
+                                     const Uint8 *lut0,
+                                     const unsigned long count);
+
+    /** apply an optimization LUT (see above).  Generic version for all other data types.
+     */
+    template<class T1, class T3>
+    static void applyOptimizationLUT(const T1 *src,
+                                     T3 *dst,
+                                     const T3 *lut0,
+                                     const unsigned long count)
+    {
+        for (unsigned long i = count; i != 0; --i)
+            *(dst++) = *(lut0 + (*(src++)));
+    }
+
+    /** apply a linear VOI window to the given pixel values (without presentation LUT
+     *  and display function).  The specialized versions for 8-bit output process four
+     *  pixels at a time using vector instructions if available (SSE2).  The results
+     *  are identical to the ones of the generic version.
+     *
+     ** @param  src          pointer to the pixel values (intermediate representation)
+     *  @param  dst          pointer to the output buffer
+     *  @param  count        number of pixels to be processed
+     *  @param  leftBorder   pixel values less than or equal to this border are mapped to 'low'
+     *  @param  rightBorder  pixel values greater than this border are mapped to 'high'
+     *  @param  offset       offset of the linear function used for all other pixel values
+     *  @param  gradient     gradient of the linear function used for all other pixel values
+     *  @param  low          lowest pixel value for the output data (e.g. 0)
+     *  @param  high         highest pixel value for the output data (e.g. 255)
+     */
+    static void applyLinearWindow(const Uint8 *src,
+                                  Uint8 *dst,
+                                  const unsigned long count,
+                                  const double leftBorder,
+                                  const double rightBorder,
+                                  const double offset,
+                                  const double gradient,
+                                  const Uint8 low,
+                                  const Uint8 high);
+
+    /** apply a linear VOI window (see above)
+     */
+    static void applyLinearWindow(const Sint8 *src,
+                                  Uint8 *dst,
+                                  const unsigned long count,
+                                  const double leftBorder,
+                                  const double rightBorder,
+                                  const double offset,
+                                  const double gradient,
+                                  const Uint8 low,
+                                  const Uint8 high);
+
+    /** apply a linear VOI window (see above)
+     */
+    static void applyLinearWindow(const Uint16 *src,
+                                  Uint8 *dst,
+                                  const unsigned long count,
+                                  const double leftBorder,
+                                  const double rightBorder,
+                                  const double offset,
+                                  const double gradient,
+                                  const Uint8 low,
+                                  const Uint8 high);
+
+    /** apply a linear VOI window (see above)
+     */
+    static void applyLinearWindow(const Sint16 *src,
+                                  Uint8 *dst,
+                                  const unsigned long count,
+                                  const double leftBorder,
+                                  const double rightBorder,
+                                  const double offset,
+                                  const double gradient,
+                                  const Uint8 low,
+                                  const Uint8 high);
+
+    /** apply a linear VOI window (see above)
+     */
+    static void applyLinearWindow(const Sint32 *src,
+                                  Uint8 *dst,
+                                  const unsigned long count,
+                                  const double leftBorder,
+                                  const double rightBorder,
+                                  const double offset,
+                                  const double gradient,
+                                  const Uint8 low,
+                                  const Uint8 high);
+
+    /** apply a linear VOI window (see above).  Generic version for all other data types.
+     */
+    template<class T1, class T3>
+    static void applyLinearWindow(const T1 *src,
+                                  T3 *dst,
+                                  const unsigned long count,
+                                  const double leftBorder,
+                                  const double rightBorder,
+                                  const double offset,
+                                  const double gradient,
+                                  const T3 low,
+                                  const T3 high)
+    {
+        double value;
+        for (unsigned long i = count; i != 0; --i)
+        {
+            value = OFstatic_cast(double, *(src++));
+            if (value <= leftBorder)
+                *(dst++) = low;                                             // black/white
+            else if (value > rightBorder)
+                *(dst++) = high;                                            // white/black
+            else
+                *(dst++) = OFstatic_cast(T3, offset + value * gradient);    // gray value
+        }
+    }
+
 
     /// number of pixels per frame (intermediate representation)
     /*const*/ unsigned long Count;
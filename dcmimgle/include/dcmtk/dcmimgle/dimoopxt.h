@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1996-2013, OFFIS e.V.
+ *  Copyright (C) 1996-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -35,6 +35,7 @@
 #include "dcmtk/dcmimgle/dipxrept.h"
 #include "dcmtk/dcmimgle/didispfn.h"
 #include "dcmtk/dcmimgle/didislut.h"
+#include "dcmtk/dcmimgle/dithread.h"
 
 #ifdef PASTEL_COLOR_OUTPUT
 #include "dimcopxt.h"
@@ -251,6 +252,133 @@ class DiMonoOutputPixelTemplate
 
  private:
 
+    /** Helper class applying the optimization LUT to bands of pixels in parallel
+     */
+    class LUTTask
+      : public DiThreadedTask
+    {
+
+     public:
+
+        /** constructor
+         *
+         ** @param  src   pointer to the pixel values (intermediate representation)
+         *  @param  dst   pointer to the output buffer
+         *  @param  lut0  pointer to the LUT entry for the pixel value 0
+         */
+        LUTTask(const T1 *src,
+                T3 *dst,
+                const T3 *lut0)
+          : Src(src),
+            Dst(dst),
+            Lut0(lut0)
+        {
+        }
+
+     protected:
+
+        /** apply the LUT to the given range of pixels
+         *
+         ** @param  first  index of the first pixel
+         *  @param  last   index of the pixel following the last one
+         */
+        virtual void process(const unsigned long first,
+                             const unsigned long last)
+        {
+            DiMonoOutputPixel::applyOptimizationLUT(Src + first, Dst + first, Lut0, last - first);
+        }
+
+     private:
+
+        /// pointer to the pixel values
+        const T1 *Src;
+        /// pointer to the output buffer
+        T3 *Dst;
+        /// pointer to the LUT entry for the pixel value 0
+        const T3 *Lut0;
+
+     // --- declarations to avoid compiler warnings
+
+        LUTTask(const LUTTask &);
+        LUTTask &operator=(const LUTTask &);
+    };
+
+    /** Helper class applying the linear VOI window to bands of pixels in parallel
+     */
+    class WindowTask
+      : public DiThreadedTask
+    {
+
+     public:
+
+        /** constructor
+         *
+         ** @param  src          pointer to the pixel values (intermediate representation)
+         *  @param  dst          pointer to the output buffer
+         *  @param  leftBorder   pixel values less than or equal to this border are mapped to 'low'
+         *  @param  rightBorder  pixel values greater than this border are mapped to 'high'
+         *  @param  offset       offset of the linear function used for all other pixel values
+         *  @param  gradient     gradient of the linear function used for all other pixel values
+         *  @param  low          lowest pixel value for the output data
+         *  @param  high         highest pixel value for the output data
+         */
+        WindowTask(const T1 *src,
+                   T3 *dst,
+                   const double leftBorder,
+                   const double rightBorder,
+                   const double offset,
+                   const double gradient,
+                   const T3 low,
+                   const T3 high)
+          : Src(src),
+            Dst(dst),
+            LeftBorder(leftBorder),
+            RightBorder(rightBorder),
+            Offset(offset),
+            Gradient(gradient),
+            Low(low),
+            High(high)
+        {
+        }
+
+     protected:
+
+        /** apply the window to the given range of pixels
+         *
+         ** @param  first  index of the first pixel
+         *  @param  last   index of the pixel following the last one
+         */
+        virtual void process(const unsigned long first,
+                             const unsigned long last)
+        {
+            DiMonoOutputPixel::applyLinearWindow(Src + first, Dst + first, last - first, LeftBorder, RightBorder, Offset, Gradient, Low, High);
+        }
+
+     private:
+
+        /// pointer to the pixel values
+        const T1 *Src;
+        /// pointer to the output buffer
+        T3 *Dst;
+        /// left window border
+        const double LeftBorder;
+        /// right window border
+        const double RightBorder;
+        /// offset of the linear function
+        const double Offset;
+        /// gradient of the linear function
+        const double Gradient;
+        /// lowest output value
+        const T3 Low;
+        /// highest output value
+        const T3 High;
+
+     // --- declarations to avoid compiler warnings
+
+        WindowTask(const WindowTask &);
+        WindowTask &operator=(const WindowTask &);
+    };
+
     /** create a display LUT with the specified number of input bits
      *
      ** @param  dlut  reference to storage area where the display LUT should be stored
@@ -285,7 +413,7 @@ class DiMonoOutputPixelTemplate
         int result = 0;
         if ((sizeof(T1) <= 2) && (Count > 3 * ocnt))                          // optimization criteria
         {                                                                     // use LUT for optimization
-            lut = new T3[ocnt];
+            lut = new T3[ocnt + 3];                                           // see applyOptimizationLUT()
             if (lut != NULL)
             {
                 DCMIMGLE_DEBUG("using optimized routine with additional LUT (" << ocnt << " entries)");
@@ -438,9 +566,8 @@ class DiMonoOutputPixelTemplate
                                 }
                             }
                             const T3 *lut0 = lut - OFstatic_cast(T2, inter->getAbsMinimum());  // points to 'zero' entry
-                            q = Data;
-                            for (i = Count; i != 0; --i)                                  // apply LUT
-                                *(q++) = *(lut0 + (*(p++)));
+                            LUTTask task(p, Data, lut0);                      // apply LUT
+                            task.run(Count);
                         }
                         if (lut == NULL)                                                  // use "normal" transformation
                         {
@@ -538,9 +665,8 @@ class DiMonoOutputPixelTemplate
                                 }
                             }
                             const T3 *lut0 = lut - OFstatic_cast(T2, inter->getAbsMinimum());   // points to 'zero' entry
-                            q = Data;
-                            for (i = Count; i != 0; --i)                                  // apply LUT
-                                *(q++) = *(lut0 + (*(p++)));
+                            LUTTask task(p, Data, lut0);                      // apply LUT
+                            task.run(Count);
                         }
                         if (lut == NULL)                                                  // use "normal" transformation
                         {
@@ -665,9 +791,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, inter->getAbsMinimum());  // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        LUTTask task(p, Data, lut0);                          // apply LUT
+                        task.run(Count);
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -721,9 +846,8 @@ class DiMonoOutputPixelTemplate
                                 *(q++) = OFstatic_cast(T3, OFstatic_cast(double, low) + OFstatic_cast(double, i) * gradient);
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, inter->getAbsMinimum());  // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        LUTTask task(p, Data, lut0);                          // apply LUT
+                        task.run(Count);
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -823,9 +947,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);             // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        LUTTask task(p, Data, lut0);                          // apply LUT
+                        task.run(Count);
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -877,9 +1000,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);             // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        LUTTask task(p, Data, lut0);                          // apply LUT
+                        task.run(Count);
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -996,9 +1118,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);             // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        LUTTask task(p, Data, lut0);                          // apply LUT
+                        task.run(Count);
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -1071,9 +1192,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);             // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        LUTTask task(p, Data, lut0);                          // apply LUT
+                        task.run(Count);
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -1096,16 +1216,8 @@ class DiMonoOutputPixelTemplate
                             DCMIMGLE_TRACE("monochrome rendering: VOI LINEAR #8");
                             const double offset = (width_1 == 0) ? 0 : (high - ((center - 0.5) / width_1 + 0.5) * outrange);
                             const double gradient = (width_1 == 0) ? 0 : outrange / width_1;
-                            for (i = Count; i != 0; --i)
-                            {
-                                value = OFstatic_cast(double, *(p++));
-                                if (value <= leftBorder)
-                                    *(q++) = low;                                            // black/white
-                                else if (value > rightBorder)
-                                    *(q++) = high;                                           // white/black
-                                else
-                                    *(q++) = OFstatic_cast(T3, offset + value * gradient);   // gray value
-                            }
+                            WindowTask task(p, q, leftBorder, rightBorder, offset, gradient, low, high);
+                            task.run(Count);
                         }
                     }
                 }
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1996-2014, OFFIS e.V.
+ *  Copyright (C) 1996-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -29,6 +29,7 @@
 
 #include "dcmtk/dcmimgle/ditranst.h"
 #include "dcmtk/dcmimgle/dipxrept.h"
+#include "dcmtk/dcmimgle/dithread.h"
 
 
 /*---------------------*
@@ -248,6 +249,65 @@ class DiScaleTemplate
 
  private:
 
+    /** Helper class processing bands of rows of the destination image in parallel
+     */
+    class ScaleTask
+      : public DiThreadedTask
+    {
+
+     public:
+
+        /// type of the method processing a range of rows
+        typedef void (DiScaleTemplate<T>::*RowMethod)(const T *[], T *[], const unsigned long, const unsigned long);
+
+        /** constructor
+         *
+         ** @param  scale   scaling object
+         *  @param  method  method processing a range of rows
+         *  @param  src     array of pointers to source image pixels
+         *  @param  dest    array of pointers to destination image pixels
+         */
+        ScaleTask(DiScaleTemplate<T> &scale,
+                  RowMethod method,
+                  const T *src[],
+                  T *dest[])
+          : Scale(scale),
+            Method(method),
+            Src(src),
+            Dest(dest)
+        {
+        }
+
+     protected:
+
+        /** process the given range of rows
+         *
+         ** @param  first  index of the first row
+         *  @param  last   index of the row following the last one
+         */
+        virtual void process(const unsigned long first,
+                             const unsigned long last)
+        {
+            (Scale.*Method)(Src, Dest, first, last);
+        }
+
+     private:
+
+        /// scaling object
+        DiScaleTemplate<T> &Scale;
+        /// method processing a range of rows
+        const RowMethod Method;
+        /// array of pointers to source image pixels
+        const T **Src;
+        /// array of pointers to destination image pixels
+        T **Dest;
+
+     // --- declarations to avoid compiler warnings
+
+        ScaleTask(const ScaleTask &);
+        ScaleTask &operator=(const ScaleTask &);
+    };
+
     /** clip image to specified area (only inside image boundaries).
      *  This is an optimization of the more general method clipBorderPixel().
      *
@@ -535,7 +595,23 @@ class DiScaleTemplate
             this->Src_X = Columns;            // temporarily removed 'const' for 'Src_X' in class 'DiTransTemplate'
             this->Src_Y = Rows;               //                             ... 'Src_Y' ...
         }
+        ScaleTask task(*this, &DiScaleTemplate<T>::interpolateRows, src, dest);
+        task.run(this->Planes * this->Frames * this->Dest_Y, this->Dest_X);
+    }
 
+    /** free scaling method with interpolation, process the given range of rows.
+     *  The rows of all frames and planes are numbered consecutively.
+     *
+     ** @param  src    array of pointers to source image pixels
+     *  @param  dest   array of pointers to destination image pixels
+     *  @param  first  index of the first row of the destination image
+     *  @param  last   index of the row following the last one
+     */
+    void interpolateRows(const T *src[],
+                         T *dest[],
+                         const unsigned long first,
+                         const unsigned long last)
+    {
         /*
          *   based on scaling algorithm from "Extended Portable Bitmap Toolkit" (pbmplus10dec91)
          *   (adapted to be used with signed pixel representation, inverse images - mono1,
@@ -553,6 +629,8 @@ class DiScaleTemplate
         const unsigned long sxscale = OFstatic_cast(unsigned long, (OFstatic_cast(double, this->Dest_X) / OFstatic_cast(double, this->Src_X)) * SCALE_FACTOR);
         const unsigned long syscale = OFstatic_cast(unsigned long, (OFstatic_cast(double, this->Dest_Y) / OFstatic_cast(double, this->Src_Y)) * SCALE_FACTOR);
         const signed long maxvalue = DicomImageClass::maxval(this->Bits - isSigned());
+        const unsigned long f_size = OFstatic_cast(unsigned long, this->Src_X) * OFstatic_cast(unsigned long, this->Src_Y);
+        const unsigned long p_rows = OFstatic_cast(unsigned long, this->Frames) * OFstatic_cast(unsigned long, this->Dest_Y);
 
         T *xtemp = new T[this->Src_X];
         signed long *xvalue = new signed long[this->Src_X];
@@ -560,52 +638,69 @@ class DiScaleTemplate
         if ((xtemp == NULL) || (xvalue == NULL))
         {
             DCMIMGLE_ERROR("can't allocate temporary buffers for interpolation scaling");
-            this->clearPixel(dest);
+            for (unsigned long row = first; row < last; ++row)
+                OFBitmanipTemplate<T>::zeroMem(dest[row / p_rows] + (row % p_rows) * this->Dest_X, this->Dest_X);
         } else {
-            for (int j = 0; j < this->Planes; ++j)
+            unsigned long row = first;
+            while (row < last)
             {
-                fp = src[j];
-                sq = dest[j];
-                for (unsigned long f = this->Frames; f != 0; --f)
+                // process the rows of the current frame that belong to the given range.  Since the
+                // vertical interpolation depends on the preceding rows, its state is determined
+                // from the beginning of the frame (without calculating the pixel values).
+                const int j = OFstatic_cast(int, row / p_rows);
+                const unsigned long f = (row % p_rows) / this->Dest_Y;
+                const Uint16 ystart = OFstatic_cast(Uint16, row % this->Dest_Y);
+                const Uint16 yend = (last - row < OFstatic_cast(unsigned long, this->Dest_Y - ystart)) ?
+                    OFstatic_cast(Uint16, ystart + (last - row)) : this->Dest_Y;
+                fp = src[j] + f * f_size;
+                sq = dest[j] + (row % p_rows) * this->Dest_X;
+                for (x = 0; x < this->Src_X; ++x)
+                    xvalue[x] = HALFSCALE_FACTOR;
+                register unsigned long yfill = SCALE_FACTOR;
+                register unsigned long yleft = syscale;
+                register int yneed = 1;
+                int ysrc = 0;
+                for (y = 0; y < yend; ++y)
                 {
-                    for (x = 0; x < this->Src_X; ++x)
-                        xvalue[x] = HALFSCALE_FACTOR;
-                    register unsigned long yfill = SCALE_FACTOR;
-                    register unsigned long yleft = syscale;
-                    register int yneed = 1;
-                    int ysrc = 0;
-                    for (y = 0; y < this->Dest_Y; ++y)
+                    const OFBool compute = (y >= ystart);
+                    if (this->Src_Y == this->Dest_Y)
                     {
-                        if (this->Src_Y == this->Dest_Y)
+                        sp = fp;
+                        if (compute)
                         {
-                            sp = fp;
                             for (x = this->Src_X, p = sp, q = xtemp; x != 0; --x)
                                 *(q++) = *(p++);
-                            fp += this->Src_X;
                         }
-                        else
+                        fp += this->Src_X;
+                    }
+                    else
+                    {
+                        while (yleft < yfill)
                         {
-                            while (yleft < yfill)
-                            {
-                                if (yneed && (ysrc < OFstatic_cast(int, this->Src_Y)))
-                                {
-                                    sp = fp;
-                                    fp += this->Src_X;
-                                    ++ysrc;
-                                }
-                                for (x = 0, p = sp; x < this->Src_X; ++x)
-                                    xvalue[x] += yleft * OFstatic_cast(signed long, *(p++));
-                                yfill -= yleft;
-                                yleft = syscale;
-                                yneed = 1;
-                            }
                             if (yneed && (ysrc < OFstatic_cast(int, this->Src_Y)))
                             {
                                 sp = fp;
                                 fp += this->Src_X;
                                 ++ysrc;
-                                yneed = 0;
                             }
+                            if (compute)
+                            {
+                                for (x = 0, p = sp; x < this->Src_X; ++x)
+                                    xvalue[x] += yleft * OFstatic_cast(signed long, *(p++));
+                            }
+                            yfill -= yleft;
+                            yleft = syscale;
+                            yneed = 1;
+                        }
+                        if (yneed && (ysrc < OFstatic_cast(int, this->Src_Y)))
+                        {
+                            sp = fp;
+                            fp += this->Src_X;
+                            ++ysrc;
+                            yneed = 0;
+                        }
+                        if (compute)
+                        {
                             register signed long v;
                             for (x = 0, p = sp, q = xtemp; x < this->Src_X; ++x)
                             {
@@ -614,67 +709,70 @@ class DiScaleTemplate
                                 *(q++) = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
                                 xvalue[x] = HALFSCALE_FACTOR;
                             }
-                            yleft -= yfill;
-                            if (yleft == 0)
-                            {
-                                yleft = syscale;
-                                yneed = 1;
-                            }
-                            yfill = SCALE_FACTOR;
                         }
-                        if (this->Src_X == this->Dest_X)
+                        yleft -= yfill;
+                        if (yleft == 0)
                         {
-                            for (x = this->Dest_X, p = xtemp, q = sq; x != 0; --x)
-                                *(q++) = *(p++);
-                            sq += this->Dest_X;
+                            yleft = syscale;
+                            yneed = 1;
                         }
-                        else
+                        yfill = SCALE_FACTOR;
+                    }
+                    if (!compute)
+                        continue;
+                    if (this->Src_X == this->Dest_X)
+                    {
+                        for (x = this->Dest_X, p = xtemp, q = sq; x != 0; --x)
+                            *(q++) = *(p++);
+                        sq += this->Dest_X;
+                    }
+                    else
+                    {
+                        register signed long v = HALFSCALE_FACTOR;
+                        register unsigned long xfill = SCALE_FACTOR;
+                        register unsigned long xleft;
+                        register int xneed = 0;
+                        q = sq;
+                        for (x = 0, p = xtemp; x < this->Src_X; ++x, ++p)
                         {
-                            register signed long v = HALFSCALE_FACTOR;
-                            register unsigned long xfill = SCALE_FACTOR;
-                            register unsigned long xleft;
-                            register int xneed = 0;
-                            q = sq;
-                            for (x = 0, p = xtemp; x < this->Src_X; ++x, ++p)
+                            xleft = sxscale;
+                            while (xleft >= xfill)
                             {
-                                xleft = sxscale;
-                                while (xleft >= xfill)
+                                if (xneed)
                                 {
-                                    if (xneed)
-                                    {
-                                        ++q;
-                                        v = HALFSCALE_FACTOR;
-                                    }
-                                    v += xfill * OFstatic_cast(signed long, *p);
-                                    v /= SCALE_FACTOR;
-                                    *q = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
-                                    xleft -= xfill;
-                                    xfill = SCALE_FACTOR;
-                                    xneed = 1;
+                                    ++q;
+                                    v = HALFSCALE_FACTOR;
                                 }
-                                if (xleft > 0)
-                                {
-                                    if (xneed)
-                                    {
-                                        ++q;
-                                        v = HALFSCALE_FACTOR;
-                                        xneed = 0;
-                                    }
-                                    v += xleft * OFstatic_cast(signed long, *p);
-                                    xfill -= xleft;
-                                }
-                            }
-                            if (xfill > 0)
-                                v += xfill * OFstatic_cast(signed long, *(--p));
-                            if (!xneed)
-                            {
+                                v += xfill * OFstatic_cast(signed long, *p);
                                 v /= SCALE_FACTOR;
                                 *q = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
+                                xleft -= xfill;
+                                xfill = SCALE_FACTOR;
+                                xneed = 1;
+                            }
+                            if (xleft > 0)
+                            {
+                                if (xneed)
+                                {
+                                    ++q;
+                                    v = HALFSCALE_FACTOR;
+                                    xneed = 0;
+                                }
+                                v += xleft * OFstatic_cast(signed long, *p);
+                                xfill -= xleft;
                             }
-                            sq += this->Dest_X;
                         }
+                        if (xfill > 0)
+                            v += xfill * OFstatic_cast(signed long, *(--p));
+                        if (!xneed)
+                        {
+                            v /= SCALE_FACTOR;
+                            *q = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
+                        }
+                        sq += this->Dest_X;
                     }
                 }
+                row += yend - ystart;
             }
         }
         delete[] xtemp;
@@ -691,9 +789,27 @@ class DiScaleTemplate
                      T *dest[])
     {
         DCMIMGLE_DEBUG("using expand pixel scaling algorithm with interpolation from c't magazine");
+        ScaleTask task(*this, &DiScaleTemplate<T>::expandRows, src, dest);
+        task.run(this->Planes * this->Frames * this->Dest_Y, this->Dest_X);
+    }
+
+    /** free scaling method with interpolation (only for magnification), process the
+     *  given range of rows.  The rows of all frames and planes are numbered consecutively.
+     *
+     ** @param  src    array of pointers to source image pixels
+     *  @param  dest   array of pointers to destination image pixels
+     *  @param  first  index of the first row of the destination image
+     *  @param  last   index of the row following the last one
+     */
+    void expandRows(const T *src[],
+                    T *dest[],
+                    const unsigned long first,
+                    const unsigned long last)
+    {
         const double x_factor = OFstatic_cast(double, this->Src_X) / OFstatic_cast(double, this->Dest_X);
         const double y_factor = OFstatic_cast(double, this->Src_Y) / OFstatic_cast(double, this->Dest_Y);
         const unsigned long f_size = OFstatic_cast(unsigned long, Rows) * OFstatic_cast(unsigned long, Columns);
+        const unsigned long p_rows = OFstatic_cast(unsigned long, this->Frames) * OFstatic_cast(unsigned long, this->Dest_Y);
         const T *sp;
         double bx, ex;
         double by, ey;
@@ -717,90 +833,86 @@ class DiScaleTemplate
          *    various bit depths, multi-frame and multi-plane/color images, combined clipping/scaling)
          */
 
-        for (int j = 0; j < this->Planes; ++j)
+        for (unsigned long row = first; row < last; ++row)
         {
-            sp = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-            q = dest[j];
-            for (unsigned long f = 0; f < this->Frames; ++f)
+            const int j = OFstatic_cast(int, row / p_rows);
+            const unsigned long f = (row % p_rows) / this->Dest_Y;
+            y = OFstatic_cast(Uint16, row % this->Dest_Y);
+            sp = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left + f * f_size;
+            q = dest[j] + (row % p_rows) * this->Dest_X;
+            by = y_factor * OFstatic_cast(double, y);
+            ey = y_factor * (OFstatic_cast(double, y) + 1.0);
+            if (ey > this->Src_Y)
             {
-                for (y = 0; y < this->Dest_Y; ++y)
+#ifdef DEBUG    // this output is only useful for debugging purposes
+                DCMIMGLE_TRACE("  limiting value of 'ey' to 'Src_Y': " << ey << " -> " << this->Src_Y);
+#endif
+                // see reducePixel()
+                ey = this->Src_Y;
+            }
+            byi = OFstatic_cast(int, by);
+            eyi = OFstatic_cast(int, ey);
+            if (OFstatic_cast(double, eyi) == ey)
+            {
+#ifdef DEBUG    // this output is only useful for debugging purposes
+                DCMIMGLE_TRACE("  decreasing value of 'eyi' by 1: " << eyi << " -> " << (eyi - 1));
+#endif
+                --eyi;
+            }
+            y_part = OFstatic_cast(double, eyi) / y_factor;
+            b_factor = y_part - OFstatic_cast(double, y);
+            t_factor = (OFstatic_cast(double, y) + 1.0) - y_part;
+            for (x = 0; x < this->Dest_X; ++x)
+            {
+                value = 0;
+                bx = x_factor * OFstatic_cast(double, x);
+                ex = x_factor * (OFstatic_cast(double, x) + 1.0);
+                if (ex > this->Src_X)
                 {
-                    by = y_factor * OFstatic_cast(double, y);
-                    ey = y_factor * (OFstatic_cast(double, y) + 1.0);
-                    if (ey > this->Src_Y)
-                    {
-#ifdef DEBUG            // this output is only useful for debugging purposes
-                        DCMIMGLE_TRACE("  limiting value of 'ey' to 'Src_Y': " << ey << " -> " << this->Src_Y);
+#ifdef DEBUG        // this output is only useful for debugging purposes
+                    DCMIMGLE_TRACE("  limiting value of 'ex' to 'Src_X': " << ex << " -> " << this->Src_X);
 #endif
-                        // see reducePixel()
-                        ey = this->Src_Y;
-                    }
-                    byi = OFstatic_cast(int, by);
-                    eyi = OFstatic_cast(int, ey);
-                    if (OFstatic_cast(double, eyi) == ey)
-                    {
-#ifdef DEBUG            // this output is only useful for debugging purposes
-                        DCMIMGLE_TRACE("  decreasing value of 'eyi' by 1: " << eyi << " -> " << (eyi - 1));
+                    // see reducePixel()
+                    ex = this->Src_X;
+                }
+                bxi = OFstatic_cast(int, bx);
+                exi = OFstatic_cast(int, ex);
+                if (OFstatic_cast(double, exi) == ex)
+                {
+#ifdef DEBUG        // this output is only useful for debugging purposes
+                    DCMIMGLE_TRACE("  decreasing value of 'exi' by 1: " << exi << " -> " << (exi - 1));
 #endif
-                        --eyi;
-                    }
-                    y_part = OFstatic_cast(double, eyi) / y_factor;
-                    b_factor = y_part - OFstatic_cast(double, y);
-                    t_factor = (OFstatic_cast(double, y) + 1.0) - y_part;
-                    for (x = 0; x < this->Dest_X; ++x)
+                    --exi;
+                }
+                x_part = OFstatic_cast(double, exi) / x_factor;
+                l_factor = x_part - OFstatic_cast(double, x);
+                r_factor = (OFstatic_cast(double, x) + 1.0) - x_part;
+                offset = OFstatic_cast(unsigned long, byi) * OFstatic_cast(unsigned long, Columns);
+                for (yi = byi; yi <= eyi; ++yi)
+                {
+                    p = sp + offset + bxi;
+                    for (xi = bxi; xi <= exi; ++xi)
                     {
-                        value = 0;
-                        bx = x_factor * OFstatic_cast(double, x);
-                        ex = x_factor * (OFstatic_cast(double, x) + 1.0);
-                        if (ex > this->Src_X)
-                        {
-#ifdef DEBUG                // this output is only useful for debugging purposes
-                            DCMIMGLE_TRACE("  limiting value of 'ex' to 'Src_X': " << ex << " -> " << this->Src_X);
-#endif
-                            // see reducePixel()
-                            ex = this->Src_X;
-                        }
-                        bxi = OFstatic_cast(int, bx);
-                        exi = OFstatic_cast(int, ex);
-                        if (OFstatic_cast(double, exi) == ex)
+                        sum = OFstatic_cast(double, *(p++));
+                        if (bxi != exi)
                         {
-#ifdef DEBUG                // this output is only useful for debugging purposes
-                            DCMIMGLE_TRACE("  decreasing value of 'exi' by 1: " << exi << " -> " << (exi - 1));
-#endif
-                            --exi;
+                            if (xi == bxi)
+                                sum *= l_factor;
+                            else
+                                sum *= r_factor;
                         }
-                        x_part = OFstatic_cast(double, exi) / x_factor;
-                        l_factor = x_part - OFstatic_cast(double, x);
-                        r_factor = (OFstatic_cast(double, x) + 1.0) - x_part;
-                        offset = OFstatic_cast(unsigned long, byi) * OFstatic_cast(unsigned long, Columns);
-                        for (yi = byi; yi <= eyi; ++yi)
+                        if (byi != eyi)
                         {
-                            p = sp + offset + bxi;
-                            for (xi = bxi; xi <= exi; ++xi)
-                            {
-                                sum = OFstatic_cast(double, *(p++));
-                                if (bxi != exi)
-                                {
-                                    if (xi == bxi)
-                                        sum *= l_factor;
-                                    else
-                                        sum *= r_factor;
-                                }
-                                if (byi != eyi)
-                                {
-                                    if (yi == byi)
-                                        sum *= b_factor;
-                                    else
-                                        sum *= t_factor;
-                                }
-                                value += sum;
-                            }
-                            offset += Columns;
+                            if (yi == byi)
+                                sum *= b_factor;
+                            else
+                                sum *= t_factor;
                         }
-                        *(q++) = OFstatic_cast(T, value + 0.5);
+                        value += sum;
                     }
+                    offset += Columns;
                 }
-                sp += f_size;
+                *(q++) = OFstatic_cast(T, value + 0.5);
             }
         }
     }
@@ -815,10 +927,28 @@ class DiScaleTemplate
                      T *dest[])
     {
         DCMIMGLE_DEBUG("using reduce pixel scaling algorithm with interpolation from c't magazine");
+        ScaleTask task(*this, &DiScaleTemplate<T>::reduceRows, src, dest);
+        task.run(this->Planes * this->Frames * this->Dest_Y, this->Dest_X);
+    }
+
+    /** free scaling method with interpolation (only for reduction), process the given
+     *  range of rows.  The rows of all frames and planes are numbered consecutively.
+     *
+     ** @param  src    array of pointers to source image pixels
+     *  @param  dest   array of pointers to destination image pixels
+     *  @param  first  index of the first row of the destination image
+     *  @param  last   index of the row following the last one
+     */
+    void reduceRows(const T *src[],
+                    T *dest[],
+                    const unsigned long first,
+                    const unsigned long last)
+    {
         const double x_factor = OFstatic_cast(double, this->Src_X) / OFstatic_cast(double, this->Dest_X);
         const double y_factor = OFstatic_cast(double, this->Src_Y) / OFstatic_cast(double, this->Dest_Y);
         const double xy_factor = x_factor * y_factor;
         const unsigned long f_size = OFstatic_cast(unsigned long, Rows) * OFstatic_cast(unsigned long, Columns);
+        const unsigned long p_rows = OFstatic_cast(unsigned long, this->Frames) * OFstatic_cast(unsigned long, this->Dest_Y);
         const T *sp;
         double bx, ex;
         double by, ey;
@@ -841,84 +971,80 @@ class DiScaleTemplate
          *    various bit depths, multi-frame and multi-plane/color images, combined clipping/scaling)
          */
 
-        for (int j = 0; j < this->Planes; ++j)
+        for (unsigned long row = first; row < last; ++row)
         {
-            sp = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-            q = dest[j];
-            for (unsigned long f = 0; f < this->Frames; ++f)
+            const int j = OFstatic_cast(int, row / p_rows);
+            const unsigned long f = (row % p_rows) / this->Dest_Y;
+            y = OFstatic_cast(Uint16, row % this->Dest_Y);
+            sp = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left + f * f_size;
+            q = dest[j] + (row % p_rows) * this->Dest_X;
+            by = y_factor * OFstatic_cast(double, y);
+            ey = y_factor * (OFstatic_cast(double, y) + 1.0);
+            if (ey > this->Src_Y)
             {
-                for (y = 0; y < this->Dest_Y; ++y)
-                {
-                    by = y_factor * OFstatic_cast(double, y);
-                    ey = y_factor * (OFstatic_cast(double, y) + 1.0);
-                    if (ey > this->Src_Y)
-                    {
-#ifdef DEBUG            // this output is only useful for debugging purposes
-                        DCMIMGLE_TRACE("  limiting value of 'ey' to 'Src_Y': " << ey << " -> " << this->Src_Y);
+#ifdef DEBUG    // this output is only useful for debugging purposes
+                DCMIMGLE_TRACE("  limiting value of 'ey' to 'Src_Y': " << ey << " -> " << this->Src_Y);
 #endif
-                        // yes, this can happen due to rounding, e.g. double(943) / double(471) * double(471)
-                        // is something like 943.00000000000011368683772161602974 and then, the eyi == ey check
-                        // fails to bring eyi back into range!
-                        ey = this->Src_Y;
-                    }
-                    byi = OFstatic_cast(int, by);
-                    eyi = OFstatic_cast(int, ey);
-                    if (OFstatic_cast(double, eyi) == ey)
-                    {
-#ifdef DEBUG            // this output is only useful for debugging purposes
-                        DCMIMGLE_TRACE("  decreasing value of 'eyi' by 1: " << eyi << " -> " << (eyi - 1));
+                // yes, this can happen due to rounding, e.g. double(943) / double(471) * double(471)
+                // is something like 943.00000000000011368683772161602974 and then, the eyi == ey check
+                // fails to bring eyi back into range!
+                ey = this->Src_Y;
+            }
+            byi = OFstatic_cast(int, by);
+            eyi = OFstatic_cast(int, ey);
+            if (OFstatic_cast(double, eyi) == ey)
+            {
+#ifdef DEBUG    // this output is only useful for debugging purposes
+                DCMIMGLE_TRACE("  decreasing value of 'eyi' by 1: " << eyi << " -> " << (eyi - 1));
 #endif
-                        --eyi;
-                    }
-                    b_factor = 1 + OFstatic_cast(double, byi) - by;
-                    t_factor = ey - OFstatic_cast(double, eyi);
-                    for (x = 0; x < this->Dest_X; ++x)
-                    {
-                        value = 0;
-                        bx = x_factor * OFstatic_cast(double, x);
-                        ex = x_factor * (OFstatic_cast(double, x) + 1.0);
-                        if (ex > this->Src_X)
-                        {
-#ifdef DEBUG                // this output is only useful for debugging purposes
-                            DCMIMGLE_TRACE("  limiting value of 'ex' to 'Src_X': " << ex << " -> " << this->Src_X);
+                --eyi;
+            }
+            b_factor = 1 + OFstatic_cast(double, byi) - by;
+            t_factor = ey - OFstatic_cast(double, eyi);
+            for (x = 0; x < this->Dest_X; ++x)
+            {
+                value = 0;
+                bx = x_factor * OFstatic_cast(double, x);
+                ex = x_factor * (OFstatic_cast(double, x) + 1.0);
+                if (ex > this->Src_X)
+                {
+#ifdef DEBUG        // this output is only useful for debugging purposes
+                    DCMIMGLE_TRACE("  limiting value of 'ex' to 'Src_X': " << ex << " -> " << this->Src_X);
 #endif
-                            // see above comment
-                            ex = this->Src_X;
-                        }
-                        bxi = OFstatic_cast(int, bx);
-                        exi = OFstatic_cast(int, ex);
-                        if (OFstatic_cast(double, exi) == ex)
-                        {
-#ifdef DEBUG                // this output is only useful for debugging purposes
-                            DCMIMGLE_TRACE("  decreasing value of 'exi' by 1: " << exi << " -> " << (exi - 1));
+                    // see above comment
+                    ex = this->Src_X;
+                }
+                bxi = OFstatic_cast(int, bx);
+                exi = OFstatic_cast(int, ex);
+                if (OFstatic_cast(double, exi) == ex)
+                {
+#ifdef DEBUG        // this output is only useful for debugging purposes
+                    DCMIMGLE_TRACE("  decreasing value of 'exi' by 1: " << exi << " -> " << (exi - 1));
 #endif
-                            --exi;
-                        }
-                        l_factor = 1 + OFstatic_cast(double, bxi) - bx;
-                        r_factor = ex - OFstatic_cast(double, exi);
-                        offset = OFstatic_cast(unsigned long, byi) * OFstatic_cast(unsigned long, Columns);
-                        for (yi = byi; yi <= eyi; ++yi)
-                        {
-                            p = sp + offset + bxi;
-                            for (xi = bxi; xi <= exi; ++xi)
-                            {
-                                sum = OFstatic_cast(double, *(p++)) / xy_factor;
-                                if (xi == bxi)
-                                    sum *= l_factor;
-                                else if (xi == exi)
-                                    sum *= r_factor;
-                                if (yi == byi)
-                                    sum *= b_factor;
-                                else if (yi == eyi)
-                                    sum *= t_factor;
-                                value += sum;
-                            }
-                            offset += Columns;
-                        }
-                        *(q++) = OFstatic_cast(T, value + 0.5);
+                    --exi;
+                }
+                l_factor = 1 + OFstatic_cast(double, bxi) - bx;
+                r_factor = ex - OFstatic_cast(double, exi);
+                offset = OFstatic_cast(unsigned long, byi) * OFstatic_cast(unsigned long, Columns);
+                for (yi = byi; yi <= eyi; ++yi)
+                {
+                    p = sp + offset + bxi;
+                    for (xi = bxi; xi <= exi; ++xi)
+                    {
+                        sum = OFstatic_cast(double, *(p++)) / xy_factor;
+                        if (xi == bxi)
+                            sum *= l_factor;
+                        else if (xi == exi)
+                            sum *= r_factor;
+                        if (yi == byi)
+                            sum *= b_factor;
+                        else if (yi == eyi)
+                            sum *= t_factor;
+                        value += sum;
                     }
+                    offset += Columns;
                 }
-                sp += f_size;
+                *(q++) = OFstatic_cast(T, value + 0.5);
             }
         }
     }
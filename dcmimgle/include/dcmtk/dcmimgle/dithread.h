@@ -0,0 +1,112 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: DicomThreadedTask (Header)
+ *
+ */
+
+
+#ifndef DITHREAD_H
+#define DITHREAD_H
+
+#include "dcmtk/config/osconfig.h"
+
+#include "dcmtk/ofstd/ofglobal.h"
+
+#include "dcmtk/dcmimgle/diutils.h"
+
+
+/*--------------------*
+ *  global variables  *
+ *--------------------*/
+
+/** global flag defining the maximum number of threads used for processing image data,
+ *  i.e. for scaling with interpolation, applying the VOI transformation to monochrome
+ *  images and converting YCbCr to RGB.  The image data is split into bands of rows
+ *  (or pixels) that are processed in parallel.  The output does not depend on the
+ *  number of threads.  Additional threads are only used if DCMTK has been compiled
+ *  with thread support and if the image is large enough.  Default is 1, i.e. no
+ *  additional threads.
+ */
+extern DCMTK_DCMIMGLE_EXPORT OFGlobal<Uint32> dcmImageProcessingThreads;
+
+
+/*------------------------*
+ *  forward declarations  *
+ *------------------------*/
+
+class DiThreadedTaskThread;
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/** Abstract base class for image processing tasks that consist of a number of
+ *  independent items (e.g. rows of an image), which can be split into bands that
+ *  are processed by multiple threads in parallel
+ */
+class DCMTK_DCMIMGLE_EXPORT DiThreadedTask
+{
+
+ public:
+
+    /** constructor
+     */
+    DiThreadedTask();
+
+    /** destructor
+     */
+    virtual ~DiThreadedTask();
+
+    /** process all items of this task.  The items are split into bands of (almost)
+     *  equal size, one for each thread.  The number of threads is limited by the global
+     *  flag dcmImageProcessingThreads and by the size of the bands, i.e. each thread
+     *  processes at least 64k pixels.  This method returns when all items are processed.
+     *
+     ** @param  count  number of items to be processed
+     *  @param  size   number of pixels per item, e.g. number of columns for rows
+     */
+    void run(const unsigned long count,
+             const unsigned long size = 1);
+
+
+ protected:
+
+    /** process the given range of items (abstract).
+     *  This method is called concurrently for different ranges, so it must not modify
+     *  any data that is shared with the other ranges.
+     *
+     ** @param  first  index of the first item to be processed
+     *  @param  last   index of the item following the last one to be processed
+     */
+    virtual void process(const unsigned long first,
+                         const unsigned long last) = 0;
+
+
+ private:
+
+    friend class DiThreadedTaskThread;
+
+ // --- declarations to avoid compiler warnings
+
+    DiThreadedTask(const DiThreadedTask &);
+    DiThreadedTask &operator=(const DiThreadedTask &);
+};
+
+
+#endif
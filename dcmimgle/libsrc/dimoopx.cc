@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1996-2010, OFFIS e.V.
+ *  Copyright (C) 1996-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,6 +25,35 @@
 #include "dcmtk/dcmimgle/dimoopx.h"
 #include "dcmtk/dcmimgle/dimopx.h"
 
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
+/* use vector instructions for rendering 8-bit output data if they are available
+ * on the target platform.  SSE2 is part of the x86-64 instruction set, the gather
+ * instructions used for applying a LUT require AVX2.  If the library is compiled
+ * for a target that supports AVX2 (e.g. compiler option -mavx2), the gather
+ * instructions are always used.  Otherwise, gcc (4.9 and newer) and clang compile
+ * the gather version separately and select it at runtime if the CPU supports AVX2.
+ * With other compilers (e.g. Visual Studio without /arch:AVX2), the scalar version
+ * is used.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DCMIMGLE_WITH_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#define DCMIMGLE_WITH_AVX2
+#define DCMIMGLE_AVX2_TARGET
+#include <immintrin.h>
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+      ((defined(__clang__) && (__clang_major__ >= 8)) || \
+       (!defined(__clang__) && !defined(__INTEL_COMPILER) && defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))))
+#define DCMIMGLE_WITH_AVX2
+#define DCMIMGLE_AVX2_RUNTIME_CHECK
+#define DCMIMGLE_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
 
 /*----------------*
  *  constructors  *
@@ -74,3 +103,281 @@ int DiMonoOutputPixel::isUnused(const unsigned long value)
     }
     return 0;
 }
+
+
+/*------------------------*
+ *  rendering primitives  *
+ *------------------------*/
+
+#ifdef DCMIMGLE_WITH_AVX2
+
+/* check whether the gather instructions can be used on this CPU */
+static inline OFBool gatherSupported()
+{
+#ifdef DCMIMGLE_AVX2_RUNTIME_CHECK
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return OFTrue;
+#endif
+}
+
+/* load eight pixel values and convert them to 32-bit LUT indices */
+DCMIMGLE_AVX2_TARGET
+static inline __m256i loadIndices(const Uint8 *src)
+{
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(OFreinterpret_cast(const __m128i *, src)));
+}
+
+DCMIMGLE_AVX2_TARGET
+static inline __m256i loadIndices(const Sint8 *src)
+{
+    return _mm256_cvtepi8_epi32(_mm_loadl_epi64(OFreinterpret_cast(const __m128i *, src)));
+}
+
+DCMIMGLE_AVX2_TARGET
+static inline __m256i loadIndices(const Uint16 *src)
+{
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128(OFreinterpret_cast(const __m128i *, src)));
+}
+
+DCMIMGLE_AVX2_TARGET
+static inline __m256i loadIndices(const Sint16 *src)
+{
+    return _mm256_cvtepi16_epi32(_mm_loadu_si128(OFreinterpret_cast(const __m128i *, src)));
+}
+
+/* apply the LUT to sixteen pixels at a time, returns the number of remaining pixels */
+template<class T>
+DCMIMGLE_AVX2_TARGET
+static unsigned long gatherLUT(const T *&src,
+                               Uint8 *&dst,
+                               const Uint8 *lut0,
+                               unsigned long count)
+{
+    // each gather instruction reads four bytes per LUT entry, i.e. the
+    // three bytes following the entry are read as well and masked out.
+    // This is why initOptimizationLUT() allocates three additional entries.
+    const int *base = OFreinterpret_cast(const int *, lut0);
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    while (count >= 16)
+    {
+        const __m256i v0 = _mm256_and_si256(_mm256_i32gather_epi32(base, loadIndices(src), 1), mask);
+        const __m256i v1 = _mm256_and_si256(_mm256_i32gather_epi32(base, loadIndices(src + 8), 1), mask);
+        // pack 2x8 values (32 bit) into 16 bytes, restoring the order of the 128-bit lanes
+        const __m256i w = _mm256_permute4x64_epi64(_mm256_packus_epi32(v0, v1), 0xd8);
+        _mm_storeu_si128(OFreinterpret_cast(__m128i *, dst),
+            _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1)));
+        src += 16;
+        dst += 16;
+        count -= 16;
+    }
+    return count;
+}
+
+#endif
+
+
+template<class T>
+static void applyLUT(const T *src,
+                     Uint8 *dst,
+                     const Uint8 *lut0,
+                     unsigned long count)
+{
+#ifdef DCMIMGLE_WITH_AVX2
+    if (gatherSupported())
+        count = gatherLUT(src, dst, lut0, count);
+#endif
+    // the loads of the LUT entries are independent of each other
+    while (count >= 4)
+    {
+        dst[0] = lut0[src[0]];
+        dst[1] = lut0[src[1]];
+        dst[2] = lut0[src[2]];
+        dst[3] = lut0[src[3]];
+        src += 4;
+        dst += 4;
+        count -= 4;
+    }
+    while (count-- != 0)
+        *(dst++) = lut0[*(src++)];
+}
+
+
+#ifdef DCMIMGLE_WITH_SSE2
+
+/* apply the linear window to two pixel values, see DiMonoOutputPixel::applyLinearWindow() */
+static inline __m128i windowValues(const __m128d value,
+                                   const __m128d leftBorder,
+                                   const __m128d rightBorder,
+                                   const __m128d offset,
+                                   const __m128d gradient,
+                                   const __m128d low,
+                                   const __m128d high)
+{
+    __m128d result = _mm_add_pd(offset, _mm_mul_pd(value, gradient));
+    __m128d select = _mm_cmpgt_pd(value, rightBorder);
+    result = _mm_or_pd(_mm_and_pd(select, high), _mm_andnot_pd(select, result));
+    select = _mm_cmple_pd(value, leftBorder);
+    result = _mm_or_pd(_mm_and_pd(select, low), _mm_andnot_pd(select, result));
+    // truncate towards zero like the conversion in the generic version
+    return _mm_cvttpd_epi32(result);
+}
+
+#endif
+
+
+template<class T>
+static void linearWindow(const T *src,
+                         Uint8 *dst,
+                         unsigned long count,
+                         const double leftBorder,
+                         const double rightBorder,
+                         const double offset,
+                         const double gradient,
+                         const Uint8 low,
+                         const Uint8 high)
+{
+#ifdef DCMIMGLE_WITH_SSE2
+    // all calculations are performed with double precision (as in the generic version)
+    // in order to get exactly the same output values
+    const __m128d vLeftBorder = _mm_set1_pd(leftBorder);
+    const __m128d vRightBorder = _mm_set1_pd(rightBorder);
+    const __m128d vOffset = _mm_set1_pd(offset);
+    const __m128d vGradient = _mm_set1_pd(gradient);
+    const __m128d vLow = _mm_set1_pd(low);
+    const __m128d vHigh = _mm_set1_pd(high);
+    while (count >= 4)
+    {
+        const __m128i value = _mm_set_epi32(src[3], src[2], src[1], src[0]);
+        const __m128i r0 = windowValues(_mm_cvtepi32_pd(value), vLeftBorder, vRightBorder, vOffset, vGradient, vLow, vHigh);
+        const __m128i r1 = windowValues(_mm_cvtepi32_pd(_mm_shuffle_epi32(value, 0xee)), vLeftBorder, vRightBorder, vOffset, vGradient, vLow, vHigh);
+        // the results are in the range 0..255, i.e. saturation does not change them
+        const __m128i words = _mm_packs_epi32(_mm_unpacklo_epi64(r0, r1), r0);
+        const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        memcpy(dst, &bytes, 4);
+        src += 4;
+        dst += 4;
+        count -= 4;
+    }
+#endif
+    double value;
+    while (count-- != 0)
+    {
+        value = OFstatic_cast(double, *(src++));
+        if (value <= leftBorder)
+            *(dst++) = low;                                             // black/white
+        else if (value > rightBorder)
+            *(dst++) = high;                                            // white/black
+        else
+            *(dst++) = OFstatic_cast(Uint8, offset + value * gradient); // gray value
+    }
+}
+
+
+void DiMonoOutputPixel::applyOptimizationLUT(const Uint8 *src,
+                                             Uint8 *dst,
+                                             const Uint8 *lut0,
+                                             const unsigned long count)
+{
+    // the LUT must have three additional entries after the last one (see
+    // initOptimizationLUT()) since the gather version of applyLUT() reads
+    // four bytes for each pixel, the first of which is the LUT entry
+    applyLUT(src, dst, lut0, count);
+}
+
+
+void DiMonoOutputPixel::applyOptimizationLUT(const Sint8 *src,
+                                             Uint8 *dst,
+                                             const Uint8 *lut0,
+                                             const unsigned long count)
+{
+    applyLUT(src, dst, lut0, count);
+}
+
+
+void DiMonoOutputPixel::applyOptimizationLUT(const Uint16 *src,
+                                             Uint8 *dst,
+                                             const Uint8 *lut0,
+                                             const unsigned long count)
+{
+    applyLUT(src, dst, lut0, count);
+}
+
+
+void DiMonoOutputPixel::applyOptimizationLUT(const Sint16 *src,
+                                             Uint8 *dst,
+                                             const Uint8 *lut0,
+                                             const unsigned long count)
+{
+    applyLUT(src, dst, lut0, count);
+}
+
+
+void DiMonoOutputPixel::applyLinearWindow(const Uint8 *src,
+                                          Uint8 *dst,
+                                          const unsigned long count,
+                                          const double leftBorder,
+                                          const double rightBorder,
+                                          const double offset,
+                                          const double gradient,
+                                          const Uint8 low,
+                                          const Uint8 high)
+{
+    linearWindow(src, dst, count, leftBorder, rightBorder, offset, gradient, low, high);
+}
+
+
+void DiMonoOutputPixel::applyLinearWindow(const Sint8 *src,
+                                          Uint8 *dst,
+                                          const unsigned long count,
+                                          const double leftBorder,
+                                          const double rightBorder,
+                                          const double offset,
+                                          const double gradient,
+                                          const Uint8 low,
+                                          const Uint8 high)
+{
+    linearWindow(src, dst, count, leftBorder, rightBorder, offset, gradient, low, high);
+}
+
+
+void DiMonoOutputPixel::applyLinearWindow(const Uint16 *src,
+                                          Uint8 *dst,
+                                          const unsigned long count,
+                                          const double leftBorder,
+                                          const double rightBorder,
+                                          const double offset,
+                                          const double gradient,
+                                          const Uint8 low,
+                                          const Uint8 high)
+{
+    linearWindow(src, dst, count, leftBorder, rightBorder, offset, gradient, low, high);
+}
+
+
+void DiMonoOutputPixel::applyLinearWindow(const Sint16 *src,
+                                          Uint8 *dst,
+                                          const unsigned long count,
+                                          const double leftBorder,
+                                          const double rightBorder,
+                                          const double offset,
+                                          const double gradient,
+                                          const Uint8 low,
+                                          const Uint8 high)
+{
+    linearWindow(src, dst, count, leftBorder, rightBorder, offset, gradient, low, high);
+}
+
+
+void DiMonoOutputPixel::applyLinearWindow(const Sint32 *src,
+                                          Uint8 *dst,
+                                          const unsigned long count,
+                                          const double leftBorder,
+                                          const double rightBorder,
+                                          const double offset,
+                                          const double gradient,
+                                          const Uint8 low,
+                                          const Uint8 high)
+{
+    linearWindow(src, dst, count, leftBorder, rightBorder, offset, gradient, low, high);
+}
@@ -0,0 +1,185 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: DicomThreadedTask (Source)
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"
+
+#include "dcmtk/dcmimgle/dithread.h"
+
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofthread.h"
+
+
+/*--------------------*
+ *  global variables  *
+ *--------------------*/
+
+OFGlobal<Uint32> dcmImageProcessingThreads(1);
+
+
+/*----------------------------*
+ *  constant initializations  *
+ *----------------------------*/
+
+/// minimum number of pixels processed by a thread (smaller images are processed by a single thread)
+const unsigned long MinimumPixelsPerThread = 65536;
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+#ifdef WITH_THREADS
+
+/** Worker thread processing one band of a DiThreadedTask
+ */
+class DiThreadedTaskThread
+  : public OFThread
+{
+
+ public:
+
+    /** constructor
+     *
+     ** @param  task   task to be processed
+     *  @param  first  index of the first item of the band
+     *  @param  last   index of the item following the last one of the band
+     */
+    DiThreadedTaskThread(DiThreadedTask &task,
+                         const unsigned long first,
+                         const unsigned long last)
+      : OFThread(),
+        Task(task),
+        First(first),
+        Last(last)
+    {
+    }
+
+    /** destructor
+     */
+    virtual ~DiThreadedTaskThread()
+    {
+    }
+
+
+ protected:
+
+    /** process the band of items
+     */
+    virtual void run()
+    {
+        Task.process(First, Last);
+    }
+
+
+ private:
+
+    /// task to be processed
+    DiThreadedTask &Task;
+    /// index of the first item of the band
+    const unsigned long First;
+    /// index of the item following the last one of the band
+    const unsigned long Last;
+
+ // --- declarations to avoid compiler warnings
+
+    DiThreadedTaskThread(const DiThreadedTaskThread &);
+    DiThreadedTaskThread &operator=(const DiThreadedTaskThread &);
+};
+
+#endif
+
+
+/*----------------*
+ *  constructors  *
+ *----------------*/
+
+DiThreadedTask::DiThreadedTask()
+{
+}
+
+
+/*--------------*
+ *  destructor  *
+ *--------------*/
+
+DiThreadedTask::~DiThreadedTask()
+{
+}
+
+
+/********************************************************************/
+
+
+void DiThreadedTask::run(const unsigned long count,
+                         const unsigned long size)
+{
+    unsigned long threads = 1;
+#ifdef WITH_THREADS
+    threads = dcmImageProcessingThreads.get();
+    if (size > 0)
+    {
+        // make sure that each thread has enough work to do
+        const unsigned long minimum = (size < MinimumPixelsPerThread) ? (MinimumPixelsPerThread + size - 1) / size : 1;
+        if (threads > count / minimum)
+            threads = count / minimum;
+    } else {
+        // items without any pixels are not worth a thread
+        threads = 1;
+    }
+#else
+    (void)size;
+#endif
+    if (threads > 1)
+    {
+#ifdef WITH_THREADS
+        DCMIMGLE_TRACE("processing " << count << " items using " << threads << " threads");
+        // the first 'remainder' bands contain one additional item
+        const unsigned long band = count / threads;
+        const unsigned long remainder = count % threads;
+        unsigned long first = band + ((remainder > 0) ? 1 : 0);
+        OFList<DiThreadedTaskThread *> threadList;
+        for (unsigned long i = 1; i < threads; ++i)
+        {
+            const unsigned long last = first + band + ((i < remainder) ? 1 : 0);
+            DiThreadedTaskThread *thread = new DiThreadedTaskThread(*this, first, last);
+            if (thread->start() == 0)
+                threadList.push_back(thread);
+            else
+            {
+                // process this band in the calling thread
+                delete thread;
+                process(first, last);
+            }
+            first = last;
+        }
+        // the calling thread processes the first band
+        process(0, band + ((remainder > 0) ? 1 : 0));
+        while (!threadList.empty())
+        {
+            threadList.front()->join();
+            delete threadList.front();
+            threadList.pop_front();
+        }
+#endif
+    } else
+        process(0, count);
+}
@@ -0,0 +1,201 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the rendering primitives of DiMonoOutputPixel
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmimgle/dimoopx.h"
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
+/* number of pixels, chosen so that the vectorized loops leave a remainder */
+#define OUTPIX_COUNT 10007
+
+
+/* gives access to the rendering primitives, which are protected members.
+ * The specialized (vectorized) versions for 8-bit output are selected by
+ * overload resolution, the generic (scalar) templates by explicit template
+ * arguments.
+ */
+class DiMonoOutputPixelTest : public DiMonoOutputPixel
+{
+ public:
+
+    template<class T>
+    static void specializedLUT(const T *src, Uint8 *dst, const Uint8 *lut0, const unsigned long count)
+    {
+        applyOptimizationLUT(src, dst, lut0, count);
+    }
+
+    template<class T>
+    static void genericLUT(const T *src, Uint8 *dst, const Uint8 *lut0, const unsigned long count)
+    {
+        applyOptimizationLUT<T, Uint8>(src, dst, lut0, count);
+    }
+
+    template<class T>
+    static void specializedWindow(const T *src, Uint8 *dst, const unsigned long count, const double leftBorder,
+                                  const double rightBorder, const double offset, const double gradient,
+                                  const Uint8 low, const Uint8 high)
+    {
+        applyLinearWindow(src, dst, count, leftBorder, rightBorder, offset, gradient, low, high);
+    }
+
+    template<class T>
+    static void genericWindow(const T *src, Uint8 *dst, const unsigned long count, const double leftBorder,
+                              const double rightBorder, const double offset, const double gradient,
+                              const Uint8 low, const Uint8 high)
+    {
+        applyLinearWindow<T, Uint8>(src, dst, count, leftBorder, rightBorder, offset, gradient, low, high);
+    }
+};
+
+
+/* fill the buffer with pseudo random pixel values in the range minValue..maxValue,
+ * including both limits
+ */
+template<class T>
+static void createPixels(T *pixels, const long minValue, const long maxValue)
+{
+    Uint32 seed = 4711;
+    pixels[0] = OFstatic_cast(T, minValue);
+    pixels[1] = OFstatic_cast(T, maxValue);
+    for (unsigned long i = 2; i < OUTPIX_COUNT; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        pixels[i] = OFstatic_cast(T, minValue + OFstatic_cast(long, (seed >> 8) % OFstatic_cast(Uint32, maxValue - minValue + 1)));
+    }
+}
+
+
+/* render the pixel values with an optimization LUT covering minValue..maxValue,
+ * using both the specialized and the generic version
+ */
+template<class T>
+static void checkLUT(const long minValue, const long maxValue)
+{
+    T *pixels = new T[OUTPIX_COUNT];
+    createPixels(pixels, minValue, maxValue);
+
+    // the LUT has three additional entries, like the ones created by
+    // DiMonoOutputPixelTemplate::initOptimizationLUT()
+    const unsigned long entries = OFstatic_cast(unsigned long, maxValue - minValue + 1);
+    Uint8 *lut = new Uint8[entries + 3];
+    Uint32 seed = 815;
+    for (unsigned long i = 0; i < entries + 3; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        lut[i] = OFstatic_cast(Uint8, seed >> 24);
+    }
+    const Uint8 *lut0 = lut - minValue;
+
+    Uint8 *expected = new Uint8[OUTPIX_COUNT];
+    Uint8 *result = new Uint8[OUTPIX_COUNT];
+    // different counts in order to check the remainders of the vectorized loops
+    const unsigned long counts[4] = { OUTPIX_COUNT, 16, 15, 1 };
+    for (int c = 0; c < 4; ++c)
+    {
+        memset(expected, 0, OUTPIX_COUNT);
+        memset(result, 0, OUTPIX_COUNT);
+        DiMonoOutputPixelTest::genericLUT(pixels, expected, lut0, counts[c]);
+        DiMonoOutputPixelTest::specializedLUT(pixels, result, lut0, counts[c]);
+        OFCHECK(memcmp(result, expected, OUTPIX_COUNT) == 0);
+    }
+    // the smallest and the largest pixel value refer to the first and the last LUT entry
+    OFCHECK_EQUAL(OFstatic_cast(int, result[0]), OFstatic_cast(int, lut[0]));
+    DiMonoOutputPixelTest::specializedLUT(pixels + 1, result, lut0, 1);
+    OFCHECK_EQUAL(OFstatic_cast(int, result[0]), OFstatic_cast(int, lut[entries - 1]));
+
+    delete[] result;
+    delete[] expected;
+    delete[] lut;
+    delete[] pixels;
+}
+
+
+/* render the pixel values with a linear VOI window, using both the specialized
+ * and the generic version.  The parameters are calculated like in
+ * DiMonoOutputPixelTemplate::window() (VOI LINEAR, no display function).
+ */
+template<class T>
+static void checkWindow(const long minValue, const long maxValue, const double center, const double width)
+{
+    T *pixels = new T[OUTPIX_COUNT];
+    createPixels(pixels, minValue, maxValue);
+    Uint8 *expected = new Uint8[OUTPIX_COUNT];
+    Uint8 *result = new Uint8[OUTPIX_COUNT];
+
+    const double width_1 = width - 1;
+    const double leftBorder = center - 0.5 - width_1 / 2;
+    const double rightBorder = center - 0.5 + width_1 / 2;
+    // normal and inverse polarity
+    for (int inverse = 0; inverse < 2; ++inverse)
+    {
+        const Uint8 low = inverse ? 255 : 0;
+        const Uint8 high = inverse ? 0 : 255;
+        const double outrange = OFstatic_cast(double, high) - OFstatic_cast(double, low);
+        const double offset = high - ((center - 0.5) / width_1 + 0.5) * outrange;
+        const double gradient = outrange / width_1;
+        memset(expected, 0, OUTPIX_COUNT);
+        memset(result, 0, OUTPIX_COUNT);
+        DiMonoOutputPixelTest::genericWindow(pixels, expected, OUTPIX_COUNT, leftBorder, rightBorder, offset, gradient, low, high);
+        DiMonoOutputPixelTest::specializedWindow(pixels, result, OUTPIX_COUNT, leftBorder, rightBorder, offset, gradient, low, high);
+        OFCHECK(memcmp(result, expected, OUTPIX_COUNT) == 0);
+    }
+
+    delete[] result;
+    delete[] expected;
+    delete[] pixels;
+}
+
+
+OFTEST(dcmimgle_outputPixelLUT)
+{
+    // 8-bit data
+    checkLUT<Uint8>(0, 255);
+    checkLUT<Sint8>(-128, 127);
+    // 12-bit data
+    checkLUT<Uint16>(0, 4095);
+    checkLUT<Sint16>(-2048, 2047);
+    // 16-bit data
+    checkLUT<Uint16>(0, 65535);
+    checkLUT<Sint16>(-32768, 32767);
+}
+
+
+OFTEST(dcmimgle_outputPixelLinearWindow)
+{
+    // 8-bit data
+    checkWindow<Uint8>(0, 255, 128, 256);
+    checkWindow<Uint8>(0, 255, 100, 31);
+    checkWindow<Sint8>(-128, 127, -10, 60);
+    // 12-bit data
+    checkWindow<Uint16>(0, 4095, 2048, 4096);
+    checkWindow<Uint16>(0, 4095, 1000.5, 333);
+    checkWindow<Sint16>(-2048, 2047, 40, 400);
+    // 16-bit data
+    checkWindow<Uint16>(0, 65535, 30000, 12345);
+    checkWindow<Sint16>(-32768, 32767, -1000, 2);
+    checkWindow<Sint32>(-1024, 3071, 40, 80);
+    checkWindow<Sint32>(-100000, 100000, 0, 65536);
+}
@@ -0,0 +1,136 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for multi-threaded scaling and rendering of
+ *           monochrome images
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmimgle/dcmimage.h"
+#include "dcmtk/dcmimgle/dithread.h"
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
+/* image size, large enough for four threads processing at least 64k pixels each */
+#define THREAD_COLUMNS 512
+#define THREAD_ROWS 512
+#define THREAD_FRAMES 3
+
+
+/* create a multi-frame monochrome image with 12 bits stored */
+static void createDataset(DcmDataset &dataset, const Uint16 pixelRepresentation)
+{
+    const unsigned long count = OFstatic_cast(unsigned long, THREAD_COLUMNS) * THREAD_ROWS * THREAD_FRAMES;
+    Uint16 *pixels = new Uint16[count];
+    Uint32 seed = 4711;
+    for (unsigned long i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        // smooth gradient with some noise, so that interpolation matters
+        const unsigned long x = i % THREAD_COLUMNS;
+        const unsigned long y = (i / THREAD_COLUMNS) % THREAD_ROWS;
+        pixels[i] = OFstatic_cast(Uint16, (x * 5 + y * 3 + i / (THREAD_COLUMNS * THREAD_ROWS) * 700 + (seed >> 26)) & 0x0fff);
+    }
+    OFCHECK(dataset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2").good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_SamplesPerPixel, 1).good());
+    OFCHECK(dataset.putAndInsertString(DCM_NumberOfFrames, "3").good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_Rows, THREAD_ROWS).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_Columns, THREAD_COLUMNS).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_BitsAllocated, 16).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_BitsStored, 12).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_HighBit, 11).good());
+    OFCHECK(dataset.putAndInsertUint16(DCM_PixelRepresentation, pixelRepresentation).good());
+    OFCHECK(dataset.putAndInsertUint16Array(DCM_PixelData, pixels, count).good());
+    delete[] pixels;
+}
+
+
+/* scale (if width > 0) and render all frames of the image with the given number
+ * of threads.  The output data of all frames is returned in a single buffer.
+ */
+static Uint8 *renderFrames(DcmDataset &dataset, const Uint32 threads, const int bits, const OFBool window,
+                           const unsigned long width, const unsigned long height, const int interpolate,
+                           unsigned long &size)
+{
+    dcmImageProcessingThreads.set(threads);
+    Uint8 *buffer = NULL;
+    size = 0;
+    DicomImage image(&dataset, EXS_LittleEndianExplicit);
+    OFCHECK_EQUAL(image.getStatus(), EIS_Normal);
+    OFCHECK_EQUAL(image.getFrameCount(), THREAD_FRAMES);
+    DicomImage *scaled = (width > 0) ? image.createScaledImage(width, height, interpolate) : &image;
+    OFCHECK(scaled != NULL);
+    if (scaled != NULL)
+    {
+        if (window)
+            OFCHECK(scaled->setWindow(1500, 1800));
+        const unsigned long frameSize = scaled->getOutputDataSize(bits);
+        size = frameSize * scaled->getFrameCount();
+        buffer = new Uint8[size];
+        memset(buffer, 0, size);
+        for (unsigned long frame = 0; frame < scaled->getFrameCount(); ++frame)
+            OFCHECK(scaled->getOutputData(buffer + frame * frameSize, frameSize, bits, frame));
+        if (scaled != &image)
+            delete scaled;
+    }
+    return buffer;
+}
+
+
+/* compare the output of a single thread with the output of four threads */
+static void checkThreads(DcmDataset &dataset, const int bits, const OFBool window, const unsigned long width = 0,
+                         const unsigned long height = 0, const int interpolate = 0)
+{
+    unsigned long expectedSize = 0;
+    unsigned long resultSize = 0;
+    Uint8 *expected = renderFrames(dataset, 1, bits, window, width, height, interpolate, expectedSize);
+    Uint8 *result = renderFrames(dataset, 4, bits, window, width, height, interpolate, resultSize);
+    OFCHECK(expectedSize > 0);
+    OFCHECK_EQUAL(resultSize, expectedSize);
+    OFCHECK((expected != NULL) && (result != NULL) && (resultSize == expectedSize) &&
+        (memcmp(result, expected, expectedSize) == 0));
+    delete[] result;
+    delete[] expected;
+}
+
+
+OFTEST(dcmimgle_multiThreadedProcessing)
+{
+    const Uint32 threads = dcmImageProcessingThreads.get();
+    for (Uint16 pixelRepresentation = 0; pixelRepresentation < 2; ++pixelRepresentation)
+    {
+        DcmDataset dataset;
+        createDataset(dataset, pixelRepresentation);
+        // rendering without and with VOI window, 8 and 16 bits output
+        checkThreads(dataset, 8, OFFalse);
+        checkThreads(dataset, 8, OFTrue);
+        checkThreads(dataset, 16, OFTrue);
+        // scaling with pbmplus interpolation
+        checkThreads(dataset, 8, OFTrue, 700, 300, 1);
+        // magnification and reduction with c't interpolation
+        checkThreads(dataset, 8, OFTrue, 768, 640, 2);
+        checkThreads(dataset, 8, OFTrue, 400, 448, 2);
+    }
+    dcmImageProcessingThreads.set(threads);
+}
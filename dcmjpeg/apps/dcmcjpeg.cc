@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2001-2014, OFFIS e.V.
+ *  Copyright (C) 2001-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -87,6 +87,7 @@ int main(int argc, char *argv[])
   OFCmdUnsignedInt opt_quality = 90;
   OFBool           opt_huffmanOptimize = OFTrue;
   OFCmdUnsignedInt opt_smoothing = 0;
+  OFCmdUnsignedInt opt_threads = 1;
   int              opt_compressedBits = 0; // 0=auto, 8/12/16=force
   E_CompressionColorSpaceConversion opt_compCSconversion = ECC_lossyYCbCr;
   E_DecompressionColorSpaceConversion opt_decompCSconversion = EDC_photometricInterpretation;
@@ -161,6 +162,12 @@ int main(int argc, char *argv[])
       cmd.addOption("--huffman-optimize",    "+ho",    "optimize huffman tables (default)");
       cmd.addOption("--huffman-standard",    "-ho",    "use standard huffman tables if 8 bits/sample");
 
+#ifdef WITH_THREADS
+    cmd.addSubGroup("multi-frame compression:");
+      cmd.addOption("--threads",             "+mt", 1, "[n]umber: integer (1..256, default: 1)",
+                                                       "compress up to n frames concurrently");
+#endif
+
     cmd.addSubGroup("compressed bits per sample (always +ba with +tl):");
       cmd.addOption("--bits-auto",           "+ba",    "choose bits/sample automatically (default)");
       cmd.addOption("--bits-force-8",        "+be",    "force 8 bits/sample");
@@ -363,6 +370,13 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--huffman-standard")) opt_huffmanOptimize = OFFalse;
       cmd.endOptionBlock();
 
+#ifdef WITH_THREADS
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValueAndCheckMinMax(opt_threads, OFstatic_cast(OFCmdUnsignedInt, 1), OFstatic_cast(OFCmdUnsignedInt, 256)));
+      }
+#endif
+
       if (cmd.findOption("--smooth"))
       {
         app.checkConflict("--smooth", "--true-lossless", opt_trueLossless);
@@ -618,7 +632,8 @@ int main(int argc, char *argv[])
       opt_useModalityRescale,
       opt_acceptWrongPaletteTags,
       opt_acrNemaCompatibility,
-      opt_trueLossless);
+      opt_trueLossless,
+      OFstatic_cast(Uint32, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
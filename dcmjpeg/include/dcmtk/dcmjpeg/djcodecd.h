@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2001-2011, OFFIS e.V.
+ *  Copyright (C) 2001-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -106,6 +106,42 @@ public:
     Uint32 bufSize,
     OFString& decompressedColorModel) const;
 
+  /** decompresses a range of consecutive frames from the given pixel sequence
+   *  and stores the result in the given buffer. If the codec parameters permit
+   *  more than one thread and the fragments of the frames can be determined in
+   *  advance, all frames following the first one are decompressed concurrently.
+   *  @param fromParam representation parameter of current compressed
+   *    representation, may be NULL.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to dataset in which pixel data element is contained
+   *  @param firstFrame number of the first frame, starting with 0 for the first frame
+   *  @param numberOfFrames number of frames to be decompressed
+   *  @param startFragment index of the compressed fragment that contains
+   *    all or the first part of the compressed bitstream for the given firstFrame.
+   *    Upon successful return this parameter is updated to contain the index
+   *    of the first compressed fragment of the frame following the given range.
+   *    When unknown, zero should be passed.
+   *  @param buffer pointer to buffer where the frames are to be stored, frame i
+   *    of the range at offset i * frameBufSize
+   *  @param frameBufSize size of the buffer for a single frame in bytes
+   *  @param decompressedColorModel upon successful return, the color model
+   *    of the decompressed image (which may be different from the one used
+   *    in the compressed images) is returned in this parameter.
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrames(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    void *buffer,
+    Uint32 frameBufSize,
+    OFString& decompressedColorModel) const;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -203,6 +239,47 @@ private:
     Uint8 bitsPerSample,
     OFBool isYBR) const = 0;
 
+  /** decompresses the given frames using multiple threads, each of them
+   *  with its own instance of the compression library.
+   *  @param fromParam representation parameter passed to decode()
+   *  @param cp codec parameter passed to decode()
+   *  @param jpeg decoder instance used by the calling thread
+   *  @param precision bits per sample of the JPEG data
+   *  @param isYBR flag indicating whether DICOM photometric interpretation is YCbCr
+   *  @param isSigned flag indicating whether the pixel data is signed
+   *  @param pixSeq compressed pixel sequence
+   *  @param startFragments index of the first fragment of each frame, followed by
+   *    the index of the first fragment after the last frame (numberOfFrames + 1 entries)
+   *  @param numberOfFrames number of frames to be decompressed
+   *  @param buffer buffer for the first frame
+   *  @param frameBufSize offset between two frames in the buffer, in bytes
+   *  @param frameSize size of an uncompressed frame, in bytes
+   *  @param columns columns of a frame
+   *  @param rows rows of a frame
+   *  @param samplesPerPixel samples per pixel of a frame
+   *  @param createPlanarConfiguration convert color frames to color-by-plane if true
+   *  @param swapFrames adjust the byte order of each frame (as done by decodeFrame()) if true
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition decodeFramesConcurrently(
+    const DcmRepresentationParameter * fromParam,
+    const DJCodecParameter *cp,
+    DJDecoder *jpeg,
+    Uint8 precision,
+    OFBool isYBR,
+    OFBool isSigned,
+    DcmPixelSequence *pixSeq,
+    const Uint32 *startFragments,
+    Uint32 numberOfFrames,
+    Uint8 *buffer,
+    size_t frameBufSize,
+    size_t frameSize,
+    Uint16 columns,
+    Uint16 rows,
+    Uint16 samplesPerPixel,
+    OFBool createPlanarConfiguration,
+    OFBool swapFrames) const;
+
   // static private helper methods
 
   /** scans the given block of JPEG data for a Start of Frame marker
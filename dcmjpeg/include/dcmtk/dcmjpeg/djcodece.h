@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2001-2014, OFFIS e.V.
+ *  Copyright (C) 2001-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,6 +25,7 @@
 #include "dcmtk/config/osconfig.h"
 #include "dcmtk/ofstd/oftypes.h"
 #include "dcmtk/dcmdata/dccodec.h"    /* for class DcmCodec */
+#include "dcmtk/dcmdata/dcofsetl.h"   /* for class DcmOffsetList */
 #include "dcmtk/dcmjpeg/djutils.h"    /* for enums */
 #include "dcmtk/ofstd/oflist.h"
 #include "dcmtk/ofstd/ofstring.h"     /* for class OFString */
@@ -366,6 +367,44 @@ private:
     const DJCodecParameter *cp,
     Uint8 bitsPerSample) const = 0;
 
+  /** compresses all frames of an image and stores the compressed frames in the
+   *  given pixel sequence (in the original order). If the codec parameters permit
+   *  more than one thread, consecutive frames are compressed concurrently, each
+   *  thread using its own encoder instance created by createEncoderInstance().
+   *  @param toRepParam representation parameter passed to encode()
+   *  @param cp codec parameter passed to encode()
+   *  @param compressedBits bits per sample passed to createEncoderInstance()
+   *  @param jpeg encoder instance used by the calling thread
+   *  @param image image from which the frames are rendered (may be NULL)
+   *  @param pixelData uncompressed pixel data of all frames, used if image is NULL
+   *  @param frameSize size of a frame in pixelData (in bytes)
+   *  @param frameCount number of frames to be compressed
+   *  @param columns columns of a frame
+   *  @param rows rows of a frame
+   *  @param interpr photometric interpretation of the frames
+   *  @param samplesPerPixel samples per pixel of the frames
+   *  @param pixelSequence pixel sequence in which the compressed frames are stored
+   *  @param offsetList list of frame offsets, updated by this method
+   *  @param compressedSize size of the compressed frames (in bytes), updated by this method
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition encodeFrames(
+    const DcmRepresentationParameter * toRepParam,
+    const DJCodecParameter *cp,
+    Uint8 compressedBits,
+    DJEncoder *jpeg,
+    DicomImage *image,
+    const Uint8 *pixelData,
+    size_t frameSize,
+    size_t frameCount,
+    Uint16 columns,
+    Uint16 rows,
+    EP_Interpretation interpr,
+    Uint16 samplesPerPixel,
+    DcmPixelSequence *pixelSequence,
+    DcmOffsetList &offsetList,
+    size_t &compressedSize) const;
+
   /** modifies all VOI window center/width settings in the image.
    *  Modifications are based on the pixel value mapping
    *  f(x) = (x+voiOffset)*voiFactor
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2014, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -64,6 +64,9 @@ public:
    *  @param pAcrNemaCompatibility accept old ACR-NEMA images without photometric interpretation
    *    (only "pseudo" lossless encoder)
    *  @param pTrueLosslessMode Enables true lossless compression (replaces old "pseudo lossless" encoder)
+   *  @param pNumberOfThreads maximum number of threads used for the compression and
+   *    decompression of multi-frame images. The frames are processed one after the other
+   *    if 1 (default).
    */
   DJCodecParameter(
     E_CompressionColorSpaceConversion pCompressionCSConversion,
@@ -91,7 +94,8 @@ public:
     OFBool pUseModalityRescale = OFFalse,
     OFBool pAcceptWrongPaletteTags = OFFalse,
     OFBool pAcrNemaCompatibility = OFFalse,
-    OFBool pTrueLosslessMode = OFTrue);
+    OFBool pTrueLosslessMode = OFTrue,
+    Uint32 pNumberOfThreads = 1);
 
   /// copy constructor
   DJCodecParameter(const DJCodecParameter& arg);
@@ -293,6 +297,15 @@ public:
     return trueLosslessMode;
   }
 
+  /** returns maximum number of threads used for processing the frames of a
+   *  multi-frame image, 1 (default) if the frames are processed sequentially
+   *  @return maximum number of threads for processing multiple frames
+   */
+  Uint32 getNumberOfThreads() const
+  {
+    return numberOfThreads;
+  }
+
   /** returns flag indicating whether the workaround for buggy JPEG lossless images with incorrect predictor 6 is enabled
    *  @return flag indicating whether the workaround for buggy JPEG lossless images with incorrect predictor 6 is enabled
    */
@@ -397,6 +410,9 @@ private:
   /// flag indicating that the workaround for buggy JPEG lossless images with incorrect predictor 6 is enabled
   OFBool predictor6WorkaroundEnabled_;
 
+  /// maximum number of threads used for processing the frames of a multi-frame image
+  Uint32 numberOfThreads;
+
 };
 
 
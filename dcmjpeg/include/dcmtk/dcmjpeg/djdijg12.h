@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2014, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -50,6 +50,8 @@ public:
 
   /** initializes internal object structures.
    *  Must be called before a new frame is decompressed.
+   *  The IJG decompression object is created upon the first call and
+   *  re-used (after a reset) for all subsequent frames.
    *  @return EC_Normal if successful, an error code otherwise
    */
   virtual OFCondition init();
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2011, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -143,6 +143,15 @@ private:
   /// cleans up pixelDataList, called from destructor and error handlers
   void cleanup();
 
+  /** creates the IJG compression object, which is then re-used for all frames
+   *  compressed by this object. Called when the first frame is compressed.
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition initCompressor();
+
+  /// destroys the IJG compression object, called from destructor and error handlers
+  void destroyCompressor();
+
   /// codec parameters
   const DJCodecParameter *cparam;
   
@@ -164,6 +173,9 @@ private:
   /// filled number of bytes in last block in pixelDataList
   size_t bytesInLastBlock;
 
+  /// IJG compression structure, created for the first frame and re-used afterwards
+  jpeg_compress_struct *cinfo;
+
 };
 
 #endif
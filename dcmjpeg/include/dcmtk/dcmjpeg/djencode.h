@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2011, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -70,6 +70,8 @@ public:
    *  @param pAcceptWrongPaletteTags Accept wrong palette attribute tags (only "pseudo lossless" encoder)
    *  @param pAcrNemaCompatibility Accept old ACR-NEMA images without photometric interpretation (only "pseudo lossless" encoder)
    *  @param pRealLossless Enables true lossless compression (replaces old "pseudo" lossless encoders)
+   *  @param pNumberOfThreads maximum number of threads used for compressing the frames
+   *    of a multi-frame image concurrently, 1 (default) for sequential compression
    */
   static void registerCodecs(
     E_CompressionColorSpaceConversion pCompressionCSConversion = ECC_lossyYCbCr,
@@ -94,7 +96,8 @@ public:
     OFBool pUseModalityRescale = OFFalse,
     OFBool pAcceptWrongPaletteTags = OFFalse,
     OFBool pAcrNemaCompatibility = OFFalse,
-    OFBool pRealLossless = OFTrue);
+    OFBool pRealLossless = OFTrue,
+    Uint32 pNumberOfThreads = 1);
 
   /** deregisters encoders.
    *  Attention: Must not be called while other threads might still use
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2001-2014, OFFIS e.V.
+ *  Copyright (C) 2001-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -22,6 +22,10 @@
 #include "dcmtk/config/osconfig.h"
 #include "dcmtk/dcmjpeg/djcodecd.h"
 
+// ofstd includes
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofthread.h"
+
 // dcmdata includes
 #include "dcmtk/dcmdata/dcdatset.h"  /* for class DcmDataset */
 #include "dcmtk/dcmdata/dcdeftag.h"  /* for tag constants */
@@ -149,6 +153,22 @@ OFCondition DJCodecDecoder::decode(
                 Uint16 *imageData16 = NULL;
                 Sint32 currentFrame = 0;
                 size_t currentItem = 1; // ignore offset table
+                Uint32 *startFragments = NULL;
+
+#ifdef WITH_THREADS
+                // the frames following the first one can be decompressed concurrently
+                // if the fragments of all frames can be determined in advance
+                if ((djcp->getNumberOfThreads() > 1) && (imageFrames > 1))
+                {
+                  startFragments = new Uint32[imageFrames];
+                  if (determineFrameFragments(1, OFstatic_cast(Uint32, imageFrames - 1), imageFrames, pixSeq, startFragments).bad())
+                  {
+                    DCMJPEG_DEBUG("JPEG decoder: cannot determine fragments of all frames, decompressing frames sequentially");
+                    delete[] startFragments;
+                    startFragments = NULL;
+                  }
+                }
+#endif
 
                 if (isYBR && (imageBitsStored < imageBitsAllocated)) // check for a special case that is currently not handled properly
                 {
@@ -166,6 +186,15 @@ OFCondition DJCodecDecoder::decode(
 
                   while ((currentFrame < imageFrames)&&(result.good()))
                   {
+                    if ((currentFrame == 1) && (startFragments != NULL) && (currentItem == startFragments[0]))
+                    {
+                      // the first frame has been decompressed and the color model is known
+                      result = decodeFramesConcurrently(fromRepParam, djcp, jpeg, precision, isYBR, isSigned, pixSeq,
+                        startFragments, OFstatic_cast(Uint32, imageFrames - 1), imageData8, frameSize, frameSize,
+                        imageColumns, imageRows, imageSamplesPerPixel, createPlanarConfiguration, OFFalse);
+                      currentFrame = imageFrames;
+                      break;
+                    }
                     result = jpeg->init();
                     if (result.good())
                     {
@@ -313,6 +342,7 @@ OFCondition DJCodecDecoder::decode(
 
                   // Pixel Representation could be signed if lossless JPEG. For now, we just believe what we get.
                 }
+                delete[] startFragments;
                 delete jpeg;
               }
             }
@@ -529,6 +559,380 @@ OFCondition DJCodecDecoder::decodeFrame(
 }
 
 
+OFCondition DJCodecDecoder::decodeFrames(
+    const DcmRepresentationParameter *fromParam,
+    DcmPixelSequence *fromPixSeq,
+    const DcmCodecParameter *cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    void *buffer,
+    Uint32 frameBufSize,
+    OFString& decompressedColorModel) const
+{
+  if ((!dataset) || (buffer == NULL) || (numberOfFrames == 0)) return EC_IllegalCall;
+
+  // the first frame is always decompressed by decodeFrame(), which also checks the image attributes
+  OFCondition result = decodeFrame(fromParam, fromPixSeq, cp, dataset, firstFrame, startFragment,
+    buffer, frameBufSize, decompressedColorModel);
+  if (result.bad() || (numberOfFrames == 1)) return result;
+  Uint8 *frameBuffer = OFstatic_cast(Uint8 *, buffer) + frameBufSize;
+
+#ifdef WITH_THREADS
+  // assume we can cast the codec parameter to what we need
+  const DJCodecParameter *djcp = OFreinterpret_cast(const DJCodecParameter*, cp);
+  if (djcp->getNumberOfThreads() > 1)
+  {
+    Uint16 imageSamplesPerPixel = 0;
+    Uint16 imageRows = 0;
+    Uint16 imageColumns = 0;
+    Sint32 imageFrames = 1;
+    Uint16 planarConfig = 0;
+    Uint16 pixelRep = 0;
+    dataset->findAndGetUint16(DCM_SamplesPerPixel, imageSamplesPerPixel);
+    dataset->findAndGetUint16(DCM_Rows, imageRows);
+    dataset->findAndGetUint16(DCM_Columns, imageColumns);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRep);
+    if (imageSamplesPerPixel > 1) dataset->findAndGetUint16(DCM_PlanarConfiguration, planarConfig);
+    dataset->findAndGetSint32(DCM_NumberOfFrames, imageFrames);
+    if (imageFrames < 1) imageFrames = 1;
+
+    EP_Interpretation dicomPI = DcmJpegHelper::getPhotometricInterpretation(dataset);
+    OFBool isYBR = OFFalse;
+    if ((dicomPI == EPI_YBR_Full)||(dicomPI == EPI_YBR_Full_422)||(dicomPI == EPI_YBR_Partial_422)) isYBR = OFTrue;
+
+    // determine the fragments of the remaining frames. If this is not possible,
+    // e.g. because the offset table is empty, decompress the frames sequentially.
+    Uint32 *startFragments = new Uint32[numberOfFrames];
+    DcmPixelItem *pixItem = NULL;
+    Uint8 *jpegData = NULL;
+    if (determineFrameFragments(firstFrame + 1, numberOfFrames - 1, imageFrames, fromPixSeq, startFragments).good() &&
+        (startFragments[0] == startFragment) &&
+        fromPixSeq->getItem(pixItem, startFragment).good() &&
+        pixItem->getUint8Array(jpegData).good() && (jpegData != NULL))
+    {
+      Uint8 precision = scanJpegDataForBitDepth(jpegData, pixItem->getLength());
+      size_t frameSize = ((precision > 8) ? sizeof(Uint16) : sizeof(Uint8)) * imageRows * imageColumns * imageSamplesPerPixel;
+      if (precision == 0) result = EC_CannotChangeRepresentation; // something has gone wrong, bail out
+      else if (frameSize > frameBufSize) result = EC_IllegalCall;
+      else
+      {
+        DJDecoder *jpeg = createDecoderInstance(fromParam, djcp, precision, isYBR);
+        if (jpeg == NULL) result = EC_MemoryExhausted;
+        else
+        {
+          result = decodeFramesConcurrently(fromParam, djcp, jpeg, precision, isYBR, (pixelRep != 0), fromPixSeq,
+            startFragments, numberOfFrames - 1, frameBuffer, frameBufSize, frameSize,
+            imageColumns, imageRows, imageSamplesPerPixel, (planarConfig == 1), OFTrue);
+          delete jpeg;
+        }
+      }
+      if (result.good())
+      {
+        /* remove all used fragments from memory */
+        for (Uint32 i = startFragments[0]; i < startFragments[numberOfFrames - 1]; i++)
+        {
+          if (fromPixSeq->getItem(pixItem, i).good()) pixItem->compact();
+        }
+        startFragment = startFragments[numberOfFrames - 1];
+      }
+      delete[] startFragments;
+      return result;
+    }
+    DCMJPEG_DEBUG("JPEG decoder: cannot determine fragments of all frames, decompressing frames sequentially");
+    delete[] startFragments;
+  }
+#endif
+
+  return DcmCodec::decodeFrames(fromParam, fromPixSeq, cp, dataset, firstFrame + 1, numberOfFrames - 1,
+    startFragment, frameBuffer, frameBufSize, decompressedColorModel);
+}
+
+
+/** helper class for the concurrent decompression of frames. Each thread
+ *  fetches the next frame that has not yet been taken and decompresses it
+ *  using its own decoder instance. The compressed fragments are accessed
+ *  in advance, since the pixel sequence must not be used by multiple threads.
+ */
+class DJFrameDecoderJob
+{
+public:
+
+  /** constructor
+   *  @param fragments compressed fragments of all frames
+   *  @param fragmentLengths length of the compressed fragments
+   *  @param startFragments index of the first fragment of each frame (relative to the
+   *    fragments array), followed by the number of fragments
+   *  @param numFrames number of frames to be decompressed
+   *  @param buffer buffer for the first frame
+   *  @param frameBufSize offset between two frames in the buffer
+   *  @param frameSize size of an uncompressed frame
+   *  @param isSigned true if the pixel data is signed
+   */
+  DJFrameDecoderJob(Uint8 **fragments, const Uint32 *fragmentLengths, const Uint32 *startFragments,
+    size_t numFrames, Uint8 *buffer, size_t frameBufSize, size_t frameSize, OFBool isSigned)
+  : fragments_(fragments)
+  , fragmentLengths_(fragmentLengths)
+  , startFragments_(startFragments)
+  , numFrames_(numFrames)
+  , buffer_(buffer)
+  , frameBufSize_(frameBufSize)
+  , frameSize_(frameSize)
+  , isSigned_(isSigned)
+  , results_(new OFCondition[numFrames])
+  , nextFrame_(0)
+  , mutex_()
+  {
+  }
+
+  /// destructor
+  ~DJFrameDecoderJob()
+  {
+    delete[] results_;
+  }
+
+  /** decompresses frames until all frames are processed.
+   *  May be called by multiple threads concurrently.
+   *  @param jpeg decoder instance used by the calling thread
+   */
+  void decodeFrames(DJDecoder &jpeg)
+  {
+    size_t i;
+    while ((i = fetchFrame()) < numFrames_)
+    {
+      Uint8 *frame = buffer_ + i * frameBufSize_;
+      OFCondition result = jpeg.init();
+      if (result.good())
+      {
+        Uint32 fragment = startFragments_[i];
+        result = EJ_Suspension;
+        while (EJ_Suspension == result)
+        {
+          // the bitstream must not continue in the fragments of the next frame
+          if (fragment == startFragments_[i + 1]) result = EC_CorruptedData;
+          else
+          {
+            result = jpeg.decode(fragments_[fragment], fragmentLengths_[fragment], frame, OFstatic_cast(Uint32, frameSize_), isSigned_);
+            ++fragment;
+          }
+        }
+      }
+      results_[i] = result;
+    }
+  }
+
+  /// array of the decompression results for the frames
+  const OFCondition *results() const { return results_; }
+
+private:
+
+  /// private undefined copy constructor
+  DJFrameDecoderJob(const DJFrameDecoderJob&);
+
+  /// private undefined copy assignment operator
+  DJFrameDecoderJob& operator=(const DJFrameDecoderJob&);
+
+  /** returns the index of the next frame to be decompressed (and marks it as taken)
+   *  @return index of the next frame, numFrames_ if all frames have been taken
+   */
+  size_t fetchFrame()
+  {
+    mutex_.lock();
+    const size_t i = (nextFrame_ < numFrames_) ? nextFrame_++ : numFrames_;
+    mutex_.unlock();
+    return i;
+  }
+
+  /// compressed fragments
+  Uint8 **fragments_;
+
+  /// length of the compressed fragments
+  const Uint32 *fragmentLengths_;
+
+  /// index of the first fragment of each frame
+  const Uint32 *startFragments_;
+
+  /// number of frames
+  size_t numFrames_;
+
+  /// buffer for the uncompressed frames
+  Uint8 *buffer_;
+
+  /// offset between two frames in the buffer
+  size_t frameBufSize_;
+
+  /// size of an uncompressed frame
+  size_t frameSize_;
+
+  /// true if the pixel data is signed
+  OFBool isSigned_;
+
+  /// decompression results
+  OFCondition *results_;
+
+  /// index of the next frame to be decompressed
+  size_t nextFrame_;
+
+  /// mutex protecting nextFrame_
+  OFMutex mutex_;
+};
+
+
+#ifdef WITH_THREADS
+
+/** worker thread decompressing frames of a DJFrameDecoderJob
+ */
+class DJFrameDecoderThread : public OFThread
+{
+public:
+
+  /** constructor
+   *  @param job job from which the frames are fetched
+   *  @param jpeg decoder instance of this thread, deleted by the destructor
+   */
+  DJFrameDecoderThread(DJFrameDecoderJob &job, DJDecoder *jpeg)
+  : OFThread()
+  , job_(job)
+  , jpeg_(jpeg)
+  {
+  }
+
+  /// destructor
+  virtual ~DJFrameDecoderThread()
+  {
+    delete jpeg_;
+  }
+
+protected:
+
+  /// decompresses frames until all frames of the job are processed
+  virtual void run()
+  {
+    job_.decodeFrames(*jpeg_);
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DJFrameDecoderThread(const DJFrameDecoderThread&);
+
+  /// private undefined copy assignment operator
+  DJFrameDecoderThread& operator=(const DJFrameDecoderThread&);
+
+  /// job from which the frames are fetched
+  DJFrameDecoderJob &job_;
+
+  /// decoder instance of this thread
+  DJDecoder *jpeg_;
+};
+
+#endif
+
+
+OFCondition DJCodecDecoder::decodeFramesConcurrently(
+    const DcmRepresentationParameter * fromParam,
+    const DJCodecParameter *cp,
+    DJDecoder *jpeg,
+    Uint8 precision,
+    OFBool isYBR,
+    OFBool isSigned,
+    DcmPixelSequence *pixSeq,
+    const Uint32 *startFragments,
+    Uint32 numberOfFrames,
+    Uint8 *buffer,
+    size_t frameBufSize,
+    size_t frameSize,
+    Uint16 columns,
+    Uint16 rows,
+    Uint16 samplesPerPixel,
+    OFBool createPlanarConfiguration,
+    OFBool swapFrames) const
+{
+  OFCondition result = EC_Normal;
+  const Uint32 firstFragment = startFragments[0];
+  const Uint32 numFragments = startFragments[numberOfFrames] - firstFragment;
+
+  // access the compressed fragments of all frames
+  Uint8 **fragments = new Uint8 *[numFragments];
+  Uint32 *fragmentLengths = new Uint32[numFragments];
+  Uint32 *frameFragments = new Uint32[numberOfFrames + 1];
+  for (Uint32 i = 0; i <= numberOfFrames; i++)
+    frameFragments[i] = startFragments[i] - firstFragment;
+  DcmPixelItem *pixItem = NULL;
+  for (Uint32 i = 0; (i < numFragments) && result.good(); i++)
+  {
+    fragments[i] = NULL;
+    result = pixSeq->getItem(pixItem, firstFragment + i);
+    if (result.good())
+    {
+      fragmentLengths[i] = pixItem->getLength();
+      result = pixItem->getUint8Array(fragments[i]);
+      if (result.good() && (fragments[i] == NULL)) result = EC_CorruptedData; // JPEG data stream is empty/absent
+    }
+  }
+
+  if (result.good())
+  {
+    DCMJPEG_DEBUG("JPEG decoder: decompressing " << numberOfFrames << " frames using up to "
+      << cp->getNumberOfThreads() << " threads");
+    DJFrameDecoderJob job(fragments, fragmentLengths, frameFragments, numberOfFrames, buffer, frameBufSize, frameSize, isSigned);
+
+    // decompress the frames, using additional threads with their own decoder instance
+#ifdef WITH_THREADS
+    OFList<DJFrameDecoderThread *> threads;
+    for (Uint32 i = 1; (i < cp->getNumberOfThreads()) && (i < numberOfFrames); i++)
+    {
+      DJDecoder *decoder = createDecoderInstance(fromParam, cp, precision, isYBR);
+      if (decoder == NULL) break;
+      DJFrameDecoderThread *thread = new DJFrameDecoderThread(job, decoder);
+      if (thread->start() != 0)
+      {
+        // the remaining frames are decompressed by the other threads
+        delete thread;
+        break;
+      }
+      threads.push_back(thread);
+    }
+#endif
+    job.decodeFrames(*jpeg);
+#ifdef WITH_THREADS
+    while (!threads.empty())
+    {
+      threads.front()->join();
+      delete threads.front();
+      threads.pop_front();
+    }
+#endif
+
+    // check the results and convert planar configuration and byte order if necessary
+    const OFCondition *results = job.results();
+    Uint8 *frame = buffer;
+    for (Uint32 i = 0; (i < numberOfFrames) && result.good(); i++)
+    {
+      result = results[i];
+      if (result.good() && (samplesPerPixel == 3) && createPlanarConfiguration)
+      {
+        if (precision > 8)
+          result = createPlanarConfigurationWord(OFreinterpret_cast(Uint16*, frame), columns, rows);
+          else result = createPlanarConfigurationByte(frame, columns, rows);
+      }
+      if (result.good() && swapFrames && (jpeg->bytesPerSample() == 1))
+      {
+        result = swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, OFreinterpret_cast(Uint16*, frame),
+          OFstatic_cast(Uint32, frameSize), sizeof(Uint16));
+      }
+      frame += frameBufSize;
+    }
+  }
+
+  delete[] fragments;
+  delete[] fragmentLengths;
+  delete[] frameFragments;
+  return result;
+}
+
+
 OFCondition DJCodecDecoder::encode(
     const Uint16 * /* pixelData */,
     const Uint32 /* length */,
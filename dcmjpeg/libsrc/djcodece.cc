@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2001-2014, OFFIS e.V.
+ *  Copyright (C) 2001-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,6 +25,7 @@
 // ofstd includes
 #include "dcmtk/ofstd/oflist.h"
 #include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofthread.h"
 
 // dcmdata includes
 #include "dcmtk/dcmdata/dcdatset.h"   /* for class DcmDataset */
@@ -48,6 +49,7 @@
 #include "dcmtk/dcmimgle/dcmimage.h"  /* for class DicomImage */
 
 #define INCLUDE_CMATH
+#define INCLUDE_NEW
 #include "dcmtk/ofstd/ofstdinc.h"
 
 
@@ -337,41 +339,13 @@ OFCondition DJCodecEncoder::encodeColorImage(
       // render and compress each frame
       bitsPerSample = jpeg->bitsPerSample();
       size_t frameCount = dimage->getFrameCount();
-      unsigned short bytesPerSample = jpeg->bytesPerSample();
       unsigned short columns = OFstatic_cast(unsigned short, dimage->getWidth());
       unsigned short rows = OFstatic_cast(unsigned short, dimage->getHeight());
-      Uint8 *jpegData = NULL;
-      Uint32 jpegLen  = 0;
-      const void *frame = NULL;
 
       // compute original image size in bytes, ignoring any padding bits.
       uncompressedSize = OFstatic_cast(double, columns * rows * dimage->getDepth() * frameCount * samplesPerPixel) / 8.0;
-      for (size_t i=0; (i<frameCount) && (result.good()); i++)
-      {
-        frame = dimage->getOutputData(bitsPerSample, i, 0);
-        if (frame == NULL) result = EC_MemoryExhausted;
-        else
-        {
-          // compress frame
-          jpegData = NULL;
-          if (bytesPerSample == 1)
-          {
-            result = jpeg->encode(columns, rows, interpr, samplesPerPixel, OFreinterpret_cast(Uint8*, OFconst_cast(void*, frame)), jpegData, jpegLen);
-          } else {
-            result = jpeg->encode(columns, rows, interpr, samplesPerPixel, OFreinterpret_cast(Uint16*, OFconst_cast(void*, frame)), jpegData, jpegLen);
-          }
-
-          // store frame
-          if (result.good())
-          {
-            result = pixelSequence->storeCompressedFrame(offsetList, jpegData, jpegLen, cp->getFragmentSize());
-          }
-
-          // delete block of JPEG data
-          delete[] jpegData;
-          compressedSize += jpegLen;
-        }
-      }
+      result = encodeFrames(toRepParam, cp, OFstatic_cast(Uint8, compressedBits), jpeg, dimage, NULL, 0, frameCount,
+        columns, rows, interpr, samplesPerPixel, pixelSequence, offsetList, compressedSize);
       delete jpeg;
     } else result = EC_MemoryExhausted;
   }
@@ -466,8 +440,6 @@ OFCondition DJCodecEncoder::encodeTrueLossless(
     Uint16 rows = 0;
     Sint32 numberOfFrames = 1;
     EP_Interpretation interpr = EPI_Unknown;
-    Uint8 *jpegData = NULL;
-    Uint32 jpegLen  = 0;
     OFBool byteSwapped = OFFalse;      // true if we have byte-swapped the original pixel data
     OFBool planConfSwitched = OFFalse; // true if planar configuration was toggled
     DcmOffsetList offsetList;
@@ -601,31 +573,13 @@ OFCondition DJCodecEncoder::encodeTrueLossless(
     DJEncoder *jpeg = createEncoderInstance(toRepParam, djcp, OFstatic_cast(Uint8, bitsAllocated));
     if (jpeg)
     {
-      // main loop for compression: compress each frame
-      for (unsigned int i=0; i<frameCount && result.good(); i++)
+      // main loop for compression: compress each frame (possibly concurrently)
+      if (result.good())
       {
-        if (bitsAllocated == 8)
-        {
-          jpeg->encode(columns, rows, interpr, samplesPerPixel, OFconst_cast(Uint8*, framePointer), jpegData, jpegLen);
-        }
-        else if (bitsAllocated == 16)
-        {
-          jpeg->encode(columns, rows, interpr, samplesPerPixel, OFreinterpret_cast(Uint16*, OFconst_cast(Uint8*, framePointer)), jpegData, jpegLen);
-        }
-        // update variables
-        compressedSize+=jpegLen;
-        framePointer+=frameSize;
-        if (jpegLen == 0)
-        {
+        result = encodeFrames(toRepParam, djcp, OFstatic_cast(Uint8, bitsAllocated), jpeg, NULL, framePointer, frameSize, frameCount,
+          columns, rows, interpr, samplesPerPixel, pixelSequence, offsetList, compressedSize);
+        if (result.bad())
           DCMJPEG_ERROR("True lossless encoder: Error encoding frame");
-          result = EC_CannotChangeRepresentation;
-        }
-        else
-        {
-          result = pixelSequence->storeCompressedFrame(offsetList, jpegData, jpegLen, djcp->getFragmentSize());
-        }
-        // free memory
-        delete[] jpegData;
       }
     }
     else
@@ -700,6 +654,402 @@ OFCondition DJCodecEncoder::encodeTrueLossless(
 }
 
 
+/** helper class for the compression of a number of frames by one or more
+ *  threads. Each thread fetches the next frame that has not been compressed
+ *  yet and compresses it with its own encoder instance.
+ */
+class DJFrameEncoderJob
+{
+public:
+
+  /** constructor
+   *  @param columns columns of a frame
+   *  @param rows rows of a frame
+   *  @param interpr photometric interpretation of the frames
+   *  @param samplesPerPixel samples per pixel of the frames
+   *  @param maxFrames maximum number of frames compressed in one run
+   */
+  DJFrameEncoderJob(Uint16 columns, Uint16 rows, EP_Interpretation interpr, Uint16 samplesPerPixel, size_t maxFrames)
+  : columns_(columns)
+  , rows_(rows)
+  , interpr_(interpr)
+  , samplesPerPixel_(samplesPerPixel)
+  , frames_(new const void *[maxFrames])
+  , jpegData_(new Uint8 *[maxFrames])
+  , jpegLen_(new Uint32[maxFrames])
+  , results_(new OFCondition[maxFrames])
+  , numFrames_(0)
+  , nextFrame_(0)
+  , mutex_()
+#ifdef WITH_THREADS
+  , finished_(OFFalse)
+  , runStarted_(0)
+  , runCompleted_(0)
+#endif
+  {
+  }
+
+  /// destructor
+  ~DJFrameEncoderJob()
+  {
+    delete[] frames_;
+    delete[] jpegData_;
+    delete[] jpegLen_;
+    delete[] results_;
+  }
+
+  /** starts a new run for the given number of frames
+   *  @param numFrames number of frames to be compressed (stored in frames())
+   */
+  void reset(size_t numFrames)
+  {
+    numFrames_ = numFrames;
+    nextFrame_ = 0;
+    for (size_t i = 0; i < numFrames; i++)
+    {
+      jpegData_[i] = NULL;
+      jpegLen_[i] = 0;
+      results_[i] = EC_Normal;
+    }
+  }
+
+  /** compresses frames until all frames of the current run are processed.
+   *  May be called by multiple threads concurrently.
+   *  @param jpeg encoder instance used by the calling thread
+   */
+  void encodeFrames(DJEncoder &jpeg)
+  {
+    size_t i;
+    while ((i = fetchFrame()) < numFrames_)
+    {
+      if (jpeg.bytesPerSample() == 1)
+        results_[i] = jpeg.encode(columns_, rows_, interpr_, samplesPerPixel_, OFreinterpret_cast(Uint8*, OFconst_cast(void*, frames_[i])), jpegData_[i], jpegLen_[i]);
+      else
+        results_[i] = jpeg.encode(columns_, rows_, interpr_, samplesPerPixel_, OFreinterpret_cast(Uint16*, OFconst_cast(void*, frames_[i])), jpegData_[i], jpegLen_[i]);
+    }
+  }
+
+#ifdef WITH_THREADS
+  /** starts the current run for the given number of worker threads
+   *  @param numWorkers number of worker threads waiting in waitForRun()
+   */
+  void startRun(size_t numWorkers)
+  {
+    for (size_t i = 0; i < numWorkers; i++)
+      runStarted_.post();
+  }
+
+  /** waits until the given number of worker threads has completed the current run
+   *  @param numWorkers number of worker threads participating in the current run
+   */
+  void waitForWorkers(size_t numWorkers)
+  {
+    for (size_t i = 0; i < numWorkers; i++)
+      runCompleted_.wait();
+  }
+
+  /** terminates the given number of worker threads waiting in waitForRun()
+   *  @param numWorkers number of worker threads
+   */
+  void finish(size_t numWorkers)
+  {
+    finished_ = OFTrue;
+    startRun(numWorkers);
+  }
+
+  /** waits until the next run is started (called by the worker threads)
+   *  @return OFTrue if a run has been started, OFFalse if the job is finished
+   */
+  OFBool waitForRun()
+  {
+    runStarted_.wait();
+    return !finished_;
+  }
+
+  /// signals that the calling worker thread has completed the current run
+  void runCompleted()
+  {
+    runCompleted_.post();
+  }
+#endif
+
+  /// array of uncompressed frames of the current run
+  const void **frames() { return frames_; }
+
+  /// array of compressed frames of the current run
+  Uint8 **jpegData() { return jpegData_; }
+
+  /// array of the length of the compressed frames of the current run
+  Uint32 *jpegLen() { return jpegLen_; }
+
+  /// array of the compression results for the frames of the current run
+  OFCondition *results() { return results_; }
+
+private:
+
+  /// private undefined copy constructor
+  DJFrameEncoderJob(const DJFrameEncoderJob&);
+
+  /// private undefined copy assignment operator
+  DJFrameEncoderJob& operator=(const DJFrameEncoderJob&);
+
+  /** returns the index of the next frame to be compressed (and marks it as taken)
+   *  @return index of the next frame, numFrames_ if all frames have been taken
+   */
+  size_t fetchFrame()
+  {
+    mutex_.lock();
+    const size_t i = (nextFrame_ < numFrames_) ? nextFrame_++ : numFrames_;
+    mutex_.unlock();
+    return i;
+  }
+
+  /// columns of a frame
+  Uint16 columns_;
+
+  /// rows of a frame
+  Uint16 rows_;
+
+  /// photometric interpretation of the frames
+  EP_Interpretation interpr_;
+
+  /// samples per pixel of the frames
+  Uint16 samplesPerPixel_;
+
+  /// uncompressed frames
+  const void **frames_;
+
+  /// compressed frames (allocated by the encoder)
+  Uint8 **jpegData_;
+
+  /// length of the compressed frames
+  Uint32 *jpegLen_;
+
+  /// compression results
+  OFCondition *results_;
+
+  /// number of frames in the current run
+  size_t numFrames_;
+
+  /// index of the next frame to be compressed
+  size_t nextFrame_;
+
+  /// mutex protecting nextFrame_
+  OFMutex mutex_;
+
+#ifdef WITH_THREADS
+  /// flag indicating that the worker threads should terminate
+  OFBool finished_;
+
+  /// semaphore signalling the start of a run to the worker threads
+  OFSemaphore runStarted_;
+
+  /// semaphore signalling the completion of a run by a worker thread
+  OFSemaphore runCompleted_;
+#endif
+};
+
+
+#ifdef WITH_THREADS
+
+/** worker thread compressing frames of a DJFrameEncoderJob. The thread
+ *  participates in all runs of the job until the job is finished.
+ */
+class DJFrameEncoderThread : public OFThread
+{
+public:
+
+  /** constructor
+   *  @param job job from which the frames are fetched
+   *  @param jpeg encoder instance of this thread, deleted by the destructor
+   */
+  DJFrameEncoderThread(DJFrameEncoderJob &job, DJEncoder *jpeg)
+  : OFThread()
+  , job_(job)
+  , jpeg_(jpeg)
+  {
+  }
+
+  /// destructor
+  virtual ~DJFrameEncoderThread()
+  {
+    delete jpeg_;
+  }
+
+protected:
+
+  /// compresses frames of each run until the job is finished
+  virtual void run()
+  {
+    while (job_.waitForRun())
+    {
+      job_.encodeFrames(*jpeg_);
+      job_.runCompleted();
+    }
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DJFrameEncoderThread(const DJFrameEncoderThread&);
+
+  /// private undefined copy assignment operator
+  DJFrameEncoderThread& operator=(const DJFrameEncoderThread&);
+
+  /// job from which the frames are fetched
+  DJFrameEncoderJob &job_;
+
+  /// encoder instance of this thread
+  DJEncoder *jpeg_;
+};
+
+#endif
+
+
+OFCondition DJCodecEncoder::encodeFrames(
+  const DcmRepresentationParameter * toRepParam,
+  const DJCodecParameter *cp,
+  Uint8 compressedBits,
+  DJEncoder *jpeg,
+  DicomImage *image,
+  const Uint8 *pixelData,
+  size_t frameSize,
+  size_t frameCount,
+  Uint16 columns,
+  Uint16 rows,
+  EP_Interpretation interpr,
+  Uint16 samplesPerPixel,
+  DcmPixelSequence *pixelSequence,
+  DcmOffsetList &offsetList,
+  size_t &compressedSize) const
+{
+  OFCondition result = EC_Normal;
+  const int bitsPerSample = jpeg->bitsPerSample();
+
+  // determine the number of frames that are compressed concurrently
+  size_t numThreads = 1;
+#ifdef WITH_THREADS
+  if (cp->getNumberOfThreads() > 1)
+    numThreads = OFstatic_cast(size_t, cp->getNumberOfThreads());
+  if (numThreads > frameCount)
+    numThreads = frameCount;
+#endif
+  if (numThreads < 1)
+    numThreads = 1;
+  DJFrameEncoderJob job(columns, rows, interpr, samplesPerPixel, numThreads);
+
+  // frames rendered from the image need a buffer of their own if compressed concurrently
+  Uint8 *frameBuffer = NULL;
+  unsigned long outputSize = 0;
+  if ((image != NULL) && (numThreads > 1))
+  {
+    outputSize = image->getOutputDataSize(bitsPerSample);
+#ifdef HAVE_STD__NOTHROW
+    frameBuffer = new (std::nothrow) Uint8[numThreads * outputSize];
+#else
+    try
+    {
+      frameBuffer = new Uint8[numThreads * outputSize];
+    }
+    catch (STD_NAMESPACE bad_alloc const &)
+    {
+      frameBuffer = NULL;
+    }
+#endif
+    if (frameBuffer == NULL)
+    {
+      // not enough memory for the frame buffers, compress the frames one after the other
+      DCMJPEG_WARN("JPEG encoder: cannot allocate frame buffers, compressing frames sequentially");
+      numThreads = 1;
+    }
+  }
+
+  // start additional threads with their own encoder instance, used for all runs
+#ifdef WITH_THREADS
+  OFList<DJFrameEncoderThread *> threads;
+  for (size_t i = 1; i < numThreads; i++)
+  {
+    DJEncoder *encoder = createEncoderInstance(toRepParam, cp, compressedBits);
+    if (encoder == NULL) break;
+    DJFrameEncoderThread *thread = new DJFrameEncoderThread(job, encoder);
+    if (thread->start() != 0)
+    {
+      // the frames are compressed by the other threads
+      delete thread;
+      break;
+    }
+    threads.push_back(thread);
+  }
+#endif
+
+  for (size_t first = 0; (first < frameCount) && result.good(); first += numThreads)
+  {
+    const size_t numFrames = (frameCount - first < numThreads) ? (frameCount - first) : numThreads;
+    job.reset(numFrames);
+    const void **frames = job.frames();
+
+    // render or locate the uncompressed frames of this run
+    for (size_t i = 0; (i < numFrames) && result.good(); i++)
+    {
+      if (image == NULL)
+        frames[i] = pixelData + (first + i) * frameSize;
+      else if (numThreads == 1)
+        frames[i] = image->getOutputData(bitsPerSample, first + i, 0);
+      else if (image->getOutputData(frameBuffer + i * outputSize, outputSize, bitsPerSample, first + i, 0))
+        frames[i] = frameBuffer + i * outputSize;
+      else
+        frames[i] = NULL;
+      if (frames[i] == NULL) result = EC_MemoryExhausted;
+    }
+    if (result.bad()) break;
+
+    // compress the frames, using the additional threads (if any)
+#ifdef WITH_THREADS
+    job.startRun(threads.size());
+#endif
+    job.encodeFrames(*jpeg);
+#ifdef WITH_THREADS
+    job.waitForWorkers(threads.size());
+#endif
+
+    // store the compressed frames in their original order
+    Uint8 **jpegData = job.jpegData();
+    Uint32 *jpegLen = job.jpegLen();
+    OFCondition *results = job.results();
+    for (size_t i = 0; i < numFrames; i++)
+    {
+      if (result.good())
+      {
+        result = results[i];
+        if (result.good() && (jpegLen[i] == 0))
+        {
+          DCMJPEG_ERROR("JPEG encoder: Error encoding frame " << (first + i + 1));
+          result = EC_CannotChangeRepresentation;
+        }
+        if (result.good())
+          result = pixelSequence->storeCompressedFrame(offsetList, jpegData[i], jpegLen[i], cp->getFragmentSize());
+        compressedSize += jpegLen[i];
+      }
+      // delete block of JPEG data
+      delete[] jpegData[i];
+    }
+  }
+
+  // terminate the additional threads
+#ifdef WITH_THREADS
+  job.finish(threads.size());
+  while (!threads.empty())
+  {
+    threads.front()->join();
+    delete threads.front();
+    threads.pop_front();
+  }
+#endif
+  delete[] frameBuffer;
+  return result;
+}
+
+
 void DJCodecEncoder::appendCompressionRatio(
   OFString& arg,
   double ratio)
@@ -1128,43 +1478,15 @@ OFCondition DJCodecEncoder::encodeMonochromeImage(
 
       // render and compress each frame
       size_t frameCount = dimage.getFrameCount();
-      unsigned short bytesPerSample = jpeg->bytesPerSample();
       unsigned short columns = OFstatic_cast(unsigned short, dimage.getWidth());
       unsigned short rows = OFstatic_cast(unsigned short, dimage.getHeight());
-      Uint8 *jpegData = NULL;
-      Uint32 jpegLen  = 0;
-      const void *frame = NULL;
 
       // compute original image size in bytes, ignoring any padding bits.
       Uint16 samplesPerPixel = 0;
       if ((dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel)).bad()) samplesPerPixel = 1;
       uncompressedSize = OFstatic_cast(double, columns * rows * pixelDepth * frameCount * samplesPerPixel) / 8.0;
-      for (size_t i=0; (i<frameCount) && (result.good()); i++)
-      {
-        frame = dimage.getOutputData(bitsPerSample, i, 0);
-        if (frame == NULL) result = EC_MemoryExhausted;
-        else
-        {
-          // compress frame
-          jpegData = NULL;
-          if (bytesPerSample == 1)
-          {
-            result = jpeg->encode(columns, rows, EPI_Monochrome2, 1, OFreinterpret_cast(Uint8*, OFconst_cast(void*, frame)), jpegData, jpegLen);
-          } else {
-            result = jpeg->encode(columns, rows, EPI_Monochrome2, 1, OFreinterpret_cast(Uint16*, OFconst_cast(void*, frame)), jpegData, jpegLen);
-          }
-
-          // store frame
-          if (result.good())
-          {
-            result = pixelSequence->storeCompressedFrame(offsetList, jpegData, jpegLen, cp->getFragmentSize());
-          }
-
-          // delete block of JPEG data
-          delete[] jpegData;
-          compressedSize += jpegLen;
-        }
-      }
+      result = encodeFrames(toRepParam, cp, OFstatic_cast(Uint8, compressedBits), jpeg, &dimage, NULL, 0, frameCount,
+        columns, rows, EPI_Monochrome2, 1, pixelSequence, offsetList, compressedSize);
       delete jpeg;
     } else result = EC_MemoryExhausted;
   }
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2010, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -45,7 +45,8 @@ void DJDecoderRegistration::registerCodecs(
     E_DecompressionColorSpaceConversion pDecompressionCSConversion,
     E_UIDCreation pCreateSOPInstanceUID,
     E_PlanarConfiguration pPlanarConfiguration,
-    OFBool predictor6WorkaroundEnable)
+    OFBool predictor6WorkaroundEnable,
+    Uint32 pNumberOfThreads)
 {
   if (! registered)
   {
@@ -54,7 +55,10 @@ void DJDecoderRegistration::registerCodecs(
       pDecompressionCSConversion, 
       pCreateSOPInstanceUID, 
       pPlanarConfiguration,
-      predictor6WorkaroundEnable);
+      predictor6WorkaroundEnable,
+      OFFalse, 0, 0, 0, OFTrue, ESS_444, OFFalse, OFFalse, // ignored, compression only
+      0, 0, 0.0, 0.0, 0, 0, 0, 0, OFTrue, OFFalse, OFFalse, OFFalse, OFTrue,
+      pNumberOfThreads);
     if (cp)
     {
       // baseline JPEG
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2001-2014, OFFIS e.V.
+ *  Copyright (C) 2001-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -207,7 +207,22 @@ OFCondition DJDecompressIJG16Bit::init()
 {
   suspension = 0;
   decompressedColorModel = EPI_Unknown;
-  cleanup(); // prevent double initialization
+  jsampBuffer = NULL;
+
+  // if this object has already decompressed a frame, reset the existing
+  // IJG decompression object instead of creating a new one. This keeps the
+  // memory manager and the permanent pool (e.g. quantization tables) alive.
+  if (cinfo)
+  {
+    jpeg_abort_decompress(cinfo);
+    DJDIJG16SourceManagerStruct *src = OFreinterpret_cast(DJDIJG16SourceManagerStruct*, cinfo->src);
+    src->pub.bytes_in_buffer   = 0;
+    src->pub.next_input_byte   = NULL;
+    src->skip_bytes            = 0;
+    src->next_buffer           = NULL;
+    src->next_buffer_size      = 0;
+    return EC_Normal;
+  }
 
   cinfo = new jpeg_decompress_struct();
   if (cinfo)
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2014, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -302,6 +302,7 @@ DJCompressIJG12Bit::DJCompressIJG12Bit(const DJCodecParameter& cp, EJ_Mode mode,
 , modeofOperation(mode)
 , pixelDataList()
 , bytesInLastBlock(0)
+, cinfo(NULL)
 {
   assert((mode != EJM_lossless) && (mode != EJM_baseline));
 }
@@ -315,6 +316,7 @@ DJCompressIJG12Bit::DJCompressIJG12Bit(const DJCodecParameter& cp, EJ_Mode mode,
 , modeofOperation(mode)
 , pixelDataList()
 , bytesInLastBlock(0)
+, cinfo(NULL)
 {
   assert(mode == EJM_lossless);
 }
@@ -322,6 +324,56 @@ DJCompressIJG12Bit::DJCompressIJG12Bit(const DJCodecParameter& cp, EJ_Mode mode,
 DJCompressIJG12Bit::~DJCompressIJG12Bit()
 {
   cleanup();
+  destroyCompressor();
+}
+
+OFCondition DJCompressIJG12Bit::initCompressor()
+{
+  destroyCompressor(); // prevent double initialization
+
+  cinfo = new jpeg_compress_struct();
+  DJEIJG12ErrorStruct *jerr = new DJEIJG12ErrorStruct();
+  jpeg_destination_mgr *dest = new jpeg_destination_mgr();
+  cinfo->err = jpeg_std_error(&jerr->pub);
+  jerr->instance = this;
+  jerr->pub.error_exit = DJEIJG12ErrorExit;
+  jerr->pub.emit_message = DJEIJG12EmitMessage;
+  if (setjmp(jerr->setjmp_buffer))
+  {
+    // the IJG error handler will cause the following code to be executed
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(OFreinterpret_cast(jpeg_common_struct*, cinfo), buffer); /* Create the message */
+    jpeg_destroy_compress(cinfo);
+    delete dest;
+    delete jerr;
+    delete cinfo;
+    cinfo = NULL;
+    return makeOFCondition(OFM_dcmjpeg, EJCode_IJG12_Compression, OF_error, buffer);
+  }
+  OFjpeg_create_compress(cinfo);
+
+  // initialize client_data
+  cinfo->client_data = this;
+
+  // Specify destination manager
+  dest->init_destination = DJEIJG12initDestination;
+  dest->empty_output_buffer = DJEIJG12emptyOutputBuffer;
+  dest->term_destination = DJEIJG12termDestination;
+  cinfo->dest = dest;
+
+  return EC_Normal;
+}
+
+void DJCompressIJG12Bit::destroyCompressor()
+{
+  if (cinfo)
+  {
+    jpeg_destroy_compress(cinfo);
+    delete OFreinterpret_cast(DJEIJG12ErrorStruct*, cinfo->err);
+    delete cinfo->dest;
+    delete cinfo;
+    cinfo = NULL;
+  }
 }
 
 OFCondition DJCompressIJG12Bit::encode(
@@ -346,113 +398,104 @@ OFCondition DJCompressIJG12Bit::encode(
   Uint32 & length)
 {
 
-  struct jpeg_compress_struct cinfo;
-  struct DJEIJG12ErrorStruct jerr;
-  cinfo.err = jpeg_std_error(&jerr.pub);
-  jerr.instance = this;
-  jerr.pub.error_exit = DJEIJG12ErrorExit;
-  jerr.pub.emit_message = DJEIJG12EmitMessage;
-  if (setjmp(jerr.setjmp_buffer))
+  // create the IJG compression object for the first frame and re-use it
+  // for all subsequent frames compressed by this object
+  if (cinfo == NULL)
+  {
+    OFCondition result = initCompressor();
+    if (result.bad()) return result;
+  }
+
+  DJEIJG12ErrorStruct *jerr = OFreinterpret_cast(DJEIJG12ErrorStruct*, cinfo->err);
+  if (setjmp(jerr->setjmp_buffer))
   {
     // the IJG error handler will cause the following code to be executed
-    char buffer[JMSG_LENGTH_MAX];    
-    (*cinfo.err->format_message)(OFreinterpret_cast(jpeg_common_struct*, &cinfo), buffer); /* Create the message */
-    jpeg_destroy_compress(&cinfo);
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(OFreinterpret_cast(jpeg_common_struct*, cinfo), buffer); /* Create the message */
+    destroyCompressor();
     return makeOFCondition(OFM_dcmjpeg, EJCode_IJG12_Compression, OF_error, buffer);
   }
-  OFjpeg_create_compress(&cinfo);
-
-  // initialize client_data
-  cinfo.client_data = this;
-
-  // Specify destination manager
-  jpeg_destination_mgr dest;
-  dest.init_destination = DJEIJG12initDestination;
-  dest.empty_output_buffer = DJEIJG12emptyOutputBuffer;
-  dest.term_destination = DJEIJG12termDestination;
-  cinfo.dest = &dest;
 
-  cinfo.image_width = columns;
-  cinfo.image_height = rows;
-  cinfo.input_components = samplesPerPixel;
-  cinfo.in_color_space = getJpegColorSpace(colorSpace);
+  cinfo->image_width = columns;
+  cinfo->image_height = rows;
+  cinfo->input_components = samplesPerPixel;
+  cinfo->in_color_space = getJpegColorSpace(colorSpace);
 
-  jpeg_set_defaults(&cinfo);
+  jpeg_set_defaults(cinfo);
 
   if (cparam->getCompressionColorSpaceConversion() != ECC_lossyYCbCr)
   {
     // prevent IJG library from doing any color space conversion
-    jpeg_set_colorspace (&cinfo, cinfo.in_color_space);
+    jpeg_set_colorspace (cinfo, cinfo->in_color_space);
   }
 
-  cinfo.optimize_coding = OFTrue; // must always be true for 12 bit compression
+  cinfo->optimize_coding = OFTrue; // must always be true for 12 bit compression
 
   switch (modeofOperation)
   {
     case EJM_baseline: // baseline only supports 8 bits/sample. Assume sequential.
     case EJM_sequential:
-      jpeg_set_quality(&cinfo, quality, 0);
+      jpeg_set_quality(cinfo, quality, 0);
       break;
     case EJM_spectralSelection:
-      jpeg_set_quality(&cinfo, quality, 0);
-      jpeg_simple_spectral_selection(&cinfo);
+      jpeg_set_quality(cinfo, quality, 0);
+      jpeg_simple_spectral_selection(cinfo);
       break;
     case EJM_progressive:
-      jpeg_set_quality(&cinfo, quality, 0);
-      jpeg_simple_progression(&cinfo);
+      jpeg_set_quality(cinfo, quality, 0);
+      jpeg_simple_progression(cinfo);
       break;
     case EJM_lossless:
      // always disables any kind of color space conversion
-     jpeg_simple_lossless(&cinfo,psv,pt);
+     jpeg_simple_lossless(cinfo,psv,pt);
      break;
   }
   
-  cinfo.smoothing_factor = cparam->getSmoothingFactor();
+  cinfo->smoothing_factor = cparam->getSmoothingFactor();
 
   // initialize sampling factors
-  if (cinfo.jpeg_color_space == JCS_YCbCr)
+  if (cinfo->jpeg_color_space == JCS_YCbCr)
   {
     switch(cparam->getSampleFactors())
     {
       case ESS_444: /* 4:4:4 sampling (no subsampling) */
-        cinfo.comp_info[0].h_samp_factor = 1;
-        cinfo.comp_info[0].v_samp_factor = 1;
+        cinfo->comp_info[0].h_samp_factor = 1;
+        cinfo->comp_info[0].v_samp_factor = 1;
         break;
       case ESS_422: /* 4:2:2 sampling (horizontal subsampling of chroma components) */
-        cinfo.comp_info[0].h_samp_factor = 2;
-        cinfo.comp_info[0].v_samp_factor = 1;
+        cinfo->comp_info[0].h_samp_factor = 2;
+        cinfo->comp_info[0].v_samp_factor = 1;
         break;
       case ESS_411: /* 4:1:1 sampling (horizontal and vertical subsampling of chroma components) */
-        cinfo.comp_info[0].h_samp_factor = 2;
-        cinfo.comp_info[0].v_samp_factor = 2;
+        cinfo->comp_info[0].h_samp_factor = 2;
+        cinfo->comp_info[0].v_samp_factor = 2;
         break;
     }
   }
   else
   {
     // JPEG color space is not YCbCr, disable subsampling.
-    cinfo.comp_info[0].h_samp_factor = 1;
-    cinfo.comp_info[0].v_samp_factor = 1;
+    cinfo->comp_info[0].h_samp_factor = 1;
+    cinfo->comp_info[0].v_samp_factor = 1;
   }
 
   // all other components are set to 1x1
   for (int sfi=1; sfi< MAX_COMPONENTS; sfi++)
   {
-    cinfo.comp_info[sfi].h_samp_factor = 1;
-    cinfo.comp_info[sfi].v_samp_factor = 1;
+    cinfo->comp_info[sfi].h_samp_factor = 1;
+    cinfo->comp_info[sfi].v_samp_factor = 1;
   }
 
   JSAMPROW row_pointer[1];
-  jpeg_start_compress(&cinfo,TRUE);
+  jpeg_start_compress(cinfo,TRUE);
   int row_stride = columns * samplesPerPixel;
-  while (cinfo.next_scanline < cinfo.image_height) 
+  while (cinfo->next_scanline < cinfo->image_height) 
   {
     // JSAMPLE is signed, typecast to avoid a warning
-    row_pointer[0] = OFreinterpret_cast(JSAMPLE*, image_buffer + (cinfo.next_scanline * row_stride));
-    jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    row_pointer[0] = OFreinterpret_cast(JSAMPLE*, image_buffer + (cinfo->next_scanline * row_stride));
+    jpeg_write_scanlines(cinfo, row_pointer, 1);
   }
-  jpeg_finish_compress(&cinfo);
-  jpeg_destroy_compress(&cinfo);
+  jpeg_finish_compress(cinfo);
 
   length = OFstatic_cast(Uint32, bytesInLastBlock);
   if (pixelDataList.size() > 1) length += OFstatic_cast(Uint32, (pixelDataList.size() - 1)*IJGE12_BLOCKSIZE);
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2014, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -160,6 +160,7 @@ DJCompressIJG16Bit::DJCompressIJG16Bit(const DJCodecParameter& cp, EJ_Mode mode,
 , modeofOperation(mode)
 , pixelDataList()
 , bytesInLastBlock(0)
+, cinfo(NULL)
 {
   assert(mode == EJM_lossless);
 }
@@ -167,6 +168,56 @@ DJCompressIJG16Bit::DJCompressIJG16Bit(const DJCodecParameter& cp, EJ_Mode mode,
 DJCompressIJG16Bit::~DJCompressIJG16Bit()
 {
   cleanup();
+  destroyCompressor();
+}
+
+OFCondition DJCompressIJG16Bit::initCompressor()
+{
+  destroyCompressor(); // prevent double initialization
+
+  cinfo = new jpeg_compress_struct();
+  DJEIJG16ErrorStruct *jerr = new DJEIJG16ErrorStruct();
+  jpeg_destination_mgr *dest = new jpeg_destination_mgr();
+  cinfo->err = jpeg_std_error(&jerr->pub);
+  jerr->instance = this;
+  jerr->pub.error_exit = DJEIJG16ErrorExit;
+  jerr->pub.emit_message = DJEIJG16EmitMessage;
+  if (setjmp(jerr->setjmp_buffer))
+  {
+    // the IJG error handler will cause the following code to be executed
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(OFreinterpret_cast(jpeg_common_struct*, cinfo), buffer); /* Create the message */
+    jpeg_destroy_compress(cinfo);
+    delete dest;
+    delete jerr;
+    delete cinfo;
+    cinfo = NULL;
+    return makeOFCondition(OFM_dcmjpeg, EJCode_IJG16_Compression, OF_error, buffer);
+  }
+  OFjpeg_create_compress(cinfo);
+
+  // initialize client_data
+  cinfo->client_data = this;
+
+  // Specify destination manager
+  dest->init_destination = DJEIJG16initDestination;
+  dest->empty_output_buffer = DJEIJG16emptyOutputBuffer;
+  dest->term_destination = DJEIJG16termDestination;
+  cinfo->dest = dest;
+
+  return EC_Normal;
+}
+
+void DJCompressIJG16Bit::destroyCompressor()
+{
+  if (cinfo)
+  {
+    jpeg_destroy_compress(cinfo);
+    delete OFreinterpret_cast(DJEIJG16ErrorStruct*, cinfo->err);
+    delete cinfo->dest;
+    delete cinfo;
+    cinfo = NULL;
+  }
 }
 
 OFCondition DJCompressIJG16Bit::encode(
@@ -191,104 +242,95 @@ OFCondition DJCompressIJG16Bit::encode(
   Uint32 & length)
 {
 
-  struct jpeg_compress_struct cinfo;
-  struct DJEIJG16ErrorStruct jerr;
-  cinfo.err = jpeg_std_error(&jerr.pub);
-  jerr.instance = this;
-  jerr.pub.error_exit = DJEIJG16ErrorExit;
-  jerr.pub.emit_message = DJEIJG16EmitMessage;
-  if (setjmp(jerr.setjmp_buffer))
+  // create the IJG compression object for the first frame and re-use it
+  // for all subsequent frames compressed by this object
+  if (cinfo == NULL)
+  {
+    OFCondition result = initCompressor();
+    if (result.bad()) return result;
+  }
+
+  DJEIJG16ErrorStruct *jerr = OFreinterpret_cast(DJEIJG16ErrorStruct*, cinfo->err);
+  if (setjmp(jerr->setjmp_buffer))
   {
     // the IJG error handler will cause the following code to be executed
-    char buffer[JMSG_LENGTH_MAX];    
-    (*cinfo.err->format_message)(OFreinterpret_cast(jpeg_common_struct*, &cinfo), buffer); /* Create the message */
-    jpeg_destroy_compress(&cinfo);
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(OFreinterpret_cast(jpeg_common_struct*, cinfo), buffer); /* Create the message */
+    destroyCompressor();
     return makeOFCondition(OFM_dcmjpeg, EJCode_IJG16_Compression, OF_error, buffer);
   }
-  OFjpeg_create_compress(&cinfo);
-
-  // initialize client_data
-  cinfo.client_data = this;
-
-  // Specify destination manager
-  jpeg_destination_mgr dest;
-  dest.init_destination = DJEIJG16initDestination;
-  dest.empty_output_buffer = DJEIJG16emptyOutputBuffer;
-  dest.term_destination = DJEIJG16termDestination;
-  cinfo.dest = &dest;
 
-  cinfo.image_width = columns;
-  cinfo.image_height = rows;
-  cinfo.input_components = samplesPerPixel;
-  cinfo.in_color_space = getJpegColorSpace(colorSpace);
+  cinfo->image_width = columns;
+  cinfo->image_height = rows;
+  cinfo->input_components = samplesPerPixel;
+  cinfo->in_color_space = getJpegColorSpace(colorSpace);
 
-  jpeg_set_defaults(&cinfo);
+  jpeg_set_defaults(cinfo);
 
   if (cparam->getCompressionColorSpaceConversion() != ECC_lossyYCbCr)
   {
     // prevent IJG library from doing any color space conversion
-    jpeg_set_colorspace (&cinfo, cinfo.in_color_space);
+    jpeg_set_colorspace (cinfo, cinfo->in_color_space);
   }
 
-  cinfo.optimize_coding = OFTrue; // must always be true for 16 bit compression
+  cinfo->optimize_coding = OFTrue; // must always be true for 16 bit compression
 
   switch (modeofOperation)
   {
     case EJM_lossless:
      // always disables any kind of color space conversion
-     jpeg_simple_lossless(&cinfo,psv,pt);
+     jpeg_simple_lossless(cinfo,psv,pt);
      break;
     default:
      return makeOFCondition(OFM_dcmjpeg, EJCode_IJG16_Compression, OF_error, "JPEG with 16 bits/sample only allowed with lossless compression");
      /* break; */
   }
   
-  cinfo.smoothing_factor = cparam->getSmoothingFactor();
+  cinfo->smoothing_factor = cparam->getSmoothingFactor();
 
   // initialize sampling factors
-  if (cinfo.jpeg_color_space == JCS_YCbCr)
+  if (cinfo->jpeg_color_space == JCS_YCbCr)
   {
     switch(cparam->getSampleFactors())
     {
       case ESS_444: /* 4:4:4 sampling (no subsampling) */
-        cinfo.comp_info[0].h_samp_factor = 1;
-        cinfo.comp_info[0].v_samp_factor = 1;
+        cinfo->comp_info[0].h_samp_factor = 1;
+        cinfo->comp_info[0].v_samp_factor = 1;
         break;
       case ESS_422: /* 4:2:2 sampling (horizontal subsampling of chroma components) */
-        cinfo.comp_info[0].h_samp_factor = 2;
-        cinfo.comp_info[0].v_samp_factor = 1;
+        cinfo->comp_info[0].h_samp_factor = 2;
+        cinfo->comp_info[0].v_samp_factor = 1;
         break;
       case ESS_411: /* 4:1:1 sampling (horizontal and vertical subsampling of chroma components) */
-        cinfo.comp_info[0].h_samp_factor = 2;
-        cinfo.comp_info[0].v_samp_factor = 2;
+        cinfo->comp_info[0].h_samp_factor = 2;
+        cinfo->comp_info[0].v_samp_factor = 2;
         break;
     }
   }
   else
   {
     // JPEG color space is not YCbCr, disable subsampling.
-    cinfo.comp_info[0].h_samp_factor = 1;
-    cinfo.comp_info[0].v_samp_factor = 1;
+    cinfo->comp_info[0].h_samp_factor = 1;
+    cinfo->comp_info[0].v_samp_factor = 1;
   }
 
   // all other components are set to 1x1
   for (int sfi=1; sfi< MAX_COMPONENTS; sfi++)
   {
-    cinfo.comp_info[sfi].h_samp_factor = 1;
-    cinfo.comp_info[sfi].v_samp_factor = 1;
+    cinfo->comp_info[sfi].h_samp_factor = 1;
+    cinfo->comp_info[sfi].v_samp_factor = 1;
   }
 
   JSAMPROW row_pointer[1];
-  jpeg_start_compress(&cinfo,TRUE);
+  jpeg_start_compress(cinfo,TRUE);
   int row_stride = columns * samplesPerPixel;
-  while (cinfo.next_scanline < cinfo.image_height) 
+  while (cinfo->next_scanline < cinfo->image_height) 
   {
     // JSAMPLE might be signed, typecast to avoid a warning
-    row_pointer[0] = OFreinterpret_cast(JSAMPLE*, image_buffer + (cinfo.next_scanline * row_stride));
-    jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    row_pointer[0] = OFreinterpret_cast(JSAMPLE*, image_buffer + (cinfo->next_scanline * row_stride));
+    jpeg_write_scanlines(cinfo, row_pointer, 1);
   }
-  jpeg_finish_compress(&cinfo);
-  jpeg_destroy_compress(&cinfo);
+  jpeg_finish_compress(cinfo);
 
   length = OFstatic_cast(Uint32, bytesInLastBlock);
   if (pixelDataList.size() > 1) length += OFstatic_cast(Uint32, (pixelDataList.size() - 1)*IJGE16_BLOCKSIZE);
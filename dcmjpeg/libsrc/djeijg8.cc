@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2014, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -303,6 +303,7 @@ DJCompressIJG8Bit::DJCompressIJG8Bit(const DJCodecParameter& cp, EJ_Mode mode, U
 , modeofOperation(mode)
 , pixelDataList()
 , bytesInLastBlock(0)
+, cinfo(NULL)
 {
   assert(mode != EJM_lossless);
 }
@@ -316,6 +317,7 @@ DJCompressIJG8Bit::DJCompressIJG8Bit(const DJCodecParameter& cp, EJ_Mode mode, i
 , modeofOperation(mode)
 , pixelDataList()
 , bytesInLastBlock(0)
+, cinfo(NULL)
 {
   assert(mode == EJM_lossless);
 }
@@ -323,6 +325,56 @@ DJCompressIJG8Bit::DJCompressIJG8Bit(const DJCodecParameter& cp, EJ_Mode mode, i
 DJCompressIJG8Bit::~DJCompressIJG8Bit()
 {
   cleanup();
+  destroyCompressor();
+}
+
+OFCondition DJCompressIJG8Bit::initCompressor()
+{
+  destroyCompressor(); // prevent double initialization
+
+  cinfo = new jpeg_compress_struct();
+  DJEIJG8ErrorStruct *jerr = new DJEIJG8ErrorStruct();
+  jpeg_destination_mgr *dest = new jpeg_destination_mgr();
+  cinfo->err = jpeg_std_error(&jerr->pub);
+  jerr->instance = this;
+  jerr->pub.error_exit = DJEIJG8ErrorExit;
+  jerr->pub.emit_message = DJEIJG8EmitMessage;
+  if (setjmp(jerr->setjmp_buffer))
+  {
+    // the IJG error handler will cause the following code to be executed
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(OFreinterpret_cast(jpeg_common_struct*, cinfo), buffer); /* Create the message */
+    jpeg_destroy_compress(cinfo);
+    delete dest;
+    delete jerr;
+    delete cinfo;
+    cinfo = NULL;
+    return makeOFCondition(OFM_dcmjpeg, EJCode_IJG8_Compression, OF_error, buffer);
+  }
+  OFjpeg_create_compress(cinfo);
+
+  // initialize client_data
+  cinfo->client_data = this;
+
+  // Specify destination manager
+  dest->init_destination = DJEIJG8initDestination;
+  dest->empty_output_buffer = DJEIJG8emptyOutputBuffer;
+  dest->term_destination = DJEIJG8termDestination;
+  cinfo->dest = dest;
+
+  return EC_Normal;
+}
+
+void DJCompressIJG8Bit::destroyCompressor()
+{
+  if (cinfo)
+  {
+    jpeg_destroy_compress(cinfo);
+    delete OFreinterpret_cast(DJEIJG8ErrorStruct*, cinfo->err);
+    delete cinfo->dest;
+    delete cinfo;
+    cinfo = NULL;
+  }
 }
 
 OFCondition DJCompressIJG8Bit::encode(
@@ -347,114 +399,105 @@ OFCondition DJCompressIJG8Bit::encode(
   Uint32 & length)
 {
 
-  struct jpeg_compress_struct cinfo;
-  struct DJEIJG8ErrorStruct jerr;
-  cinfo.err = jpeg_std_error(&jerr.pub);
-  jerr.instance = this;
-  jerr.pub.error_exit = DJEIJG8ErrorExit;
-  jerr.pub.emit_message = DJEIJG8EmitMessage;
-  if (setjmp(jerr.setjmp_buffer))
+  // create the IJG compression object for the first frame and re-use it
+  // for all subsequent frames compressed by this object
+  if (cinfo == NULL)
+  {
+    OFCondition result = initCompressor();
+    if (result.bad()) return result;
+  }
+
+  DJEIJG8ErrorStruct *jerr = OFreinterpret_cast(DJEIJG8ErrorStruct*, cinfo->err);
+  if (setjmp(jerr->setjmp_buffer))
   {
     // the IJG error handler will cause the following code to be executed
-    char buffer[JMSG_LENGTH_MAX];    
-    (*cinfo.err->format_message)(OFreinterpret_cast(jpeg_common_struct*, &cinfo), buffer); /* Create the message */
-    jpeg_destroy_compress(&cinfo);
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(OFreinterpret_cast(jpeg_common_struct*, cinfo), buffer); /* Create the message */
+    destroyCompressor();
     return makeOFCondition(OFM_dcmjpeg, EJCode_IJG8_Compression, OF_error, buffer);
   }
-  OFjpeg_create_compress(&cinfo);
-
-  // initialize client_data
-  cinfo.client_data = this;
-
-  // Specify destination manager
-  jpeg_destination_mgr dest;
-  dest.init_destination = DJEIJG8initDestination;
-  dest.empty_output_buffer = DJEIJG8emptyOutputBuffer;
-  dest.term_destination = DJEIJG8termDestination;
-  cinfo.dest = &dest;
 
-  cinfo.image_width = columns;
-  cinfo.image_height = rows;
-  cinfo.input_components = samplesPerPixel;
-  cinfo.in_color_space = getJpegColorSpace(colorSpace);
+  cinfo->image_width = columns;
+  cinfo->image_height = rows;
+  cinfo->input_components = samplesPerPixel;
+  cinfo->in_color_space = getJpegColorSpace(colorSpace);
 
-  jpeg_set_defaults(&cinfo);
+  jpeg_set_defaults(cinfo);
 
   if (cparam->getCompressionColorSpaceConversion() != ECC_lossyYCbCr)
   {
     // prevent IJG library from doing any color space conversion
-    jpeg_set_colorspace (&cinfo, cinfo.in_color_space);
+    jpeg_set_colorspace (cinfo, cinfo->in_color_space);
   }
 
-  cinfo.optimize_coding = cparam->getOptimizeHuffmanCoding();
+  cinfo->optimize_coding = cparam->getOptimizeHuffmanCoding();
 
   switch (modeofOperation)
   {
     case EJM_baseline:
-      jpeg_set_quality(&cinfo, quality, 1);
+      jpeg_set_quality(cinfo, quality, 1);
       break;
     case EJM_sequential:
-      jpeg_set_quality(&cinfo, quality, 0);
+      jpeg_set_quality(cinfo, quality, 0);
       break;
     case EJM_spectralSelection:
-      jpeg_set_quality(&cinfo, quality, 0);
-      jpeg_simple_spectral_selection(&cinfo);
+      jpeg_set_quality(cinfo, quality, 0);
+      jpeg_simple_spectral_selection(cinfo);
       break;
     case EJM_progressive:
-      jpeg_set_quality(&cinfo, quality, 0);
-      jpeg_simple_progression(&cinfo);
+      jpeg_set_quality(cinfo, quality, 0);
+      jpeg_simple_progression(cinfo);
       break;
     case EJM_lossless:
      // always disables any kind of color space conversion
-     jpeg_simple_lossless(&cinfo,psv,pt);
+     jpeg_simple_lossless(cinfo,psv,pt);
      break;
   }
   
-  cinfo.smoothing_factor = cparam->getSmoothingFactor();
+  cinfo->smoothing_factor = cparam->getSmoothingFactor();
 
   // initialize sampling factors
-  if (cinfo.jpeg_color_space == JCS_YCbCr)
+  if (cinfo->jpeg_color_space == JCS_YCbCr)
   {
     switch(cparam->getSampleFactors())
     {
       case ESS_444: /* 4:4:4 sampling (no subsampling) */
-        cinfo.comp_info[0].h_samp_factor = 1;
-        cinfo.comp_info[0].v_samp_factor = 1;
+        cinfo->comp_info[0].h_samp_factor = 1;
+        cinfo->comp_info[0].v_samp_factor = 1;
         break;
       case ESS_422: /* 4:2:2 sampling (horizontal subsampling of chroma components) */
-        cinfo.comp_info[0].h_samp_factor = 2;
-        cinfo.comp_info[0].v_samp_factor = 1;
+        cinfo->comp_info[0].h_samp_factor = 2;
+        cinfo->comp_info[0].v_samp_factor = 1;
         break;
       case ESS_411: /* 4:1:1 sampling (horizontal and vertical subsampling of chroma components) */
-        cinfo.comp_info[0].h_samp_factor = 2;
-        cinfo.comp_info[0].v_samp_factor = 2;
+        cinfo->comp_info[0].h_samp_factor = 2;
+        cinfo->comp_info[0].v_samp_factor = 2;
         break;
     }
   }
   else
   {
     // JPEG color space is not YCbCr, disable subsampling.
-    cinfo.comp_info[0].h_samp_factor = 1;
-    cinfo.comp_info[0].v_samp_factor = 1;
+    cinfo->comp_info[0].h_samp_factor = 1;
+    cinfo->comp_info[0].v_samp_factor = 1;
   }
 
   // all other components are set to 1x1
   for (int sfi=1; sfi< MAX_COMPONENTS; sfi++)
   {
-    cinfo.comp_info[sfi].h_samp_factor = 1;
-    cinfo.comp_info[sfi].v_samp_factor = 1;
+    cinfo->comp_info[sfi].h_samp_factor = 1;
+    cinfo->comp_info[sfi].v_samp_factor = 1;
   }
 
   JSAMPROW row_pointer[1];
-  jpeg_start_compress(&cinfo,TRUE);
+  jpeg_start_compress(cinfo,TRUE);
   int row_stride = columns * samplesPerPixel;
-  while (cinfo.next_scanline < cinfo.image_height) 
+  while (cinfo->next_scanline < cinfo->image_height) 
   {
-    row_pointer[0] = & image_buffer[cinfo.next_scanline * row_stride];
-    jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    row_pointer[0] = & image_buffer[cinfo->next_scanline * row_stride];
+    jpeg_write_scanlines(cinfo, row_pointer, 1);
   }
-  jpeg_finish_compress(&cinfo);
-  jpeg_destroy_compress(&cinfo);
+  jpeg_finish_compress(cinfo);
 
   length = OFstatic_cast(Uint32, bytesInLastBlock);
   if (pixelDataList.size() > 1) length += OFstatic_cast(Uint32, (pixelDataList.size() - 1)*IJGE8_BLOCKSIZE);
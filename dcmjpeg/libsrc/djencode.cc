@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2010, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -64,7 +64,8 @@ void DJEncoderRegistration::registerCodecs(
     OFBool pUseModalityRescale,
     OFBool pAcceptWrongPaletteTags,
     OFBool pAcrNemaCompatibility,
-    OFBool pRealLossless)
+    OFBool pRealLossless,
+    Uint32 pNumberOfThreads)
 {
   if (! registered)
   {
@@ -94,7 +95,8 @@ void DJEncoderRegistration::registerCodecs(
       pUseModalityRescale,
       pAcceptWrongPaletteTags,
       pAcrNemaCompatibility,
-      pRealLossless);
+      pRealLossless,
+      pNumberOfThreads);
     if (cp)
     {
       // baseline JPEG
@@ -0,0 +1,174 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmjpeg
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the concurrent compression and decompression
+ *           of the frames of multi-frame images
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcpxitem.h"
+#include "dcmtk/dcmjpeg/djencode.h"
+#include "dcmtk/dcmjpeg/djdecode.h"
+#include "dcmtk/dcmjpeg/djrplol.h"
+#include "dcmtk/dcmjpeg/djrploss.h"
+
+#define COLUMNS 64
+#define ROWS 48
+#define FRAMES 8
+#define FRAME_SIZE (COLUMNS * ROWS)
+#define NUM_THREADS 4
+
+
+// create a multi-frame image with different pixel values in each frame
+static void createDataset(DcmDataset &dset, Uint8 *pixelData)
+{
+    for (Uint32 i = 0; i < FRAMES; i++)
+    {
+        for (Uint32 j = 0; j < FRAME_SIZE; j++)
+            pixelData[i * FRAME_SIZE + j] = OFstatic_cast(Uint8, (j % COLUMNS) * (i + 1) + (j / COLUMNS) * 3);
+    }
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_MultiframeGrayscaleByteSecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4.5").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, 1).good());
+    OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2").good());
+    OFCHECK(dset.putAndInsertString(DCM_NumberOfFrames, "8").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, ROWS).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, COLUMNS).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 8).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, 8).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_HighBit, 7).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+    OFCHECK(dset.putAndInsertUint8Array(DCM_PixelData, pixelData, FRAMES * FRAME_SIZE).good());
+}
+
+
+// compress the given dataset using the given number of threads
+static void compress(DcmDataset &dset, E_TransferSyntax xfer, const DcmRepresentationParameter *param, Uint32 numThreads)
+{
+    DJEncoderRegistration::registerCodecs(ECC_lossyYCbCr, EUC_never, OFFalse, 0, 0, 0, OFTrue, ESS_444,
+        OFFalse, OFFalse, 0, 0, 0.0, 0.0, 0, 0, 0, 0, OFTrue, OFFalse, OFFalse, OFFalse, OFTrue, numThreads);
+    OFCHECK(dset.chooseRepresentation(xfer, param).good());
+    dset.removeAllButCurrentRepresentations();
+    OFCHECK(dset.hasRepresentation(xfer, param));
+    DJEncoderRegistration::cleanup();
+}
+
+
+// decompress the given dataset using the given number of threads and compare with the expected pixel data
+static void decompress(DcmDataset &dset, const Uint8 *expected, Uint32 numThreads)
+{
+    DJDecoderRegistration::registerCodecs(EDC_photometricInterpretation, EUC_never, EPC_default, OFFalse, numThreads);
+    // decompress a range of frames
+    DcmElement *elem = NULL;
+    OFCHECK(dset.findAndGetElement(DCM_PixelData, elem).good());
+    DcmPixelData *pixelData = OFstatic_cast(DcmPixelData *, elem);
+    if (pixelData != NULL)
+    {
+        Uint8 buffer[(FRAMES - 2) * FRAME_SIZE];
+        OFString colorModel;
+        Uint32 startFragment = 0;
+        OFCHECK(pixelData->getUncompressedFrames(&dset, 1, FRAMES - 2, startFragment, buffer, sizeof(buffer), colorModel).good());
+        OFCHECK(memcmp(buffer, expected + FRAME_SIZE, sizeof(buffer)) == 0);
+    }
+    // decompress the complete image
+    OFCHECK(dset.chooseRepresentation(EXS_LittleEndianExplicit, NULL).good());
+    const Uint8 *pixels = NULL;
+    unsigned long count = 0;
+    OFCHECK(dset.findAndGetUint8Array(DCM_PixelData, pixels, &count).good());
+    OFCHECK_EQUAL(count, FRAMES * FRAME_SIZE);
+    if ((pixels != NULL) && (count == FRAMES * FRAME_SIZE))
+        OFCHECK(memcmp(pixels, expected, count) == 0);
+    DJDecoderRegistration::cleanup();
+}
+
+
+// check whether the compressed pixel data of both datasets is identical
+static OFBool samePixelSequence(DcmDataset &dset1, DcmDataset &dset2, E_TransferSyntax xfer, const DcmRepresentationParameter *param)
+{
+    DcmElement *elem1 = NULL;
+    DcmElement *elem2 = NULL;
+    if (dset1.findAndGetElement(DCM_PixelData, elem1).bad() || dset2.findAndGetElement(DCM_PixelData, elem2).bad())
+        return OFFalse;
+    DcmPixelSequence *pixSeq1 = NULL;
+    DcmPixelSequence *pixSeq2 = NULL;
+    if (OFstatic_cast(DcmPixelData *, elem1)->getEncapsulatedRepresentation(xfer, param, pixSeq1).bad() ||
+        OFstatic_cast(DcmPixelData *, elem2)->getEncapsulatedRepresentation(xfer, param, pixSeq2).bad())
+        return OFFalse;
+    if ((pixSeq1 == NULL) || (pixSeq2 == NULL) || (pixSeq1->card() != pixSeq2->card()))
+        return OFFalse;
+    for (unsigned long i = 0; i < pixSeq1->card(); i++)
+    {
+        DcmPixelItem *item1 = NULL;
+        DcmPixelItem *item2 = NULL;
+        Uint8 *data1 = NULL;
+        Uint8 *data2 = NULL;
+        if (pixSeq1->getItem(item1, i).bad() || pixSeq2->getItem(item2, i).bad())
+            return OFFalse;
+        if (item1->getLength() != item2->getLength())
+            return OFFalse;
+        if (item1->getLength() > 0)
+        {
+            if (item1->getUint8Array(data1).bad() || item2->getUint8Array(data2).bad())
+                return OFFalse;
+            if (memcmp(data1, data2, item1->getLength()) != 0)
+                return OFFalse;
+        }
+    }
+    return OFTrue;
+}
+
+
+OFTEST(dcmjpeg_multiThreadedFrames)
+{
+    Uint8 original[FRAMES * FRAME_SIZE];
+    DcmDataset dset1;
+    createDataset(dset1, original);
+    DcmDataset dsetN(dset1);
+    // true lossless compression with one and with multiple threads
+    DJ_RPLossless param;
+    compress(dset1, EXS_JPEGProcess14SV1, &param, 1);
+    compress(dsetN, EXS_JPEGProcess14SV1, &param, NUM_THREADS);
+    OFCHECK(samePixelSequence(dset1, dsetN, EXS_JPEGProcess14SV1, &param));
+    // decompression with one and with multiple threads
+    decompress(dset1, original, 1);
+    decompress(dsetN, original, NUM_THREADS);
+
+    // lossy compression of the rendered frames with one and with multiple threads
+    DcmDataset lossy1;
+    createDataset(lossy1, original);
+    DcmDataset lossyN(lossy1);
+    DJ_RPLossy lossyParam(90);
+    compress(lossy1, EXS_JPEGProcess1, &lossyParam, 1);
+    compress(lossyN, EXS_JPEGProcess1, &lossyParam, NUM_THREADS);
+    OFCHECK(samePixelSequence(lossy1, lossyN, EXS_JPEGProcess1, &lossyParam));
+    // decompression with multiple threads gives the same result as with one thread
+    DcmDataset decompressed(lossy1);
+    DJDecoderRegistration::registerCodecs();
+    OFCHECK(decompressed.chooseRepresentation(EXS_LittleEndianExplicit, NULL).good());
+    DJDecoderRegistration::cleanup();
+    const Uint8 *pixels = NULL;
+    unsigned long count = 0;
+    OFCHECK(decompressed.findAndGetUint8Array(DCM_PixelData, pixels, &count).good());
+    OFCHECK_EQUAL(count, FRAMES * FRAME_SIZE);
+    if ((pixels != NULL) && (count == FRAMES * FRAME_SIZE))
+        decompress(lossyN, pixels, NUM_THREADS);
+}
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2007-2014, OFFIS e.V.
+ *  Copyright (C) 2007-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -86,6 +86,7 @@ int main(int argc, char *argv[])
   JLS_UIDCreation opt_uidcreation = EJLSUC_default;
   JLS_PlanarConfiguration opt_planarconfig = EJLSPC_restore;
   OFBool opt_ignoreOffsetTable = OFFalse;
+  OFCmdUnsignedInt opt_threads = 1;
 
 #ifdef USE_LICENSE_FILE
 LICENSE_FILE_DECLARATIONS
@@ -125,6 +126,10 @@ LICENSE_FILE_DECLARE_COMMAND_LINE_OPTIONS
       cmd.addOption("--uid-always",             "+ua",    "always assign new UID");
     cmd.addSubGroup("other processing options:");
       cmd.addOption("--ignore-offsettable",     "+io",    "ignore offset table when decompressing");
+#ifdef WITH_THREADS
+      cmd.addOption("--threads",                "+mt", 1, "[n]umber: integer (1..256, default: 1)",
+                                                          "decompress up to n frames concurrently");
+#endif
 
   cmd.addGroup("output options:");
     cmd.addSubGroup("output file format:");
@@ -195,6 +200,12 @@ LICENSE_FILE_EVALUATE_COMMAND_LINE_OPTIONS
       cmd.endOptionBlock();
 
       if (cmd.findOption("--ignore-offsettable")) opt_ignoreOffsetTable = OFTrue;
+#ifdef WITH_THREADS
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValueAndCheckMinMax(opt_threads, OFstatic_cast(OFCmdUnsignedInt, 1), OFstatic_cast(OFCmdUnsignedInt, 256)));
+      }
+#endif
 
       cmd.beginOptionBlock();
       if (cmd.findOption("--read-file"))
@@ -265,7 +276,8 @@ LICENSE_FILE_EVALUATE_COMMAND_LINE_OPTIONS
     OFLOG_DEBUG(dcmdjplsLogger, rcsid << OFendl);
 
     // register global decompression codecs
-    DJLSDecoderRegistration::registerCodecs(opt_uidcreation, opt_planarconfig, opt_ignoreOffsetTable);
+    DJLSDecoderRegistration::registerCodecs(opt_uidcreation, opt_planarconfig, opt_ignoreOffsetTable,
+      OFstatic_cast(Uint32, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
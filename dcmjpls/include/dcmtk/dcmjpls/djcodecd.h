@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2007-2011, OFFIS e.V.
+ *  Copyright (C) 2007-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -99,6 +99,41 @@ public:
     Uint32 bufSize,
     OFString& decompressedColorModel) const;
 
+  /** decompresses a range of consecutive frames from the given pixel sequence
+   *  and stores the result in the given buffer. If the codec parameters permit
+   *  more than one thread, the frames are decompressed concurrently.
+   *  @param fromParam representation parameter of current compressed
+   *    representation, may be NULL.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to dataset in which pixel data element is contained
+   *  @param firstFrame number of the first frame, starting with 0 for the first frame
+   *  @param numberOfFrames number of frames to be decompressed
+   *  @param startFragment index of the compressed fragment that contains
+   *    all or the first part of the compressed bitstream for the given firstFrame.
+   *    Upon successful return this parameter is updated to contain the index
+   *    of the first compressed fragment of the frame following the given range.
+   *    When unknown, zero should be passed.
+   *  @param buffer pointer to buffer where the frames are to be stored, frame i
+   *    of the range at offset i * frameBufSize
+   *  @param frameBufSize size of the buffer for a single frame in bytes
+   *  @param decompressedColorModel upon successful return, the color model
+   *    of the decompressed image (which may be different from the one used
+   *    in the compressed images) is returned in this parameter.
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrames(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    void *buffer,
+    Uint32 frameBufSize,
+    OFString& decompressedColorModel) const;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -218,6 +253,95 @@ private:
     Uint16 imageSamplesPerPixel,
     Uint16 bytesPerSample);
 
+  /** decompresses the given frames using multiple threads. The compressed
+   *  bitstreams of all frames are read from the pixel sequence in advance.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to dataset in which pixel data element is contained
+   *  @param firstFrame number of the first frame, starting with 0 for the first frame
+   *  @param numberOfFrames number of frames to be decompressed
+   *  @param startFragment index of the first fragment of the first frame, updated
+   *    to contain the index of the first fragment of the frame following the range
+   *  @param buffer pointer to buffer for the first frame
+   *  @param frameBufSize offset between two frames in the buffer, in bytes
+   *  @param imageFrames number of frames in this image
+   *  @param imageColumns number of columns for each frame
+   *  @param imageRows number of rows for each frame
+   *  @param imageSamplesPerPixel number of samples per pixel
+   *  @param bytesPerSample number of bytes per sample
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition decodeFramesConcurrently(
+    DcmPixelSequence * fromPixSeq,
+    const DJLSCodecParameter *cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    Uint8 *buffer,
+    Uint32 frameBufSize,
+    Sint32 imageFrames,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 bytesPerSample);
+
+  /** copies the compressed bitstream of a single frame from the given pixel sequence
+   *  into a newly allocated buffer.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param frameNo number of frame, starting with 0 for the first frame
+   *  @param startFragment index of the first fragment of the frame, updated to
+   *    contain the index of the first fragment of the next frame
+   *  @param imageFrames number of frames in this image
+   *  @param jlsData compressed bitstream returned in this parameter upon success,
+   *    must be deleted by the caller
+   *  @param compressedSize size of the compressed bitstream returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition readCompressedFrame(
+    DcmPixelSequence * fromPixSeq,
+    const DJLSCodecParameter *cp,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    Sint32 imageFrames,
+    Uint8 *&jlsData,
+    size_t& compressedSize);
+
+  /** converts the planar configuration and byte order of a decompressed frame
+   *  if necessary.
+   *  @param buffer pointer to decompressed frame
+   *  @param bufSize size of buffer in bytes
+   *  @param imageColumns number of columns for each frame
+   *  @param imageRows number of rows for each frame
+   *  @param imageSamplesPerPixel number of samples per pixel
+   *  @param bytesPerSample number of bytes per sample
+   *  @param imagePlanarConfiguration desired planar configuration of the frame
+   *  @param interleaveMode interleave mode of the JPEG-LS bitstream
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition postProcessFrame(
+    void *buffer,
+    Uint32 bufSize,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 bytesPerSample,
+    Uint16 imagePlanarConfiguration,
+    int interleaveMode);
+
+  /** determines the planar configuration of decompressed color images
+   *  depending on the codec parameters and the given dataset.
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to dataset in which pixel data element is contained
+   *  @param imageSamplesPerPixel number of samples per pixel
+   *  @return planar configuration (0 = color-by-pixel, 1 = color-by-plane)
+   */
+  static Uint16 determinePlanarConfiguration(
+    const DJLSCodecParameter *cp,
+    DcmItem *dataset,
+    Uint16 imageSamplesPerPixel);
+
   /** determines if a given image requires color-by-plane planar configuration
    *  depending on SOP Class UID (DICOM IOD) and photometric interpretation.
    *  All SOP classes defined in the 2003 edition of the DICOM standard or earlier
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2011, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -83,11 +83,14 @@ public:
    *  @param uidCreation               mode for SOP Instance UID creation (used both for encoding and decoding)
    *  @param planarConfiguration       flag describing how planar configuration of decompressed color images should be handled
    *  @param ignoreOffsetTable         flag indicating whether to ignore the offset table when decompressing multiframe images
+   *  @param numberOfThreads           maximum number of threads used for decompressing multiframe images,
+   *                                   1 for decompressing the frames sequentially
    */
   DJLSCodecParameter(
     JLS_UIDCreation uidCreation = EJLSUC_default,
     JLS_PlanarConfiguration planarConfiguration = EJLSPC_restore,
-    OFBool ignoreOffsetTable = OFFalse);
+    OFBool ignoreOffsetTable = OFFalse,
+    Uint32 numberOfThreads = 1);
 
   /// copy constructor
   DJLSCodecParameter(const DJLSCodecParameter& arg);
@@ -211,6 +214,14 @@ public:
     return ignoreOffsetTable_;
   }
 
+  /** returns the maximum number of threads used for decompressing multiframe images
+   *  @return maximum number of threads, 1 if the frames are decompressed sequentially
+   */
+  Uint32 getNumberOfThreads() const
+  {
+    return numberOfThreads_;
+  }
+
   /** returns the interleave mode which the encoder should use
    *  @return the interleave mode which the encoder should use
    */
@@ -272,6 +283,9 @@ private:
   /// flag indicating if temporary files should be kept, false if they should be deleted after use
   OFBool ignoreOffsetTable_;
 
+  /// maximum number of threads used for decompressing multiframe images
+  Uint32 numberOfThreads_;
+
 };
 
 
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2007-2011, OFFIS e.V.
+ *  Copyright (C) 2007-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -26,6 +26,8 @@
 #include "dcmtk/ofstd/ofcast.h"      /* for casts */
 #include "dcmtk/ofstd/offile.h"      /* for class OFFile */
 #include "dcmtk/ofstd/ofstd.h"       /* for class OFStandard */
+#include "dcmtk/ofstd/oflist.h"      /* for class OFList */
+#include "dcmtk/ofstd/ofthread.h"    /* for class OFThread */
 #include "dcmtk/dcmdata/dcdatset.h"  /* for class DcmDataset */
 #include "dcmtk/dcmdata/dcdeftag.h"  /* for tag constants */
 #include "dcmtk/dcmdata/dcpixseq.h"  /* for class DcmPixelSequence */
@@ -158,6 +160,16 @@ OFCondition DJLSDecoderBase::decode(
   Uint32 currentItem = 1; // item 0 contains the offset table
   OFBool done = OFFalse;
 
+#ifdef WITH_THREADS
+  if ((imageFrames > 1) && (djcp->getNumberOfThreads() > 1))
+  {
+    // decompress all frames concurrently
+    result = decodeFramesConcurrently(pixSeq, djcp, dataset, 0, OFstatic_cast(Uint32, imageFrames), currentItem, pixeldata8, frameSize,
+        imageFrames, imageColumns, imageRows, imageSamplesPerPixel, bytesPerSample);
+    done = OFTrue;
+  }
+#endif
+
   while (result.good() && !done)
   {
       DCMJPLS_DEBUG("JPEG-LS decoder processes frame " << (currentFrame+1));
@@ -199,7 +211,7 @@ OFCondition DJLSDecoderBase::decode(
 
 
 OFCondition DJLSDecoderBase::decodeFrame(
-    const DcmRepresentationParameter * /* fromParam */,
+    const DcmRepresentationParameter *fromParam,
     DcmPixelSequence *fromPixSeq,
     const DcmCodecParameter *cp,
     DcmItem *dataset,
@@ -208,8 +220,25 @@ OFCondition DJLSDecoderBase::decodeFrame(
     void * buffer,
     Uint32 bufSize,
     OFString& decompressedColorModel) const
+{
+  return decodeFrames(fromParam, fromPixSeq, cp, dataset, frameNo, 1, currentItem, buffer, bufSize, decompressedColorModel);
+}
+
+
+OFCondition DJLSDecoderBase::decodeFrames(
+    const DcmRepresentationParameter * /* fromParam */,
+    DcmPixelSequence *fromPixSeq,
+    const DcmCodecParameter *cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& currentItem,
+    void * buffer,
+    Uint32 frameBufSize,
+    OFString& decompressedColorModel) const
 {
   OFCondition result = EC_Normal;
+  if ((buffer == NULL) || (numberOfFrames == 0)) return EC_IllegalCall;
 
   // assume we can cast the codec parameter to what we need
   const DJLSCodecParameter *djcp = OFreinterpret_cast(const DJLSCodecParameter *, cp);
@@ -255,15 +284,30 @@ OFCondition DJLSDecoderBase::decodeFrame(
   // If the user has passed a zero, try to find out ourselves.
   if (currentItem == 0)
   {
-    result = determineStartFragment(frameNo, imageFrames, fromPixSeq, currentItem);
+    result = determineStartFragment(firstFrame, imageFrames, fromPixSeq, currentItem);
   }
 
   if (result.good())
   {
     // We got all the data we need from the dataset, let's start decoding
-    DCMJPLS_DEBUG("Starting to decode frame " << frameNo << " with fragment " << currentItem);
-    result = decodeFrame(fromPixSeq, djcp, dataset, frameNo, currentItem, buffer, bufSize,
-        imageFrames, imageColumns, imageRows, imageSamplesPerPixel, bytesPerSample);
+    DCMJPLS_DEBUG("Starting to decode frame " << firstFrame << " with fragment " << currentItem);
+#ifdef WITH_THREADS
+    if ((numberOfFrames > 1) && (djcp->getNumberOfThreads() > 1))
+    {
+      result = decodeFramesConcurrently(fromPixSeq, djcp, dataset, firstFrame, numberOfFrames, currentItem,
+        OFstatic_cast(Uint8 *, buffer), frameBufSize, imageFrames, imageColumns, imageRows, imageSamplesPerPixel, bytesPerSample);
+    }
+    else
+#endif
+    {
+      Uint8 *frameBuffer = OFstatic_cast(Uint8 *, buffer);
+      for (Uint32 i = 0; (i < numberOfFrames) && result.good(); i++)
+      {
+        result = decodeFrame(fromPixSeq, djcp, dataset, firstFrame + i, currentItem, frameBuffer, frameBufSize,
+          imageFrames, imageColumns, imageRows, imageSamplesPerPixel, bytesPerSample);
+        frameBuffer += frameBufSize;
+      }
+    }
   }
 
   if (result.good())
@@ -275,6 +319,315 @@ OFCondition DJLSDecoderBase::decodeFrame(
   return result;
 }
 
+
+/** decompresses a single JPEG-LS bitstream after checking that it matches the image attributes.
+ *  This function does not access any shared data and may, therefore, be called by multiple threads.
+ *  @param jlsData compressed bitstream
+ *  @param compressedSize size of the compressed bitstream
+ *  @param buffer pointer to buffer where frame is to be stored
+ *  @param bufSize size of buffer in bytes
+ *  @param imageColumns number of columns for each frame
+ *  @param imageRows number of rows for each frame
+ *  @param imageSamplesPerPixel number of samples per pixel
+ *  @param bytesPerSample number of bytes per sample
+ *  @param interleaveMode interleave mode of the bitstream returned in this parameter
+ *  @return EC_Normal if successful, an error code otherwise.
+ */
+static OFCondition decodeJPEGLSBitstream(
+    Uint8 *jlsData,
+    size_t compressedSize,
+    void *buffer,
+    Uint32 bufSize,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 bytesPerSample,
+    int& interleaveMode)
+{
+  JlsParameters params;
+  JLS_ERROR err;
+
+  err = JpegLsReadHeader(jlsData, compressedSize, &params);
+  OFCondition result = DJLSError::convert(err);
+
+  if (result.good())
+  {
+    if (params.width != imageColumns) result = EC_JLSImageDataMismatch;
+    else if (params.height != imageRows) result = EC_JLSImageDataMismatch;
+    else if (params.components != imageSamplesPerPixel) result = EC_JLSImageDataMismatch;
+    else if ((bytesPerSample == 1) && (params.bitspersample > 8)) result = EC_JLSImageDataMismatch;
+    else if ((bytesPerSample == 2) && (params.bitspersample <= 8)) result = EC_JLSImageDataMismatch;
+  }
+
+  if (result.good())
+  {
+    err = JpegLsDecode(buffer, bufSize, jlsData, compressedSize, &params);
+    result = DJLSError::convert(err);
+    interleaveMode = params.ilv;
+  }
+  return result;
+}
+
+
+/** helper class for the concurrent decompression of frames. Each thread
+ *  fetches the next frame that has not yet been taken and decompresses it.
+ */
+class DJLSFrameDecoderJob
+{
+public:
+
+  /** constructor
+   *  @param numFrames number of frames to be decompressed
+   *  @param buffer buffer for the first frame
+   *  @param frameBufSize offset between two frames in the buffer
+   *  @param columns columns of a frame
+   *  @param rows rows of a frame
+   *  @param samplesPerPixel samples per pixel of a frame
+   *  @param bytesPerSample bytes per sample of a frame
+   */
+  DJLSFrameDecoderJob(size_t numFrames, Uint8 *buffer, Uint32 frameBufSize,
+    Uint16 columns, Uint16 rows, Uint16 samplesPerPixel, Uint16 bytesPerSample)
+  : numFrames_(numFrames)
+  , buffer_(buffer)
+  , frameBufSize_(frameBufSize)
+  , columns_(columns)
+  , rows_(rows)
+  , samplesPerPixel_(samplesPerPixel)
+  , bytesPerSample_(bytesPerSample)
+  , jlsData_(new Uint8 *[numFrames])
+  , jlsSize_(new size_t[numFrames])
+  , interleaveModes_(new int[numFrames])
+  , results_(new OFCondition[numFrames])
+  , nextFrame_(0)
+  , mutex_()
+  {
+    for (size_t i = 0; i < numFrames; i++)
+    {
+      jlsData_[i] = NULL;
+      jlsSize_[i] = 0;
+      interleaveModes_[i] = 0;
+    }
+  }
+
+  /// destructor, also deletes the compressed bitstreams
+  ~DJLSFrameDecoderJob()
+  {
+    for (size_t i = 0; i < numFrames_; i++)
+      delete[] jlsData_[i];
+    delete[] jlsData_;
+    delete[] jlsSize_;
+    delete[] interleaveModes_;
+    delete[] results_;
+  }
+
+  /** decompresses frames until all frames are processed.
+   *  May be called by multiple threads concurrently.
+   */
+  void decodeFrames()
+  {
+    size_t i;
+    while ((i = fetchFrame()) < numFrames_)
+    {
+      results_[i] = decodeJPEGLSBitstream(jlsData_[i], jlsSize_[i], buffer_ + i * frameBufSize_, frameBufSize_,
+        columns_, rows_, samplesPerPixel_, bytesPerSample_, interleaveModes_[i]);
+      // the compressed bitstream is not needed any longer
+      delete[] jlsData_[i];
+      jlsData_[i] = NULL;
+    }
+  }
+
+  /// array of compressed bitstreams (allocated by the caller, deleted by this job)
+  Uint8 **jlsData() { return jlsData_; }
+
+  /// array of the size of the compressed bitstreams
+  size_t *jlsSize() { return jlsSize_; }
+
+  /// array of the interleave modes of the decompressed frames
+  const int *interleaveModes() const { return interleaveModes_; }
+
+  /// array of the decompression results for the frames
+  const OFCondition *results() const { return results_; }
+
+private:
+
+  /// private undefined copy constructor
+  DJLSFrameDecoderJob(const DJLSFrameDecoderJob&);
+
+  /// private undefined copy assignment operator
+  DJLSFrameDecoderJob& operator=(const DJLSFrameDecoderJob&);
+
+  /** returns the index of the next frame to be decompressed (and marks it as taken)
+   *  @return index of the next frame, numFrames_ if all frames have been taken
+   */
+  size_t fetchFrame()
+  {
+    mutex_.lock();
+    const size_t i = (nextFrame_ < numFrames_) ? nextFrame_++ : numFrames_;
+    mutex_.unlock();
+    return i;
+  }
+
+  /// number of frames
+  size_t numFrames_;
+
+  /// buffer for the uncompressed frames
+  Uint8 *buffer_;
+
+  /// offset between two frames in the buffer
+  Uint32 frameBufSize_;
+
+  /// columns of a frame
+  Uint16 columns_;
+
+  /// rows of a frame
+  Uint16 rows_;
+
+  /// samples per pixel of a frame
+  Uint16 samplesPerPixel_;
+
+  /// bytes per sample of a frame
+  Uint16 bytesPerSample_;
+
+  /// compressed bitstreams
+  Uint8 **jlsData_;
+
+  /// size of the compressed bitstreams
+  size_t *jlsSize_;
+
+  /// interleave modes of the decompressed frames
+  int *interleaveModes_;
+
+  /// decompression results
+  OFCondition *results_;
+
+  /// index of the next frame to be decompressed
+  size_t nextFrame_;
+
+  /// mutex protecting nextFrame_
+  OFMutex mutex_;
+};
+
+
+#ifdef WITH_THREADS
+
+/** worker thread decompressing frames of a DJLSFrameDecoderJob
+ */
+class DJLSFrameDecoderThread : public OFThread
+{
+public:
+
+  /** constructor
+   *  @param job job from which the frames are fetched
+   */
+  DJLSFrameDecoderThread(DJLSFrameDecoderJob &job)
+  : OFThread()
+  , job_(job)
+  {
+  }
+
+  /// destructor
+  virtual ~DJLSFrameDecoderThread()
+  {
+  }
+
+protected:
+
+  /// decompresses frames until all frames of the job are processed
+  virtual void run()
+  {
+    job_.decodeFrames();
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DJLSFrameDecoderThread(const DJLSFrameDecoderThread&);
+
+  /// private undefined copy assignment operator
+  DJLSFrameDecoderThread& operator=(const DJLSFrameDecoderThread&);
+
+  /// job from which the frames are fetched
+  DJLSFrameDecoderJob &job_;
+};
+
+#endif
+
+
+OFCondition DJLSDecoderBase::decodeFramesConcurrently(
+    DcmPixelSequence * fromPixSeq,
+    const DJLSCodecParameter *cp,
+    DcmItem *dataset,
+    Uint32 firstFrame,
+    Uint32 numberOfFrames,
+    Uint32& startFragment,
+    Uint8 *buffer,
+    Uint32 frameBufSize,
+    Sint32 imageFrames,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 bytesPerSample)
+{
+  OFCondition result = EC_Normal;
+  Uint16 imagePlanarConfiguration = determinePlanarConfiguration(cp, dataset, imageSamplesPerPixel);
+  DJLSFrameDecoderJob job(numberOfFrames, buffer, frameBufSize, imageColumns, imageRows, imageSamplesPerPixel, bytesPerSample);
+
+  // read the compressed bitstreams of all frames, since the pixel sequence must not be accessed by multiple threads
+  Uint8 **jlsData = job.jlsData();
+  size_t *jlsSize = job.jlsSize();
+  for (Uint32 i = 0; (i < numberOfFrames) && result.good(); i++)
+  {
+    result = readCompressedFrame(fromPixSeq, cp, firstFrame + i, startFragment, imageFrames, jlsData[i], jlsSize[i]);
+  }
+
+  if (result.good())
+  {
+    DCMJPLS_DEBUG("JPEG-LS decoder: decompressing " << numberOfFrames << " frames using up to "
+      << cp->getNumberOfThreads() << " threads");
+
+    // decompress the frames, using additional threads if possible
+#ifdef WITH_THREADS
+    OFList<DJLSFrameDecoderThread *> threads;
+    for (Uint32 i = 1; (i < cp->getNumberOfThreads()) && (i < numberOfFrames); i++)
+    {
+      DJLSFrameDecoderThread *thread = new DJLSFrameDecoderThread(job);
+      if (thread->start() != 0)
+      {
+        // the remaining frames are decompressed by the other threads
+        delete thread;
+        break;
+      }
+      threads.push_back(thread);
+    }
+#endif
+    job.decodeFrames();
+#ifdef WITH_THREADS
+    while (!threads.empty())
+    {
+      threads.front()->join();
+      delete threads.front();
+      threads.pop_front();
+    }
+#endif
+
+    // check the results and convert planar configuration and byte order if necessary
+    const OFCondition *results = job.results();
+    const int *interleaveModes = job.interleaveModes();
+    for (Uint32 i = 0; (i < numberOfFrames) && result.good(); i++)
+    {
+      result = results[i];
+      if (result.good())
+      {
+        result = postProcessFrame(buffer + i * frameBufSize, frameBufSize, imageColumns, imageRows,
+          imageSamplesPerPixel, bytesPerSample, imagePlanarConfiguration, interleaveModes[i]);
+      }
+    }
+  }
+
+  return result;
+}
+
+
 OFCondition DJLSDecoderBase::decodeFrame(
     DcmPixelSequence * fromPixSeq,
     const DJLSCodecParameter *cp,
@@ -289,50 +642,55 @@ OFCondition DJLSDecoderBase::decodeFrame(
     Uint16 imageSamplesPerPixel,
     Uint16 bytesPerSample)
 {
-  DcmPixelItem *pixItem = NULL;
   Uint8 * jlsData = NULL;
+  size_t compressedSize = 0;
+  int interleaveMode = 0;
+
+  // determine planar configuration for uncompressed data
+  Uint16 imagePlanarConfiguration = determinePlanarConfiguration(cp, dataset, imageSamplesPerPixel);
+
+  // get the compressed data
+  OFCondition result = readCompressedFrame(fromPixSeq, cp, frameNo, currentItem, imageFrames, jlsData, compressedSize);
+
+  if (result.good())
+  {
+    result = decodeJPEGLSBitstream(jlsData, compressedSize, buffer, bufSize, imageColumns, imageRows,
+      imageSamplesPerPixel, bytesPerSample, interleaveMode);
+    delete[] jlsData;
+  }
+
+  if (result.good())
+  {
+    result = postProcessFrame(buffer, bufSize, imageColumns, imageRows, imageSamplesPerPixel,
+      bytesPerSample, imagePlanarConfiguration, interleaveMode);
+  }
+
+  return result;
+}
+
+
+OFCondition DJLSDecoderBase::readCompressedFrame(
+    DcmPixelSequence * fromPixSeq,
+    const DJLSCodecParameter *cp,
+    Uint32 frameNo,
+    Uint32& currentItem,
+    Sint32 imageFrames,
+    Uint8 *&jlsData,
+    size_t& compressedSize)
+{
+  DcmPixelItem *pixItem = NULL;
   Uint8 * jlsFragmentData = NULL;
   Uint32 fragmentLength = 0;
-  size_t compressedSize = 0;
   Uint32 fragmentsForThisFrame = 0;
   OFCondition result = EC_Normal;
   OFBool ignoreOffsetTable = cp->ignoreOffsetTable();
+  jlsData = NULL;
+  compressedSize = 0;
 
   // compute the number of JPEG-LS fragments we need in order to decode the next frame
   fragmentsForThisFrame = computeNumberOfFragments(imageFrames, frameNo, currentItem, ignoreOffsetTable, fromPixSeq);
   if (fragmentsForThisFrame == 0) result = EC_JLSCannotComputeNumberOfFragments;
 
-  // determine planar configuration for uncompressed data
-  OFString imageSopClass;
-  OFString imagePhotometricInterpretation;
-  dataset->findAndGetOFString(DCM_SOPClassUID, imageSopClass);
-  dataset->findAndGetOFString(DCM_PhotometricInterpretation, imagePhotometricInterpretation);
-  Uint16 imagePlanarConfiguration = 0; // 0 is color-by-pixel, 1 is color-by-plane
-
-  if (imageSamplesPerPixel > 1)
-  {
-    switch (cp->getPlanarConfiguration())
-    {
-      case EJLSPC_restore:
-        // get planar configuration from dataset
-        imagePlanarConfiguration = 2; // invalid value
-        dataset->findAndGetUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
-        // determine auto default if not found or invalid
-        if (imagePlanarConfiguration > 1)
-          imagePlanarConfiguration = determinePlanarConfiguration(imageSopClass, imagePhotometricInterpretation);
-        break;
-      case EJLSPC_auto:
-        imagePlanarConfiguration = determinePlanarConfiguration(imageSopClass, imagePhotometricInterpretation);
-        break;
-      case EJLSPC_colorByPixel:
-        imagePlanarConfiguration = 0;
-        break;
-      case EJLSPC_colorByPlane:
-        imagePlanarConfiguration = 1;
-        break;
-    }
-  }
-
   // get the size of all the fragments
   if (result.good())
   {
@@ -372,75 +730,106 @@ OFCondition DJLSDecoderBase::decodeFrame(
         }
       }
     } /* while */
+
+    if (result.bad())
+    {
+      delete[] jlsData;
+      jlsData = NULL;
+    }
   }
 
-  if (result.good())
-  {
-    JlsParameters params;
-    JLS_ERROR err;
+  return result;
+}
 
-    err = JpegLsReadHeader(jlsData, compressedSize, &params);
-    result = DJLSError::convert(err);
 
-    if (result.good())
-    {
-      if (params.width != imageColumns) result = EC_JLSImageDataMismatch;
-      else if (params.height != imageRows) result = EC_JLSImageDataMismatch;
-      else if (params.components != imageSamplesPerPixel) result = EC_JLSImageDataMismatch;
-      else if ((bytesPerSample == 1) && (params.bitspersample > 8)) result = EC_JLSImageDataMismatch;
-      else if ((bytesPerSample == 2) && (params.bitspersample <= 8)) result = EC_JLSImageDataMismatch;
-    }
+OFCondition DJLSDecoderBase::postProcessFrame(
+    void *buffer,
+    Uint32 bufSize,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 bytesPerSample,
+    Uint16 imagePlanarConfiguration,
+    int interleaveMode)
+{
+  OFCondition result = EC_Normal;
 
-    if (!result.good())
+  if (imageSamplesPerPixel == 3)
+  {
+    if (imagePlanarConfiguration == 1 && interleaveMode != ILV_NONE)
     {
-      delete[] jlsData;
+      // The dataset says this should be planarConfiguration == 1, but
+      // it isn't -> convert it.
+      DCMJPLS_WARN("different planar configuration in JPEG stream, converting to \"1\"");
+      if (bytesPerSample == 1)
+        result = createPlanarConfiguration1Byte(OFreinterpret_cast(Uint8*, buffer), imageColumns, imageRows);
+      else
+        result = createPlanarConfiguration1Word(OFreinterpret_cast(Uint16*, buffer), imageColumns, imageRows);
     }
-    else
+    else if (imagePlanarConfiguration == 0 && interleaveMode != ILV_SAMPLE && interleaveMode != ILV_LINE)
     {
-      err = JpegLsDecode(buffer, bufSize, jlsData, compressedSize, &params);
-      result = DJLSError::convert(err);
-      delete[] jlsData;
-
-      if (result.good() && imageSamplesPerPixel == 3)
-      {
-        if (imagePlanarConfiguration == 1 && params.ilv != ILV_NONE)
-        {
-          // The dataset says this should be planarConfiguration == 1, but
-          // it isn't -> convert it.
-          DCMJPLS_WARN("different planar configuration in JPEG stream, converting to \"1\"");
-          if (bytesPerSample == 1)
-            result = createPlanarConfiguration1Byte(OFreinterpret_cast(Uint8*, buffer), imageColumns, imageRows);
-          else
-            result = createPlanarConfiguration1Word(OFreinterpret_cast(Uint16*, buffer), imageColumns, imageRows);
-        }
-        else if (imagePlanarConfiguration == 0 && params.ilv != ILV_SAMPLE && params.ilv != ILV_LINE)
-        {
-          // The dataset says this should be planarConfiguration == 0, but
-          // it isn't -> convert it.
-          DCMJPLS_WARN("different planar configuration in JPEG stream, converting to \"0\"");
-          if (bytesPerSample == 1)
-            result = createPlanarConfiguration0Byte(OFreinterpret_cast(Uint8*, buffer), imageColumns, imageRows);
-          else
-            result = createPlanarConfiguration0Word(OFreinterpret_cast(Uint16*, buffer), imageColumns, imageRows);
-        }
-      }
+      // The dataset says this should be planarConfiguration == 0, but
+      // it isn't -> convert it.
+      DCMJPLS_WARN("different planar configuration in JPEG stream, converting to \"0\"");
+      if (bytesPerSample == 1)
+        result = createPlanarConfiguration0Byte(OFreinterpret_cast(Uint8*, buffer), imageColumns, imageRows);
+      else
+        result = createPlanarConfiguration0Word(OFreinterpret_cast(Uint16*, buffer), imageColumns, imageRows);
+    }
+  }
 
-      if (result.good())
+  if (result.good())
+  {
+      // decompression is complete, finally adjust byte order if necessary
+      if (bytesPerSample == 1) // we're writing bytes into words
       {
-          // decompression is complete, finally adjust byte order if necessary
-          if (bytesPerSample == 1) // we're writing bytes into words
-          {
-              result = swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, buffer,
-                      bufSize, sizeof(Uint16));
-          }
+          result = swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, buffer,
+                  bufSize, sizeof(Uint16));
       }
-    }
   }
 
   return result;
 }
 
 
+Uint16 DJLSDecoderBase::determinePlanarConfiguration(
+    const DJLSCodecParameter *cp,
+    DcmItem *dataset,
+    Uint16 imageSamplesPerPixel)
+{
+  OFString imageSopClass;
+  OFString imagePhotometricInterpretation;
+  dataset->findAndGetOFString(DCM_SOPClassUID, imageSopClass);
+  dataset->findAndGetOFString(DCM_PhotometricInterpretation, imagePhotometricInterpretation);
+  Uint16 imagePlanarConfiguration = 0; // 0 is color-by-pixel, 1 is color-by-plane
+
+  if (imageSamplesPerPixel > 1)
+  {
+    switch (cp->getPlanarConfiguration())
+    {
+      case EJLSPC_restore:
+        // get planar configuration from dataset
+        imagePlanarConfiguration = 2; // invalid value
+        dataset->findAndGetUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
+        // determine auto default if not found or invalid
+        if (imagePlanarConfiguration > 1)
+          imagePlanarConfiguration = determinePlanarConfiguration(imageSopClass, imagePhotometricInterpretation);
+        break;
+      case EJLSPC_auto:
+        imagePlanarConfiguration = determinePlanarConfiguration(imageSopClass, imagePhotometricInterpretation);
+        break;
+      case EJLSPC_colorByPixel:
+        imagePlanarConfiguration = 0;
+        break;
+      case EJLSPC_colorByPlane:
+        imagePlanarConfiguration = 1;
+        break;
+    }
+  }
+  return imagePlanarConfiguration;
+}
+
+
 OFCondition DJLSDecoderBase::encode(
     const Uint16 * /* pixelData */,
     const Uint32 /* length */,
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2011, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -53,6 +53,7 @@ DJLSCodecParameter::DJLSCodecParameter(
 , jplsInterleaveMode_(jplsInterleaveMode)
 , planarConfiguration_(planarConfiguration)
 , ignoreOffsetTable_(ignoreOffsetTble)
+, numberOfThreads_(1)
 {
 }
 
@@ -60,7 +61,8 @@ DJLSCodecParameter::DJLSCodecParameter(
 DJLSCodecParameter::DJLSCodecParameter(
     JLS_UIDCreation uidCreation,
     JLS_PlanarConfiguration planarConfiguration,
-    OFBool ignoreOffsetTble)
+    OFBool ignoreOffsetTble,
+    Uint32 numberOfThreads)
 : DcmCodecParameter()
 , jpls_optionsEnabled_(OFFalse)
 , jpls_t1_(3)
@@ -76,6 +78,7 @@ DJLSCodecParameter::DJLSCodecParameter(
 , jplsInterleaveMode_(interleaveDefault)
 , planarConfiguration_(planarConfiguration)
 , ignoreOffsetTable_(ignoreOffsetTble)
+, numberOfThreads_(numberOfThreads)
 {
 }
 
@@ -96,6 +99,7 @@ DJLSCodecParameter::DJLSCodecParameter(const DJLSCodecParameter& arg)
 , jplsInterleaveMode_(arg.jplsInterleaveMode_)
 , planarConfiguration_(arg.planarConfiguration_)
 , ignoreOffsetTable_(arg.ignoreOffsetTable_)
+, numberOfThreads_(arg.numberOfThreads_)
 {
 }
 
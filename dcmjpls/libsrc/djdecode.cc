@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1997-2011, OFFIS e.V.
+ *  Copyright (C) 1997-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -34,11 +34,12 @@ DJLSNearLosslessDecoder *DJLSDecoderRegistration::nearlosslessdecoder_ = NULL;
 void DJLSDecoderRegistration::registerCodecs(
     JLS_UIDCreation uidcreation,
     JLS_PlanarConfiguration planarconfig,
-    OFBool ignoreOffsetTable)
+    OFBool ignoreOffsetTable,
+    Uint32 numberOfThreads)
 {
   if (! registered_)
   {
-    cp_ = new DJLSCodecParameter(uidcreation, planarconfig, ignoreOffsetTable);
+    cp_ = new DJLSCodecParameter(uidcreation, planarconfig, ignoreOffsetTable, numberOfThreads);
     if (cp_)
     {
       losslessdecoder_ = new DJLSLosslessDecoder();
@@ -0,0 +1,129 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmjpls
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the concurrent decompression of the frames
+ *           of multi-frame images
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcpxitem.h"
+#include "dcmtk/dcmjpls/djencode.h"
+#include "dcmtk/dcmjpls/djdecode.h"
+#include "dcmtk/dcmjpls/djrparam.h"
+
+#define COLUMNS 64
+#define ROWS 48
+#define FRAMES 8
+#define FRAME_SIZE (COLUMNS * ROWS)
+#define NUM_THREADS 4
+
+
+// create a multi-frame image with different pixel values in each frame
+static void createDataset(DcmDataset &dset, Uint8 *pixelData)
+{
+    for (Uint32 i = 0; i < FRAMES; i++)
+    {
+        for (Uint32 j = 0; j < FRAME_SIZE; j++)
+            pixelData[i * FRAME_SIZE + j] = OFstatic_cast(Uint8, (j % COLUMNS) * (i + 1) + (j / COLUMNS) * 3);
+    }
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_MultiframeGrayscaleByteSecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4.5").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, 1).good());
+    OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2").good());
+    OFCHECK(dset.putAndInsertString(DCM_NumberOfFrames, "8").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, ROWS).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, COLUMNS).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 8).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, 8).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_HighBit, 7).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+    OFCHECK(dset.putAndInsertUint8Array(DCM_PixelData, pixelData, FRAMES * FRAME_SIZE).good());
+}
+
+
+// compress the given dataset
+static void compress(DcmDataset &dset, E_TransferSyntax xfer, const DcmRepresentationParameter *param)
+{
+    DJLSEncoderRegistration::registerCodecs();
+    OFCHECK(dset.chooseRepresentation(xfer, param).good());
+    dset.removeAllButCurrentRepresentations();
+    OFCHECK(dset.hasRepresentation(xfer, param));
+    DJLSEncoderRegistration::cleanup();
+}
+
+
+// decompress the given dataset using the given number of threads and compare with the expected pixel data
+static void decompress(DcmDataset &dset, const Uint8 *expected, Uint32 numThreads)
+{
+    DJLSDecoderRegistration::registerCodecs(EJLSUC_never, EJLSPC_restore, OFFalse, numThreads);
+    // decompress a range of frames
+    DcmElement *elem = NULL;
+    OFCHECK(dset.findAndGetElement(DCM_PixelData, elem).good());
+    DcmPixelData *pixelData = OFstatic_cast(DcmPixelData *, elem);
+    if (pixelData != NULL)
+    {
+        Uint8 buffer[(FRAMES - 2) * FRAME_SIZE];
+        OFString colorModel;
+        Uint32 startFragment = 0;
+        OFCHECK(pixelData->getUncompressedFrames(&dset, 1, FRAMES - 2, startFragment, buffer, sizeof(buffer), colorModel).good());
+        OFCHECK(memcmp(buffer, expected + FRAME_SIZE, sizeof(buffer)) == 0);
+    }
+    // decompress the complete image
+    OFCHECK(dset.chooseRepresentation(EXS_LittleEndianExplicit, NULL).good());
+    const Uint8 *pixels = NULL;
+    unsigned long count = 0;
+    OFCHECK(dset.findAndGetUint8Array(DCM_PixelData, pixels, &count).good());
+    OFCHECK_EQUAL(count, FRAMES * FRAME_SIZE);
+    if ((pixels != NULL) && (count == FRAMES * FRAME_SIZE))
+        OFCHECK(memcmp(pixels, expected, count) == 0);
+    DJLSDecoderRegistration::cleanup();
+}
+
+
+OFTEST(dcmjpls_multiThreadedFrames)
+{
+    Uint8 original[FRAMES * FRAME_SIZE];
+    // lossless compression, decompressed with one and with multiple threads
+    DcmDataset dset1;
+    createDataset(dset1, original);
+    DJLSRepresentationParameter param(0, OFTrue);
+    compress(dset1, EXS_JPEGLSLossless, &param);
+    DcmDataset dsetN(dset1);
+    decompress(dset1, original, 1);
+    decompress(dsetN, original, NUM_THREADS);
+
+    // near-lossless compression, decompression with multiple threads gives the same result as with one thread
+    DcmDataset lossy1;
+    createDataset(lossy1, original);
+    DJLSRepresentationParameter lossyParam(2, OFFalse);
+    compress(lossy1, EXS_JPEGLSLossy, &lossyParam);
+    DcmDataset lossyN(lossy1);
+    DJLSDecoderRegistration::registerCodecs();
+    OFCHECK(lossy1.chooseRepresentation(EXS_LittleEndianExplicit, NULL).good());
+    DJLSDecoderRegistration::cleanup();
+    const Uint8 *pixels = NULL;
+    unsigned long count = 0;
+    OFCHECK(lossy1.findAndGetUint8Array(DCM_PixelData, pixels, &count).good());
+    OFCHECK_EQUAL(count, FRAMES * FRAME_SIZE);
+    if ((pixels != NULL) && (count == FRAMES * FRAME_SIZE))
+        decompress(lossyN, pixels, NUM_THREADS);
+}
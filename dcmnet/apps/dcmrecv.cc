@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2013-2014, OFFIS e.V.
+ *  Copyright (C) 2013-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -29,6 +29,7 @@
 #include "dcmtk/dcmdata/dcuid.h"     /* for dcmtk version name */
 #include "dcmtk/dcmdata/cmdlnarg.h"  /* for prepareCmdLineArgs */
 #include "dcmtk/dcmnet/dstorscp.h"   /* for DcmStorageSCP */
+#include "dcmtk/dcmnet/dstorpool.h"  /* for DcmStorageSCPPool */
 
 
 /* general definitions */
@@ -72,6 +73,25 @@ static char rcsid[] = "$dcmtk: " OFFIS_CONSOLE_APPLICATION " v"
     OFSTRINGSTREAM_GETOFSTRING(optStream, string)
 
 
+/* set the storage parameters of a storage SCP or a pool of storage SCPs */
+
+template<class T>
+static OFCondition configureStorage(T &storage,
+                                    const DcmStorageSCP::E_DirectoryGenerationMode directoryGeneration,
+                                    const DcmStorageSCP::E_FilenameGenerationMode filenameGeneration,
+                                    const char *filenameExtension,
+                                    const DcmStorageSCP::E_DatasetStorageMode datasetStorage,
+                                    const char *outputDirectory)
+{
+    storage.setDirectoryGenerationMode(directoryGeneration);
+    storage.setFilenameGenerationMode(filenameGeneration);
+    storage.setFilenameExtension(filenameExtension);
+    storage.setDatasetStorageMode(datasetStorage);
+    /* specify the output directory (also checks whether directory exists and is writable) */
+    return storage.setOutputDirectory(outputDirectory);
+}
+
+
 /* main program */
 
 #define SHORTCOL 4
@@ -91,11 +111,13 @@ int main(int argc, char *argv[])
     OFCmdUnsignedInt opt_dimseTimeout = 0;
     OFCmdUnsignedInt opt_acseTimeout = 30;
     OFCmdUnsignedInt opt_maxPDULength = ASC_DEFAULTMAXPDU;
+    OFCmdUnsignedInt opt_maxThreads = 1;
     T_DIMSE_BlockingMode opt_blockingMode = DIMSE_BLOCKING;
 
     OFBool opt_showPresentationContexts = OFFalse;  // default: do not show presentation contexts in verbose mode
     OFBool opt_useCalledAETitle = OFFalse;          // default: respond with specified application entity title
     OFBool opt_HostnameLookup = OFTrue;             // default: perform hostname lookup (for log output)
+    OFBool opt_workerSubdirectories = OFFalse;      // default: all worker threads use the output directory
 
     DcmStorageSCP::E_DirectoryGenerationMode opt_directoryGeneration = DcmStorageSCP::DGM_NoSubdirectory;
     DcmStorageSCP::E_FilenameGenerationMode opt_filenameGeneration = DcmStorageSCP::FGM_SOPInstanceUID;
@@ -133,6 +155,11 @@ int main(int argc, char *argv[])
         cmd.addOption("--max-pdu",             "-pdu", 1, optString3.c_str(),
                                                           optString4.c_str());
         cmd.addOption("--disable-host-lookup", "-dhl",    "disable hostname lookup");
+#ifdef WITH_THREADS
+      cmd.addSubGroup("multi-threading:");
+        cmd.addOption("--max-threads",         "+mt",  1, "[n]umber: integer (1..255)",
+                                                          "receive up to n associations in parallel,\neach in a thread of its own (default: 1)");
+#endif
     cmd.addGroup("output options:");
       cmd.addSubGroup("general:");
         CONVERT_TO_STRING("[d]irectory: string (default: \"" << opt_outputDirectory << "\")", optString5);
@@ -141,6 +168,9 @@ int main(int argc, char *argv[])
       cmd.addSubGroup("subdirectory generation:");
         cmd.addOption("--no-subdir",           "-s",      "do not generate any subdirectories (default)");
         cmd.addOption("--series-date-subdir",  "+ssd",    "generate subdirectories from series date");
+#ifdef WITH_THREADS
+        cmd.addOption("--worker-subdir",       "+ws",     "store objects received by each thread in a\nsubdirectory of its own (only with --max-threads)");
+#endif
       cmd.addSubGroup("filename generation:");
         cmd.addOption("--default-filenames",   "+fd",     "generate filename from instance UID (default)");
         cmd.addOption("--unique-filenames",    "+fu",     "generate unique filename based on new UID");
@@ -204,6 +234,10 @@ int main(int argc, char *argv[])
             app.checkValue(cmd.getValueAndCheckMinMax(opt_maxPDULength, ASC_MINIMUMPDUSIZE, ASC_MAXIMUMPDUSIZE));
         if (cmd.findOption("--disable-host-lookup"))
             opt_HostnameLookup = OFFalse;
+#ifdef WITH_THREADS
+        if (cmd.findOption("--max-threads"))
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_maxThreads, 1, 255));
+#endif
 
         /* output options */
         if (cmd.findOption("--output-directory"))
@@ -215,6 +249,13 @@ int main(int argc, char *argv[])
         if (cmd.findOption("--series-date-subdir"))
             opt_directoryGeneration = DcmStorageSCP::DGM_SeriesDate;
         cmd.endOptionBlock();
+#ifdef WITH_THREADS
+        if (cmd.findOption("--worker-subdir"))
+        {
+            app.checkDependence("--worker-subdir", "--max-threads", opt_maxThreads > 1);
+            opt_workerSubdirectories = OFTrue;
+        }
+#endif
 
         cmd.beginOptionBlock();
         if (cmd.findOption("--default-filenames"))
@@ -257,30 +298,28 @@ int main(int argc, char *argv[])
     }
 
     /* start with the real work */
-    DcmStorageSCP storageSCP;
     OFCondition status;
 
     OFLOG_INFO(dcmrecvLogger, "configuring service class provider ...");
 
-    /* set general network parameters */
-    storageSCP.setPort(OFstatic_cast(Uint16, opt_port));
-    storageSCP.setAETitle(opt_aeTitle);
-    storageSCP.setMaxReceivePDULength(OFstatic_cast(Uint32, opt_maxPDULength));
-    storageSCP.setACSETimeout(OFstatic_cast(Uint32, opt_acseTimeout));
-    storageSCP.setDIMSETimeout(OFstatic_cast(Uint32, opt_dimseTimeout));
-    storageSCP.setDIMSEBlockingMode(opt_blockingMode);
-    storageSCP.setVerbosePCMode(opt_showPresentationContexts);
-    storageSCP.setRespondWithCalledAETitle(opt_useCalledAETitle);
-    storageSCP.setHostLookupEnabled(opt_HostnameLookup);
-    storageSCP.setDirectoryGenerationMode(opt_directoryGeneration);
-    storageSCP.setFilenameGenerationMode(opt_filenameGeneration);
-    storageSCP.setFilenameExtension(opt_filenameExtension);
-    storageSCP.setDatasetStorageMode(opt_datasetStorage);
+    /* set general network parameters (used by the single SCP or all SCPs of the pool) */
+    DcmSCPConfig config;
+    config.setPort(OFstatic_cast(Uint16, opt_port));
+    config.setAETitle(opt_aeTitle);
+    config.setMaxReceivePDULength(OFstatic_cast(Uint32, opt_maxPDULength));
+    config.setACSETimeout(OFstatic_cast(Uint32, opt_acseTimeout));
+    config.setDIMSETimeout(OFstatic_cast(Uint32, opt_dimseTimeout));
+    config.setDIMSEBlockingMode(opt_blockingMode);
+    config.setVerbosePCMode(opt_showPresentationContexts);
+    config.setRespondWithCalledAETitle(opt_useCalledAETitle);
+    config.setHostLookupEnabled(opt_HostnameLookup);
 
     /* load association negotiation profile from configuration file (if specified) */
     if ((opt_configFile != NULL) && (opt_profileName != NULL))
     {
-        status = storageSCP.loadAssociationConfiguration(opt_configFile, opt_profileName);
+        status = config.loadAssociationCfgFile(opt_configFile);
+        if (status.good())
+            status = config.setAndCheckAssociationProfile(opt_profileName);
         if (status.bad())
         {
             OFLOG_FATAL(dcmrecvLogger, "cannot load association configuration: " << status.text());
@@ -291,22 +330,56 @@ int main(int argc, char *argv[])
         OFLOG_WARN(dcmrecvLogger, "no configuration file specified, SCP will only support the Verification SOP Class");
     }
 
-    /* specify the output directory (also checks whether directory exists and is writable) */
-    status = storageSCP.setOutputDirectory(opt_outputDirectory);
-    if (status.bad())
+#ifdef WITH_THREADS
+    if (opt_maxThreads > 1)
     {
-        OFLOG_FATAL(dcmrecvLogger, "cannot specify output directory: " << status.text());
-        return EXITCODE_INVALID_OUTPUT_DIRECTORY;
-    }
+        DcmStorageSCPPool storagePool;
+        storagePool.getConfig() = config;
+        storagePool.setMaxThreads(OFstatic_cast(Uint16, opt_maxThreads));
+        storagePool.setWorkerSubdirectoryMode(opt_workerSubdirectories);
+
+        /* set storage parameters (also checks whether output directory exists and is writable) */
+        status = configureStorage(storagePool, opt_directoryGeneration, opt_filenameGeneration,
+            opt_filenameExtension, opt_datasetStorage, opt_outputDirectory);
+        if (status.bad())
+        {
+            OFLOG_FATAL(dcmrecvLogger, "cannot specify output directory: " << status.text());
+            return EXITCODE_INVALID_OUTPUT_DIRECTORY;
+        }
 
-    OFLOG_INFO(dcmrecvLogger, "starting service class provider and listening ...");
+        OFLOG_INFO(dcmrecvLogger, "starting pool of " << opt_maxThreads << " service class providers and listening ...");
 
-    /* start SCP and listen on the specified port */
-    status = storageSCP.listen();
-    if (status.bad())
+        /* start pool and listen on the specified port */
+        status = storagePool.listen();
+        if (status.bad())
+        {
+            OFLOG_FATAL(dcmrecvLogger, "cannot start SCP pool and listen on port " << opt_port << ": " << status.text());
+            return EXITCODE_CANNOT_START_SCP_AND_LISTEN;
+        }
+    } else
+#endif
     {
-        OFLOG_FATAL(dcmrecvLogger, "cannot start SCP and listen on port " << opt_port << ": " << status.text());
-        return EXITCODE_CANNOT_START_SCP_AND_LISTEN;
+        DcmStorageSCP storageSCP;
+        storageSCP.setConfig(config);
+
+        /* set storage parameters (also checks whether output directory exists and is writable) */
+        status = configureStorage(storageSCP, opt_directoryGeneration, opt_filenameGeneration,
+            opt_filenameExtension, opt_datasetStorage, opt_outputDirectory);
+        if (status.bad())
+        {
+            OFLOG_FATAL(dcmrecvLogger, "cannot specify output directory: " << status.text());
+            return EXITCODE_INVALID_OUTPUT_DIRECTORY;
+        }
+
+        OFLOG_INFO(dcmrecvLogger, "starting service class provider and listening ...");
+
+        /* start SCP and listen on the specified port */
+        status = storageSCP.listen();
+        if (status.bad())
+        {
+            OFLOG_FATAL(dcmrecvLogger, "cannot start SCP and listen on port " << opt_port << ": " << status.text());
+            return EXITCODE_CANNOT_START_SCP_AND_LISTEN;
+        }
     }
 
     /* make sure that everything is cleaned up properly */
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2011-2014, OFFIS e.V.
+ *  Copyright (C) 2011-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -131,6 +131,8 @@ int main(int argc, char *argv[])
     OFCmdUnsignedInt opt_acseTimeout = 30;
     OFCmdUnsignedInt opt_maxReceivePDULength = ASC_DEFAULTMAXPDU;
     OFCmdUnsignedInt opt_maxSendPDULength = 0;
+    OFCmdUnsignedInt opt_maxOperationsInvoked = 1;
+    OFCmdUnsignedInt opt_parallelAssociations = 1;
     T_DIMSE_BlockingMode opt_blockMode = DIMSE_BLOCKING;
 #ifdef WITH_ZLIB
     OFCmdUnsignedInt opt_compressionLevel = 0;
@@ -207,6 +209,12 @@ int main(int argc, char *argv[])
       cmd.addSubGroup("association handling:");
         cmd.addOption("--multi-associations",  "+ma",     "use multiple associations (one after the other)\nif needed to transfer the instances (default)");
         cmd.addOption("--single-association",  "-ma",     "always use a single association");
+        cmd.addOption("--async-operations",    "+ao",  1, "[n]umber: integer (1..65535)",
+                                                          "propose asynchronous operations window, i.e.\nsend up to n requests without waiting for\nthe responses (default: 1 = synchronous)");
+#ifdef WITH_THREADS
+        cmd.addOption("--parallel-associations", "+pa", 1, "[n]umber: integer (1..128)",
+                                                          "split the instances into n parts and send\nthem on n associations in parallel (default: 1)");
+#endif
       cmd.addSubGroup("other network options:");
         cmd.addOption("--timeout",             "-to",  1, "[s]econds: integer (default: unlimited)",
                                                           "timeout for connection requests");
@@ -330,6 +338,12 @@ int main(int argc, char *argv[])
         if (cmd.findOption("--multi-associations")) opt_multipleAssociations = OFTrue;
         if (cmd.findOption("--single-association")) opt_multipleAssociations = OFFalse;
         cmd.endOptionBlock();
+        if (cmd.findOption("--async-operations"))
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_maxOperationsInvoked, 1, 65535));
+#ifdef WITH_THREADS
+        if (cmd.findOption("--parallel-associations"))
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_parallelAssociations, 1, 128));
+#endif
 
         if (cmd.findOption("--timeout"))
         {
@@ -460,6 +474,7 @@ int main(int argc, char *argv[])
     storageSCU.setPeerAETitle(opt_peerTitle);
     storageSCU.setAETitle(opt_ourTitle);
     storageSCU.setMaxReceivePDULength(OFstatic_cast(Uint32, opt_maxReceivePDULength));
+    storageSCU.setMaxOperationsInvoked(OFstatic_cast(Uint16, opt_maxOperationsInvoked));
     storageSCU.setACSETimeout(OFstatic_cast(Uint32, opt_acseTimeout));
     storageSCU.setDIMSETimeout(OFstatic_cast(Uint32, opt_dimseTimeout));
     storageSCU.setDIMSEBlockingMode(opt_blockMode);
@@ -477,7 +492,23 @@ int main(int argc, char *argv[])
         OFLOG_DEBUG(dcmsendLogger, "only a single associations allowed (option --single-association used)");
     }
 
-    /* add presentation contexts to be negotiated (if there are still any) */
+    /* send SOP instances on multiple associations in parallel (if requested) */
+    if (opt_parallelAssociations > 1)
+    {
+        OFLOG_INFO(dcmsendLogger, "sending SOP instances on up to " << opt_parallelAssociations
+            << " associations in parallel ...");
+        status = storageSCU.sendSOPInstancesInParallel(OFstatic_cast(size_t, opt_parallelAssociations),
+            opt_multipleAssociations);
+        if (status.bad())
+        {
+            OFLOG_FATAL(dcmsendLogger, "cannot send SOP instances: " << status.text());
+            cleanup();
+            return EXITCODE_CANNOT_SEND_REQUEST;
+        }
+    }
+
+    /* add presentation contexts to be negotiated (if there are still any);
+     * nothing is left to be done here after a parallel transfer */
     while ((status = storageSCU.addPresentationContexts()).good())
     {
         if (opt_multipleAssociations)
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -57,6 +57,7 @@ END_EXTERN_C
 #include "dcmtk/dcmnet/diutil.h"
 #include "dcmtk/dcmnet/dcasccfg.h"      /* for class DcmAssociationConfiguration */
 #include "dcmtk/dcmnet/dcasccff.h"      /* for class DcmAssociationConfigurationFile */
+#include "dcmtk/dcmnet/dstorwb.h"       /* for class DcmWriteBehindStorage */
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmdata/dcuid.h"
 #include "dcmtk/dcmdata/dcdict.h"
@@ -187,6 +188,12 @@ OFBool             opt_forkMode = OFFalse;
 OFBool             opt_forkedChild = OFFalse;
 OFBool             opt_execSync = OFFalse;            // default: execute in background
 
+#ifdef WITH_THREADS
+static OFBool      opt_writeBehind = OFFalse;         // default: write files directly
+static DcmWriteBehindStorage::E_SyncMode opt_syncMode = DcmWriteBehindStorage::WSM_Batch;
+static OFBool      opt_respondAfterSync = OFFalse;    // default: respond after file has been written
+#endif
+
 #ifdef WITH_OPENSSL
 static int         opt_keyFileFormat = SSL_FILETYPE_PEM;
 static const char *opt_privateKeyFile = NULL;
@@ -201,6 +208,10 @@ static const char *opt_readSeedFile = NULL;
 static const char *opt_writeSeedFile = NULL;
 static DcmCertificateVerification opt_certVerification = DCV_requireCertificate;
 static const char *opt_dhparam = NULL;
+static OFBool      opt_setSessionCacheSize = OFFalse;  // default: use OpenSSL default
+static OFCmdUnsignedInt opt_sessionCacheSize = 0;
+static OFCmdUnsignedInt opt_sessionTimeout = 300;
+static OFBool      opt_sessionTickets = OFTrue;
 #endif
 
 
@@ -370,6 +381,12 @@ int main(int argc, char *argv[])
       cmd.addOption("--require-peer-cert",      "-rc",     "verify peer certificate, fail if absent (def.)");
       cmd.addOption("--verify-peer-cert",       "-vc",     "verify peer certificate if present");
       cmd.addOption("--ignore-peer-cert",       "-ic",     "don't verify peer certificate");
+    cmd.addSubGroup("session resumption (only with --enable-tls):");
+      cmd.addOption("--session-cache",          "+sc",  1, "[n]umber: integer (default: 20480)",
+                                                           "cache at most n TLS sessions for resumption\n(0 = disable session cache)");
+      cmd.addOption("--session-timeout",        "+st",  1, "[s]econds: integer (default: 300)",
+                                                           "TLS sessions can be resumed for s seconds");
+      cmd.addOption("--no-session-tickets",     "-st",     "do not issue TLS session tickets");
 #endif
 
   cmd.addGroup("output options:");
@@ -378,6 +395,14 @@ int main(int argc, char *argv[])
     cmd.addSubGroup("bit preserving mode:");
       cmd.addOption("--normal",                 "-B",      "allow implicit format conversions (default)");
       cmd.addOption("--bit-preserving",         "+B",      "write data exactly as read");
+#ifdef WITH_THREADS
+    cmd.addSubGroup("write-behind storage (only with --bit-preserving, not with --fork):");
+      cmd.addOption("--write-behind",           "+wb",     "write received data in a background thread");
+      cmd.addOption("--sync-batch",             "+sb",     "synchronize files to disk in batches (default)");
+      cmd.addOption("--sync-each",              "+se",     "synchronize each file to disk");
+      cmd.addOption("--sync-none",              "-sy",     "do not synchronize files to disk");
+      cmd.addOption("--respond-after-sync",     "+ra",     "send C-STORE response after file has been\nsynchronized (default: after written)");
+#endif
     cmd.addSubGroup("output file format:");
       cmd.addOption("--write-file",             "+F",      "write file format (default)");
       cmd.addOption("--write-dataset",          "-F",      "write data set without file meta information");
@@ -665,6 +690,39 @@ int main(int argc, char *argv[])
     if (cmd.findOption("--bit-preserving")) opt_bitPreserving = OFTrue;
     cmd.endOptionBlock();
 
+#ifdef WITH_THREADS
+    if (cmd.findOption("--write-behind"))
+    {
+      app.checkDependence("--write-behind", "--bit-preserving", opt_bitPreserving);
+#if defined(HAVE_FORK) || defined(_WIN32)
+      app.checkConflict("--write-behind", "--fork", opt_forkMode);
+#endif
+      opt_writeBehind = OFTrue;
+    }
+    cmd.beginOptionBlock();
+    if (cmd.findOption("--sync-batch"))
+    {
+      app.checkDependence("--sync-batch", "--write-behind", opt_writeBehind);
+      opt_syncMode = DcmWriteBehindStorage::WSM_Batch;
+    }
+    if (cmd.findOption("--sync-each"))
+    {
+      app.checkDependence("--sync-each", "--write-behind", opt_writeBehind);
+      opt_syncMode = DcmWriteBehindStorage::WSM_EachFile;
+    }
+    if (cmd.findOption("--sync-none"))
+    {
+      app.checkDependence("--sync-none", "--write-behind", opt_writeBehind);
+      opt_syncMode = DcmWriteBehindStorage::WSM_None;
+    }
+    cmd.endOptionBlock();
+    if (cmd.findOption("--respond-after-sync"))
+    {
+      app.checkDependence("--respond-after-sync", "--write-behind", opt_writeBehind);
+      opt_respondAfterSync = OFTrue;
+    }
+#endif
+
     cmd.beginOptionBlock();
     if (cmd.findOption("--write-file")) opt_useMetaheader = OFTrue;
     if (cmd.findOption("--write-dataset")) opt_useMetaheader = OFFalse;
@@ -944,6 +1002,23 @@ int main(int argc, char *argv[])
   if (cmd.findOption("--ignore-peer-cert"))  opt_certVerification = DCV_ignoreCertificate;
   cmd.endOptionBlock();
 
+  if (cmd.findOption("--session-cache"))
+  {
+    app.checkDependence("--session-cache", "--enable-tls", opt_secureConnection);
+    app.checkValue(cmd.getValue(opt_sessionCacheSize));
+    opt_setSessionCacheSize = OFTrue;
+  }
+  if (cmd.findOption("--session-timeout"))
+  {
+    app.checkDependence("--session-timeout", "--enable-tls", opt_secureConnection);
+    app.checkValue(cmd.getValueAndCheckMin(opt_sessionTimeout, 1));
+  }
+  if (cmd.findOption("--no-session-tickets"))
+  {
+    app.checkDependence("--no-session-tickets", "--enable-tls", opt_secureConnection);
+    opt_sessionTickets = OFFalse;
+  }
+
   const char *current = NULL;
   const char *currentOpenSSL;
   if (cmd.findOption("--cipher", 0, OFCommandLine::FOM_First))
@@ -1132,6 +1207,13 @@ int main(int argc, char *argv[])
 
     tLayer->setCertificateVerification(opt_certVerification);
 
+    /* sessions cached in this process cannot be resumed by another one in
+     * multi-process mode, but session tickets can.
+     */
+    if (opt_setSessionCacheSize) tLayer->setSessionCacheSize(opt_sessionCacheSize);
+    tLayer->setSessionTimeout(OFstatic_cast(long, opt_sessionTimeout));
+    tLayer->setSessionTickets(opt_sessionTickets);
+
     cond = ASC_setTransportLayer(net, tLayer, 0);
     if (cond.bad())
     {
@@ -1146,6 +1228,23 @@ int main(int argc, char *argv[])
   signal(SIGCHLD, sigChildHandler);
 #endif
 
+#ifdef WITH_THREADS
+  /* start the I/O thread that writes the received files in the background */
+  DcmWriteBehindStorage writeBehindStorage;
+  if (opt_writeBehind)
+  {
+    writeBehindStorage.setSyncMode(opt_syncMode);
+    writeBehindStorage.setCompletionMode(opt_respondAfterSync ? DcmWriteBehindStorage::WCM_Synced : DcmWriteBehindStorage::WCM_Written);
+    cond = writeBehindStorage.start();
+    if (cond.bad())
+    {
+      OFLOG_ERROR(storescpLogger, DimseCondition::dump(temp_str, cond));
+      return 1;
+    }
+    dcmWriteBehindStorage.set(&writeBehindStorage);
+  }
+#endif
+
   while (cond.good())
   {
     /* receive an association and acknowledge or reject it. If the association was */
@@ -1178,6 +1277,17 @@ int main(int argc, char *argv[])
     if (DUL_processIsForkedChild()) break;
   }
 
+#ifdef WITH_THREADS
+  /* write all remaining data and stop the I/O thread */
+  if (opt_writeBehind)
+  {
+    dcmWriteBehindStorage.set(NULL);
+    writeBehindStorage.stop();
+    OFLOG_DEBUG(storescpLogger, "write-behind storage: " << writeBehindStorage.getNumFilesWritten()
+      << " file(s) written, " << writeBehindStorage.getNumSyncs() << " synchronization(s)");
+  }
+#endif
+
   /* drop the network, i.e. free memory of T_ASC_Network* structure. This call */
   /* is the counterpart of ASC_initializeNetwork(...) which was called above. */
   cond = ASC_dropNetwork(&net);
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1996-2013, OFFIS e.V.
+ *  Copyright (C) 1996-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -90,6 +90,9 @@ static char rcsid[] = "$dcmtk: " OFFIS_CONSOLE_APPLICATION " v"
 #define APPLICATIONTITLE     "STORESCU"
 #define PEERAPPLICATIONTITLE "ANY-SCP"
 
+/* maximum number of TLS sessions (i.e. peers) stored in the session file */
+#define STORESCU_SESSION_CACHE_SIZE 64
+
 static OFBool opt_showPresentationContexts = OFFalse;
 static OFBool opt_abortAssociation = OFFalse;
 static OFCmdUnsignedInt opt_maxReceivePDULength = ASC_DEFAULTMAXPDU;
@@ -144,6 +147,8 @@ static const char *opt_readSeedFile = NULL;
 static const char *opt_writeSeedFile = NULL;
 static DcmCertificateVerification opt_certVerification = DCV_requireCertificate;
 static const char *opt_dhparam = NULL;
+static const char *opt_sessionFile = NULL;
+static OFCmdUnsignedInt opt_sessionTimeout = 300;
 #endif
 
 // User Identity Negotiation
@@ -344,6 +349,11 @@ int main(int argc, char *argv[])
       cmd.addOption("--require-peer-cert",    "-rc",     "verify peer certificate, fail if absent (default)");
       cmd.addOption("--verify-peer-cert",     "-vc",     "verify peer certificate if present");
       cmd.addOption("--ignore-peer-cert",     "-ic",     "don't verify peer certificate");
+    cmd.addSubGroup("session resumption (only with --enable-tls):");
+      cmd.addOption("--session-file",         "+sf",  1, "[f]ilename: string",
+                                                         "resume TLS session stored in file f and\nstore negotiated session in f");
+      cmd.addOption("--session-timeout",      "+st",  1, "[s]econds: integer (default: 300)",
+                                                         "TLS sessions can be resumed for s seconds");
 #endif
 
     /* evaluate command line */
@@ -612,6 +622,17 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--ignore-peer-cert"))  opt_certVerification = DCV_ignoreCertificate;
       cmd.endOptionBlock();
 
+      if (cmd.findOption("--session-file"))
+      {
+        app.checkDependence("--session-file", "--enable-tls", opt_secureConnection);
+        app.checkValue(cmd.getValue(opt_sessionFile));
+      }
+      if (cmd.findOption("--session-timeout"))
+      {
+        app.checkDependence("--session-timeout", "--enable-tls", opt_secureConnection);
+        app.checkValue(cmd.getValueAndCheckMin(opt_sessionTimeout, 1));
+      }
+
       const char *current = NULL;
       const char *currentOpenSSL;
       if (cmd.findOption("--cipher", 0, OFCommandLine::FOM_First))
@@ -875,6 +896,16 @@ int main(int argc, char *argv[])
 
       tLayer->setCertificateVerification(opt_certVerification);
 
+      /* resume the TLS session negotiated by a previous run (if not expired),
+       * so that the full handshake can be skipped
+       */
+      tLayer->setSessionTimeout(OFstatic_cast(long, opt_sessionTimeout));
+      if (opt_sessionFile)
+      {
+        tLayer->setSessionCacheSize(STORESCU_SESSION_CACHE_SIZE);
+        if (OFStandard::fileExists(opt_sessionFile) && (TCS_ok != tLayer->loadSessionCache(opt_sessionFile)))
+          OFLOG_WARN(storescuLogger, "unable to load TLS sessions from file '" << opt_sessionFile << "', ignoring");
+      }
 
       cond = ASC_setTransportLayer(net, tLayer, 0);
       if (cond.bad())
@@ -1081,6 +1112,11 @@ int main(int argc, char *argv[])
       } else
         OFLOG_WARN(storescuLogger, "cannot write random seed, ignoring");
     }
+    if (tLayer && opt_sessionFile)
+    {
+      if (TCS_ok != tLayer->saveSessionCache(opt_sessionFile))
+        OFLOG_WARN(storescuLogger, "cannot write TLS sessions to file '" << opt_sessionFile << "', ignoring");
+    }
     delete tLayer;
 #endif
 
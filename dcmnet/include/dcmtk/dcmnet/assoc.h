@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -234,6 +234,12 @@ struct DCMTK_DCMNET_EXPORT T_ASC_Parameters
     long ourMaxPDUReceiveSize;    /* we say what we can receive */
     long theirMaxPDUReceiveSize;  /* they say what we can send */
 
+    /* asynchronous operations window, 0/0 means "not negotiated" */
+    unsigned short ourMaxOperationsInvoked;      /* we propose or accept */
+    unsigned short ourMaxOperationsPerformed;
+    unsigned short theirMaxOperationsInvoked;    /* they propose or accept */
+    unsigned short theirMaxOperationsPerformed;
+
 };
 
 /*
@@ -509,6 +515,43 @@ ASC_getCopyOfIdentResponse(T_ASC_Parameters * params,
                            char*& buffer,
                            unsigned short& bufferLen);
 
+/* asynchronous operations window negotiation */
+
+/** sets the values of the Asynchronous Operations Window sub-item.
+ *  For the association requestor, these are the values proposed in the
+ *  A-ASSOCIATE-RQ. For the association acceptor, these are the values
+ *  returned in the A-ASSOCIATE-AC, which is only done if the requestor
+ *  has proposed an asynchronous operations window. According to the DICOM
+ *  standard, a value of 0 means "unlimited". If both values are 0, the
+ *  sub-item is not sent at all (which is the default).
+ *  @param params - [in/out] The association parameters to be modified
+ *  @param maxOperationsInvoked - [in] Maximum number of operations invoked
+ *  @param maxOperationsPerformed - [in] Maximum number of operations performed
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_setAsyncOperationsWindow(T_ASC_Parameters * params,
+                             unsigned short maxOperationsInvoked,
+                             unsigned short maxOperationsPerformed);
+
+/** returns the values of the Asynchronous Operations Window sub-item
+ *  received from the peer, i.e.\ the values proposed by the requestor (on
+ *  the acceptor side) or the values accepted by the acceptor (on the
+ *  requestor side). If no such sub-item has been received, both values are
+ *  set to 1, which is the default for synchronous operation.
+ *  Please note that the values in the A-ASSOCIATE-AC are interpreted from
+ *  the point of view of the association requestor, i.e. the requestor may
+ *  invoke up to maxOperationsInvoked operations asynchronously.
+ *  @param params - [in] The association parameters to read from
+ *  @param maxOperationsInvoked - [out] Maximum number of operations invoked
+ *  @param maxOperationsPerformed - [out] Maximum number of operations performed
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_getAsyncOperationsWindow(T_ASC_Parameters * params,
+                             unsigned short& maxOperationsInvoked,
+                             unsigned short& maxOperationsPerformed);
+
 /* TLS/SSL */
 
 /* get peer certificate from open association */
@@ -519,6 +562,23 @@ DCMTK_DCMNET_EXPORT unsigned long ASC_getPeerCertificate(T_ASC_Association *asso
 DCMTK_DCMNET_EXPORT OFCondition
 ASC_setTransportLayer(T_ASC_Network *network, DcmTransportLayer *newLayer, int takeoverOwnership);
 
+/** set the size of the receive buffer allocated for each association that is
+ *  subsequently requested or accepted on the given network. The initial value
+ *  is taken from the global dcmReceiveBufferSize when the network is created.
+ *  @param network network to be modified
+ *  @param size receive buffer size in bytes, 0 disables the buffer
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_setReceiveBufferSize(T_ASC_Network *network, Uint32 size);
+
+/** get the size of the receive buffer used for new associations on the given network
+ *  @param network network to be queried
+ *  @return receive buffer size in bytes, 0 if the network is NULL
+ */
+DCMTK_DCMNET_EXPORT Uint32
+ASC_getReceiveBufferSize(T_ASC_Network *network);
+
 enum ASC_associateType
 {
     ASC_ASSOC_RQ,
@@ -574,6 +634,49 @@ ASC_receiveAssociation(
     DUL_BLOCKOPTIONS block=DUL_BLOCK,
     int timeout=0);
 
+/** accept an incoming transport connection without reading the association
+ *  request from it. This is the first part of ASC_receiveAssociation(). It
+ *  allows for accepting a connection in one thread and reading the
+ *  A-ASSOCIATE-RQ in another one as soon as data is available on the
+ *  connection (e.g. reported by select()), which may take a while otherwise.
+ *  @param network network to be listened on
+ *  @param assoc pointer to the association created by this function. The
+ *    caller has to drop and destroy it if this function fails.
+ *  @param maxReceivePDUSize maximum PDU size to be accepted
+ *  @param useSecureLayer use the secure transport layer of the network
+ *  @param block blocking mode for waiting for a connection
+ *  @param timeout timeout in seconds for waiting for a connection (DUL_NOBLOCK only)
+ *  @param retrieveRawPDU if true, the raw A-ASSOCIATE-RQ PDU is kept and can
+ *    be retrieved by ASC_readAssociationRequest()
+ *  @return EC_Normal if successful, DUL_NOASSOCIATIONREQUEST on timeout, an
+ *    error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_receiveTransportConnection(
+    T_ASC_Network * network,
+    T_ASC_Association ** assoc,
+    long maxReceivePDUSize,
+    OFBool useSecureLayer=OFFalse,
+    DUL_BLOCKOPTIONS block=DUL_BLOCK,
+    int timeout=0,
+    OFBool retrieveRawPDU=OFFalse);
+
+/** read the association request from a transport connection that has been
+ *  accepted by ASC_receiveTransportConnection(). This is the second part of
+ *  ASC_receiveAssociation(), i.e. the association is ready for being
+ *  acknowledged or rejected if this function succeeds.
+ *  @param assoc association created by ASC_receiveTransportConnection()
+ *  @param associatePDU if not NULL, the raw A-ASSOCIATE-RQ PDU is returned
+ *    here (retrieveRawPDU must have been set for ASC_receiveTransportConnection())
+ *  @param associatePDUlength length of the returned raw PDU
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_readAssociationRequest(
+    T_ASC_Association * assoc,
+    void **associatePDU=NULL,
+    unsigned long *associatePDUlength=NULL);
+
 DCMTK_DCMNET_EXPORT OFCondition
 ASC_acknowledgeAssociation(
     T_ASC_Association * assoc,
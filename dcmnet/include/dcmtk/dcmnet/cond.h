@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -189,6 +189,9 @@ extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_NoSOPInstancesToSend;
 extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_NoSuchSOPInstance;                /* No such SOP instance */
 extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_InvalidDatasetPointer;            /* Invalid dataset pointer */
 extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_AlreadyConnected;                 /* Already connected */
+extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_AsyncOperationsWindowFull;        /* Asynchronous operations window full */
+extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_UnexpectedMessageID;              /* Unexpected message ID */
+extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_OutstandingRequests;              /* Outstanding requests */
 extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_InsufficientPortPrivileges;       /* Insufficient Port Privileges */
 // codes 1024 to 1073 are used for the association negotiation profile classes
 extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_SCPBusy;                          /* SCP is busy */
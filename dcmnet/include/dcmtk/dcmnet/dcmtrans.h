@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1998-2011, OFFIS e.V.
+ *  Copyright (C) 1998-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -31,6 +31,18 @@
 #define INCLUDE_UNISTD
 #include "dcmtk/ofstd/ofstdinc.h"
 
+/** describes one of several memory blocks that are written to a
+ *  transport connection with a single call to DcmTransportConnection::writev().
+ */
+struct DCMTK_DCMNET_EXPORT DcmTransportBuffer
+{
+  /// pointer to the data to be written
+  void *data;
+
+  /// number of bytes to be written
+  size_t length;
+};
+
 /** this class represents a TCP/IP based transport connection
  *  which can be a transparent TCP/IP socket communication or a
  *  secure transport protocol such as TLS.
@@ -88,6 +100,17 @@ public:
    */
   virtual ssize_t write(void *buf, size_t nbyte) = 0;
 
+  /** attempts to write the given memory blocks, in the given order,
+   *  to the transport connection (gather write). The default implementation
+   *  calls write() for each block and stops at the first incomplete write.
+   *  Derived classes may override this method to pass all blocks to the
+   *  operating system at once.
+   *  @param buffers array of memory blocks to be written
+   *  @param count number of entries in the array
+   *  @return number of bytes written, negative number if unsuccessful.
+   */
+  virtual ssize_t writev(const DcmTransportBuffer *buffers, int count);
+
   /** Closes the transport connection. If a secure connection
    *  is used, a closure alert is sent before the connection
    *  is closed. Abstract method.
@@ -157,13 +180,14 @@ public:
    */
   static OFBool selectReadableAssociation(DcmTransportConnection *connections[], int connCount, int timeout);
 
-protected:
-
-  /** returns the socket file descriptor managed by this object.
+  /** returns the socket file descriptor managed by this object, e.g.\ for
+   *  waiting for incoming data on multiple connections using select().
    *  @return socket file descriptor
    */
   int getSocket() { return theSocket; }
 
+protected:
+
   /** set the socket file descriptor managed by this object.
    *  @param socket file descriptor
    */
@@ -273,6 +297,15 @@ public:
    */
   virtual ssize_t write(void *buf, size_t nbyte);
 
+  /** attempts to write the given memory blocks, in the given order,
+   *  to the transport connection using a single writev() system call
+   *  where available.
+   *  @param buffers array of memory blocks to be written
+   *  @param count number of entries in the array
+   *  @return number of bytes written, negative number if unsuccessful.
+   */
+  virtual ssize_t writev(const DcmTransportBuffer *buffers, int count);
+
   /** Closes the transport connection. If a secure connection
    *  is used, a closure alert is sent before the connection
    *  is closed.
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -94,6 +94,8 @@
 #include "dcmtk/ofstd/ofglobal.h"
 
 class DcmOutputFileStream;
+class DcmWriteBehindStorage;
+class DcmWriteBehindStream;
 
 /** Global flag to enable/disable workaround code for some buggy Store SCUs
  * in DIMSE_storeProvider().  If enabled, an illegal space-padding in the
@@ -113,6 +115,19 @@ extern DCMTK_DCMNET_EXPORT OFGlobal<OFBool> dcmPeerRequiresExactUIDCopy; /* defa
  */
 extern DCMTK_DCMNET_EXPORT OFGlobal<Uint32> dcmMaxOutgoingPDUSize; /* default 2^32-1 */
 
+/** global flag specifying whether instance data sent from a file with
+ *  DIMSE_sendMessageUsingFileData() may be transmitted exactly as stored
+ *  in the file, i.e. without loading, parsing and re-encoding the dataset.
+ *  This is only done if the file has a meta header and the dataset is
+ *  encoded in the transfer syntax of the presentation context; otherwise
+ *  the file is loaded as usual. On unencrypted TCP connections on systems
+ *  supporting sendfile(), the dataset is passed from the page cache to the
+ *  socket without being copied into user space. Note that the dataset is
+ *  then sent unchanged, e.g. group length and sequence encoding are not
+ *  adjusted according to the global encoding settings.
+ */
+extern DCMTK_DCMNET_EXPORT OFGlobal<OFBool> dcmSendStraightFileData; /* default OFFalse */
+
 
 /*
  * General Status Codes
@@ -988,6 +1003,25 @@ DIMSE_createFilestream(
                      /* out */
                      DcmOutputFileStream **filestream);
 
+#ifdef WITH_THREADS
+/** create a file for receiving the dataset of the given C-STORE request,
+ *  like DIMSE_createFilestream(), but write it in the background using the
+ *  given write-behind storage.  The returned stream must be finished with
+ *  DcmWriteBehindStorage::closeFile() or DcmWriteBehindStorage::abortFile().
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+DIMSE_createWriteBehindFilestream(
+                     /* in */
+                     const OFFilename &filename,
+                     const T_DIMSE_C_StoreRQ *request,
+                     const T_ASC_Association *assoc,
+                     T_ASC_PresentationContextID presIdCmd,
+                     int writeMetaheader,
+                     DcmWriteBehindStorage &storage,
+                     /* out */
+                     DcmWriteBehindStream **filestream);
+#endif
+
 DCMTK_DCMNET_EXPORT OFCondition
 DIMSE_receiveDataSetInFile(T_ASC_Association *assoc,
                      T_DIMSE_BlockingMode blocking, int timeout,
@@ -0,0 +1,330 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Pool of DICOM Storage Service Class Providers (SCP)
+ *
+ */
+
+#ifndef DSTORPOOL_H
+#define DSTORPOOL_H
+
+#include "dcmtk/config/osconfig.h"  /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS // Without threads this does not make sense...
+
+#include "dcmtk/ofstd/ofvector.h"   /* for OFVector */
+#include "dcmtk/dcmnet/scppool.h"   /* for base class DcmBaseSCPPool */
+#include "dcmtk/dcmnet/dstorscp.h"  /* for DcmStorageSCP */
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/** Storage Service Class Provider (SCP) that serves multiple associations at the
+ *  same time, each of them by a DcmStorageSCP object running in its own worker
+ *  thread.  All workers share the same process, i.e. the same data dictionary and
+ *  the same codec registry, so there is no need to re-initialize anything for an
+ *  incoming association.  The maximum number of associations served in parallel is
+ *  set by setMaxThreads() (see DcmBaseSCPPool for further options).
+ *  The storage settings (output directory, naming scheme, etc.) are the same as for
+ *  DcmStorageSCP and are handed to each worker.  Optionally, each worker stores the
+ *  received objects in a subdirectory of its own (see setWorkerSubdirectoryMode()),
+ *  so parallel associations never write to the same directory.
+ *  @note The Verification SOP Class (with Default Transfer Syntax) is always
+ *    supported.  Further Presentation Contexts are usually loaded from an
+ *    association negotiation profile, see loadAssociationConfiguration().
+ */
+class DCMTK_DCMNET_EXPORT DcmStorageSCPPool
+  : public DcmBaseSCPPool
+{
+
+  public:
+
+    /** default constructor
+     */
+    DcmStorageSCPPool();
+
+    /** destructor
+     */
+    virtual ~DcmStorageSCPPool();
+
+    // get methods
+
+    /** get the output directory to be used for the storage of the received DICOM
+     *  datasets
+     *  @return name of the output directory that is used for storing the received
+     *    DICOM datasets
+     */
+    const OFString &getOutputDirectory() const;
+
+    /** get the mode for generating subdirectories used to store the received datasets
+     *  @return current mode for generating subdirectories
+     *    (see DcmStorageSCP::E_DirectoryGenerationMode)
+     */
+    DcmStorageSCP::E_DirectoryGenerationMode getDirectoryGenerationMode() const;
+
+    /** get the mode for generating filenames for the received datasets
+     *  @return current mode for generating filenames
+     *    (see DcmStorageSCP::E_FilenameGenerationMode)
+     */
+    DcmStorageSCP::E_FilenameGenerationMode getFilenameGenerationMode() const;
+
+    /** get the filename extension that is appended to the generated filenames
+     *  @return current filename extension that is appended to the generated filenames
+     */
+    const OFString &getFilenameExtension() const;
+
+    /** get the mode specifying whether and how to store the received datasets
+     *  @return current mode specifying whether and how to store the received datasets
+     *    (see DcmStorageSCP::E_DatasetStorageMode)
+     */
+    DcmStorageSCP::E_DatasetStorageMode getDatasetStorageMode() const;
+
+    /** get the mode specifying whether each worker uses its own subdirectory
+     *  @return OFTrue if each worker uses its own subdirectory, OFFalse otherwise
+     */
+    OFBool getWorkerSubdirectoryMode() const;
+
+    // set methods
+
+    /** specify the output directory to be used for the storage of the received DICOM
+     *  datasets.  See DcmStorageSCP::setOutputDirectory() for details.
+     *  @param  directory  name of the output directory to be used
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    OFCondition setOutputDirectory(const OFString &directory);
+
+    /** set the mode for generating subdirectories used to store the received datasets.
+     *  See DcmStorageSCP::setDirectoryGenerationMode() for details.
+     *  @param  mode  mode to be set for generating subdirectories
+     *               (see DcmStorageSCP::E_DirectoryGenerationMode)
+     */
+    void setDirectoryGenerationMode(const DcmStorageSCP::E_DirectoryGenerationMode mode);
+
+    /** set the mode for generating filenames for the received datasets.
+     *  See DcmStorageSCP::setFilenameGenerationMode() for details.
+     *  @param  mode  mode to be set for generating filenames
+     *               (see DcmStorageSCP::E_FilenameGenerationMode)
+     */
+    void setFilenameGenerationMode(const DcmStorageSCP::E_FilenameGenerationMode mode);
+
+    /** specify the filename extension to be appended to the generated filenames.
+     *  See DcmStorageSCP::setFilenameExtension() for details.
+     *  @param  extension  filename extension appended to the generated filenames
+     */
+    void setFilenameExtension(const OFString &extension);
+
+    /** set the mode specifying how to store the received datasets.
+     *  See DcmStorageSCP::setDatasetStorageMode() for details.
+     *  @param  mode  mode to be set specifying whether and how to store the received
+     *                datasets (see DcmStorageSCP::E_DatasetStorageMode)
+     */
+    void setDatasetStorageMode(const DcmStorageSCP::E_DatasetStorageMode mode);
+
+    /** specify whether each worker stores the received datasets in a subdirectory of
+     *  its own.  If enabled, the subdirectories "worker1", "worker2", etc. are created
+     *  below the output directory (as needed) and are used instead of the output
+     *  directory, i.e. the subdirectories generated according to the directory
+     *  generation mode are created below them.  The number of a subdirectory is reused
+     *  by another worker as soon as its previous worker has been removed from the pool,
+     *  so there are never more subdirectories than the maximum number of threads.
+     *  By default, all workers use the same output directory.
+     *  @param  mode  use a subdirectory for each worker if OFTrue, do not otherwise
+     */
+    void setWorkerSubdirectoryMode(const OFBool mode);
+
+    // other methods
+
+    /** load an association negotiation profile from a configuration file.  This
+     *  profile specifies which Presentation Contexts (i.e. combination of SOP Class
+     *  and Transfer Syntaxes) are supported by all workers of this pool.
+     *  See DcmStorageSCP::loadAssociationConfiguration() for details.
+     *  @param  filename  filename of the configuration file to be loaded
+     *  @param  profile   name of the profile specified in the configuration file to be
+     *                    used
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    OFCondition loadAssociationConfiguration(const OFString &filename,
+                                             const OFString &profile);
+
+  protected:
+
+    /** worker of the storage SCP pool, i.e.\ a DcmStorageSCP object running a single
+     *  association in a thread of its own
+     */
+    class DCMTK_DCMNET_EXPORT Worker
+      : public DcmBaseSCPPool::DcmBaseSCPWorker
+      , public DcmStorageSCP
+    {
+
+      public:
+
+        /** constructor
+         *  @param  pool    storage SCP pool this worker belongs to
+         *  @param  number  number of this worker (1..n), also used for the name of
+         *                  its subdirectory (if any)
+         */
+        Worker(DcmStorageSCPPool &pool,
+               const size_t number);
+
+        /** destructor.  Releases the number of this worker.
+         */
+        virtual ~Worker();
+
+        /** set the shared configuration for this worker
+         *  @param  config  DcmSharedSCPConfig object to be used by this worker
+         *  @return status, EC_Normal if successful, an error code otherwise
+         */
+        virtual OFCondition setSharedConfig(const DcmSharedSCPConfig &config);
+
+        /** check whether this worker is currently handling an association
+         *  @return OFTrue if worker is busy, OFFalse otherwise
+         */
+        virtual OFBool busy();
+
+      protected:
+
+        /** run an already accepted (on TCP/IP level) association
+         *  @param  assoc  association to be run
+         *  @return status, EC_Normal if successful, an error code otherwise
+         */
+        virtual OFCondition workerListen(T_ASC_Association * const assoc);
+
+        /** negotiate an already accepted (on TCP/IP level) association
+         *  (event-driven mode)
+         *  @param  assoc  association to be negotiated, set to NULL if refused
+         *  @return status, EC_Normal if successful, an error code otherwise
+         */
+        virtual OFCondition workerNegotiate(T_ASC_Association *&assoc);
+
+        /** receive and handle a single DIMSE command on the association
+         *  (event-driven mode)
+         *  @param  assoc  association to be used, set to NULL if terminated
+         *  @return status, EC_Normal if successful, an error code otherwise
+         */
+        virtual OFCondition workerHandleCommand(T_ASC_Association *&assoc);
+
+        /** notification handler that is called for each DICOM object that has been
+         *  received and stored.  Forwards the call to the pool (see
+         *  DcmStorageSCPPool::notifyInstanceStored()).
+         *  @param  filename        filename (with full path) of the object stored
+         *  @param  sopClassUID     SOP Class UID of the object stored
+         *  @param  sopInstanceUID  SOP Instance UID of the object stored
+         *  @param  dataset         pointer to dataset of the object stored (or NULL if
+         *                          the dataset has been stored directly to file)
+         */
+        virtual void notifyInstanceStored(const OFString &filename,
+                                          const OFString &sopClassUID,
+                                          const OFString &sopInstanceUID,
+                                          DcmDataset *dataset = NULL) const;
+
+      private:
+
+        /// storage SCP pool this worker belongs to
+        DcmStorageSCPPool &StoragePool;
+        /// number of this worker (1..n)
+        const size_t Number;
+
+        // private undefined copy constructor
+        Worker(const Worker &);
+
+        // private undefined assignment operator
+        Worker &operator=(const Worker &);
+    };
+
+    // needed to keep MS VC6 happy
+    friend class Worker;
+
+    /** create a new worker and configure it according to the storage settings of
+     *  this pool
+     *  @return pointer to the newly created worker, NULL in case of error
+     */
+    virtual DcmBaseSCPWorker *createSCPWorker();
+
+    /** configure a newly created worker.  Sets the storage settings of this pool and,
+     *  if enabled, the subdirectory of the worker (which is created if needed).
+     *  Can be overwritten by derived classes in order to apply further settings.
+     *  @param  worker  storage SCP of the worker to be configured
+     *  @param  number  number of the worker (1..n)
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition configureWorker(DcmStorageSCP &worker,
+                                        const size_t number);
+
+    /** notification handler that is called for each DICOM object that has been
+     *  received and stored by any of the workers.  Please note that this method is
+     *  called from within the thread of the respective worker, i.e. different calls
+     *  may happen in parallel.  The default implementation does nothing.
+     *  @param  filename        filename (with full path) of the object stored
+     *  @param  sopClassUID     SOP Class UID of the object stored
+     *  @param  sopInstanceUID  SOP Instance UID of the object stored
+     *  @param  dataset         pointer to dataset of the object stored (or NULL if the
+     *                          dataset has been stored directly to file).
+     *                          Please note that this dataset will be deleted by the
+     *                          calling method, so do not store any references to it!
+     */
+    virtual void notifyInstanceStored(const OFString &filename,
+                                      const OFString &sopClassUID,
+                                      const OFString &sopInstanceUID,
+                                      DcmDataset *dataset) const;
+
+    // --- constants ---
+
+    /// prefix of the name of the subdirectory used by a worker (followed by its number)
+    static const char *DEF_WorkerSubdirectoryPrefix;
+
+  private:
+
+    /** get the lowest worker number that is currently not in use and mark it as used
+     *  @return worker number (1..n)
+     */
+    size_t acquireWorkerNumber();
+
+    /** mark the given worker number as not being in use any longer
+     *  @param  number  worker number to be released
+     */
+    void releaseWorkerNumber(const size_t number);
+
+    /// name of the output directory that is used to store the received datasets
+    OFString OutputDirectory;
+    /// filename extension appended to the generated filenames
+    OFString FilenameExtension;
+    /// mode that is used to generate subdirectories to store the received datasets
+    DcmStorageSCP::E_DirectoryGenerationMode DirectoryGeneration;
+    /// mode that is used to generate filenames for the received datasets
+    DcmStorageSCP::E_FilenameGenerationMode FilenameGeneration;
+    /// mode specifying how to store the received datasets
+    DcmStorageSCP::E_DatasetStorageMode DatasetStorage;
+    /// flag indicating whether each worker uses a subdirectory of its own
+    OFBool WorkerSubdirectories;
+
+    /// mutex that guards the list of worker numbers in use
+    OFMutex WorkerNumberMutex;
+    /// worker numbers in use, entry n-1 is OFTrue if number n is used by a worker
+    OFVector<OFBool> WorkerNumbersInUse;
+
+    // private undefined copy constructor
+    DcmStorageSCPPool(const DcmStorageSCPPool &);
+
+    // private undefined assignment operator
+    DcmStorageSCPPool &operator=(const DcmStorageSCPPool &);
+};
+
+#endif // WITH_THREADS
+
+#endif // DSTORPOOL_H
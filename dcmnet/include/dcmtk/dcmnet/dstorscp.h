@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2013-2014, OFFIS e.V.
+ *  Copyright (C) 2013-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,7 +25,7 @@
 #include "dcmtk/config/osconfig.h"  /* make sure OS specific configuration is included first */
 
 #include "dcmtk/ofstd/offname.h"    /* for OFFilenameCreator */
-#include "dcmtk/dcmnet/scp.h"       /* for base class DcmSCP */
+#include "dcmtk/dcmnet/scpthrd.h"   /* for base class DcmThreadSCP */
 
 
 /*---------------------*
@@ -36,7 +36,8 @@
  *  This class supports C-STORE and C-ECHO messages as an SCP.  The received datasets are
  *  always stored as DICOM files with the same Transfer Syntax as used for the network
  *  transmission.  Both the generation of the directory structure and the filenames can
- *  be configured by the user.
+ *  be configured by the user.  Since this class is derived from DcmThreadSCP, it can
+ *  also be used as a worker of an SCP pool (see DcmStorageSCPPool).
  *  @note The current implementation always requires to load a so-called association
  *    negotiation profile from a configuration file, which specifies the list of
  *    Presentation Contexts (i.e. combination of SOP Class and Transfer Syntaxes) to be
@@ -46,7 +47,7 @@
  *    Service Class Providers.
  */
 class DCMTK_DCMNET_EXPORT DcmStorageSCP
-  : public DcmSCP
+  : public DcmThreadSCP
 {
 
   public:
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2011-2014, OFFIS e.V.
+ *  Copyright (C) 2011-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,6 +25,7 @@
 #include "dcmtk/config/osconfig.h"  /* make sure OS specific configuration is included first */
 
 #include "dcmtk/dcmnet/scu.h"       /* for base class DcmSCU */
+#include "dcmtk/ofstd/ofmap.h"       /* for class OFMap */
 
 
 /*---------------------*
@@ -329,10 +330,42 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCU
      *  The sending process can be stopped by overwriting shouldStopAfterCurrentSOPInstance()
      *  in a derived class.  The sending process can be continued with the next SOP instance
      *  by calling sendSOPInstances() again.
+     *  If an Asynchronous Operations Window has been negotiated (see setMaxOperationsInvoked()
+     *  of the base class), the next C-STORE requests are sent without waiting for the previous
+     *  responses, i.e. as long as the window is not full.  In this case, notifySOPInstanceSent()
+     *  is called when the corresponding response has been received, which means that the SOP
+     *  instances are not necessarily reported in the order of the transfer list.  All
+     *  outstanding responses are received before this method returns.
      *  @return status, EC_Normal if successful, an error code otherwise
      */
     OFCondition sendSOPInstances();
 
+    /** send all SOP instances from the transfer list that have not yet been sent, using
+     *  multiple associations in parallel.  The instances to be sent are split into up to
+     *  'numAssociations' contiguous parts of (nearly) the same size, and each part is
+     *  transferred by a separate thread on its own association.  The network parameters
+     *  (e.g. peer, AE titles, timeouts and maximum PDU size) and the processing modes of
+     *  this object are used for all associations.  In contrast to sendSOPInstances(), this
+     *  method creates, negotiates and releases the associations itself, i.e. neither
+     *  addPresentationContexts() nor initNetwork() or negotiateAssociation() have to be
+     *  called before.  The transfer entries are updated while the instances are being sent,
+     *  and notifySOPInstanceSent() as well as shouldStopAfterCurrentSOPInstance() are
+     *  called for each SOP instance (never concurrently).  If one of the associations
+     *  fails, the other ones are stopped after their current SOP instance.
+     *  Please note that a secure transport connection (TLS) is not supported by this method.
+     *  If DCMTK has been compiled without thread support, all parts are sent one after the
+     *  other.
+     *  @param  numAssociations       maximum number of associations used in parallel
+     *  @param  multipleAssociations  flag indicating whether each part may be sent using
+     *                                more than one association (one after the other) if
+     *                                needed, e.g. because of the limited number of
+     *                                presentation contexts
+     *  @return status, EC_Normal if successful, an error code otherwise (i.e. the status of
+     *    the first association that failed)
+     */
+    OFCondition sendSOPInstancesInParallel(const size_t numAssociations,
+                                           const OFBool multipleAssociations = OFTrue);
+
     /** get some status information on the overall sending process.  This text can for example
      *  be output to the logger (on the level at the user's option).
      *  @param  summary  reference to a string in which the summary is stored
@@ -541,6 +574,10 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCU
 
   private:
 
+    /// helper class sending a part of the transfer list on its own association(s)
+    class StorageWorker;
+    friend class StorageWorker;
+
     /// association counter
     unsigned long AssociationCounter;
     /// presentation context counter
@@ -564,6 +601,25 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCU
     /// iterator pointing to the current entry in the list of SOP instances to be transferred
     OFListIterator(TransferEntry *) CurrentTransferEntry;
 
+    /** finish the processing of a SOP instance after its C-STORE request has been sent and
+     *  the response has been received (or an error occurred), i.e.\ update the transfer entry,
+     *  compact or delete the dataset (if requested) and call notifySOPInstanceSent()
+     *  @param  transferEntry  reference to the transfer entry that has been processed
+     *  @param  status         status of the C-STORE operation
+     *  @return status, EC_Normal if the sending process should be continued, an error code
+     *    otherwise (e.g. if the transfer should be halted on an unsuccessful store)
+     */
+    OFCondition finishSOPInstance(TransferEntry &transferEntry,
+                                  OFCondition status);
+
+    /** receive the response to one of the C-STORE requests sent asynchronously and finish the
+     *  processing of the corresponding SOP instance.  If no response could be received, the
+     *  processing of all outstanding SOP instances is finished with the respective error.
+     *  @param  pendingEntries  transfer entries of the outstanding requests (by message ID)
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    OFCondition receiveSOPInstanceResponse(OFMap<Uint16, TransferEntry *> &pendingEntries);
+
     // private undefined copy constructor
     DcmStorageSCU(const DcmStorageSCU &);
 
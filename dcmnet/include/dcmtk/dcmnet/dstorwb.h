@@ -0,0 +1,439 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Write-behind storage of received DICOM files
+ *
+ */
+
+#ifndef DSTORWB_H
+#define DSTORWB_H
+
+#include "dcmtk/config/osconfig.h"  /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS // Without threads this does not make sense...
+
+#include "dcmtk/ofstd/ofthread.h"    /* for OFThread, OFMutex, OFSemaphore */
+#include "dcmtk/ofstd/oflist.h"      /* for OFList */
+#include "dcmtk/ofstd/ofglobal.h"    /* for OFGlobal */
+#include "dcmtk/ofstd/offile.h"      /* for OFFilename */
+#include "dcmtk/dcmdata/dcostrma.h"  /* for DcmConsumer, DcmOutputStream */
+#include "dcmtk/dcmnet/dndefine.h"
+
+
+class DcmWriteBehindStorage;
+struct DcmWriteBehindFile;
+
+
+/** consumer that collects the data written to it in chunks and hands them
+ *  to the I/O thread of a DcmWriteBehindStorage object
+ */
+class DCMTK_DCMNET_EXPORT DcmWriteBehindConsumer: public DcmConsumer
+{
+public:
+  /** constructor
+   *  @param storage write-behind storage the data is handed to
+   *  @param file file the data is written to
+   */
+  DcmWriteBehindConsumer(DcmWriteBehindStorage &storage, DcmWriteBehindFile *file);
+
+  /// destructor
+  virtual ~DcmWriteBehindConsumer();
+
+  /** returns the status of the consumer, i.e.\ also reports errors that occurred
+   *  while the I/O thread was writing the data handed to it before.
+   *  @return OFTrue if status is OK, OFFalse otherwise
+   */
+  virtual OFBool good() const;
+
+  /** returns the status of the consumer as an OFCondition object
+   *  @return status, EC_Normal if successful, an error code otherwise
+   */
+  virtual OFCondition status() const;
+
+  /** returns true if no data is buffered in the current chunk
+   *  @return OFTrue if flushed, OFFalse otherwise
+   */
+  virtual OFBool isFlushed() const;
+
+  /** returns the minimum number of bytes that can be written with the
+   *  next call to write()
+   *  @return minimum of space available in consumer
+   */
+  virtual offile_off_t avail() const;
+
+  /** processes as many bytes as possible from the given input block.
+   *  The data is copied into the current chunk, which is handed to the I/O
+   *  thread when it is full.  If too much data is queued already, this
+   *  method blocks until the I/O thread has caught up.
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually processed.
+   */
+  virtual offile_off_t write(const void *buf, offile_off_t buflen);
+
+  /** hands the current (incomplete) chunk to the I/O thread
+   */
+  virtual void flush();
+
+private:
+  /// private unimplemented copy constructor
+  DcmWriteBehindConsumer(const DcmWriteBehindConsumer&);
+
+  /// private unimplemented copy assignment operator
+  DcmWriteBehindConsumer& operator=(const DcmWriteBehindConsumer&);
+
+  /// write-behind storage the data is handed to
+  DcmWriteBehindStorage &storage_;
+
+  /// file the data is written to
+  DcmWriteBehindFile *file_;
+
+  /// current chunk, NULL if none
+  unsigned char *chunk_;
+
+  /// number of bytes used in the current chunk
+  size_t chunkUsed_;
+};
+
+
+/** output stream that writes a file in the background, using the I/O thread
+ *  of a DcmWriteBehindStorage object.  Instances of this class are created by
+ *  DcmWriteBehindStorage::createFile() and must be finished with
+ *  DcmWriteBehindStorage::closeFile() or DcmWriteBehindStorage::abortFile().
+ */
+class DCMTK_DCMNET_EXPORT DcmWriteBehindStream: public DcmOutputStream
+{
+public:
+  /// destructor
+  virtual ~DcmWriteBehindStream();
+
+  /** returns the file written by this stream
+   *  @return file written by this stream
+   */
+  DcmWriteBehindFile *file() const { return file_; }
+
+private:
+  friend class DcmWriteBehindStorage;
+
+  /** constructor
+   *  @param storage write-behind storage the data is handed to
+   *  @param file file the data is written to
+   */
+  DcmWriteBehindStream(DcmWriteBehindStorage &storage, DcmWriteBehindFile *file);
+
+  /// private unimplemented copy constructor
+  DcmWriteBehindStream(const DcmWriteBehindStream&);
+
+  /// private unimplemented copy assignment operator
+  DcmWriteBehindStream& operator=(const DcmWriteBehindStream&);
+
+  /// file written by this stream
+  DcmWriteBehindFile *file_;
+
+  /// the final consumer of the filter chain
+  DcmWriteBehindConsumer consumer_;
+};
+
+
+/** Write-behind storage for received DICOM files.  The data written to a file
+ *  created by this class is queued to a dedicated I/O thread, so the thread
+ *  receiving the data from the network does not have to wait for the file
+ *  system (e.g.\ small synchronous writes to a network file system).
+ *  The durability of the files can be configured (see setSyncMode()): the
+ *  files can be synchronized to disk (i.e.\ using fsync()) one by one, or in
+ *  batches, i.e.\ all files closed while the I/O thread was busy are synchronized
+ *  together.  Furthermore, sync() synchronizes all files closed so far, e.g.\ at
+ *  the end of a study.  The point in time when closeFile() returns, and therefore
+ *  the response to a C-STORE request can be sent, is configured separately (see
+ *  setCompletionMode()).
+ *  In order to use this class for all files received with DIMSE_storeProvider(),
+ *  start() an instance and assign it to the global variable dcmWriteBehindStorage.
+ */
+class DCMTK_DCMNET_EXPORT DcmWriteBehindStorage: private OFThread
+{
+public:
+
+  /** modes for synchronizing the files written to disk
+   */
+  enum E_SyncMode
+  {
+    /// never synchronize files, leave this to the operating system
+    WSM_None,
+    /// synchronize all files closed while the I/O thread was busy together,
+    /// but not more than the maximum batch size (see setMaxBatchSize())
+    WSM_Batch,
+    /// synchronize each file when it is closed
+    WSM_EachFile,
+    /// synchronize files only when sync() is called (e.g.\ at end of study)
+    WSM_OnRequest
+  };
+
+  /** modes specifying when closeFile() returns
+   */
+  enum E_CompletionMode
+  {
+    /// return as soon as all data has been queued to the I/O thread.
+    /// Write errors are only logged.
+    WCM_Queued,
+    /// return when the file has been written and closed (or flushed to the
+    /// operating system, if it still has to be synchronized)
+    WCM_Written,
+    /// return when the file has been written and synchronized to disk according
+    /// to the sync mode.  Same as WCM_Written for WSM_None and WSM_OnRequest.
+    WCM_Synced
+  };
+
+  /** default constructor
+   */
+  DcmWriteBehindStorage();
+
+  /** destructor.  Stops the I/O thread (see stop()).
+   */
+  virtual ~DcmWriteBehindStorage();
+
+  /** set the mode for synchronizing the files written to disk.
+   *  Must be called before start().  The default is WSM_Batch.
+   *  @param mode sync mode
+   */
+  void setSyncMode(const E_SyncMode mode);
+
+  /** get the mode for synchronizing the files written to disk
+   *  @return sync mode
+   */
+  E_SyncMode getSyncMode() const;
+
+  /** set the maximum number of files synchronized together in sync mode
+   *  WSM_Batch.  Must be called before start().  The default is 64.
+   *  @param maxFiles maximum number of files per batch (at least 1)
+   */
+  void setMaxBatchSize(const size_t maxFiles);
+
+  /** get the maximum number of files synchronized together in sync mode
+   *  WSM_Batch
+   *  @return maximum number of files per batch
+   */
+  size_t getMaxBatchSize() const;
+
+  /** set the mode specifying when closeFile() returns.
+   *  Must be called before start().  The default is WCM_Written.
+   *  @param mode completion mode
+   */
+  void setCompletionMode(const E_CompletionMode mode);
+
+  /** get the mode specifying when closeFile() returns
+   *  @return completion mode
+   */
+  E_CompletionMode getCompletionMode() const;
+
+  /** set the maximum amount of data queued to the I/O thread.  If this limit
+   *  is reached, writing to a file blocks until the I/O thread has caught up.
+   *  Must be called before start().  The default is 64 MB.
+   *  @param maxBytes maximum number of bytes queued (at least 64 kB)
+   */
+  void setMaxQueuedBytes(const size_t maxBytes);
+
+  /** get the maximum amount of data queued to the I/O thread
+   *  @return maximum number of bytes queued
+   */
+  size_t getMaxQueuedBytes() const;
+
+  /** start the I/O thread
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition start();
+
+  /** write all queued data, synchronize all files (unless sync mode is WSM_None)
+   *  and stop the I/O thread.  Does nothing if the thread is not running.
+   */
+  void stop();
+
+  /** create a file (or truncate an existing one) and return a stream for
+   *  writing to it in the background.  The file is opened immediately so that
+   *  any error is reported at once.
+   *  @param filename name of the file
+   *  @param stream returns the stream, NULL in case of error
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition createFile(const OFFilename &filename,
+                         DcmWriteBehindStream *&stream);
+
+  /** close a file created with createFile() and delete the stream.  Waits
+   *  according to the completion mode.
+   *  @param stream stream to be closed, set to NULL
+   *  @return EC_Normal if successful, an error code if the data could not be
+   *    written (not reported in completion mode WCM_Queued, since this method
+   *    returns before any error is known)
+   */
+  OFCondition closeFile(DcmWriteBehindStream *&stream);
+
+  /** discard a file created with createFile(), i.e.\ the file is closed and
+   *  deleted by the I/O thread, and delete the stream.  Does not wait.
+   *  @param stream stream to be discarded, set to NULL
+   */
+  void abortFile(DcmWriteBehindStream *&stream);
+
+  /** write all queued data and synchronize all files closed so far, e.g.\ at the
+   *  end of a study.  Waits until this has been done.  Does nothing in sync mode
+   *  WSM_None except for waiting.
+   *  @return EC_Normal if successful, an error code if any file could not be
+   *    written or synchronized since the last call of this method
+   */
+  OFCondition sync();
+
+  /** get the number of files written (and closed) so far
+   *  @return number of files
+   */
+  size_t getNumFilesWritten();
+
+  /** get the number of times files have been synchronized to disk, i.e.\ the
+   *  number of batches in sync mode WSM_Batch
+   *  @return number of synchronizations
+   */
+  size_t getNumSyncs();
+
+protected:
+
+  /** main function of the I/O thread
+   */
+  virtual void run();
+
+private:
+
+  friend class DcmWriteBehindConsumer;
+
+  /// a job for the I/O thread
+  struct Job
+  {
+    /// types of jobs
+    enum E_Type
+    {
+      /// write a chunk of data
+      JT_Write,
+      /// close a file
+      JT_Close,
+      /// close and delete a file
+      JT_Abort,
+      /// synchronize all files closed so far
+      JT_Sync,
+      /// stop the thread
+      JT_Stop
+    };
+
+    /// type of the job
+    E_Type type;
+    /// file concerned, NULL for JT_Sync and JT_Stop
+    DcmWriteBehindFile *file;
+    /// chunk of data to be written (JT_Write only)
+    unsigned char *data;
+    /// number of bytes in the chunk
+    size_t length;
+    /// semaphore posted when the job is done (JT_Sync only)
+    OFSemaphore *done;
+  };
+
+  /** allocate a new chunk.  Blocks if the maximum amount of queued data has been
+   *  reached.
+   *  @return new chunk of size ChunkSize
+   */
+  unsigned char *allocateChunk();
+
+  /** add a job to the queue of the I/O thread
+   *  @param job job to be added
+   */
+  void addJob(const Job &job);
+
+  /** get the status of the given file
+   *  @param file file to be checked
+   *  @return status of the file, i.e.\ the first error that occurred
+   */
+  OFCondition fileStatus(DcmWriteBehindFile *file);
+
+  /** record the given error for the given file (unless there is an error already)
+   *  @param file file concerned
+   *  @param error error to be recorded
+   */
+  void setFileError(DcmWriteBehindFile *file, const OFCondition &error);
+
+  /** release one reference to the given file and delete it if it was the last one
+   *  @param file file to be released
+   */
+  void releaseFile(DcmWriteBehindFile *file);
+
+  /** close the given file after all its data has been written, i.e.\ synchronize
+   *  it if required and notify any waiting thread.  Used by the I/O thread.
+   *  @param file file to be closed
+   */
+  void finishFile(DcmWriteBehindFile *file);
+
+  /** synchronize and close all files waiting for synchronization.  Used by the
+   *  I/O thread.
+   */
+  void syncPendingFiles();
+
+  /** notify the thread waiting in closeFile() (if any) that the file is complete
+   *  @param file file concerned
+   */
+  void completeFile(DcmWriteBehindFile *file);
+
+  /// size of the chunks of data queued to the I/O thread
+  static const size_t ChunkSize;
+
+  /// mode for synchronizing the files
+  E_SyncMode SyncMode;
+  /// maximum number of files synchronized together
+  size_t MaxBatchSize;
+  /// mode specifying when closeFile() returns
+  E_CompletionMode CompletionMode;
+  /// maximum number of bytes queued
+  size_t MaxQueuedBytes;
+  /// OFTrue if the I/O thread is running
+  OFBool Running;
+
+  /// mutex that guards the job queue, the files and the statistics
+  OFMutex Mutex;
+  /// queue of jobs for the I/O thread
+  OFList<Job> Jobs;
+  /// semaphore counting the entries of Jobs
+  OFSemaphore *JobSemaphore;
+  /// semaphore counting the chunks that can still be allocated
+  OFSemaphore *ChunkSemaphore;
+  /// files waiting for synchronization (I/O thread only)
+  OFList<DcmWriteBehindFile *> PendingFiles;
+  /// first error since the last call of sync()
+  OFCondition SyncStatus;
+  /// number of files written so far
+  size_t NumFilesWritten;
+  /// number of synchronizations so far
+  size_t NumSyncs;
+
+  /// private unimplemented copy constructor
+  DcmWriteBehindStorage(const DcmWriteBehindStorage&);
+
+  /// private unimplemented copy assignment operator
+  DcmWriteBehindStorage& operator=(const DcmWriteBehindStorage&);
+};
+
+
+/** Global write-behind storage used by DIMSE_storeProvider() for writing the
+ *  received datasets to file (bit-preserving mode), NULL if files should be
+ *  written directly (default).  The storage must have been started.
+ */
+extern DCMTK_DCMNET_EXPORT OFGlobal<DcmWriteBehindStorage *> dcmWriteBehindStorage;
+
+#endif // WITH_THREADS
+
+#endif // DSTORWB_H
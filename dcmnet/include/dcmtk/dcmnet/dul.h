@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -68,12 +68,14 @@
 #include "dcmtk/ofstd/ofglobal.h"
 #include "dcmtk/ofstd/oftypes.h"
 #include "dcmtk/ofstd/ofcast.h"
+#include "dcmtk/ofstd/offile.h"    /* for offile_off_t */
 #include "dcmtk/dcmnet/extneg.h"
 #include "dcmtk/dcmnet/dicom.h"
 #include "dcmtk/dcmnet/dcuserid.h"
 
 class DcmTransportConnection;
 class DcmTransportLayer;
+struct DcmTransportBuffer;
 class LST_HEAD;
 
 /** Global flag to enable/disable reverse DNS lookup when accepting associations.
@@ -115,6 +117,20 @@ extern DCMTK_DCMNET_EXPORT OFGlobal<const char *> dcmTCPWrapperDaemonName;   /*
  */
 extern DCMTK_DCMNET_EXPORT OFGlobal<unsigned long> dcmEnableBackwardCompatibility;
 
+/** Size (in bytes) of the receive buffer allocated for each association.
+ *  Incoming data is read from the transport connection in chunks of up to
+ *  this size, and PDU headers and bodies are then taken from the buffer,
+ *  which greatly reduces the number of read() calls for small PDUs. PDU
+ *  bodies that are larger than the buffer are read directly into their
+ *  destination. The default matches the default socket buffer size (see
+ *  environment variable TCP_BUFFER_LENGTH). A value of 0 disables the
+ *  receive buffer. The value is copied into each network when it is
+ *  initialized and can be changed per network with DUL_setReceiveBufferSize()
+ *  (or ASC_setReceiveBufferSize()), so changes only affect networks created
+ *  afterwards.
+ */
+extern DCMTK_DCMNET_EXPORT OFGlobal<Uint32> dcmReceiveBufferSize;   /* default 65536 */
+
 typedef void DUL_NETWORKKEY;
 typedef void DUL_ASSOCIATIONKEY;
 typedef unsigned char DUL_PRESENTATIONCONTEXTID;
@@ -380,6 +396,20 @@ DUL_ReceiveAssociationRQ(
   DUL_ASSOCIATIONKEY ** association,
   int activatePDUStorage);
 
+DCMTK_DCMNET_EXPORT OFCondition
+DUL_ReceiveTransportConnection(
+  DUL_NETWORKKEY ** network,
+  DUL_BLOCKOPTIONS block,
+  int timeout,
+  DUL_ASSOCIATESERVICEPARAMETERS * parameters,
+  DUL_ASSOCIATIONKEY ** association,
+  int activatePDUStorage);
+
+DCMTK_DCMNET_EXPORT OFCondition
+DUL_ReadAssociationRQ(
+  DUL_ASSOCIATIONKEY ** association,
+  DUL_ASSOCIATESERVICEPARAMETERS * parameters);
+
 DCMTK_DCMNET_EXPORT OFCondition
 DUL_RejectAssociationRQ(
   DUL_ASSOCIATIONKEY ** association,
@@ -413,6 +443,22 @@ DUL_WritePDVs(DUL_ASSOCIATIONKEY ** association,
         DUL_PDVLIST * pdvList);
 DCMTK_DCMNET_EXPORT OFCondition DUL_NextPDV(DUL_ASSOCIATIONKEY ** association, DUL_PDV * pdv);
 
+/* Functions for writing a PDV whose data is taken directly from a file.
+** DUL_CanWritePDVFromFile returns true if the association uses an
+** unencrypted TCP connection and the system supports sendfile().
+*/
+DCMTK_DCMNET_EXPORT OFBool DUL_CanWritePDVFromFile(DUL_ASSOCIATIONKEY ** association);
+DCMTK_DCMNET_EXPORT OFCondition
+DUL_WritePDVFromFile(DUL_ASSOCIATIONKEY ** association,
+        DUL_PDV * pdv, int fd, offile_off_t offset);
+
+/* Function for writing a PDV whose data is the concatenation of several
+** memory blocks, which are sent without being copied into one buffer.
+*/
+DCMTK_DCMNET_EXPORT OFCondition
+DUL_WritePDVBuffers(DUL_ASSOCIATIONKEY ** association,
+        DUL_PDV * pdv, const DcmTransportBuffer * buffers, int count);
+
 
 /* Miscellaneous functions.
 */
@@ -440,6 +486,8 @@ DCMTK_DCMNET_EXPORT OFString& dumpExtNegList(OFString& str, SOPClassExtendedNego
 
 DCMTK_DCMNET_EXPORT OFBool
 DUL_dataWaiting(DUL_ASSOCIATIONKEY * callerAssociation, int timeout);
+DCMTK_DCMNET_EXPORT OFBool
+DUL_dataBuffered(DUL_ASSOCIATIONKEY * callerAssociation);
 DCMTK_DCMNET_EXPORT int
 DUL_networkSocket(DUL_NETWORKKEY * callerNet);
 DCMTK_DCMNET_EXPORT OFBool
@@ -457,6 +505,10 @@ DCMTK_DCMNET_EXPORT DcmTransportConnection *DUL_getTransportConnection(DUL_ASSOC
 /* change transport layer */
 DCMTK_DCMNET_EXPORT OFCondition DUL_setTransportLayer(DUL_NETWORKKEY *callerNetworkKey, DcmTransportLayer *newLayer, int takeoverOwnership);
 
+/* change/query size of the receive buffer of associations created on this network */
+DCMTK_DCMNET_EXPORT OFCondition DUL_setReceiveBufferSize(DUL_NETWORKKEY *callerNetworkKey, Uint32 size);
+DCMTK_DCMNET_EXPORT Uint32 DUL_getReceiveBufferSize(DUL_NETWORKKEY *callerNetworkKey);
+
 /* activate compatibility mode and callback */
 DCMTK_DCMNET_EXPORT void DUL_activateCompatibilityMode(DUL_ASSOCIATIONKEY *dulassoc, unsigned long mode);
 DCMTK_DCMNET_EXPORT void DUL_activateCallback(DUL_ASSOCIATIONKEY *dulassoc, DUL_ModeCallback *cb);
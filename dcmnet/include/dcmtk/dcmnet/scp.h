@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2009-2014, OFFIS e.V.
+ *  Copyright (C) 2009-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -221,6 +221,20 @@ public:
    */
   void setMaxReceivePDULength(const Uint32 maxRecPDU);
 
+  /** Set size of the receive buffer allocated for each association accepted by the SCP.
+   *  By default, the value of the global dcmReceiveBufferSize is used.
+   *  @param bufferSize [in] The receive buffer size in bytes, 0 disables the buffer
+   */
+  void setReceiveBufferSize(const Uint32 bufferSize);
+
+  /** Set maximum number of operations the SCP is willing to perform asynchronously. If the
+   *  SCU proposes an Asynchronous Operations Window, the SCP accepts the minimum of the
+   *  proposed number of operations invoked and this value (0 means "unlimited"). By default
+   *  (value 1), no Asynchronous Operations Window is accepted.
+   *  @param maxOperations [in] The maximum number of operations performed
+   */
+  void setMaxOperationsPerformed(const Uint16 maxOperations);
+
   /** Set whether waiting for a TCP/IP connection should be blocking or non-blocking.
    *  In non-blocking mode, the networking routines will wait for specified connection
    *  timeout, see setConnectionTimeout() function. In blocking mode, no timeout is set
@@ -309,6 +323,16 @@ public:
    */
   Uint32 getMaxReceivePDULength() const;
 
+  /** Returns size of the receive buffer configured for associations accepted by the SCP
+   *  @return Receive buffer size in bytes (0 means "disabled")
+   */
+  Uint32 getReceiveBufferSize() const;
+
+  /** Returns maximum number of operations the SCP is willing to perform asynchronously
+   *  @return Maximum number of operations performed (0 means "unlimited")
+   */
+  Uint16 getMaxOperationsPerformed() const;
+
   /** Returns whether receiving of TCP/IP connection requests is done in blocking or
    *  unblocking mode
    *  @return DUL_BLOCK if in blocking mode, otherwise DUL_NOBLOCK
@@ -864,6 +888,14 @@ protected:
    */
   virtual OFCondition processAssociationRQ();
 
+  /** Negotiate the association request and either accept or refuse it, i.e.\ the first
+   *  part of processAssociationRQ() without handling any incoming DIMSE commands. If the
+   *  association is refused, it is dropped and destroyed, i.e.\ isConnected() returns
+   *  OFFalse afterwards. Refusing an association does NOT lead to an error.
+   *  @return EC_Normal if association could be processed, error otherwise.
+   */
+  virtual OFCondition acceptOrRefuseAssociationRQ();
+
  /** This function checks all presentation contexts proposed by the SCU whether they are
   *  supported or not. It is not an error if no common presentation context could be
   *  identified with the SCU; only issues like problems in memory management etc. are
@@ -884,6 +916,22 @@ protected:
    */
   virtual void handleAssociation();
 
+  /** Receive a single DIMSE command on the current association and handle it by calling
+   *  handleIncomingCommand(). This is the body of the message loop in handleAssociation().
+   *  @return EC_Normal if the command was received and handled successfully, an error code
+   *    otherwise, e.g.\ DUL_PEERREQUESTEDRELEASE if the peer requested the release of the
+   *    association.
+   */
+  virtual OFCondition receiveAndHandleCommand();
+
+  /** Clean up after the message loop on the current association has finished, i.e.\
+   *  acknowledge a release request or abort the association in case of an error, and
+   *  finally drop and destroy the association.
+   *  @param cond the condition that terminated the message loop, i.e.\ the result of the
+   *    last call of receiveAndHandleCommand()
+   */
+  virtual void terminateAssociation(const OFCondition &cond);
+
   /** Send a DIMSE command and possibly also a dataset from a data object via network to
    *  another DICOM application
    *  @param presID          [in]  Presentation context ID to be used for message
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2012-2014, OFFIS e.V.
+ *  Copyright (C) 2012-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -133,6 +133,21 @@ public:
    */
   void setMaxReceivePDULength(const Uint32 maxRecPDU);
 
+  /** Set size of the receive buffer allocated for each association accepted by the SCP.
+   *  By default, the value of the global dcmReceiveBufferSize is used.
+   *  @param bufferSize [in] The receive buffer size in bytes, 0 disables the buffer
+   */
+  void setReceiveBufferSize(const Uint32 bufferSize);
+
+  /** Set maximum number of operations the SCP is willing to perform asynchronously, i.e.\
+   *  the number of requests an SCU may send without waiting for the corresponding responses.
+   *  If the SCU proposes an Asynchronous Operations Window, the SCP accepts the minimum of
+   *  the proposed number of operations invoked and this value (0 means "unlimited"). By
+   *  default (value 1), no Asynchronous Operations Window is accepted.
+   *  @param maxOperations [in] The maximum number of operations performed
+   */
+  void setMaxOperationsPerformed(const Uint16 maxOperations);
+
   /** Set whether waiting for a TCP/IP connection should be blocking or non-blocking.
    *  In non-blocking mode, the networking routines will wait for specified connection
    *  timeout, see setConnectionTimeout() function. In blocking mode, no timeout is set
@@ -222,6 +237,16 @@ public:
    */
   Uint32 getMaxReceivePDULength() const;
 
+  /** Returns size of the receive buffer configured for associations accepted by the SCP
+   *  @return Receive buffer size in bytes (0 means "disabled")
+   */
+  Uint32 getReceiveBufferSize() const;
+
+  /** Returns maximum number of operations the SCP is willing to perform asynchronously
+   *  @return Maximum number of operations performed (0 means "unlimited")
+   */
+  Uint16 getMaxOperationsPerformed() const;
+
   /** Returns whether receiving of TCP/IP connection requests is done in blocking or
    *  unblocking mode
    *  @return DUL_BLOCK if in blocking mode, otherwise DUL_NOBLOCK
@@ -295,6 +320,13 @@ protected:
   /// association negotiation.
   Uint32 m_maxReceivePDULength;
 
+  /// Size of the receive buffer allocated for each association accepted by the SCP
+  Uint32 m_receiveBufferSize;
+
+  /// Maximum number of operations the SCP is willing to perform asynchronously. The value 1
+  /// (default) means that the SCP does not accept an Asynchronous Operations Window.
+  Uint16 m_maxOperationsPerformed;
+
   /// Blocking mode for TCP/IP connection requests. If non-blocking mode is enabled, the SCP is
   /// waiting for new DIMSE data a specific (m_connectionTimeout) amount of time and then returns
   /// if not data arrives. In blocking mode, the SCP is calling the underlying operating
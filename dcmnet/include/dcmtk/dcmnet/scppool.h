@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2012-2014, OFFIS e.V.
+ *  Copyright (C) 2012-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -112,6 +112,28 @@ public:
        */
       virtual OFCondition workerListen(T_ASC_Association* const assoc) = 0;
 
+      /** Negotiate the given association, i.e.\ accept or refuse it, without
+       *  handling any DIMSE commands. Used in event-driven mode only, see
+       *  DcmBaseSCPPool::setEventDrivenMode(). The default implementation
+       *  returns an error since the mode is not supported.
+       *  @param assoc Pointer to the association that should be negotiated.
+       *         Set to NULL if the association has been refused.
+       *  @return EC_Normal if association was handled properly, error code
+       *          otherwise.
+       */
+      virtual OFCondition workerNegotiate(T_ASC_Association*& assoc);
+
+      /** Receive and handle a single DIMSE command on the given association.
+       *  Used in event-driven mode only, see
+       *  DcmBaseSCPPool::setEventDrivenMode(). The default implementation
+       *  returns an error since the mode is not supported.
+       *  @param assoc Pointer to the association that has data available.
+       *         Set to NULL if the association has been terminated.
+       *  @return EC_Normal if command was handled properly, error code
+       *          otherwise.
+       */
+      virtual OFCondition workerHandleCommand(T_ASC_Association*& assoc);
+
       /// Reference to pool in order to notify pool if thread exits, etc.
       DcmBaseSCPPool& m_pool;
 
@@ -146,6 +168,109 @@ public:
    */
   virtual size_t numThreads(const OFBool onlyBusy);
 
+  /** Set the maximum number of associations that wait for a worker becoming
+   *  available if all workers are busy. The associations have already been
+   *  accepted on TCP/IP level, but the association request is only answered
+   *  when a worker takes over. This way, bursts of association requests can
+   *  be absorbed instead of being rejected. If the list of waiting
+   *  associations is full, further requests are rejected with the reason
+   *  "local limit exceeded". Not used in event-driven mode.
+   *  @param maxWaiting Maximum number of waiting associations. The default
+   *         is 0, i.e.\ associations are rejected immediately if all workers
+   *         are busy.
+   */
+  virtual void setMaxWaitingAssociations(const Uint16 maxWaiting);
+
+  /** Get the maximum number of associations that wait for a worker becoming
+   *  available if all workers are busy.
+   *  @return Maximum number of waiting associations.
+   */
+  virtual Uint16 getMaxWaitingAssociations();
+
+  /** Set the maximum number of seconds an association waits for a worker
+   *  becoming available (see setMaxWaitingAssociations()). Thereafter, the
+   *  association is rejected with the reason "local limit exceeded". While
+   *  associations are waiting, the pool does not wait for new connection
+   *  requests any longer than the remaining time of the first waiting
+   *  association (even in blocking mode), so it is rejected in time.
+   *  @param timeout Maximum number of seconds to wait. The default is 60.
+   */
+  virtual void setWorkersBusyTimeout(const Uint16 timeout);
+
+  /** Get the maximum number of seconds an association waits for a worker
+   *  becoming available.
+   *  @return Maximum number of seconds to wait.
+   */
+  virtual Uint16 getWorkersBusyTimeout();
+
+  /** Get number of associations currently waiting for a worker becoming
+   *  available.
+   *  @return Number of waiting associations
+   */
+  virtual size_t numWaitingAssociations();
+
+  /** Get maximum number of associations that have been waiting for a worker
+   *  at the same time, i.e.\ the peak length of the list of waiting
+   *  associations since the pool was created.
+   *  @return Maximum number of associations waiting at the same time
+   */
+  virtual size_t getPeakWaitingAssociations();
+
+  /** Get total number of associations that had to wait for a worker becoming
+   *  available since the pool was created.
+   *  @return Number of associations that had to wait
+   */
+  virtual size_t getNumQueuedAssociations();
+
+  /** Get total number of associations that have been rejected since the pool
+   *  was created because no worker became available within the timeout.
+   *  @return Number of associations rejected after waiting
+   */
+  virtual size_t getNumTimedOutAssociations();
+
+  /** Enable or disable the event-driven mode. By default, each association
+   *  is run by its own worker thread for its whole lifetime. In event-driven
+   *  mode, the thread calling listen() waits for incoming data on all
+   *  associations (using select()) and hands an association to one of a fixed
+   *  number of worker threads (see setMaxThreads()) only when a DIMSE command
+   *  is available. Thereafter, the association is returned to the listening
+   *  thread. This way, many idle or slow associations can be served by a few
+   *  threads. Please note that, in this mode, an SCP worker object serves
+   *  different associations one after the other, so it should not keep any
+   *  association-specific state. The listening thread only accepts incoming
+   *  TCP connections, the association request is read by a worker as soon
+   *  as it is available. Connections that do not send an association request
+   *  within the ACSE timeout are closed. Must be called before listen().
+   *  @param enabled Enable event-driven mode if OFTrue, disable otherwise.
+   */
+  virtual void setEventDrivenMode(const OFBool enabled);
+
+  /** Get whether the event-driven mode is enabled.
+   *  @return OFTrue if event-driven mode is enabled, OFFalse otherwise.
+   */
+  virtual OFBool getEventDrivenMode();
+
+  /** Set the maximum number of associations served simultaneously in
+   *  event-driven mode. Further association requests are rejected with the
+   *  reason "local limit exceeded". The default is 64. Please note that the
+   *  number of associations might also be limited by the maximum number of
+   *  sockets that can be passed to select() (i.e.\ FD_SETSIZE).
+   *  @param maxAssociations Maximum number of associations, 0 means no limit.
+   */
+  virtual void setMaxAssociations(const Uint16 maxAssociations);
+
+  /** Get the maximum number of associations served simultaneously in
+   *  event-driven mode.
+   *  @return Maximum number of associations, 0 means no limit.
+   */
+  virtual Uint16 getMaxAssociations();
+
+  /** Get number of associations currently served in event-driven mode.
+   *  @return Number of associations currently served (including the ones
+   *          being negotiated or rejected).
+   */
+  virtual size_t numAssociations();
+
   /** Listen for incoming association requests. For each incoming request, a
    *  new thread is started if number of maximum threads is not reached yet.
    *  @return DUL_NOASSOCIATIONREQUEST if no connection is requested during
@@ -185,7 +310,9 @@ protected:
    *  @param assoc The association to be run. Must be not NULL.
    *  @param sharedConfig A DcmSharedSCPConfig object to be used by the worker.
    *  @return EC_Normal if worker could be found and runs the association,
-   *          an error code otherwise.
+   *          or if all workers are busy and the association has been added
+   *          to the list of associations waiting for a worker, an error code
+   *          otherwise.
    */
   OFCondition runAssociation(T_ASC_Association* assoc,
                              const DcmSharedSCPConfig& sharedConfig);
@@ -213,6 +340,96 @@ protected:
 
 private:
 
+  /// Association waiting for a worker becoming available
+  struct WaitingAssociation
+  {
+    /// The association
+    T_ASC_Association* assoc;
+    /// Time the association has been added to the list of waiting ones
+    time_t since;
+  };
+
+  /** Used by worker thread after running an association to take over the
+   *  next association waiting for a worker. If there is none, the worker is
+   *  removed from the pool (see notifyThreadExit()). Both is done within the
+   *  same critical section so that no association can be added to the list
+   *  of waiting ones without any worker being able to take it over.
+   *  @param worker The worker asking for the next association.
+   *  @param result The result of the association run by the worker before.
+   *  @return The next association to be run, or NULL if the worker has to
+   *          exit.
+   */
+  T_ASC_Association* nextWaitingAssociation(DcmBaseSCPWorker* worker,
+                                            OFCondition result);
+
+  /** Reject all associations that have been waiting for a worker for more
+   *  than the configured timeout.
+   */
+  void rejectTimedOutAssociations();
+
+  /** Limit the time to wait for incoming connections so that associations
+   *  waiting for a worker are rejected in time, even if no further
+   *  connection request arrives.
+   *  @param blockMode The blocking mode, set to DUL_NOBLOCK if required.
+   *  @param timeout The timeout in seconds, reduced to the time left until
+   *         the first waiting association times out (at least 1 second).
+   */
+  void limitConnectionTimeout(DUL_BLOCKOPTIONS& blockMode,
+                              int& timeout);
+
+  /// States of an association served in event-driven mode
+  enum dispatchstate
+  {
+    /// TCP connection accepted, association request not yet received
+    CONNECTED,
+    /// Same as CONNECTED, but the association request has to be rejected
+    /// since the maximum number of associations is reached
+    LIMIT_EXCEEDED,
+    /// Association negotiated, DIMSE commands are expected
+    NEGOTIATED
+  };
+
+  /// Association served in event-driven mode
+  struct DispatchedAssociation
+  {
+    /// The association
+    T_ASC_Association* assoc;
+    /// Current state of the association
+    dispatchstate state;
+    /// Time of last activity on the association
+    time_t lastActivity;
+  };
+
+  /** Listen for incoming association requests and dispatch all associations
+   *  with data available to the worker threads (event-driven mode).
+   *  @param network The network to listen on
+   *  @param sharedConfig A DcmSharedSCPConfig object to be used by the workers.
+   *  @return EC_Normal if pool was shut down properly, an error code if the
+   *          worker threads could not be started.
+   */
+  OFCondition dispatchAssociations(T_ASC_Network* network,
+                                   const DcmSharedSCPConfig& sharedConfig);
+
+  /** Used by worker thread in event-driven mode to wait for the next
+   *  association having data available.
+   *  @param entry Returns the association to be handled.
+   *  @return OFTrue if an association is available, OFFalse if the worker
+   *          should exit.
+   */
+  OFBool waitForDispatchedAssociation(DispatchedAssociation& entry);
+
+  /** Used by worker thread in event-driven mode to return an association
+   *  after handling it.
+   *  @param assoc The association to be returned. NULL if the association
+   *         has been terminated by the worker.
+   */
+  void returnDispatchedAssociation(T_ASC_Association* assoc);
+
+  /** Wake up the thread dispatching the associations in event-driven mode,
+   *  e.g.\ because an association has been returned by a worker.
+   */
+  void wakeupDispatcher();
+
   /// Possible run modes of pool
   enum runmode
   {
@@ -238,14 +455,41 @@ private:
   /// one connection at a time.
   Uint16 m_maxWorkers;
 
-  // Not implemented yet: Can be helpful if all workers are busy but incoming
-  // associations should then not be rejected immediately but only after a
-  // specific timeout
-  // Uint16 m_workersBusyTimeout;
-
-  // Not implemented yet: list of associations that are waiting for a worker
-  // becoming available
-  // OFList<T_ASC_Association*> m_waiting;
+  /// Event-driven mode enabled (OFTrue) or disabled (OFFalse)
+  OFBool m_eventDriven;
+  /// Maximum number of associations served in event-driven mode (0 = unlimited)
+  Uint16 m_maxAssociations;
+  /// Number of associations currently served in event-driven mode
+  size_t m_numAssociations;
+  /// Associations with data available, waiting for a worker (event-driven mode)
+  OFList<DispatchedAssociation> m_readyAssociations;
+  /// Associations returned by a worker, waiting for data (event-driven mode)
+  OFList<T_ASC_Association*> m_returnedAssociations;
+  /// Semaphore counting the entries of m_readyAssociations (event-driven mode)
+  OFSemaphore m_readySemaphore;
+  /// UDP socket connected to itself used to wake up the dispatching thread
+  /// (event-driven mode), -1 if not available
+  int m_wakeupSocket;
+
+  /// Maximum number of seconds an association waits for a worker becoming
+  /// available before it is rejected
+  Uint16 m_workersBusyTimeout;
+
+  /// Maximum number of associations that wait for a worker becoming available
+  /// (0 = associations are rejected immediately if all workers are busy)
+  Uint16 m_maxWaiting;
+
+  /// List of associations that are waiting for a worker becoming available
+  OFList<WaitingAssociation> m_waiting;
+
+  /// Maximum number of associations that waited at the same time
+  size_t m_peakWaiting;
+
+  /// Total number of associations that had to wait for a worker
+  size_t m_numQueued;
+
+  /// Total number of associations rejected after waiting for the timeout
+  size_t m_numTimedOut;
 
   /// Current run mode of pool
   runmode m_runMode;
@@ -254,10 +498,14 @@ private:
 /** Implementation of DICOM SCP server pool. The pool waits for incoming
  *  TCP/IP connection requests, accepts them on TCP/IP level and hands the
  *  connection to a worker thread. The maximum number of worker threads, i.e.
- *  simultaneous connections, is configurable. The default is 5. At the moment,
- *  if no free worker slots are available, an incoming request is rejected with
- *  the error "local limit exceeded", i.e. those requests are not queued. This
- *  behaviour might change in the future.
+ *  simultaneous connections, is configurable. The default is 5. If no free
+ *  worker slots are available, an incoming request is rejected with the error
+ *  "local limit exceeded" unless waiting for a worker is enabled (see
+ *  setMaxWaitingAssociations()), in which case the request is queued for a
+ *  configurable time. In event-driven mode (see
+ *  setEventDrivenMode()), a fixed number of worker threads serves up to
+ *  setMaxAssociations() associations, each of them only while a DIMSE
+ *  command is available on the association.
  *  @tparam SCP the service class provider to be instantiated for each request,
  *    should follow the @ref SCPThread_Concept.
  *  @tparam SCPPool the base SCP pool class to use. Use this parameter if you
@@ -324,6 +572,24 @@ private:
         {
             return SCP::run(assoc);
         }
+
+        /** Negotiate an already accepted (TCP/IP) connection (event-driven mode).
+         *  @param assoc The association to be negotiated, set to NULL if refused
+         *  @return Returns the result of the underlying SCP implementation.
+         */
+        virtual OFCondition workerNegotiate(T_ASC_Association*& assoc)
+        {
+            return SCP::runNegotiation(assoc);
+        }
+
+        /** Handle a single DIMSE command on the association (event-driven mode).
+         *  @param assoc The association to be used, set to NULL if terminated
+         *  @return Returns the result of the underlying SCP implementation.
+         */
+        virtual OFCondition workerHandleCommand(T_ASC_Association*& assoc)
+        {
+            return SCP::runNextCommand(assoc);
+        }
     };
 
     /** Create a worker to be used for handling a request.
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2013, OFFIS e.V.
+ *  Copyright (C) 2013-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -58,6 +58,33 @@ public:
    */
   virtual OFCondition run(T_ASC_Association* incomingAssoc);
 
+  /** Negotiate an already established (on TCP/IP level) connection, i.e.\ accept or
+   *  refuse the association request, but do not handle any DIMSE commands. This
+   *  function is used by an event-driven thread pool that hands an association to
+   *  any of its workers only when data is available. Therefore, this SCP object does
+   *  not keep the association after returning from this function.
+   *  @param assoc the association of the connection. Set to NULL if the association
+   *    has been refused (and, therefore, dropped and destroyed).
+   *  @return DIMSE_ILLEGALASSOCIATION if the given association is not valid or this
+   *    SCP is already connected, EC_Normal otherwise (also if the association has
+   *    been refused).
+   */
+  virtual OFCondition runNegotiation(T_ASC_Association*& assoc);
+
+  /** Receive and handle a single DIMSE command on an association that has been
+   *  negotiated by runNegotiation() before, possibly by another SCP object. The
+   *  caller should make sure that data is available on the association since the
+   *  command is received using the configured DIMSE blocking mode and timeout.
+   *  If the association is released, aborted or an error occurs, the association is
+   *  terminated in the same way as within run().
+   *  @param assoc the association to receive the command from. Set to NULL if the
+   *    association has been terminated (and, therefore, dropped and destroyed).
+   *  @return DIMSE_ILLEGALASSOCIATION if the given association is not valid or this
+   *    SCP is already connected, EC_Normal otherwise (also if the association has
+   *    been terminated).
+   */
+  virtual OFCondition runNextCommand(T_ASC_Association*& assoc);
+
   /** Get access to the DcmSharedSCPConfig object. The shared configuration can be used
    *  to provide other SCPs with the same configuration without the need to copy it.
    *  @return a reference to the DcmSharedSCPConfig object used by this DcmSCP object.
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2008-2014, OFFIS e.V.
+ *  Copyright (C) 2008-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -288,7 +288,9 @@ public:
    *                               message ID.
    *  @return EC_Normal if request could be issued and response was received successfully,
    *          error code otherwise. That means that if the receiver sends a response denoting
-   *          failure of the storage request, EC_Normal will be returned.
+   *          failure of the storage request, EC_Normal will be returned. If there are still
+   *          requests sent with sendSTORERequestAsync() awaiting their response,
+   *          NET_EC_OutstandingRequests is returned.
    */
   virtual OFCondition sendSTORERequest(const T_ASC_PresentationContextID presID,
                                        const OFString &dicomFile,
@@ -297,6 +299,50 @@ public:
                                        const OFString &moveOriginatorAETitle = "",
                                        const Uint16 moveOriginatorMsgID = 0);
 
+  /** Sends a C-STORE request on the given presentation context but does not wait for the
+   *  corresponding response. This allows for sending further requests (up to the number of
+   *  operations invoked negotiated in the Asynchronous Operations Window) before receiving
+   *  the responses with receiveSTOREResponse(). The message ID of each request sent is
+   *  recorded internally until the matching response has been received.
+   *  @param presID        [in]  The ID of the presentation context to be used. If 0 is
+   *                             given, the function tries to find an appropriate context
+   *                             itself. See sendSTORERequest() for details.
+   *  @param dicomFile     [in]  The filename of the DICOM file to be sent. Alternatively, a
+   *                             dataset can be given in the next parameter.
+   *  @param dataset       [in]  The dataset to be sent. Alternatively, a filename can be
+   *                             specified in the previous parameter.
+   *  @param messageID     [out] The message ID of the C-STORE request sent
+   *  @param moveOriginatorAETitle [in] If this C-STORE is started due to a C-MOVE request,
+   *                               this parameter informs the C-STORE SCP about the C-MOVE
+   *                               client's AE title.
+   *  @param moveOriginatorMsgID   [in] If this C-STORE is started due to a C-MOVE request,
+   *                               this parameter informs the C-STORE SCP about the C-MOVE
+   *                               message ID.
+   *  @return EC_Normal if request could be sent successfully, NET_EC_AsyncOperationsWindowFull
+   *          if the maximum number of outstanding requests has already been reached, another
+   *          error code otherwise.
+   */
+  virtual OFCondition sendSTORERequestAsync(const T_ASC_PresentationContextID presID,
+                                            const OFString &dicomFile,
+                                            DcmDataset *dataset,
+                                            Uint16 &messageID,
+                                            const OFString &moveOriginatorAETitle = "",
+                                            const Uint16 moveOriginatorMsgID = 0);
+
+  /** Receives the response to a C-STORE request previously sent with
+   *  sendSTORERequestAsync(). Responses may arrive in any order, so the message ID of the
+   *  request this response belongs to is returned to the caller.
+   *  @param messageID     [out] The message ID of the request this response refers to
+   *  @param rspStatusCode [out] The response status code received. 0 means success, others
+   *                             can be found in the DICOM standard.
+   *  @return EC_Normal if a response to an outstanding request was received successfully,
+   *          NET_EC_UnexpectedMessageID if the response does not match any outstanding
+   *          request, an error code otherwise. As for sendSTORERequest(), EC_Normal is also
+   *          returned if the receiver sends a response denoting failure of the request.
+   */
+  virtual OFCondition receiveSTOREResponse(Uint16 &messageID,
+                                           Uint16 &rspStatusCode);
+
   /** Sends a C-MOVE Request on given presentation context and receives list of responses.
    *  The function receives the first response and then calls the function handleMOVEResponse()
    *  which gets the relevant presentation context together with the response dataset and
@@ -581,6 +627,21 @@ public:
    */
   void setMaxReceivePDULength(const Uint32 maxRecPDU);
 
+  /** Set size of the receive buffer allocated for the association(s) of this SCU.
+   *  By default, the value of the global dcmReceiveBufferSize is used. The setting
+   *  takes effect with the next call of initNetwork().
+   *  @param bufferSize [in] The receive buffer size in bytes, 0 disables the buffer
+   */
+  void setReceiveBufferSize(const Uint32 bufferSize);
+
+  /** Set maximum number of operations (e.g.\ C-STORE requests) that this SCU would like to
+   *  invoke asynchronously, i.e.\ without waiting for the corresponding responses. A value
+   *  other than 1 is proposed to the SCP in the Asynchronous Operations Window sub-item of
+   *  the association request, where 0 means "unlimited". Must be called before initNetwork().
+   *  @param maxOperations [in] The maximum number of operations invoked (default: 1)
+   */
+  void setMaxOperationsInvoked(const Uint16 maxOperations);
+
   /** Set whether to send in DIMSE blocking or non-blocking mode
    *  @param blockingMode [in] Either blocking or non-blocking mode
    */
@@ -684,6 +745,31 @@ public:
    */
   Uint32 getMaxReceivePDULength() const;
 
+  /** Returns size of the receive buffer configured for the association(s) of this SCU
+   *  @return Receive buffer size in bytes (0 means "disabled")
+   */
+  Uint32 getReceiveBufferSize() const;
+
+  /** Returns maximum number of operations invoked configured for this SCU
+   *  @return Maximum number of operations invoked (0 means "unlimited")
+   */
+  Uint16 getMaxOperationsInvoked() const;
+
+  /** Returns the maximum number of operations that may be invoked asynchronously on the
+   *  current association, i.e.\ the number of requests that can be outstanding at the same
+   *  time. This is the minimum of the value proposed by this SCU and the one accepted by the
+   *  SCP. If no Asynchronous Operations Window has been negotiated, 1 is returned.
+   *  @return Negotiated maximum number of operations invoked (0 means "unlimited"), or
+   *    1 if there is no current association
+   */
+  Uint16 getNegotiatedMaxOperationsInvoked() const;
+
+  /** Returns the number of requests sent with sendSTORERequestAsync() for which no response
+   *  has been received yet
+   *  @return Number of outstanding requests
+   */
+  size_t getNumberOfOutstandingRequests() const;
+
   /** Returns whether DIMSE messaging is configured to be blocking or unblocking
    *  @return The blocking mode configured
    */
@@ -1021,6 +1107,15 @@ private:
   /// Maximum PDU size (default: 16384 bytes)
   Uint32 m_maxReceivePDULength;
 
+  /// Receive buffer size (default: value of dcmReceiveBufferSize)
+  Uint32 m_receiveBufferSize;
+
+  /// Maximum number of operations invoked asynchronously (default: 1)
+  Uint16 m_maxOperationsInvoked;
+
+  /// Message IDs of requests sent asynchronously that are still awaiting their response
+  OFList<Uint16> m_outstandingRequests;
+
   /// DIMSE blocking mode (default: blocking)
   T_DIMSE_BlockingMode m_blockMode;
 
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2013, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -1275,6 +1275,40 @@ void ASC_setAcceptedExtNegList(T_ASC_Parameters* params, SOPClassExtendedNegotia
 }
 
 
+/* Asynchronous Operations Window */
+
+OFCondition
+ASC_setAsyncOperationsWindow(T_ASC_Parameters * params,
+    unsigned short maxOperationsInvoked,
+    unsigned short maxOperationsPerformed)
+{
+    if (params == NULL)
+        return ASC_NULLKEY;
+    params->ourMaxOperationsInvoked = maxOperationsInvoked;
+    params->ourMaxOperationsPerformed = maxOperationsPerformed;
+    return EC_Normal;
+}
+
+OFCondition
+ASC_getAsyncOperationsWindow(T_ASC_Parameters * params,
+    unsigned short& maxOperationsInvoked,
+    unsigned short& maxOperationsPerformed)
+{
+    if (params == NULL)
+        return ASC_NULLKEY;
+    if ((params->theirMaxOperationsInvoked == 0) && (params->theirMaxOperationsPerformed == 0))
+    {
+        /* sub-item not received, use the default (synchronous operation) */
+        maxOperationsInvoked = 1;
+        maxOperationsPerformed = 1;
+    } else {
+        maxOperationsInvoked = params->theirMaxOperationsInvoked;
+        maxOperationsPerformed = params->theirMaxOperationsPerformed;
+    }
+    return EC_Normal;
+}
+
+
 /* User Identity Negotiation */
 void ASC_getUserIdentRQ(T_ASC_Parameters* params, UserIdentityNegotiationSubItemRQ** usrIdentRQ)
 {
@@ -1548,6 +1582,17 @@ ASC_dumpParameters(OFString& str, T_ASC_Parameters * params, ASC_associateType d
         << "Their Max PDU Receive Size:  "
         << params->theirMaxPDUReceiveSize << OFendl;
 
+    if ((params->ourMaxOperationsInvoked != 0) || (params->ourMaxOperationsPerformed != 0) ||
+        (params->theirMaxOperationsInvoked != 0) || (params->theirMaxOperationsPerformed != 0))
+    {
+        outstream << "Our Async Operations Window:   "
+            << params->ourMaxOperationsInvoked << " invoked, "
+            << params->ourMaxOperationsPerformed << " performed" << OFendl
+            << "Their Async Operations Window: "
+            << params->theirMaxOperationsInvoked << " invoked, "
+            << params->theirMaxOperationsPerformed << " performed" << OFendl;
+    }
+
     outstream << "Presentation Contexts:" << OFendl;
     for (i=0; i<ASC_countPresentationContexts(params); i++) {
         ASC_getPresentationContext(params, i, &pc);
@@ -1633,12 +1678,25 @@ ASC_selectReadableAssociation(T_ASC_Association* assocs[],
   if (connections == NULL) return OFFalse;
 
   int i;
+  OFBool buffered = OFFalse;
   for (i=0; i<assocCount; i++)
   {
     if (assocs[i]) connections[i] = DUL_getTransportConnection(assocs[i]->DULassociation);
     else connections[i] = NULL;
+    /* data already received by the DUL layer is not visible on the connection */
+    if (assocs[i] && DUL_dataBuffered(assocs[i]->DULassociation)) buffered = OFTrue;
+  }
+  OFBool result;
+  if (buffered)
+  {
+    /* return the associations with buffered data without waiting */
+    for (i=0; i<assocCount; i++)
+    {
+      if (assocs[i] && !DUL_dataBuffered(assocs[i]->DULassociation)) connections[i] = NULL;
+    }
+    result = OFTrue;
   }
-  OFBool result = DcmTransportConnection::selectReadableAssociation(connections, assocCount, timeout);
+  else result = DcmTransportConnection::selectReadableAssociation(connections, assocCount, timeout);
   if (result)
   {
     for (i=0; i<assocCount; i++)
@@ -1728,13 +1786,26 @@ ASC_receiveAssociation(T_ASC_Network * network,
                        DUL_BLOCKOPTIONS block,
                        int timeout)
 {
-    T_ASC_Parameters *params;
-    DUL_ASSOCIATIONKEY *DULassociation;
-    DUL_PRESENTATIONCONTEXT *pc;
-    LST_HEAD **l;
+    const OFBool retrieveRawPDU = (associatePDU && associatePDUlength) ? OFTrue : OFFalse;
 
-    int retrieveRawPDU = 0;
-    if (associatePDU && associatePDUlength) retrieveRawPDU = 1;
+    OFCondition cond = ASC_receiveTransportConnection(network, assoc, maxReceivePDUSize,
+                                                      useSecureLayer, block, timeout, retrieveRawPDU);
+    if (cond.bad() || (cond.code() == DULC_FORKEDCHILD)) return cond;
+
+    return ASC_readAssociationRequest(*assoc, associatePDU, associatePDUlength);
+}
+
+OFCondition
+ASC_receiveTransportConnection(T_ASC_Network * network,
+                               T_ASC_Association ** assoc,
+                               long maxReceivePDUSize,
+                               OFBool useSecureLayer,
+                               DUL_BLOCKOPTIONS block,
+                               int timeout,
+                               OFBool retrieveRawPDU)
+{
+    T_ASC_Parameters *params;
+    DUL_ASSOCIATIONKEY *DULassociation = NULL;
 
     OFCondition cond = ASC_createAssociationParameters(&params, maxReceivePDUSize);
     if (cond.bad()) return cond;
@@ -1757,8 +1828,8 @@ ASC_receiveAssociation(T_ASC_Network * network,
     (*assoc)->params = params;
     (*assoc)->nextMsgID = 1;
 
-    cond = DUL_ReceiveAssociationRQ(&network->network, block, timeout,
-                                    &(params->DULparams), &DULassociation, retrieveRawPDU);
+    cond = DUL_ReceiveTransportConnection(&network->network, block, timeout,
+                                          &(params->DULparams), &DULassociation, retrieveRawPDU ? 1 : 0);
 
     if (cond.code() == DULC_FORKEDCHILD)
     {
@@ -1770,9 +1841,26 @@ ASC_receiveAssociation(T_ASC_Network * network,
 
     (*assoc)->DULassociation = DULassociation;
 
-    if (retrieveRawPDU && DULassociation)
+    return cond;
+}
+
+OFCondition
+ASC_readAssociationRequest(T_ASC_Association * assoc,
+                           void **associatePDU,
+                           unsigned long *associatePDUlength)
+{
+    T_ASC_Parameters *params;
+    DUL_PRESENTATIONCONTEXT *pc;
+    LST_HEAD **l;
+
+    if ((assoc == NULL) || (assoc->params == NULL)) return ASC_NULLKEY;
+    params = assoc->params;
+
+    OFCondition cond = DUL_ReadAssociationRQ(&assoc->DULassociation, &(params->DULparams));
+
+    if (associatePDU && associatePDUlength && assoc->DULassociation)
     {
-      DUL_returnAssociatePDUStorage((*assoc)->DULassociation, *associatePDU, *associatePDUlength);
+      DUL_returnAssociatePDUStorage(assoc->DULassociation, *associatePDU, *associatePDUlength);
     }
 
     if (cond.bad()) return cond;
@@ -1807,9 +1895,19 @@ ASC_receiveAssociation(T_ASC_Network * network,
      */
     params->theirMaxPDUReceiveSize = params->DULparams.peerMaxPDU;
 
+    /*
+     * Remember the asynchronous operations window proposed by the requestor.
+     * By default, the acceptor does not return this sub-item, i.e. all
+     * operations are performed synchronously.
+     */
+    params->theirMaxOperationsInvoked = params->DULparams.maximumOperationsInvoked;
+    params->theirMaxOperationsPerformed = params->DULparams.maximumOperationsPerformed;
+    params->DULparams.maximumOperationsInvoked = 0;
+    params->DULparams.maximumOperationsPerformed = 0;
+
     /* the PDV buffer and length get set when we acknowledge the association */
-    (*assoc)->sendPDVLength = 0;
-    (*assoc)->sendPDVBuffer = NULL;
+    assoc->sendPDVLength = 0;
+    assoc->sendPDVBuffer = NULL;
 
     return EC_Normal;
 }
@@ -1903,6 +2001,8 @@ ASC_requestAssociation(T_ASC_Network * network,
         params->ourImplementationClassUID);
     strcpy(params->DULparams.callingImplementationVersionName,
         params->ourImplementationVersionName);
+    params->DULparams.maximumOperationsInvoked = params->ourMaxOperationsInvoked;
+    params->DULparams.maximumOperationsPerformed = params->ourMaxOperationsPerformed;
 
     cond = DUL_RequestAssociation(&network->network, block, timeout,
                                   &(*assoc)->params->DULparams,
@@ -1924,6 +2024,10 @@ ASC_requestAssociation(T_ASC_Network * network,
         */
         params->theirMaxPDUReceiveSize = params->DULparams.peerMaxPDU;
 
+        /* the asynchronous operations window accepted by the acceptor (if any) */
+        params->theirMaxOperationsInvoked = params->DULparams.maximumOperationsInvoked;
+        params->theirMaxOperationsPerformed = params->DULparams.maximumOperationsPerformed;
+
         if (!((params->theirMaxPDUReceiveSize & DUL_MAXPDUCOMPAT) ^ DUL_DULCOMPAT))
         {
           /* activate compatibility with DCMTK releases prior to 3.0 */
@@ -2002,6 +2106,16 @@ ASC_acknowledgeAssociation(
     strcpy(assoc->params->DULparams.calledImplementationVersionName,
         assoc->params->ourImplementationVersionName);
 
+    /* only return an asynchronous operations window if it was proposed */
+    if ((assoc->params->theirMaxOperationsInvoked != 0) || (assoc->params->theirMaxOperationsPerformed != 0))
+    {
+        assoc->params->DULparams.maximumOperationsInvoked = assoc->params->ourMaxOperationsInvoked;
+        assoc->params->DULparams.maximumOperationsPerformed = assoc->params->ourMaxOperationsPerformed;
+    } else {
+        assoc->params->DULparams.maximumOperationsInvoked = 0;
+        assoc->params->DULparams.maximumOperationsPerformed = 0;
+    }
+
     OFCondition cond = DUL_AcknowledgeAssociationRQ(&assoc->DULassociation,
                                         &assoc->params->DULparams,
                                         retrieveRawPDU);
@@ -2162,6 +2276,20 @@ ASC_setTransportLayer(T_ASC_Network *network, DcmTransportLayer *newLayer, int t
   return DUL_setTransportLayer(network->network, newLayer, takeoverOwnership);
 }
 
+OFCondition
+ASC_setReceiveBufferSize(T_ASC_Network *network, Uint32 size)
+{
+  if (network == NULL) return ASC_NULLKEY;
+  return DUL_setReceiveBufferSize(network->network, size);
+}
+
+Uint32
+ASC_getReceiveBufferSize(T_ASC_Network *network)
+{
+  if (network == NULL) return 0;
+  return DUL_getReceiveBufferSize(network->network);
+}
+
 unsigned long ASC_getPeerCertificateLength(T_ASC_Association *assoc)
 {
   if (assoc==NULL) return 0;
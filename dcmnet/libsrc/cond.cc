@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -83,6 +83,9 @@ makeOFConditionConst(NET_EC_NoSOPInstancesToSend,            OFM_dcmnet, 1007, O
 makeOFConditionConst(NET_EC_NoSuchSOPInstance,               OFM_dcmnet, 1008, OF_error, "No such SOP instance");
 makeOFConditionConst(NET_EC_InvalidDatasetPointer,           OFM_dcmnet, 1009, OF_error, "Invalid dataset pointer");
 makeOFConditionConst(NET_EC_AlreadyConnected,                OFM_dcmnet, 1010, OF_error, "Already connected");
+makeOFConditionConst(NET_EC_AsyncOperationsWindowFull,       OFM_dcmnet, 1011, OF_error, "Asynchronous operations window full");
+makeOFConditionConst(NET_EC_UnexpectedMessageID,             OFM_dcmnet, 1012, OF_error, "Unexpected message ID");
+makeOFConditionConst(NET_EC_OutstandingRequests,             OFM_dcmnet, 1013, OF_error, "Outstanding requests");
 makeOFConditionConst(NET_EC_InsufficientPortPrivileges,      OFM_dcmnet, 1023, OF_error, "Insufficient port privileges");
 // codes 1024 to 1073 are used for the association negotiation profile classes
 makeOFConditionConst(NET_EC_SCPBusy,                         OFM_dcmnet, 1074, OF_error, "SCP is busy");
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2003-2012, OFFIS e.V.
+ *  Copyright (C) 2003-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -165,8 +165,8 @@ OFCondition DcmExtendedNegotiationMap::add(
   if (it == map_.end())
   {
     DcmExtendedNegotiationList *newentry = new DcmExtendedNegotiationList();
-    map_.insert(OFPair<OFString, DcmExtendedNegotiationList*>(skey, newentry));
-    value = &newentry;
+    // point to the map entry, not to the local variable which goes out of scope
+    value = &((*map_.insert(OFPair<OFString, DcmExtendedNegotiationList*>(skey, newentry)).first).second);
   }
   else
   {
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2003-2010, OFFIS e.V.
+ *  Copyright (C) 2003-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -127,8 +127,8 @@ OFCondition DcmRoleSelectionMap::add(
   if (it == map_.end())
   {
     DcmRoleSelectionList *newentry = new DcmRoleSelectionList();
-    map_.insert(OFPair<OFString, DcmRoleSelectionList*>(skey, newentry));
-    value = &newentry;
+    // point to the map entry, not to the local variable which goes out of scope
+    value = &((*map_.insert(OFPair<OFString, DcmRoleSelectionList*>(skey, newentry)).first).second);
   }
   else
   {
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1998-2012, OFFIS e.V.
+ *  Copyright (C) 1998-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -43,6 +43,9 @@ BEGIN_EXTERN_C
 #ifdef HAVE_SYS_SELECT_H
 #include <sys/select.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>       /* for writev() */
+#endif
 END_EXTERN_C
 
 #ifdef HAVE_WINDOWS_H
@@ -218,6 +221,20 @@ OFBool DcmTransportConnection::selectReadableAssociation(DcmTransportConnection
   return safeSelectReadableAssociation(connections, connCount, timeout);
 }
 
+ssize_t DcmTransportConnection::writev(const DcmTransportBuffer *buffers, int count)
+{
+  ssize_t total = 0;
+  for (int i = 0; i < count; i++)
+  {
+    if (buffers[i].length == 0) continue;
+    ssize_t nbytes = write(buffers[i].data, buffers[i].length);
+    if (nbytes < 0) return (total > 0) ? total : nbytes;
+    total += nbytes;
+    if (OFstatic_cast(size_t, nbytes) != buffers[i].length) break;
+  }
+  return total;
+}
+
 void DcmTransportConnection::dumpConnectionParameters(STD_NAMESPACE ostream& out)
 {
     OFString str;
@@ -269,6 +286,36 @@ ssize_t DcmTCPConnection::write(void *buf, size_t nbyte)
 #endif
 }
 
+ssize_t DcmTCPConnection::writev(const DcmTransportBuffer *buffers, int count)
+{
+#if defined(HAVE_SYS_UIO_H) && !defined(HAVE_WINSOCK_H)
+  /* DcmTransportBuffer has the same members as struct iovec, but their order is unspecified */
+  struct iovec vec[64];
+  ssize_t total = 0;
+  while (count > 0)
+  {
+    /* pass at most 64 buffers to the system at a time */
+    int n = (count > 64) ? 64 : count;
+    size_t requested = 0;
+    for (int i = 0; i < n; i++)
+    {
+      vec[i].iov_base = buffers[i].data;
+      vec[i].iov_len = buffers[i].length;
+      requested += buffers[i].length;
+    }
+    ssize_t nbytes = ::writev(getSocket(), vec, n);
+    if (nbytes < 0) return (total > 0) ? total : nbytes;
+    total += nbytes;
+    if (OFstatic_cast(size_t, nbytes) != requested) break;
+    buffers += n;
+    count -= n;
+  }
+  return total;
+#else
+  return DcmTransportConnection::writev(buffers, count);
+#endif
+}
+
 void DcmTCPConnection::close()
 {
   if (getSocket() != -1)
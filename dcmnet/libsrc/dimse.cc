@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2014, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -109,7 +109,8 @@
 #include "dcmtk/dcmdata/dcfilefo.h"    /* for class DcmFileFormat */
 #include "dcmtk/dcmdata/dcmetinf.h"    /* for class DcmMetaInfo */
 #include "dcmtk/dcmdata/dcistrmb.h"    /* for class DcmInputBufferStream */
-#include "dcmtk/dcmdata/dcostrmb.h"    /* for class DcmOutputBufferStream */
+#include "dcmtk/dcmdata/dcistrmf.h"    /* for class DcmInputFileStream */
+#include "dcmtk/dcmdata/dcostrma.h"    /* for class DcmOutputStream */
 #include "dcmtk/dcmdata/dcostrmf.h"    /* for class DcmOutputFileStream */
 #include "dcmtk/dcmdata/dcvrul.h"      /* for class DcmUnsignedLong */
 #include "dcmtk/dcmdata/dcvrobow.h"    /* for class DcmOtherByteOtherWord */
@@ -118,6 +119,9 @@
 #include "dcmtk/dcmdata/dcdicent.h"    /* for DcmDictEntry, needed for MSVC5 */
 #include "dcmtk/dcmdata/dcwcache.h"    /* for class DcmWriteCache */
 #include "dcmtk/dcmdata/dcvrui.h"      /* for class DcmUniqueIdentifier */
+#include "dcmtk/dcmnet/dstorwb.h"      /* for class DcmWriteBehindStorage */
+#include "dcmtk/dcmnet/dcmtrans.h"     /* for struct DcmTransportBuffer */
+#include "dcmtk/ofstd/ofvector.h"
 
 
 /*
@@ -132,6 +136,13 @@
  */
 OFGlobal<Uint32> dcmMaxOutgoingPDUSize((Uint32) -1);
 
+/*  global flag specifying whether instance data that is sent from a file
+ *  (DIMSE_sendMessageUsingFileData) may be sent as stored in the file,
+ *  i.e. without parsing and re-encoding it, if the transfer syntax of the
+ *  file matches the presentation context.
+ */
+OFGlobal<OFBool> dcmSendStraightFileData(OFFalse);
+
 /*
  * Other global variables (should be used very, very rarely).
  * Modification of this variables is THREAD UNSAFE.
@@ -154,6 +165,156 @@ static unsigned long g_dimse_commandCounter = 0;
 static unsigned long g_dimse_dataCounter = 0;
 
 
+/*
+ * Output stream used by sendDcmDataset(). Small blocks (tags, lengths,
+ * short values) are collected in the association's send buffer, whereas
+ * larger element values that stay in memory are only referenced. The
+ * resulting list of memory blocks is passed to DUL_WritePDVBuffers(), so
+ * the element values are not copied before they are sent.
+ */
+
+class DcmGatherConsumer: public DcmConsumer
+{
+public:
+  /* blocks shorter than this are copied into the send buffer */
+  enum { MinReferenceLength = 1024 };
+
+  DcmGatherConsumer(void *buf, offile_off_t bufLen)
+  : buffer_(OFstatic_cast(unsigned char *, buf))
+  , bufSize_(bufLen)
+  , filled_(0)
+  , staged_(0)
+  , blocks_()
+  , takenOut_(OFFalse)
+  , status_(EC_Normal)
+  {
+    if ((buffer_ == NULL) || (bufSize_ == 0)) status_ = EC_IllegalCall;
+  }
+
+  virtual OFBool good() const { return status_.good(); }
+  virtual OFCondition status() const { return status_; }
+  virtual OFBool isFlushed() const { return (filled_ == 0); }
+  virtual offile_off_t avail() const { return bufSize_ - filled_; }
+  virtual void flush() { /* nothing to flush */ }
+
+  virtual offile_off_t write(const void *buf, offile_off_t buflen)
+  {
+    offile_off_t result = 0;
+    if (status_.good() && buf && buflen)
+    {
+      startBlocks();
+      result = bufSize_ - filled_;
+      if (result > buflen) result = buflen;
+      /* since staged_ <= filled_, the send buffer cannot overflow */
+      memcpy(buffer_ + staged_, buf, OFstatic_cast(size_t, result));
+      appendBlock(buffer_ + staged_, result);
+      staged_ += result;
+      filled_ += result;
+    }
+    return result;
+  }
+
+  virtual offile_off_t writeReference(const void *buf, offile_off_t buflen)
+  {
+    if (buflen < MinReferenceLength) return write(buf, buflen);
+    offile_off_t result = 0;
+    if (status_.good() && buf)
+    {
+      startBlocks();
+      result = bufSize_ - filled_;
+      if (result > buflen) result = buflen;
+      appendBlock(OFconst_cast(void *, buf), result);
+      filled_ += result;
+    }
+    return result;
+  }
+
+  /* hand out the collected blocks. They remain valid until the next write. */
+  void flushBlocks(const DcmTransportBuffer *& blocks, int& count, offile_off_t& length)
+  {
+    blocks = blocks_.empty() ? NULL : &blocks_[0];
+    count = OFstatic_cast(int, blocks_.size());
+    length = filled_;
+    filled_ = 0;
+    takenOut_ = OFTrue;
+  }
+
+  /* append a zero pad byte to the blocks handed out by the last call of flushBlocks() */
+  void addPadByte(const DcmTransportBuffer *& blocks, int& count, offile_off_t& length)
+  {
+    buffer_[staged_] = 0;
+    appendBlock(buffer_ + staged_, 1);
+    ++staged_;
+    ++length;
+    blocks = &blocks_[0];
+    count = OFstatic_cast(int, blocks_.size());
+  }
+
+private:
+  /* forget the blocks handed out before, since they have been sent in the meantime */
+  void startBlocks()
+  {
+    if (takenOut_)
+    {
+      blocks_.clear();
+      staged_ = 0;
+      takenOut_ = OFFalse;
+    }
+  }
+
+  /* append a block, merging it with the previous one if they are contiguous in memory */
+  void appendBlock(void *data, offile_off_t length)
+  {
+    if (!blocks_.empty() &&
+        (OFstatic_cast(unsigned char *, blocks_.back().data) + blocks_.back().length == data))
+    {
+      blocks_.back().length += OFstatic_cast(size_t, length);
+    }
+    else
+    {
+      DcmTransportBuffer block;
+      block.data = data;
+      block.length = OFstatic_cast(size_t, length);
+      blocks_.push_back(block);
+    }
+  }
+
+  DcmGatherConsumer(const DcmGatherConsumer&);
+  DcmGatherConsumer& operator=(const DcmGatherConsumer&);
+
+  unsigned char *buffer_;
+  offile_off_t bufSize_;
+  offile_off_t filled_;
+  offile_off_t staged_;
+  OFVector<DcmTransportBuffer> blocks_;
+  OFBool takenOut_;
+  OFCondition status_;
+};
+
+class DcmOutputGatherStream: public DcmOutputStream
+{
+public:
+  DcmOutputGatherStream(void *buf, offile_off_t bufLen)
+  : DcmOutputStream(&consumer_) // safe because DcmOutputStream only stores pointer
+  , consumer_(buf, bufLen)
+  {
+  }
+
+  void flushBlocks(const DcmTransportBuffer *& blocks, int& count, offile_off_t& length)
+  {
+    consumer_.flushBlocks(blocks, count, length);
+  }
+
+  void addPadByte(const DcmTransportBuffer *& blocks, int& count, offile_off_t& length)
+  {
+    consumer_.addPadByte(blocks, count, length);
+  }
+
+private:
+  DcmGatherConsumer consumer_;
+};
+
+
 /*
 ** Private Functions Bodies
 */
@@ -570,84 +731,153 @@ validateMessage(
  * Message sending support routines
  */
 
-#if 0
-/*** Currently Unused */
-/*
-** SendStraightFileData does not work for files with a Metaheader.
-** It would need to be rewritten to read data after the Metaheader.
-** However, finding out where the Metaheader ends means parsing the
-** whole file in the current implementation.  It is thus not worth
-** the effort!
-*/
+static OFBool
+findStraightFileData(
+        const char *dataFileName,
+        E_TransferSyntax xferSyntax,
+        offile_off_t &offset,
+        offile_off_t &length)
+    /*
+     * This function checks whether the instance data contained in a DICOM file can be sent
+     * "as is", i.e. without parsing and re-encoding the data set, and determines where the
+     * data set starts. This is the case if the file has a meta header and the data set is
+     * stored in the transfer syntax of the presentation context. Only the meta header is
+     * parsed for this purpose.
+     *
+     * Parameters:
+     *   dataFileName    - [in] The name of the file that contains the instance data.
+     *   xferSyntax      - [in] The transfer syntax of the presentation context.
+     *   offset          - [out] The position of the data set within the file.
+     *   length          - [out] The length of the data set in bytes.
+     */
+{
+    OFString xferUID;
+    DcmMetaInfo metaInfo;
+    DcmInputFileStream fileStream(dataFileName);
+    if (! fileStream.good()) return OFFalse;
+
+    /* read the meta header only, the position of the stream then marks the data set */
+    metaInfo.transferInit();
+    OFCondition cond = metaInfo.read(fileStream, EXS_Unknown, EGL_noChange);
+    metaInfo.transferEnd();
+    if (cond.bad() || metaInfo.findAndGetOFString(DCM_TransferSyntaxUID, xferUID).bad())
+    {
+      DCMNET_DEBUG("DIMSE sendMessage: file " << dataFileName
+        << " has no meta header, cannot send it without parsing");
+      return OFFalse;
+    }
+    if (DcmXfer(xferUID.c_str()).getXfer() != xferSyntax)
+    {
+      DCMNET_DEBUG("DIMSE sendMessage: transfer syntax of file " << dataFileName
+        << " differs from presentation context, cannot send it without parsing");
+      return OFFalse;
+    }
+    offset = fileStream.tell();
+    length = OFstatic_cast(offile_off_t, OFStandard::getFileSize(dataFileName)) - offset;
+    return (length > 0);
+}
+
 static OFCondition
 sendStraightFileData(
         T_ASC_Association *assoc,
         const char *dataFileName,
+        offile_off_t offset,
+        offile_off_t length,
         T_ASC_PresentationContextID presID,
-        E_TransferSyntax /* xferSyntax */,
         DIMSE_ProgressCallback callback,
         void *callbackContext)
-
+    /*
+     * This function sends the instance data which is stored in a file at the given position
+     * over the network without parsing it (see findStraightFileData()). On unencrypted TCP
+     * connections on systems that support sendfile(), the data is passed from the file to the
+     * socket by the kernel, i.e. it is never copied into user space. Otherwise the data is read
+     * into the association's send buffer chunk by chunk.
+     *
+     * Parameters:
+     *   assoc           - [in] The association (network connection to another DICOM application).
+     *   dataFileName    - [in] The name of the file that contains the instance data.
+     *   offset          - [in] The position of the data set within the file.
+     *   length          - [in] The length of the data set in bytes.
+     *   presId          - [in] The ID of the presentation context which shall be used
+     *   callback        - [in] Pointer to a function which shall be called to indicate progress.
+     *   callbackContext - []
+     */
 {
-    /* we assume that the file contains transfer syntax compatible data */
-    unsigned char *buf;
-    unsigned long bufLen;
-    FILE *f;
-    long nbytes;
-    OFBool last;
-    unsigned long bytesTransmitted = 0;
+    OFFile file;
+    OFBool last = OFFalse;
+    Uint32 bytesTransmitted = 0;
     OFCondition dulCond = EC_Normal;
     DUL_PDVLIST pdvList;
     DUL_PDV pdv;
-    /* the following variable is currently unused, leave it for future use */
-    unsigned long pdvCount = 0;
+    unsigned char *buf = assoc->sendPDVBuffer;
+    unsigned long bufLen = assoc->sendPDVLength;
 
-    buf = assoc->sendPDVBuffer;
-    bufLen = assoc->sendPDVLength;
+    /* we may wish to restrict output PDU size */
+    Uint32 maxpdulen = dcmMaxOutgoingPDUSize.get();
 
-    OFCondition cond = EC_Normal;
+    /* max PDV size is max PDU size minus 12 bytes PDU/PDV header */
+    if (bufLen + 12 > maxpdulen)
+    {
+      bufLen = maxpdulen - 12;
+    }
 
-    f = fopen(dataFileName, "rb");
-    if (f == NULL) {
-        char buf[256];
-        DCMNET_WARN(DIMSE_warn_str(assoc) << "sendStraightFileData: cannot open DICOM file ("
-            << dataFileName << "): " << OFStandard::strerror(errno, buf, sizeof(buf)));
-        cond = DIMSE_SENDFAILED;
+    if (! file.fopen(dataFileName, "rb") || (file.fseek(offset, SEEK_SET) != 0))
+    {
+      char errBuf[256];
+      DCMNET_WARN(DIMSE_warn_str(assoc) << "sendStraightFileData: cannot open DICOM file ("
+        << dataFileName << "): " << OFStandard::strerror(errno, errBuf, sizeof(errBuf)));
+      return DIMSE_SENDFAILED;
     }
 
-    while (cond.good() && ((nbytes = fread(buf, 1, bufLen, f)) > 0)) {
-        last = ((unsigned long)nbytes != bufLen);
+    /* use the zero-copy path if the transport connection permits it */
+    OFBool fromFile = DUL_CanWritePDVFromFile(&assoc->DULassociation);
+    DCMNET_TRACE("DIMSE sendStraightFileData: sending " << length << " bytes from file "
+      << dataFileName << ((fromFile) ? " using sendfile()" : ""));
+
+    while (!last)
+    {
+        unsigned long nbytes = (length > OFstatic_cast(offile_off_t, bufLen)) ? bufLen : OFstatic_cast(unsigned long, length);
+        last = (OFstatic_cast(offile_off_t, nbytes) == length);
+
         pdv.fragmentLength = nbytes;
         pdv.presentationContextID = presID;
         pdv.pdvType = DUL_DATASETPDV;
         pdv.lastPDV = last;
         pdv.data = buf;
 
-        pdvList.count = 1;
-        pdvList.pdv = &pdv;
-
-        DCMNET_TRACE("DIMSE sendStraightFileData: sending " << pdv.fragmentLength << " bytes (last: "
-            << ((last)?("YES"):("NO")) << ")");
-
-        dulCond = DUL_WritePDVs(&assoc->DULassociation, &pdvList);
+        if (fromFile)
+        {
+            dulCond = DUL_WritePDVFromFile(&assoc->DULassociation, &pdv, file.fileNo(), offset);
+        }
+        else if (file.fread(buf, 1, nbytes) != nbytes)
+        {
+            char errBuf[256];
+            DCMNET_WARN(DIMSE_warn_str(assoc) << "sendStraightFileData: cannot read DICOM file ("
+              << dataFileName << "): " << OFStandard::strerror(errno, errBuf, sizeof(errBuf)));
+            return DIMSE_SENDFAILED;
+        }
+        else
+        {
+            pdvList.count = 1;
+            pdvList.pdv = &pdv;
+            dulCond = DUL_WritePDVs(&assoc->DULassociation, &pdvList);
+        }
         if (dulCond.bad())
         {
-            cond = makeDcmnetSubCondition(DIMSEC_SENDFAILED, OF_error, "DIMSE Failed to send message", dulCond);
+            return makeDcmnetSubCondition(DIMSEC_SENDFAILED, OF_error, "DIMSE Failed to send message", dulCond);
         }
 
+        offset += nbytes;
+        length -= nbytes;
         bytesTransmitted += nbytes;
-        pdvCount += pdvList.count;
 
         if (callback) { /* execute callback function */
             callback(callbackContext, bytesTransmitted);
         }
     }
 
-    fclose(f);
-
-    return cond;
+    return EC_Normal;
 }
-#endif
 
 static OFCondition
 sendDcmDataset(
@@ -681,8 +911,9 @@ sendDcmDataset(
     OFBool last = OFFalse;
     OFBool written = OFFalse;
     offile_off_t rtnLength;
+    const DcmTransportBuffer *blocks = NULL;
+    int blockCount = 0;
     Uint32 bytesTransmitted = 0;
-    DUL_PDVLIST pdvList;
     DUL_PDV pdv;
     /* the following variable is currently unused, leave it for future use */
     unsigned long pdvCount = 0;
@@ -702,8 +933,10 @@ sendDcmDataset(
       bufLen = maxpdulen - 12;
     }
 
-    /* on the basis of the association's buffer, create a buffer variable that we can write to */
-    DcmOutputBufferStream outBuf(buf, bufLen);
+    /* on the basis of the association's buffer, create a stream that we can write to. */
+    /* Element values that stay in memory are not copied into the buffer but referenced, */
+    /* and sent directly from the dataset with a single gather write per PDU. */
+    DcmOutputGatherStream outBuf(buf, bufLen);
 
     /* prepare all elements in the DcmDataset variable for transfer */
     obj->transferInit();
@@ -751,9 +984,8 @@ sendDcmDataset(
 
         if (written) outBuf.flush(); // flush stream including embedded compression codec.
 
-        /* get buffer and its length, assign to local variable */
-        void *fullBuf = NULL;
-        outBuf.flushBuffer(fullBuf, rtnLength);
+        /* get the list of memory blocks and its total length, assign to local variables */
+        outBuf.flushBlocks(blocks, blockCount, rtnLength);
 
         last = written && outBuf.isFlushed();
 
@@ -777,33 +1009,28 @@ sendDcmDataset(
                * than rtnLength, so we can safely add a pad byte (and hope that
                * the pad byte will not confuse the receiver's decompressor).
                */
-              unsigned char *cbuf = (unsigned char *)fullBuf;
-              cbuf[rtnLength++] = 0; // add zero pad byte
+              outBuf.addPadByte(blocks, blockCount, rtnLength);
             }
 
-            /* initialize a DUL_PDV variable with the buffer's data */
+            /* initialize a DUL_PDV variable describing the data in the memory blocks */
             pdv.fragmentLength = OFstatic_cast(unsigned long, rtnLength);
             pdv.presentationContextID = presID;
             pdv.pdvType = pdvType;
             pdv.lastPDV = last;
-            pdv.data = fullBuf;
-
-            /* append this PDV to a PDV list structure, set the counter variable */
-            /* to 1 since this structure contains only 1 element */
-            pdvList.count = 1;
-            pdvList.pdv = &pdv;
+            pdv.data = NULL;
 
             /* dump some information if required */
-            DCMNET_TRACE("DIMSE sendDcmDataset: sending " << pdv.fragmentLength << " bytes");
+            DCMNET_TRACE("DIMSE sendDcmDataset: sending " << pdv.fragmentLength << " bytes in "
+                << blockCount << " block(s)");
 
             /* send information over the network to the other DICOM application */
-            dulCond = DUL_WritePDVs(&assoc->DULassociation, &pdvList);
+            dulCond = DUL_WritePDVBuffers(&assoc->DULassociation, &pdv, blocks, blockCount);
             if (dulCond.bad())
                 return makeDcmnetSubCondition(DIMSEC_SENDFAILED, OF_error, "DIMSE Failed to send message", dulCond);
 
             /* count the bytes and the amount of PDVs which were transmitted */
             bytesTransmitted += OFstatic_cast(Uint32, rtnLength);
-            pdvCount += pdvList.count;
+            pdvCount++;
 
             /* execute callback function to indicate progress */
             if (callback) {
@@ -867,6 +1094,9 @@ DIMSE_sendMessage(
     DcmDataset *cmdObj = NULL;
     DcmFileFormat dcmff;
     int fromFile = 0;
+    OFBool straightFile = OFFalse;
+    offile_off_t straightOffset = 0;
+    offile_off_t straightLength = 0;
     OFCondition cond = EC_Normal;
 
     if (commandSet) *commandSet = NULL;
@@ -912,7 +1142,16 @@ DIMSE_sendMessage(
       /* to create a data object with the actual instance data that shall be sent */
       else if ((dataObject == NULL)&&(dataFileName != NULL))
       {
-        if (! dcmff.loadFile(dataFileName, EXS_Unknown).good())
+        /* if requested, try to send the data set as stored in the file (without parsing it) */
+        if (dcmSendStraightFileData.get() && !g_dimse_save_dimse_data)
+        {
+          straightFile = findStraightFileData(dataFileName, xferSyntax, straightOffset, straightLength);
+        }
+        if (straightFile)
+        {
+          /* nothing to do, the file is sent after the command */
+        }
+        else if (! dcmff.loadFile(dataFileName, EXS_Unknown).good())
         {
           char buf[256];
           DCMNET_WARN(DIMSE_warn_str(assoc) << "sendMessage: cannot open DICOM file ("
@@ -951,7 +1190,7 @@ DIMSE_sendMessage(
           }
           cond = DIMSE_SENDFAILED;
         }
-      } else {
+      } else if (! straightFile) {
         /* if there is neither a data object nor a file name, create a warning, since */
         /* the information in msg specified that instance data should be present. */
         DCMNET_WARN(DIMSE_warn_str(assoc) << "sendMessage: no dataset to send");
@@ -989,6 +1228,12 @@ DIMSE_sendMessage(
       cond = sendDcmDataset(assoc, dataObject, presID, xferSyntax,
           DUL_DATASETPDV, callback, callbackContext);
     }
+    else if (cond.good() && DIMSE_isDataSetPresent(msg) && straightFile)
+    {
+      /* send the instance data straight from the file */
+      cond = sendStraightFileData(assoc, dataFileName, straightOffset, straightLength,
+          presID, callback, callbackContext);
+    }
 
     /* clean up some memory */
     delete cmdObj;
@@ -1321,17 +1566,16 @@ DIMSE_receiveCommand(
 }
 
 
-OFCondition DIMSE_createFilestream(
-        const OFFilename &filename,
+/* build the meta header for a file received with a C-STORE request */
+static OFCondition createMetaheader(
         const T_DIMSE_C_StoreRQ *request,
         const T_ASC_Association *assoc,
         T_ASC_PresentationContextID presIdCmd,
         int writeMetaheader,
-        DcmOutputFileStream **filestream)
+        DcmMetaInfo *&metainfo)
 {
   OFCondition cond = EC_Normal;
   DcmElement *elem=NULL;
-  DcmMetaInfo *metainfo=NULL;
   DcmTag metaElementGroupLength(DCM_FileMetaInformationGroupLength);
   DcmTag fileMetaInformationVersion(DCM_FileMetaInformationVersion);
   DcmTag mediaStorageSOPClassUID(DCM_MediaStorageSOPClassUID);
@@ -1342,12 +1586,7 @@ OFCondition DIMSE_createFilestream(
   DcmTag sourceApplicationEntityTitle(DCM_SourceApplicationEntityTitle);
   T_ASC_PresentationContext presentationContext;
 
-  if (filename.isEmpty() || (request==NULL) || (assoc==NULL) ||
-      (assoc->params==NULL) || (filestream==NULL))
-  {
-    return DIMSE_NULLKEY;
-  }
-
+  metainfo = NULL;
   cond = ASC_findAcceptedPresentationContext(assoc->params, presIdCmd, &presentationContext);
   if (cond.bad()) return cond;
 
@@ -1403,6 +1642,7 @@ OFCondition DIMSE_createFilestream(
     if (cond == EC_MemoryExhausted)
     {
       delete metainfo;
+      metainfo = NULL;
       return cond;
     }
 
@@ -1411,10 +1651,58 @@ OFCondition DIMSE_createFilestream(
     if (cond.bad())
     {
       delete metainfo;
+      metainfo = NULL;
       return cond;
     }
   }
 
+  return cond;
+}
+
+
+/* write the meta header (if any) to the given stream and delete it */
+static OFCondition writeMetaheaderToStream(
+        const OFFilename &filename,
+        DcmMetaInfo *metainfo,
+        DcmOutputStream &filestream)
+{
+  OFCondition cond = EC_Normal;
+  if (metainfo)
+  {
+    metainfo->transferInit();
+    if (EC_Normal != metainfo->write(filestream, META_HEADER_DEFAULT_TRANSFERSYNTAX, EET_ExplicitLength, NULL))
+    {
+      OFOStringStream stream;
+      stream << "DIMSE createFilestream: cannot write metaheader to file '" << filename << "'" << OFStringStream_ends;
+      OFSTRINGSTREAM_GETOFSTRING(stream, msg)
+      cond = makeDcmnetCondition(DIMSEC_OUTOFRESOURCES, OF_error, msg.c_str());
+    }
+    metainfo->transferEnd();
+    delete metainfo;
+  }
+  return cond;
+}
+
+
+OFCondition DIMSE_createFilestream(
+        const OFFilename &filename,
+        const T_DIMSE_C_StoreRQ *request,
+        const T_ASC_Association *assoc,
+        T_ASC_PresentationContextID presIdCmd,
+        int writeMetaheader,
+        DcmOutputFileStream **filestream)
+{
+  DcmMetaInfo *metainfo=NULL;
+
+  if (filename.isEmpty() || (request==NULL) || (assoc==NULL) ||
+      (assoc->params==NULL) || (filestream==NULL))
+  {
+    return DIMSE_NULLKEY;
+  }
+
+  OFCondition cond = createMetaheader(request, assoc, presIdCmd, writeMetaheader, metainfo);
+  if (cond.bad()) return cond;
+
   *filestream = new DcmOutputFileStream(filename);
   if ((*filestream == NULL)||(! (*filestream)->good()))
   {
@@ -1430,23 +1718,46 @@ OFCondition DIMSE_createFilestream(
      return makeDcmnetCondition(DIMSEC_OUTOFRESOURCES, OF_error, msg.c_str());
   }
 
-  if (metainfo)
+  return writeMetaheaderToStream(filename, metainfo, **filestream);
+}
+
+
+#ifdef WITH_THREADS
+
+OFCondition DIMSE_createWriteBehindFilestream(
+        const OFFilename &filename,
+        const T_DIMSE_C_StoreRQ *request,
+        const T_ASC_Association *assoc,
+        T_ASC_PresentationContextID presIdCmd,
+        int writeMetaheader,
+        DcmWriteBehindStorage &storage,
+        DcmWriteBehindStream **filestream)
+{
+  DcmMetaInfo *metainfo=NULL;
+
+  if (filename.isEmpty() || (request==NULL) || (assoc==NULL) ||
+      (assoc->params==NULL) || (filestream==NULL))
+  {
+    return DIMSE_NULLKEY;
+  }
+
+  OFCondition cond = createMetaheader(request, assoc, presIdCmd, writeMetaheader, metainfo);
+  if (cond.bad()) return cond;
+
+  cond = storage.createFile(filename, *filestream);
+  if (cond.bad())
   {
-    metainfo->transferInit();
-    if (EC_Normal != metainfo->write(**filestream, META_HEADER_DEFAULT_TRANSFERSYNTAX, EET_ExplicitLength, NULL))
-    {
-      OFOStringStream stream;
-      stream << "DIMSE createFilestream: cannot write metaheader to file '" << filename << "'" << OFStringStream_ends;
-      OFSTRINGSTREAM_GETOFSTRING(stream, msg)
-      cond = makeDcmnetCondition(DIMSEC_OUTOFRESOURCES, OF_error, msg.c_str());
-    }
-    metainfo->transferEnd();
     delete metainfo;
+    return cond;
   }
 
+  cond = writeMetaheaderToStream(filename, metainfo, **filestream);
+  if (cond.bad()) storage.abortFile(*filestream);
   return cond;
 }
 
+#endif // WITH_THREADS
+
 
 OFCondition
 DIMSE_receiveDataSetInFile(
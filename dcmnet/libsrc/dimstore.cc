@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -95,6 +95,7 @@
 #include "dcmtk/dcmnet/dimse.h"		/* always include the module header */
 #include "dcmtk/dcmnet/cond.h"
 #include "dcmtk/dcmdata/dcostrmf.h"    /* for class DcmOutputFileStream */
+#include "dcmtk/dcmnet/dstorwb.h"      /* for class DcmWriteBehindStorage */
 #include "dcmtk/ofstd/ofstd.h"         /* for OFStandard::getFileSize() */
 
 
@@ -449,6 +450,43 @@ DIMSE_storeProvider( T_ASC_Association *assoc,
     /* data shall be received and stored in memory. This will be handled through the call to function */
     /* DIMSE_receiveDataSetInMemory(...). The case in which both variables are NULL is considered to */
     /* be an error and will be handled correspondingly. */
+#ifdef WITH_THREADS
+    DcmWriteBehindStorage *writeBehindStorage = dcmWriteBehindStorage.get();
+    if ((imageFileName != NULL) && (writeBehindStorage != NULL) && (strcmp(imageFileName, NULL_DEVICE_NAME) != 0)) {
+        /* create a stream that writes the file in the background */
+        DcmWriteBehindStream *filestream = NULL;
+        cond = DIMSE_createWriteBehindFilestream(imageFileName, request, assoc, presIdCmd, writeMetaheader, *writeBehindStorage, &filestream);
+        if (cond.bad())
+        {
+          /* We cannot create the filestream, so ignore the incoming dataset and return an out-of-resources error to the SCU */
+          DIC_UL bytesRead = 0;
+          DIC_UL pdvCount=0;
+          cond = DIMSE_ignoreDataSet(assoc, blockMode, timeout, &bytesRead, &pdvCount);
+          if (cond.good())
+          {
+            OFString s = "DIMSE_storeProvider: Cannot create file: ";
+            s += imageFileName;
+            cond = makeDcmnetCondition(DIMSEC_OUTOFRESOURCES, OF_error, s.c_str());
+          }
+        } else {
+          /* receive data and queue it to the I/O thread; closing the file waits according to the completion mode */
+          cond = DIMSE_receiveDataSetInFile(assoc, blockMode, timeout, &presIdData, filestream, privCallback, &callbackCtx);
+          if (cond.good())
+          {
+            cond = writeBehindStorage->closeFile(filestream);
+            if (cond.bad())
+            {
+              /* the file could not be written, the incomplete file has been removed by the I/O thread */
+              OFString s = "DIMSE_storeProvider: Cannot write file: ";
+              s += imageFileName;
+              cond = makeDcmnetCondition(DIMSEC_OUTOFRESOURCES, OF_error, s.c_str());
+            }
+          }
+          else writeBehindStorage->abortFile(filestream);
+        }
+    }
+    else
+#endif
     if (imageFileName != NULL) {
         /* create filestream */
         DcmOutputFileStream *filestream = NULL;
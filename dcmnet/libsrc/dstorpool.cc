@@ -0,0 +1,308 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Pool of DICOM Storage Service Class Providers (SCP)
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/ofstream.h"     /* for OFOStringStream */
+#include "dcmtk/dcmnet/dstorpool.h"
+#include "dcmtk/dcmnet/diutil.h"
+
+
+// constant definitions
+
+const char *DcmStorageSCPPool::DEF_WorkerSubdirectoryPrefix = "worker";
+
+
+// implementation of the main interface class
+
+DcmStorageSCPPool::DcmStorageSCPPool()
+  : DcmBaseSCPPool(),
+    OutputDirectory(),
+    FilenameExtension(),
+    DirectoryGeneration(DcmStorageSCP::DGM_Default),
+    FilenameGeneration(DcmStorageSCP::FGM_Default),
+    DatasetStorage(DcmStorageSCP::DSM_Default),
+    WorkerSubdirectories(OFFalse),
+    WorkerNumberMutex(),
+    WorkerNumbersInUse()
+{
+    // make sure that the SCP at least supports C-ECHO with default transfer syntax
+    OFList<OFString> transferSyntaxes;
+    transferSyntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+    getConfig().addPresentationContext(UID_VerificationSOPClass, transferSyntaxes);
+}
+
+
+DcmStorageSCPPool::~DcmStorageSCPPool()
+{
+}
+
+
+// get methods
+
+const OFString &DcmStorageSCPPool::getOutputDirectory() const
+{
+    return OutputDirectory;
+}
+
+
+DcmStorageSCP::E_DirectoryGenerationMode DcmStorageSCPPool::getDirectoryGenerationMode() const
+{
+    return DirectoryGeneration;
+}
+
+
+DcmStorageSCP::E_FilenameGenerationMode DcmStorageSCPPool::getFilenameGenerationMode() const
+{
+    return FilenameGeneration;
+}
+
+
+const OFString &DcmStorageSCPPool::getFilenameExtension() const
+{
+    return FilenameExtension;
+}
+
+
+DcmStorageSCP::E_DatasetStorageMode DcmStorageSCPPool::getDatasetStorageMode() const
+{
+    return DatasetStorage;
+}
+
+
+OFBool DcmStorageSCPPool::getWorkerSubdirectoryMode() const
+{
+    return WorkerSubdirectories;
+}
+
+
+// set methods
+
+OFCondition DcmStorageSCPPool::setOutputDirectory(const OFString &directory)
+{
+    OFCondition status = EC_Normal;
+    if (directory.empty())
+    {
+        // empty directory refers to the current directory
+        if (OFStandard::isWriteable("."))
+            OutputDirectory.clear();
+        else
+            status = EC_DirectoryNotWritable;
+    } else {
+        // check whether given directory exists and is writable
+        if (OFStandard::dirExists(directory))
+        {
+            if (OFStandard::isWriteable(directory))
+                OFStandard::normalizeDirName(OutputDirectory, directory);
+            else
+                status = EC_DirectoryNotWritable;
+        } else
+            status = EC_DirectoryDoesNotExist;
+    }
+    return status;
+}
+
+
+void DcmStorageSCPPool::setDirectoryGenerationMode(const DcmStorageSCP::E_DirectoryGenerationMode mode)
+{
+    DirectoryGeneration = mode;
+}
+
+
+void DcmStorageSCPPool::setFilenameGenerationMode(const DcmStorageSCP::E_FilenameGenerationMode mode)
+{
+    FilenameGeneration = mode;
+}
+
+
+void DcmStorageSCPPool::setFilenameExtension(const OFString &extension)
+{
+    FilenameExtension = extension;
+}
+
+
+void DcmStorageSCPPool::setDatasetStorageMode(const DcmStorageSCP::E_DatasetStorageMode mode)
+{
+    DatasetStorage = mode;
+}
+
+
+void DcmStorageSCPPool::setWorkerSubdirectoryMode(const OFBool mode)
+{
+    WorkerSubdirectories = mode;
+}
+
+
+// further public methods
+
+OFCondition DcmStorageSCPPool::loadAssociationConfiguration(const OFString &filename,
+                                                            const OFString &profile)
+{
+    // first, try to load the configuration file
+    OFCondition status = getConfig().loadAssociationCfgFile(filename);
+    // and then, try to select the desired profile
+    if (status.good())
+        status = getConfig().setAndCheckAssociationProfile(profile);
+    return status;
+}
+
+
+// protected methods
+
+DcmBaseSCPPool::DcmBaseSCPWorker *DcmStorageSCPPool::createSCPWorker()
+{
+    const size_t number = acquireWorkerNumber();
+    Worker *worker = new Worker(*this, number);
+    OFCondition status = configureWorker(*worker, number);
+    if (status.bad())
+    {
+        DCMNET_ERROR("cannot configure storage SCP worker #" << number << ": " << status.text());
+        // also releases the worker number
+        delete worker;
+        worker = NULL;
+    }
+    return worker;
+}
+
+
+OFCondition DcmStorageSCPPool::configureWorker(DcmStorageSCP &worker,
+                                               const size_t number)
+{
+    OFCondition status = EC_Normal;
+    worker.setDirectoryGenerationMode(DirectoryGeneration);
+    worker.setFilenameGenerationMode(FilenameGeneration);
+    worker.setFilenameExtension(FilenameExtension);
+    worker.setDatasetStorageMode(DatasetStorage);
+    if (WorkerSubdirectories)
+    {
+        // use (and create, if needed) the subdirectory of this worker
+        OFOStringStream stream;
+        stream << DEF_WorkerSubdirectoryPrefix << number << OFStringStream_ends;
+        OFSTRINGSTREAM_GETOFSTRING(stream, subdirectoryName)
+        OFString directoryName;
+        OFStandard::combineDirAndFilename(directoryName, OutputDirectory, subdirectoryName, OFTrue /*allowEmptyDirName*/);
+        if (!OFStandard::dirExists(directoryName))
+            status = OFStandard::createDirectory(directoryName, OutputDirectory /* rootDir */);
+        if (status.good())
+            status = worker.setOutputDirectory(directoryName);
+    } else
+        status = worker.setOutputDirectory(OutputDirectory);
+    return status;
+}
+
+
+void DcmStorageSCPPool::notifyInstanceStored(const OFString & /*filename*/,
+                                             const OFString & /*sopClassUID*/,
+                                             const OFString & /*sopInstanceUID*/,
+                                             DcmDataset * /*dataset*/) const
+{
+    // do nothing in the default implementation
+}
+
+
+// private methods
+
+size_t DcmStorageSCPPool::acquireWorkerNumber()
+{
+    WorkerNumberMutex.lock();
+    size_t index = 0;
+    while ((index < WorkerNumbersInUse.size()) && WorkerNumbersInUse[index])
+        ++index;
+    if (index == WorkerNumbersInUse.size())
+        WorkerNumbersInUse.push_back(OFTrue);
+    else
+        WorkerNumbersInUse[index] = OFTrue;
+    WorkerNumberMutex.unlock();
+    return index + 1;
+}
+
+
+void DcmStorageSCPPool::releaseWorkerNumber(const size_t number)
+{
+    WorkerNumberMutex.lock();
+    if ((number > 0) && (number <= WorkerNumbersInUse.size()))
+        WorkerNumbersInUse[number - 1] = OFFalse;
+    WorkerNumberMutex.unlock();
+}
+
+
+// implementation of the worker class
+
+DcmStorageSCPPool::Worker::Worker(DcmStorageSCPPool &pool,
+                                  const size_t number)
+  : DcmBaseSCPPool::DcmBaseSCPWorker(pool),
+    DcmStorageSCP(),
+    StoragePool(pool),
+    Number(number)
+{
+}
+
+
+DcmStorageSCPPool::Worker::~Worker()
+{
+    StoragePool.releaseWorkerNumber(Number);
+}
+
+
+OFCondition DcmStorageSCPPool::Worker::setSharedConfig(const DcmSharedSCPConfig &config)
+{
+    return DcmStorageSCP::setSharedConfig(config);
+}
+
+
+OFBool DcmStorageSCPPool::Worker::busy()
+{
+    return DcmStorageSCP::isConnected();
+}
+
+
+OFCondition DcmStorageSCPPool::Worker::workerListen(T_ASC_Association * const assoc)
+{
+    return DcmStorageSCP::run(assoc);
+}
+
+
+OFCondition DcmStorageSCPPool::Worker::workerNegotiate(T_ASC_Association *&assoc)
+{
+    return DcmStorageSCP::runNegotiation(assoc);
+}
+
+
+OFCondition DcmStorageSCPPool::Worker::workerHandleCommand(T_ASC_Association *&assoc)
+{
+    return DcmStorageSCP::runNextCommand(assoc);
+}
+
+
+void DcmStorageSCPPool::Worker::notifyInstanceStored(const OFString &filename,
+                                                     const OFString &sopClassUID,
+                                                     const OFString &sopInstanceUID,
+                                                     DcmDataset *dataset) const
+{
+    DcmStorageSCP::notifyInstanceStored(filename, sopClassUID, sopInstanceUID, dataset);
+    StoragePool.notifyInstanceStored(filename, sopClassUID, sopInstanceUID, dataset);
+}
+
+
+#endif // WITH_THREADS
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2013-2014, OFFIS e.V.
+ *  Copyright (C) 2013-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -36,7 +36,7 @@ const char *DcmStorageSCP::DEF_FilenameExtension     = "";
 // implementation of the main interface class
 
 DcmStorageSCP::DcmStorageSCP()
-  : DcmSCP(),
+  : DcmThreadSCP(),
     OutputDirectory(),
     StandardSubdirectory(DEF_StandardSubdirectory),
     UndefinedSubdirectory(DEF_UndefinedSubdirectory),
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2011-2014, OFFIS e.V.
+ *  Copyright (C) 2011-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -23,6 +23,10 @@
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 
 #include "dcmtk/ofstd/ofdatime.h"
+#include "dcmtk/ofstd/ofvector.h"
+#ifdef WITH_THREADS
+#include "dcmtk/ofstd/ofthread.h"
+#endif
 #include "dcmtk/dcmdata/dccodec.h"
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmnet/dstorscu.h"
@@ -788,6 +792,13 @@ OFCondition DcmStorageSCU::sendSOPInstances()
     if (!TransferList.empty())
     {
         DcmDataset *dataset = NULL;
+        // check whether more than one request can be outstanding at a time (0 means "unlimited")
+        const Uint16 maxOperations = getNegotiatedMaxOperationsInvoked();
+        const OFBool pipelined = (maxOperations != 1);
+        if (pipelined)
+            DCMNET_DEBUG("sending SOP instances asynchronously (max. " << maxOperations << " outstanding requests)");
+        // transfer entries of the outstanding requests (if sent asynchronously)
+        OFMap<Uint16, TransferEntry *> pendingEntries;
         // iterate over the list of SOP instance to be transferred
         // (continue with next SOP instance if there already was a transmission)
         OFListConstIterator(TransferEntry *) lastEntry = TransferList.end();
@@ -855,56 +866,54 @@ OFCondition DcmStorageSCU::sendSOPInstances()
                             }
                         }
                     }
-                    // call the inherited method from the base class doing the real work
-                    status = sendSTORERequest((*CurrentTransferEntry)->PresentationContextID, "" /* filename */,
-                        dataset, (*CurrentTransferEntry)->ResponseStatusCode,
-                        MoveOriginatorAETitle, MoveOriginatorMsgID);
-                    // store some further information (even in case of error)
-                    (*CurrentTransferEntry)->AssociationNumber = AssociationCounter;
-                    (*CurrentTransferEntry)->NetworkTransferSyntax = dataset->getCurrentXfer();
-                }
-                // if it was successful (i.e. even if DIMSE status is not 0x0000 = success) ...
-                if (status.good())
-                {
-                    // ... remember that this SOP instance has already been sent
-                    (*CurrentTransferEntry)->RequestSent = OFTrue;
-                    // check whether we need to compact or delete the dataset
-                    if ((*CurrentTransferEntry)->Filename.empty() && ((*CurrentTransferEntry)->Dataset != NULL))
+                    if (pipelined)
                     {
-                        if ((*CurrentTransferEntry)->DatasetHandlingMode == HM_compactAfterSend)
-                        {
-                            DCMNET_DEBUG("compacting dataset after successful send");
-                            (*CurrentTransferEntry)->Dataset->compactElements(256 /* maxLength */);
-                        }
-                        else if ((*CurrentTransferEntry)->DatasetHandlingMode == HM_deleteAfterSend)
+                        // wait for a response if the asynchronous operations window is full
+                        while (status.good() && (maxOperations != 0) && (pendingEntries.size() >= maxOperations))
+                            status = receiveSOPInstanceResponse(pendingEntries);
+                        if (status.bad())
                         {
-                            DCMNET_DEBUG("deleting dataset after successful send");
-                            delete (*CurrentTransferEntry)->Dataset;
-                            // forget about this dataset (e.g. in order to avoid double deletion)
-                            (*CurrentTransferEntry)->Dataset = NULL;
+                            // a response could not be received, so there is no point in continuing;
+                            // the current SOP instance has not been sent (might be on another association)
+                            break;
+                        } else {
+                            Uint16 messageID = 0;
+                            // send the request without waiting for the response
+                            status = sendSTORERequestAsync((*CurrentTransferEntry)->PresentationContextID,
+                                "" /* filename */, dataset, messageID, MoveOriginatorAETitle, MoveOriginatorMsgID);
+                            // store some further information (even in case of error)
+                            (*CurrentTransferEntry)->AssociationNumber = AssociationCounter;
+                            (*CurrentTransferEntry)->NetworkTransferSyntax = dataset->getCurrentXfer();
+                            // the SOP instance is finished when the response has been received
+                            if (status.good())
+                                pendingEntries[messageID] = *CurrentTransferEntry;
                         }
+                    } else {
+                        // call the inherited method from the base class doing the real work
+                        status = sendSTORERequest((*CurrentTransferEntry)->PresentationContextID, "" /* filename */,
+                            dataset, (*CurrentTransferEntry)->ResponseStatusCode,
+                            MoveOriginatorAETitle, MoveOriginatorMsgID);
+                        // store some further information (even in case of error)
+                        (*CurrentTransferEntry)->AssociationNumber = AssociationCounter;
+                        (*CurrentTransferEntry)->NetworkTransferSyntax = dataset->getCurrentXfer();
                     }
-                } else {
-                    // if the SOP instance could not be sent because no acceptable presentation context was found
-                    if (status == DIMSE_NOVALIDPRESENTATIONCONTEXTID)
-                    {
-                        // mark the SOP instance as being sent with an error that is not defined for C-STORE;
-                        // the DIMSE status indicates "pending" (see above)
-                        (*CurrentTransferEntry)->RequestSent = OFTrue;
-                        (*CurrentTransferEntry)->ResponseStatusCode = STATUS_STORE_Pending_NoPresentationContext;
-                    }
-                    // do not exit the loop if the error should be ignored
-                    if (!HaltOnUnsuccessfulStoreMode && (status != DIMSE_ILLEGALASSOCIATION))
-                        status = EC_Normal;
                 }
-                // notify user of this class that the current SOP instance has been processed
-                notifySOPInstanceSent(**CurrentTransferEntry);
+                // process SOP instance unless it is still awaiting its response
+                if (!pipelined || status.bad())
+                    status = finishSOPInstance(**CurrentTransferEntry, status);
             }
             ++CurrentTransferEntry;
             // check whether the sending process should be stopped
             if (shouldStopAfterCurrentSOPInstance())
                 break;
         }
+        // receive the responses that are still outstanding (if any)
+        while (pendingEntries.size() > 0)
+        {
+            OFCondition result = receiveSOPInstanceResponse(pendingEntries);
+            if (status.good())
+                status = result;
+        }
     } else {
         // report an error to the caller
         status = NET_EC_NoSOPInstancesToSend;
@@ -913,6 +922,433 @@ OFCondition DcmStorageSCU::sendSOPInstances()
 }
 
 
+OFCondition DcmStorageSCU::finishSOPInstance(TransferEntry &transferEntry,
+                                             OFCondition status)
+{
+    // if it was successful (i.e. even if DIMSE status is not 0x0000 = success) ...
+    if (status.good())
+    {
+        // ... remember that this SOP instance has already been sent
+        transferEntry.RequestSent = OFTrue;
+        // check whether we need to compact or delete the dataset
+        if (transferEntry.Filename.empty() && (transferEntry.Dataset != NULL))
+        {
+            if (transferEntry.DatasetHandlingMode == HM_compactAfterSend)
+            {
+                DCMNET_DEBUG("compacting dataset after successful send");
+                transferEntry.Dataset->compactElements(256 /* maxLength */);
+            }
+            else if (transferEntry.DatasetHandlingMode == HM_deleteAfterSend)
+            {
+                DCMNET_DEBUG("deleting dataset after successful send");
+                delete transferEntry.Dataset;
+                // forget about this dataset (e.g. in order to avoid double deletion)
+                transferEntry.Dataset = NULL;
+            }
+        }
+    } else {
+        // if the SOP instance could not be sent because no acceptable presentation context was found
+        if (status == DIMSE_NOVALIDPRESENTATIONCONTEXTID)
+        {
+            // mark the SOP instance as being sent with an error that is not defined for C-STORE;
+            // the DIMSE status indicates "pending" (see above)
+            transferEntry.RequestSent = OFTrue;
+            transferEntry.ResponseStatusCode = STATUS_STORE_Pending_NoPresentationContext;
+        }
+        // do not exit the loop if the error should be ignored
+        if (!HaltOnUnsuccessfulStoreMode && (status != DIMSE_ILLEGALASSOCIATION))
+            status = EC_Normal;
+    }
+    // notify user of this class that the current SOP instance has been processed
+    notifySOPInstanceSent(transferEntry);
+    return status;
+}
+
+
+OFCondition DcmStorageSCU::receiveSOPInstanceResponse(OFMap<Uint16, TransferEntry *> &pendingEntries)
+{
+    Uint16 messageID = 0;
+    Uint16 rspStatusCode = 0;
+    OFCondition status = receiveSTOREResponse(messageID, rspStatusCode);
+    if (status.good())
+    {
+        OFMap<Uint16, TransferEntry *>::iterator entry = pendingEntries.find(messageID);
+        if (entry != pendingEntries.end())
+        {
+            TransferEntry *transferEntry = entry->second;
+            pendingEntries.erase(entry);
+            transferEntry->ResponseStatusCode = rspStatusCode;
+            status = finishSOPInstance(*transferEntry, status);
+        }
+    } else {
+        // the responses cannot be assigned to the requests any longer, so give up on all of them
+        OFMap<Uint16, TransferEntry *>::iterator entry = pendingEntries.begin();
+        while (entry != pendingEntries.end())
+        {
+            finishSOPInstance(*(entry->second), status);
+            ++entry;
+        }
+        pendingEntries.clear();
+    }
+    return status;
+}
+
+
+// helper class for sending SOP instances on multiple associations in parallel
+
+/* shared state of all workers started by sendSOPInstancesInParallel() */
+struct DcmStorageSCUWorkerContext
+{
+#ifdef WITH_THREADS
+    /// mutex protecting the parent object and the stop flag
+    OFMutex Mutex;
+#endif
+    /// flag indicating whether all workers should stop after their current SOP instance
+    OFBool Stop;
+
+    DcmStorageSCUWorkerContext()
+#ifdef WITH_THREADS
+      : Mutex(),
+        Stop(OFFalse)
+#else
+      : Stop(OFFalse)
+#endif
+    {
+    }
+
+    void lock()
+    {
+#ifdef WITH_THREADS
+        Mutex.lock();
+#endif
+    }
+
+    void unlock()
+    {
+#ifdef WITH_THREADS
+        Mutex.unlock();
+#endif
+    }
+};
+
+
+class DcmStorageSCU::StorageWorker
+  : public DcmStorageSCU
+#ifdef WITH_THREADS
+  , public OFThread
+#endif
+{
+
+  public:
+
+    StorageWorker(DcmStorageSCU &parent,
+                  DcmStorageSCUWorkerContext &context,
+                  const OFBool multipleAssociations)
+      : DcmStorageSCU(),
+#ifdef WITH_THREADS
+        OFThread(),
+#endif
+        Result(EC_Normal),
+        Parent(parent),
+        Context(context),
+        MultipleAssociations(multipleAssociations),
+        ParentEntries(),
+        AssociationNumbers(),
+        NumProcessed(0),
+        NumSuccess(0)
+    {
+        // use the same network parameters as the parent ...
+        setAETitle(parent.getAETitle());
+        setPeerAETitle(parent.getPeerAETitle());
+        setPeerHostName(parent.getPeerHostName());
+        setPeerPort(parent.getPeerPort());
+        setMaxReceivePDULength(parent.getMaxReceivePDULength());
+        setMaxOperationsInvoked(parent.getMaxOperationsInvoked());
+        setDIMSEBlockingMode(parent.getDIMSEBlockingMode());
+        setDIMSETimeout(parent.getDIMSETimeout());
+        setACSETimeout(parent.getACSETimeout());
+        setVerbosePCMode(parent.getVerbosePCMode());
+        setDatasetConversionMode(parent.getDatasetConversionMode());
+        setProgressNotificationMode(parent.getProgressNotificationMode());
+        // ... and the same processing modes
+        DecompressionMode = parent.DecompressionMode;
+        HaltOnInvalidFileMode = parent.HaltOnInvalidFileMode;
+        HaltOnUnsuccessfulStoreMode = parent.HaltOnUnsuccessfulStoreMode;
+        AllowIllegalProposalMode = parent.AllowIllegalProposalMode;
+        MoveOriginatorAETitle = parent.MoveOriginatorAETitle;
+        MoveOriginatorMsgID = parent.MoveOriginatorMsgID;
+    }
+
+    /* add a copy of the given transfer entry of the parent to the transfer list */
+    void addTransferEntry(TransferEntry *parentEntry)
+    {
+        TransferEntry *entry = NULL;
+        // the dataset (if any) is still owned by the parent
+        if (parentEntry->Filename.empty())
+        {
+            entry = new TransferEntry(parentEntry->Dataset, HM_doNothing, parentEntry->SOPClassUID,
+                parentEntry->SOPInstanceUID, parentEntry->TransferSyntaxUID);
+        } else {
+            entry = new TransferEntry(parentEntry->Filename, parentEntry->FileReadMode, parentEntry->SOPClassUID,
+                parentEntry->SOPInstanceUID, parentEntry->TransferSyntaxUID);
+        }
+        TransferList.push_back(entry);
+        ParentEntries[entry] = parentEntry;
+    }
+
+    /* send all SOP instances of this worker using one or more associations */
+    OFCondition transfer()
+    {
+        OFCondition status;
+        // add presentation contexts to be negotiated (if there are still any)
+        while ((status = addPresentationContexts()).good())
+        {
+            status = initNetwork();
+            if (status.bad())
+            {
+                DCMNET_ERROR("cannot initialize network: " << status.text());
+                break;
+            }
+            status = negotiateAssociation();
+            if (status.good())
+            {
+                const unsigned long associationNumber = AssociationNumbers.back();
+                NumProcessed = 0;
+                NumSuccess = 0;
+                status = sendSOPInstances();
+                // output some statistics on this association
+                DCMNET_INFO("association #" << associationNumber << ": " << NumProcessed
+                    << " SOP instance(s) processed, " << NumSuccess << " with status SUCCESS");
+                if (status.bad())
+                {
+                    DCMNET_ERROR("association #" << associationNumber << ": cannot send SOP instance: "
+                        << status.text());
+                    // handle certain error conditions (initiated by the communication peer)
+                    if (status == DUL_PEERREQUESTEDRELEASE)
+                        closeAssociation(DCMSCU_PEER_REQUESTED_RELEASE);
+                    else if (status == DUL_PEERABORTEDASSOCIATION)
+                        closeAssociation(DCMSCU_PEER_ABORTED_ASSOCIATION);
+                    else
+                        abortAssociation();
+                    break;
+                }
+                releaseAssociation();
+            }
+            // check whether we can continue with a new association
+            else if (status != NET_EC_NoAcceptablePresentationContexts)
+            {
+                DCMNET_ERROR("cannot negotiate network association: " << status.text());
+                break;
+            }
+            // check whether multiple associations are permitted and needed
+            if (!MultipleAssociations || stopRequested())
+                break;
+        }
+        // all SOP instances have been negotiated and sent
+        if (status == NET_EC_NoPresentationContextsDefined)
+            status = EC_Normal;
+        // make sure that the parent knows about all SOP instances (including the ones
+        // that could not be sent at all) and stop all other workers in case of error
+        Context.lock();
+        OFMap<const TransferEntry *, TransferEntry *>::iterator entry = ParentEntries.begin();
+        while (entry != ParentEntries.end())
+        {
+            updateParentEntry(*(entry->first), *(entry->second));
+            ++entry;
+        }
+        Parent.PresentationContextCounter += PresentationContextCounter;
+        if (status.bad())
+            Context.Stop = OFTrue;
+        Context.unlock();
+        return status;
+    }
+
+    /// status of the transfer
+    OFCondition Result;
+
+  protected:
+
+#ifdef WITH_THREADS
+    void run()
+    {
+        Result = transfer();
+    }
+#endif
+
+    OFCondition negotiateAssociation()
+    {
+        OFCondition status = DcmStorageSCU::negotiateAssociation();
+        // associations are counted by the parent (over all workers)
+        Context.lock();
+        AssociationNumbers.push_back(++Parent.AssociationCounter);
+        Context.unlock();
+        return status;
+    }
+
+    void notifySOPInstanceSent(const TransferEntry &transferEntry)
+    {
+        OFMap<const TransferEntry *, TransferEntry *>::iterator entry = ParentEntries.find(&transferEntry);
+        if (entry != ParentEntries.end())
+        {
+            TransferEntry &parentEntry = *(entry->second);
+            ++NumProcessed;
+            if (transferEntry.RequestSent && (transferEntry.ResponseStatusCode == STATUS_Success))
+                ++NumSuccess;
+            // notifications of the parent are never called concurrently
+            Context.lock();
+            updateParentEntry(transferEntry, parentEntry);
+            // check whether we need to compact or delete the dataset (which is owned by the parent)
+            if (transferEntry.RequestSent &&
+                (transferEntry.ResponseStatusCode != STATUS_STORE_Pending_NoPresentationContext) &&
+                (transferEntry.ResponseStatusCode != STATUS_STORE_Pending_InvalidDatasetPointer) &&
+                parentEntry.Filename.empty() && (parentEntry.Dataset != NULL))
+            {
+                if (parentEntry.DatasetHandlingMode == HM_compactAfterSend)
+                {
+                    DCMNET_DEBUG("compacting dataset after successful send");
+                    parentEntry.Dataset->compactElements(256 /* maxLength */);
+                }
+                else if (parentEntry.DatasetHandlingMode == HM_deleteAfterSend)
+                {
+                    DCMNET_DEBUG("deleting dataset after successful send");
+                    delete parentEntry.Dataset;
+                    // forget about this dataset (e.g. in order to avoid double deletion)
+                    parentEntry.Dataset = NULL;
+                }
+            }
+            Parent.notifySOPInstanceSent(parentEntry);
+            Context.unlock();
+        }
+    }
+
+    OFBool shouldStopAfterCurrentSOPInstance()
+    {
+        Context.lock();
+        // ask the parent only if none of the workers is to be stopped anyway
+        if (!Context.Stop)
+            Context.Stop = Parent.shouldStopAfterCurrentSOPInstance();
+        const OFBool stop = Context.Stop;
+        Context.unlock();
+        return stop;
+    }
+
+  private:
+
+    /* check whether all workers should stop (e.g. because another one has failed) */
+    OFBool stopRequested()
+    {
+        Context.lock();
+        const OFBool stop = Context.Stop;
+        Context.unlock();
+        return stop;
+    }
+
+    /* copy the status of a transfer entry to the corresponding entry of the parent */
+    void updateParentEntry(const TransferEntry &entry,
+                           TransferEntry &parentEntry)
+    {
+        parentEntry.RequestSent = entry.RequestSent;
+        parentEntry.ResponseStatusCode = entry.ResponseStatusCode;
+        parentEntry.NetworkTransferSyntax = entry.NetworkTransferSyntax;
+        // map the association number of this worker to the one of the parent
+        if ((entry.AssociationNumber > 0) && (entry.AssociationNumber <= AssociationNumbers.size()))
+            parentEntry.AssociationNumber = AssociationNumbers[entry.AssociationNumber - 1];
+    }
+
+    /// parent object that owns the transfer list
+    DcmStorageSCU &Parent;
+    /// state shared by all workers
+    DcmStorageSCUWorkerContext &Context;
+    /// flag indicating whether more than one association may be used
+    const OFBool MultipleAssociations;
+    /// mapping of the transfer entries of this worker to the ones of the parent
+    OFMap<const TransferEntry *, TransferEntry *> ParentEntries;
+    /// number of each association of this worker as counted by the parent
+    OFVector<unsigned long> AssociationNumbers;
+    /// number of SOP instances processed on the current association
+    size_t NumProcessed;
+    /// number of SOP instances stored successfully on the current association
+    size_t NumSuccess;
+
+    // private undefined copy constructor
+    StorageWorker(const StorageWorker &);
+
+    // private undefined assignment operator
+    StorageWorker &operator=(const StorageWorker &);
+};
+
+
+OFCondition DcmStorageSCU::sendSOPInstancesInParallel(const size_t numAssociations,
+                                                      const OFBool multipleAssociations)
+{
+    // determine the SOP instances that have not yet been sent
+    OFVector<TransferEntry *> entries;
+    OFListIterator(TransferEntry *) transferEntry = TransferList.begin();
+    OFListIterator(TransferEntry *) lastEntry = TransferList.end();
+    while (transferEntry != lastEntry)
+    {
+        if (!(*transferEntry)->RequestSent)
+            entries.push_back(*transferEntry);
+        ++transferEntry;
+    }
+    if (entries.empty())
+    {
+        // report an error to the caller
+        return NET_EC_NoSOPInstancesToSend;
+    }
+    // split the SOP instances into contiguous parts (one per association)
+    size_t numWorkers = (numAssociations > 0) ? numAssociations : 1;
+    if (numWorkers > entries.size())
+        numWorkers = entries.size();
+    const size_t partSize = (entries.size() + numWorkers - 1) / numWorkers;
+    DCMNET_DEBUG("sending " << entries.size() << " SOP instances on up to " << numWorkers
+        << " associations in parallel");
+    DcmStorageSCUWorkerContext context;
+    OFVector<StorageWorker *> workers;
+    size_t index = 0;
+    while (index < entries.size())
+    {
+        StorageWorker *worker = new StorageWorker(*this, context, multipleAssociations);
+        for (size_t i = 0; (i < partSize) && (index < entries.size()); ++i)
+            worker->addTransferEntry(entries[index++]);
+        workers.push_back(worker);
+    }
+#ifdef WITH_THREADS
+    // start one thread per worker ...
+    OFVector<OFBool> started(workers.size(), OFFalse);
+    for (size_t j = 0; j < workers.size(); ++j)
+    {
+        started[j] = (workers[j]->start() == 0);
+        if (!started[j])
+            DCMNET_WARN("cannot start thread for sending SOP instances, using the current thread instead");
+    }
+    // ... and wait for all of them to finish
+    for (size_t k = 0; k < workers.size(); ++k)
+    {
+        if (started[k])
+            workers[k]->join();
+        else
+            workers[k]->Result = workers[k]->transfer();
+    }
+#else
+    // send the parts one after the other
+    for (size_t k = 0; k < workers.size(); ++k)
+        workers[k]->Result = workers[k]->transfer();
+#endif
+    // return the status of the first worker that failed (if any)
+    OFCondition status = EC_Normal;
+    for (size_t l = 0; l < workers.size(); ++l)
+    {
+        if (status.good() && workers[l]->Result.bad())
+            status = workers[l]->Result;
+        delete workers[l];
+    }
+    // the transfer list has been processed completely
+    CurrentTransferEntry = TransferList.end();
+    return status;
+}
+
+
 void DcmStorageSCU::notifySOPInstanceSent(const TransferEntry &transferEntry)
 {
     // do nothing in the default implementation
@@ -0,0 +1,568 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Write-behind storage of received DICOM files
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/dcmnet/dstorwb.h"
+#include "dcmtk/dcmnet/cond.h"
+#include "dcmtk/dcmnet/diutil.h"
+#include "dcmtk/ofstd/ofstd.h"
+
+#ifdef HAVE_UNISTD_H
+BEGIN_EXTERN_C
+#include <unistd.h>       /* for fsync() */
+END_EXTERN_C
+#endif
+#ifdef HAVE_IO_H
+#include <io.h>           /* for _commit() */
+#endif
+
+
+OFGlobal<DcmWriteBehindStorage *> dcmWriteBehindStorage(NULL);
+
+const size_t DcmWriteBehindStorage::ChunkSize = 65536;
+
+
+/** a file written by the I/O thread of a DcmWriteBehindStorage object
+ */
+struct DcmWriteBehindFile
+{
+  /** constructor
+   *  @param fname name of the file
+   */
+  DcmWriteBehindFile(const OFFilename &fname)
+  : filename(fname)
+  , file()
+  , status()
+  , references(2)
+  , completed(0)
+  {
+  }
+
+  /// name of the file
+  OFFilename filename;
+  /// the file (only accessed by the I/O thread after creation)
+  OFFile file;
+  /// status, i.e.\ the first error that occurred
+  OFCondition status;
+  /// number of references: one by the writing thread, one by the I/O thread
+  int references;
+  /// semaphore posted when the file is complete according to the completion mode
+  OFSemaphore completed;
+};
+
+
+/** create an error condition for a failed file operation
+ *  @param operation description of the operation that failed
+ *  @param filename name of the file concerned
+ *  @return error condition
+ */
+static OFCondition makeFileError(const char *operation, const OFFilename &filename)
+{
+  char buf[256];
+  OFString msg = "DIMSE write-behind: cannot ";
+  msg += operation;
+  msg += " file '";
+  msg += OFSTRING_GUARD(filename.getCharPointer());
+  msg += "': ";
+  msg += OFStandard::strerror(errno, buf, sizeof(buf));
+  return makeDcmnetCondition(DIMSEC_OUTOFRESOURCES, OF_error, msg.c_str());
+}
+
+
+/** flush the given file and synchronize it to disk
+ *  @param file file to be synchronized
+ *  @return 0 if successful, -1 otherwise
+ */
+static int syncFile(OFFile &file)
+{
+  int result = file.fflush();
+#ifdef HAVE_FSYNC
+  if (result == 0) result = fsync(file.fileNo());
+#elif defined(HAVE_IO_H)
+  if (result == 0) result = _commit(file.fileNo());
+#endif
+  return (result == 0) ? 0 : -1;
+}
+
+
+/* ======================================================================= */
+
+DcmWriteBehindConsumer::DcmWriteBehindConsumer(DcmWriteBehindStorage &storage, DcmWriteBehindFile *file)
+: storage_(storage)
+, file_(file)
+, chunk_(NULL)
+, chunkUsed_(0)
+{
+}
+
+DcmWriteBehindConsumer::~DcmWriteBehindConsumer()
+{
+  // discard data not flushed before
+  if (chunk_)
+  {
+    delete[] chunk_;
+    storage_.ChunkSemaphore->post();
+  }
+}
+
+OFBool DcmWriteBehindConsumer::good() const
+{
+  return status().good();
+}
+
+OFCondition DcmWriteBehindConsumer::status() const
+{
+  return storage_.fileStatus(file_);
+}
+
+OFBool DcmWriteBehindConsumer::isFlushed() const
+{
+  return (chunkUsed_ == 0);
+}
+
+offile_off_t DcmWriteBehindConsumer::avail() const
+{
+  // since we cannot report "unlimited", let's claim that we can still write 2GB.
+  // Note that offile_off_t is a signed type.
+  return 2147483647L;
+}
+
+offile_off_t DcmWriteBehindConsumer::write(const void *buf, offile_off_t buflen)
+{
+  offile_off_t result = 0;
+  const unsigned char *data = OFstatic_cast(const unsigned char *, buf);
+  while (buf && (result < buflen))
+  {
+    if (chunk_ == NULL)
+    {
+      chunk_ = storage_.allocateChunk();
+      chunkUsed_ = 0;
+    }
+    size_t count = DcmWriteBehindStorage::ChunkSize - chunkUsed_;
+    if (OFstatic_cast(offile_off_t, count) > buflen - result)
+      count = OFstatic_cast(size_t, buflen - result);
+    memcpy(chunk_ + chunkUsed_, data + result, count);
+    chunkUsed_ += count;
+    result += count;
+    // hand the chunk to the I/O thread as soon as it is full
+    if (chunkUsed_ == DcmWriteBehindStorage::ChunkSize) flush();
+  }
+  return result;
+}
+
+void DcmWriteBehindConsumer::flush()
+{
+  if (chunk_ && chunkUsed_)
+  {
+    DcmWriteBehindStorage::Job job;
+    job.type = DcmWriteBehindStorage::Job::JT_Write;
+    job.file = file_;
+    job.data = chunk_;
+    job.length = chunkUsed_;
+    job.done = NULL;
+    storage_.addJob(job);
+    chunk_ = NULL;
+    chunkUsed_ = 0;
+  }
+}
+
+
+/* ======================================================================= */
+
+DcmWriteBehindStream::DcmWriteBehindStream(DcmWriteBehindStorage &storage, DcmWriteBehindFile *file)
+: DcmOutputStream(&consumer_) // safe because DcmOutputStream only stores pointer
+, file_(file)
+, consumer_(storage, file)
+{
+}
+
+DcmWriteBehindStream::~DcmWriteBehindStream()
+{
+}
+
+
+/* ======================================================================= */
+
+DcmWriteBehindStorage::DcmWriteBehindStorage()
+: OFThread()
+, SyncMode(WSM_Batch)
+, MaxBatchSize(64)
+, CompletionMode(WCM_Written)
+, MaxQueuedBytes(64 * 1024 * 1024)
+, Running(OFFalse)
+, Mutex()
+, Jobs()
+, JobSemaphore(NULL)
+, ChunkSemaphore(NULL)
+, PendingFiles()
+, SyncStatus()
+, NumFilesWritten(0)
+, NumSyncs(0)
+{
+}
+
+DcmWriteBehindStorage::~DcmWriteBehindStorage()
+{
+  stop();
+}
+
+void DcmWriteBehindStorage::setSyncMode(const E_SyncMode mode)
+{
+  SyncMode = mode;
+}
+
+DcmWriteBehindStorage::E_SyncMode DcmWriteBehindStorage::getSyncMode() const
+{
+  return SyncMode;
+}
+
+void DcmWriteBehindStorage::setMaxBatchSize(const size_t maxFiles)
+{
+  MaxBatchSize = (maxFiles > 0) ? maxFiles : 1;
+}
+
+size_t DcmWriteBehindStorage::getMaxBatchSize() const
+{
+  return MaxBatchSize;
+}
+
+void DcmWriteBehindStorage::setCompletionMode(const E_CompletionMode mode)
+{
+  CompletionMode = mode;
+}
+
+DcmWriteBehindStorage::E_CompletionMode DcmWriteBehindStorage::getCompletionMode() const
+{
+  return CompletionMode;
+}
+
+void DcmWriteBehindStorage::setMaxQueuedBytes(const size_t maxBytes)
+{
+  MaxQueuedBytes = (maxBytes > ChunkSize) ? maxBytes : ChunkSize;
+}
+
+size_t DcmWriteBehindStorage::getMaxQueuedBytes() const
+{
+  return MaxQueuedBytes;
+}
+
+OFCondition DcmWriteBehindStorage::start()
+{
+  if (Running) return EC_IllegalCall;
+  JobSemaphore = new OFSemaphore(0);
+  ChunkSemaphore = new OFSemaphore(OFstatic_cast(unsigned int, MaxQueuedBytes / ChunkSize));
+  if (OFThread::start() != 0)
+  {
+    delete JobSemaphore;
+    delete ChunkSemaphore;
+    JobSemaphore = NULL;
+    ChunkSemaphore = NULL;
+    return makeDcmnetCondition(DIMSEC_OUTOFRESOURCES, OF_error, "DIMSE write-behind: cannot start I/O thread");
+  }
+  Running = OFTrue;
+  return EC_Normal;
+}
+
+void DcmWriteBehindStorage::stop()
+{
+  if (Running)
+  {
+    Job job;
+    job.type = Job::JT_Stop;
+    job.file = NULL;
+    job.data = NULL;
+    job.length = 0;
+    job.done = NULL;
+    addJob(job);
+    join();
+    Running = OFFalse;
+    delete JobSemaphore;
+    delete ChunkSemaphore;
+    JobSemaphore = NULL;
+    ChunkSemaphore = NULL;
+  }
+}
+
+OFCondition DcmWriteBehindStorage::createFile(const OFFilename &filename,
+                                              DcmWriteBehindStream *&stream)
+{
+  stream = NULL;
+  if (!Running) return EC_IllegalCall;
+  DcmWriteBehindFile *file = new DcmWriteBehindFile(filename);
+  // open the file right now, so that the caller learns about any error at once
+  if (!file->file.fopen(filename, "wb"))
+  {
+    OFCondition cond = makeFileError("create", filename);
+    delete file;
+    return cond;
+  }
+  stream = new DcmWriteBehindStream(*this, file);
+  return EC_Normal;
+}
+
+OFCondition DcmWriteBehindStorage::closeFile(DcmWriteBehindStream *&stream)
+{
+  if (stream == NULL) return EC_IllegalCall;
+  DcmWriteBehindFile *file = stream->file();
+  stream->flush();
+  delete stream;
+  stream = NULL;
+  Job job;
+  job.type = Job::JT_Close;
+  job.file = file;
+  job.data = NULL;
+  job.length = 0;
+  job.done = NULL;
+  addJob(job);
+  if (CompletionMode != WCM_Queued)
+    file->completed.wait();
+  OFCondition result = fileStatus(file);
+  releaseFile(file);
+  return result;
+}
+
+void DcmWriteBehindStorage::abortFile(DcmWriteBehindStream *&stream)
+{
+  if (stream)
+  {
+    DcmWriteBehindFile *file = stream->file();
+    // unflushed data is discarded by the stream
+    delete stream;
+    stream = NULL;
+    Job job;
+    job.type = Job::JT_Abort;
+    job.file = file;
+    job.data = NULL;
+    job.length = 0;
+    job.done = NULL;
+    addJob(job);
+    releaseFile(file);
+  }
+}
+
+OFCondition DcmWriteBehindStorage::sync()
+{
+  if (!Running) return EC_IllegalCall;
+  OFSemaphore done(0);
+  Job job;
+  job.type = Job::JT_Sync;
+  job.file = NULL;
+  job.data = NULL;
+  job.length = 0;
+  job.done = &done;
+  addJob(job);
+  done.wait();
+  Mutex.lock();
+  OFCondition result = SyncStatus;
+  SyncStatus = EC_Normal;
+  Mutex.unlock();
+  return result;
+}
+
+size_t DcmWriteBehindStorage::getNumFilesWritten()
+{
+  Mutex.lock();
+  const size_t result = NumFilesWritten;
+  Mutex.unlock();
+  return result;
+}
+
+size_t DcmWriteBehindStorage::getNumSyncs()
+{
+  Mutex.lock();
+  const size_t result = NumSyncs;
+  Mutex.unlock();
+  return result;
+}
+
+void DcmWriteBehindStorage::run()
+{
+  OFBool stopped = OFFalse;
+  while (!stopped)
+  {
+    JobSemaphore->wait();
+    Mutex.lock();
+    Job job = Jobs.front();
+    Jobs.pop_front();
+    Mutex.unlock();
+    switch (job.type)
+    {
+      case Job::JT_Write:
+        if (fileStatus(job.file).good())
+        {
+          if (job.file->file.fwrite(job.data, 1, job.length) != job.length)
+            setFileError(job.file, makeFileError("write", job.file->filename));
+        }
+        delete[] job.data;
+        ChunkSemaphore->post();
+        break;
+      case Job::JT_Close:
+        finishFile(job.file);
+        break;
+      case Job::JT_Abort:
+        job.file->file.fclose();
+        OFStandard::deleteFile(job.file->filename);
+        completeFile(job.file);
+        releaseFile(job.file);
+        break;
+      case Job::JT_Sync:
+        syncPendingFiles();
+        job.done->post();
+        break;
+      case Job::JT_Stop:
+        syncPendingFiles();
+        stopped = OFTrue;
+        break;
+    }
+    // in batch mode, synchronize all files closed so far as soon as there is
+    // nothing else to do (or the batch is full)
+    if ((SyncMode == WSM_Batch) && !PendingFiles.empty())
+    {
+      Mutex.lock();
+      const OFBool idle = Jobs.empty();
+      Mutex.unlock();
+      if (idle || (PendingFiles.size() >= MaxBatchSize))
+        syncPendingFiles();
+    }
+  }
+}
+
+unsigned char *DcmWriteBehindStorage::allocateChunk()
+{
+  ChunkSemaphore->wait();
+  return new unsigned char[ChunkSize];
+}
+
+void DcmWriteBehindStorage::addJob(const Job &job)
+{
+  Mutex.lock();
+  Jobs.push_back(job);
+  Mutex.unlock();
+  JobSemaphore->post();
+}
+
+OFCondition DcmWriteBehindStorage::fileStatus(DcmWriteBehindFile *file)
+{
+  Mutex.lock();
+  OFCondition result = file->status;
+  Mutex.unlock();
+  return result;
+}
+
+void DcmWriteBehindStorage::setFileError(DcmWriteBehindFile *file, const OFCondition &error)
+{
+  Mutex.lock();
+  if (file->status.good()) file->status = error;
+  if (SyncStatus.good()) SyncStatus = error;
+  Mutex.unlock();
+  DCMNET_ERROR(error.text());
+}
+
+void DcmWriteBehindStorage::releaseFile(DcmWriteBehindFile *file)
+{
+  Mutex.lock();
+  const int references = --file->references;
+  Mutex.unlock();
+  if (references == 0) delete file;
+}
+
+void DcmWriteBehindStorage::finishFile(DcmWriteBehindFile *file)
+{
+  if (fileStatus(file).bad())
+  {
+    // do not keep incomplete files
+    file->file.fclose();
+    OFStandard::deleteFile(file->filename);
+    completeFile(file);
+    releaseFile(file);
+    return;
+  }
+  Mutex.lock();
+  ++NumFilesWritten;
+  Mutex.unlock();
+  switch (SyncMode)
+  {
+    case WSM_None:
+      if (file->file.fclose() != 0)
+        setFileError(file, makeFileError("close", file->filename));
+      completeFile(file);
+      releaseFile(file);
+      break;
+    case WSM_EachFile:
+      if (syncFile(file->file) != 0)
+        setFileError(file, makeFileError("synchronize", file->filename));
+      if (file->file.fclose() != 0)
+        setFileError(file, makeFileError("close", file->filename));
+      Mutex.lock();
+      ++NumSyncs;
+      Mutex.unlock();
+      completeFile(file);
+      releaseFile(file);
+      break;
+    case WSM_Batch:
+    case WSM_OnRequest:
+      // hand the data to the operating system, synchronize it later
+      if (file->file.fflush() != 0)
+        setFileError(file, makeFileError("write", file->filename));
+      if ((CompletionMode != WCM_Synced) || (SyncMode == WSM_OnRequest))
+        completeFile(file);
+      PendingFiles.push_back(file);
+      // limit the number of files kept open
+      if (PendingFiles.size() >= MaxBatchSize)
+        syncPendingFiles();
+      break;
+  }
+}
+
+void DcmWriteBehindStorage::syncPendingFiles()
+{
+  if (PendingFiles.empty()) return;
+  DCMNET_DEBUG("DIMSE write-behind: synchronizing " << PendingFiles.size() << " file(s)");
+  OFListIterator(DcmWriteBehindFile *) it = PendingFiles.begin();
+  while (it != PendingFiles.end())
+  {
+    DcmWriteBehindFile *file = *it;
+    if (syncFile(file->file) != 0)
+      setFileError(file, makeFileError("synchronize", file->filename));
+    if (file->file.fclose() != 0)
+      setFileError(file, makeFileError("close", file->filename));
+    // files have been completed before unless they have to be synchronized first
+    if ((CompletionMode == WCM_Synced) && (SyncMode == WSM_Batch))
+      completeFile(file);
+    releaseFile(file);
+    ++it;
+  }
+  PendingFiles.clear();
+  Mutex.lock();
+  ++NumSyncs;
+  Mutex.unlock();
+}
+
+void DcmWriteBehindStorage::completeFile(DcmWriteBehindFile *file)
+{
+  file->completed.post();
+}
+
+#endif // WITH_THREADS
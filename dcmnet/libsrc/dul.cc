@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -152,6 +152,7 @@ OFGlobal<Sint32> dcmConnectionTimeout(-1);
 OFGlobal<int>    dcmExternalSocketHandle(-1);
 OFGlobal<const char *> dcmTCPWrapperDaemonName((const char *)NULL);
 OFGlobal<unsigned long> dcmEnableBackwardCompatibility(0);
+OFGlobal<Uint32> dcmReceiveBufferSize(65536);
 
 static int networkInitialized = 0;
 
@@ -582,17 +583,55 @@ DUL_ReceiveAssociationRQ(
   DUL_ASSOCIATESERVICEPARAMETERS * params,
   DUL_ASSOCIATIONKEY ** callerAssociation,
   int activatePDUStorage)
+{
+    OFCondition cond = DUL_ReceiveTransportConnection(callerNetworkKey, block,
+        timeout, params, callerAssociation, activatePDUStorage);
+    if (cond.bad() || (cond.code() == DULC_FORKEDCHILD))
+        return cond;
+
+    return DUL_ReadAssociationRQ(callerAssociation, params);
+}
+
+
+/* DUL_ReceiveTransportConnection
+**
+** Purpose:
+**      This function performs the first part of DUL_ReceiveAssociationRQ,
+**      i.e. it accepts an incoming transport connection and creates the
+**      AssociationKey for it, but it does not read the Association Request
+**      from the new connection yet.  The caller has to call
+**      DUL_ReadAssociationRQ as soon as data is available on the connection.
+**
+** Parameter Dictionary:
+**      callerNetworkKey    Caller's handle to the network environment.
+**      block               Flag indicating blocking/non-blocking mode.
+**      timeout             When blocking mode is non-blocking, the timeout in
+**                          seconds.
+**      params              Pointer to a structure holding parameters which
+**                          describe this Association.
+**      callerAssociation   Caller handle for this association that is created
+**                          by this function.
+**      activatePDUStorage
+**
+** Return Values:
+**
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+OFCondition
+DUL_ReceiveTransportConnection(
+  DUL_NETWORKKEY ** callerNetworkKey,
+  DUL_BLOCKOPTIONS block,
+  int timeout,
+  DUL_ASSOCIATESERVICEPARAMETERS * params,
+  DUL_ASSOCIATIONKEY ** callerAssociation,
+  int activatePDUStorage)
 {
     PRIVATE_NETWORKKEY
         ** network;
     PRIVATE_ASSOCIATIONKEY
         ** association;
-    unsigned char
-        pduType;
-    int
-        event;
-    DUL_ABORTITEMS
-        abortItems;
 
     network = (PRIVATE_NETWORKKEY **) callerNetworkKey;
     association = (PRIVATE_ASSOCIATIONKEY **) callerAssociation;
@@ -622,10 +661,49 @@ DUL_ReceiveAssociationRQ(
         return cond;
     }
 
-    cond = PRV_StateMachine(network, association,
+    return PRV_StateMachine(network, association,
                   TRANS_CONN_INDICATION, (*network)->protocolState, params);
-    if (cond.bad())
-        return cond;
+}
+
+
+/* DUL_ReadAssociationRQ
+**
+** Purpose:
+**      This function performs the second part of DUL_ReceiveAssociationRQ,
+**      i.e. it reads the Association Request from a transport connection
+**      that has been accepted by DUL_ReceiveTransportConnection.  If the
+**      function does receive such a request, the list of Association Items
+**      describing the proposed Association is returned in params.
+**
+** Parameter Dictionary:
+**      callerAssociation   Caller handle for this association that has been
+**                          created by DUL_ReceiveTransportConnection.
+**      params              Pointer to a structure holding parameters which
+**                          describe this Association.
+**
+** Return Values:
+**
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+OFCondition
+DUL_ReadAssociationRQ(
+  DUL_ASSOCIATIONKEY ** callerAssociation,
+  DUL_ASSOCIATESERVICEPARAMETERS * params)
+{
+    PRIVATE_ASSOCIATIONKEY
+        ** association;
+    unsigned char
+        pduType;
+    int
+        event;
+    DUL_ABORTITEMS
+        abortItems;
+
+    association = (PRIVATE_ASSOCIATIONKEY **) callerAssociation;
+    OFCondition cond = checkAssociation(association);
+    if (cond.bad()) return cond;
 
     /* This is the first time we read from this new connection, so in case it
      * doesn't speak DICOM, we shouldn't wait forever (= DUL_NOBLOCK).
@@ -666,7 +744,8 @@ DUL_ReceiveAssociationRQ(
             break;
         }
     }
-    cond = PRV_StateMachine(network, association, event,
+    /* none of the actions for these events requires the network key */
+    cond = PRV_StateMachine(NULL, association, event,
                             (*association)->protocolState, params);
     if (cond == DUL_UNSUPPORTEDPEERPROTOCOL) {
         abortItems.result = DUL_REJECT_PERMANENT;
@@ -1102,6 +1181,143 @@ DUL_WritePDVs(DUL_ASSOCIATIONKEY ** callerAssociation,
 }
 
 
+/* DUL_CanWritePDVFromFile
+**
+** Purpose:
+**      Check whether DUL_WritePDVFromFile can be used on an Association.
+**
+** Parameter Dictionary:
+**      callerAssociation  Caller's handle to the Association
+**
+** Return Values:
+**      OFTrue if the Association is established on an unencrypted TCP
+**      connection and the system supports sendfile(), OFFalse otherwise.
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+OFBool
+DUL_CanWritePDVFromFile(DUL_ASSOCIATIONKEY ** callerAssociation)
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    PRIVATE_ASSOCIATIONKEY
+        ** association = (PRIVATE_ASSOCIATIONKEY **) callerAssociation;
+
+    if (checkAssociation(association).bad()) return OFFalse;
+    return ((*association)->connection != NULL) && (*association)->connection->isTransparentConnection();
+#else
+    (void) callerAssociation;
+    return OFFalse;
+#endif
+}
+
+
+/* DUL_WritePDVFromFile
+**
+** Purpose:
+**      Write a single PDV on an active Association, taking the PDV data
+**      directly from a file instead of from memory.
+**
+** Parameter Dictionary:
+**      callerAssociation  Caller's handle to the Association
+**      pdv                Description of the PDV to be written. The data
+**                         field is ignored, fragmentLength bytes are read
+**                         from the file.
+**      fd                 Descriptor of the file containing the PDV data
+**      offset             Position of the PDV data in the file
+**
+** Return Values:
+**
+**
+** Algorithm:
+**      Only permitted where the state machine accepts a P-DATA request
+**      (i.e. in the states in which DUL_WritePDVs would send data).
+**      Should only be called if DUL_CanWritePDVFromFile returned true.
+*/
+OFCondition
+DUL_WritePDVFromFile(DUL_ASSOCIATIONKEY ** callerAssociation,
+                     DUL_PDV * pdv, int fd, offile_off_t offset)
+{
+    PRIVATE_ASSOCIATIONKEY
+        ** association;
+
+    /* assign association to local variable */
+    association = (PRIVATE_ASSOCIATIONKEY **) callerAssociation;
+
+    /* check if association is valid, if not return an error */
+    OFCondition cond = checkAssociation(association);
+    if (cond.bad()) return cond;
+
+    /* P-DATA requests are only handled in state 6 (data transfer) and state 8 */
+    /* (awaiting local A-RELEASE response). In any other state, let the finite */
+    /* state machine report the error just like for DUL_WritePDVs. */
+    if ((*association)->protocolState != STATE6 && (*association)->protocolState != STATE8)
+    {
+        DUL_PDVLIST pdvList;
+        pdvList.count = 0;
+        pdvList.scratch = NULL;
+        pdvList.scratchLength = 0;
+        pdvList.pdv = NULL;
+        return PRV_StateMachine(NULL, association, P_DATA_REQ,
+                                (*association)->protocolState, &pdvList);
+    }
+
+    return PRV_SendPDataFromFile(association, pdv, fd, offset);
+}
+
+
+/* DUL_WritePDVBuffers
+**
+** Purpose:
+**      Write a single PDV on an active Association, taking the PDV data
+**      from several memory blocks without copying them into one buffer.
+**
+** Parameter Dictionary:
+**      callerAssociation  Caller's handle to the Association
+**      pdv                Description of the PDV to be written. The data
+**                         field is ignored, fragmentLength bytes are taken
+**                         from the memory blocks in the given order.
+**      buffers            Memory blocks containing the PDV data
+**      count              Number of memory blocks
+**
+** Return Values:
+**
+**
+** Algorithm:
+**      Only permitted where the state machine accepts a P-DATA request
+**      (i.e. in the states in which DUL_WritePDVs would send data).
+*/
+OFCondition
+DUL_WritePDVBuffers(DUL_ASSOCIATIONKEY ** callerAssociation,
+                    DUL_PDV * pdv, const DcmTransportBuffer * buffers, int count)
+{
+    PRIVATE_ASSOCIATIONKEY
+        ** association;
+
+    /* assign association to local variable */
+    association = (PRIVATE_ASSOCIATIONKEY **) callerAssociation;
+
+    /* check if association is valid, if not return an error */
+    OFCondition cond = checkAssociation(association);
+    if (cond.bad()) return cond;
+
+    /* P-DATA requests are only handled in state 6 (data transfer) and state 8 */
+    /* (awaiting local A-RELEASE response), see DUL_WritePDVFromFile() */
+    if ((*association)->protocolState != STATE6 && (*association)->protocolState != STATE8)
+    {
+        DUL_PDVLIST pdvList;
+        pdvList.count = 0;
+        pdvList.scratch = NULL;
+        pdvList.scratchLength = 0;
+        pdvList.pdv = NULL;
+        return PRV_StateMachine(NULL, association, P_DATA_REQ,
+                                (*association)->protocolState, &pdvList);
+    }
+
+    return PRV_SendPDataBuffers(association, pdv, buffers, count);
+}
+
+
 /* DUL_ReadPDVs
 **
 ** Purpose:
@@ -2017,6 +2233,7 @@ createNetworkKey(const char *mode,
         (*key)->timeout = DEFAULT_TIMEOUT;
 
     (*key)->options = opt;
+    (*key)->receiveBufferLength = dcmReceiveBufferSize.get();
 
     return EC_Normal;
 }
@@ -2168,9 +2385,11 @@ createAssociationKey(PRIVATE_NETWORKKEY ** networkKey,
                      PRIVATE_ASSOCIATIONKEY ** associationKey)
 {
     PRIVATE_ASSOCIATIONKEY *key;
+    unsigned long receiveBufferLength = (*networkKey)->receiveBufferLength;
 
+    /* the fragment buffer and the receive buffer are allocated along with the key */
     key = (PRIVATE_ASSOCIATIONKEY *) malloc(
-        size_t(sizeof(PRIVATE_ASSOCIATIONKEY) + maxPDU + 100));
+        size_t(sizeof(PRIVATE_ASSOCIATIONKEY) + maxPDU + 100 + receiveBufferLength));
     if (key == NULL) return EC_MemoryExhausted;
     key->receivePDUQueue = NULL;
 
@@ -2184,6 +2403,10 @@ createAssociationKey(PRIVATE_NETWORKKEY ** networkKey,
     key->maxPDVInput = maxPDU;
     key->fragmentBufferLength = maxPDU + 100;
     key->fragmentBuffer = (unsigned char *) key + sizeof(*key);
+    key->receiveBufferLength = receiveBufferLength;
+    key->receiveBufferStart = 0;
+    key->receiveBufferEnd = 0;
+    key->receiveBuffer = key->fragmentBuffer + key->fragmentBufferLength;
 
     key->pdvList.count = 0;
     key->pdvList.scratch = key->fragmentBuffer;
@@ -2362,6 +2585,8 @@ DUL_DumpParams(OFString& ret_str, DUL_ASSOCIATESERVICEPARAMETERS * params)
         << "AP TITLE:     " << params->respondingAPTitle << OFendl
         << "MAX PDU:      " << (int)params->maxPDU << OFendl
         << "Peer MAX PDU: " << (int)params->peerMaxPDU << OFendl
+        << "MAX OPS INV:  " << params->maximumOperationsInvoked << OFendl
+        << "MAX OPS PERF: " << params->maximumOperationsPerformed << OFendl
         << "PRES ADDR:    " << params->callingPresentationAddress << OFendl
         << "PRES ADDR:    " << params->calledPresentationAddress << OFendl
         << "REQ IMP UID:  " << params->callingImplementationClassUID << OFendl;
@@ -2699,6 +2924,24 @@ OFCondition DUL_setTransportLayer(DUL_NETWORKKEY *callerNetworkKey, DcmTransport
   return DUL_NULLKEY;
 }
 
+OFCondition DUL_setReceiveBufferSize(DUL_NETWORKKEY *callerNetworkKey, Uint32 size)
+{
+  if (callerNetworkKey)
+  {
+    PRIVATE_NETWORKKEY * key = (PRIVATE_NETWORKKEY *) callerNetworkKey;
+    key->receiveBufferLength = size;
+    return EC_Normal;
+  }
+  return DUL_NULLKEY;
+}
+
+Uint32 DUL_getReceiveBufferSize(DUL_NETWORKKEY *callerNetworkKey)
+{
+  if (callerNetworkKey)
+    return OFstatic_cast(Uint32, ((PRIVATE_NETWORKKEY *) callerNetworkKey)->receiveBufferLength);
+  return 0;
+}
+
 OFString& DUL_DumpConnectionParameters(OFString& str, DUL_ASSOCIATIONKEY *association)
 {
   if (association)
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -97,6 +97,9 @@ static OFCondition
 constructMaxLength(unsigned long maxPDU, DUL_MAXLENGTH * max,
                    unsigned long *rtnLen);
 static OFCondition
+constructAsyncOperations(unsigned short maxInvoked, unsigned short maxPerformed,
+                         PRV_ASYNCOPERATIONS * async, unsigned long *rtnLen);
+static OFCondition
 constructSCUSCPRoles(unsigned char type,
                      DUL_ASSOCIATESERVICEPARAMETERS * params,
                      LST_HEAD ** lst,
@@ -118,6 +121,9 @@ streamUserInfo(DUL_USERINFO * userInfo, unsigned char *b,
 static OFCondition
 streamMaxLength(DUL_MAXLENGTH * max, unsigned char *b,
                 unsigned long *length);
+static OFCondition
+streamAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *b,
+                      unsigned long *length);
 static OFCondition
     streamSCUSCPList(LST_HEAD ** lst, unsigned char *b, unsigned long *length);
 static OFCondition
@@ -845,7 +851,15 @@ constructUserInfo(unsigned char type, DUL_ASSOCIATESERVICEPARAMETERS * params,
     totalUserInfoLength += length;
     *rtnLen += length;
 
-    // user info sub-item 53H (async operations) is not yet implemented!
+    // construct user info sub-item 53H: asynchronous operations window.
+    // The sub-item is omitted if both values are zero (i.e. not negotiated).
+    if ((params->maximumOperationsInvoked != 0) || (params->maximumOperationsPerformed != 0)) {
+        cond = constructAsyncOperations(params->maximumOperationsInvoked,
+            params->maximumOperationsPerformed, &userInfo->asyncOperations, &length);
+        if (cond.bad()) return cond;
+        totalUserInfoLength += length;
+        *rtnLen += length;
+    }
 
     // construct user info sub-item 55H: implementation version name
     if (type == DUL_TYPEASSOCIATERQ) {
@@ -945,6 +959,38 @@ constructMaxLength(unsigned long maxPDU, DUL_MAXLENGTH * max,
 }
 
 
+/* constructAsyncOperations
+**
+** Purpose:
+**  Construct the Asynchronous Operations Window sub-item of the PDU
+**
+** Parameter Dictionary:
+**  maxInvoked    Maximum number of operations invoked
+**  maxPerformed  Maximum number of operations performed
+**  async         Pointer to structure to receive the sub-item
+**  rtnLen        Length of the sub-item constructed
+**
+** Return Values:
+**
+** Algorithm:
+**  Description of the algorithm (optional) and any other notes.
+*/
+
+static OFCondition
+constructAsyncOperations(unsigned short maxInvoked, unsigned short maxPerformed,
+       PRV_ASYNCOPERATIONS * async, unsigned long *rtnLen)
+{
+    async->type = DUL_TYPEASYNCOPERATIONS;
+    async->rsv1 = 0;
+    async->length = 4;
+    async->maximumOperationsInvoked = maxInvoked;
+    async->maximumOperationsPerformed = maxPerformed;
+    *rtnLen = 8;
+
+    return EC_Normal;
+}
+
+
 /* constructSCUSCPRoles
 **
 ** Purpose:
@@ -1295,7 +1341,14 @@ streamUserInfo(DUL_USERINFO * userInfo, unsigned char *b,
     b += subLength;
     *length += subLength;
 
-    // user info sub-item 53H (async operations) is not yet implemented!
+    // stream user info sub-item 53H: asynchronous operations window
+    if (userInfo->asyncOperations.length != 0) {
+        cond = streamAsyncOperations(&userInfo->asyncOperations, b, &subLength);
+        if (cond.bad())
+            return cond;
+        b += subLength;
+        *length += subLength;
+    }
 
 #ifdef OLD_USER_INFO_SUB_ITEM_ORDER
     /* prior DCMTK releases did not encode user information sub items
@@ -1386,6 +1439,40 @@ streamMaxLength(DUL_MAXLENGTH * max, unsigned char *b,
     return EC_Normal;
 }
 
+/* streamAsyncOperations
+**
+** Purpose:
+**  Convert the Asynchronous Operations Window sub-item into stream format
+**
+** Parameter Dictionary:
+**  async     The sub-item to be streamed
+**  b         The stream version (output)
+**  length    Length of the stream version
+**
+** Return Values:
+**
+** Notes:
+**
+** Algorithm:
+**  Description of the algorithm (optional) and any other notes.
+*/
+static OFCondition
+streamAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *b,
+    unsigned long *length)
+{
+
+    *b++ = async->type;
+    *b++ = async->rsv1;
+    COPY_SHORT_BIG(async->length, b);
+    b += 2;
+    COPY_SHORT_BIG(async->maximumOperationsInvoked, b);
+    b += 2;
+    COPY_SHORT_BIG(async->maximumOperationsPerformed, b);
+
+    *length = 8;
+    return EC_Normal;
+}
+
 /* streamSCUSCPList
 **
 ** Purpose:
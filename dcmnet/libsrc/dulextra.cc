@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -103,9 +103,21 @@ DUL_dataWaiting(DUL_ASSOCIATIONKEY * callerAssociation, int timeout)
 {
     PRIVATE_ASSOCIATIONKEY * association = (PRIVATE_ASSOCIATIONKEY *)callerAssociation;
     if ((association==NULL)||(association->connection == NULL)) return OFFalse;
+    /* data that has already been received is available immediately */
+    if (DUL_dataBuffered(callerAssociation)) return OFTrue;
     return association->connection->networkDataAvailable(timeout);
 }
 
+OFBool
+DUL_dataBuffered(DUL_ASSOCIATIONKEY * callerAssociation)
+{
+    PRIVATE_ASSOCIATIONKEY * association = (PRIVATE_ASSOCIATIONKEY *)callerAssociation;
+    if (association == NULL) return OFFalse;
+    /* unprocessed PDVs of the last PDU received, or data in the receive buffer */
+    return (association->pdvIndex != -1) ||
+           (association->receiveBufferStart != association->receiveBufferEnd);
+}
+
 DcmTransportConnection *DUL_getTransportConnection(DUL_ASSOCIATIONKEY * callerAssociation)
 {
   if (callerAssociation == NULL) return NULL;
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2012, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -85,6 +85,10 @@
 #include <fcntl.h>
 #endif
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/socket.h>
+#include <sys/sendfile.h>       /* for sendfile() */
+#endif
 
 BEGIN_EXTERN_C
 #ifdef HAVE_NETINET_IN_SYSTM_H
@@ -117,6 +121,7 @@ END_EXTERN_C
 #include "dcmtk/dcmnet/dcmlayer.h"
 #include "dcmtk/dcmnet/diutil.h"
 #include "dcmtk/ofstd/ofnetdb.h"
+#include "dcmtk/ofstd/ofvector.h"
 
 /* At least Solaris doesn't define this */
 #ifndef INADDR_NONE
@@ -240,6 +245,9 @@ sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
 static OFCondition
 writeDataPDU(PRIVATE_ASSOCIATIONKEY ** association,
              DUL_DATAPDU * pdu);
+static OFCondition
+writeBuffers(PRIVATE_ASSOCIATIONKEY ** association,
+             DcmTransportBuffer * buffers, int count, const char *routine);
 static void clearPDUCache(PRIVATE_ASSOCIATIONKEY ** association);
 static void closeTransport(PRIVATE_ASSOCIATIONKEY ** association);
 static void closeTransportTCP(PRIVATE_ASSOCIATIONKEY ** association);
@@ -273,7 +281,7 @@ readPDUBodyTCP(PRIVATE_ASSOCIATIONKEY ** association,
                unsigned char *pduType, unsigned char *pduReserved,
                unsigned long *pduLength);
 static OFCondition
-defragmentTCP(DcmTransportConnection *connection, DUL_BLOCKOPTIONS block, time_t timerStart,
+defragmentTCP(PRIVATE_ASSOCIATIONKEY ** association, DUL_BLOCKOPTIONS block, time_t timerStart,
               int timeout, void *b, unsigned long l, unsigned long *rtnLen);
 
 static OFString dump_pdu(const char *type, void *buffer, unsigned long length);
@@ -994,6 +1002,10 @@ AE_3_AssociateConfirmationAccept(PRIVATE_NETWORKKEY ** /*network*/,
         (*association)->maxPDV = assoc.userInfo.maxLength.maxLength;
         (*association)->maxPDVAcceptor =
             assoc.userInfo.maxLength.maxLength;
+        service->maximumOperationsInvoked =
+            assoc.userInfo.asyncOperations.maximumOperationsInvoked;
+        service->maximumOperationsPerformed =
+            assoc.userInfo.asyncOperations.maximumOperationsPerformed;
         strcpy(service->calledImplementationClassUID,
                assoc.userInfo.implementationClassUID.data);
         strcpy(service->calledImplementationVersionName,
@@ -1199,6 +1211,10 @@ AE_6_ExamineAssociateRequest(PRIVATE_NETWORKKEY ** /*network*/,
         (*association)->maxPDV = assoc.userInfo.maxLength.maxLength;
         (*association)->maxPDVRequestor =
             assoc.userInfo.maxLength.maxLength;
+        service->maximumOperationsInvoked =
+            assoc.userInfo.asyncOperations.maximumOperationsInvoked;
+        service->maximumOperationsPerformed =
+            assoc.userInfo.asyncOperations.maximumOperationsPerformed;
         strcpy(service->callingImplementationClassUID,
                assoc.userInfo.implementationClassUID.data);
         strcpy(service->callingImplementationVersionName,
@@ -2069,7 +2085,7 @@ AA_6_IgnorePDU(PRIVATE_NETWORKKEY ** /*network*/,
     PDULength = l;
     while (PDULength > 0 && cond.good())
     {
-        cond = defragmentTCP((*association)->connection,
+        cond = defragmentTCP(association,
                              DUL_NOBLOCK, (*association)->timerStart,
                    (*association)->timeout, buffer, sizeof(buffer), &l);
         if (cond.bad()) return cond;
@@ -3018,8 +3034,6 @@ writeDataPDU(PRIVATE_ASSOCIATIONKEY ** association,
         head[24];
     unsigned long
         length;
-    int
-        nbytes;
 
     /* construct a stream variable that will contain PDU head information */
     /* (in detail, this variable will contain PDU type, PDU reserved field, */
@@ -3028,41 +3042,305 @@ writeDataPDU(PRIVATE_ASSOCIATIONKEY ** association,
     OFCondition cond = streamDataPDUHead(pdu, head, sizeof(head), &length);
     if (cond.bad()) return cond;
 
-    /* send the PDU head information (see above) */
-    do
+    /* send the PDU head information (see above) and the PDU's PDV data */
+    /* with a single gather write, directly from the caller's buffer */
+    /* (note that our representation of a PDU can only contain one PDV.) */
+    DcmTransportBuffer buffers[2];
+    buffers[0].data = head;
+    buffers[0].length = OFstatic_cast(size_t, length);
+    buffers[1].data = pdu->presentationDataValue.data;
+    buffers[1].length = OFstatic_cast(size_t, pdu->presentationDataValue.length - 2);
+    return writeBuffers(association, buffers, 2, "writeDataPDU");
+}
+
+/* writeBuffers
+**
+** Purpose:
+**      Send a sequence of memory blocks through the transport connection,
+**      continuing partial writes until all blocks have been sent.
+**
+** Parameter Dictionary:
+**
+**      association     Handle to the Association
+**      buffers         Memory blocks to be sent (modified during the call)
+**      count           Number of memory blocks
+**      routine         Name of the calling routine (for error messages)
+**
+** Return Values:
+**
+**
+** Notes:
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+
+static OFCondition
+writeBuffers(PRIVATE_ASSOCIATIONKEY ** association,
+             DcmTransportBuffer * buffers, int count, const char *routine)
+{
+    ssize_t nbytes;
+    int first = 0;
+    while (first < count)
     {
-      nbytes = (*association)->connection ? (*association)->connection->write((char*)head, size_t(length)) : 0;
-    } while (nbytes == -1 && errno == EINTR);
+        do
+        {
+          nbytes = (*association)->connection ? (*association)->connection->writev(buffers + first, count - first) : 0;
+        } while (nbytes == -1 && errno == EINTR);
+
+        /* if nothing could be sent, return an error */
+        if (nbytes <= 0)
+        {
+            char buf[256];
+            OFString msg = "TCP I/O Error (";
+            msg += OFStandard::strerror(errno, buf, sizeof(buf));
+            msg += ") occurred in routine: ";
+            msg += routine;
+            return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, msg.c_str());
+        }
+
+        /* skip the data already sent and continue with the remainder, if any */
+        size_t sent = OFstatic_cast(size_t, nbytes);
+        while ((first < count) && (sent >= buffers[first].length))
+            sent -= buffers[first++].length;
+        if (first < count)
+        {
+            buffers[first].data = OFstatic_cast(unsigned char *, buffers[first].data) + sent;
+            buffers[first].length -= sent;
+        }
+    }
+
+    /* return ok */
+    return EC_Normal;
+}
 
-    /* if not all head information was sent, return an error */
-    if ((unsigned long) nbytes != length)
+/* PRV_SendPDataBuffers
+**
+** Purpose:
+**      Send a PDV whose data is the concatenation of several memory blocks,
+**      without copying the blocks into a contiguous buffer first (for TCP).
+**
+** Parameter Dictionary:
+**
+**      association     Handle to the Association
+**      pdv             Description of the PDV to be sent (the data field
+**                      is ignored, fragmentLength bytes are taken from
+**                      the memory blocks)
+**      buffers         Memory blocks containing the PDV data
+**      count           Number of memory blocks
+**
+** Return Values:
+**
+**
+** Notes:
+**      If the PDV is larger than the receiver's maximum PDU size, it is
+**      split into several P-DATA-TF PDUs just like in sendPDataTCP().
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+
+OFCondition
+PRV_SendPDataBuffers(PRIVATE_ASSOCIATIONKEY ** association,
+                     DUL_PDV * pdv, const DcmTransportBuffer * buffers, int count)
+{
+    unsigned char
+        head[24];
+    unsigned long
+        length,
+        headLength,
+        pdvLength,
+        maxLength;
+    OFBool localLast;
+    OFBool firstTrip;
+    DUL_DATAPDU dataPDU;
+
+    /* determine the maximum length of the PDV data field (see sendPDataTCP()) */
+    maxLength = (*association)->maxPDV;
+    if (maxLength == 0) maxLength = ASC_MAXIMUMPDUSIZE - 12;
+    else if (maxLength < 14)
     {
-        char buf[256];
-        OFString msg = "TCP I/O Error (";
-        msg += OFStandard::strerror(errno, buf, sizeof(buf));
-        msg += ") occurred in routine: writeDataPDU";
-        return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, msg.c_str());
+       char buf[256];
+       sprintf(buf, "DUL Cannot send P-DATA PDU because receiver's max PDU size of %lu is illegal (must be > 12)", maxLength);
+       return makeDcmnetCondition(DULC_ILLEGALPDULENGTH, OF_error, buf);
     }
+    else maxLength -= 12;
 
-    /* send the PDU's PDV data (note that our representation of a PDU can only contain one PDV.) */
-    do
+    /* PDU head followed by the parts of the memory blocks that go into the PDU */
+    OFVector<DcmTransportBuffer> gather;
+    gather.reserve(count + 1);
+    int index = 0;
+    size_t offset = 0;
+
+    OFCondition cond = EC_Normal;
+    length = pdv->fragmentLength;
+    firstTrip = OFTrue;
+    while ((firstTrip || (length > 0)) && (cond.good()))
     {
-      nbytes = (*association)->connection ? (*association)->connection->write((char*)pdu->presentationDataValue.data,
-        size_t(pdu->presentationDataValue.length - 2)) : 0;
-    } while (nbytes == -1 && errno == EINTR);
+        firstTrip = OFFalse;
+        pdvLength = (length <= maxLength) ? length : maxLength;
+        localLast = ((pdvLength == length) && pdv->lastPDV);
+        cond = constructDataPDU(NULL, pdvLength, pdv->pdvType,
+                       pdv->presentationContextID, localLast, &dataPDU);
+        if (cond.good()) cond = streamDataPDUHead(&dataPDU, head, sizeof(head), &headLength);
+        if (cond.bad()) break;
+
+        gather.clear();
+        DcmTransportBuffer entry;
+        entry.data = head;
+        entry.length = OFstatic_cast(size_t, headLength);
+        gather.push_back(entry);
+
+        /* collect the next pdvLength bytes from the memory blocks */
+        unsigned long remaining = pdvLength;
+        while ((remaining > 0) && (index < count))
+        {
+            size_t n = buffers[index].length - offset;
+            if (n > remaining) n = OFstatic_cast(size_t, remaining);
+            if (n > 0)
+            {
+                entry.data = OFstatic_cast(unsigned char *, buffers[index].data) + offset;
+                entry.length = n;
+                gather.push_back(entry);
+                offset += n;
+                remaining -= OFstatic_cast(unsigned long, n);
+            }
+            if (offset == buffers[index].length)
+            {
+                ++index;
+                offset = 0;
+            }
+        }
+        if (remaining > 0)
+            return makeDcmnetCondition(DULC_ILLEGALPARAMETER, OF_error, "DUL PDV length exceeds the size of the given data blocks");
 
-        /* if not all head information was sent, return an error */
-    if ((unsigned long) nbytes != pdu->presentationDataValue.length - 2)
+        cond = writeBuffers(association, &gather[0], OFstatic_cast(int, gather.size()), "PRV_SendPDataBuffers");
+        length -= pdvLength;
+    }
+    return cond;
+}
+
+/* PRV_SendPDataFromFile
+**
+** Purpose:
+**      Send a P-DATA-TF PDU whose PDV data is read from a file (for TCP).
+**
+** Parameter Dictionary:
+**
+**      association     Handle to the Association
+**      pdv             Description of the PDV to be sent (the data field
+**                      is ignored, fragmentLength bytes are taken from fd)
+**      fd              Descriptor of the file that contains the PDV data
+**      offset          Position of the PDV data in the file
+**
+** Return Values:
+**
+**
+** Notes:
+**      Only the PDU/PDV headers are copied into user space. The PDV data
+**      is passed from the file to the socket by the kernel using sendfile().
+**      Like sendPDataTCP(), PDVs that exceed the maximum PDU size of the
+**      receiver are split into several PDUs.
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+
+OFCondition
+PRV_SendPDataFromFile(PRIVATE_ASSOCIATIONKEY ** association,
+                      DUL_PDV * pdv, int fd, offile_off_t offset)
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    unsigned char
+        head[24];
+    unsigned long
+        length,
+        headLength,
+        pdvLength,
+        maxLength;
+    OFBool localLast;
+    OFBool firstTrip;
+    DUL_DATAPDU dataPDU;
+    ssize_t nbytes;
+    off_t fileOffset = OFstatic_cast(off_t, offset);
+
+    if ((*association)->connection == NULL || !(*association)->connection->isTransparentConnection())
+        return makeDcmnetCondition(DULC_ILLEGALREQUEST, OF_error, "DUL Cannot send PDV data from file on a non-transparent connection");
+    int sock = (*association)->connection->getSocket();
+
+    /* determine the maximum length of the PDV data field (see sendPDataTCP()) */
+    maxLength = (*association)->maxPDV;
+    if (maxLength == 0) maxLength = ASC_MAXIMUMPDUSIZE - 12;
+    else if (maxLength < 14)
     {
-        char buf[256];
-        OFString msg = "TCP I/O Error (";
-        msg += OFStandard::strerror(errno, buf, sizeof(buf));
-        msg += ") occurred in routine: writeDataPDU";
-        return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, msg.c_str());
+       char buf[256];
+       sprintf(buf, "DUL Cannot send P-DATA PDU because receiver's max PDU size of %lu is illegal (must be > 12)", maxLength);
+       return makeDcmnetCondition(DULC_ILLEGALPDULENGTH, OF_error, buf);
     }
+    else maxLength -= 12;
 
-    /* return ok */
-    return EC_Normal;
+    OFCondition cond = EC_Normal;
+    length = pdv->fragmentLength;
+    firstTrip = OFTrue;
+    while ((firstTrip || (length > 0)) && (cond.good()))
+    {
+        firstTrip = OFFalse;
+        pdvLength = (length <= maxLength) ? length : maxLength;
+        localLast = ((pdvLength == length) && pdv->lastPDV);
+        cond = constructDataPDU(NULL, pdvLength, pdv->pdvType,
+                       pdv->presentationContextID, localLast, &dataPDU);
+        if (cond.good()) cond = streamDataPDUHead(&dataPDU, head, sizeof(head), &headLength);
+        if (cond.bad()) break;
+
+        /* send the PDU head; tell the kernel that the PDV data will follow immediately */
+        do
+        {
+#ifdef MSG_MORE
+          nbytes = send(sock, (char *) head, size_t(headLength), MSG_MORE);
+#else
+          nbytes = send(sock, (char *) head, size_t(headLength), 0);
+#endif
+        } while (nbytes == -1 && errno == EINTR);
+
+        if ((unsigned long) nbytes != headLength)
+        {
+            char buf[256];
+            OFString msg = "TCP I/O Error (";
+            msg += OFStandard::strerror(errno, buf, sizeof(buf));
+            msg += ") occurred in routine: PRV_SendPDataFromFile";
+            return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, msg.c_str());
+        }
+
+        /* send the PDV data; sendfile() may transfer less than requested, so loop */
+        unsigned long remaining = pdvLength;
+        while (remaining > 0)
+        {
+            do
+            {
+              nbytes = sendfile(sock, fd, &fileOffset, size_t(remaining));
+            } while (nbytes == -1 && errno == EINTR);
+            if (nbytes <= 0) break;
+            remaining -= OFstatic_cast(unsigned long, nbytes);
+        }
+
+        if (remaining > 0)
+        {
+            char buf[256];
+            OFString msg = "TCP I/O Error (";
+            msg += (nbytes < 0) ? OFStandard::strerror(errno, buf, sizeof(buf)) : "unexpected end of file";
+            msg += ") occurred in routine: PRV_SendPDataFromFile";
+            return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, msg.c_str());
+        }
+        length -= pdvLength;
+    }
+    return cond;
+#else
+    (void) association;
+    (void) pdv;
+    (void) fd;
+    (void) offset;
+    return makeDcmnetCondition(DULC_ILLEGALREQUEST, OF_error, "DUL Sending PDV data from file is not supported on this system");
+#endif
 }
 
 /* closeTransport
@@ -3110,6 +3388,8 @@ closeTransport(PRIVATE_ASSOCIATIONKEY ** association)
 static void
 closeTransportTCP(PRIVATE_ASSOCIATIONKEY ** association)
 {
+  /* discard any data that has been received but not processed */
+  (*association)->receiveBufferStart = (*association)->receiveBufferEnd = 0;
   if ((*association)->connection)
   {
    (*association)->connection->close();
@@ -3428,7 +3708,7 @@ readPDUHeadTCP(PRIVATE_ASSOCIATIONKEY ** association,
 
     /* try to receive PDU header (6 bytes) over the network, mind blocking */
     /* options; in the end, buffer will contain the 6 bytes that were read. */
-    OFCondition cond = defragmentTCP((*association)->connection, block, (*association)->timerStart, timeout, buffer, 6, &length);
+    OFCondition cond = defragmentTCP(association, block, (*association)->timerStart, timeout, buffer, 6, &length);
 
     /* if receiving was not successful, return the corresponding error value */
     if (cond.bad()) return cond;
@@ -3546,7 +3826,7 @@ readPDUBodyTCP(PRIVATE_ASSOCIATIONKEY ** association,
       /* PDVs of the current PDU are (*association)->nextPDULength bytes long. Hence, in detail */
       /* we want to try to receive (*association)->nextPDULength bytes of data on the network) */
       /* The information that was received will be available through the buffer variable. */
-      cond = defragmentTCP((*association)->connection,
+      cond = defragmentTCP(association,
                          block, (*association)->timerStart, timeout,
                          buffer, (*association)->nextPDULength, &length);
     }
@@ -3563,7 +3843,7 @@ readPDUBodyTCP(PRIVATE_ASSOCIATIONKEY ** association,
 **      incoming socket stream.
 **
 ** Parameter Dictionary:
-**      sock            Socket descriptor
+**      association     Handle to the Association
 **      block           Blocking/non-blocking option
 **      timerStart      Time at which the reading operation is started.
 **      timeout         Timeout interval for reading
@@ -3577,6 +3857,12 @@ readPDUBodyTCP(PRIVATE_ASSOCIATIONKEY ** association,
 **
 **
 ** Notes:
+**      Data is taken from the association's receive buffer first. Small
+**      requests (e.g. PDU headers) refill the receive buffer with as much
+**      data as the transport connection delivers in one read() call, so
+**      that subsequent requests can be served from memory. Requests that
+**      are at least as large as the receive buffer are read directly into
+**      the caller's buffer.
 **
 ** Algorithm:
 **      Description of the algorithm (optional) and any other notes.
@@ -3584,10 +3870,13 @@ readPDUBodyTCP(PRIVATE_ASSOCIATIONKEY ** association,
 
 
 static OFCondition
-defragmentTCP(DcmTransportConnection *connection, DUL_BLOCKOPTIONS block, time_t timerStart,
+defragmentTCP(PRIVATE_ASSOCIATIONKEY ** association, DUL_BLOCKOPTIONS block, time_t timerStart,
               int timeout, void *p, unsigned long l, unsigned long *rtnLen)
 {
     unsigned char *b;
+    unsigned char *readBuffer;
+    unsigned long readLength;
+    unsigned long buffered;
     int bytesRead;
 
     /* assign buffer to local variable */
@@ -3598,6 +3887,7 @@ defragmentTCP(DcmTransportConnection *connection, DUL_BLOCKOPTIONS block, time_t
         *rtnLen = 0;
 
     /* if there is no network connection, return an error */
+    DcmTransportConnection *connection = (*association)->connection;
     if (connection == NULL) return DUL_NULLKEY;
 
     int timeToWait = 0;
@@ -3615,6 +3905,33 @@ defragmentTCP(DcmTransportConnection *connection, DUL_BLOCKOPTIONS block, time_t
     /* we won't stop waiting for data until we actually did receive l bytes. */
     while (l > 0)
     {
+        /* take as much data as possible from the receive buffer */
+        buffered = (*association)->receiveBufferEnd - (*association)->receiveBufferStart;
+        if (buffered > 0)
+        {
+            if (buffered > l) buffered = l;
+            (void) memcpy(b, (*association)->receiveBuffer + (*association)->receiveBufferStart, size_t(buffered));
+            (*association)->receiveBufferStart += buffered;
+            if ((*association)->receiveBufferStart == (*association)->receiveBufferEnd)
+                (*association)->receiveBufferStart = (*association)->receiveBufferEnd = 0;
+            b += buffered;
+            l -= buffered;
+            if (rtnLen != NULL)
+                *rtnLen += buffered;
+            continue;
+        }
+
+        /* the receive buffer is empty: read large requests directly into */
+        /* the caller's buffer, refill the receive buffer for small ones */
+        if (l >= (*association)->receiveBufferLength)
+        {
+            readBuffer = b;
+            readLength = l;
+        } else {
+            readBuffer = (*association)->receiveBuffer;
+            readLength = (*association)->receiveBufferLength;
+        }
+
         /* receive data from the network connection; wait until */
         /* we actually did receive data or an error occured */
         do
@@ -3635,17 +3952,22 @@ defragmentTCP(DcmTransportConnection *connection, DUL_BLOCKOPTIONS block, time_t
             }
 
             /* data has become available, now call read(). */
-            bytesRead = connection->read((char*)b, size_t(l));
+            bytesRead = connection->read((char*)readBuffer, size_t(readLength));
 
         } while (bytesRead == -1 && errno == EINTR);
 
         /* if we actually received data, move the buffer pointer to its own end, update the variable */
         /* that determines the end of the first loop, and update the reference parameter return variable */
         if (bytesRead > 0) {
-            b += bytesRead;
-            l -= (unsigned long) bytesRead;
-            if (rtnLen != NULL)
-                *rtnLen += (unsigned long) bytesRead;
+            if (readBuffer == b) {
+                b += bytesRead;
+                l -= (unsigned long) bytesRead;
+                if (rtnLen != NULL)
+                    *rtnLen += (unsigned long) bytesRead;
+            } else {
+                /* the data is copied to the caller's buffer in the next iteration */
+                (*association)->receiveBufferEnd = (unsigned long) bytesRead;
+            }
         } else {
             /* in case we did not receive any data, an error must have occured; return a corresponding result value */
             return DUL_NETWORKCLOSED;
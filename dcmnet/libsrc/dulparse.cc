@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -93,6 +93,9 @@ parseUserInfo(DUL_USERINFO * userInfo,
 static OFCondition
 parseMaxPDU(DUL_MAXLENGTH * max, unsigned char *buf,
             unsigned long *itemLength, unsigned long availData);
+static OFCondition
+parseAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *buf,
+            unsigned long *itemLength, unsigned long availData);
 static OFCondition
     parseDummy(unsigned char *buf, unsigned long *itemLength,
             unsigned long availData);
@@ -491,9 +494,12 @@ parseUserInfo(DUL_USERINFO * userInfo,
             break;
 
         case DUL_TYPEASYNCOPERATIONS:
-            cond = parseDummy(buf, &length, userLength);
+            cond = parseAsyncOperations(&userInfo->asyncOperations, buf, &length, userLength);
+            if (cond.bad())
+                return cond;
             buf += length;
             userLength -= (unsigned short) length;
+            DCMNET_TRACE("Successfully parsed Asynchronous Operations Window");
             break;
         case DUL_TYPESCUSCPROLE:
             role = (PRV_SCUSCPROLE*)malloc(sizeof(PRV_SCUSCPROLE));
@@ -597,6 +603,50 @@ parseMaxPDU(DUL_MAXLENGTH * max, unsigned char *buf,
     return EC_Normal;
 }
 
+/* parseAsyncOperations
+**
+** Purpose:
+**      Parse the buffer and extract the Asynchronous Operations Window
+**      sub-item.
+**
+** Parameter Dictionary:
+**      async           The structure to hold the Asynchronous Operations Window
+**      buf             The buffer that is to be parsed
+**      itemLength      Length of structure extracted.
+**
+** Return Values:
+**
+** Notes:
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+static OFCondition
+parseAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *buf,
+            unsigned long *itemLength, unsigned long availData)
+{
+    // We want to read 8 bytes of data, is there enough data?
+    if (availData < 8)
+        return makeLengthError("Asynchronous Operations Window", availData, 8);
+
+    async->type = *buf++;
+    async->rsv1 = *buf++;
+    EXTRACT_SHORT_BIG(buf, async->length);
+    buf += 2;
+    EXTRACT_SHORT_BIG(buf, async->maximumOperationsInvoked);
+    buf += 2;
+    EXTRACT_SHORT_BIG(buf, async->maximumOperationsPerformed);
+    *itemLength = 2 + 2 + async->length;
+
+    if (async->length != 4)
+        DCMNET_WARN("Invalid length (" << async->length << ") for asynchronous operations window item, must be 4");
+
+    DCMNET_TRACE("Maximum Number Operations Invoked: " << async->maximumOperationsInvoked << OFendl
+        << "Maximum Number Operations Performed: " << async->maximumOperationsPerformed);
+
+    return EC_Normal;
+}
+
 /* parseDummy
 **
 ** Purpose:
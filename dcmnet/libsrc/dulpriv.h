@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -108,6 +108,12 @@ OFCondition
 parseAssociate(unsigned char *buf, unsigned long len,
 	       PRV_ASSOCIATEPDU * pdu);
 OFCondition
+PRV_SendPDataFromFile(PRIVATE_ASSOCIATIONKEY ** association,
+		      DUL_PDV * pdv, int fd, offile_off_t offset);
+OFCondition
+PRV_SendPDataBuffers(PRIVATE_ASSOCIATIONKEY ** association,
+		     DUL_PDV * pdv, const DcmTransportBuffer * buffers, int count);
+OFCondition
 PRV_NextPDUType(PRIVATE_ASSOCIATIONKEY ** association,
 		DUL_BLOCKOPTIONS block, int timeout, unsigned char *type);
 
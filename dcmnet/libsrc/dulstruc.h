@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -97,6 +97,7 @@ typedef struct {
     int protocolState;
     int timeout;
     unsigned long options;
+    unsigned long receiveBufferLength;
     union {
   struct {
       int port;
@@ -146,6 +147,10 @@ typedef struct {
     unsigned char *pdvPointer;
     unsigned long fragmentBufferLength;
     unsigned char *fragmentBuffer;
+    unsigned long receiveBufferLength;
+    unsigned long receiveBufferStart;
+    unsigned long receiveBufferEnd;
+    unsigned char *receiveBuffer;
     DUL_ModeCallback *modeCallback;
 }   PRIVATE_ASSOCIATIONKEY;
 
@@ -190,7 +195,7 @@ typedef struct {
     unsigned char rsv1;
     unsigned short length;
     unsigned short maximumOperationsInvoked;
-    unsigned short maximumOperationsProvided;
+    unsigned short maximumOperationsPerformed;
 }   PRV_ASYNCOPERATIONS;
 
 typedef struct {
@@ -238,7 +243,7 @@ typedef struct user_info {
     unsigned char rsv1;
     unsigned short length;
     DUL_MAXLENGTH maxLength;                             // 51H: maximum length
-    PRV_ASYNCOPERATIONS asyncOperations;                 // 53H: async operations (not yet implemented!)
+    PRV_ASYNCOPERATIONS asyncOperations;                 // 53H: asynchronous operations window
     DUL_SUBITEM implementationClassUID;                  // 52H: implementation class UID
     DUL_SUBITEM implementationVersionName;               // 55H: implementation version name
     LST_HEAD *SCUSCPRoleList;                            // 54H: SCP/SCU role selection
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2009-2014, OFFIS e.V.
+ *  Copyright (C) 2009-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -112,6 +112,9 @@ OFCondition DcmSCP::listen()
   if( cond.bad() )
     return cond;
 
+  // Use the configured receive buffer size for all associations accepted on this network
+  ASC_setReceiveBufferSize(network, m_cfg->getReceiveBufferSize());
+
   // drop root privileges now and revert to the calling user id (if we are running as setuid root)
   cond = OFStandard::dropPrivileges();
   if (cond.bad())
@@ -333,6 +336,17 @@ OFCondition DcmSCP::waitForAssociationRQ(T_ASC_Network *network)
 
 
 OFCondition DcmSCP::processAssociationRQ()
+{
+  OFCondition cond = acceptOrRefuseAssociationRQ();
+  // Go ahead and handle the association (i.e. handle the callers requests) in this process
+  if( cond.good() && isConnected() )
+    handleAssociation();
+  return cond;
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmSCP::acceptOrRefuseAssociationRQ()
 {
   DcmSCPActionType desiredAction = DCMSCP_ACTION_UNDEFINED;
   if ( (m_assoc == NULL) || (m_assoc->params == NULL) )
@@ -439,9 +453,7 @@ OFCondition DcmSCP::processAssociationRQ()
   else
     DCMNET_DEBUG(ASC_dumpParameters(tempStr, m_assoc->params, ASC_ASSOC_AC));
 
-   // Go ahead and handle the association (i.e. handle the callers requests) in this process
-   handleAssociation();
-   return EC_Normal;
+  return EC_Normal;
 }
 
 // ----------------------------------------------------------------------------
@@ -459,6 +471,21 @@ OFCondition DcmSCP::negotiateAssociation()
     OFString tempStr;
     DCMNET_ERROR(DimseCondition::dump(tempStr, result));
   }
+  else
+  {
+    // Accept asynchronous operations window (if proposed by the SCU and configured)
+    const Uint16 maxOpsPerformed = m_cfg->getMaxOperationsPerformed();
+    unsigned short maxOpsInvoked = 1;
+    unsigned short dummy = 1;
+    if ((maxOpsPerformed != 1) && ASC_getAsyncOperationsWindow(m_assoc->params, maxOpsInvoked, dummy).good())
+    {
+      // use the minimum of both values (0 means "unlimited")
+      if ((maxOpsInvoked == 0) || ((maxOpsPerformed != 0) && (maxOpsPerformed < maxOpsInvoked)))
+        maxOpsInvoked = maxOpsPerformed;
+      // we never invoke any operations on the SCU asynchronously
+      result = ASC_setAsyncOperationsWindow(m_assoc->params, maxOpsInvoked, 1 /* operations performed */);
+    }
+  }
   return result;
 }
 
@@ -501,24 +528,46 @@ void DcmSCP::handleAssociation()
   // or that the peer requested the release of the association (DUL_PEERREQUESTEDRELEASE).) (Also note
   // that ReceiveAndHandleCommands() will never return EC_Normal.)
   OFCondition cond = EC_Normal;
-  T_DIMSE_Message message;
-  T_ASC_PresentationContextID presID;
 
   // start a loop to be able to receive more than one DIMSE command
   while( cond.good() )
   {
-    // receive a DIMSE command over the network
-    cond = DIMSE_receiveCommand( m_assoc, m_cfg->getDIMSEBlockingMode(), m_cfg->getDIMSETimeout(),
-                                 &presID, &message, NULL );
+    cond = receiveAndHandleCommand();
+  }
+  terminateAssociation(cond);
+}
 
-    // check if peer did release or abort, or if we have a valid message
-    if( cond.good() )
-    {
-      DcmPresentationContextInfo presInfo;
-      getPresentationContextInfo(m_assoc, presID, presInfo);
-      cond = handleIncomingCommand(&message, presInfo);
-    }
+// ----------------------------------------------------------------------------
+
+OFCondition DcmSCP::receiveAndHandleCommand()
+{
+  if (m_assoc == NULL)
+    return DIMSE_ILLEGALASSOCIATION;
+
+  T_DIMSE_Message message;
+  T_ASC_PresentationContextID presID;
+
+  // receive a DIMSE command over the network
+  OFCondition cond = DIMSE_receiveCommand( m_assoc, m_cfg->getDIMSEBlockingMode(), m_cfg->getDIMSETimeout(),
+                                           &presID, &message, NULL );
+
+  // check if peer did release or abort, or if we have a valid message
+  if( cond.good() )
+  {
+    DcmPresentationContextInfo presInfo;
+    getPresentationContextInfo(m_assoc, presID, presInfo);
+    cond = handleIncomingCommand(&message, presInfo);
   }
+  return cond;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmSCP::terminateAssociation(const OFCondition &cond)
+{
+  if (m_assoc == NULL)
+    return;
+
   // Clean up on association termination.
   if( cond == DUL_PEERREQUESTEDRELEASE )
   {
@@ -1624,6 +1673,20 @@ void DcmSCP::setMaxReceivePDULength(const Uint32 maxRecPDU)
 
 // ----------------------------------------------------------------------------
 
+void DcmSCP::setReceiveBufferSize(const Uint32 bufferSize)
+{
+  m_cfg->setReceiveBufferSize(bufferSize);
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmSCP::setMaxOperationsPerformed(const Uint16 maxOperations)
+{
+  m_cfg->setMaxOperationsPerformed(maxOperations);
+}
+
+// ----------------------------------------------------------------------------
+
 OFCondition DcmSCP::addPresentationContext(const OFString &abstractSyntax,
                                            const OFList<OFString> xferSyntaxes,
                                            const T_ASC_SC_ROLE role,
@@ -1741,6 +1804,20 @@ Uint32 DcmSCP::getMaxReceivePDULength() const
 
 // ----------------------------------------------------------------------------
 
+Uint32 DcmSCP::getReceiveBufferSize() const
+{
+  return m_cfg->getReceiveBufferSize();
+}
+
+// ----------------------------------------------------------------------------
+
+Uint16 DcmSCP::getMaxOperationsPerformed() const
+{
+  return m_cfg->getMaxOperationsPerformed();
+}
+
+// ----------------------------------------------------------------------------
+
 Uint16 DcmSCP::getPort() const
 {
   return m_cfg->getPort();
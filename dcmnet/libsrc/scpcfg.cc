@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2012-2014, OFFIS e.V.
+ *  Copyright (C) 2012-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -33,6 +33,8 @@ DcmSCPConfig::DcmSCPConfig() :
   m_aetitle("DCMTK_SCP"),
   m_refuseAssociation(OFFalse),
   m_maxReceivePDULength(ASC_DEFAULTMAXPDU),
+  m_receiveBufferSize(dcmReceiveBufferSize.get()),
+  m_maxOperationsPerformed(1),
   m_connectionBlockingMode(DUL_BLOCK),
   m_dimseBlockingMode(DIMSE_BLOCKING),
   m_dimseTimeout(0),
@@ -60,6 +62,8 @@ DcmSCPConfig::DcmSCPConfig(const DcmSCPConfig &old) :
   m_aetitle(old.m_aetitle),
   m_refuseAssociation(old.m_refuseAssociation),
   m_maxReceivePDULength(old.m_maxReceivePDULength),
+  m_receiveBufferSize(old.m_receiveBufferSize),
+  m_maxOperationsPerformed(old.m_maxOperationsPerformed),
   m_connectionBlockingMode(old.m_connectionBlockingMode),
   m_dimseBlockingMode(old.m_dimseBlockingMode),
   m_dimseTimeout(old.m_dimseTimeout),
@@ -85,6 +89,8 @@ DcmSCPConfig& DcmSCPConfig::operator=(const DcmSCPConfig &obj)
     m_aetitle = obj.m_aetitle;
     m_refuseAssociation = obj.m_refuseAssociation;
     m_maxReceivePDULength = obj.m_maxReceivePDULength;
+    m_receiveBufferSize = obj.m_receiveBufferSize;
+    m_maxOperationsPerformed = obj.m_maxOperationsPerformed;
     m_connectionBlockingMode = obj.m_connectionBlockingMode;
     m_dimseBlockingMode = obj.m_dimseBlockingMode;
     m_dimseTimeout = obj.m_dimseTimeout;
@@ -120,6 +126,20 @@ void DcmSCPConfig::setMaxReceivePDULength(const Uint32 maxRecPDU)
 
 // ----------------------------------------------------------------------------
 
+void DcmSCPConfig::setReceiveBufferSize(const Uint32 bufferSize)
+{
+  m_receiveBufferSize = bufferSize;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmSCPConfig::setMaxOperationsPerformed(const Uint16 maxOperations)
+{
+  m_maxOperationsPerformed = maxOperations;
+}
+
+// ----------------------------------------------------------------------------
+
 void DcmSCPConfig::setPort(const Uint16 port)
 {
   m_port = port;
@@ -214,6 +234,20 @@ Uint32 DcmSCPConfig::getMaxReceivePDULength() const
 
 // ----------------------------------------------------------------------------
 
+Uint32 DcmSCPConfig::getReceiveBufferSize() const
+{
+  return m_receiveBufferSize;
+}
+
+// ----------------------------------------------------------------------------
+
+Uint16 DcmSCPConfig::getMaxOperationsPerformed() const
+{
+  return m_maxOperationsPerformed;
+}
+
+// ----------------------------------------------------------------------------
+
 Uint16 DcmSCPConfig::getPort() const
 {
   return m_port;
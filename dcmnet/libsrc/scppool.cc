@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2012-2014, OFFIS e.V.
+ *  Copyright (C) 2012-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -28,6 +28,77 @@
 
 #include "dcmtk/dcmnet/scppool.h"
 #include "dcmtk/dcmnet/diutil.h"
+#include "dcmtk/dcmnet/dcompat.h"     /* for the socket API */
+#include "dcmtk/dcmnet/dcmtrans.h"
+#include "dcmtk/dcmnet/dul.h"
+
+/* timeout (in seconds) for waiting for incoming data in event-driven mode,
+ * used for checking the run mode and the DIMSE timeout of idle associations
+ */
+#define SCPPOOL_DISPATCH_TIMEOUT 1
+
+// ----------------------------------------------------------------------------
+
+/* close the given socket */
+static void closeWakeupSocket(int sock)
+{
+#ifdef HAVE_WINSOCK_H
+  (void) closesocket(sock);
+#else
+  (void) close(sock);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+/* create a UDP socket that is connected to itself on the loopback interface.
+ * Sending a datagram to this socket wakes up a thread waiting in select().
+ * In contrast to a pipe, this also works with select() on Windows.
+ */
+static int createWakeupSocket()
+{
+  int sock = OFstatic_cast(int, socket(AF_INET, SOCK_DGRAM, 0));
+  if (sock < 0)
+    return -1;
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+#ifdef HAVE_DECLARATION_SOCKLEN_T
+  socklen_t length = sizeof(addr);
+#elif !defined(HAVE_PROTOTYPE_ACCEPT) || defined(HAVE_INTP_ACCEPT)
+  int length = sizeof(addr);
+#else
+  size_t length = sizeof(addr);
+#endif
+  if ((bind(sock, OFreinterpret_cast(struct sockaddr *, &addr), sizeof(addr)) < 0) ||
+      (getsockname(sock, OFreinterpret_cast(struct sockaddr *, &addr), &length) < 0) ||
+      (connect(sock, OFreinterpret_cast(struct sockaddr *, &addr), sizeof(addr)) < 0))
+  {
+    closeWakeupSocket(sock);
+    return -1;
+  }
+  return sock;
+}
+
+// ----------------------------------------------------------------------------
+
+/* get the socket of the given association, -1 if not available */
+static int getAssociationSocket(T_ASC_Association *assoc)
+{
+  DcmTransportConnection *connection = DUL_getTransportConnection(assoc->DULassociation);
+  return connection ? connection->getSocket() : -1;
+}
+
+/* check whether data of the given association has already been read from its socket */
+static OFBool isDataBuffered(T_ASC_Association *assoc)
+{
+  if (DUL_dataBuffered(assoc->DULassociation)) return OFTrue;
+  DcmTransportConnection *connection = DUL_getTransportConnection(assoc->DULassociation);
+  /* secure connections buffer data of their own */
+  return connection && !connection->isTransparentConnection() && connection->networkDataAvailable(0);
+}
 
 // ----------------------------------------------------------------------------
 
@@ -37,9 +108,20 @@ DcmBaseSCPPool::DcmBaseSCPPool()
     m_workersIdle(),
     m_cfg(),
     m_maxWorkers(5),
+    m_eventDriven(OFFalse),
+    m_maxAssociations(64),
+    m_numAssociations(0),
+    m_readyAssociations(),
+    m_returnedAssociations(),
+    m_readySemaphore(0),
+    m_wakeupSocket(-1),
+    m_workersBusyTimeout(60),
+    m_maxWaiting(0),
+    m_waiting(),
+    m_peakWaiting(0),
+    m_numQueued(0),
+    m_numTimedOut(0),
     m_runMode( LISTEN )
-    // not implemented yet: m_workersBusyTimeout(60),
-    // not implemented yet: m_waiting(),
 {
 }
 
@@ -64,6 +146,17 @@ OFCondition DcmBaseSCPPool::listen()
   if( cond.bad() )
     return cond;
 
+  /* Use the configured receive buffer size for all associations accepted on this network */
+  ASC_setReceiveBufferSize(network, m_cfg.getReceiveBufferSize());
+
+  /* In event-driven mode, a fixed number of workers serves all associations */
+  if (m_eventDriven)
+  {
+    cond = dispatchAssociations(network, sharedConfig);
+    ASC_dropNetwork(&network);
+    return cond;
+  }
+
   /* As long as all is fine (or we have been to busy handling last connection request) keep listening */
   while ( m_runMode == LISTEN && ( cond.good() || (cond == NET_EC_SCPBusy) ) )
   {
@@ -71,9 +164,17 @@ OFCondition DcmBaseSCPPool::listen()
     cond = EC_Normal;
     // Every incoming connection is handled in a new association object
     T_ASC_Association *assoc = NULL;
+    DUL_BLOCKOPTIONS blockMode = m_cfg.getConnectionBlockingMode();
+    int timeout = OFstatic_cast(int, m_cfg.getConnectionTimeout());
+    // Do not wait longer than the first waiting association may wait for a worker
+    if (m_maxWaiting > 0)
+      limitConnectionTimeout(blockMode, timeout);
     // Listen to a socket for timeout seconds for an association request, accepts TCP connection.
     cond = ASC_receiveAssociation( network, &assoc, m_cfg.getMaxReceivePDULength(), NULL, NULL, OFFalse,
-        m_cfg.getConnectionBlockingMode(), OFstatic_cast(int, m_cfg.getConnectionTimeout()) );
+        blockMode, timeout );
+
+    /* Reject associations that have been waiting for a worker for too long */
+    rejectTimedOutAssociations();
 
     /* If we have a connection request, try to find/create a worker to handle it */
     if (cond.good())
@@ -131,7 +232,16 @@ OFCondition DcmBaseSCPPool::listen()
   }
 
   m_workersBusy.clear();
+
+  /* Usually, the workers take over all waiting associations before exiting */
+  OFList<WaitingAssociation> waiting(m_waiting);
+  m_waiting.clear();
   m_criticalSection.unlock();
+  for (OFListIterator(WaitingAssociation) w = waiting.begin(); w != waiting.end(); ++w)
+  {
+    rejectAssociation((*w).assoc, ASC_REASON_SP_PRES_LOCALLIMITEXCEEDED);
+    dropAndDestroyAssociation((*w).assoc);
+  }
 
   /* In the end, clean up the rest of the memory and drop network */
   ASC_dropNetwork(&network);
@@ -139,12 +249,286 @@ OFCondition DcmBaseSCPPool::listen()
   return EC_Normal;
 }
 
+OFCondition DcmBaseSCPPool::dispatchAssociations(T_ASC_Network *network,
+                                                 const DcmSharedSCPConfig& sharedConfig)
+{
+  /* Start the fixed number of workers that handle all associations */
+  OFCondition cond = EC_Normal;
+  OFList<DcmBaseSCPWorker*> workers;
+  for (Uint16 i = 0; i < m_maxWorkers; ++i)
+  {
+    DcmBaseSCPWorker* const worker = createSCPWorker();
+    if (!worker)
+    {
+      cond = EC_MemoryExhausted;
+      break;
+    }
+    worker->setSharedConfig(sharedConfig);
+    if (worker->start() != 0)
+    {
+      delete worker;
+      cond = NET_EC_CannotStartSCPThread;
+      break;
+    }
+    workers.push_back(worker);
+  }
+  m_criticalSection.lock();
+  m_workersBusy = workers;
+  m_criticalSection.unlock();
+  DCMNET_DEBUG("DcmBaseSCPPool: Started " << workers.size() << " DcmSCP worker thread(s) in event-driven mode");
+
+  /* Without wakeup socket, returned associations are only noticed after a timeout */
+  m_wakeupSocket = createWakeupSocket();
+  if (m_wakeupSocket < 0)
+    DCMNET_WARN("DcmBaseSCPPool: Cannot create wakeup socket, returned associations are handled with a delay");
+
+  const int networkSocket = DUL_networkSocket(network->network);
+  const OFBool checkIdleTimeout = (m_cfg.getDIMSEBlockingMode() == DIMSE_NONBLOCKING) && (m_cfg.getDIMSETimeout() > 0);
+  const OFBool checkRequestTimeout = (m_cfg.getACSETimeout() > 0);
+  OFList<DispatchedAssociation> idle;
+  OFListIterator(DispatchedAssociation) it;
+
+  /* Keep dispatching as long as we listen or associations are still served */
+  while (cond.good())
+  {
+    m_criticalSection.lock();
+    const runmode runMode = m_runMode;
+    const size_t numAssociations = m_numAssociations;
+    /* Take over associations returned by the workers */
+    const time_t now = time(NULL);
+    while (m_returnedAssociations.size() > 0)
+    {
+      DispatchedAssociation entry;
+      entry.assoc = m_returnedAssociations.front();
+      entry.state = NEGOTIATED;
+      entry.lastActivity = now;
+      idle.push_back(entry);
+      m_returnedAssociations.pop_front();
+    }
+    m_criticalSection.unlock();
+    if ((runMode != LISTEN) && (numAssociations == 0))
+      break;
+
+    /* Wait for incoming data on the idle associations and connection requests */
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    int maxSocket = -1;
+    OFBool dataBuffered = OFFalse;
+    for (it = idle.begin(); it != idle.end(); ++it)
+    {
+      /* data might already have been read from the socket (receive buffer, secure connections) */
+      if (isDataBuffered((*it).assoc))
+        dataBuffered = OFTrue;
+      const int sock = getAssociationSocket((*it).assoc);
+      if (sock >= 0)
+      {
+#ifdef __MINGW32__
+        FD_SET(OFstatic_cast(unsigned int, sock), &fdset);
+#else
+        FD_SET(sock, &fdset);
+#endif
+        if (sock > maxSocket) maxSocket = sock;
+      }
+    }
+    if ((runMode == LISTEN) && (networkSocket >= 0))
+    {
+#ifdef __MINGW32__
+      FD_SET(OFstatic_cast(unsigned int, networkSocket), &fdset);
+#else
+      FD_SET(networkSocket, &fdset);
+#endif
+      if (networkSocket > maxSocket) maxSocket = networkSocket;
+    }
+    if (m_wakeupSocket >= 0)
+    {
+#ifdef __MINGW32__
+      FD_SET(OFstatic_cast(unsigned int, m_wakeupSocket), &fdset);
+#else
+      FD_SET(m_wakeupSocket, &fdset);
+#endif
+      if (m_wakeupSocket > maxSocket) maxSocket = m_wakeupSocket;
+    }
+    struct timeval t;
+    t.tv_sec = dataBuffered ? 0 : SCPPOOL_DISPATCH_TIMEOUT;
+    t.tv_usec = 0;
+#ifdef HAVE_INTP_SELECT
+    int nfound = select(maxSocket + 1, OFreinterpret_cast(int *, &fdset), NULL, NULL, &t);
+#else
+    int nfound = select(maxSocket + 1, &fdset, NULL, NULL, &t);
+#endif
+    if (nfound < 0)
+    {
+      /* e.g. interrupted by a signal, just try again */
+      FD_ZERO(&fdset);
+    }
+
+    /* Drain the wakeup socket */
+    if ((m_wakeupSocket >= 0) && FD_ISSET(m_wakeupSocket, &fdset))
+    {
+      char buf[16];
+      (void) recv(m_wakeupSocket, buf, sizeof(buf), 0);
+    }
+
+    /* Hand all associations with data available to the workers */
+    const time_t current = time(NULL);
+    it = idle.begin();
+    while (it != idle.end())
+    {
+      const int sock = getAssociationSocket((*it).assoc);
+      if (((sock >= 0) && FD_ISSET(sock, &fdset)) || (dataBuffered && isDataBuffered((*it).assoc)))
+      {
+        m_criticalSection.lock();
+        m_readyAssociations.push_back(*it);
+        m_criticalSection.unlock();
+        m_readySemaphore.post();
+        it = idle.erase(it);
+      }
+      else if (((*it).state == NEGOTIATED) && checkIdleTimeout &&
+               (current - (*it).lastActivity > OFstatic_cast(time_t, m_cfg.getDIMSETimeout())))
+      {
+        DCMNET_WARN("DcmBaseSCPPool: DIMSE timeout on idle association, aborting association");
+        ASC_abortAssociation((*it).assoc);
+        dropAndDestroyAssociation((*it).assoc);
+        m_criticalSection.lock();
+        --m_numAssociations;
+        m_criticalSection.unlock();
+        it = idle.erase(it);
+      }
+      else if (((*it).state != NEGOTIATED) && checkRequestTimeout &&
+               (current - (*it).lastActivity > OFstatic_cast(time_t, m_cfg.getACSETimeout())))
+      {
+        DCMNET_WARN("DcmBaseSCPPool: No association request received within ACSE timeout, closing connection");
+        dropAndDestroyAssociation((*it).assoc);
+        m_criticalSection.lock();
+        --m_numAssociations;
+        m_criticalSection.unlock();
+        it = idle.erase(it);
+      }
+      else
+        ++it;
+    }
+
+    /* Accept incoming connections. Reading the association request might block
+     * until the ACSE timeout, so this is left to a worker as soon as the request
+     * is available, i.e. the new connection is treated like an idle association.
+     */
+    if ((runMode == LISTEN) && (networkSocket >= 0) && FD_ISSET(networkSocket, &fdset))
+    {
+      T_ASC_Association *assoc = NULL;
+      OFCondition result = ASC_receiveTransportConnection( network, &assoc, m_cfg.getMaxReceivePDULength(), OFFalse,
+          DUL_NOBLOCK, 0 );
+      if (result.good())
+      {
+#ifndef HAVE_WINSOCK_H
+        /* select() cannot handle sockets beyond FD_SETSIZE */
+        if (getAssociationSocket(assoc) >= FD_SETSIZE)
+        {
+          DCMNET_WARN("DcmBaseSCPPool: Cannot handle socket of incoming connection, closing connection");
+          dropAndDestroyAssociation(assoc);
+        }
+        else
+#endif
+        {
+          /* Associations beyond the limit are rejected after receiving the request */
+          DispatchedAssociation entry;
+          entry.assoc = assoc;
+          entry.lastActivity = current;
+          m_criticalSection.lock();
+          entry.state = ((m_maxAssociations == 0) || (m_numAssociations < m_maxAssociations)) ? CONNECTED : LIMIT_EXCEEDED;
+          ++m_numAssociations;
+          m_criticalSection.unlock();
+          idle.push_back(entry);
+        }
+      }
+      else if (result == DUL_NOASSOCIATIONREQUEST)
+      {
+        ASC_destroyAssociation( &assoc );
+      }
+      else
+      {
+        dropAndDestroyAssociation(assoc);
+        DCMNET_ERROR("DcmBaseSCPPool: Error receiving association: " << result.text());
+      }
+    }
+  }
+
+  /* Tell the workers to exit, i.e. wake them up without any association */
+  m_criticalSection.lock();
+  m_runMode = SHUTDOWN;
+  m_criticalSection.unlock();
+  for (it = idle.begin(); it != idle.end(); ++it)
+  {
+    if ((*it).state == NEGOTIATED)
+      ASC_abortAssociation((*it).assoc);
+    dropAndDestroyAssociation((*it).assoc);
+  }
+  for (size_t j = 0; j < workers.size(); ++j)
+    m_readySemaphore.post();
+  for (OFListIterator(DcmBaseSCPWorker*) w = workers.begin(); w != workers.end(); ++w)
+  {
+    (*w)->join();
+    delete *w;
+  }
+  m_criticalSection.lock();
+  m_workersBusy.clear();
+  m_numAssociations = 0;
+  if (m_wakeupSocket >= 0)
+    closeWakeupSocket(m_wakeupSocket);
+  m_wakeupSocket = -1;
+  m_criticalSection.unlock();
+  return cond;
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPPool::waitForDispatchedAssociation(DispatchedAssociation& entry)
+{
+  m_readySemaphore.wait();
+  OFBool result = OFFalse;
+  m_criticalSection.lock();
+  /* An empty queue tells the worker to exit */
+  if (m_readyAssociations.size() > 0)
+  {
+    entry = m_readyAssociations.front();
+    m_readyAssociations.pop_front();
+    result = OFTrue;
+  }
+  m_criticalSection.unlock();
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPPool::returnDispatchedAssociation(T_ASC_Association *assoc)
+{
+  m_criticalSection.lock();
+  if (assoc)
+    m_returnedAssociations.push_back(assoc);
+  else
+    --m_numAssociations;
+  m_criticalSection.unlock();
+  wakeupDispatcher();
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPPool::wakeupDispatcher()
+{
+  m_criticalSection.lock();
+  if (m_wakeupSocket >= 0)
+    (void) send(m_wakeupSocket, "", 1, 0);
+  m_criticalSection.unlock();
+}
+
+// ----------------------------------------------------------------------------
+
 void DcmBaseSCPPool::stopAfterCurrentAssociations()
 {
   m_criticalSection.lock();
   if (m_runMode == LISTEN )
     m_runMode = STOP;
   m_criticalSection.unlock();
+  wakeupDispatcher();
 }
 
 // ----------------------------------------------------------------------------
@@ -179,6 +563,112 @@ void DcmBaseSCPPool::setMaxThreads(const Uint16 maxWorkers)
 
 // ----------------------------------------------------------------------------
 
+void DcmBaseSCPPool::setMaxWaitingAssociations(const Uint16 maxWaiting)
+{
+  m_maxWaiting = maxWaiting;
+}
+
+// ----------------------------------------------------------------------------
+
+Uint16 DcmBaseSCPPool::getMaxWaitingAssociations()
+{
+  return m_maxWaiting;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPPool::setWorkersBusyTimeout(const Uint16 timeout)
+{
+  m_workersBusyTimeout = timeout;
+}
+
+// ----------------------------------------------------------------------------
+
+Uint16 DcmBaseSCPPool::getWorkersBusyTimeout()
+{
+  return m_workersBusyTimeout;
+}
+
+// ----------------------------------------------------------------------------
+
+size_t DcmBaseSCPPool::numWaitingAssociations()
+{
+  m_criticalSection.lock();
+  const size_t result = m_waiting.size();
+  m_criticalSection.unlock();
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
+size_t DcmBaseSCPPool::getPeakWaitingAssociations()
+{
+  m_criticalSection.lock();
+  const size_t result = m_peakWaiting;
+  m_criticalSection.unlock();
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
+size_t DcmBaseSCPPool::getNumQueuedAssociations()
+{
+  m_criticalSection.lock();
+  const size_t result = m_numQueued;
+  m_criticalSection.unlock();
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
+size_t DcmBaseSCPPool::getNumTimedOutAssociations()
+{
+  m_criticalSection.lock();
+  const size_t result = m_numTimedOut;
+  m_criticalSection.unlock();
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPPool::setEventDrivenMode(const OFBool enabled)
+{
+  m_eventDriven = enabled;
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPPool::getEventDrivenMode()
+{
+  return m_eventDriven;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPPool::setMaxAssociations(const Uint16 maxAssociations)
+{
+  m_maxAssociations = maxAssociations;
+}
+
+// ----------------------------------------------------------------------------
+
+Uint16 DcmBaseSCPPool::getMaxAssociations()
+{
+  return m_maxAssociations;
+}
+
+// ----------------------------------------------------------------------------
+
+size_t DcmBaseSCPPool::numAssociations()
+{
+  m_criticalSection.lock();
+  const size_t result = m_numAssociations;
+  m_criticalSection.unlock();
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
 OFCondition DcmBaseSCPPool::runAssociation(T_ASC_Association *assoc,
                                            const DcmSharedSCPConfig& sharedConfig)
 {
@@ -192,6 +682,21 @@ OFCondition DcmBaseSCPPool::runAssociation(T_ASC_Association *assoc,
   {
     if (m_workersBusy.size() >= m_maxWorkers)
     {
+      if (m_waiting.size() < m_maxWaiting)
+      {
+        /* Let the association wait until a worker becomes available */
+        WaitingAssociation entry;
+        entry.assoc = assoc;
+        entry.since = time(NULL);
+        m_waiting.push_back(entry);
+        ++m_numQueued;
+        if (m_waiting.size() > m_peakWaiting)
+          m_peakWaiting = m_waiting.size();
+        DCMNET_DEBUG("DcmBaseSCPPool: All workers busy, association is waiting for a worker ("
+          << m_waiting.size() << " waiting)");
+        m_criticalSection.unlock();
+        return EC_Normal;
+      }
       /* No idle workers and maximum of busy workers reached? Return busy */
       result = NET_EC_SCPBusy;
     }
@@ -240,6 +745,96 @@ OFCondition DcmBaseSCPPool::runAssociation(T_ASC_Association *assoc,
 
 // ----------------------------------------------------------------------------
 
+T_ASC_Association* DcmBaseSCPPool::nextWaitingAssociation(DcmBaseSCPPool::DcmBaseSCPWorker* worker,
+                                                          OFCondition result)
+{
+  T_ASC_Association *assoc = NULL;
+  OFList<WaitingAssociation> timedOut;
+  const time_t now = time(NULL);
+  m_criticalSection.lock();
+  while (!assoc && (m_waiting.size() > 0))
+  {
+    WaitingAssociation entry = m_waiting.front();
+    m_waiting.pop_front();
+    if (now - entry.since > OFstatic_cast(time_t, m_workersBusyTimeout))
+    {
+      ++m_numTimedOut;
+      timedOut.push_back(entry);
+    }
+    else
+      assoc = entry.assoc;
+  }
+  /* No more work, remove the worker while still in the critical section */
+  if (!assoc && (m_runMode != SHUTDOWN))
+  {
+    DCMNET_DEBUG("DcmBaseSCPPool: Worker thread #" << worker->threadID() << " exited with error: " << result.text());
+    m_workersBusy.remove(worker);
+    delete worker;
+    worker = NULL;
+  }
+  m_criticalSection.unlock();
+  for (OFListIterator(WaitingAssociation) it = timedOut.begin(); it != timedOut.end(); ++it)
+  {
+    DCMNET_WARN("DcmBaseSCPPool: No worker available within " << m_workersBusyTimeout << " seconds, rejecting association");
+    rejectAssociation((*it).assoc, ASC_REASON_SP_PRES_LOCALLIMITEXCEEDED);
+    dropAndDestroyAssociation((*it).assoc);
+  }
+  if (assoc)
+    DCMNET_DEBUG("DcmBaseSCPPool: Worker thread #" << worker->threadID() << " takes over waiting association");
+  return assoc;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPPool::rejectTimedOutAssociations()
+{
+  OFList<WaitingAssociation> timedOut;
+  const time_t now = time(NULL);
+  m_criticalSection.lock();
+  OFListIterator(WaitingAssociation) it = m_waiting.begin();
+  while (it != m_waiting.end())
+  {
+    if (now - (*it).since > OFstatic_cast(time_t, m_workersBusyTimeout))
+    {
+      ++m_numTimedOut;
+      timedOut.push_back(*it);
+      it = m_waiting.erase(it);
+    }
+    else
+      ++it;
+  }
+  m_criticalSection.unlock();
+  for (it = timedOut.begin(); it != timedOut.end(); ++it)
+  {
+    DCMNET_WARN("DcmBaseSCPPool: No worker available within " << m_workersBusyTimeout << " seconds, rejecting association");
+    rejectAssociation((*it).assoc, ASC_REASON_SP_PRES_LOCALLIMITEXCEEDED);
+    dropAndDestroyAssociation((*it).assoc);
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPPool::limitConnectionTimeout(DUL_BLOCKOPTIONS& blockMode,
+                                            int& timeout)
+{
+  m_criticalSection.lock();
+  if (m_waiting.size() > 0)
+  {
+    /* The first association has been waiting for the longest time */
+    const time_t deadline = m_waiting.front().since + OFstatic_cast(time_t, m_workersBusyTimeout) + 1;
+    const time_t now = time(NULL);
+    const int remaining = (deadline > now) ? OFstatic_cast(int, deadline - now) : 1;
+    if ((blockMode == DUL_BLOCK) || (remaining < timeout))
+    {
+      blockMode = DUL_NOBLOCK;
+      timeout = remaining;
+    }
+  }
+  m_criticalSection.unlock();
+}
+
+// ----------------------------------------------------------------------------
+
 void DcmBaseSCPPool::rejectAssociation(T_ASC_Association *assoc,
                                        const T_ASC_RejectParametersReason& reason)
 {
@@ -322,6 +917,52 @@ OFCondition DcmBaseSCPPool::DcmBaseSCPWorker::setAssociation(T_ASC_Association*
 void DcmBaseSCPPool::DcmBaseSCPWorker::run()
 {
   OFCondition result;
+  if (m_pool.m_eventDriven)
+  {
+    /* Handle any association that has data available until the pool shuts down */
+    DcmBaseSCPPool::DispatchedAssociation entry;
+    while (m_pool.waitForDispatchedAssociation(entry))
+    {
+      T_ASC_Association *assoc = entry.assoc;
+      if (entry.state == NEGOTIATED)
+        result = workerHandleCommand(assoc);
+      else
+      {
+        /* Only the TCP connection has been accepted so far, read the association request */
+        result = ASC_readAssociationRequest(assoc);
+        if (result.bad())
+        {
+          m_pool.dropAndDestroyAssociation(assoc);
+          assoc = NULL;
+        }
+        else if (entry.state == LIMIT_EXCEEDED)
+        {
+          DCMNET_WARN("DcmBaseSCPPool: Maximum number of associations reached, rejecting association");
+          m_pool.rejectAssociation(assoc, ASC_REASON_SP_PRES_LOCALLIMITEXCEEDED);
+          m_pool.dropAndDestroyAssociation(assoc);
+          assoc = NULL;
+        }
+        else
+          result = workerNegotiate(assoc);
+      }
+      /* Continue with further commands that are already available, e.g. pipelined requests */
+      while (result.good() && assoc && ASC_dataWaiting(assoc, 0))
+        result = workerHandleCommand(assoc);
+      if (result.bad())
+      {
+        DCMNET_ERROR("DcmBaseSCPPool: Worker thread #" << threadID() << " failed handling association: " << result.text());
+        if (assoc)
+        {
+          ASC_abortAssociation(assoc);
+          m_pool.dropAndDestroyAssociation(assoc);
+          assoc = NULL;
+        }
+      }
+      m_pool.returnDispatchedAssociation(assoc);
+    }
+    thread_exit();
+    return;
+  }
   if(!m_assoc)
   {
     DCMNET_ERROR("DcmBaseSCPPool: Worker thread #" << threadID() << " received run command but has no association, exiting");
@@ -332,16 +973,34 @@ void DcmBaseSCPPool::DcmBaseSCPWorker::run()
   {
     T_ASC_Association *param = m_assoc;
     m_assoc = NULL;
-    result = workerListen(param);
-    DCMNET_DEBUG("DcmBaseSCPPool: Worker thread #" << threadID() << " returns with code: " << result.text() );
+    while (param)
+    {
+      result = workerListen(param);
+      DCMNET_DEBUG("DcmBaseSCPPool: Worker thread #" << threadID() << " returns with code: " << result.text() );
+      /* Continue with the next association waiting for a worker (if any), otherwise exit */
+      param = m_pool.nextWaitingAssociation(this, result);
+    }
   }
-  m_pool.notifyThreadExit(this, result);
   thread_exit();
   return;
 }
 
 // ----------------------------------------------------------------------------
 
+OFCondition DcmBaseSCPPool::DcmBaseSCPWorker::workerNegotiate(T_ASC_Association*& /* assoc */)
+{
+  return EC_IllegalCall;
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPPool::DcmBaseSCPWorker::workerHandleCommand(T_ASC_Association*& /* assoc */)
+{
+  return EC_IllegalCall;
+}
+
+// ----------------------------------------------------------------------------
+
 void DcmBaseSCPPool::DcmBaseSCPWorker::exit()
 {
   thread_exit();
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2013, OFFIS e.V.
+ *  Copyright (C) 2013-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -73,3 +73,37 @@ OFCondition DcmThreadSCP::run(T_ASC_Association* incomingAssoc)
 
   return processAssociationRQ();
 }
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmThreadSCP::runNegotiation(T_ASC_Association*& assoc)
+{
+  if ((assoc == NULL) || isConnected())
+    return DIMSE_ILLEGALASSOCIATION;
+
+  m_assoc = assoc;
+  OFCondition result = acceptOrRefuseAssociationRQ();
+  // the association has been dropped and destroyed if it was refused
+  assoc = m_assoc;
+  m_assoc = NULL;
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmThreadSCP::runNextCommand(T_ASC_Association*& assoc)
+{
+  if ((assoc == NULL) || isConnected())
+    return DIMSE_ILLEGALASSOCIATION;
+
+  m_assoc = assoc;
+  OFCondition cond = receiveAndHandleCommand();
+  if (cond.bad())
+  {
+    // peer did release or abort, or an error occurred
+    terminateAssociation(cond);
+  }
+  assoc = m_assoc;
+  m_assoc = NULL;
+  return EC_Normal;
+}
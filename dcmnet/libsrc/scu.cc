@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2008-2014, OFFIS e.V.
+ *  Copyright (C) 2008-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -42,6 +42,9 @@ DcmSCU::DcmSCU() :
   m_assocConfigFile(),
   m_openDIMSERequest(NULL),
   m_maxReceivePDULength(ASC_DEFAULTMAXPDU),
+  m_receiveBufferSize(dcmReceiveBufferSize.get()),
+  m_maxOperationsInvoked(1),
+  m_outstandingRequests(),
   m_blockMode(DIMSE_BLOCKING),
   m_ourAETitle("ANY-SCU"),
   m_peer(),
@@ -94,6 +97,8 @@ void DcmSCU::freeNetwork()
   // Cleanup old DIMSE request if any
   delete m_openDIMSERequest;
   m_openDIMSERequest = NULL;
+  // Forget about requests that have not been responded to
+  m_outstandingRequests.clear();
 }
 
 
@@ -125,6 +130,8 @@ OFCondition DcmSCU::initNetwork()
   OFString tempStr;
   /* initialize network, i.e. create an instance of T_ASC_Network*. */
   OFCondition cond = ASC_initializeNetwork(NET_REQUESTOR, 0, m_acseTimeout, &m_net);
+  if (cond.good())
+    cond = ASC_setReceiveBufferSize(m_net, m_receiveBufferSize);
   if (cond.bad())
   {
     DimseCondition::dump(tempStr, cond);
@@ -140,6 +147,17 @@ OFCondition DcmSCU::initNetwork()
     return cond;
   }
 
+  /* propose an asynchronous operations window if more than one operation is to be invoked */
+  if (m_maxOperationsInvoked != 1)
+  {
+    cond = ASC_setAsyncOperationsWindow(m_params, m_maxOperationsInvoked, 1 /* operations performed */);
+    if (cond.bad())
+    {
+      DCMNET_ERROR(DimseCondition::dump(tempStr, cond));
+      return cond;
+    }
+  }
+
   /* sets this application's title and the called application's title in the params */
   /* structure. The default values are "ANY-SCU" and "ANY-SCP". */
   ASC_setAPTitles(m_params, m_ourAETitle.c_str(), m_peerAETitle.c_str(), NULL);
@@ -678,7 +696,7 @@ OFCondition DcmSCU::sendECHORequest(const T_ASC_PresentationContextID presID)
 /*                            C-STORE functionality                          */
 /* ************************************************************************* */
 
-// Sends C-STORE request to another DICOM application
+// Sends C-STORE request to another DICOM application and waits for the response
 OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
                                      const OFString &dicomFile,
                                      DcmDataset *dataset,
@@ -689,11 +707,49 @@ OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
   // Do some basic validity checks
   if (!isConnected())
     return DIMSE_ILLEGALASSOCIATION;
+  // Responses to asynchronous requests must be received first
+  if (!m_outstandingRequests.empty())
+  {
+    DCMNET_ERROR("Cannot send C-STORE request synchronously, there are still "
+      << m_outstandingRequests.size() << " request(s) awaiting their response");
+    return NET_EC_OutstandingRequests;
+  }
+
+  Uint16 messageID = 0;
+  OFCondition cond = sendSTORERequestAsync(presID, dicomFile, dataset, messageID,
+    moveOriginatorAETitle, moveOriginatorMsgID);
+  if (cond.good())
+  {
+    Uint16 rspMessageID = 0;
+    cond = receiveSTOREResponse(rspMessageID, rspStatusCode);
+  }
+  return cond;
+}
+
+
+// Sends C-STORE request to another DICOM application without waiting for the response
+OFCondition DcmSCU::sendSTORERequestAsync(const T_ASC_PresentationContextID presID,
+                                          const OFString &dicomFile,
+                                          DcmDataset *dataset,
+                                          Uint16 &messageID,
+                                          const OFString &moveOriginatorAETitle,
+                                          const Uint16 moveOriginatorMsgID)
+{
+  // Do some basic validity checks
+  if (!isConnected())
+    return DIMSE_ILLEGALASSOCIATION;
+  // Check whether another request may be invoked (0 means "unlimited")
+  const Uint16 maxOperations = getNegotiatedMaxOperationsInvoked();
+  if ((maxOperations != 0) && (m_outstandingRequests.size() >= maxOperations))
+  {
+    DCMNET_DEBUG("Cannot send C-STORE request, asynchronous operations window is full ("
+      << m_outstandingRequests.size() << " outstanding request(s))");
+    return NET_EC_AsyncOperationsWindowFull;
+  }
 
   OFCondition cond;
   OFString tempStr;
   T_ASC_PresentationContextID pcid = presID;
-  DcmDataset* statusDetail = NULL;
   T_DIMSE_Message msg;
   // Make sure everything is zeroed (especially options)
   bzero((char*)&msg, sizeof(msg));
@@ -819,6 +875,25 @@ OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
     DCMNET_ERROR("Failed sending C-STORE request: " << DimseCondition::dump(tempStr, cond));
     return cond;
   }
+  /* Remember request until the matching response has been received */
+  messageID = req->MessageID;
+  m_outstandingRequests.push_back(messageID);
+  return cond;
+}
+
+
+// Receives C-STORE response to a request sent before
+OFCondition DcmSCU::receiveSTOREResponse(Uint16 &messageID,
+                                         Uint16 &rspStatusCode)
+{
+  // Do some basic validity checks
+  if (!isConnected())
+    return DIMSE_ILLEGALASSOCIATION;
+
+  OFCondition cond;
+  OFString tempStr;
+  T_ASC_PresentationContextID pcid = 0;
+  DcmDataset* statusDetail = NULL;
 
   /* Receive response */
   T_DIMSE_Message rsp;
@@ -849,7 +924,19 @@ OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
     return DIMSE_BADCOMMANDTYPE;
   }
   T_DIMSE_C_StoreRSP storeRsp = rsp.msg.CStoreRSP;
+  messageID = storeRsp.MessageIDBeingRespondedTo;
   rspStatusCode = storeRsp.DimseStatus;
+  /* Check whether this response belongs to one of our outstanding requests */
+  OFListIterator(Uint16) it = m_outstandingRequests.begin();
+  while ((it != m_outstandingRequests.end()) && (*it != messageID))
+    ++it;
+  if (it == m_outstandingRequests.end())
+  {
+    DCMNET_ERROR("Received C-STORE response for unknown request (MsgID " << messageID << ")");
+    delete statusDetail;
+    return NET_EC_UnexpectedMessageID;
+  }
+  m_outstandingRequests.erase(it);
   if (statusDetail != NULL)
   {
     DCMNET_DEBUG("Response has status detail:" << OFendl << DcmObject::PrintHelper(*statusDetail));
@@ -2254,6 +2341,18 @@ void DcmSCU::setMaxReceivePDULength(const Uint32 maxRecPDU)
 }
 
 
+void DcmSCU::setReceiveBufferSize(const Uint32 bufferSize)
+{
+  m_receiveBufferSize = bufferSize;
+}
+
+
+void DcmSCU::setMaxOperationsInvoked(const Uint16 maxOperations)
+{
+  m_maxOperationsInvoked = maxOperations;
+}
+
+
 void DcmSCU::setDIMSEBlockingMode(const T_DIMSE_BlockingMode blockingMode)
 {
   m_blockMode = blockingMode;
@@ -2353,6 +2452,39 @@ Uint32 DcmSCU::getMaxReceivePDULength() const
 }
 
 
+Uint32 DcmSCU::getReceiveBufferSize() const
+{
+  return m_receiveBufferSize;
+}
+
+
+Uint16 DcmSCU::getMaxOperationsInvoked() const
+{
+  return m_maxOperationsInvoked;
+}
+
+
+Uint16 DcmSCU::getNegotiatedMaxOperationsInvoked() const
+{
+  if (!isConnected())
+    return 1;
+  unsigned short maxOpsInvoked = 1;
+  unsigned short maxOpsPerformed = 1;
+  if (ASC_getAsyncOperationsWindow(m_assoc->params, maxOpsInvoked, maxOpsPerformed).bad())
+    return 1;
+  /* never exceed what we have proposed ourselves (0 means "unlimited") */
+  if ((maxOpsInvoked == 0) || ((m_maxOperationsInvoked != 0) && (m_maxOperationsInvoked < maxOpsInvoked)))
+    maxOpsInvoked = m_maxOperationsInvoked;
+  return maxOpsInvoked;
+}
+
+
+size_t DcmSCU::getNumberOfOutstandingRequests() const
+{
+  return m_outstandingRequests.size();
+}
+
+
 OFBool DcmSCU::getTLSEnabled() const
 {
   return OFFalse;
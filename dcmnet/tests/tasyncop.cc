@@ -0,0 +1,171 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test negotiation of the asynchronous operations window and
+ *           pipelined C-STORE requests, including DcmSCP and DcmSCU interaction
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmnet/scu.h"
+#include "dcmtk/dcmnet/dstorscu.h"
+#include "tstorage.h"
+
+#define ASYNC_TEST_PORT 11113
+
+
+/* Storage SCU that counts the SOP instances stored successfully.
+ */
+struct TestStorageSCU : DcmStorageSCU
+{
+    int numSuccess;
+
+    TestStorageSCU()
+    : numSuccess(0)
+    {
+    }
+
+protected:
+    void notifySOPInstanceSent(const TransferEntry &transferEntry)
+    {
+        if (transferEntry.RequestSent && (transferEntry.ResponseStatusCode == STATUS_Success))
+            ++numSuccess;
+    }
+};
+
+
+static void configureSCU(DcmSCU &scu)
+{
+    scu.setAETitle("AsyncTestSCU");
+    scu.setPeerAETitle("AsyncTestSCP");
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(ASYNC_TEST_PORT);
+}
+
+
+/* Test starts an SCP that is willing to perform up to 3 operations
+ * asynchronously. The first SCU proposes a window of 5 operations and
+ * sends C-STORE requests without waiting for the responses until the
+ * negotiated window is full. The second SCU does not propose any window
+ * and, therefore, has to work synchronously. Finally, a storage SCU sends
+ * all instances using the negotiated window.
+ */
+OFTEST_FLAGS(dcmnet_async_operations, EF_Slow)
+{
+    TestStorageSCP scp(3 /* associations */);
+    scp.setAETitle("AsyncTestSCP");
+    scp.setPort(ASYNC_TEST_PORT);
+    scp.setMaxOperationsPerformed(3);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(scp.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    scp.start();
+
+    // "ensure" the SCP is listening before the SCU starts connecting to it
+    OFStandard::sleep(2);
+
+    DcmDataset *datasets[4];
+    for (int i = 0; i < 4; ++i)
+        datasets[i] = createStorageDataset(UID_SecondaryCaptureImageStorage);
+
+    // first association: asynchronous operations window is negotiated
+    DcmSCU scu;
+    configureSCU(scu);
+    scu.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers);
+    scu.setMaxOperationsInvoked(5);
+    OFCHECK(scu.initNetwork().good());
+    OFCHECK(scu.negotiateAssociation().good());
+    OFCHECK_EQUAL(scu.getNegotiatedMaxOperationsInvoked(), 3);
+    const T_ASC_PresentationContextID presID = scu.findPresentationContextID(
+        UID_SecondaryCaptureImageStorage, UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(presID != 0);
+
+    OFList<Uint16> messageIDs;
+    Uint16 messageID = 0;
+    for (int j = 0; j < 3; ++j)
+    {
+        OFCHECK(scu.sendSTORERequestAsync(presID, "", datasets[j], messageID).good());
+        messageIDs.push_back(messageID);
+    }
+    OFCHECK_EQUAL(scu.getNumberOfOutstandingRequests(), 3);
+    // the window is full now
+    OFCHECK(scu.sendSTORERequestAsync(presID, "", datasets[3], messageID) == NET_EC_AsyncOperationsWindowFull);
+    // synchronous requests are not possible while there are outstanding requests
+    Uint16 rspStatusCode = 0xffff;
+    OFCHECK(scu.sendSTORERequest(presID, "", datasets[3], rspStatusCode) == NET_EC_OutstandingRequests);
+    // receive all responses, each of them has to match one of the requests sent
+    for (int k = 0; k < 3; ++k)
+    {
+        rspStatusCode = 0xffff;
+        OFCHECK(scu.receiveSTOREResponse(messageID, rspStatusCode).good());
+        OFCHECK_EQUAL(rspStatusCode, STATUS_Success);
+        const size_t count = messageIDs.size();
+        messageIDs.remove(messageID);
+        OFCHECK_EQUAL(messageIDs.size() + 1, count);
+    }
+    OFCHECK_EQUAL(scu.getNumberOfOutstandingRequests(), 0);
+    // synchronous operation is still possible
+    rspStatusCode = 0xffff;
+    OFCHECK(scu.sendSTORERequest(presID, "", datasets[3], rspStatusCode).good());
+    OFCHECK_EQUAL(rspStatusCode, STATUS_Success);
+    OFCHECK(scu.releaseAssociation().good());
+
+    // second association: no asynchronous operations window proposed
+    DcmSCU syncSCU;
+    configureSCU(syncSCU);
+    syncSCU.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers);
+    OFCHECK(syncSCU.initNetwork().good());
+    OFCHECK(syncSCU.negotiateAssociation().good());
+    OFCHECK_EQUAL(syncSCU.getNegotiatedMaxOperationsInvoked(), 1);
+    const T_ASC_PresentationContextID syncPresID = syncSCU.findPresentationContextID(
+        UID_SecondaryCaptureImageStorage, UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(syncPresID != 0);
+    OFCHECK(syncSCU.sendSTORERequestAsync(syncPresID, "", datasets[1], messageID).good());
+    OFCHECK(syncSCU.sendSTORERequestAsync(syncPresID, "", datasets[2], messageID) == NET_EC_AsyncOperationsWindowFull);
+    OFCHECK(syncSCU.receiveSTOREResponse(messageID, rspStatusCode).good());
+    OFCHECK_EQUAL(rspStatusCode, STATUS_Success);
+    OFCHECK(syncSCU.releaseAssociation().good());
+
+    // third association: storage SCU sends more instances than fit into the window
+    TestStorageSCU storageSCU;
+    configureSCU(storageSCU);
+    storageSCU.setMaxOperationsInvoked(2);
+    for (int m = 0; m < 4; ++m)
+        OFCHECK(storageSCU.addDataset(datasets[m], EXS_LittleEndianImplicit, DcmStorageSCU::HM_doNothing).good());
+    OFCHECK(storageSCU.addPresentationContexts().good());
+    OFCHECK(storageSCU.initNetwork().good());
+    OFCHECK(storageSCU.negotiateAssociation().good());
+    OFCHECK_EQUAL(storageSCU.getNegotiatedMaxOperationsInvoked(), 2);
+    OFCHECK(storageSCU.sendSOPInstances().good());
+    OFCHECK_EQUAL(storageSCU.numSuccess, 4);
+    OFCHECK_EQUAL(storageSCU.getNumberOfOutstandingRequests(), 0);
+    OFCHECK(storageSCU.releaseAssociation().good());
+
+    scp.join();
+    OFCHECK(scp.result.good());
+    OFCHECK_EQUAL(scp.numStoreRequests, 9);
+
+    for (int l = 0; l < 4; ++l)
+        delete datasets[l];
+}
+
+#endif // WITH_THREADS
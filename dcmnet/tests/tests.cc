@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2012-2013, OFFIS e.V.
+ *  Copyright (C) 2012-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -24,9 +24,22 @@
 #include "dcmtk/ofstd/oftest.h"
 
 OFTEST_REGISTER(dcmnet_dimseDump_nullByte);
+OFTEST_REGISTER(dcmnet_receiveBufferSize);
 
 #ifdef WITH_THREADS
 OFTEST_REGISTER(dcmnet_scp_pool);
+OFTEST_REGISTER(dcmnet_scp_pool_event_driven);
+OFTEST_REGISTER(dcmnet_scp_pool_silent_connection);
+OFTEST_REGISTER(dcmnet_scp_pool_waiting);
+OFTEST_REGISTER(dcmnet_scp_pool_waiting_timeout);
+OFTEST_REGISTER(dcmnet_storage_scp_pool);
+OFTEST_REGISTER(dcmnet_async_operations);
+OFTEST_REGISTER(dcmnet_storage_scu_parallel);
+OFTEST_REGISTER(dcmnet_send_straight_file_data);
+OFTEST_REGISTER(dcmnet_write_behind_storage);
+OFTEST_REGISTER(dcmnet_write_behind_storage_on_request);
+OFTEST_REGISTER(dcmnet_receiveBufferSize_scp_pool);
+OFTEST_REGISTER(dcmnet_send_dataset_by_reference);
 #endif // WITH_THREADS
 
 OFTEST_MAIN("dcmnet")
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2013-2014, OFFIS e.V.
+ *  Copyright (C) 2013-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -15,7 +15,8 @@
  *
  *  Author:  Jan Schlamelcher
  *
- *  Purpose: Test DcmSCPPool class, including DcmSCP and DcmSCU interaction
+ *  Purpose: Test DcmSCPPool and DcmStorageSCPPool classes, including DcmSCP
+ *           and DcmSCU interaction
  *
  */
 
@@ -26,7 +27,14 @@
 
 #include "dcmtk/ofstd/oftest.h"
 #include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmnet/dstorpool.h"
 #include "dcmtk/dcmnet/scu.h"
+#include "dcmtk/dcmnet/dcompat.h"     /* for the socket API */
+#include "dcmtk/dcmdata/dcuid.h"
+
+#define INCLUDE_CSTDIO
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
 
 struct TestSCU : DcmSCU, OFThread
 {
@@ -40,6 +48,41 @@ protected:
     }
 };
 
+/* SCU that keeps its association open (and idle) for a while */
+struct TestIdleSCU : DcmSCU, OFThread
+{
+    OFCondition result;
+protected:
+    void run()
+    {
+        result = negotiateAssociation();
+        for (int i = 0; (i < 3) && result.good(); ++i)
+        {
+            OFStandard::milliSleep(200);
+            result = sendECHORequest(0);
+        }
+        releaseAssociation();
+    }
+};
+
+/* SCU that keeps its association open (and idle) for the given number of seconds */
+struct TestBusySCU : DcmSCU, OFThread
+{
+    OFCondition result;
+    unsigned int seconds;
+protected:
+    void run()
+    {
+        result = negotiateAssociation();
+        if (result.good())
+        {
+            OFStandard::sleep(seconds);
+            result = sendECHORequest(0);
+        }
+        releaseAssociation();
+    }
+};
+
 struct TestPool : DcmSCPPool<>, OFThread
 {
     OFCondition result;
@@ -50,6 +93,58 @@ protected:
     }
 };
 
+/* close the given socket */
+static void closeSocket(int sock)
+{
+#ifdef HAVE_WINSOCK_H
+    (void) closesocket(sock);
+#else
+    (void) close(sock);
+#endif
+}
+
+/* open a TCP connection to the given port on the loopback interface, -1 on error */
+static int connectSocket(const unsigned short port)
+{
+    int sock = OFstatic_cast(int, socket(AF_INET, SOCK_STREAM, 0));
+    if (sock < 0)
+        return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(sock, OFreinterpret_cast(struct sockaddr *, &addr), sizeof(addr)) < 0)
+    {
+        closeSocket(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/* check whether the given socket has been closed by the peer within the timeout */
+static OFBool socketClosedByPeer(int sock, const int timeout)
+{
+    fd_set fdset;
+    FD_ZERO(&fdset);
+#ifdef __MINGW32__
+    FD_SET(OFstatic_cast(unsigned int, sock), &fdset);
+#else
+    FD_SET(sock, &fdset);
+#endif
+    struct timeval t;
+    t.tv_sec = timeout;
+    t.tv_usec = 0;
+#ifdef HAVE_INTP_SELECT
+    if (select(sock + 1, OFreinterpret_cast(int *, &fdset), NULL, NULL, &t) <= 0)
+#else
+    if (select(sock + 1, &fdset, NULL, NULL, &t) <= 0)
+#endif
+        return OFFalse;
+    char buf[16];
+    return recv(sock, buf, sizeof(buf), 0) <= 0;
+}
+
 
 /* Test starts pool with a maximum of 20 SCP workers. All workers are
  * configured to respond to C-ECHO (Verification SOP Class). 20 SCU
@@ -110,4 +205,394 @@ OFTEST_FLAGS(dcmnet_scp_pool, EF_Slow)
     OFCHECK(pool.result.good());
 }
 
+
+/* Test starts pool in event-driven mode with only 2 SCP workers. 20 SCU
+ * threads connect simultaneously to the pool and keep their associations
+ * open while sending a few C-ECHO messages, i.e. all associations are
+ * served at the same time by the two workers.
+ */
+OFTEST_FLAGS(dcmnet_scp_pool_event_driven, EF_Slow)
+{
+    TestPool pool;
+    DcmSCPConfig& config = pool.getConfig();
+
+    config.setAETitle("PoolTestSCP");
+    config.setPort(11115);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+
+    pool.setEventDrivenMode(OFTrue);
+    pool.setMaxThreads(2);
+    pool.setMaxAssociations(20);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    config.addPresentationContext(UID_VerificationSOPClass, xfers);
+
+    pool.start();
+
+    OFVector<TestIdleSCU*> scus(20);
+    for (OFVector<TestIdleSCU*>::iterator it1 = scus.begin(); it1 != scus.end(); ++it1)
+    {
+        *it1 = new TestIdleSCU;
+        (*it1)->setAETitle("PoolTestSCU");
+        (*it1)->setPeerAETitle("PoolTestSCP");
+        (*it1)->setPeerHostName("localhost");
+        (*it1)->setPeerPort(11115);
+        (*it1)->addPresentationContext(UID_VerificationSOPClass, xfers);
+        (*it1)->initNetwork();
+    }
+
+    // "ensure" the pool is initialized before any SCU starts connecting to it
+    OFStandard::sleep(5);
+
+    for (OFVector<TestIdleSCU*>::const_iterator it2 = scus.begin(); it2 != scus.end(); ++it2)
+        (*it2)->start();
+
+    for (OFVector<TestIdleSCU*>::iterator it3 = scus.begin(); it3 != scus.end(); ++it3)
+    {
+        (*it3)->join();
+        OFCHECK((*it3)->result.good());
+        delete *it3;
+    }
+    // the number of worker threads never changes in event-driven mode
+    OFCHECK_EQUAL(pool.numThreads(OFFalse), 2);
+
+    // Request shutdown.
+    pool.stopAfterCurrentAssociations();
+    pool.join();
+
+    OFCHECK(pool.result.good());
+    OFCHECK_EQUAL(pool.numAssociations(), 0);
+}
+
+
+/* Test starts pool in event-driven mode with a single SCP worker. A client
+ * opens a TCP connection but never sends an association request. This must
+ * neither block the pool nor its worker, i.e. another SCU can still be
+ * served, and the silent connection is closed after the ACSE timeout.
+ */
+OFTEST_FLAGS(dcmnet_scp_pool_silent_connection, EF_Slow)
+{
+    TestPool pool;
+    DcmSCPConfig& config = pool.getConfig();
+
+    config.setAETitle("PoolTestSCP");
+    config.setPort(11121);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+    config.setACSETimeout(5);
+
+    pool.setEventDrivenMode(OFTrue);
+    pool.setMaxThreads(1);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    config.addPresentationContext(UID_VerificationSOPClass, xfers);
+
+    pool.start();
+
+    TestSCU scu;
+    scu.setAETitle("PoolTestSCU");
+    scu.setPeerAETitle("PoolTestSCP");
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(11121);
+    scu.addPresentationContext(UID_VerificationSOPClass, xfers);
+    scu.initNetwork();
+
+    // "ensure" the pool is initialized before any client connects to it
+    OFStandard::sleep(5);
+
+    const int silent = connectSocket(11121);
+    OFCHECK(silent >= 0);
+    // give the pool the chance to accept the silent connection first
+    OFStandard::sleep(1);
+
+    // the SCU is served long before the silent connection is closed
+    const time_t start = time(NULL);
+    scu.start();
+    scu.join();
+    OFCHECK(scu.result.good());
+    OFCHECK(time(NULL) - start < 4);
+
+    if (silent >= 0)
+    {
+        OFCHECK(socketClosedByPeer(silent, 15));
+        closeSocket(silent);
+    }
+
+    // Request shutdown.
+    pool.stopAfterCurrentAssociations();
+    pool.join();
+
+    OFCHECK(pool.result.good());
+    OFCHECK_EQUAL(pool.numAssociations(), 0);
+}
+
+
+/* Test starts pool with only 2 SCP workers but allows 10 associations to
+ * wait for a worker becoming available. 8 SCU threads connect
+ * simultaneously to the pool and keep their associations open for a while,
+ * so some of them have to wait but none of them is rejected.
+ */
+OFTEST_FLAGS(dcmnet_scp_pool_waiting, EF_Slow)
+{
+    TestPool pool;
+    DcmSCPConfig& config = pool.getConfig();
+
+    config.setAETitle("PoolTestSCP");
+    config.setPort(11116);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+
+    pool.setMaxThreads(2);
+    pool.setMaxWaitingAssociations(10);
+    pool.setWorkersBusyTimeout(30);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    config.addPresentationContext(UID_VerificationSOPClass, xfers);
+
+    pool.start();
+
+    OFVector<TestIdleSCU*> scus(8);
+    for (OFVector<TestIdleSCU*>::iterator it1 = scus.begin(); it1 != scus.end(); ++it1)
+    {
+        *it1 = new TestIdleSCU;
+        (*it1)->setAETitle("PoolTestSCU");
+        (*it1)->setPeerAETitle("PoolTestSCP");
+        (*it1)->setPeerHostName("localhost");
+        (*it1)->setPeerPort(11116);
+        (*it1)->addPresentationContext(UID_VerificationSOPClass, xfers);
+        (*it1)->initNetwork();
+    }
+
+    // "ensure" the pool is initialized before any SCU starts connecting to it
+    OFStandard::sleep(5);
+
+    for (OFVector<TestIdleSCU*>::const_iterator it2 = scus.begin(); it2 != scus.end(); ++it2)
+        (*it2)->start();
+
+    for (OFVector<TestIdleSCU*>::iterator it3 = scus.begin(); it3 != scus.end(); ++it3)
+    {
+        (*it3)->join();
+        OFCHECK((*it3)->result.good());
+        delete *it3;
+    }
+    OFCHECK(pool.getNumQueuedAssociations() > 0);
+    OFCHECK(pool.getPeakWaitingAssociations() > 0);
+    OFCHECK(pool.getPeakWaitingAssociations() <= 6);
+    OFCHECK_EQUAL(pool.getNumTimedOutAssociations(), 0);
+    OFCHECK_EQUAL(pool.numWaitingAssociations(), 0);
+
+    // Request shutdown.
+    pool.stopAfterCurrentAssociations();
+    pool.join();
+
+    OFCHECK(pool.result.good());
+}
+
+
+/* Test starts pool with a single SCP worker that is kept busy by a first
+ * SCU for a while. A second SCU has to wait for the worker, but only for 2
+ * seconds. No further connection request arrives, nevertheless, the waiting
+ * association must be rejected in time (and not only when the first SCU is
+ * done or the connection timeout of the pool expires).
+ */
+OFTEST_FLAGS(dcmnet_scp_pool_waiting_timeout, EF_Slow)
+{
+    TestPool pool;
+    DcmSCPConfig& config = pool.getConfig();
+
+    config.setAETitle("PoolTestSCP");
+    config.setPort(11122);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(15);
+
+    pool.setMaxThreads(1);
+    pool.setMaxWaitingAssociations(5);
+    pool.setWorkersBusyTimeout(2);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    config.addPresentationContext(UID_VerificationSOPClass, xfers);
+
+    pool.start();
+
+    TestBusySCU busy;
+    TestSCU waiting;
+    busy.seconds = 10;
+    busy.setPeerPort(11122);
+    waiting.setPeerPort(11122);
+    DcmSCU *scus[2] = { &busy, &waiting };
+    for (int i = 0; i < 2; ++i)
+    {
+        scus[i]->setAETitle("PoolTestSCU");
+        scus[i]->setPeerAETitle("PoolTestSCP");
+        scus[i]->setPeerHostName("localhost");
+        scus[i]->addPresentationContext(UID_VerificationSOPClass, xfers);
+        scus[i]->initNetwork();
+    }
+
+    // "ensure" the pool is initialized before any SCU starts connecting to it
+    OFStandard::sleep(5);
+
+    busy.start();
+    // make sure that the first SCU gets the worker
+    OFStandard::sleep(1);
+    const time_t start = time(NULL);
+    waiting.start();
+    waiting.join();
+    // rejected after about 3 seconds, i.e. while the first SCU is still busy
+    OFCHECK(waiting.result.bad());
+    OFCHECK(time(NULL) - start < 6);
+    OFCHECK_EQUAL(pool.getNumTimedOutAssociations(), 1);
+    OFCHECK_EQUAL(pool.numWaitingAssociations(), 0);
+
+    busy.join();
+    OFCHECK(busy.result.good());
+
+    // Request shutdown.
+    pool.stopAfterCurrentAssociations();
+    pool.join();
+
+    OFCHECK(pool.result.good());
+}
+
+
+/* SCU that stores a single dataset after keeping its association idle for
+ * a moment, so all SCUs are connected to the pool at the same time
+ */
+struct TestStoreSCU : DcmSCU, OFThread
+{
+    OFCondition result;
+    OFString sopInstanceUID;
+protected:
+    void run()
+    {
+        result = negotiateAssociation();
+        if (result.good())
+        {
+            OFStandard::sleep(1);
+            DcmDataset dataset;
+            dataset.putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage);
+            dataset.putAndInsertString(DCM_SOPInstanceUID, sopInstanceUID.c_str());
+            dataset.putAndInsertString(DCM_PatientName, "Doe^John");
+            Uint16 rspStatus = 0;
+            // the dataset has been created in memory, so use any accepted transfer syntax
+            const T_ASC_PresentationContextID presID = findPresentationContextID(UID_SecondaryCaptureImageStorage, "");
+            result = sendSTORERequest(presID, "", &dataset, rspStatus);
+            if (result.good() && (rspStatus != STATUS_Success))
+                result = DIMSE_BADDATA;
+        }
+        releaseAssociation();
+    }
+};
+
+/* Storage SCP pool that keeps the names of all files stored by its workers */
+struct TestStoragePool : DcmStorageSCPPool, OFThread
+{
+    OFCondition result;
+    OFList<OFString> storedFiles;
+    OFMutex mutex;
+protected:
+    void run()
+    {
+        result = listen();
+    }
+
+    void notifyInstanceStored(const OFString &filename,
+                              const OFString & /* sopClassUID */,
+                              const OFString & /* sopInstanceUID */,
+                              DcmDataset * /* dataset */) const
+    {
+        TestStoragePool *self = OFconst_cast(TestStoragePool *, this);
+        self->mutex.lock();
+        self->storedFiles.push_back(filename);
+        self->mutex.unlock();
+    }
+};
+
+
+/* Test starts a storage SCP pool with 2 workers, each storing the received
+ * objects in a subdirectory of its own. 2 SCU threads connect simultaneously
+ * to the pool and store a dataset each, i.e. both workers are busy at the
+ * same time and must use different subdirectories.
+ */
+OFTEST_FLAGS(dcmnet_storage_scp_pool, EF_Slow)
+{
+    TestStoragePool pool;
+    DcmSCPConfig& config = pool.getConfig();
+
+    config.setAETitle("PoolTestSCP");
+    config.setPort(11118);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+
+    pool.setMaxThreads(2);
+    pool.setWorkerSubdirectoryMode(OFTrue);
+    OFCHECK(pool.setOutputDirectory(".").good());
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    config.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers);
+
+    pool.start();
+
+    OFVector<TestStoreSCU*> scus(2);
+    for (OFVector<TestStoreSCU*>::iterator it1 = scus.begin(); it1 != scus.end(); ++it1)
+    {
+        char uid[100];
+        *it1 = new TestStoreSCU;
+        (*it1)->sopInstanceUID = dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT);
+        (*it1)->setAETitle("PoolTestSCU");
+        (*it1)->setPeerAETitle("PoolTestSCP");
+        (*it1)->setPeerHostName("localhost");
+        (*it1)->setPeerPort(11118);
+        (*it1)->addPresentationContext(UID_SecondaryCaptureImageStorage, xfers);
+        (*it1)->initNetwork();
+    }
+
+    // "ensure" the pool is initialized before any SCU starts connecting to it
+    OFStandard::sleep(5);
+
+    for (OFVector<TestStoreSCU*>::const_iterator it2 = scus.begin(); it2 != scus.end(); ++it2)
+        (*it2)->start();
+
+    for (OFVector<TestStoreSCU*>::iterator it3 = scus.begin(); it3 != scus.end(); ++it3)
+    {
+        (*it3)->join();
+        OFCHECK((*it3)->result.good());
+        delete *it3;
+    }
+
+    // Request shutdown.
+    pool.stopAfterCurrentAssociations();
+    pool.join();
+
+    OFCHECK(pool.result.good());
+
+    // each worker has stored one of the datasets in its own subdirectory
+    OFString dir1, dir2;
+    OFStandard::combineDirAndFilename(dir1, pool.getOutputDirectory(), "worker1", OFTrue /*allowEmptyDirName*/);
+    OFStandard::combineDirAndFilename(dir2, pool.getOutputDirectory(), "worker2", OFTrue /*allowEmptyDirName*/);
+    OFCHECK_EQUAL(pool.storedFiles.size(), 2);
+    OFBool found1 = OFFalse;
+    OFBool found2 = OFFalse;
+    for (OFListIterator(OFString) it4 = pool.storedFiles.begin(); it4 != pool.storedFiles.end(); ++it4)
+    {
+        OFString dirName;
+        OFStandard::getDirNameFromPath(dirName, *it4);
+        found1 = found1 || (dirName == dir1);
+        found2 = found2 || (dirName == dir2);
+        OFCHECK(OFStandard::fileExists(*it4));
+        OFStandard::deleteFile(*it4);
+    }
+    OFCHECK(found1);
+    OFCHECK(found2);
+    // remove the (now empty) subdirectories
+    remove(dir1.c_str());
+    remove(dir2.c_str());
+}
+
 #endif // WITH_THREADS
@@ -0,0 +1,161 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test the per-network receive buffer size of the DUL layer and
+ *           the corresponding settings of DcmSCU and DcmSCP
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmnet/scu.h"
+#include "dcmtk/dcmnet/scpcfg.h"
+#include "dcmtk/dcmdata/dcuid.h"
+
+#ifdef WITH_THREADS
+#include "dcmtk/dcmnet/scppool.h"
+#endif
+
+#define RECVBUF_TEST_PORT 11119
+
+
+OFTEST(dcmnet_receiveBufferSize)
+{
+    const Uint32 globalSize = dcmReceiveBufferSize.get();
+
+    // a new network uses the global default
+    T_ASC_Network *net1 = NULL;
+    OFCHECK(ASC_initializeNetwork(NET_REQUESTOR, 0, 30, &net1).good());
+    OFCHECK_EQUAL(ASC_getReceiveBufferSize(net1), globalSize);
+
+    // the size can be changed per network
+    OFCHECK(ASC_setReceiveBufferSize(net1, 1234).good());
+    OFCHECK_EQUAL(ASC_getReceiveBufferSize(net1), 1234);
+    OFCHECK(ASC_setReceiveBufferSize(NULL, 1234).bad());
+    OFCHECK_EQUAL(ASC_getReceiveBufferSize(NULL), 0);
+
+    // changing the global value only affects networks created afterwards
+    dcmReceiveBufferSize.set(4096);
+    T_ASC_Network *net2 = NULL;
+    OFCHECK(ASC_initializeNetwork(NET_REQUESTOR, 0, 30, &net2).good());
+    OFCHECK_EQUAL(ASC_getReceiveBufferSize(net1), 1234);
+    OFCHECK_EQUAL(ASC_getReceiveBufferSize(net2), 4096);
+    ASC_dropNetwork(&net2);
+    ASC_dropNetwork(&net1);
+
+    // SCU and SCP take their defaults from the global value at construction time
+    DcmSCU scu;
+    DcmSCPConfig config;
+    OFCHECK_EQUAL(scu.getReceiveBufferSize(), 4096);
+    OFCHECK_EQUAL(config.getReceiveBufferSize(), 4096);
+    dcmReceiveBufferSize.set(globalSize);
+
+    scu.setReceiveBufferSize(0);
+    config.setReceiveBufferSize(256);
+    OFCHECK_EQUAL(scu.getReceiveBufferSize(), 0);
+    OFCHECK_EQUAL(config.getReceiveBufferSize(), 256);
+    DcmSCPConfig configCopy(config);
+    OFCHECK_EQUAL(configCopy.getReceiveBufferSize(), 256);
+}
+
+
+#ifdef WITH_THREADS
+
+struct TestRecvBufSCU : DcmSCU, OFThread
+{
+    OFCondition result;
+protected:
+    void run()
+    {
+        result = negotiateAssociation();
+        for (int i = 0; (i < 3) && result.good(); ++i)
+            result = sendECHORequest(0);
+        releaseAssociation();
+    }
+};
+
+struct TestRecvBufPool : DcmSCPPool<>, OFThread
+{
+    OFCondition result;
+protected:
+    void run()
+    {
+        result = listen();
+    }
+};
+
+
+/* Test starts a pool whose associations use a receive buffer that is
+ * smaller than a PDU header and connects SCUs with the receive buffer
+ * disabled, with a tiny buffer and with a buffer larger than any PDU.
+ * Every combination must be able to negotiate and exchange C-ECHO
+ * messages.
+ */
+OFTEST_FLAGS(dcmnet_receiveBufferSize_scp_pool, EF_Slow)
+{
+    TestRecvBufPool pool;
+    DcmSCPConfig& config = pool.getConfig();
+
+    config.setAETitle("RecvBufTestSCP");
+    config.setPort(RECVBUF_TEST_PORT);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+    config.setReceiveBufferSize(5);
+
+    pool.setMaxThreads(3);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    config.addPresentationContext(UID_VerificationSOPClass, xfers);
+
+    pool.start();
+
+    const Uint32 sizes[3] = { 0, 7, 1048576 };
+    TestRecvBufSCU scus[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        scus[i].setAETitle("RecvBufTestSCU");
+        scus[i].setPeerAETitle("RecvBufTestSCP");
+        scus[i].setPeerHostName("localhost");
+        scus[i].setPeerPort(RECVBUF_TEST_PORT);
+        scus[i].setReceiveBufferSize(sizes[i]);
+        scus[i].addPresentationContext(UID_VerificationSOPClass, xfers);
+        OFCHECK(scus[i].initNetwork().good());
+    }
+
+    // "ensure" the pool is initialized before any SCU starts connecting to it
+    OFStandard::sleep(5);
+
+    for (int j = 0; j < 3; ++j)
+        scus[j].start();
+
+    for (int k = 0; k < 3; ++k)
+    {
+        scus[k].join();
+        OFCHECK(scus[k].result.good());
+    }
+
+    // Request shutdown.
+    pool.stopAfterCurrentAssociations();
+    pool.join();
+
+    OFCHECK(pool.result.good());
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,168 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test sending datasets whose element values are passed to the
+ *           network layer by reference instead of being copied
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmnet/scu.h"
+#include "dcmtk/dcmdata/dcvrobow.h"
+#include "tstorage.h"
+
+#define SENDDATA_TEST_PORT 11120
+#define SENDDATA_TEST_PIXELS 50001
+#define SENDDATA_TEST_XFERS 3
+
+
+/* Create a dataset with 16-bit pixel data that spans many PDUs, an odd
+ * length OB value and a number of medium sized values, some of which
+ * are shorter than the threshold for being sent by reference.
+ */
+static DcmDataset *createDataset()
+{
+    DcmDataset *dataset = createStorageDataset(UID_SecondaryCaptureImageStorage);
+    OFCHECK(dataset->putAndInsertString(DCM_PatientName, "Doe^Jane").good());
+    Uint8 odd[1001];
+    for (Uint32 i = 0; i < 1001; ++i)
+        odd[i] = OFstatic_cast(Uint8, i % 253);
+    OFCHECK(dataset->putAndInsertUint8Array(DcmTag(0x0009, 0x1010, EVR_OB), odd, 1001).good());
+    for (Uint16 e = 0; e < 8; ++e)
+    {
+        Uint8 medium[3000];
+        const Uint32 length = 1000 + e * 250;
+        for (Uint32 i = 0; i < length; ++i)
+            medium[i] = OFstatic_cast(Uint8, (i + e) % 241);
+        OFCHECK(dataset->putAndInsertUint8Array(DcmTag(0x0009, OFstatic_cast(Uint16, 0x1020 + e), EVR_OB), medium, length).good());
+    }
+    OFCHECK(dataset->putAndInsertUint16(DCM_BitsAllocated, 16).good());
+    Uint16 *pixels = NULL;
+    OFCHECK(dataset->putAndInsertUint16Array(DCM_PixelData, NULL, 0).good());
+    DcmElement *elem = NULL;
+    OFCHECK(dataset->findAndGetElement(DCM_PixelData, elem).good());
+    if (elem != NULL) OFCHECK(elem->createUint16Array(SENDDATA_TEST_PIXELS, pixels).good());
+    for (Uint32 i = 0; (pixels != NULL) && (i < SENDDATA_TEST_PIXELS); ++i)
+        pixels[i] = OFstatic_cast(Uint16, i * 7);
+    return dataset;
+}
+
+
+/* Check that the element values of two datasets are equal */
+static void checkDataset(DcmDataset &received, DcmDataset &original)
+{
+    OFCHECK_EQUAL(received.card(), original.card());
+    for (unsigned long i = 0; i < original.card(); ++i)
+    {
+        DcmElement *expected = original.getElement(i);
+        DcmElement *actual = NULL;
+        OFCHECK(received.findAndGetElement(expected->getTag(), actual).good());
+        if (actual == NULL) continue;
+        OFCHECK_EQUAL(actual->getLength(), expected->getLength());
+        if (expected->getTag() == DCM_PixelData)
+        {
+            Uint16 *expectedPixels = NULL;
+            Uint16 *actualPixels = NULL;
+            OFCHECK(expected->getUint16Array(expectedPixels).good());
+            OFCHECK(actual->getUint16Array(actualPixels).good());
+            OFCHECK((expectedPixels != NULL) && (actualPixels != NULL) &&
+                (memcmp(expectedPixels, actualPixels, SENDDATA_TEST_PIXELS * 2) == 0));
+        }
+        else
+        {
+            OFString expectedValue;
+            OFString actualValue;
+            OFCHECK(expected->getOFStringArray(expectedValue).good());
+            OFCHECK(actual->getOFStringArray(actualValue).good());
+            OFCHECK_EQUAL(actualValue, expectedValue);
+        }
+    }
+}
+
+
+/* Test sends the same dataset with several transfer syntaxes to an SCP
+ * that only accepts PDUs of the minimum size, so that element values are
+ * split across PDUs and byte-swapped (or compressed) before being sent.
+ * The SCP must receive exactly the original element values.
+ */
+OFTEST_FLAGS(dcmnet_send_dataset_by_reference, EF_Slow)
+{
+    const char *xferUIDs[SENDDATA_TEST_XFERS] =
+    {
+        UID_LittleEndianExplicitTransferSyntax,
+        UID_BigEndianExplicitTransferSyntax,
+#ifdef WITH_ZLIB
+        UID_DeflatedExplicitVRLittleEndianTransferSyntax
+#else
+        UID_LittleEndianImplicitTransferSyntax
+#endif
+    };
+
+    TestStorageSCP scp(1 /* association */, SENDDATA_TEST_XFERS /* datasets */);
+    scp.setAETitle("SendDataSCP");
+    scp.setPort(SENDDATA_TEST_PORT);
+    scp.setMaxReceivePDULength(ASC_MINIMUMPDUSIZE);
+    OFList<OFString> xfers;
+    for (int i = 0; i < SENDDATA_TEST_XFERS; ++i)
+        xfers.push_back(xferUIDs[i]);
+    OFCHECK(scp.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    scp.start();
+
+    // "ensure" the SCP is listening before the SCU starts connecting to it
+    OFStandard::sleep(2);
+
+    DcmSCU scu;
+    scu.setAETitle("SendDataSCU");
+    scu.setPeerAETitle("SendDataSCP");
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(SENDDATA_TEST_PORT);
+    for (int j = 0; j < SENDDATA_TEST_XFERS; ++j)
+    {
+        OFList<OFString> xfer;
+        xfer.push_back(xferUIDs[j]);
+        scu.addPresentationContext(UID_SecondaryCaptureImageStorage, xfer);
+    }
+    OFCHECK(scu.initNetwork().good());
+    OFCHECK(scu.negotiateAssociation().good());
+
+    DcmDataset *dataset = createDataset();
+    for (int k = 0; k < SENDDATA_TEST_XFERS; ++k)
+    {
+        Uint16 status = 0;
+        T_ASC_PresentationContextID presID = scu.findPresentationContextID(UID_SecondaryCaptureImageStorage, xferUIDs[k]);
+        OFCHECK(presID != 0);
+        OFCHECK(scu.sendSTORERequest(presID, "", dataset, status).good());
+        OFCHECK_EQUAL(status, STATUS_Success);
+    }
+    scu.releaseAssociation();
+    scp.join();
+
+    OFCHECK_EQUAL(scp.numDatasets, SENDDATA_TEST_XFERS);
+    for (int l = 0; l < scp.numDatasets; ++l)
+    {
+        OFCHECK_EQUAL(scp.xfers[l], xferUIDs[l]);
+        checkDataset(scp.datasets[l], *dataset);
+    }
+    delete dataset;
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,161 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test sending instance data straight from a DICOM file
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmnet/dimse.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcvrobow.h"
+#include "dcmtk/dcmdata/dcsequen.h"
+#include "dcmtk/dcmdata/dcitem.h"
+#include "tstorage.h"
+
+#define SENDFILE_TEST_PORT 11117
+#define SENDFILE_TEST_PIXELS 100000
+
+
+/* Create a dataset with a sequence of undefined length and pixel data that
+ * is too large to fit into a single PDU, and save it to the given file.
+ */
+static void createFile(const char *filename, E_TransferSyntax xfer, const char *sopInstanceUID)
+{
+    DcmFileFormat fileformat;
+    DcmDataset *dataset = fileformat.getDataset();
+    OFCHECK(dataset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dataset->putAndInsertString(DCM_SOPInstanceUID, sopInstanceUID).good());
+    OFCHECK(dataset->putAndInsertString(DCM_PatientName, "Doe^John").good());
+    DcmItem *item = NULL;
+    OFCHECK(dataset->findOrCreateSequenceItem(DCM_ReferencedImageSequence, item).good());
+    if (item != NULL) OFCHECK(item->putAndInsertString(DCM_ReferencedSOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    Uint8 *pixels = NULL;
+    OFCHECK(dataset->putAndInsertUint8Array(DCM_PixelData, NULL, 0).good());
+    DcmElement *elem = NULL;
+    OFCHECK(dataset->findAndGetElement(DCM_PixelData, elem).good());
+    if (elem != NULL) OFCHECK(elem->createUint8Array(SENDFILE_TEST_PIXELS, pixels).good());
+    for (Uint32 i = 0; (pixels != NULL) && (i < SENDFILE_TEST_PIXELS); ++i)
+        pixels[i] = OFstatic_cast(Uint8, i % 251);
+    OFCHECK(fileformat.saveFile(filename, xfer, EET_UndefinedLength).good());
+}
+
+
+/* Check that the dataset received by the SCP matches the one created by createFile() */
+static void checkDataset(DcmDataset &dataset, const char *sopInstanceUID)
+{
+    OFString value;
+    OFCHECK(dataset.findAndGetOFString(DCM_SOPInstanceUID, value).good());
+    OFCHECK_EQUAL(value, sopInstanceUID);
+    OFCHECK(dataset.findAndGetOFString(DCM_PatientName, value).good());
+    OFCHECK_EQUAL(value, "Doe^John");
+    OFCHECK(dataset.findAndGetOFString(DCM_ReferencedSOPClassUID, value, 0, OFTrue /*searchIntoSub*/).good());
+    OFCHECK_EQUAL(value, UID_SecondaryCaptureImageStorage);
+    const Uint8 *pixels = NULL;
+    unsigned long count = 0;
+    OFCHECK(dataset.findAndGetUint8Array(DCM_PixelData, pixels, &count).good());
+    OFCHECK_EQUAL(count, SENDFILE_TEST_PIXELS);
+    OFBool equal = (pixels != NULL) && (count == SENDFILE_TEST_PIXELS);
+    for (Uint32 i = 0; equal && (i < SENDFILE_TEST_PIXELS); ++i)
+        equal = (pixels[i] == OFstatic_cast(Uint8, i % 251));
+    OFCHECK(equal);
+}
+
+
+/* Send the given file on a new association proposing the given transfer syntax */
+static void sendFile(const char *filename, const char *xferUID, const char *sopInstanceUID)
+{
+    T_ASC_Network *net = NULL;
+    T_ASC_Parameters *params = NULL;
+    T_ASC_Association *assoc = NULL;
+    const char *xfers[] = { xferUID };
+    OFCHECK(ASC_initializeNetwork(NET_REQUESTOR, 0, 30, &net).good());
+    OFCHECK(ASC_createAssociationParameters(&params, ASC_DEFAULTMAXPDU).good());
+    ASC_setAPTitles(params, "SendFileSCU", "SendFileSCP", NULL);
+    ASC_setPresentationAddresses(params, "localhost", "localhost:11117");
+    OFCHECK(ASC_addPresentationContext(params, 1, UID_SecondaryCaptureImageStorage, xfers, 1).good());
+    OFCondition cond = ASC_requestAssociation(net, params, &assoc);
+    OFCHECK(cond.good());
+    if (cond.good())
+    {
+        T_DIMSE_C_StoreRQ req;
+        T_DIMSE_C_StoreRSP rsp;
+        DcmDataset *statusDetail = NULL;
+        memset(&req, 0, sizeof(req));
+        req.MessageID = assoc->nextMsgID++;
+        OFStandard::strlcpy(req.AffectedSOPClassUID, UID_SecondaryCaptureImageStorage, sizeof(req.AffectedSOPClassUID));
+        OFStandard::strlcpy(req.AffectedSOPInstanceUID, sopInstanceUID, sizeof(req.AffectedSOPInstanceUID));
+        req.DataSetType = DIMSE_DATASET_PRESENT;
+        req.Priority = DIMSE_PRIORITY_MEDIUM;
+        OFCHECK(DIMSE_storeUser(assoc, 1, &req, filename, NULL, NULL, NULL,
+            DIMSE_BLOCKING, 0, &rsp, &statusDetail).good());
+        OFCHECK_EQUAL(rsp.DimseStatus, STATUS_Success);
+        delete statusDetail;
+        OFCHECK(ASC_releaseAssociation(assoc).good());
+        ASC_destroyAssociation(&assoc);
+    }
+    else ASC_destroyAssociationParameters(&params);
+    ASC_dropNetwork(&net);
+}
+
+
+/* Test stores two files with dcmSendStraightFileData enabled: the first
+ * one is encoded in the negotiated transfer syntax and is sent without
+ * being parsed, the second one is not and has to be loaded and converted.
+ * In both cases, the SCP must receive the complete dataset.
+ */
+OFTEST_FLAGS(dcmnet_send_straight_file_data, EF_Slow)
+{
+    // one dataset is sent on each of the two associations
+    TestStorageSCP scp(2 /* associations */, 2 /* datasets */);
+    scp.setAETitle("SendFileSCP");
+    scp.setPort(SENDFILE_TEST_PORT);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(scp.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    scp.start();
+
+    // "ensure" the SCP is listening before the SCU starts connecting to it
+    OFStandard::sleep(2);
+
+    char uid1[100];
+    char uid2[100];
+    dcmGenerateUniqueIdentifier(uid1, SITE_INSTANCE_UID_ROOT);
+    dcmGenerateUniqueIdentifier(uid2, SITE_INSTANCE_UID_ROOT);
+    createFile("test_sendfile_1.dcm", EXS_LittleEndianExplicit, uid1);
+    createFile("test_sendfile_2.dcm", EXS_BigEndianExplicit, uid2);
+
+    dcmSendStraightFileData.set(OFTrue);
+    sendFile("test_sendfile_1.dcm", UID_LittleEndianExplicitTransferSyntax, uid1);
+    sendFile("test_sendfile_2.dcm", UID_LittleEndianImplicitTransferSyntax, uid2);
+    dcmSendStraightFileData.set(OFFalse);
+    scp.join();
+    OFCHECK_EQUAL(scp.numDatasets, 2);
+    checkDataset(scp.datasets[0], uid1);
+    checkDataset(scp.datasets[1], uid2);
+
+    OFStandard::deleteFile("test_sendfile_1.dcm");
+    OFStandard::deleteFile("test_sendfile_2.dcm");
+}
+
+#endif // WITH_THREADS
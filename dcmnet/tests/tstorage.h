@@ -0,0 +1,117 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: helper classes and functions for the storage tests
+ *
+ */
+
+
+#ifndef TSTORAGE_H
+#define TSTORAGE_H
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmnet/scp.h"
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+
+/* maximum number of datasets kept by TestStorageSCP */
+#define TEST_STORAGE_MAX_DATASETS 4
+
+
+/* Storage SCP running in its own thread that accepts C-STORE requests and
+ * stops after the given number of associations. Optionally, a copy of the
+ * first datasets received (and their transfer syntax) is kept.
+ */
+struct TestStorageSCP : DcmSCP, OFThread
+{
+    OFCondition result;
+    int maxAssociations;
+    int numAssociations;
+    int numStoreRequests;
+    int maxDatasets;
+    int numDatasets;
+    DcmDataset datasets[TEST_STORAGE_MAX_DATASETS];
+    OFString xfers[TEST_STORAGE_MAX_DATASETS];
+
+    TestStorageSCP(int maxAssocs, int maxDsets = 0)
+    : result()
+    , maxAssociations(maxAssocs)
+    , numAssociations(0)
+    , numStoreRequests(0)
+    , maxDatasets((maxDsets < TEST_STORAGE_MAX_DATASETS) ? maxDsets : TEST_STORAGE_MAX_DATASETS)
+    , numDatasets(0)
+    {
+    }
+
+protected:
+    void run()
+    {
+        result = listen();
+    }
+
+    OFCondition handleIncomingCommand(T_DIMSE_Message *incomingMsg,
+                                      const DcmPresentationContextInfo &presInfo)
+    {
+        if (incomingMsg->CommandField == DIMSE_C_STORE_RQ)
+        {
+            DcmDataset *reqDataset = NULL;
+            OFCondition cond = handleSTORERequest(incomingMsg->msg.CStoreRQ, presInfo.presentationContextID, reqDataset);
+            if ((reqDataset != NULL) && (numDatasets < maxDatasets))
+            {
+                xfers[numDatasets] = presInfo.acceptedTransferSyntax;
+                datasets[numDatasets++] = *reqDataset;
+            }
+            delete reqDataset;
+            ++numStoreRequests;
+            return cond;
+        }
+        return DcmSCP::handleIncomingCommand(incomingMsg, presInfo);
+    }
+
+    void notifyAssociationTermination()
+    {
+        ++numAssociations;
+    }
+
+    OFBool stopAfterCurrentAssociation()
+    {
+        return numAssociations >= maxAssociations;
+    }
+};
+
+
+/* Create a dataset with the given SOP class and instance UID. A new SOP
+ * instance UID is generated if none is given. The caller has to delete the
+ * returned dataset.
+ */
+inline DcmDataset *createStorageDataset(const char *sopClassUID,
+                                        const char *sopInstanceUID = NULL)
+{
+    char uid[100];
+    DcmDataset *dataset = new DcmDataset;
+    if (sopInstanceUID == NULL)
+        sopInstanceUID = dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT);
+    OFCHECK(dataset->putAndInsertString(DCM_SOPClassUID, sopClassUID).good());
+    OFCHECK(dataset->putAndInsertString(DCM_SOPInstanceUID, sopInstanceUID).good());
+    return dataset;
+}
+
+#endif // TSTORAGE_H
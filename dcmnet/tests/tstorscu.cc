@@ -0,0 +1,149 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test sending SOP instances with DcmStorageSCU on multiple
+ *           associations in parallel (using an SCP pool as the receiver)
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmnet/dstorscu.h"
+#include "tstorage.h"
+
+#define STORAGE_TEST_PORT 11114
+#define STORAGE_TEST_INSTANCES 10
+
+
+/* SCP worker that accepts C-STORE requests */
+struct TestStoreSCP : DcmThreadSCP
+{
+protected:
+    OFCondition handleIncomingCommand(T_DIMSE_Message *incomingMsg,
+                                      const DcmPresentationContextInfo &presInfo)
+    {
+        if (incomingMsg->CommandField == DIMSE_C_STORE_RQ)
+        {
+            DcmDataset *reqDataset = NULL;
+            OFCondition cond = handleSTORERequest(incomingMsg->msg.CStoreRQ, presInfo.presentationContextID, reqDataset);
+            delete reqDataset;
+            return cond;
+        }
+        return DcmThreadSCP::handleIncomingCommand(incomingMsg, presInfo);
+    }
+};
+
+struct TestStorePool : DcmSCPPool<TestStoreSCP>, OFThread
+{
+    OFCondition result;
+protected:
+    void run()
+    {
+        result = listen();
+    }
+};
+
+/* Storage SCU that counts the notifications (which must never be concurrent) */
+struct TestParallelStorageSCU : DcmStorageSCU
+{
+    int numNotified;
+    int numSuccess;
+    OFBool concurrent;
+    OFBool inNotification;
+
+    TestParallelStorageSCU()
+    : numNotified(0)
+    , numSuccess(0)
+    , concurrent(OFFalse)
+    , inNotification(OFFalse)
+    {
+    }
+
+protected:
+    void notifySOPInstanceSent(const TransferEntry &transferEntry)
+    {
+        if (inNotification)
+            concurrent = OFTrue;
+        inNotification = OFTrue;
+        ++numNotified;
+        if (transferEntry.RequestSent && (transferEntry.ResponseStatusCode == STATUS_Success) &&
+            (transferEntry.AssociationNumber > 0))
+        {
+            ++numSuccess;
+        }
+        // give other threads the chance to interfere
+        OFStandard::milliSleep(10);
+        inNotification = OFFalse;
+    }
+};
+
+
+/* Test starts a pool of SCP workers that accept C-STORE requests. A storage
+ * SCU sends a number of SOP instances (of two different SOP classes) on four
+ * associations in parallel and checks that each instance has been sent once.
+ */
+OFTEST_FLAGS(dcmnet_storage_scu_parallel, EF_Slow)
+{
+    TestStorePool pool;
+    DcmSCPConfig& config = pool.getConfig();
+    config.setAETitle("StoreTestSCP");
+    config.setPort(STORAGE_TEST_PORT);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+    pool.setMaxThreads(4);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(config.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    OFCHECK(config.addPresentationContext(UID_CTImageStorage, xfers).good());
+    pool.start();
+
+    TestParallelStorageSCU scu;
+    scu.setAETitle("StoreTestSCU");
+    scu.setPeerAETitle("StoreTestSCP");
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(STORAGE_TEST_PORT);
+    for (int i = 0; i < STORAGE_TEST_INSTANCES; ++i)
+    {
+        DcmDataset *dataset = createStorageDataset((i % 2) ? UID_CTImageStorage : UID_SecondaryCaptureImageStorage);
+        OFCHECK(scu.addDataset(dataset, EXS_LittleEndianImplicit, DcmStorageSCU::HM_deleteAfterRemove).good());
+    }
+
+    // "ensure" the pool is listening before the SCU starts connecting to it
+    OFStandard::sleep(2);
+
+    OFCHECK(scu.sendSOPInstancesInParallel(4).good());
+    OFCHECK_EQUAL(scu.getAssociationCounter(), 4);
+    OFCHECK_EQUAL(scu.getNumberOfSOPInstancesToBeSent(), 0);
+    OFCHECK_EQUAL(scu.numNotified, STORAGE_TEST_INSTANCES);
+    OFCHECK_EQUAL(scu.numSuccess, STORAGE_TEST_INSTANCES);
+    OFCHECK(!scu.concurrent);
+    // nothing left to be sent
+    OFCHECK(scu.sendSOPInstancesInParallel(4) == NET_EC_NoSOPInstancesToSend);
+
+    // request shutdown
+    pool.stopAfterCurrentAssociations();
+    pool.join();
+    OFCHECK(pool.result.good());
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,158 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test write-behind storage of received DICOM files
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/dcmnet/dstorwb.h"
+
+#define INCLUDE_CSTDIO
+#include "dcmtk/ofstd/ofstdinc.h"
+
+#define WRITE_BEHIND_TEST_FILES 5
+#define WRITE_BEHIND_TEST_BYTES 200000
+
+
+/* Write a file of the given size through the given storage, in pieces of
+ * varying size, using a pattern that depends on the file number.
+ */
+static void writeFile(DcmWriteBehindStorage &storage, const OFFilename &filename, int number)
+{
+    DcmWriteBehindStream *stream = NULL;
+    OFCHECK(storage.createFile(filename, stream).good());
+    if (stream == NULL) return;
+    Uint8 buffer[1000];
+    size_t written = 0;
+    size_t piece = 1;
+    while (written < WRITE_BEHIND_TEST_BYTES)
+    {
+        size_t count = WRITE_BEHIND_TEST_BYTES - written;
+        if (count > piece) count = piece;
+        for (size_t i = 0; i < count; ++i)
+            buffer[i] = OFstatic_cast(Uint8, (written + i + number) % 251);
+        size_t done = 0;
+        while (done < count)
+            done += OFstatic_cast(size_t, stream->write(buffer + done, count - done));
+        written += count;
+        piece = (piece * 7 + 3) % sizeof(buffer) + 1;
+    }
+    OFCHECK(stream->good());
+    OFCHECK(storage.closeFile(stream).good());
+    OFCHECK(stream == NULL);
+}
+
+
+/* Check that the given file contains the data written by writeFile() */
+static void checkFile(const OFFilename &filename, int number)
+{
+    OFFile file;
+    OFCHECK(file.fopen(filename, "rb"));
+    Uint8 buffer[4096];
+    size_t total = 0;
+    OFBool equal = OFTrue;
+    size_t count;
+    while (equal && ((count = file.fread(buffer, 1, sizeof(buffer))) > 0))
+    {
+        for (size_t i = 0; equal && (i < count); ++i)
+            equal = (buffer[i] == OFstatic_cast(Uint8, (total + i + number) % 251));
+        total += count;
+    }
+    OFCHECK(equal);
+    OFCHECK_EQUAL(total, WRITE_BEHIND_TEST_BYTES);
+    file.fclose();
+}
+
+
+static OFFilename testFilename(int number)
+{
+    char name[64];
+    sprintf(name, "test_writebehind_%d.dat", number);
+    return OFFilename(name);
+}
+
+
+OFTEST(dcmnet_write_behind_storage)
+{
+    DcmWriteBehindStorage storage;
+    // use a small queue, so that the writing thread has to wait for the I/O thread
+    storage.setMaxQueuedBytes(128 * 1024);
+    storage.setMaxBatchSize(3);
+    storage.setCompletionMode(DcmWriteBehindStorage::WCM_Synced);
+    OFCHECK(storage.start().good());
+    for (int i = 0; i < WRITE_BEHIND_TEST_FILES; ++i)
+        writeFile(storage, testFilename(i), i);
+    // closeFile() waits for the synchronization, so there is at most one per file
+    OFCHECK_EQUAL(storage.getNumFilesWritten(), WRITE_BEHIND_TEST_FILES);
+    OFCHECK(storage.getNumSyncs() >= 1);
+    OFCHECK(storage.getNumSyncs() <= WRITE_BEHIND_TEST_FILES);
+    for (int i = 0; i < WRITE_BEHIND_TEST_FILES; ++i)
+        checkFile(testFilename(i), i);
+
+    // an aborted file must be removed
+    DcmWriteBehindStream *stream = NULL;
+    const OFFilename abortedFile("test_writebehind_aborted.dat");
+    OFCHECK(storage.createFile(abortedFile, stream).good());
+    if (stream != NULL)
+    {
+        Uint8 data[100] = { 0 };
+        stream->write(data, sizeof(data));
+        storage.abortFile(stream);
+        OFCHECK(stream == NULL);
+    }
+    OFCHECK(storage.sync().good());
+    OFCHECK(!OFStandard::fileExists(abortedFile));
+    OFCHECK_EQUAL(storage.getNumFilesWritten(), WRITE_BEHIND_TEST_FILES);
+
+    // creating a file in a non-existing directory must fail at once
+    OFCHECK(storage.createFile("no_such_directory/test_writebehind.dat", stream).bad());
+    OFCHECK(stream == NULL);
+    storage.stop();
+
+    for (int i = 0; i < WRITE_BEHIND_TEST_FILES; ++i)
+        OFStandard::deleteFile(testFilename(i));
+}
+
+
+OFTEST(dcmnet_write_behind_storage_on_request)
+{
+    DcmWriteBehindStorage storage;
+    storage.setSyncMode(DcmWriteBehindStorage::WSM_OnRequest);
+    OFCHECK(storage.start().good());
+    for (int i = 0; i < WRITE_BEHIND_TEST_FILES; ++i)
+        writeFile(storage, testFilename(i), i);
+    // nothing is synchronized before it is requested
+    OFCHECK_EQUAL(storage.getNumSyncs(), 0);
+    OFCHECK(storage.sync().good());
+    OFCHECK_EQUAL(storage.getNumSyncs(), 1);
+    OFCHECK_EQUAL(storage.getNumFilesWritten(), WRITE_BEHIND_TEST_FILES);
+    storage.stop();
+    for (int i = 0; i < WRITE_BEHIND_TEST_FILES; ++i)
+    {
+        checkFile(testFilename(i), i);
+        OFStandard::deleteFile(testFilename(i));
+    }
+}
+
+#endif // WITH_THREADS
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1993-2014, OFFIS e.V.
+ *  Copyright (C) 1993-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -250,6 +250,7 @@ main(int argc, char *argv[])
       cmd.addOption("--reject",                              "reject association if no implement. class UID");
       cmd.addOption("--ignore",                              "ignore store data, receive but do not store");
       cmd.addOption("--uid-padding",            "-up",       "silently correct space-padded UIDs");
+      cmd.addOption("--send-as-stored",                      "send stored files without re-encoding them\nif the transfer syntax permits (C-MOVE/GET)");
 
   cmd.addGroup("encoding options:");
     cmd.addSubGroup("post-1993 value representations:");
@@ -447,6 +448,7 @@ main(int argc, char *argv[])
       if (cmd.findOption("--reject")) options.rejectWhenNoImplementationClassUID_ = OFTrue;
       if (cmd.findOption("--ignore")) options.ignoreStoreData_ = OFTrue;
       if (cmd.findOption("--uid-padding")) options.correctUIDPadding_ = OFTrue;
+      if (cmd.findOption("--send-as-stored")) dcmSendStraightFileData.set(OFTrue);
 
       cmd.beginOptionBlock();
       if (cmd.findOption("--enable-new-vr")) dcmEnableGenerationOfNewVRs();
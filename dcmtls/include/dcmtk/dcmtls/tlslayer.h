@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1998-2015, OFFIS e.V.
+ *  Copyright (C) 1998-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -27,6 +27,8 @@
 #include "dcmtk/dcmnet/dcmlayer.h"    /* for DcmTransportLayer */
 #include "dcmtk/ofstd/ofstream.h"    /* for ostream */
 #include "dcmtk/oflog/oflog.h"
+#include "dcmtk/ofstd/oflist.h"      /* for OFList */
+#include "dcmtk/ofstd/ofthread.h"    /* for OFMutex */
 #include "dcmtk/dcmtls/tlsdefin.h"
 
 #ifdef WITH_OPENSSL
@@ -236,8 +238,117 @@ public:
    */
   static OFString dumpX509Certificate(X509 *peerCertificate);
 
+  /** sets the maximum number of TLS sessions kept for resumption.
+   *  An acceptor caches the sessions negotiated with its peers (by default,
+   *  the OpenSSL default of 20480 sessions is used), a requestor caches the
+   *  last session negotiated with each peer address and offers it to the peer
+   *  when connecting to the same address again, so that the full handshake
+   *  (i.e.\ the costly public key operations) can be skipped.  For a requestor,
+   *  sessions are not cached by default.  A value of 0 disables the cache.
+   *  @param size maximum number of sessions in the cache
+   */
+  void setSessionCacheSize(unsigned long size);
+
+  /** returns the maximum number of TLS sessions kept for resumption
+   *  @return maximum number of sessions in the cache, 0 if disabled
+   */
+  unsigned long getSessionCacheSize() const { return sessionCacheSize; }
+
+  /** sets the lifetime of the TLS sessions negotiated by this transport layer,
+   *  i.e.\ the time after which a session cannot be resumed anymore.  The default
+   *  is 300 seconds.
+   *  @param seconds lifetime in seconds, must be > 0
+   */
+  void setSessionTimeout(long seconds);
+
+  /** returns the lifetime of the TLS sessions negotiated by this transport layer
+   *  @return lifetime in seconds
+   */
+  long getSessionTimeout() const { return sessionTimeout; }
+
+  /** enables or disables session tickets (RFC 5077), which allow an acceptor
+   *  to resume a session without keeping it in its cache.  Session tickets are
+   *  enabled by default if supported by the OpenSSL library.
+   *  @param enabled OFTrue to enable session tickets, OFFalse to disable them
+   */
+  void setSessionTickets(OFBool enabled);
+
+  /** loads the TLS sessions stored by saveSessionCache() into the session cache
+   *  of a requestor, e.g.\ in order to resume a session negotiated by a previous
+   *  run of the application.  Sessions that have expired are ignored.
+   *  @param fileName path to the session cache file
+   *  @return TCS_ok if successful, an error code otherwise
+   */
+  DcmTransportLayerStatus loadSessionCache(const char *fileName);
+
+  /** stores the session cache of a requestor in a file (PEM format).
+   *  Please note that the file allows for resuming the stored sessions,
+   *  i.e.\ it must be protected like a private key.  On Posix systems, the
+   *  file is created (or an existing file is changed) with mode 0600.
+   *  @param fileName path to the session cache file
+   *  @return TCS_ok if successful, an error code otherwise
+   */
+  DcmTransportLayerStatus saveSessionCache(const char *fileName);
+
+  /** returns the number of TLS sessions that have been resumed successfully,
+   *  i.e.\ the number of connections established without a full handshake
+   *  @return number of resumed sessions
+   */
+  long getNumberOfResumedSessions() const;
+
+  /** stores a session negotiated by a requestor in the session cache.
+   *  Called by OpenSSL whenever a new session has been established.
+   *  @param connection connection on which the session was negotiated
+   *  @param session new session
+   *  @return 1 if the session has been stored, 0 otherwise
+   */
+  int addCachedSession(SSL *connection, SSL_SESSION *session);
+
 private:
 
+  /** entry of the session cache of a requestor
+   */
+  struct SessionCacheEntry
+  {
+    /// address of the peer
+    OFString peer;
+    /// session negotiated with the peer
+    SSL_SESSION *session;
+  };
+
+  /** returns the address of the peer connected to the given socket
+   *  @param socket connected socket
+   *  @return address of the peer (IP address and port, IPv6 addresses in
+   *    brackets), empty string if unknown
+   */
+  static OFString getPeerAddress(int socket);
+
+  /** checks if the given session has expired
+   *  @param session session to be checked
+   *  @return OFTrue if the session has expired, OFFalse otherwise
+   */
+  static OFBool sessionExpired(SSL_SESSION *session);
+
+  /** stores a session in the session cache of a requestor, replacing any
+   *  session for the same peer and removing the oldest sessions if the cache
+   *  is full.  Takes over ownership of the session.
+   *  @param peer address of the peer
+   *  @param session session to be stored
+   */
+  void storeSession(const OFString &peer, SSL_SESSION *session);
+
+  /** offers the cached session for the given peer (if any) for resumption
+   *  on the given connection
+   *  @param connection new connection, handshake not yet performed
+   *  @param peer address of the peer
+   *  @return OFTrue if a session is offered, OFFalse otherwise
+   */
+  OFBool offerCachedSession(SSL *connection, const OFString &peer);
+
+  /** removes all sessions from the session cache of a requestor
+   */
+  void clearSessionCache();
+
   /// private undefined copy constructor
   DcmTLSTransportLayer(const DcmTLSTransportLayer&);
 
@@ -253,6 +364,23 @@ private:
   /// contains the password for the private key if set on command line
   OFString privateKeyPasswd;
 
+  /// network role of the transport layer
+  int role;
+
+  /// maximum number of sessions in the session cache
+  unsigned long sessionCacheSize;
+
+  /// lifetime of sessions in seconds
+  long sessionTimeout;
+
+  /// session cache of a requestor, most recently used session first
+  OFList<SessionCacheEntry> sessionCache;
+
+#ifdef WITH_THREADS
+  /// mutex protecting the session cache of a requestor
+  OFMutex sessionCacheMutex;
+#endif
+
 };
 
 #endif /* WITH_OPENSSL */
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2010-2013, OFFIS e.V.
+ *  Copyright (C) 2010-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -59,7 +59,10 @@ public:
   virtual ~DcmTLSSCU();
 
   /** Initialize network, i.e. prepare for association negotiation.
-   *  @return EC_Normal if initialization was successful, otherwise error code
+   *  The TLS transport layer of the last association is re-used if session
+   *  resumption is enabled and none of the TLS settings has been changed since.
+   *  @return EC_Normal if initialization was successful, otherwise error code.
+   *          NET_EC_AlreadyConnected if SCU is already connected.
    */
   virtual OFCondition initNetwork();
 
@@ -134,6 +137,19 @@ public:
    */
   virtual void setDHParam(const OFString& dhParam);
 
+  /** Enables the resumption of TLS sessions, i.e.\ the session negotiated with the
+   *  peer is cached and offered to the peer when the next association is negotiated,
+   *  so that the full TLS handshake can be skipped.  If enabled, the TLS transport
+   *  layer (and therefore the session cache) is kept until the SCU is destroyed,
+   *  i.e.\ it is not re-created for each association (unless the TLS settings
+   *  are changed).
+   *  @param cacheSize [in] maximum number of sessions cached, 0 disables resumption
+   *                        (default)
+   *  @param timeout   [in] lifetime of the sessions in seconds
+   */
+  virtual void setSessionResumption(const unsigned long cacheSize,
+                                    const long timeout = 300);
+
   /** Returns OFTrue if authentication is enabled
    *  @param ... TODO: Not documented yet
    *  @return Return value OFTrue
@@ -174,6 +190,16 @@ public:
    */
   virtual OFString getDHParam() const;
 
+  /** Returns the maximum number of TLS sessions cached for resumption
+   *  @return maximum number of sessions cached, 0 if resumption is disabled
+   */
+  virtual unsigned long getSessionCacheSize() const;
+
+  /** Returns the lifetime of TLS sessions cached for resumption
+   *  @return lifetime in seconds
+   */
+  virtual long getSessionTimeout() const;
+
 private:
 
   /** Private undefined copy-constructor. Shall never be called.
@@ -190,6 +216,9 @@ private:
   /// The TLS layer responsible for all encryption/authentication stuff
   DcmTLSTransportLayer *m_tLayer;
 
+  /// OFTrue if the TLS settings have been changed since the TLS layer was created
+  OFBool m_tLayerOutdated;
+
   /// If enabled, authentication of client/server is enabled
   OFBool m_doAuthenticate;
 
@@ -232,6 +261,12 @@ private:
   /// File containing Diffie-Hellman parameters to be used
   OFString m_dhparam;
 
+  /// Maximum number of TLS sessions cached for resumption, 0 if disabled
+  unsigned long m_sessionCacheSize;
+
+  /// Lifetime of TLS sessions cached for resumption in seconds
+  long m_sessionTimeout;
+
 };
 
 #endif // WITH_OPENSSL
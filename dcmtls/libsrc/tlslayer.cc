@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2000-2015, OFFIS e.V.
+ *  Copyright (C) 2000-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -27,6 +27,8 @@
 #ifdef WITH_OPENSSL
 
 #define INCLUDE_CSTDLIB
+#define INCLUDE_CSTRING
+#define INCLUDE_CTIME
 #include "dcmtk/ofstd/ofstdinc.h"
 
 BEGIN_EXTERN_C
@@ -34,13 +36,27 @@ BEGIN_EXTERN_C
 #include <windows.h>
 #include <winbase.h>
 #endif
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>         /* for struct sockaddr_in and sockaddr_in6 */
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>              /* for open() */
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>           /* for fchmod() */
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>             /* for close() */
+#endif
 #include <openssl/rand.h>
 #include <openssl/err.h>
+#include <openssl/pem.h>
 END_EXTERN_C
 
 #include "dcmtk/dcmtls/tlslayer.h"
 #include "dcmtk/dcmtls/tlstrans.h"
 #include "dcmtk/dcmnet/dicom.h"
+#include "dcmtk/dcmnet/dcompat.h"    /* for getpeername() and socklen_t */
 
 extern "C" int DcmTLSTransportLayer_certificateValidationCallback(int ok, X509_STORE_CTX *storeContext);
 
@@ -54,6 +70,19 @@ int DcmTLSTransportLayer_certificateValidationCallback(int ok, X509_STORE_CTX *
   return ok;
 }
 
+/* ssl     : connection on which a new session has been established
+ * session : the new session
+ * returns : 1 if the session has been stored (i.e. the reference is taken over), 0 otherwise
+ */
+extern "C" int DcmTLSTransportLayer_newSessionCallback(SSL *ssl, SSL_SESSION *session);
+
+int DcmTLSTransportLayer_newSessionCallback(SSL *ssl, SSL_SESSION *session)
+{
+  DcmTLSTransportLayer *layer = OFstatic_cast(DcmTLSTransportLayer *, SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  if (layer == NULL) return 0;
+  return layer->addCachedSession(ssl, session);
+}
+
 /* buf     : buffer to write password into
  * size    : length of buffer in bytes
  * rwflag  : nonzero if the password will be used as a new password, i.e. user should be asked to repeat the password
@@ -171,6 +200,13 @@ DcmTLSTransportLayer::DcmTLSTransportLayer(int networkRole, const char *randFile
 , transportLayerContext(NULL)
 , canWriteRandseed(OFFalse)
 , privateKeyPasswd()
+, role(networkRole)
+, sessionCacheSize(0)
+, sessionTimeout(300)
+, sessionCache()
+#ifdef WITH_THREADS
+, sessionCacheMutex()
+#endif
 {
    if (initializeOpenSSL)
    {
@@ -200,6 +236,27 @@ DcmTLSTransportLayer::DcmTLSTransportLayer(int networkRole, const char *randFile
    }
 #endif
 
+   if (transportLayerContext)
+   {
+     if (networkRole == DICOM_APPLICATION_REQUESTOR)
+     {
+       /* sessions are cached by this class (see addCachedSession()), since
+        * OpenSSL does not look up the session for a peer on client side.
+        */
+       SSL_CTX_set_session_cache_mode(transportLayerContext, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+       SSL_CTX_set_app_data(transportLayerContext, this);
+       SSL_CTX_sess_set_new_cb(transportLayerContext, DcmTLSTransportLayer_newSessionCallback);
+     } else {
+       /* the session ID context is required for resuming sessions if peer
+        * certificates are verified, the internal session cache is used.
+        */
+       static const unsigned char sessionIdContext[] = "DCMTK";
+       SSL_CTX_set_session_id_context(transportLayerContext, sessionIdContext, sizeof(sessionIdContext) - 1);
+       sessionCacheSize = SSL_CTX_sess_get_cache_size(transportLayerContext);
+     }
+     SSL_CTX_set_timeout(transportLayerContext, sessionTimeout);
+   }
+
    setCertificateVerification(DCV_requireCertificate); /* default */
 }
 
@@ -281,6 +338,7 @@ DcmTransportLayerStatus DcmTLSTransportLayer::setCipherSuites(const char *suites
 
 DcmTLSTransportLayer::~DcmTLSTransportLayer()
 {
+  clearSessionCache();
   if (transportLayerContext) SSL_CTX_free(transportLayerContext);
 }
 
@@ -367,6 +425,12 @@ DcmTransportConnection *DcmTLSTransportLayer::createConnection(int openSocket, O
       if (newConnection)
       {
         SSL_set_fd(newConnection, openSocket);
+        if ((role == DICOM_APPLICATION_REQUESTOR) && (sessionCacheSize > 0))
+        {
+          // try to resume the last session negotiated with this peer
+          if (offerCachedSession(newConnection, getPeerAddress(openSocket)))
+            DCMTLS_DEBUG("offering cached TLS session for resumption");
+        }
         return new DcmTLSConnection(openSocket, newConnection);
       }
     }
@@ -482,6 +546,277 @@ OFString DcmTLSTransportLayer::dumpX509Certificate(X509 *peerCertificate)
   }
 }
 
+void DcmTLSTransportLayer::setSessionCacheSize(unsigned long size)
+{
+  sessionCacheSize = size;
+  if (transportLayerContext == NULL) return;
+  if (role == DICOM_APPLICATION_REQUESTOR)
+  {
+    // remove the oldest sessions if the cache has been shrunk
+#ifdef WITH_THREADS
+    sessionCacheMutex.lock();
+#endif
+    while (sessionCache.size() > sessionCacheSize)
+    {
+      SSL_SESSION_free(sessionCache.back().session);
+      sessionCache.pop_back();
+    }
+#ifdef WITH_THREADS
+    sessionCacheMutex.unlock();
+#endif
+  } else {
+    if (size > 0)
+    {
+      SSL_CTX_set_session_cache_mode(transportLayerContext, SSL_SESS_CACHE_SERVER);
+      SSL_CTX_sess_set_cache_size(transportLayerContext, OFstatic_cast(long, size));
+    }
+    else SSL_CTX_set_session_cache_mode(transportLayerContext, SSL_SESS_CACHE_OFF);
+  }
+}
+
+void DcmTLSTransportLayer::setSessionTimeout(long seconds)
+{
+  if (seconds > 0)
+  {
+    sessionTimeout = seconds;
+    if (transportLayerContext) SSL_CTX_set_timeout(transportLayerContext, seconds);
+  }
+}
+
+void DcmTLSTransportLayer::setSessionTickets(OFBool enabled)
+{
+#ifdef SSL_OP_NO_TICKET
+  if (transportLayerContext)
+  {
+    if (!enabled)
+      SSL_CTX_set_options(transportLayerContext, SSL_OP_NO_TICKET);
+#ifdef SSL_CTRL_CLEAR_OPTIONS
+    else
+      SSL_CTX_clear_options(transportLayerContext, SSL_OP_NO_TICKET);
+#endif
+  }
+#else
+  // session tickets are not supported by this version of OpenSSL
+  if (enabled) DCMTLS_DEBUG("TLS session tickets not supported by OpenSSL library, ignoring");
+#endif
+}
+
+long DcmTLSTransportLayer::getNumberOfResumedSessions() const
+{
+  if (transportLayerContext) return SSL_CTX_sess_hits(transportLayerContext);
+  return 0;
+}
+
+int DcmTLSTransportLayer::addCachedSession(SSL *connection, SSL_SESSION *session)
+{
+  if ((sessionCacheSize == 0) || (connection == NULL) || (session == NULL)) return 0;
+  OFString peer = getPeerAddress(SSL_get_fd(connection));
+  if (peer.empty()) return 0;
+  storeSession(peer, session);
+  return 1;
+}
+
+DcmTransportLayerStatus DcmTLSTransportLayer::loadSessionCache(const char *fileName)
+{
+  if ((transportLayerContext == NULL) || (role != DICOM_APPLICATION_REQUESTOR) || (fileName == NULL)) return TCS_illegalCall;
+  BIO *bio = BIO_new_file(fileName, "r");
+  if (bio == NULL) return TCS_tlsError;
+  char line[256];
+  size_t count = 0;
+  // each session is preceded by a line containing the address of the peer
+  while (BIO_gets(bio, line, sizeof(line)) > 0)
+  {
+    OFString peer(line);
+    if (peer.compare(0, 6, "Peer: ") != 0) continue;
+    peer.erase(0, 6);
+    while (!peer.empty() && ((peer[peer.length() - 1] == '\n') || (peer[peer.length() - 1] == '\r')))
+      peer.erase(peer.length() - 1);
+    SSL_SESSION *session = PEM_read_bio_SSL_SESSION(bio, NULL, NULL, NULL);
+    if (session == NULL) break;
+    if (sessionExpired(session) || peer.empty())
+      SSL_SESSION_free(session);
+    else
+    {
+      storeSession(peer, session);
+      ++count;
+    }
+  }
+  BIO_free(bio);
+  DCMTLS_DEBUG("loaded " << count << " TLS session(s) from file '" << fileName << "'");
+  return TCS_ok;
+}
+
+DcmTransportLayerStatus DcmTLSTransportLayer::saveSessionCache(const char *fileName)
+{
+  if ((transportLayerContext == NULL) || (role != DICOM_APPLICATION_REQUESTOR) || (fileName == NULL)) return TCS_illegalCall;
+#ifdef HAVE_WINDOWS_H
+  BIO *bio = BIO_new_file(fileName, "w");
+#else
+  // the file contains the master secrets of the sessions, so it must only be
+  // accessible by its owner. fchmod() also restricts a file that already existed.
+  int fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) return TCS_tlsError;
+  if (fchmod(fd, 0600) != 0)
+  {
+    close(fd);
+    return TCS_tlsError;
+  }
+  BIO *bio = BIO_new_fd(fd, BIO_CLOSE);
+  if (bio == NULL) close(fd);
+#endif
+  if (bio == NULL) return TCS_tlsError;
+  DcmTransportLayerStatus result = TCS_ok;
+#ifdef WITH_THREADS
+  sessionCacheMutex.lock();
+#endif
+  // write the oldest session first, so that loading the file restores the order
+  OFListIterator(SessionCacheEntry) it = sessionCache.end();
+  while ((it != sessionCache.begin()) && (result == TCS_ok))
+  {
+    --it;
+    if (!sessionExpired((*it).session))
+    {
+      if ((BIO_printf(bio, "Peer: %s\n", (*it).peer.c_str()) <= 0) ||
+          !PEM_write_bio_SSL_SESSION(bio, (*it).session))
+        result = TCS_tlsError;
+    }
+  }
+#ifdef WITH_THREADS
+  sessionCacheMutex.unlock();
+#endif
+  BIO_free(bio);
+  return result;
+}
+
+OFString DcmTLSTransportLayer::getPeerAddress(int socket)
+{
+  struct sockaddr_storage from;
+#ifdef HAVE_DECLARATION_SOCKLEN_T
+  socklen_t len = sizeof(from);
+#elif !defined(HAVE_PROTOTYPE_ACCEPT) || defined(HAVE_INTP_ACCEPT)
+  int len = sizeof(from);
+#else
+  size_t len = sizeof(from);
+#endif
+  memset(&from, 0, sizeof(from));
+  if (getpeername(socket, OFreinterpret_cast(struct sockaddr *, &from), &len))
+    return OFString();
+  const unsigned char *port = NULL;
+  OFOStringStream stream;
+  if (from.ss_family == AF_INET)
+  {
+    const struct sockaddr_in *from4 = OFreinterpret_cast(const struct sockaddr_in *, &from);
+    const unsigned char *addr = OFreinterpret_cast(const unsigned char *, &from4->sin_addr);
+    stream << OFstatic_cast(int, addr[0]) << "." << OFstatic_cast(int, addr[1]) << "."
+           << OFstatic_cast(int, addr[2]) << "." << OFstatic_cast(int, addr[3]);
+    port = OFreinterpret_cast(const unsigned char *, &from4->sin_port);
+  }
+#ifdef AF_INET6
+  else if (from.ss_family == AF_INET6)
+  {
+    // IPv6 addresses are written as eight groups of hexadecimal digits in brackets
+    const struct sockaddr_in6 *from6 = OFreinterpret_cast(const struct sockaddr_in6 *, &from);
+    const unsigned char *addr = OFreinterpret_cast(const unsigned char *, &from6->sin6_addr);
+    stream << "[" << STD_NAMESPACE hex;
+    for (int i = 0; i < 16; i += 2)
+    {
+      if (i > 0) stream << ":";
+      stream << ((OFstatic_cast(int, addr[i]) << 8) | addr[i + 1]);
+    }
+    stream << STD_NAMESPACE dec << "]";
+    port = OFreinterpret_cast(const unsigned char *, &from6->sin6_port);
+  }
+#endif
+  else return OFString();
+  stream << ":" << ((OFstatic_cast(int, port[0]) << 8) | port[1]) << OFStringStream_ends;
+  OFSTRINGSTREAM_GETOFSTRING(stream, result)
+  return result;
+}
+
+OFBool DcmTLSTransportLayer::sessionExpired(SSL_SESSION *session)
+{
+  return (OFstatic_cast(long, time(NULL)) >= SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session));
+}
+
+void DcmTLSTransportLayer::storeSession(const OFString &peer, SSL_SESSION *session)
+{
+#ifdef WITH_THREADS
+  sessionCacheMutex.lock();
+#endif
+  // only keep the most recent session for each peer
+  OFListIterator(SessionCacheEntry) it = sessionCache.begin();
+  while (it != sessionCache.end())
+  {
+    if ((*it).peer == peer)
+    {
+      SSL_SESSION_free((*it).session);
+      it = sessionCache.erase(it);
+    }
+    else ++it;
+  }
+  SessionCacheEntry entry;
+  entry.peer = peer;
+  entry.session = session;
+  sessionCache.push_front(entry);
+  while (sessionCache.size() > sessionCacheSize)
+  {
+    SSL_SESSION_free(sessionCache.back().session);
+    sessionCache.pop_back();
+  }
+#ifdef WITH_THREADS
+  sessionCacheMutex.unlock();
+#endif
+}
+
+OFBool DcmTLSTransportLayer::offerCachedSession(SSL *connection, const OFString &peer)
+{
+  if (peer.empty()) return OFFalse;
+  OFBool result = OFFalse;
+#ifdef WITH_THREADS
+  sessionCacheMutex.lock();
+#endif
+  OFListIterator(SessionCacheEntry) it = sessionCache.begin();
+  while (it != sessionCache.end())
+  {
+    if ((*it).peer == peer)
+    {
+      if (sessionExpired((*it).session))
+      {
+        SSL_SESSION_free((*it).session);
+        sessionCache.erase(it);
+      }
+      else
+      {
+        // SSL_set_session() increments the reference count of the session
+        result = (SSL_set_session(connection, (*it).session) == 1);
+      }
+      break;
+    }
+    ++it;
+  }
+#ifdef WITH_THREADS
+  sessionCacheMutex.unlock();
+#endif
+  return result;
+}
+
+void DcmTLSTransportLayer::clearSessionCache()
+{
+#ifdef WITH_THREADS
+  sessionCacheMutex.lock();
+#endif
+  OFListIterator(SessionCacheEntry) it = sessionCache.begin();
+  while (it != sessionCache.end())
+  {
+    SSL_SESSION_free((*it).session);
+    ++it;
+  }
+  sessionCache.clear();
+#ifdef WITH_THREADS
+  sessionCacheMutex.unlock();
+#endif
+}
+
 #else  /* WITH_OPENSSL */
 
 /* make sure that the object file is not completely empty if compiled
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2010-2013, OFFIS e.V.
+ *  Copyright (C) 2010-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -28,6 +28,7 @@
 
 DcmTLSSCU::DcmTLSSCU() :
   m_tLayer(NULL),
+  m_tLayerOutdated(OFFalse),
   m_doAuthenticate(OFFalse),
   m_trustedCertDirs(),
   m_trustedCertFiles(),
@@ -40,7 +41,9 @@ DcmTLSSCU::DcmTLSSCU() :
   m_readSeedFile(""),
   m_writeSeedFile(""),
   m_certVerification(DCV_requireCertificate),
-  m_dhparam("")
+  m_dhparam(""),
+  m_sessionCacheSize(0),
+  m_sessionTimeout(300)
 {
 #if OPENSSL_VERSION_NUMBER >= 0x0090700fL
   m_ciphersuites = TLS1_TXT_RSA_WITH_AES_128_SHA;
@@ -56,6 +59,7 @@ DcmTLSSCU::DcmTLSSCU(const OFString& peerHost,
                      const OFString& peerAETitle,
                      const Uint16 portNum) :
   m_tLayer(NULL),
+  m_tLayerOutdated(OFFalse),
   m_doAuthenticate(OFFalse),
   m_trustedCertDirs(),
   m_trustedCertFiles(),
@@ -68,7 +72,9 @@ DcmTLSSCU::DcmTLSSCU(const OFString& peerHost,
   m_readSeedFile(""),
   m_writeSeedFile(""),
   m_certVerification(DCV_requireCertificate),
-  m_dhparam("")
+  m_dhparam(""),
+  m_sessionCacheSize(0),
+  m_sessionTimeout(300)
 {
 #if OPENSSL_VERSION_NUMBER >= 0x0090700fL
   m_ciphersuites = TLS1_TXT_RSA_WITH_AES_128_SHA;
@@ -85,6 +91,13 @@ DcmTLSSCU::DcmTLSSCU(const OFString& peerHost,
 
 DcmTLSSCU::~DcmTLSSCU()
 {
+  // abort association (if any) and free the network first, both still use the
+  // transport layer, which is kept between associations if sessions are resumed
+  if (isConnected())
+    closeAssociation(DCMSCU_ABORT_ASSOCIATION);
+  else
+    freeNetwork();
+  delete m_tLayer;
   if (m_passwd)
   {
     delete[] m_passwd;
@@ -97,6 +110,28 @@ OFCondition DcmTLSSCU::initNetwork()
 {
   OFCondition cond;
 
+  /* The TLS layer must not be replaced while it is in use */
+  if (isConnected())
+    return NET_EC_AlreadyConnected;
+
+  /* Re-use the TLS layer of the last association (if any), so that the TLS session
+   * can be resumed. If the TLS settings have been changed in the meantime, a new
+   * layer is created instead (which also discards the cached sessions).
+   */
+  if (m_tLayer != NULL)
+  {
+    if (!m_tLayerOutdated)
+    {
+      cond = DcmSCU::initNetwork();
+      if (cond.good())
+        cond = useSecureConnection(m_tLayer);
+      return cond;
+    }
+    delete m_tLayer;
+    m_tLayer = NULL;
+  }
+  m_tLayerOutdated = OFFalse;
+
   /* First, create TLS layer */
   m_tLayer = new DcmTLSTransportLayer(DICOM_APPLICATION_REQUESTOR, m_readSeedFile.c_str());
   if (m_tLayer == NULL)
@@ -133,6 +168,28 @@ OFCondition DcmTLSSCU::initNetwork()
     }
   }
 
+  /* Add the certificates of the trusted certificate authorities */
+  OFListIterator(OFString) it = m_trustedCertFiles.begin();
+  while (cond.good() && (it != m_trustedCertFiles.end()))
+  {
+    if (TCS_ok != m_tLayer->addTrustedCertificateFile((*it).c_str(), m_certKeyFileFormat))
+    {
+      DCMTLS_ERROR("Unable to load certificate file " << *it);
+      cond = EC_IllegalCall;
+    }
+    ++it;
+  }
+  it = m_trustedCertDirs.begin();
+  while (cond.good() && (it != m_trustedCertDirs.end()))
+  {
+    if (TCS_ok != m_tLayer->addTrustedCertificateDir((*it).c_str(), m_certKeyFileFormat))
+    {
+      DCMTLS_ERROR("Unable to load certificates from directory " << *it);
+      cond = EC_IllegalCall;
+    }
+    ++it;
+  }
+
   /* Set cipher suites to be supported */
   if ( cond.good() && (TCS_ok != m_tLayer->setCipherSuites(m_ciphersuites.c_str())) )
   {
@@ -151,6 +208,13 @@ OFCondition DcmTLSSCU::initNetwork()
   if (cond.good())
     m_tLayer->setCertificateVerification(m_certVerification);
 
+  /* Set up the session cache for resuming TLS sessions */
+  if (cond.good())
+  {
+    m_tLayer->setSessionCacheSize(m_sessionCacheSize);
+    m_tLayer->setSessionTimeout(m_sessionTimeout);
+  }
+
   /*  Now we are ready to initialize SCU's network structures */
   if (cond.good())
     cond = DcmSCU::initNetwork();
@@ -209,8 +273,12 @@ void DcmTLSSCU::closeAssociation(const DcmCloseAssociationType closeType)
       DCMNET_WARN("Cannot write random seed, ignoring");
     }
   }
-  delete m_tLayer;
-  m_tLayer = NULL;
+  // keep the TLS layer (and its session cache) if sessions are to be resumed
+  if (m_sessionCacheSize == 0)
+  {
+    delete m_tLayer;
+    m_tLayer = NULL;
+  }
 }
 
 
@@ -225,6 +293,7 @@ void DcmTLSSCU::enableAuthentication(const OFString& privateKey,
   m_privateKeyFileFormat = privKeyFormat;
   m_certificateFile = certFile;
   m_certKeyFileFormat = certFormat;
+  m_tLayerOutdated = OFTrue;
   if (m_passwd != NULL)
   {
     delete[] m_passwd;
@@ -246,18 +315,21 @@ void DcmTLSSCU::enableAuthentication(const OFString& privateKey,
 void DcmTLSSCU::addTrustedCertFile(const OFString& str)
 {
   m_trustedCertFiles.push_back(str);
+  m_tLayerOutdated = OFTrue;
 }
 
 
 void DcmTLSSCU::addTrustedCertDir(const OFString& certDir)
 {
   m_trustedCertDirs.push_back(certDir);
+  m_tLayerOutdated = OFTrue;
 }
 
 
 void DcmTLSSCU::disableAuthentication()
 {
   m_doAuthenticate = OFFalse;
+  m_tLayerOutdated = OFTrue;
 }
 
 
@@ -270,12 +342,14 @@ void DcmTLSSCU::addCiphersuite(const OFString& cs)
     m_ciphersuites+= ":";
     m_ciphersuites+= cs;
   }
+  m_tLayerOutdated = OFTrue;
 }
 
 
 void DcmTLSSCU::setReadSeedFile(const OFString& seedFile)
 {
   m_readSeedFile = seedFile;
+  m_tLayerOutdated = OFTrue;
 }
 
 
@@ -288,12 +362,23 @@ void DcmTLSSCU::setWriteSeedFile(const OFString& seedFile)
 void DcmTLSSCU::setPeerCertVerification(const DcmCertificateVerification cert)
 {
   m_certVerification = cert;
+  m_tLayerOutdated = OFTrue;
 }
 
 
 void DcmTLSSCU::setDHParam(const OFString& dhParam)
 {
   m_dhparam = dhParam;
+  m_tLayerOutdated = OFTrue;
+}
+
+
+void DcmTLSSCU::setSessionResumption(const unsigned long cacheSize,
+                                     const long timeout)
+{
+  m_sessionCacheSize = cacheSize;
+  m_sessionTimeout = timeout;
+  m_tLayerOutdated = OFTrue;
 }
 
 
@@ -361,4 +446,16 @@ OFString DcmTLSSCU::getDHParam() const
 }
 
 
+unsigned long DcmTLSSCU::getSessionCacheSize() const
+{
+  return m_sessionCacheSize;
+}
+
+
+long DcmTLSSCU::getSessionTimeout() const
+{
+  return m_sessionTimeout;
+}
+
+
 #endif // WITH_OPENSSL
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1998-2010, OFFIS e.V.
+ *  Copyright (C) 1998-2016, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -100,6 +100,9 @@ DcmTransportLayerStatus DcmTLSConnection::serverSideHandshake()
   // unavailable at this point. We know that something has gone wrong, but
   // OpenSSL does not tell us who tried to connect.
 
+  if ((result == TCS_ok) && SSL_session_reused(tlsConnection))
+    DCMTLS_DEBUG("TLS session resumed, no full handshake performed");
+
   return result;
 }
 
@@ -128,6 +131,8 @@ DcmTransportLayerStatus DcmTLSConnection::clientSideHandshake()
       result = TCS_tlsError;
       break;
   }
+  if ((result == TCS_ok) && SSL_session_reused(tlsConnection))
+    DCMTLS_DEBUG("TLS session resumed, no full handshake performed");
   return result;
 }
 
@@ -302,6 +307,7 @@ OFString& DcmTLSConnection::dumpConnectionParameters(OFString& str)
          << "  Ciphersuite: " << SSL_CIPHER_get_name(SSL_get_current_cipher(tlsConnection))
          << ", version: " << SSL_CIPHER_get_version(SSL_get_current_cipher(tlsConnection))
          << ", encryption: " << SSL_CIPHER_get_bits(SSL_get_current_cipher(tlsConnection), NULL) << " bits" << OFendl
+         << "  Session: " << (SSL_session_reused(tlsConnection) ? "resumed" : "new") << OFendl
          << DcmTLSTransportLayer::dumpX509Certificate(peerCert) << OFendl;
   // out << "Certificate verification: " << X509_verify_cert_error_string(SSL_get_verify_result(tlsConnection)) << OFendl;
   X509_free(peerCert);
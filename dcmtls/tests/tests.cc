@@ -0,0 +1,33 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmtls
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: main test program
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"
+
+#include "dcmtk/ofstd/oftest.h"
+
+#ifdef WITH_OPENSSL
+OFTEST_REGISTER(dcmtls_sessionCache);
+#ifdef WITH_THREADS
+OFTEST_REGISTER(dcmtls_sessionResumption);
+#endif
+#endif
+
+OFTEST_MAIN("dcmtls")
@@ -0,0 +1,154 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmtls
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test saving and loading the TLS session cache of a requestor
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_OPENSSL
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/oftempf.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/dcmtls/tlslayer.h"
+#include "dcmtk/dcmnet/dicom.h"
+
+#define INCLUDE_CTIME
+#include "dcmtk/ofstd/ofstdinc.h"
+
+BEGIN_EXTERN_C
+#if defined(HAVE_SYS_STAT_H) && !defined(HAVE_WINDOWS_H)
+#include <sys/stat.h>
+#endif
+#include <openssl/pem.h>
+END_EXTERN_C
+
+
+/* A minimal TLS 1.2 session (AES128-SHA) in the format written by
+ * PEM_write_bio_SSL_SESSION(), established in January 2004.
+ */
+static const char *testSession =
+    "-----BEGIN SSL SESSION PARAMETERS-----\n"
+    "MG0CAQECAgMDBAIALwQgAQIDBAUGBwgJCgsMDQ4PEBESExQVFhcYGRobHB0eHyAE\n"
+    "MEBBQkNERUZHSElKS0xNTk9QUVJTVFVWV1hZWltcXV5fYGFiY2RlZmdoaWprbG1u\n"
+    "b6EGAgRAAAAAogQCAgEs\n"
+    "-----END SSL SESSION PARAMETERS-----\n";
+
+
+/* Returns the peer addresses stored in the given session cache file, in order */
+static OFString readPeers(const char *fileName)
+{
+    OFString peers;
+    BIO *bio = BIO_new_file(fileName, "r");
+    OFCHECK(bio != NULL);
+    if (bio == NULL) return peers;
+    char line[256];
+    while (BIO_gets(bio, line, sizeof(line)) > 0)
+    {
+        OFString peer(line);
+        if (peer.compare(0, 6, "Peer: ") != 0) continue;
+        if (!peers.empty()) peers += " ";
+        peers += peer.substr(6, peer.find_first_of("\r\n") - 6);
+    }
+    BIO_free(bio);
+    return peers;
+}
+
+
+/* Writes a session cache file with the given peers, sessions established
+ * the given number of seconds ago and the given session timeouts
+ */
+static void writeCache(const char *fileName, const char **peers, const long *ages, const long *timeouts, int count)
+{
+    BIO *bio = BIO_new_file(fileName, "w");
+    OFCHECK(bio != NULL);
+    if (bio == NULL) return;
+    // lines before the first session are ignored
+    BIO_printf(bio, "TLS session cache\n");
+    for (int i = 0; i < count; ++i)
+    {
+        BIO *mem = BIO_new_mem_buf(OFconst_cast(char *, testSession), -1);
+        SSL_SESSION *session = PEM_read_bio_SSL_SESSION(mem, NULL, NULL, NULL);
+        BIO_free(mem);
+        OFCHECK(session != NULL);
+        if (session == NULL) break;
+        if (ages[i] >= 0)
+            SSL_SESSION_set_time(session, OFstatic_cast(long, time(NULL)) - ages[i]);
+        SSL_SESSION_set_timeout(session, timeouts[i]);
+        OFCHECK(BIO_printf(bio, "Peer: %s\n", peers[i]) > 0);
+        OFCHECK(PEM_write_bio_SSL_SESSION(bio, session));
+        SSL_SESSION_free(session);
+    }
+    BIO_free(bio);
+}
+
+
+OFTEST(dcmtls_sessionCache)
+{
+    OFTempFile inFile;
+    OFTempFile outFile;
+    OFTempFile limitFile;
+
+    // an age of -1 keeps the time of the test session, i.e. the session has expired
+    const char *peers[4] = { "10.0.0.1:104", "10.0.0.2:104", "[fe80:0:0:0:0:0:0:1]:11112", "10.0.0.3:104" };
+    const long ages[4] = { 0, -1, 0, 298 };
+    const long timeouts[4] = { 300, 300, 300, 300 };
+    writeCache(inFile.getFilename(), peers, ages, timeouts, 4);
+
+    // the session cache is only available for requestors
+    DcmTLSTransportLayer acceptor(DICOM_APPLICATION_ACCEPTOR, NULL);
+    OFCHECK_EQUAL(acceptor.loadSessionCache(inFile.getFilename()), TCS_illegalCall);
+    OFCHECK_EQUAL(acceptor.saveSessionCache(outFile.getFilename()), TCS_illegalCall);
+
+    DcmTLSTransportLayer requestor(DICOM_APPLICATION_REQUESTOR, NULL);
+    requestor.setSessionCacheSize(10);
+    OFCHECK_EQUAL(requestor.loadSessionCache(NULL), TCS_illegalCall);
+    OFStandard::deleteFile(limitFile.getFilename());
+    OFCHECK_EQUAL(requestor.loadSessionCache(limitFile.getFilename()), TCS_tlsError);
+    OFCHECK_EQUAL(requestor.loadSessionCache(inFile.getFilename()), TCS_ok);
+
+    // the last session expires while it is in the cache
+    OFStandard::sleep(3);
+
+#if defined(HAVE_SYS_STAT_H) && !defined(HAVE_WINDOWS_H)
+    // an existing file is made inaccessible for other users
+    chmod(outFile.getFilename(), 0644);
+#endif
+    OFCHECK_EQUAL(requestor.saveSessionCache(outFile.getFilename()), TCS_ok);
+    OFCHECK_EQUAL(readPeers(outFile.getFilename()), "10.0.0.1:104 [fe80:0:0:0:0:0:0:1]:11112");
+#if defined(HAVE_SYS_STAT_H) && !defined(HAVE_WINDOWS_H)
+    struct stat st;
+    OFCHECK(stat(outFile.getFilename(), &st) == 0);
+    OFCHECK_EQUAL(st.st_mode & 0777, 0600);
+#endif
+
+    // a smaller cache only keeps the most recent sessions
+    DcmTLSTransportLayer limited(DICOM_APPLICATION_REQUESTOR, NULL);
+    limited.setSessionCacheSize(1);
+    OFCHECK_EQUAL(limited.loadSessionCache(outFile.getFilename()), TCS_ok);
+    OFCHECK_EQUAL(limited.saveSessionCache(limitFile.getFilename()), TCS_ok);
+    OFCHECK_EQUAL(readPeers(limitFile.getFilename()), "[fe80:0:0:0:0:0:0:1]:11112");
+#if defined(HAVE_SYS_STAT_H) && !defined(HAVE_WINDOWS_H)
+    OFCHECK(stat(limitFile.getFilename(), &st) == 0);
+    OFCHECK_EQUAL(st.st_mode & 0777, 0600);
+#endif
+}
+
+#endif // WITH_OPENSSL
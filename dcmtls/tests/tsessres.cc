@@ -0,0 +1,202 @@
+/*
+ *
+ *  Copyright (C) 2016, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmtls
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test resuming a TLS session on a second association between a
+ *           requestor and an acceptor on the loopback interface
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#if defined(WITH_OPENSSL) && defined(WITH_THREADS)
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/oftempf.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmtls/tlslayer.h"
+#include "dcmtk/dcmtls/tlsscu.h"
+#include "dcmtk/dcmnet/assoc.h"
+#include "dcmtk/dcmnet/dimse.h"
+#include "dcmtk/dcmdata/dcuid.h"
+
+BEGIN_EXTERN_C
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+END_EXTERN_C
+
+#define RESUME_TEST_PORT 11123
+
+
+/* Creates an RSA key and a self-signed certificate for "localhost" and
+ * writes them to the given files (PEM format)
+ */
+static void createCertificate(const char *keyFile, const char *certFile)
+{
+    EVP_PKEY *pkey = NULL;
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL);
+    OFCHECK(ctx != NULL);
+    if (ctx == NULL) return;
+    OFCHECK(EVP_PKEY_keygen_init(ctx) > 0);
+    OFCHECK(EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048) > 0);
+    OFCHECK(EVP_PKEY_keygen(ctx, &pkey) > 0);
+    EVP_PKEY_CTX_free(ctx);
+    if (pkey == NULL) return;
+
+    X509 *cert = X509_new();
+    OFCHECK(cert != NULL);
+    if (cert != NULL)
+    {
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_get_notBefore(cert), 0);
+        X509_gmtime_adj(X509_get_notAfter(cert), 3600);
+        X509_set_pubkey(cert, pkey);
+        X509_NAME *name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, OFreinterpret_cast(const unsigned char *, "localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        OFCHECK(X509_sign(cert, pkey, EVP_sha256()) > 0);
+
+        BIO *bio = BIO_new_file(keyFile, "w");
+        OFCHECK(bio != NULL);
+        if (bio != NULL)
+        {
+            OFCHECK(PEM_write_bio_PrivateKey(bio, pkey, NULL, NULL, 0, NULL, NULL));
+            BIO_free(bio);
+        }
+        bio = BIO_new_file(certFile, "w");
+        OFCHECK(bio != NULL);
+        if (bio != NULL)
+        {
+            OFCHECK(PEM_write_bio_X509(bio, cert));
+            BIO_free(bio);
+        }
+        X509_free(cert);
+    }
+    EVP_PKEY_free(pkey);
+}
+
+
+/* Acceptor that answers C-ECHO requests on a given number of TLS associations */
+struct TestTLSAcceptor : OFThread
+{
+    T_ASC_Network *network;
+    int maxAssociations;
+    int numAssociations;
+    OFCondition result;
+
+    TestTLSAcceptor(T_ASC_Network *net, int maxAssocs)
+    : network(net)
+    , maxAssociations(maxAssocs)
+    , numAssociations(0)
+    , result()
+    {
+    }
+
+protected:
+    void run()
+    {
+        while (result.good() && (numAssociations < maxAssociations))
+        {
+            T_ASC_Association *assoc = NULL;
+            result = ASC_receiveAssociation(network, &assoc, ASC_DEFAULTMAXPDU, NULL, NULL,
+                OFTrue /* useSecureLayer */, DUL_NOBLOCK, 30);
+            if (result.good())
+            {
+                const char *abstractSyntaxes[] = { UID_VerificationSOPClass };
+                const char *transferSyntaxes[] = { UID_LittleEndianImplicitTransferSyntax };
+                result = ASC_acceptContextsWithPreferredTransferSyntaxes(assoc->params,
+                    abstractSyntaxes, 1, transferSyntaxes, 1);
+                if (result.good())
+                    result = ASC_acknowledgeAssociation(assoc);
+            }
+            while (result.good())
+            {
+                T_ASC_PresentationContextID presID;
+                T_DIMSE_Message msg;
+                result = DIMSE_receiveCommand(assoc, DIMSE_NONBLOCKING, 30, &presID, &msg, NULL);
+                if (result.good() && (msg.CommandField == DIMSE_C_ECHO_RQ))
+                    result = DIMSE_sendEchoResponse(assoc, presID, &msg.msg.CEchoRQ, STATUS_Success, NULL);
+                else if (result.good())
+                    result = DIMSE_BADCOMMANDTYPE;
+            }
+            if (result == DUL_PEERREQUESTEDRELEASE)
+                result = ASC_acknowledgeRelease(assoc);
+            if (assoc != NULL)
+            {
+                ASC_dropSCPAssociation(assoc);
+                ASC_destroyAssociation(&assoc);
+            }
+            ++numAssociations;
+        }
+    }
+};
+
+
+/* Test connects a DcmTLSSCU with session resumption enabled twice to an
+ * acceptor. The first association requires a full handshake, the second
+ * one must resume the session negotiated on the first association.
+ */
+OFTEST_FLAGS(dcmtls_sessionResumption, EF_Slow)
+{
+    OFTempFile keyFile;
+    OFTempFile certFile;
+    createCertificate(keyFile.getFilename(), certFile.getFilename());
+
+    DcmTLSTransportLayer acceptorLayer(DICOM_APPLICATION_ACCEPTOR, NULL);
+    OFCHECK_EQUAL(acceptorLayer.setPrivateKeyFile(keyFile.getFilename(), SSL_FILETYPE_PEM), TCS_ok);
+    OFCHECK_EQUAL(acceptorLayer.setCertificateFile(certFile.getFilename(), SSL_FILETYPE_PEM), TCS_ok);
+    OFCHECK(acceptorLayer.checkPrivateKeyMatchesCertificate());
+    acceptorLayer.setCertificateVerification(DCV_ignoreCertificate);
+
+    // the network listens as soon as it is initialized
+    T_ASC_Network *network = NULL;
+    OFCHECK(ASC_initializeNetwork(NET_ACCEPTOR, RESUME_TEST_PORT, 30, &network).good());
+    OFCHECK(ASC_setTransportLayer(network, &acceptorLayer, 0).good());
+    TestTLSAcceptor acceptor(network, 2);
+    acceptor.start();
+
+    DcmTLSSCU scu("localhost", "ResumeTestSCP", RESUME_TEST_PORT);
+    scu.setAETitle("ResumeTestSCU");
+    scu.addTrustedCertFile(certFile.getFilename());
+    scu.setSessionResumption(10, 300);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(scu.addPresentationContext(UID_VerificationSOPClass, xfers).good());
+
+    for (int i = 0; i < 2; ++i)
+    {
+        OFCHECK(scu.initNetwork().good());
+        OFCHECK(scu.negotiateAssociation().good());
+        OFCHECK(scu.sendECHORequest(0).good());
+        OFCHECK(scu.releaseAssociation().good());
+        // wait until the acceptor is done with the association
+        while ((acceptor.numAssociations <= i) && acceptor.result.good())
+            OFStandard::milliSleep(10);
+        // only the second association resumes the session
+        OFCHECK_EQUAL(acceptorLayer.getNumberOfResumedSessions(), i);
+    }
+
+    acceptor.join();
+    OFCHECK(acceptor.result.good());
+    OFCHECK_EQUAL(acceptor.numAssociations, 2);
+    ASC_dropNetwork(&network);
+}
+
+#endif // WITH_OPENSSL && WITH_THREADS